@@ -34,6 +34,10 @@ For further information and questions please use the web site
 uint16_t ogm_interval       = OGM_INTERVAL_MS;
 uint16_t ogm_size           = OGM_SIZE;
 uint8_t window_size         = WINDOW_SIZE;
+uint32_t brc_log_timeout    = BROADCAST_LOG_TIMEOUT;
+uint16_t ogm_aggr_window    = OGM_AGGR_WINDOW_MS;
+uint16_t ogm_aggr_jitter    = OGM_AGGR_JITTER_MS;
+uint8_t ogm_aggr_max        = OGM_AGGR_MAX;
 bool ogm_precursor_mode     = USE_PRECURSOR_LIST;
 bool resend_ogm_always      = RESEND_OGM_ALWAYS;
 
@@ -43,12 +47,18 @@ static void _register_cli() {
 
     cli_register_command(dessert_cli, dessert_cli_set, "ogm_size", cli_set_ogm_size, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "set OGM packet size");
     cli_register_command(dessert_cli, dessert_cli_set, "ogm_interval", cli_set_ogm_interval, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "set OGM interval");
+    cli_register_command(dessert_cli, dessert_cli_set, "broadcast_log_timeout", cli_set_brc_log_timeout, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "set timeout of broadcast log in millisec");
+    cli_register_command(dessert_cli, dessert_cli_set, "ogm_aggr_window", cli_set_ogm_aggr_window, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "set time OGMs are collected for one frame in millisec");
+    cli_register_command(dessert_cli, dessert_cli_set, "ogm_aggr_jitter", cli_set_ogm_aggr_jitter, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "set max random delay of aggregated OGM frames in millisec");
+    cli_register_command(dessert_cli, dessert_cli_set, "ogm_aggr_max", cli_set_ogm_aggr_max, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "set max OGMs per frame [1=no aggregation]");
     cli_register_command(dessert_cli, dessert_cli_set, "window_size", cli_set_window_size, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "set sliding window size [0..255]");
     cli_register_command(dessert_cli, dessert_cli_set, "resend_ogm_always", cli_set_ogm_resend_mode, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "forward all OGMs [0=false,1=true]");
     cli_register_command(dessert_cli, dessert_cli_set, "ogm_precursor_mode", cli_set_ogm_precursor_mode, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "enable OGM precursor mode [0=off, 1=on]");
 
     cli_register_command(dessert_cli, dessert_cli_show, "ogm_size", cli_show_ogm_size, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "show OGM packet size");
     cli_register_command(dessert_cli, dessert_cli_show, "ogm_interval", cli_show_ogm_interval, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "show OGM interval");
+    cli_register_command(dessert_cli, dessert_cli_show, "broadcast_log_timeout", cli_show_brc_log_timeout, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "show timeout of broadcast log");
+    cli_register_command(dessert_cli, dessert_cli_show, "ogm_aggregation", cli_show_ogm_aggr, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "show OGM aggregation settings and statistics");
     cli_register_command(dessert_cli, dessert_cli_show, "rt", cli_show_rt, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "show routing table");
 }
 
@@ -65,11 +75,7 @@ static void _register_cb() {
 }
 
 static void _register_tasks() {
-    struct timeval db_cleanup_interval;
-    db_cleanup_interval.tv_sec = DB_CLEANUP_INTERVAL / 1000;
-    db_cleanup_interval.tv_usec = (DB_CLEANUP_INTERVAL % 1000) * 1000;
-    dessert_periodic_add(batman_periodic_cleanup_database, NULL, NULL, &db_cleanup_interval);
-
+    // also registers database cleanup
     batman_periodic_register_send_ogm(ogm_interval);
 }
 
@@ -77,6 +83,7 @@ static void _register_names() {
     dessert_register_ptr_name(batman_periodic_cleanup_database, "batman_periodic_cleanup_database");
     dessert_register_ptr_name(batman_periodic_send_ogm, "batman_periodic_send_ogm");
     dessert_register_ptr_name(batman_periodic_log_rt, "batman_periodic_log_rt");
+    dessert_register_ptr_name(batman_aggr_flush, "batman_aggr_flush");
 }
 
 int main(int argc, char** argv) {
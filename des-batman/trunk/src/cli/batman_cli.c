@@ -46,6 +46,7 @@ int cli_set_window_size(struct cli_def* cli, char* command, char* argv[], int ar
     batman_db_change_pt(PURGE_TIMEOUT_KOEFF * ogm_interval * window_size);
     batman_db_change_window_size((uint8_t) new_window_size);
     batman_db_unlock();
+    batman_periodic_register_cleanup(PURGE_TIMEOUT_KOEFF * ogm_interval * window_size);
     dessert_info("set WINDOW_SIZE to %i", new_window_size);
     return CLI_OK;
 }
@@ -124,11 +125,66 @@ int cli_set_ogm_interval(struct cli_def* cli, char* command, char* argv[], int a
     return CLI_OK;
 }
 
+int cli_set_brc_log_timeout(struct cli_def* cli, char* command, char* argv[], int argc) {
+    unsigned int new_timeout;
+
+    if(argc != 1 || sscanf(argv[0], "%u", &new_timeout) != 1 || new_timeout == 0) {
+        cli_print(cli, "usage of %s command [timeout in millisec]\n", command);
+        return CLI_ERROR_ARG;
+    }
+
+    brc_log_timeout = new_timeout;
+    batman_db_wlock();
+    batman_db_change_brc_log_timeout(brc_log_timeout);
+    batman_db_unlock();
+    dessert_info("set broadcast log timeout to %u millisec", brc_log_timeout);
+    return CLI_OK;
+}
+
+int cli_set_ogm_aggr_window(struct cli_def* cli, char* command, char* argv[], int argc) {
+    unsigned int new_window;
+
+    if(argc != 1 || sscanf(argv[0], "%u", &new_window) != 1 || new_window > UINT16_MAX) {
+        cli_print(cli, "usage of %s command [aggregation window in millisec]\n", command);
+        return CLI_ERROR_ARG;
+    }
+
+    ogm_aggr_window = (uint16_t) new_window;
+    dessert_info("set OGM aggregation window to %u millisec", ogm_aggr_window);
+    return CLI_OK;
+}
+
+int cli_set_ogm_aggr_jitter(struct cli_def* cli, char* command, char* argv[], int argc) {
+    unsigned int new_jitter;
+
+    if(argc != 1 || sscanf(argv[0], "%u", &new_jitter) != 1 || new_jitter > UINT16_MAX) {
+        cli_print(cli, "usage of %s command [max jitter in millisec]\n", command);
+        return CLI_ERROR_ARG;
+    }
+
+    ogm_aggr_jitter = (uint16_t) new_jitter;
+    dessert_info("set OGM aggregation jitter to %u millisec", ogm_aggr_jitter);
+    return CLI_OK;
+}
+
+int cli_set_ogm_aggr_max(struct cli_def* cli, char* command, char* argv[], int argc) {
+    unsigned int new_max;
+
+    if(argc != 1 || sscanf(argv[0], "%u", &new_max) != 1 || new_max < 1 || new_max > OGM_AGGR_LIMIT) {
+        cli_print(cli, "usage of %s command [1..%u OGMs per frame, 1 disables aggregation]\n", command, OGM_AGGR_LIMIT);
+        return CLI_ERROR_ARG;
+    }
+
+    ogm_aggr_max = (uint8_t) new_max;
+    dessert_info("set max OGMs per frame to %u", ogm_aggr_max);
+    return CLI_OK;
+}
+
 // ----------------------- CLI Debug and Report --------------------------------------
 
 int cli_show_rt(struct cli_def* cli, char* command, char* argv[], int argc) {
     char* rt_report;
-    batman_db_rlock();
+    batman_db_wlock();  // entrys may change under read lock
     batman_db_view_routingtable(&rt_report);
     batman_db_unlock();
     cli_print(cli, "\n%s\n", rt_report);
@@ -145,3 +201,21 @@ int cli_show_ogm_size(struct cli_def* cli, char* command, char* argv[], int argc
     cli_print(cli, "OGM size = %d bytes\n", ogm_size);
     return CLI_OK;
 }
+
+int cli_show_brc_log_timeout(struct cli_def* cli, char* command, char* argv[], int argc) {
+    cli_print(cli, "broadcast log timeout = %u millisec\n", brc_log_timeout);
+    return CLI_OK;
+}
+
+int cli_show_ogm_aggr(struct cli_def* cli, char* command, char* argv[], int argc) {
+    char* aggr_report;
+    cli_print(cli, "OGM aggregation: window = %u millisec, jitter = %u millisec, max = %u OGMs per frame\n",
+              ogm_aggr_window, ogm_aggr_jitter, ogm_aggr_max);
+
+    if(batman_aggr_report(&aggr_report) == true) {
+        cli_print(cli, "%s\n", aggr_report);
+        free(aggr_report);
+    }
+
+    return CLI_OK;
+}
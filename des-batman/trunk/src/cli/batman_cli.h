@@ -30,7 +30,13 @@ int cli_set_port(struct cli_def* cli, char* command, char* argv[], int argc);
 int cli_set_routing_log(struct cli_def* cli, char* command, char* argv[], int argc);
 int cli_set_ogm_resend_mode(struct cli_def* cli, char* command, char* argv[], int argc);
 int cli_set_ogm_precursor_mode(struct cli_def* cli, char* command, char* argv[], int argc);
+int cli_set_brc_log_timeout(struct cli_def* cli, char* command, char* argv[], int argc);
+int cli_set_ogm_aggr_window(struct cli_def* cli, char* command, char* argv[], int argc);
+int cli_set_ogm_aggr_jitter(struct cli_def* cli, char* command, char* argv[], int argc);
+int cli_set_ogm_aggr_max(struct cli_def* cli, char* command, char* argv[], int argc);
 
 int cli_show_rt(struct cli_def* cli, char* command, char* argv[], int argc);
 int cli_show_ogm_interval(struct cli_def* cli, char* command, char* argv[], int argc);
 int cli_show_ogm_size(struct cli_def* cli, char* command, char* argv[], int argc);
+int cli_show_brc_log_timeout(struct cli_def* cli, char* command, char* argv[], int argc);
+int cli_show_ogm_aggr(struct cli_def* cli, char* command, char* argv[], int argc);
@@ -28,7 +28,7 @@ For further information and questions please use the web site
 #define BATMAN_CONFIG
 
 #define RESEND_OGM_ALWAYS		false
-#define VERSION 				5
+#define VERSION 				7
 #define TTL_MAX 				255
 #define SEQNO_MAX 				65535
 #define OGM_INTERVAL_MS         2000
@@ -38,7 +38,7 @@ For further information and questions please use the web site
 #define PURGE_TIMEOUT_KOEFF		2
 #define PURGE_TIMEOUT			PURGE_TIMEOUT_KOEFF * WINDOW_SIZE * OGM_INTERVAL_MS
 #define NEIGHBOR_TIMEOUT		PURGE_TIMEOUT
-#define DB_CLEANUP_INTERVAL		PURGE_TIMEOUT
+#define DB_LOCK_STRIPES			64      // number of originator locks. MUST be a power of 2
 
 enum ext_types {
     OGM_EXT_TYPE = DESSERT_EXT_USER,
@@ -50,14 +50,24 @@ enum ext_types {
 
 // default values
 #define USE_PRECURSOR_LIST      false
-#define OGM_PREC_LIST_SIZE      12      // size of precursor list in OGM. Size MUST be between 1 and 255
-#define BROADCAST_LOG_TIMEOUT   10
+#define OGM_PREC_LIST_SIZE      12      // number of last precursors remembered in OGM and data packets. MUST be between 2 and 255
+#define PREC_FILTER_BITS        128     // bits of one precursor filter generation. MUST be a multiple of 8
+#define PREC_FILTER_HASHES      4       // ~0.2% false positives with 128 bits and OGM_PREC_LIST_SIZE 12. PREC_FILTER_BITS^PREC_FILTER_HASHES MUST be below 2^64
+#define BROADCAST_LOG_TIMEOUT   10000   // millisec
 #define OGM_SIZE                128
+#define OGM_AGGR_WINDOW_MS      100     // max time an OGM waits for others to be sent in the same frame
+#define OGM_AGGR_JITTER_MS      20      // random additional delay of aggregated frames
+#define OGM_AGGR_MAX            10      // max OGMs per frame, 1 disables aggregation
+#define OGM_AGGR_LIMIT          24      // upper bound of OGM_AGGR_MAX, frames are flushed earlier when full
 
 extern bool     ogm_precursor_mode;
 extern bool     resend_ogm_always;
 extern uint8_t  window_size;
 extern uint16_t ogm_interval;
 extern uint16_t ogm_size;
+extern uint32_t brc_log_timeout;
+extern uint16_t ogm_aggr_window;
+extern uint16_t ogm_aggr_jitter;
+extern uint8_t  ogm_aggr_max;
 
 #endif
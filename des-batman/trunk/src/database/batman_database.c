@@ -21,8 +21,10 @@ For further information and questions please use the web site
        http://www.des-testbed.net
 *******************************************************************************/
 
+#include <string.h>
 #include "batman_database.h"
 #include "../config.h"
+#include "../helper.h"
 #include "routing_table/batman_rt.h"
 #include "neighbor_table/batman_nt.h"
 #include "rl_seq_t/rl_seq.h"
@@ -31,6 +33,19 @@ For further information and questions please use the web site
 
 pthread_rwlock_t rwlock = PTHREAD_RWLOCK_INITIALIZER;
 
+/**
+ * Per-originator locks. While the read lock is held they protect the
+ * content of the routing table entrys, the table itself is only changed
+ * under the write lock.
+ */
+pthread_mutex_t originator_locks[DB_LOCK_STRIPES];
+
+#define BATMAN_DB_OGM_RETRY				0x80	// needs the write lock
+
+static pthread_mutex_t* _originator_lock(const uint8_t ether_addr[ETH_ALEN]) {
+    return &originator_locks[(ether_addr[3] ^ (ether_addr[4] << 1) ^ ether_addr[5]) & (DB_LOCK_STRIPES - 1)];
+}
+
 void batman_db_rlock() {
     pthread_rwlock_rdlock(&rwlock);
 }
@@ -44,6 +59,12 @@ void batman_db_unlock() {
 }
 
 int batman_db_init() {
+    int i;
+
+    for(i = 0; i < DB_LOCK_STRIPES; i++) {
+        pthread_mutex_init(&originator_locks[i], NULL);
+    }
+
     batman_db_rt_init();
     batman_db_brct_init();
 
@@ -63,16 +84,20 @@ int batman_db_cleanup() {
         return false;
     }
 
+    if(batman_db_nt_cleanup() == false) {
+        return false;
+    }
+
     return true;
 }
 
-int batman_db_change_pt(time_t pudge_timeout) {
+int batman_db_change_pt(uint32_t pudge_timeout) {
     batman_db_rt_change_pt(pudge_timeout);
     batman_db_nt_change_pt(pudge_timeout);
     return true;
 }
 
-int batman_db_captureroute(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t* local_iface, time_t timestamp, uint8_t ether_nexthop_addr[ETH_ALEN], uint16_t seq_num) {
+int batman_db_captureroute(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t* local_iface, uint64_t timestamp, uint8_t ether_nexthop_addr[ETH_ALEN], uint16_t seq_num) {
     return batman_db_rt_addroute(ether_dest_addr, local_iface, timestamp, ether_nexthop_addr, seq_num);
 }
 
@@ -81,15 +106,125 @@ int batman_db_deleteroute(uint8_t ether_dest_addr[ETH_ALEN]) {
 }
 
 int batman_db_getbestroute(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t** local_iface_out, uint8_t ether_nexthop_addr_out[ETH_ALEN]) {
-    return batman_db_rt_getbestroute(ether_dest_addr, local_iface_out, ether_nexthop_addr_out);
+    pthread_mutex_t* lock = _originator_lock(ether_dest_addr);
+    pthread_mutex_lock(lock);
+    int result = batman_db_rt_getbestroute(ether_dest_addr, local_iface_out, ether_nexthop_addr_out);
+    pthread_mutex_unlock(lock);
+    return result;
 }
 
-int batman_db_getbestroute_arl(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t** ether_iface_out, uint8_t ether_nexthop_addr_out[ETH_ALEN], uint8_t precursors_iface_list[OGM_PREC_LIST_SIZE* ETH_ALEN], uint8_t* presursosr_iface_count) {
-    return batman_db_rt_getbestroute_arl(ether_dest_addr, ether_iface_out, ether_nexthop_addr_out, precursors_iface_list, presursosr_iface_count);
+int batman_db_getbestroute_arl(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t** ether_iface_out, uint8_t ether_nexthop_addr_out[ETH_ALEN], hf_prec_filter_t* precursors) {
+    pthread_mutex_t* lock = _originator_lock(ether_dest_addr);
+    pthread_mutex_lock(lock);
+    int result = batman_db_rt_getbestroute_arl(ether_dest_addr, ether_iface_out, ether_nexthop_addr_out, precursors);
+    pthread_mutex_unlock(lock);
+    return result;
 }
 
 int batman_db_getroutesn(uint8_t ether_dest_addr[ETH_ALEN]) {
-    return batman_db_rt_getroutesn(ether_dest_addr);
+    pthread_mutex_t* lock = _originator_lock(ether_dest_addr);
+    pthread_mutex_lock(lock);
+    int result = batman_db_rt_getroutesn(ether_dest_addr);
+    pthread_mutex_unlock(lock);
+    return result;
+}
+
+/**
+ * OGM transaction. Must be called with read lock and originator lock
+ * (exclusive == false) or with write lock (exclusive == true).
+ * Returns BATMAN_DB_OGM_RETRY before changing anything if the
+ * routing table itself has to be changed but exclusive is false.
+ */
+static int _processogm(uint8_t ether_orig_addr[ETH_ALEN], dessert_meshif_t* local_iface, uint8_t ether_prevhop_addr[ETH_ALEN],
+                       uint16_t seq_num, int reset_flag, int in_precursors, uint64_t timestamp, int exclusive) {
+    int result = 0;
+
+    // if not from bidirectional neighbor -> silently drop!
+    if(batman_db_nt_check2Dneigh(ether_prevhop_addr, local_iface) != true) {
+        return BATMAN_DB_OGM_UNIDIRECTIONAL;
+    }
+
+    int last_seq_num = batman_db_rt_getroutesn(ether_orig_addr);
+    // if reset flag is set -> delete old destination
+    int restarted = (reset_flag && last_seq_num >= 0 && (last_seq_num - seq_num >= OGM_RESET_COUNT));
+
+    if(restarted) {
+        last_seq_num = -1;
+    }
+
+    int capture;
+
+    if(ogm_precursor_mode == false) {
+        // capture OGM only if incoming OGM is newer
+        // HINT: Process only OGM with greater seq_num to avoid routing loops.
+        capture = (last_seq_num == -1) || (hf_seq_comp_i_j(last_seq_num, seq_num) < 0);
+    }
+    else {
+        // capture all OGM not processed by me.
+        // We assume that the OGM with known sequence number but
+        // not containing my default address in precursor list were not processed.
+        capture = (in_precursors == false) && ((last_seq_num == -1) || (hf_seq_comp_i_j(seq_num, last_seq_num) >= 0));
+    }
+
+    if(exclusive == false && (restarted || (capture && last_seq_num == -1))) {
+        return BATMAN_DB_OGM_RETRY;
+    }
+
+    if(restarted) {
+        dessert_debug("--- " MAC " - was restarted", EXPLODE_ARRAY6(ether_orig_addr));
+        batman_db_rt_deleteroute(ether_orig_addr);
+    }
+
+    if(capture) {
+        // add or change route to originator
+        if(batman_db_rt_addroute(ether_orig_addr, local_iface, timestamp, ether_prevhop_addr, seq_num) == true) {
+            result |= BATMAN_DB_OGM_CAPTURED;
+        }
+    }
+
+    // check re-broadcast conditions
+    int allow_rebroadcast = false;
+
+    if(resend_ogm_always == true) {
+        allow_rebroadcast = true;
+    }
+    else {
+        // if OGM received over best next hop toward OGM originator -> re-broadcast
+        uint8_t ether_best_prev_hop[ETH_ALEN];
+        dessert_meshif_t* local_iface_towards_originator;
+
+        if((batman_db_rt_getbestroute(ether_orig_addr, &local_iface_towards_originator, ether_best_prev_hop) == true)
+            && (memcmp(ether_best_prev_hop, ether_prevhop_addr, ETH_ALEN) == 0)
+            && (local_iface_towards_originator == local_iface)) {
+            allow_rebroadcast = true;
+        }
+    }
+
+    if(allow_rebroadcast == true && batman_db_rt_addogmseq(ether_orig_addr, seq_num) == true) {
+        result |= BATMAN_DB_OGM_REBROADCAST;
+    }
+
+    return result;
+}
+
+int batman_db_processogm(uint8_t ether_orig_addr[ETH_ALEN], dessert_meshif_t* local_iface, uint8_t ether_prevhop_addr[ETH_ALEN],
+                         uint16_t seq_num, int reset_flag, int in_precursors, uint64_t timestamp) {
+    pthread_mutex_t* lock = _originator_lock(ether_orig_addr);
+
+    batman_db_rlock();
+    pthread_mutex_lock(lock);
+    int result = _processogm(ether_orig_addr, local_iface, ether_prevhop_addr, seq_num, reset_flag, in_precursors, timestamp, false);
+    pthread_mutex_unlock(lock);
+    batman_db_unlock();
+
+    if(result & BATMAN_DB_OGM_RETRY) {
+        // unknown or restarted originator -> routing table itself changes
+        batman_db_wlock();
+        result = _processogm(ether_orig_addr, local_iface, ether_prevhop_addr, seq_num, reset_flag, in_precursors, timestamp, true);
+        batman_db_unlock();
+    }
+
+    return result;
 }
 
 /**
@@ -110,8 +245,8 @@ int batman_db_addbrcid(uint8_t source_addr[ETH_ALEN], uint16_t id) {
     return batman_db_brct_addid(source_addr, id);
 }
 
-int batman_db_addogmseq(uint8_t source_addr[ETH_ALEN], uint16_t seq) {
-    return batman_db_ogm_addid(source_addr, seq);
+void batman_db_change_brc_log_timeout(uint32_t timeout) {
+    batman_db_brct_change_pt(timeout);
 }
 
 void batman_db_change_window_size(uint8_t window_size) {
@@ -28,6 +28,7 @@ For further information and questions please use the web site
 #include <linux/if_ether.h>
 #include <dessert.h>
 #include "../config.h"
+#include "../helper.h"
 
 /** Make read lock over database to avoid corrupt read/write */
 void batman_db_rlock();
@@ -38,6 +39,22 @@ void batman_db_wlock();
 /** Unlock previos locks for this thread */
 void batman_db_unlock();
 
+/** Flags returned by batman_db_processogm */
+#define BATMAN_DB_OGM_UNIDIRECTIONAL	0x01	// not received over bidirectional connection -> drop
+#define BATMAN_DB_OGM_CAPTURED			0x02	// route towards originator was captured
+#define BATMAN_DB_OGM_REBROADCAST		0x04	// OGM should be re-broadcasted
+
+/**
+ * Process a received OGM as one transaction: check the bidirectional
+ * connection to the previous hop, capture the route towards the originator
+ * and decide whether to re-broadcast.
+ * Takes the database locks itself: OGMs of already known originators only hold
+ * the read lock and a per-originator lock, so different originators are
+ * processed in parallel. Unknown or restarted originators take the write lock.
+ */
+int batman_db_processogm(uint8_t ether_orig_addr[ETH_ALEN], dessert_meshif_t* local_iface, uint8_t ether_prevhop_addr[ETH_ALEN],
+                         uint16_t seq_num, int reset_flag, int in_precursors, uint64_t timestamp);
+
 /** initialize all tables of routing database */
 int batman_db_init();
 
@@ -45,22 +62,25 @@ int batman_db_init();
 int batman_db_cleanup();
 
 /** change pudge timeout for all tables */
-int batman_db_change_pt(time_t pudge_timeout);
+int batman_db_change_pt(uint32_t pudge_timeout);
 
 /** Add routing entry into routing table */
-int batman_db_captureroute(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t* local_iface, time_t timestamp, uint8_t ether_nexthop_addr[ETH_ALEN], uint16_t seq_num);
+int batman_db_captureroute(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t* local_iface, uint64_t timestamp, uint8_t ether_nexthop_addr[ETH_ALEN], uint16_t seq_num);
 
 /** Delete route to destination. HINT: need when detected router restart */
 int batman_db_deleteroute(uint8_t ether_dest_addr[ETH_ALEN]);
 
-/** Get best route (next hop) towards destination from routing table */
+/**
+ * Get best route (next hop) towards destination from routing table.
+ * HINT: the getters need the read lock and take the originator lock themselves.
+ */
 int batman_db_getbestroute(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t** local_iface_out, uint8_t ether_nexthop_addr_out[ETH_ALEN]);
 
 /**
  * Get best route (next hop) towards destination from routing table
  * that avoids route looping
  */
-int batman_db_getbestroute_arl(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t** ether_iface_out, uint8_t ether_nexthop_addr_out[ETH_ALEN], uint8_t precursors_iface_list[OGM_PREC_LIST_SIZE* ETH_ALEN], uint8_t* presursosr_iface_count);
+int batman_db_getbestroute_arl(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t** ether_iface_out, uint8_t ether_nexthop_addr_out[ETH_ALEN], hf_prec_filter_t* precursors);
 
 
 /** Get last know seq_num of destination */
@@ -79,7 +99,8 @@ int batman_db_check2Dneigh(uint8_t ether_neighbor_addr[ETH_ALEN], dessert_meshif
 
 int batman_db_addbrcid(uint8_t source_addr[ETH_ALEN], uint16_t id);
 
-int batman_db_addogmseq(uint8_t source_addr[ETH_ALEN], uint16_t seq);
+/** Change timeout of broadcast log (millisec) */
+void batman_db_change_brc_log_timeout(uint32_t timeout);
 
 /** Change window size of all sliding windows in entire routing table */
 void batman_db_change_window_size(uint8_t window_size);
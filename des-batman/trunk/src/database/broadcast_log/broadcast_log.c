@@ -37,31 +37,26 @@ typedef struct batman_brclog_entry {
 batman_brclog_entry_t*	brclog_set = NULL;
 timeslot_t*				brclog_ts;
 
-batman_brclog_entry_t*	ogmlog_set = NULL;
-timeslot_t*				ogmlog_ts;
 
-
-void purge_brcid_entry(time_t timestamp, void* object) {
+void purge_brcid_entry(uint64_t timestamp, void* object) {
     batman_brclog_entry_t* entry = object;
     HASH_DEL(brclog_set, entry);
     free(entry);
 }
 
-void purge_ogmid_entry(time_t timestamp, void* object) {
-    batman_brclog_entry_t* entry = object;
-    HASH_DEL(ogmlog_set, entry);
-    free(entry);
-}
-
 int batman_db_brct_init() {
-    timeslot_create(&brclog_ts, BROADCAST_LOG_TIMEOUT, purge_brcid_entry);
-    timeslot_create(&ogmlog_ts, RL_TIMEOUT, purge_ogmid_entry);
+    timeslot_create(&brclog_ts, brc_log_timeout, purge_brcid_entry);
     return true;
 }
 
+void batman_db_brct_change_pt(uint32_t timeout) {
+    timeslot_change_pt(brclog_ts, timeout);
+}
+
 int batman_db_brct_addid(uint8_t shost_ether[ETH_ALEN], uint16_t brc_id) {
     batman_brclog_entry_t* entry;
-    timeslot_purgeobjects(brclog_ts, time(0));
+    uint64_t now = hf_time_ms();
+    timeslot_purgeobjects(brclog_ts, now);
     HASH_FIND(hh, brclog_set, shost_ether, ETH_ALEN, entry);
 
     if(entry == NULL) {
@@ -74,45 +69,15 @@ int batman_db_brct_addid(uint8_t shost_ether[ETH_ALEN], uint16_t brc_id) {
         memcpy(entry->shost_ether, shost_ether, ETH_ALEN);
         HASH_ADD_KEYPTR(hh, brclog_set, entry->shost_ether, ETH_ALEN, entry);
         entry->brc_id = brc_id;
-        timeslot_addobject(brclog_ts, time(0), entry);
+        timeslot_addobject(brclog_ts, now, entry);
         return true;
     }
 
     if(hf_seq_comp_i_j(entry->brc_id, brc_id) < 0) {
         entry->brc_id = brc_id;
-        timeslot_addobject(brclog_ts, time(0), entry);
-        return true;
-    }
-
-    return false;
-}
-
-int batman_db_ogm_addid(uint8_t shost_ether[ETH_ALEN], uint16_t seq) {
-    batman_brclog_entry_t* entry;
-    timeslot_purgeobjects(ogmlog_ts, time(0));
-    HASH_FIND(hh, ogmlog_set, shost_ether, ETH_ALEN, entry);
-
-    if(entry == NULL) {
-        entry = malloc(sizeof(batman_brclog_entry_t));
-
-        if(entry == NULL) {
-            return false;
-        }
-
-        memcpy(entry->shost_ether, shost_ether, ETH_ALEN);
-        HASH_ADD_KEYPTR(hh, ogmlog_set, entry->shost_ether, ETH_ALEN, entry);
-        entry->brc_id = seq;
-        timeslot_addobject(ogmlog_ts, time(0), entry);
-        return true;
-    }
-
-    if(hf_seq_comp_i_j(entry->brc_id, seq) < 0) {
-        entry->brc_id = seq;
-        timeslot_addobject(ogmlog_ts, time(0), entry);
+        timeslot_addobject(brclog_ts, now, entry);
         return true;
     }
 
     return false;
 }
-
-
@@ -30,15 +30,12 @@ For further information and questions please use the web site
 
 int batman_db_brct_init();
 
+/** change timeout (millisec) of broadcast ids */
+void batman_db_brct_change_pt(uint32_t timeout);
+
 /**
  * Returns true if message with this broadcast id was newer re-broadcastet
  */
 int batman_db_brct_addid(uint8_t shost_ether[ETH_ALEN], uint16_t brc_id);
 
-
-/**
- * Returns true if OGM with this seq was newer re-broadcastet
- */
-int batman_db_ogm_addid(uint8_t shost_ether[ETH_ALEN], uint16_t seq);
-
 #endif
@@ -26,12 +26,15 @@ For further information and questions please use the web site
 #include "batman_nt.h"
 #include "../timeslot.h"
 #include "../../config.h"
+#include "../../helper.h"
 
 typedef struct batman_neighbor_entry {
     struct __attribute__((__packed__)) {
         uint8_t 		ether_neighbor[ETH_ALEN];
         uint8_t		ether_iface[ETH_ALEN];
     };
+    /** last time the bidirectional connection was confirmed */
+    uint64_t		last_aw_time;
     UT_hash_handle	hh;
 } batman_neighbor_entry_t;
 
@@ -63,7 +66,7 @@ int batman_db_neighbor_entry_destroy(batman_neighbor_entry_t* entry) {
     return true;
 }
 
-void on_neigbor_timeout(time_t timestamp, void* object) {
+void on_neigbor_timeout(uint64_t timestamp, void* object) {
     batman_neighbor_entry_t* curr_entry = object;
     HASH_DEL(nt.entrys, curr_entry);
     batman_db_neighbor_entry_destroy(curr_entry);
@@ -97,26 +100,31 @@ int batman_db_nt_cap2Dneigh(uint8_t ether_neighbor_addr[ETH_ALEN], const dessert
         dessert_debug("%s <====> " MAC, local_iface->if_name, EXPLODE_ARRAY6(ether_neighbor_addr));
     }
 
-    timeslot_addobject(nt.ts, time(0), curr_entry);
+    curr_entry->last_aw_time = hf_time_ms();
+    timeslot_addobject(nt.ts, curr_entry->last_aw_time, curr_entry);
     return true;
 }
 
 int batman_db_nt_check2Dneigh(uint8_t ether_neighbor_addr[ETH_ALEN], const dessert_meshif_t* local_iface) {
-    timeslot_purgeobjects(nt.ts, time(0));
+    // HINT: read only, may run under read lock. Outdated entrys are pudged by batman_db_nt_cleanup
     batman_neighbor_entry_t* curr_entry;
     uint8_t addr_sum[2*ETH_ALEN];
     memcpy(addr_sum, ether_neighbor_addr, ETH_ALEN);
     memcpy(addr_sum + ETH_ALEN, local_iface->hwaddr, ETH_ALEN);
     HASH_FIND(hh, nt.entrys, addr_sum, 2 * ETH_ALEN, curr_entry);
 
-    if(curr_entry == NULL) {
+    if(curr_entry == NULL || curr_entry->last_aw_time + nt.ts->purge_timeout <= hf_time_ms()) {
         return false;
     }
 
     return true;
 }
 
-int batman_db_nt_change_pt(time_t pudge_timeout) {
+int batman_db_nt_cleanup() {
+    return timeslot_purgeobjects(nt.ts, hf_time_ms());
+}
+
+int batman_db_nt_change_pt(uint32_t pudge_timeout) {
     timeslot_change_pt(nt.ts, pudge_timeout);
     return true;
 }
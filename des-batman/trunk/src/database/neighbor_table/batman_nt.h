@@ -41,7 +41,10 @@ int batman_db_nt_cap2Dneigh(uint8_t ether_neighbor_addr[ETH_ALEN], const dessert
  */
 int batman_db_nt_check2Dneigh(uint8_t ether_neighbor_addr[ETH_ALEN], const dessert_meshif_t* local_iface);
 
+/** pudge outdated neighbors */
+int batman_db_nt_cleanup();
+
 /** change pudge_timeout for neighbor table */
-int batman_db_nt_change_pt(time_t pudge_timeout);
+int batman_db_nt_change_pt(uint32_t pudge_timeout);
 
 #endif
@@ -30,17 +30,16 @@ For further information and questions please use the web site
 
 typedef struct rl_packet_id {
     uint8_t src_dest_addr[ETH_ALEN * 2]; // key
-    batman_sw_t* sw;
+    batman_sw_t sw;
     UT_hash_handle hh;
 } rl_packet_id_t;
 
 rl_packet_id_t* rl_entrys = NULL;
 timeslot_t* rl_ts = NULL;
 
-void on_rl_timeout(time_t timestamp, void* object) {
+void on_rl_timeout(uint64_t timestamp, void* object) {
     rl_packet_id_t* rl_entry = object;
     HASH_DEL(rl_entrys, rl_entry);
-    batman_sw_destroy(rl_entry->sw);
     free(rl_entry);
 }
 
@@ -55,19 +54,13 @@ rl_packet_id_t* create_entry(uint8_t key[2 * ETH_ALEN]) {
         return NULL;
     }
 
-    batman_sw_t* sw;
-
-    if(batman_sw_create(&sw, WINDOW_SIZE * 4) != true) {
-        free(entry);
-    }
-
     memcpy(entry->src_dest_addr, key, ETH_ALEN * 2);
-    entry->sw = sw;
+    batman_sw_init(&entry->sw, WINDOW_SIZE * 4);
     return entry;
 }
 
 uint16_t rl_get_nextseq(uint8_t src_addr[ETH_ALEN], uint8_t dest_addr[ETH_ALEN],
-                        time_t timestamp) {
+                        uint64_t timestamp) {
     uint8_t key[ETH_ALEN * 2];
     memcpy(key, src_addr, ETH_ALEN);
     memcpy(key + ETH_ALEN, dest_addr, ETH_ALEN);
@@ -82,12 +75,12 @@ uint16_t rl_get_nextseq(uint8_t src_addr[ETH_ALEN], uint8_t dest_addr[ETH_ALEN],
             return 0;
         }
 
-        batman_sw_addsn(entry->sw, 0);
+        batman_sw_addsn(&entry->sw, 0);
         HASH_ADD_KEYPTR(hh, rl_entrys, entry->src_dest_addr, ETH_ALEN * 2, entry);
     }
     else {
-        batman_sw_addsn(entry->sw, entry->sw->head->seq_num + 1);
-        packet_seq = entry->sw->head->seq_num;
+        batman_sw_addsn(&entry->sw, entry->sw.head + 1);
+        packet_seq = entry->sw.head;
     }
 
     timeslot_addobject(rl_ts, timestamp, entry);
@@ -95,7 +88,7 @@ uint16_t rl_get_nextseq(uint8_t src_addr[ETH_ALEN], uint8_t dest_addr[ETH_ALEN],
 }
 
 int rl_check_seq(uint8_t src_addr[ETH_ALEN], uint8_t dest_addr[ETH_ALEN], uint16_t seq_num,
-                 time_t timestamp) {
+                 uint64_t timestamp) {
     timeslot_purgeobjects(rl_ts, timestamp);
     uint8_t key[ETH_ALEN * 2];
     memcpy(key, src_addr, ETH_ALEN);
@@ -107,21 +100,11 @@ int rl_check_seq(uint8_t src_addr[ETH_ALEN], uint8_t dest_addr[ETH_ALEN], uint16
         return false;
     }
 
-    batman_sw_element_t* el = entry->sw->head;
-
-    while(el != NULL) {
-        if(el->seq_num == seq_num) {
-            return true;
-        }
-
-        el = el->prev;
-    }
-
-    return false;
+    return batman_sw_contains(&entry->sw, seq_num);
 }
 
 void rl_add_seq(uint8_t src_addr[ETH_ALEN], uint8_t dest_addr[ETH_ALEN],
-                uint16_t seq_num, time_t timestamp) {
+                uint16_t seq_num, uint64_t timestamp) {
     uint8_t key[ETH_ALEN * 2];
     memcpy(key, src_addr, ETH_ALEN);
     memcpy(key + ETH_ALEN, dest_addr, ETH_ALEN);
@@ -138,6 +121,6 @@ void rl_add_seq(uint8_t src_addr[ETH_ALEN], uint8_t dest_addr[ETH_ALEN],
         HASH_ADD_KEYPTR(hh, rl_entrys, entry->src_dest_addr, ETH_ALEN * 2, entry);
     }
 
-    batman_sw_addsn(entry->sw, seq_num);
+    batman_sw_addsn(&entry->sw, seq_num);
     timeslot_addobject(rl_ts, timestamp, entry);
 }
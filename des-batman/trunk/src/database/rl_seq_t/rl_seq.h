@@ -30,16 +30,16 @@ For further information and questions please use the web site
 int rl_table_init();
 
 uint16_t rl_get_nextseq(uint8_t src_addr[ETH_ALEN], uint8_t dest_addr[ETH_ALEN],
-                        time_t timestamp);
+                        uint64_t timestamp);
 
 /**
  * Return true if given seq_num is equals to thin in database
  * (i.e. this packet was already processed)
  */
 int rl_check_seq(uint8_t src_addr[ETH_ALEN], uint8_t dest_addr[ETH_ALEN], uint16_t seq_num,
-                 time_t timestamp);
+                 uint64_t timestamp);
 
 void rl_add_seq(uint8_t src_addr[ETH_ALEN], uint8_t dest_addr[ETH_ALEN],
-                uint16_t seq_num, time_t timestamp);
+                uint16_t seq_num, uint64_t timestamp);
 
 #endif
@@ -22,15 +22,15 @@ For further information and questions please use the web site
 *******************************************************************************/
 
 #include <time.h>
-#include <utlist.h>
 #include <dessert.h>
 #include "../../config.h"
 #include "../../helper.h"
 #include "batman_rt.h"
 #include "batman_sw.h"
-#include "../timeslot.h"
 
 #define REPORT_RT_STR_LEN 200
+/** number of next hop candidates kept sorted per destination for loop avoidance */
+#define RT_CANDIDATE_COUNT 8
 
 /** Entry of NextHop-List table */
 typedef struct batman_rt_nht_entry {
@@ -40,7 +40,9 @@ typedef struct batman_rt_nht_entry {
      * Sliding Window of this connection towards destination.
      * Indicates quality of connection.
      */
-    batman_sw_t* sw;
+    batman_sw_t sw;
+    /** count of seq_nums in sliding window relative to curr_seq_num of destination */
+    uint16_t sn_count;
     UT_hash_handle hh;
 } batman_rt_nht_entry_t;
 
@@ -57,20 +59,36 @@ typedef struct batman_rt_if_entry {
     UT_hash_handle 			hh;
 } batman_rt_if_entry_t;
 
+/** Next hop candidate towards destination */
+typedef struct route_entry {
+    uint8_t             next_hop[ETH_ALEN];
+    dessert_meshif_t*   out_iface;
+    uint16_t            quality;
+} route_entry_t;
+
 /** Row entry of B.A.T.M.A.N routing table */
 typedef struct batman_rt_entry {
     /** MAC address of destination */
     uint8_t 				ether_dest_addr[ETH_ALEN];	// key value
     /** pointer to first HASH_MAP iface entry */
     batman_rt_if_entry_t*	if_entrys;
-    /** Last aware time of destination */
-    time_t 					last_aw_time;
+    /** Last aware time of destination (millisec) */
+    uint64_t 				last_aw_time;
     /** most actual sequence number for destination */
     uint16_t 				curr_seq_num;
+    /** sequence number of the last re-broadcasted OGM of destination */
+    uint16_t 				rebrc_seq_num;
+    /** whether rebrc_seq_num is valid */
+    uint8_t 				rebrc_valid;
     // /* HNA list
     // /* Gateway capabilities
     /** the best output interface for packets towards destination */
     batman_rt_if_entry_t*	best_output_iface;
+    /** next hops with most seq_nums over all interfaces, sorted by quality */
+    route_entry_t			candidates[RT_CANDIDATE_COUNT];
+    uint8_t					candidate_count;
+    /** set if more next hops are known than fit into candidates */
+    uint8_t					candidates_truncated;
     UT_hash_handle 			hh;
 } batman_rt_entry_t;
 
@@ -80,8 +98,8 @@ typedef struct batman_rt_entry {
 struct batman_rt {
     /** pointer to first HASH_MAP entry */
     batman_rt_entry_t* 	entrys;
-    /** time-slot to manage (pudge) old entrys */
-    timeslot_t*			ts;
+    /** entrys not aware for this time are pudged by batman_db_rt_cleanup */
+    uint32_t			purge_timeout;
 } rt;
 
 /** create output interface entry. */
@@ -96,28 +114,22 @@ int batman_db_rt_if_entry_create(batman_rt_if_entry_t** rt_if_entry_out, dessert
 
     new_entry->ether_iface = local_iface;
     new_entry->nh_entrys = NULL;
+    new_entry->best_next_hop = NULL;
     *rt_if_entry_out = new_entry;
     return true;
 }
 
 int batman_db_nht_entry_create(batman_rt_nht_entry_t** rt_nh_entry_out, uint8_t ether_addr[ETH_ALEN]) {
     batman_rt_nht_entry_t* new_entry;
-    batman_sw_t* new_sw;
     new_entry = malloc(sizeof(batman_rt_nht_entry_t));
 
     if(new_entry == NULL) {
         return false;
     }
 
-    if(batman_sw_create(&new_sw, window_size) == false) {
-        free(new_entry);
-        return false;
-    };
-
     memcpy(new_entry->ether_nexthop_addr, ether_addr, ETH_ALEN);
-
-    new_entry->sw = new_sw;
-
+    batman_sw_init(&new_entry->sw, window_size);
+    new_entry->sn_count = 0;
     *rt_nh_entry_out = new_entry;
 
     return true;
@@ -127,7 +139,6 @@ int batman_db_nht_entry_create(batman_rt_nht_entry_t** rt_nh_entry_out, uint8_t
 int batman_db_rt_if_entry_destroy(batman_rt_if_entry_t* rt_if_entry) {
     while(rt_if_entry->nh_entrys != NULL) {
         batman_rt_nht_entry_t* nht_entry = rt_if_entry->nh_entrys;
-        batman_sw_destroy(nht_entry->sw);
         HASH_DEL(rt_if_entry->nh_entrys, nht_entry);
         free(nht_entry);
     }
@@ -137,13 +148,12 @@ int batman_db_rt_if_entry_destroy(batman_rt_if_entry_t* rt_if_entry) {
 }
 
 int batman_db_nht_entry_destroy(batman_rt_nht_entry_t* rt_nh_entry) {
-    batman_sw_destroy(rt_nh_entry->sw);
     free(rt_nh_entry);
     return true;
 }
 
 int batman_db_rt_entry_create(batman_rt_entry_t** rt_entry,
-                              uint8_t ether_dest_addr[ETH_ALEN], time_t timestamp,
+                              uint8_t ether_dest_addr[ETH_ALEN], uint64_t timestamp,
                               batman_rt_if_entry_t* rt_if_entry, uint16_t seq_num) {
     batman_rt_entry_t* new_entry;
     new_entry = malloc(sizeof(batman_rt_entry_t));
@@ -157,6 +167,9 @@ int batman_db_rt_entry_create(batman_rt_entry_t** rt_entry,
     HASH_ADD_KEYPTR(hh, new_entry->if_entrys, &rt_if_entry->ether_iface, sizeof(int), rt_if_entry);
     new_entry->best_output_iface = rt_if_entry;
     new_entry->curr_seq_num = seq_num;
+    new_entry->rebrc_valid = false;
+    new_entry->candidate_count = 0;
+    new_entry->candidates_truncated = false;
     new_entry->last_aw_time = timestamp;
     *rt_entry = new_entry;
     return true;
@@ -175,21 +188,79 @@ int batman_db_rt_entry_destroy(batman_rt_entry_t* rt_entry) {
     return true;
 }
 
-int batman_db_nht_shiftuptoseq(batman_rt_if_entry_t* rt_iface, uint16_t seq_num) {
+/**
+ * Set the quality of next hop in the sorted candidate list of destination.
+ * The quality MUST NOT have dropped since the last update of the list, otherwise
+ * the list has to be reset and filled again in table order.
+ * Next hops with equal quality keep the order they were added in.
+ */
+void batman_db_rt_update_candidate(batman_rt_entry_t* rt_entry, batman_rt_if_entry_t* if_entry, batman_rt_nht_entry_t* nht_entry) {
+    route_entry_t* candidates = rt_entry->candidates;
+    route_entry_t candidate;
+    int pos;
+
+    for(pos = 0; pos < rt_entry->candidate_count; pos++) {
+        if(candidates[pos].out_iface == if_entry->ether_iface
+            && memcmp(candidates[pos].next_hop, nht_entry->ether_nexthop_addr, ETH_ALEN) == 0) {
+            break;
+        }
+    }
+
+    if(pos == rt_entry->candidate_count) {
+        // not a candidate yet
+        if(rt_entry->candidate_count == RT_CANDIDATE_COUNT) {
+            rt_entry->candidates_truncated = true;
+
+            if(nht_entry->sn_count <= candidates[pos - 1].quality) {
+                return;
+            }
+
+            pos--; // replace the worst candidate
+        }
+        else {
+            rt_entry->candidate_count++;
+        }
+    }
+
+    memcpy(candidate.next_hop, nht_entry->ether_nexthop_addr, ETH_ALEN);
+    candidate.out_iface = if_entry->ether_iface;
+    candidate.quality = nht_entry->sn_count;
+
+    while(pos > 0 && candidates[pos - 1].quality < candidate.quality) {
+        candidates[pos] = candidates[pos - 1];
+        pos--;
+    }
+
+    candidates[pos] = candidate;
+}
+
+/** Empty the candidate list of destination before it is filled again */
+void batman_db_rt_reset_candidates(batman_rt_entry_t* rt_entry) {
+    rt_entry->candidate_count = 0;
+    rt_entry->candidates_truncated = false;
+}
+
+/**
+ * Recount all next hops against the newest seq_num of the destination,
+ * drop next hops without seq_nums in range and select the best one.
+ * The windows itself are not shifted, only counted up to base.
+ * The remaining next hops are added to the candidates of destination.
+ */
+int batman_db_nht_rank(batman_rt_entry_t* rt_entry, batman_rt_if_entry_t* rt_iface, uint16_t base) {
     batman_rt_nht_entry_t* nh_entry = rt_iface->nh_entrys;
     rt_iface->best_next_hop = nh_entry; // reset best next hop
 
     while(nh_entry != NULL) {
-        batman_sw_dropsn(nh_entry->sw, seq_num); // shift window by all entrys to seq_num
+        nh_entry->sn_count = batman_sw_count(&nh_entry->sw, base);
 
-        if(rt_iface->best_next_hop->sw->size + WINDOW_SWITCH_DIFF <= nh_entry->sw->size) {
+        if(rt_iface->best_next_hop->sn_count + WINDOW_SWITCH_DIFF <= nh_entry->sn_count) {
             rt_iface->best_next_hop = nh_entry;
         }
 
         batman_rt_nht_entry_t* prev_element = nh_entry;
         nh_entry = nh_entry->hh.next;
 
-        if(prev_element->sw->size == 0) {
+        if(prev_element->sn_count == 0) {
             // previous element is empty -> delete
             HASH_DEL(rt_iface->nh_entrys, prev_element);
 
@@ -199,13 +270,16 @@ int batman_db_nht_shiftuptoseq(batman_rt_if_entry_t* rt_iface, uint16_t seq_num)
 
             batman_db_nht_entry_destroy(prev_element);
         }
+        else {
+            batman_db_rt_update_candidate(rt_entry, rt_iface, prev_element);
+        }
     }
 
     return true;
 }
 
-int batman_db_nht_addseq(batman_rt_if_entry_t* iface_entry,
-                         uint8_t ether_nexthop_addr[ETH_ALEN], uint16_t seq_num) {
+int batman_db_nht_addseq(batman_rt_entry_t* rt_entry, batman_rt_if_entry_t* iface_entry,
+                         uint8_t ether_nexthop_addr[ETH_ALEN], uint16_t seq_num, uint16_t base, int base_moved) {
     batman_rt_nht_entry_t* nh_entry;
 
     // Find entry with ether_nexthop_addr
@@ -222,16 +296,47 @@ int batman_db_nht_addseq(batman_rt_if_entry_t* iface_entry,
     }
 
     // add sequence number to entry sliding window
-    batman_sw_addsn(nh_entry->sw, seq_num);
+    batman_sw_addsn(&nh_entry->sw, seq_num);
+
+    if(base_moved == true) {
+        // counts of all other entrys may have dropped
+        // -> recount and set the BEST NEXT HOP to entry with most count of seq numbers
+        batman_db_nht_rank(rt_entry, iface_entry, base);
+    }
+    else {
+        // only this entry changed, its count can only have grown
+        nh_entry->sn_count = batman_sw_count(&nh_entry->sw, base);
+
+        if(iface_entry->best_next_hop == NULL
+            || iface_entry->best_next_hop->sn_count + WINDOW_SWITCH_DIFF <= nh_entry->sn_count) {
+            iface_entry->best_next_hop = nh_entry;
+        }
+
+        batman_db_rt_update_candidate(rt_entry, iface_entry, nh_entry);
+    }
 
-    // drop all out-of-range seq_num from other entry
-    // AND
-    // set the BEST NEXT HOP to entry with most count of seq numbers
-    batman_db_nht_shiftuptoseq(iface_entry, seq_num);
     return true;
 }
 
-int batman_db_rt_addroute(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t* local_iface, time_t timestamp, uint8_t ether_nexthop_addr[ETH_ALEN], uint16_t seq_num) {
+/** Fill the candidate list of destination again from all next hops */
+void batman_db_rt_sort_candidates(batman_rt_entry_t* rt_entry) {
+    batman_rt_if_entry_t* if_entry = rt_entry->if_entrys;
+
+    batman_db_rt_reset_candidates(rt_entry);
+
+    while(if_entry != NULL) {
+        batman_rt_nht_entry_t* nht_entry = if_entry->nh_entrys;
+
+        while(nht_entry != NULL) {
+            batman_db_rt_update_candidate(rt_entry, if_entry, nht_entry);
+            nht_entry = nht_entry->hh.next;
+        }
+
+        if_entry = if_entry->hh.next;
+    }
+}
+
+int batman_db_rt_addroute(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t* local_iface, uint64_t timestamp, uint8_t ether_nexthop_addr[ETH_ALEN], uint16_t seq_num) {
     batman_rt_entry_t* rt_entry;
     // First find appropriate routing table entry
     HASH_FIND(hh, rt.entrys, ether_dest_addr, ETH_ALEN, rt_entry);
@@ -272,25 +377,35 @@ int batman_db_rt_addroute(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t* l
     /*uint8_t* last_next_hop_addr = (rt_entry->best_output_iface->nht->best_next_hop == NULL)?
     	NULL : rt_entry->best_output_iface->nht->best_next_hop->ether_nexthop_addr; // only for debugging*/
     // actualize the BEST NEXT HOP towards destination and BEST_OUTPUT_IFACE for rt_entry
+    // curr_seq_num is the window base all next hops are counted against
+    int base_moved = (hf_seq_comp_i_j(seq_num, rt_entry->curr_seq_num) > 0);
+    uint16_t base = base_moved ? seq_num : rt_entry->curr_seq_num;
     batman_rt_if_entry_t* curr_iface = rt_entry->if_entrys;
 
+    if(base_moved == true) {
+        // all next hops are ranked again below
+        batman_db_rt_reset_candidates(rt_entry);
+    }
+
     while(curr_iface != NULL) {
         if(curr_iface->ether_iface == local_iface) {
             // actualize BEST NEXT HOP towards destination for given local_interface
-            if(batman_db_nht_addseq(curr_iface, ether_nexthop_addr, seq_num) == false) {
+            if(batman_db_nht_addseq(rt_entry, curr_iface, ether_nexthop_addr, seq_num, base, base_moved) == false) {
                 dessert_crit("could not allocate memory");
+                batman_db_rt_sort_candidates(rt_entry);
                 return false;
             }
         }
-        else {
-            // shift sliding window for all other interfaces
-            batman_db_nht_shiftuptoseq(curr_iface, seq_num);
+        else if(base_moved == true) {
+            // recount sliding windows for all other interfaces
+            batman_db_nht_rank(rt_entry, curr_iface, base);
         }
 
         // actualize BEST OUTPUT IFACE
         if(curr_iface->best_next_hop != NULL &&
-           (rt_entry->best_output_iface->best_next_hop->sw->size + WINDOW_SWITCH_DIFF
-            <= curr_iface->best_next_hop->sw->size)) {
+           (rt_entry->best_output_iface->best_next_hop == NULL ||
+            rt_entry->best_output_iface->best_next_hop->sn_count + WINDOW_SWITCH_DIFF
+            <= curr_iface->best_next_hop->sn_count)) {
             rt_entry->best_output_iface = curr_iface;
         }
 
@@ -310,11 +425,8 @@ int batman_db_rt_addroute(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t* l
     }
 
     // actualize curr_seq_anum and last_aware_time
-    // and
-    // add/replace current routing entry in timeslot
-    rt_entry->curr_seq_num = seq_num;
+    rt_entry->curr_seq_num = base;
     rt_entry->last_aw_time = timestamp;
-    timeslot_addobject(rt.ts, timestamp, rt_entry);
     return true;
 }
 
@@ -334,66 +446,16 @@ int batman_db_rt_getbestroute(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_
     return true;
 }
 
-void _add_myinterfaces_to_precursors(uint8_t precursors_iface_list[OGM_PREC_LIST_SIZE* ETH_ALEN], uint8_t* precursors_iface_count) {
+void _add_myinterfaces_to_precursors(hf_prec_filter_t* precursors) {
     dessert_meshif_t* my_ifaces = dessert_meshiflist_get();
 
     while(my_ifaces != NULL) {
-        if((*precursors_iface_count) < OGM_PREC_LIST_SIZE) {
-            // increment size and write my default address to end of list
-            uint8_t* el_start_address = precursors_iface_list + ETH_ALEN * (*precursors_iface_count);
-            memcpy(el_start_address, my_ifaces->hwaddr, ETH_ALEN);
-            (*precursors_iface_count)++;
-        }
-        else {   // precursor list is full
-            // delete first element and move all elements to begin of the list.
-            // add my default address to end of list.
-            if(OGM_PREC_LIST_SIZE > 1) {
-                memmove(precursors_iface_list, precursors_iface_list + ETH_ALEN, ETH_ALEN *(OGM_PREC_LIST_SIZE - 1));
-            }
-
-            memcpy(precursors_iface_list + (OGM_PREC_LIST_SIZE - 1)*ETH_ALEN, my_ifaces->hwaddr, ETH_ALEN);
-        }
-
+        hf_prec_add(precursors, my_ifaces->hwaddr);
         my_ifaces = my_ifaces->next;
     }
 }
 
-int _check_precursors_list(uint8_t precursors_iface_list[OGM_PREC_LIST_SIZE* ETH_ALEN],
-                           uint8_t* precursors_iface_count, uint8_t iface_addr[ETH_ALEN]) {
-    int i;
-
-    for(i = (*precursors_iface_count) - 1; i >= 0; i--) {
-        // start to search from !END! It is very presumably that i am the last entry in the list
-        uint8_t* el_start_address = precursors_iface_list + ETH_ALEN * i;
-
-        if(memcmp(el_start_address, iface_addr, ETH_ALEN) == 0) {
-            return true;
-        }
-    }
-
-    return false;
-}
-
-typedef struct route_entry {
-    uint8_t             next_hop[ETH_ALEN];
-    dessert_meshif_t*   out_iface;
-    uint8_t             quality;
-    struct route_entry* next, *prev;
-} route_entry_t;
-
-int compare_routing_entrys(route_entry_t* e1, route_entry_t* e2) {
-    if(e1->quality > e2->quality) {
-        return -1;
-    }
-
-    if(e1->quality < e2->quality) {
-        return 1;
-    }
-
-    return 0;
-}
-
-int batman_db_rt_getbestroute_arl(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t** ether_iface_out, uint8_t ether_nexthop_addr_out[ETH_ALEN], uint8_t precursors_iface_list[OGM_PREC_LIST_SIZE* ETH_ALEN], uint8_t* presursosr_iface_count) {
+int batman_db_rt_getbestroute_arl(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t** ether_iface_out, uint8_t ether_nexthop_addr_out[ETH_ALEN], hf_prec_filter_t* precursors) {
     batman_rt_entry_t* rt_entry;
 
     // find appropriate routing table entry
@@ -405,59 +467,63 @@ int batman_db_rt_getbestroute_arl(uint8_t ether_dest_addr[ETH_ALEN], dessert_mes
     }
 
     // first check if best route not contained in precursors list
-    if(_check_precursors_list(precursors_iface_list, presursosr_iface_count,
-                              rt_entry->best_output_iface->best_next_hop->ether_nexthop_addr) == false) {
+    if(hf_prec_contains(precursors, rt_entry->best_output_iface->best_next_hop->ether_nexthop_addr) == false) {
         *ether_iface_out = rt_entry->best_output_iface->ether_iface;
         memcpy(ether_nexthop_addr_out, rt_entry->best_output_iface->best_next_hop->ether_nexthop_addr, ETH_ALEN);
-        _add_myinterfaces_to_precursors(precursors_iface_list, presursosr_iface_count);
+        _add_myinterfaces_to_precursors(precursors);
         return true;
     }
 
     // otherwise find another next hop
     dessert_debug("route looping detected! trying to avoid ... ");
 
-    route_entry_t* re_list = NULL;
-    batman_rt_if_entry_t* if_entry = rt_entry->if_entrys;
+    int found = false;
+    route_entry_t* re = NULL;
+    int i;
 
-    while(if_entry != NULL) {
-        batman_rt_nht_entry_t* nht_entry = if_entry->nh_entrys;
+    // candidates are sorted by quality -> take the first one not in precursors list
+    for(i = 0; i < rt_entry->candidate_count; i++) {
+        if(hf_prec_contains(precursors, rt_entry->candidates[i].next_hop) == false) {
+            re = &rt_entry->candidates[i];
+            break;
+        }
+    }
 
-        while(nht_entry != NULL) {
-            route_entry_t* re = malloc(sizeof(route_entry_t));
+    if(re != NULL) {
+        *ether_iface_out = re->out_iface;
+        memcpy(ether_nexthop_addr_out, re->next_hop, ETH_ALEN);
+        found = true;
+    }
+    else if(rt_entry->candidates_truncated == true) {
+        // all candidates loop -> search best of the remaining next hops
+        batman_rt_nht_entry_t* best_nht_entry = NULL;
+        batman_rt_if_entry_t* if_entry = rt_entry->if_entrys;
+
+        while(if_entry != NULL) {
+            batman_rt_nht_entry_t* nht_entry = if_entry->nh_entrys;
 
-            if(re != NULL) {
-                memcpy(re->next_hop, nht_entry->ether_nexthop_addr, ETH_ALEN);
-                re->out_iface = if_entry->ether_iface;
-                re->quality = nht_entry->sw->size;
-                DL_APPEND(re_list, re);
+            while(nht_entry != NULL) {
+                if((best_nht_entry == NULL || nht_entry->sn_count > best_nht_entry->sn_count)
+                    && hf_prec_contains(precursors, nht_entry->ether_nexthop_addr) == false) {
+                    best_nht_entry = nht_entry;
+                    *ether_iface_out = if_entry->ether_iface;
+                }
+
+                nht_entry = nht_entry->hh.next;
             }
 
-            nht_entry = nht_entry->hh.next;
+            if_entry = if_entry->hh.next;
         }
 
-        if_entry = if_entry->hh.next;
-    }
-
-    int found = false;
-    DL_SORT(re_list, compare_routing_entrys);
-    route_entry_t* re = re_list;
-
-    while(re != NULL) {
-        route_entry_t* current_entry = re;
-        re = re->next;
-
-        if(found == false && _check_precursors_list(precursors_iface_list, presursosr_iface_count,
-                current_entry->next_hop) == false) {
-            // set next hop and output_iface towards destination
-            *ether_iface_out = current_entry->out_iface;
-            memcpy(ether_nexthop_addr_out, current_entry->next_hop, ETH_ALEN);
+        if(best_nht_entry != NULL) {
+            memcpy(ether_nexthop_addr_out, best_nht_entry->ether_nexthop_addr, ETH_ALEN);
             found = true;
-            // add myself to precursors
-            _add_myinterfaces_to_precursors(precursors_iface_list, presursosr_iface_count);
         }
+    }
 
-        DL_DELETE(re_list, current_entry);
-        free(current_entry);
+    if(found == true) {
+        // add myself to precursors
+        _add_myinterfaces_to_precursors(precursors);
     }
 
     if(found == true) {
@@ -483,21 +549,47 @@ int batman_db_rt_getroutesn(uint8_t ether_dest_addr[ETH_ALEN]) {
     return rt_entry->curr_seq_num;
 }
 
-int batman_db_rt_cleanup() {
-    return timeslot_purgeobjects(rt.ts, time(0));
+int batman_db_rt_addogmseq(uint8_t ether_dest_addr[ETH_ALEN], uint16_t seq_num) {
+    batman_rt_entry_t* rt_entry;
+    HASH_FIND(hh, rt.entrys, ether_dest_addr, ETH_ALEN, rt_entry);
+
+    if(rt_entry == NULL) {
+        return false;
+    }
+
+    if(rt_entry->rebrc_valid == true && hf_seq_comp_i_j(rt_entry->rebrc_seq_num, seq_num) >= 0) {
+        return false;
+    }
+
+    rt_entry->rebrc_seq_num = seq_num;
+    rt_entry->rebrc_valid = true;
+    return true;
 }
 
-int batman_db_rt_change_pt(time_t pudge_timeout) {
-    timeslot_change_pt(rt.ts, pudge_timeout);
+/**
+ * Pudge destinations not aware for purge_timeout.
+ * HINT: OGM processing only touches last_aw_time of the entry (under the
+ * originator lock), so entrys are swept here instead of being kept in a timeslot.
+ */
+int batman_db_rt_cleanup() {
+    batman_rt_entry_t* rt_entry;
+    batman_rt_entry_t* tmp;
+    uint64_t now = hf_time_ms();
+
+    HASH_ITER(hh, rt.entrys, rt_entry, tmp) {
+        if(rt_entry->last_aw_time + rt.purge_timeout <= now) {
+            dessert_debug("--- " MAC " - timeout", EXPLODE_ARRAY6(rt_entry->ether_dest_addr));
+            HASH_DEL(rt.entrys, rt_entry);
+            batman_db_rt_entry_destroy(rt_entry);
+        }
+    }
+
     return true;
 }
 
-/** routing entry element by timeout */
-void pudge_old_destination(time_t lasw_aw_time, void* entry) {
-    batman_rt_entry_t* rt_entry = entry;
-    dessert_debug("--- " MAC " - timeout", EXPLODE_ARRAY6(rt_entry->ether_dest_addr));
-    HASH_DEL(rt.entrys, rt_entry);
-    batman_db_rt_entry_destroy(rt_entry);
+int batman_db_rt_change_pt(uint32_t pudge_timeout) {
+    rt.purge_timeout = pudge_timeout;
+    return true;
 }
 
 int batman_db_rt_deleteroute(uint8_t ether_dest_addr[ETH_ALEN]) {
@@ -510,13 +602,9 @@ int batman_db_rt_deleteroute(uint8_t ether_dest_addr[ETH_ALEN]) {
         return false;
     }
 
-    if(timeslot_deleteobject(rt.ts, rt_entry) == true) {
-        HASH_DEL(rt.entrys, rt_entry);
-        batman_db_rt_entry_destroy(rt_entry);
-        return true;
-    }
-
-    return false;
+    HASH_DEL(rt.entrys, rt_entry);
+    batman_db_rt_entry_destroy(rt_entry);
+    return true;
 }
 
 void batman_db_rt_change_window_size(uint8_t window_size) {
@@ -532,22 +620,26 @@ void batman_db_rt_change_window_size(uint8_t window_size) {
             nht_entry = if_entry->nh_entrys;
 
             while(nht_entry != NULL) {
-                batman_sw_chage_size(nht_entry->sw, window_size);
+                // windows are only counted against curr_seq_num, not shifted to it
+                // -> drop what already left the window before a bigger one brings it back
+                batman_sw_dropsn(&nht_entry->sw, rt_entry->curr_seq_num);
+                batman_sw_chage_size(&nht_entry->sw, window_size);
+                nht_entry->sn_count = batman_sw_count(&nht_entry->sw, rt_entry->curr_seq_num);
                 nht_entry = nht_entry->hh.next;
             }
 
             if_entry = if_entry->hh.next;
         }
 
-        if_entry = if_entry->hh.next;
+        batman_db_rt_sort_candidates(rt_entry);
+
+        rt_entry = rt_entry->hh.next;
     }
 }
 
 int batman_db_rt_init() {
     rt.entrys = NULL;
-    timeslot_t* ts;
-    timeslot_create(&ts, PURGE_TIMEOUT, pudge_old_destination);
-    rt.ts = ts;
+    rt.purge_timeout = PURGE_TIMEOUT;
     return true;
 }
 
@@ -556,7 +648,7 @@ int batman_db_nht_get_totalsncount(batman_rt_if_entry_t* rt_iface) {
     batman_rt_nht_entry_t* curr_entry = rt_iface->nh_entrys;
 
     while(curr_entry != NULL) {
-        count += curr_entry->sw->size;
+        count += curr_entry->sn_count;
         curr_entry = curr_entry->hh.next;
     }
 
@@ -592,14 +684,14 @@ int batman_db_rt_report(char** str_out) {
     strcat(output, "+-------------------+-------------------+-------------------+-----------------+-----------------+---------------+\n");
 
     while(current_entry != NULL) {		// first line for best output interface
-        snprintf(entry_str, REPORT_RT_STR_LEN + 1, "| " MAC " | " MAC " | " MAC " | %15i | %15i | %7i / %3i |\n",
+        snprintf(entry_str, REPORT_RT_STR_LEN + 1, "| " MAC " | " MAC " | " MAC " | %15llu | %15i | %7i / %3i |\n",
             EXPLODE_ARRAY6(current_entry->ether_dest_addr),
             EXPLODE_ARRAY6(current_entry->best_output_iface->best_next_hop->ether_nexthop_addr),
             EXPLODE_ARRAY6(current_entry->best_output_iface->ether_iface->hwaddr),
-            (int) current_entry->last_aw_time,
+            (unsigned long long) current_entry->last_aw_time,
             current_entry->curr_seq_num,
-            current_entry->best_output_iface->best_next_hop->sw->size,
-            current_entry->best_output_iface->best_next_hop->sw->window_size);
+            current_entry->best_output_iface->best_next_hop->sn_count,
+            current_entry->best_output_iface->best_next_hop->sw.window_size);
         strcat(output, entry_str);
         batman_rt_if_entry_t* curr_iface = current_entry->if_entrys;
 
@@ -608,8 +700,8 @@ int batman_db_rt_report(char** str_out) {
                 snprintf(entry_str, REPORT_RT_STR_LEN + 1, "| " MAC " | " MAC " | | | | %7i / %3i |\n",
                     EXPLODE_ARRAY6(curr_iface->best_next_hop->ether_nexthop_addr),
                     EXPLODE_ARRAY6(curr_iface->ether_iface->hwaddr),
-                    curr_iface->best_next_hop->sw->size,
-                    curr_iface->best_next_hop->sw->window_size);
+                    curr_iface->best_next_hop->sn_count,
+                    curr_iface->best_next_hop->sw.window_size);
                 strcat(output, entry_str);
             }
 
@@ -26,11 +26,12 @@ For further information and questions please use the web site
 
 #include <dessert.h>
 #include "../../config.h"
+#include "../../helper.h"
 
 int batman_db_rt_init();
 
 /** Add routing entry into routing table */
-int batman_db_rt_addroute(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t* ether_iface, time_t timestamp, uint8_t ether_nexthop_addr[ETH_ALEN], uint16_t seq_num);
+int batman_db_rt_addroute(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t* ether_iface, uint64_t timestamp, uint8_t ether_nexthop_addr[ETH_ALEN], uint16_t seq_num);
 
 /** delete route to destination */
 int batman_db_rt_deleteroute(uint8_t ether_dest_addr[ETH_ALEN]);
@@ -42,16 +43,22 @@ int batman_db_rt_getbestroute(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_
  * Get best route (next hop) towards destination from routing table
  * that avoids routing loops
  */
-int batman_db_rt_getbestroute_arl(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t** ether_iface_out, uint8_t ether_nexthop_addr_out[ETH_ALEN], uint8_t precursors_iface_list[OGM_PREC_LIST_SIZE* ETH_ALEN], uint8_t* presursosr_iface_count);
+int batman_db_rt_getbestroute_arl(uint8_t ether_dest_addr[ETH_ALEN], dessert_meshif_t** ether_iface_out, uint8_t ether_nexthop_addr_out[ETH_ALEN], hf_prec_filter_t* precursors);
 
 /** Get last know seq_num of destination */
 int batman_db_rt_getroutesn(uint8_t ether_dest_addr[ETH_ALEN]);
 
+/**
+ * Take a record that OGM of destination with seq_num is re-broadcasted.
+ * Returns true if no OGM with this or a newer seq_num was re-broadcasted before
+ */
+int batman_db_rt_addogmseq(uint8_t ether_dest_addr[ETH_ALEN], uint16_t seq_num);
+
 /** Pudge old rows from routing table */
 int batman_db_rt_cleanup();
 
 /** Change pusge timeout for routing table */
-int batman_db_rt_change_pt(time_t pudge_timeout);
+int batman_db_rt_change_pt(uint32_t pudge_timeout);
 
 /** Change window size in all sliding windows in entire routing table */
 void batman_db_rt_change_window_size(uint8_t window_size);
@@ -21,156 +21,151 @@ For further information and questions please use the web site
        http://www.des-testbed.net
 *******************************************************************************/
 
+#include <string.h>
 #include "batman_sw.h"
 #include "../../helper.h"
 #include "../../config.h"
 
-int batman_create_new_sw_element(batman_sw_element_t** sw_el_out, uint16_t seq_num) {
-    batman_sw_element_t* new_el;
+/** count set bits among the lowest n bits of the window */
+static uint16_t _popcount_lowest(const batman_sw_t* sw, unsigned int n) {
+    uint16_t count = 0;
+    unsigned int i;
 
-    new_el = malloc(sizeof(batman_sw_element_t));
+    for(i = 0; i < BATMAN_SW_WORDS && n > 0; i++) {
+        uint64_t word = sw->bits[i];
 
-    if(new_el == NULL) {
-        return false;
+        if(n < 64) {
+            word &= ((uint64_t) 1 << n) - 1;
+            n = 0;
+        }
+        else {
+            n -= 64;
+        }
+
+        count += __builtin_popcountll(word);
     }
 
-    new_el->next = NULL;
-    new_el->prev = NULL;
-    new_el->seq_num = seq_num;
-    *sw_el_out = new_el;
-    return true;
+    return count;
 }
 
-int batman_sw_create(batman_sw_t** swout, uint8_t ws) {
-    batman_sw_t* sw;
-    sw = malloc(sizeof(batman_sw_t));
+/** clear all bits at and above window_size */
+static void _mask(batman_sw_t* sw) {
+    unsigned int i;
 
-    if(sw == NULL) {
-        return false;
-    }
+    for(i = 0; i < BATMAN_SW_WORDS; i++) {
+        unsigned int low = i * 64;
 
-    sw->head = NULL;
-    sw->tail = NULL;
-    sw->size = 0;
-    sw->window_size = ws;
-    *swout = sw;
-    return true;
+        if(sw->window_size <= low) {
+            sw->bits[i] = 0;
+        }
+        else if(sw->window_size < low + 64) {
+            sw->bits[i] &= ((uint64_t) 1 << (sw->window_size - low)) - 1;
+        }
+    }
 }
 
-int batman_sw_destroy(batman_sw_t* sw) {
-    batman_sw_element_t* temp_el;
-    batman_sw_element_t* search_el = sw->tail;
-
-    while(search_el != NULL) {
-        temp_el = search_el;
-        search_el = search_el->next;
-        free(temp_el);
+/** move window forward by shift sequence numbers */
+static void _shift(batman_sw_t* sw, uint16_t shift) {
+    if(shift >= sw->window_size) {
+        memset(sw->bits, 0, sizeof(sw->bits));
+        return;
     }
 
-    free(sw);
-    return true;
-};
-
-int batman_sw_dropsn(batman_sw_t* sw, uint16_t seq_num) {
-    batman_sw_element_t* search_el = sw->tail;
+    int words = shift / 64;
+    int bits = shift % 64;
+    int i;
 
-    while(search_el != NULL && hf_seq_comp_i_j(seq_num, search_el->seq_num + sw->window_size) >= 0) {
-        search_el = search_el->next;
+    for(i = BATMAN_SW_WORDS - 1; i >= 0; i--) {
+        uint64_t word = (i >= words) ? sw->bits[i - words] << bits : 0;
 
-        if(search_el != NULL) {
-            search_el->prev = NULL;
+        if(bits && i > words) {
+            word |= sw->bits[i - words - 1] >> (64 - bits);
         }
 
-        free(sw->tail);
+        sw->bits[i] = word;
+    }
 
-        if(sw->tail == sw->head) {
-            sw->tail = sw->head = search_el;
-        }
-        else {
-            sw->tail = search_el;
-        }
+    _mask(sw);
+}
+
+static int _empty(const batman_sw_t* sw) {
+    unsigned int i;
 
-        sw->size--;
+    for(i = 0; i < BATMAN_SW_WORDS; i++) {
+        if(sw->bits[i]) {
+            return false;
+        }
     }
 
     return true;
 }
 
-int batman_sw_addsn(batman_sw_t* sw, uint16_t seq_num) {
-    batman_sw_element_t* new_el;
+void batman_sw_init(batman_sw_t* sw, uint8_t ws) {
+    memset(sw->bits, 0, sizeof(sw->bits));
+    sw->head = 0;
+    sw->window_size = ws;
+}
 
-    if((sw->head != NULL) &&
-       (hf_seq_comp_i_j(sw->head->seq_num, seq_num + sw->window_size) >= 0)) {
-        return true;
+int batman_sw_dropsn(batman_sw_t* sw, uint16_t seq_num) {
+    if(hf_seq_comp_i_j(seq_num, sw->head) > 0) {
+        _shift(sw, seq_num - sw->head);
+        sw->head = seq_num;
     }
 
-    if(sw->size == 0) {
-        if(batman_create_new_sw_element(&new_el, seq_num) == false) {
-            return false;
-        }
+    return true;
+}
 
-        sw->head = sw->tail = new_el;
-        sw->size = 1;
+int batman_sw_addsn(batman_sw_t* sw, uint16_t seq_num) {
+    if(sw->window_size == 0) {
         return true;
     }
 
-    // insert new element to appropriate place
-    batman_sw_element_t* search_el = sw->head;
+    if(_empty(sw)) {
+        sw->head = seq_num;
+    }
+    else if(hf_seq_comp_i_j(seq_num, sw->head) > 0) {
+        _shift(sw, seq_num - sw->head);
+        sw->head = seq_num;
+    }
 
-    while(search_el->prev != NULL && hf_seq_comp_i_j(search_el->seq_num, seq_num) >= 0) {
-        if(search_el->seq_num == seq_num) {
-            return true;
-        }
+    uint16_t bit = sw->head - seq_num;
 
-        // we search for an smaller element
-        search_el = search_el->prev;
+    if(bit < sw->window_size) {
+        sw->bits[bit / 64] |= (uint64_t) 1 << (bit % 64);
     }
 
-    if(search_el->seq_num == seq_num) {
-        return true;
+    return true;
+}
+
+int batman_sw_contains(const batman_sw_t* sw, uint16_t seq_num) {
+    if(hf_seq_comp_i_j(seq_num, sw->head) > 0) {
+        return false;
     }
 
-    if(batman_create_new_sw_element(&new_el, seq_num) == false) {
+    uint16_t bit = sw->head - seq_num;
+
+    if(bit >= sw->window_size) {
         return false;
     }
 
-    if(hf_seq_comp_i_j(search_el->seq_num, seq_num) < 0) {
-        // insert new element after search element
-        new_el->prev = search_el;
-        new_el->next = search_el->next;
-        search_el->next = new_el;
+    return (sw->bits[bit / 64] >> (bit % 64)) & 1;
+}
 
-        if(new_el->next != NULL) {
-            new_el->next->prev = new_el;
-        }
+uint16_t batman_sw_count(const batman_sw_t* sw, uint16_t base) {
+    uint16_t shift = 0;
 
-        if(sw->head == search_el) {
-            sw->head = new_el;
-        }
+    if(hf_seq_comp_i_j(base, sw->head) > 0) {
+        shift = base - sw->head;
     }
-    else {
-        // insert new element befor search element
-        new_el->prev = search_el->prev;
-        new_el->next = search_el;
-        search_el->prev = new_el;
-
-        if(new_el->prev != NULL) {
-            new_el->prev->next = new_el;
-        }
 
-        if(sw->tail == search_el) {
-            sw->tail = new_el;
-        }
+    if(shift >= sw->window_size) {
+        return 0;
     }
 
-    sw->size++;
-
-    // drop all elements out of WINDOW_SIZE range
-    batman_sw_dropsn(sw, sw->head->seq_num);
-    return true;
+    return _popcount_lowest(sw, sw->window_size - shift);
 }
 
 void batman_sw_chage_size(batman_sw_t* sw, uint8_t ws) {
     sw->window_size = ws;
-    batman_sw_dropsn(sw, sw->head->seq_num);
+    _mask(sw);
 }
@@ -27,24 +27,23 @@ For further information and questions please use the web site
 #include <stdlib.h>
 #include <stdint.h>
 
-typedef struct batman_sw_element {
-    struct batman_sw_element*   prev;
-    struct batman_sw_element*   next;
-    uint16_t                    seq_num;
-} batman_sw_element_t;
+/** number of 64 bit words in a window, enough for any uint8_t window size */
+#define BATMAN_SW_WORDS     4
 
+/**
+ * Sliding window over received sequence numbers.
+ * Bit i is set if sequence number head - i was received.
+ * Bits at and above window_size are always cleared.
+ */
 typedef struct batman_sw {
-    struct batman_sw_element*   head;
-    struct batman_sw_element*   tail;
-    uint16_t                    size;
-    uint8_t                     window_size;
+    uint64_t    bits[BATMAN_SW_WORDS];
+    /** newest sequence number in window (only valid if a bit is set) */
+    uint16_t    head;
+    uint8_t     window_size;
 } batman_sw_t;
 
-/** Create sliding window */
-int batman_sw_create(batman_sw_t** sw, uint8_t ws);
-
-/** Remove all Seq_Num elements and destroy sliding window */
-int batman_sw_destroy(batman_sw_t* sw);
+/** Initialize empty sliding window */
+void batman_sw_init(batman_sw_t* sw, uint8_t ws);
 
 /** Add sequence number to sliding window.
  * Drops all values out of  {max_value - WINDOW_SIZE + 1, max_value} range */
@@ -53,6 +52,16 @@ int batman_sw_addsn(batman_sw_t* sw, uint16_t value);
 /**Drops all sequence numbers out of  {value - WINDOW_SIZE + 1, value} range*/
 int batman_sw_dropsn(batman_sw_t* sw, uint16_t value);
 
+/** Check whether sequence number is contained in sliding window */
+int batman_sw_contains(const batman_sw_t* sw, uint16_t value);
+
+/**
+ * Count sequence numbers in {base - WINDOW_SIZE + 1, base} range
+ * without shifting the window. Used to rank windows of all next hops
+ * against the newest sequence number of the originator.
+ */
+uint16_t batman_sw_count(const batman_sw_t* sw, uint16_t base);
+
 void batman_sw_chage_size(batman_sw_t* sw, uint8_t ws);
 
 
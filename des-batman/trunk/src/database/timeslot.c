@@ -22,10 +22,31 @@ For further information and questions please use the web site
 *******************************************************************************/
 
 #include <stdio.h>
+#include <string.h>
+#include <utlist.h>
 #include "timeslot.h"
 #include "../config.h"
 
-int create_new_ts_element(timeslot_element_t** ts_el_out, time_t timestamp, void* object) {
+static uint32_t _tick(uint32_t pudge_timeout) {
+    // one turn of the wheel covers the pudge timeout and the tick it starts in
+    uint32_t tick = (pudge_timeout + TIMESLOT_WHEEL_SIZE - 2) / (TIMESLOT_WHEEL_SIZE - 1);
+    return (tick > 0) ? tick : 1;
+}
+
+/** put element into the slot of its expiry tick, but not into a tick already purged */
+static void _insert(timeslot_t* ts, timeslot_element_t* el) {
+    uint64_t expiry_tick = (el->timestamp + ts->purge_timeout) / ts->tick;
+    uint64_t purge_tick = ts->last_purge / ts->tick;
+
+    if(expiry_tick < purge_tick) {
+        expiry_tick = purge_tick;
+    }
+
+    el->slot = expiry_tick % TIMESLOT_WHEEL_SIZE;
+    DL_APPEND(ts->wheel[el->slot], el);
+}
+
+int create_new_ts_element(timeslot_element_t** ts_el_out, uint64_t timestamp, void* object) {
     timeslot_element_t* new_el;
 
     new_el = malloc(sizeof(timeslot_element_t));
@@ -43,7 +64,7 @@ int create_new_ts_element(timeslot_element_t** ts_el_out, time_t timestamp, void
     return true;
 }
 
-int timeslot_create(timeslot_t** ts_out, time_t pudge_timeout, pudge_object_t* callback) {
+int timeslot_create(timeslot_t** ts_out, uint32_t pudge_timeout, pudge_object_t* callback) {
     timeslot_t* ts;
     ts = malloc(sizeof(timeslot_t));
 
@@ -52,10 +73,11 @@ int timeslot_create(timeslot_t** ts_out, time_t pudge_timeout, pudge_object_t* c
         return false;
     }
 
-    ts->head = NULL;
-    ts->tail = NULL;
+    memset(ts->wheel, 0, sizeof(ts->wheel));
     ts->size = 0;
     ts->purge_timeout = pudge_timeout;
+    ts->tick = _tick(pudge_timeout);
+    ts->last_purge = 0;
     ts->object_pudger = callback;
     ts->elements_hash = NULL;
     *ts_out = ts;
@@ -63,131 +85,112 @@ int timeslot_create(timeslot_t** ts_out, time_t pudge_timeout, pudge_object_t* c
 }
 
 int timeslot_destroy(timeslot_t* ts) {
-    timeslot_element_t* temp_el;
-    timeslot_element_t* search_el = ts->tail;
+    timeslot_element_t* el;
+    timeslot_element_t* tmp;
 
-    while(search_el != NULL) {
-        temp_el = search_el;
-        search_el = search_el->next;
-        HASH_DEL(ts->elements_hash, temp_el);
+    HASH_ITER(hh, ts->elements_hash, el, tmp) {
+        HASH_DEL(ts->elements_hash, el);
 
         if(ts->object_pudger != NULL) {
-            ts->object_pudger(temp_el->timestamp, temp_el->object);
+            ts->object_pudger(el->timestamp, el->object);
         }
 
-        free(temp_el);
+        free(el);
     }
 
     free(ts);
     return true;
 };
 
-int timeslot_change_pt(timeslot_t* ts, time_t pudge_timeout) {
-    ts->purge_timeout = pudge_timeout;
-
-    if(ts->head != NULL) {
-        timeslot_purgeobjects(ts, ts->head->timestamp);
-    }
-
-    return true;
-}
+int timeslot_change_pt(timeslot_t* ts, uint32_t pudge_timeout) {
+    timeslot_element_t* el;
+    timeslot_element_t* tmp;
 
-int timeslot_purgeobjects(timeslot_t* ts, time_t timestamp) {
-    timeslot_element_t* search_el = ts->tail;
-
-    while(search_el != NULL && search_el->timestamp + ts->purge_timeout <= timestamp) {
-        search_el = search_el->next;
-        HASH_DEL(ts->elements_hash, ts->tail);
+    ts->purge_timeout = pudge_timeout;
+    ts->tick = _tick(pudge_timeout);
 
-        if(search_el != NULL) {
-            search_el->prev = NULL;
-        }
+    // expiry times changed -> re-sort all elements into the wheel
+    // and pudge those already expired with the new timeout
+    memset(ts->wheel, 0, sizeof(ts->wheel));
 
-        if(ts->object_pudger != NULL) {
-            ts->object_pudger(ts->tail->timestamp, ts->tail->object);
-        }
+    HASH_ITER(hh, ts->elements_hash, el, tmp) {
+        if(el->timestamp + ts->purge_timeout <= ts->last_purge) {
+            HASH_DEL(ts->elements_hash, el);
+            ts->size--;
 
-        free(ts->tail);
+            if(ts->object_pudger != NULL) {
+                ts->object_pudger(el->timestamp, el->object);
+            }
 
-        if(ts->tail == ts->head) {
-            ts->tail = ts->head = search_el;
+            free(el);
         }
         else {
-            ts->tail = search_el;
+            _insert(ts, el);
         }
-
-        ts->size--;
     }
 
     return true;
 }
 
-int timeslot_addobject(timeslot_t* ts, time_t timestamp, void* object) {
-    timeslot_element_t* new_el;
-
-    // first find element with *object pointer and delete this element
-    timeslot_deleteobject(ts, object);
+int timeslot_purgeobjects(timeslot_t* ts, uint64_t timestamp) {
+    uint64_t first_tick = ts->last_purge / ts->tick;
+    uint64_t last_tick = timestamp / ts->tick;
+    uint64_t curr_tick;
 
-    // if new element out if date -> execute object_pudger and do nothing
-    if((ts->head != NULL) && (timestamp + ts->purge_timeout <= ts->head->timestamp)) {
-        ts->object_pudger(timestamp, object);
+    if(timestamp < ts->last_purge) {
         return true;
     }
 
-    if(create_new_ts_element(&new_el, timestamp, object) == false) {
-        return false;
-    }
-
-    HASH_ADD_KEYPTR(hh, ts->elements_hash, &new_el->object, sizeof(void*), new_el);
-
-    // if this is a first element -> set tail and head
-    if(ts->size == 0) {
-        ts->head = ts->tail = new_el;
-        ts->size = 1;
-        return true;
+    if(last_tick - first_tick > TIMESLOT_WHEEL_SIZE) {
+        // more than one turn elapsed -> look at every slot once
+        first_tick = last_tick - TIMESLOT_WHEEL_SIZE;
     }
 
-    // insert new element to apropriate place
-    timeslot_element_t* search_el = ts->head;
-
-    while(search_el->prev != NULL && timestamp < search_el->timestamp) {
-        // we search for an smaller element
-        search_el = search_el->prev;
+    // only ticks that are over, the current one is purged when it is over as well
+    for(curr_tick = first_tick; curr_tick < last_tick; curr_tick++) {
+        timeslot_element_t** slot = &ts->wheel[curr_tick % TIMESLOT_WHEEL_SIZE];
+        timeslot_element_t* el;
+        timeslot_element_t* tmp;
+
+        DL_FOREACH_SAFE(*slot, el, tmp) {
+            // HINT: only elements with timestamps in the future may not be expired yet
+            if(el->timestamp + ts->purge_timeout <= timestamp) {
+                DL_DELETE(*slot, el);
+                HASH_DEL(ts->elements_hash, el);
+                ts->size--;
+
+                if(ts->object_pudger != NULL) {
+                    ts->object_pudger(el->timestamp, el->object);
+                }
+
+                free(el);
+            }
+        }
     }
 
-    if(timestamp >= search_el->timestamp) {
-        // insert new element after search element
-        new_el->prev = search_el;
-        new_el->next = search_el->next;
-        search_el->next = new_el;
+    ts->last_purge = timestamp;
+    return true;
+}
 
-        if(new_el->next != NULL) {
-            new_el->next->prev = new_el;
-        }
+int timeslot_addobject(timeslot_t* ts, uint64_t timestamp, void* object) {
+    timeslot_element_t* el;
+    HASH_FIND(hh, ts->elements_hash, &object, sizeof(void*), el);
 
-        if(ts->head == search_el) {
-            ts->head = new_el;
-        }
+    if(el != NULL) {
+        // refresh -> move to slot of new expiry time
+        DL_DELETE(ts->wheel[el->slot], el);
+        el->timestamp = timestamp;
+        _insert(ts, el);
+        return true;
     }
-    else {
-        // insert new element bevor search element
-        new_el->prev = search_el->prev;
-        new_el->next = search_el;
-        search_el->prev = new_el;
-
-        if(new_el->prev != NULL) {
-            new_el->prev->next = new_el;
-        }
 
-        if(ts->tail == search_el) {
-            ts->tail = new_el;
-        }
+    if(create_new_ts_element(&el, timestamp, object) == false) {
+        return false;
     }
 
+    HASH_ADD_KEYPTR(hh, ts->elements_hash, &el->object, sizeof(void*), el);
+    _insert(ts, el);
     ts->size++;
-
-    // drop all elements out of WINDOW_SIZE range
-    timeslot_purgeobjects(ts, ts->head->timestamp);
     return true;
 }
 
@@ -198,22 +201,7 @@ int timeslot_deleteobject(timeslot_t* ts, void* object) {
 
     // then delete if found
     if(old_el != NULL) {
-        if(old_el->prev != NULL) {
-            old_el->prev->next = old_el->next;
-        }
-
-        if(old_el->next != NULL) {
-            old_el->next->prev = old_el->prev;
-        }
-
-        if(ts->tail == old_el) {
-            ts->tail = ts->tail->next;
-        }
-
-        if(ts->head == old_el) {
-            ts->head = ts->head->prev;
-        }
-
+        DL_DELETE(ts->wheel[old_el->slot], old_el);
         HASH_DEL(ts->elements_hash, old_el);
         free(old_el);
         ts->size--;
@@ -226,15 +214,6 @@ int timeslot_deleteobject(timeslot_t* ts, void* object) {
 void timeslot_report(timeslot_t* ts) {
     printf("---------- Time Slot  -------------\n");
     printf("Timeslot size : %i\n", ts->size);
-    printf("max timestamp : %i\n", (int)ts->head->timestamp);
-    timeslot_element_t* search_el = ts->tail;
-    printf("elements : (");
-
-    while(search_el != NULL) {
-        printf(" %i", (int)search_el->timestamp);
-        search_el = search_el->next;
-    }
-
-    printf(")\n");
+    printf("purge timeout : %u ms (%u ms per slot)\n", ts->purge_timeout, ts->tick);
+    printf("last purge    : %llu\n", (unsigned long long) ts->last_purge);
 }
-
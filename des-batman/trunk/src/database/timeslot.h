@@ -25,44 +25,63 @@ For further information and questions please use the web site
 #define TIMESLOT
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <uthash.h>
 
-typedef void pudge_object_t(time_t timestamp, void* object);
+/** number of slots in the timer wheel */
+#define TIMESLOT_WHEEL_SIZE     256
+
+/** timestamp is the time in millisec the object was last added */
+typedef void pudge_object_t(uint64_t timestamp, void* object);
 
 typedef struct timeslot_element {
     struct timeslot_element*	prev;
     struct timeslot_element*	next;
-    time_t			 			timestamp;
+    uint64_t		 			timestamp;
+    /** wheel slot the element is kept in */
+    uint16_t					slot;
     void*						object; // key
     UT_hash_handle 				hh;
 } timeslot_element_t;
 
+/**
+ * Objects with millisec timestamps that are pudged purge_timeout millisec
+ * after they were last added. Elements are kept in a timer wheel slot by
+ * the tick of their expiry time. One turn of the wheel is longer than the
+ * purge timeout, so a slot only holds the elements of one tick. A purge
+ * only looks at the slots of the ticks passed since the previous one, each
+ * slot once, so objects are pudged up to one tick late.
+ */
 typedef struct timeslot {
-    struct timeslot_element*	head;
-    struct timeslot_element*	tail;
+    struct timeslot_element*	wheel[TIMESLOT_WHEEL_SIZE];
     uint32_t					size;
-    time_t						purge_timeout;
+    /** millisec */
+    uint32_t					purge_timeout;
+    /** millisec per wheel slot */
+    uint32_t					tick;
+    /** time of last purge, all ticks before its tick are purged */
+    uint64_t					last_purge;
     pudge_object_t*				object_pudger;
     struct timeslot_element*	elements_hash;
 } timeslot_t;
 
 /** Create time-slot */
-int timeslot_create(timeslot_t** ts, time_t pudge_timeout, pudge_object_t* object_pudger);
+int timeslot_create(timeslot_t** ts, uint32_t pudge_timeout, pudge_object_t* object_pudger);
 
 /** Remove all time-slot elements and destroy time-slot */
 int timeslot_destroy(timeslot_t* ts);
 
 /** Change pudge timeout */
-int timeslot_change_pt(timeslot_t* ts, time_t pudge_timeout);
+int timeslot_change_pt(timeslot_t* ts, uint32_t pudge_timeout);
 
-/** Add object with timestamp number time-slot.
- * Pudges all objects older than timestamp - pudge_timeout from time-slot */
-int timeslot_addobject(timeslot_t* ts, time_t timestamp, void* object);
+/** Add object with timestamp to time-slot or refresh timestamp of the object.
+ * HINT: does not purge, call timeslot_purgeobjects */
+int timeslot_addobject(timeslot_t* ts, uint64_t timestamp, void* object);
 
 /** delete an object from timeslot */
 int timeslot_deleteobject(timeslot_t* ts, void* object);
 
 /**Pudges all objects older than timestamp - pudge_timeout from time-slot*/
-int timeslot_purgeobjects(timeslot_t* sw, time_t timestamp);
+int timeslot_purgeobjects(timeslot_t* sw, uint64_t timestamp);
 
 #endif
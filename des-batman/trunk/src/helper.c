@@ -21,6 +21,8 @@ For further information and questions please use the web site
        http://www.des-testbed.net
 *******************************************************************************/
 
+#include <time.h>
+#include <string.h>
 #include "helper.h"
 #include "config.h"
 
@@ -37,3 +39,83 @@ int hf_seq_comp_i_j(uint16_t i, uint16_t j) {
 
     return -1;
 }
+
+uint64_t hf_time_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// ------------------------------ precursor filter ------------------------------
+
+/**
+ * Bit positions of address, taken one after another from a 64 bit FNV-1a
+ * hash with the final mixing of MurmurHash3. Double hashing would allow
+ * only PREC_FILTER_BITS^2 / 2 different sets of positions, which raised the
+ * false positives. All nodes MUST use the same function.
+ */
+static void _prec_positions(const uint8_t addr[ETH_ALEN], uint16_t pos[PREC_FILTER_HASHES]) {
+    uint64_t h = 14695981039346656037ull;
+    int i;
+
+    for(i = 0; i < ETH_ALEN; i++) {
+        h = (h ^ addr[i]) * 1099511628211ull;
+    }
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+
+    for(i = 0; i < PREC_FILTER_HASHES; i++) {
+        pos[i] = h % PREC_FILTER_BITS;
+        h /= PREC_FILTER_BITS;
+    }
+}
+
+static int _prec_test(const uint8_t bits[PREC_FILTER_BITS / 8], const uint16_t pos[PREC_FILTER_HASHES]) {
+    int i;
+
+    for(i = 0; i < PREC_FILTER_HASHES; i++) {
+        if(!(bits[pos[i] / 8] & (1 << (pos[i] % 8)))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void hf_prec_init(hf_prec_filter_t* filter) {
+    memset(filter, 0, sizeof(hf_prec_filter_t));
+}
+
+void hf_prec_add(hf_prec_filter_t* filter, const uint8_t addr[ETH_ALEN]) {
+    uint16_t pos[PREC_FILTER_HASHES];
+    int i;
+
+    _prec_positions(addr, pos);
+
+    if(_prec_test(filter->curr, pos)) {
+        return; // already contained, adding would not change any bit
+    }
+
+    if(filter->count >= OGM_PREC_LIST_SIZE / 2) {
+        // current generation is full -> forget the previous one
+        memcpy(filter->prev, filter->curr, sizeof(filter->curr));
+        memset(filter->curr, 0, sizeof(filter->curr));
+        filter->count = 0;
+    }
+
+    for(i = 0; i < PREC_FILTER_HASHES; i++) {
+        filter->curr[pos[i] / 8] |= 1 << (pos[i] % 8);
+    }
+
+    filter->count++;
+}
+
+int hf_prec_contains(const hf_prec_filter_t* filter, const uint8_t addr[ETH_ALEN]) {
+    uint16_t pos[PREC_FILTER_HASHES];
+    _prec_positions(addr, pos);
+    return _prec_test(filter->curr, pos) || _prec_test(filter->prev, pos);
+}
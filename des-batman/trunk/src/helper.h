@@ -26,7 +26,34 @@ For further information and questions please use the web site
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <linux/if_ether.h>
+#include "config.h"
+
+/**
+ * Compact precursor list: a Bloom filter over MAC addresses that remembers
+ * about the last OGM_PREC_LIST_SIZE added addresses. It consists of two
+ * generations of OGM_PREC_LIST_SIZE / 2 addresses, if the current one is
+ * full it replaces the previous one. Sent inside OGM and data packets.
+ */
+typedef struct hf_prec_filter {
+    uint8_t     prev[PREC_FILTER_BITS / 8];
+    uint8_t     curr[PREC_FILTER_BITS / 8];
+    /** addresses in current generation */
+    uint8_t     count;
+} __attribute__((__packed__)) hf_prec_filter_t;
 
 int hf_seq_comp_i_j(uint16_t i, uint16_t j);
 
+/** monotonic time in millisec, used for all timestamps of the database */
+uint64_t hf_time_ms();
+
+/** Initialize empty precursor filter */
+void hf_prec_init(hf_prec_filter_t* filter);
+
+/** Add address to precursor filter */
+void hf_prec_add(hf_prec_filter_t* filter, const uint8_t addr[ETH_ALEN]);
+
+/** Check whether address is contained in precursor filter (false positives possible) */
+int hf_prec_contains(const hf_prec_filter_t* filter, const uint8_t addr[ETH_ALEN]);
+
 #endif
@@ -0,0 +1,246 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "batman_pipeline.h"
+
+#define REPORT_AGGR_STR_LEN 100
+
+/** OGMs waiting to be sent over one mesh interface */
+typedef struct batman_aggr_iface {
+    dessert_meshif_t*           iface;
+    pthread_mutex_t             lock;
+    struct batman_msg_ogm       pending[OGM_AGGR_LIMIT];
+    uint8_t                     pending_count;
+    /** a flush is scheduled */
+    uint8_t                     timer_pending;
+    // statistics
+    uint32_t                    frames;
+    uint32_t                    ogms;
+    uint32_t                    full_flushes;
+    uint8_t                     max_aggregated;
+    struct batman_aggr_iface*   next;
+} batman_aggr_iface_t;
+
+batman_aggr_iface_t* aggr_ifaces = NULL;
+pthread_mutex_t aggr_ifaces_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static batman_aggr_iface_t* _get_aggr_iface(dessert_meshif_t* iface) {
+    batman_aggr_iface_t* aggr;
+
+    pthread_mutex_lock(&aggr_ifaces_lock);
+
+    for(aggr = aggr_ifaces; aggr != NULL; aggr = aggr->next) {
+        if(aggr->iface == iface) {
+            break;
+        }
+    }
+
+    if(aggr == NULL) {
+        aggr = malloc(sizeof(batman_aggr_iface_t));
+
+        if(aggr != NULL) {
+            memset(aggr, 0, sizeof(batman_aggr_iface_t));
+            aggr->iface = iface;
+            pthread_mutex_init(&aggr->lock, NULL);
+            aggr->next = aggr_ifaces;
+            aggr_ifaces = aggr;
+        }
+    }
+
+    pthread_mutex_unlock(&aggr_ifaces_lock);
+    return aggr;
+}
+
+/** number of OGMs fitting into one frame besides the l25 header and the dummy payload */
+static int _frame_capacity() {
+    int room = dessert_maxlen - sizeof(dessert_msg_t) - (DESSERT_EXTLEN + ETHER_HDR_LEN) - ogm_size;
+    int capacity = room / (int)(DESSERT_EXTLEN + sizeof(struct batman_msg_ogm));
+    return (capacity > 1) ? capacity : 1;
+}
+
+/**
+ * Send OGMs in one frame, as many as fit. The frame gets the highest TTL
+ * of its OGMs, the OGMs keep their own. Returns the number of OGMs sent.
+ */
+static int _send_frame(dessert_meshif_t* iface, struct batman_msg_ogm* ogms, int count) {
+    dessert_msg_t* msg;
+    dessert_ext_t* ext;
+    int capacity = _frame_capacity();
+    int i;
+
+    dessert_msg_new(&msg);
+    msg->ttl = 0;
+
+    if(dessert_msg_addext(msg, &ext, DESSERT_EXT_ETH, ETHER_HDR_LEN) != DESSERT_OK) {
+        dessert_msg_destroy(msg);
+        return 0;
+    }
+
+    struct ether_header* l25h = (struct ether_header*) ext->data;
+    memcpy(l25h->ether_shost, dessert_l25_defsrc, ETHER_ADDR_LEN);
+    memcpy(l25h->ether_dhost, ether_broadcast, ETHER_ADDR_LEN);
+
+    for(i = 0; i < count && i < capacity; i++) {
+        if(dessert_msg_addext(msg, &ext, OGM_EXT_TYPE, sizeof(struct batman_msg_ogm)) != DESSERT_OK) {
+            break;
+        }
+
+        memcpy(ext->data, &ogms[i], sizeof(struct batman_msg_ogm));
+
+        if(ogms[i].ttl > msg->ttl) {
+            msg->ttl = ogms[i].ttl;
+        }
+    }
+
+    if(i > 0) {
+        // the dummy payload is sent once per frame, not once per OGM
+        if(dessert_msg_dummy_payload(msg, ogm_size) != DESSERT_OK) {
+            dessert_debug("OGM frame on %s sent without dummy payload", iface->if_name);
+        }
+
+        dessert_meshsend_fast(msg, iface);
+    }
+
+    dessert_msg_destroy(msg);
+    return i;
+}
+
+/** send all pending OGMs of interface in as few frames as possible. aggr->lock must be held */
+static void _send_pending(batman_aggr_iface_t* aggr) {
+    int sent = 0;
+
+    while(sent < aggr->pending_count) {
+        int count = _send_frame(aggr->iface, aggr->pending + sent, aggr->pending_count - sent);
+
+        if(count == 0) {
+            dessert_crit("could not build OGM frame on %s, %d OGMs dropped", aggr->iface->if_name, aggr->pending_count - sent);
+            break;
+        }
+
+        if(count > aggr->max_aggregated) {
+            aggr->max_aggregated = count;
+        }
+
+        aggr->frames++;
+        aggr->ogms += count;
+        sent += count;
+    }
+
+    aggr->pending_count = 0;
+}
+
+void batman_aggr_queue_ogm(const struct batman_msg_ogm* ogm) {
+    dessert_meshif_t* iface = dessert_meshiflist_get();
+    int aggr_max = (ogm_aggr_max > OGM_AGGR_LIMIT) ? OGM_AGGR_LIMIT : ogm_aggr_max;
+
+    // flush before the frame would overflow
+    if(aggr_max > _frame_capacity()) {
+        aggr_max = _frame_capacity();
+    }
+
+    for(; iface != NULL; iface = iface->next) {
+        batman_aggr_iface_t* aggr = _get_aggr_iface(iface);
+
+        if(aggr == NULL) {
+            dessert_crit("could not allocate memory");
+            continue;
+        }
+
+        pthread_mutex_lock(&aggr->lock);
+        memcpy(&aggr->pending[aggr->pending_count++], ogm, sizeof(struct batman_msg_ogm));
+
+        if(aggr->pending_count >= aggr_max) {
+            // frame is full -> send now, a scheduled flush finds the queue empty or newer OGMs
+            _send_pending(aggr);
+
+            if(aggr_max > 1) {
+                aggr->full_flushes++;
+            }
+        }
+        else if(aggr->timer_pending == false) {
+            struct timeval flush_time;
+            uint32_t delay_ms = ogm_aggr_window + (ogm_aggr_jitter ? random() % (ogm_aggr_jitter + 1) : 0);
+            gettimeofday(&flush_time, NULL);
+            dessert_timevaladd(&flush_time, delay_ms / 1000, (delay_ms % 1000) * 1000);
+            aggr->timer_pending = true;
+            dessert_periodic_add(batman_aggr_flush, aggr, &flush_time, NULL);
+        }
+
+        pthread_mutex_unlock(&aggr->lock);
+    }
+}
+
+dessert_per_result_t batman_aggr_flush(void* data, struct timeval* scheduled, struct timeval* interval) {
+    batman_aggr_iface_t* aggr = data;
+    pthread_mutex_lock(&aggr->lock);
+    aggr->timer_pending = false;
+    _send_pending(aggr);
+    pthread_mutex_unlock(&aggr->lock);
+    return DESSERT_PER_UNREGISTER;
+}
+
+// ------------------- reporting -----------------------------------------------
+
+int batman_aggr_report(char** str_out) {
+    batman_aggr_iface_t* aggr;
+    char entry_str[REPORT_AGGR_STR_LEN + 1];
+    int count = 0;
+
+    pthread_mutex_lock(&aggr_ifaces_lock);
+
+    for(aggr = aggr_ifaces; aggr != NULL; aggr = aggr->next) {
+        count++;
+    }
+
+    char* output = malloc(REPORT_AGGR_STR_LEN * (count + 4) + 1);
+
+    if(output == NULL) {
+        pthread_mutex_unlock(&aggr_ifaces_lock);
+        return false;
+    }
+
+    *output = '\0';
+    strcat(output, "+-----------------+------------+------------+---------+--------------+-----+\n");
+    strcat(output, "|    interface    |   frames   |    OGMs    | avg/frm | full flushes | max |\n");
+    strcat(output, "+-----------------+------------+------------+---------+--------------+-----+\n");
+
+    for(aggr = aggr_ifaces; aggr != NULL; aggr = aggr->next) {
+        pthread_mutex_lock(&aggr->lock);
+        snprintf(entry_str, REPORT_AGGR_STR_LEN + 1, "| %15s | %10u | %10u | %7.2f | %12u | %3u |\n",
+                 aggr->iface->if_name, aggr->frames, aggr->ogms,
+                 aggr->frames ? (double) aggr->ogms / aggr->frames : 0.0,
+                 aggr->full_flushes, aggr->max_aggregated);
+        pthread_mutex_unlock(&aggr->lock);
+        strcat(output, entry_str);
+    }
+
+    strcat(output, "+-----------------+------------+------------+---------+--------------+-----+\n");
+    pthread_mutex_unlock(&aggr_ifaces_lock);
+    *str_out = output;
+    return true;
+}
@@ -26,53 +26,42 @@ For further information and questions please use the web site
 #include "batman_pipeline.h"
 
 dessert_periodic_t* ogm_periodic = NULL;
+dessert_periodic_t* cleanup_periodic = NULL;
 
 uint16_t sequence_num = 0;
 uint8_t reset_flag_counter = OGM_RESET_COUNT;
 
 dessert_per_result_t batman_periodic_send_ogm(void* data, struct timeval* scheduled, struct timeval* interval) {
-    dessert_msg_t* ogm_msg;
-    dessert_ext_t* ext;
+    struct batman_msg_ogm ogm;
 
     // increment sequence number
     sequence_num ++;
 
-    // create new ogm message with ogm_ext and l25 header for TTL.
-    dessert_msg_new(&ogm_msg);
-    ogm_msg->ttl = TTL_MAX;
-
-    dessert_msg_addext(ogm_msg, &ext, DESSERT_EXT_ETH, ETHER_HDR_LEN);
-    struct ether_header* l25h = (struct ether_header*) ext->data;
-    // set src address
-    memcpy(l25h->ether_shost, dessert_l25_defsrc, ETHER_ADDR_LEN);
-    // set destination broadcast address
-    memcpy(l25h->ether_dhost, ether_broadcast, ETHER_ADDR_LEN);
-
-    dessert_msg_addext(ogm_msg, &ext, OGM_EXT_TYPE, sizeof(struct batman_msg_ogm));
-    struct batman_msg_ogm* ogm_ext = (struct batman_msg_ogm*) ext->data;
-    ogm_ext->version = VERSION;
-    ogm_ext->flags = BATMAN_OGM_UFLAG; // set unidirectional flag
+    memset(&ogm, 0, sizeof(struct batman_msg_ogm));
+    ogm.version = VERSION;
+    ogm.flags = BATMAN_OGM_UFLAG; // set unidirectional flag
 
     if(reset_flag_counter > 0) {
         reset_flag_counter--;
-        ogm_ext->flags = ogm_ext->flags | BATMAN_OGM_RFLAG;
+        ogm.flags = ogm.flags | BATMAN_OGM_RFLAG;
     }
 
-    ogm_ext->gw_flags = 0x00;
-    ogm_ext->sequence_num = sequence_num;
-    ogm_ext->gw_port = 0x00;
-    ogm_ext->precursors_count = 0;
-
-    dessert_msg_dummy_payload(ogm_msg, ogm_size);
+    ogm.gw_flags = 0x00;
+    ogm.ttl = TTL_MAX;
+    ogm.sequence_num = sequence_num;
+    ogm.gw_port = 0x00;
+    memcpy(ogm.originator, dessert_l25_defsrc, ETH_ALEN);
+    hf_prec_init(&ogm.precursors);
 
-    dessert_meshsend_fast(ogm_msg, NULL);
-    dessert_msg_destroy(ogm_msg);
+    // sent together with the OGMs rebroadcasted in the same aggregation window
+    batman_aggr_queue_ogm(&ogm);
     return DESSERT_PER_KEEP;
 }
 
 dessert_per_result_t batman_periodic_log_rt(void* data, struct timeval* scheduled, struct timeval* interval) {
     char* rt_str;
-    batman_db_rlock();
+    // write lock, as entrys may change under read lock
+    batman_db_wlock();
     batman_db_view_routingtable(&rt_str);
     batman_db_unlock();
     dessert_info("\n%s", rt_str);
@@ -89,14 +78,29 @@ dessert_per_result_t batman_periodic_cleanup_database(void* data, struct timeval
     return DESSERT_PER_KEEP;
 }
 
-int batman_periodic_register_send_ogm(time_t ogm_int) {
+int batman_periodic_register_cleanup(uint32_t purge_timeout) {
+    struct timeval db_cleanup_interval;
+    db_cleanup_interval.tv_sec = purge_timeout / 1000;
+    db_cleanup_interval.tv_usec = (purge_timeout % 1000) * 1000;
+
+    if(cleanup_periodic != NULL) {
+        dessert_periodic_del(cleanup_periodic);
+    }
+
+    cleanup_periodic = dessert_periodic_add(batman_periodic_cleanup_database, NULL, NULL, &db_cleanup_interval);
+    return true;
+}
+
+int batman_periodic_register_send_ogm(uint32_t ogm_int) {
     // change pudge timeout
+    uint32_t purge_timeout = PURGE_TIMEOUT_KOEFF * ogm_int * window_size;
     batman_db_wlock();
-    batman_db_change_pt(PURGE_TIMEOUT_KOEFF * ogm_int * window_size);
+    batman_db_change_pt(purge_timeout);
     batman_db_unlock();
+    batman_periodic_register_cleanup(purge_timeout);
     // update callback
     struct timeval send_ogm_interval;
-    dessert_debug("set OGM interval to %i sek", ogm_int);
+    dessert_debug("set OGM interval to %u millisec", ogm_int);
     send_ogm_interval.tv_sec = ogm_int / 1000;
     send_ogm_interval.tv_usec = (ogm_int % 1000) * 1000;
 
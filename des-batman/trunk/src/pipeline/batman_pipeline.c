@@ -37,36 +37,31 @@ For further information and questions please use the web site
  * (in that case silently DROP without processing)
  */
 int _check_precursors(struct batman_msg_ogm* ogm_ext) {
-    int i;
-
-    for(i = ogm_ext->precursors_count - 1; i >= 0; i--) {
-        // start to search from !END! It is very presumably that i am the last entry in the list
-        uint8_t* el_start_address = ogm_ext->precursor_list + ETH_ALEN * i;
-
-        if(memcmp(el_start_address, dessert_l25_defsrc, ETH_ALEN) == 0) {
-            return true;
-        }
-    }
-
-    return false;
+    return hf_prec_contains(&ogm_ext->precursors, dessert_l25_defsrc);
 }
 
 void _add_myself_to_precursors(struct batman_msg_ogm* ogm_ext) {
-    if(ogm_ext->precursors_count < OGM_PREC_LIST_SIZE) {
-        // increment size and write my default address to end of list
-        uint8_t* el_start_address = ogm_ext->precursor_list + ETH_ALEN * ogm_ext->precursors_count;
-        memcpy(el_start_address, dessert_l25_defsrc, ETH_ALEN);
-        ogm_ext->precursors_count++;
+    hf_prec_add(&ogm_ext->precursors, dessert_l25_defsrc);
+}
+
+/**
+ * Check that the extension holds a whole OGM of my version, older versions
+ * carry no originator and TTL per OGM.
+ */
+static int _ogm_valid(dessert_ext_t* ogm_ext) {
+    struct batman_msg_ogm* ogm = (struct batman_msg_ogm*) ogm_ext->data;
+
+    if(dessert_ext_getdatalen(ogm_ext) != sizeof(struct batman_msg_ogm)) {
+        dessert_debug("--- OGM extension of %d bytes skipped, expected %zu", dessert_ext_getdatalen(ogm_ext), sizeof(struct batman_msg_ogm));
+        return false;
     }
-    else {   // precursor list is full
-        // delete first element and move all elements to begin of the list.
-        // add my default address to end of list.
-        if(OGM_PREC_LIST_SIZE > 1) {
-            memmove(ogm_ext->precursor_list, ogm_ext->precursor_list + ETH_ALEN, ETH_ALEN *(OGM_PREC_LIST_SIZE - 1));
-        }
 
-        memcpy(ogm_ext->precursor_list + (OGM_PREC_LIST_SIZE - 1)*ETH_ALEN, dessert_l25_defsrc, ETH_ALEN);
+    if(ogm->version != VERSION) {
+        dessert_debug("--- OGM%u of version %u skipped, expected %u", ogm->sequence_num, ogm->version, VERSION);
+        return false;
     }
+
+    return true;
 }
 
 pthread_rwlock_t rlseqlock = PTHREAD_RWLOCK_INITIALIZER;
@@ -82,7 +77,7 @@ dessert_cb_result batman_drop_errors(dessert_msg_t* msg, size_t len, dessert_msg
     if(proc->lflags & DESSERT_RX_FLAG_L25_SRC) {
         dessert_ext_t* ogm_ext;
 
-        if(dessert_msg_getext(msg, &ogm_ext, OGM_EXT_TYPE, 0) != 0) {
+        if(dessert_msg_getext(msg, &ogm_ext, OGM_EXT_TYPE, 0) != 0 && _ogm_valid(ogm_ext) == true) {
             struct batman_msg_ogm* ogm = (struct batman_msg_ogm*) ogm_ext->data;
 
             if(ogm->flags & BATMAN_OGM_DFLAG
@@ -101,117 +96,102 @@ dessert_cb_result batman_drop_errors(dessert_msg_t* msg, size_t len, dessert_msg
     return DESSERT_MSG_KEEP;
 }
 
-dessert_cb_result batman_handle_ogm(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, dessert_meshif_t* iface, dessert_frameid_t id) {
-    dessert_ext_t* ogm_ext;
+/**
+ * Send OGM back to its originator with directed flag set, so the originator
+ * can capture the link to me as bidirectional.
+ */
+static void _echo_ogm(const struct batman_msg_ogm* ogm, dessert_msg_t* msg, dessert_meshif_t* iface) {
+    dessert_msg_t* echo_msg;
+    dessert_ext_t* ext;
+
+    dessert_msg_new(&echo_msg);
+    echo_msg->ttl = TTL_MAX;
+
+    dessert_msg_addext(echo_msg, &ext, DESSERT_EXT_ETH, ETHER_HDR_LEN);
+    struct ether_header* l25h = (struct ether_header*) ext->data;
+    memcpy(l25h->ether_shost, ogm->originator, ETHER_ADDR_LEN);
+    memcpy(l25h->ether_dhost, ether_broadcast, ETHER_ADDR_LEN);
+
+    dessert_msg_addext(echo_msg, &ext, OGM_EXT_TYPE, sizeof(struct batman_msg_ogm));
+    struct batman_msg_ogm* echo = (struct batman_msg_ogm*) ext->data;
+    memcpy(echo, ogm, sizeof(struct batman_msg_ogm));
+    echo->flags = (echo->flags & ~BATMAN_OGM_UFLAG) | BATMAN_OGM_DFLAG;
+
+    memcpy(echo_msg->l2h.ether_dhost, msg->l2h.ether_shost, ETH_ALEN);
+    dessert_meshsend(echo_msg, iface);
+    dessert_msg_destroy(echo_msg);
+}
 
-    if(dessert_msg_getext(msg, &ogm_ext, OGM_EXT_TYPE, 0) != 0) {
-        struct batman_msg_ogm* ogm = (struct batman_msg_ogm*) ogm_ext->data;
-        struct ether_header* l25h = dessert_msg_getl25ether(msg);
+static void _handle_one_ogm(struct batman_msg_ogm* ogm, dessert_msg_t* msg, dessert_meshif_t* iface) {
+    dessert_debug("--- OGM%u from " MAC , ogm->sequence_num, EXPLODE_ARRAY6(ogm->originator));
 
-        dessert_debug("--- OGM%u from " MAC , ogm->sequence_num, EXPLODE_ARRAY6(l25h->ether_shost));
+    // my own OGM, rebroadcasted by a neighbor in its aggregated frame
+    if(memcmp(ogm->originator, dessert_l25_defsrc, ETH_ALEN) == 0) {
+        return;
+    }
 
-        // if unidirectional flag is set ->
-        // switch to directed flag and send this OGM back to originator
-        if(ogm->flags & BATMAN_OGM_UFLAG) {
-            ogm->flags = (ogm->flags & ~BATMAN_OGM_UFLAG) | BATMAN_OGM_DFLAG;
-            memcpy(msg->l2h.ether_dhost, msg->l2h.ether_shost, ETH_ALEN);
-            dessert_meshsend(msg, iface);
-            // reset dhost to broadcast
-            memset(msg->l2h.ether_dhost, 255, ETH_ALEN);
-        }
+    // if unidirectional flag is set ->
+    // switch to directed flag and send this OGM back to originator
+    if(ogm->flags & BATMAN_OGM_UFLAG) {
+        _echo_ogm(ogm, msg, iface);
+    }
 
-        // delete Dflag in all ways
-        ogm->flags = ogm->flags & ~BATMAN_OGM_DFLAG;
+    // delete Uflag and Dflag in all ways, a rebroadcast is never echoed
+    ogm->flags = ogm->flags & ~(BATMAN_OGM_UFLAG | BATMAN_OGM_DFLAG);
 
-        // if not from bidirectional neighbor -> silently drop!
-        batman_db_wlock();
-        int bd = batman_db_check2Dneigh(msg->l2h.ether_shost, iface);
-        batman_db_unlock();
+    // check bidirectional connection, capture route and decide about re-broadcast in one step
+    int in_precursors = (ogm_precursor_mode == true) && (_check_precursors(ogm) == true);
+    int result = batman_db_processogm(ogm->originator, iface, msg->l2h.ether_shost, ogm->sequence_num,
+                                      ogm->flags & BATMAN_OGM_RFLAG, in_precursors, hf_time_ms());
 
-        if(bd != true) {
-            dessert_debug("--- OGM%u drop as not over bidirectional connection (" MAC ")", ogm->sequence_num, EXPLODE_ARRAY6(msg->l2h.ether_shost));
-            return DESSERT_MSG_DROP;
-        }
+    if(result & BATMAN_DB_OGM_UNIDIRECTIONAL) {
+        dessert_debug("--- OGM%u drop as not over bidirectional connection (" MAC ")", ogm->sequence_num, EXPLODE_ARRAY6(msg->l2h.ether_shost));
+        return;
+    }
 
-        batman_db_wlock();
-        int last_seq_num = batman_db_getroutesn(l25h->ether_shost);
+    if(ogm_precursor_mode == true && (result & BATMAN_DB_OGM_CAPTURED)) {
+        _add_myself_to_precursors(ogm);
+    }
 
-        // if reset flag is set -> delete old destination
-        if(ogm->flags & BATMAN_OGM_RFLAG) {
-            if(last_seq_num >= 0 && (last_seq_num - ogm->sequence_num >= OGM_RESET_COUNT)) {
-                dessert_debug("--- " MAC " - was restarted", EXPLODE_ARRAY6(l25h->ether_shost));
-                batman_db_deleteroute(l25h->ether_shost);
-            }
+    if(result & BATMAN_DB_OGM_REBROADCAST) {
+        if(ogm->ttl <= 1) {
+            dessert_debug("--- OGM%u not re-broadcasted as TTL expired", ogm->sequence_num);
+            return;
         }
 
-        batman_db_unlock();
+        ogm->ttl--;
 
-        if(ogm_precursor_mode == false) {  // precursor list not used.
-            // capture and re-send OGM only if incoming OGM is newer
-            // HINT: Process only OGM with greater seq_num to avoid routing loops.
-            if((last_seq_num == -1) || hf_seq_comp_i_j(last_seq_num, ogm->sequence_num) < 0) {
-                // add or change route to destination (l25h->ether_shost)
-                batman_db_wlock();
-                batman_db_captureroute(l25h->ether_shost, iface, time(0), msg->l2h.ether_shost, ogm->sequence_num);
-                batman_db_unlock();
-            }
-        }
-        else {
-            // capture all OGM not processed by me.
-            // We assume that the OGM with known sequence number but
-            // not containing my default address in precursor list were not processed.
-            // Re-send OGMs only with newer seq_num to avoid routing loops
-            if((_check_precursors(ogm) == false)
-                && ((hf_seq_comp_i_j(ogm->sequence_num, last_seq_num) >= 0) || (last_seq_num == -1))) {
-                // also: don't process old OGM
-                // add or change route to destination (l25h->ether_shost)
-                batman_db_wlock();
-                batman_db_captureroute(l25h->ether_shost, iface, time(0), msg->l2h.ether_shost, ogm->sequence_num);
-                batman_db_unlock();
-                _add_myself_to_precursors(ogm);
-            }
+        if(ogm_precursor_mode == true) {
+            _add_myself_to_precursors(ogm);
         }
 
-        // check re-broadcast conditions
-        int allow_rebroadcast = false;
-
-        if(resend_ogm_always == true) {
-            allow_rebroadcast = true;
-        }
-        else {
-            // if OGM received over best next hop toward OGM originator -> re-broadcast
-            uint8_t ether_best_prev_hop[ETH_ALEN];
-            dessert_meshif_t* local_iface_towards_originator;
-            batman_db_rlock();
-            int result = batman_db_getbestroute(l25h->ether_shost, &local_iface_towards_originator, ether_best_prev_hop);
-            batman_db_unlock();
+        batman_aggr_queue_ogm(ogm);
+    }
+}
 
-            if((result == true)
-                && (memcmp(ether_best_prev_hop, msg->l2h.ether_shost, ETH_ALEN) == 0)
-                && (local_iface_towards_originator == iface)) {
-                allow_rebroadcast = true;
-            }
-        }
+dessert_cb_result batman_handle_ogm(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, dessert_meshif_t* iface, dessert_frameid_t id) {
+    dessert_ext_t* ogm_ext;
+    int ogm_count = dessert_msg_getext(msg, &ogm_ext, OGM_EXT_TYPE, 0);
+    int i;
 
-        if(allow_rebroadcast == true) {
-            batman_db_wlock();
-            int not_rebroadcastet = batman_db_addogmseq(l25h->ether_shost, ogm->sequence_num);
-            batman_db_unlock();
+    if(ogm_count == 0) {
+        return DESSERT_MSG_KEEP;
+    }
 
-            if(not_rebroadcastet == true) {
-                if(ogm_precursor_mode == true) {
-                    _add_myself_to_precursors(ogm);
-                }
+    // frames may carry several aggregated OGMs of different originators
+    for(i = 0; i < ogm_count; i++) {
+        if(i > 0) {
+            dessert_msg_getext(msg, &ogm_ext, OGM_EXT_TYPE, i);
+        }
 
-                dessert_meshsend_fast_randomized(msg);
-            }
+        if(_ogm_valid(ogm_ext) != true) {
+            continue;
         }
 
-        return DESSERT_MSG_DROP;
-    }
-    else {
-        return DESSERT_MSG_KEEP;
+        _handle_one_ogm((struct batman_msg_ogm*) ogm_ext->data, msg, iface);
     }
+
+    return DESSERT_MSG_DROP;
 }
 
 dessert_cb_result batman_fwd2dest(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, dessert_meshif_t* iface, dessert_frameid_t id) {
@@ -224,7 +204,7 @@ dessert_cb_result batman_fwd2dest(dessert_msg_t* msg, size_t len, dessert_msg_pr
         struct rl_seq* rl_data = (struct rl_seq*) rl_ext->data;
         rl_seq_num = rl_data->seq_num;
         pthread_rwlock_wrlock(&rlseqlock);
-        int pk = rl_check_seq(l25h->ether_shost, l25h->ether_dhost, rl_seq_num, time(0));
+        int pk = rl_check_seq(l25h->ether_shost, l25h->ether_dhost, rl_seq_num, hf_time_ms());
         pthread_rwlock_unlock(&rlseqlock);
 
         if(pk == true) {
@@ -234,7 +214,7 @@ dessert_cb_result batman_fwd2dest(dessert_msg_t* msg, size_t len, dessert_msg_pr
         }
 
         pthread_rwlock_wrlock(&rlseqlock);
-        rl_add_seq(l25h->ether_shost, l25h->ether_dhost, rl_seq_num, time(0));
+        rl_add_seq(l25h->ether_shost, l25h->ether_dhost, rl_seq_num, hf_time_ms());
         pthread_rwlock_unlock(&rlseqlock);
 
         if(rl_data->hop_count != 255) {
@@ -282,7 +262,7 @@ dessert_cb_result batman_fwd2dest(dessert_msg_t* msg, size_t len, dessert_msg_pr
         }
         else {
             struct rl_seq* rl_data = (struct rl_seq*) rl_ext->data;
-            result = batman_db_getbestroute_arl(l25h->ether_dhost, &output_iface, ether_best_next_hop, rl_data->precursor_if_list, &rl_data->prec_iface_count);
+            result = batman_db_getbestroute_arl(l25h->ether_dhost, &output_iface, ether_best_next_hop, &rl_data->precursors);
         }
 
         batman_db_unlock();
@@ -325,7 +305,7 @@ dessert_cb_result batman_sys2rp(dessert_msg_t* msg, size_t len, dessert_msg_proc
         dessert_msg_addext(msg, &rl_ext, RL_EXT_TYPE, sizeof(struct rl_seq));
         struct rl_seq* rl_data = (struct rl_seq*) rl_ext->data;
         rl_data->hop_count = 0;
-        rl_data->prec_iface_count = 0;
+        hf_prec_init(&rl_data->precursors);
 
         batman_db_rlock();
         int result = false;
@@ -334,7 +314,7 @@ dessert_cb_result batman_sys2rp(dessert_msg_t* msg, size_t len, dessert_msg_proc
             result = batman_db_getbestroute(l25h->ether_dhost, &output_iface, ether_best_next_hop);
         }
         else {
-            result = batman_db_getbestroute_arl(l25h->ether_dhost, &output_iface, ether_best_next_hop, rl_data->precursor_if_list, &rl_data->prec_iface_count);
+            result = batman_db_getbestroute_arl(l25h->ether_dhost, &output_iface, ether_best_next_hop, &rl_data->precursors);
         }
 
         batman_db_unlock();
@@ -342,7 +322,7 @@ dessert_cb_result batman_sys2rp(dessert_msg_t* msg, size_t len, dessert_msg_proc
         if(result == true) {
             uint32_t seq_num = 0;
             pthread_rwlock_wrlock(&rlseqlock);
-            seq_num = rl_get_nextseq(dessert_l25_defsrc, l25h->ether_dhost, time(0));
+            seq_num = rl_get_nextseq(dessert_l25_defsrc, l25h->ether_dhost, hf_time_ms());
             pthread_rwlock_unlock(&rlseqlock);
             rl_data->seq_num = seq_num;
 
@@ -372,7 +352,7 @@ dessert_cb_result rp2sys(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* pro
         if(dessert_msg_getext(msg, &rl_ext, RL_EXT_TYPE, 0) != 0) {
             struct rl_seq* rl_data = (struct rl_seq*) rl_ext->data;
             pthread_rwlock_wrlock(&rlseqlock);
-            rl_add_seq(dessert_l25_defsrc, l25h->ether_shost, rl_data->seq_num, time(0));
+            rl_add_seq(dessert_l25_defsrc, l25h->ether_shost, rl_data->seq_num, hf_time_ms());
             pthread_rwlock_unlock(&rlseqlock);
             rl_seq_num = rl_data->seq_num;
             rl_hop_count = rl_data->hop_count;
@@ -23,6 +23,7 @@ For further information and questions please use the web site
 
 #include <dessert.h>
 #include "../config.h"
+#include "../helper.h"
 
 #ifndef BATMAN_PIPELINE_H
 #define BATMAN_PIPELINE_H
@@ -42,23 +43,24 @@ struct batman_msg_ogm {
      *  				destination must be deleted.
      */
     uint8_t flags;
-    /** TTL (not used) + gateway flags : TTL(8 bit) | GWFlags(8 bit) */
+    /** gateway flags */
     uint8_t gw_flags;
+    /** hops this OGM may still be re-broadcasted over, kept per OGM as frames aggregate several */
+    uint8_t ttl;
     /** Sequence number */
     uint16_t sequence_num;
     /** Gateway port */
     uint16_t gw_port;
-    // Originator Address (not used)
-    // uint32_t orig_address;
+    /** Originator Address. Needed as several OGMs are aggregated in one frame */
+    uint8_t originator[ETH_ALEN];
     /**
-     * Precursor list. Used to save last OGM_PRECURSOR_LIST_SIZE
+     * Precursor filter. Used to save about the last OGM_PREC_LIST_SIZE
      * addresses of nodes that processed this OGM
      * to prevent multiple processing of same OGM.
      * HINT: The approach to process only first incoming OGM with
      * given sequence number have numerous issues.
      */
-    uint8_t precursor_list[OGM_PREC_LIST_SIZE* ETH_ALEN];
-    uint8_t precursors_count;
+    hf_prec_filter_t precursors;
 }  __attribute__((__packed__));
 
 /**
@@ -67,8 +69,8 @@ struct batman_msg_ogm {
 struct rl_seq {
     uint32_t 	seq_num;
     uint8_t	hop_count;
-    uint8_t	precursor_if_list[OGM_PREC_LIST_SIZE* ETH_ALEN];
-    uint8_t	prec_iface_count;
+    /** interfaces of nodes that forwarded this packet */
+    hf_prec_filter_t	precursors;
 } __attribute__((__packed__));
 
 struct batman_msg_brc {
@@ -107,11 +109,28 @@ dessert_per_result_t batman_periodic_log_rt(void* data, struct timeval* schedule
 /** clean up database from old entrys */
 dessert_per_result_t batman_periodic_cleanup_database(void* data, struct timeval* scheduled, struct timeval* interval);
 
+// ------------------------------ aggregation ----------------------------------------------
+
+/**
+ * Queue OGM for sending over all mesh interfaces. OGMs queued within
+ * ogm_aggr_window (plus jitter) are sent together in one frame per interface.
+ */
+void batman_aggr_queue_ogm(const struct batman_msg_ogm* ogm);
+
+/** send aggregated OGMs of one interface when its aggregation window is over */
+dessert_per_result_t batman_aggr_flush(void* data, struct timeval* scheduled, struct timeval* interval);
+
+/** get per interface aggregation statistics as string */
+int batman_aggr_report(char** str_out);
+
 /**
  *  Register send_ogm callback to periodic pipeline and set/change
  * 	ist interval betwen to OGMs to omg_int
  */
-int batman_periodic_register_send_ogm(time_t ogm_int);
+int batman_periodic_register_send_ogm(uint32_t ogm_int);
+
+/** Register cleanup callback to periodic pipeline, run every purge_timeout millisec */
+int batman_periodic_register_cleanup(uint32_t purge_timeout);
 
 
 #endif
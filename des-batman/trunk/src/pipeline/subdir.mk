@@ -4,14 +4,17 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../src/pipeline/batman_aggr.c \
 ../src/pipeline/batman_periodic.c \
 ../src/pipeline/batman_pipeline.c 
 
 OBJS += \
+./src/pipeline/batman_aggr.o \
 ./src/pipeline/batman_periodic.o \
 ./src/pipeline/batman_pipeline.o 
 
 C_DEPS += \
+./src/pipeline/batman_aggr.d \
 ./src/pipeline/batman_periodic.d \
 ./src/pipeline/batman_pipeline.d 
 
@@ -0,0 +1,173 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+
+/*
+ * Measure insert and check of the broadcast log.
+ *
+ * The log is filled with the broadcast ids of the given number of sources
+ * and then sees every source again, with the id it already logged (check,
+ * the broadcast is dropped) and with the next one (insert, the broadcast is
+ * re-broadcasted). Afterwards the timeout is lowered so that sources expire
+ * all the time: each millisec new sources are added at the rate that keeps
+ * the given number of them logged, while the log is purged as the OGM
+ * handler does on every broadcast. The calls of this case are spread over
+ * the millisecs, so they run with cold caches. Prints the time per call and
+ * the number of sources logged at the end, and checks that expired sources
+ * are gone after one more tick of the wheel.
+ *
+ * usage: brclog_bench [sources] [rounds] [timeout]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../src/config.h"
+#include "../src/helper.h"
+#include "../src/database/batman_database.h"
+#include "../src/database/timeslot.h"
+
+uint16_t ogm_interval       = OGM_INTERVAL_MS;
+uint16_t ogm_size           = OGM_SIZE;
+uint8_t window_size         = WINDOW_SIZE;
+uint32_t brc_log_timeout    = BROADCAST_LOG_TIMEOUT;
+uint16_t ogm_aggr_window    = OGM_AGGR_WINDOW_MS;
+uint16_t ogm_aggr_jitter    = OGM_AGGR_JITTER_MS;
+uint8_t ogm_aggr_max        = OGM_AGGR_MAX;
+bool ogm_precursor_mode     = USE_PRECURSOR_LIST;
+bool resend_ogm_always      = RESEND_OGM_ALWAYS;
+
+extern timeslot_t* brclog_ts;
+
+static void node_addr(uint8_t addr[ETH_ALEN], int net, int i) {
+    uint8_t a[ETH_ALEN] = {0x02, net, 0x00, (i >> 16) & 0xff, (i >> 8) & 0xff, i & 0xff};
+    memcpy(addr, a, ETH_ALEN);
+}
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    int sources = (argc > 1) ? atoi(argv[1]) : 10000;
+    int rounds = (argc > 2) ? atoi(argv[2]) : 100;
+    uint32_t timeout = (argc > 3) ? atoi(argv[3]) : 1000;
+    int* order = malloc(sources * sizeof(int));
+    long calls = 0;
+    int errors = 0;
+    int r, s;
+
+    srand(1);
+    batman_db_init();
+
+    for(s = 0; s < sources; s++) {
+        order[s] = s;
+    }
+
+    double start = now_sec();
+
+    for(s = 0; s < sources; s++) {
+        uint8_t source[ETH_ALEN];
+        node_addr(source, 0, s);
+        errors += (batman_db_addbrcid(source, 0) == true) ? 0 : 1;
+    }
+
+    printf("%d sources: new      %6.1f ns per call\n", sources, (now_sec() - start) * 1e9 / sources);
+
+    double check_time = 0;
+    double insert_time = 0;
+
+    for(r = 1; r <= rounds; r++) {
+        for(s = 0; s < sources; s++) {
+            int k = rand() % (s + 1);
+            int tmp = order[s];
+            order[s] = order[k];
+            order[k] = tmp;
+        }
+
+        start = now_sec();
+
+        for(s = 0; s < sources; s++) {
+            uint8_t source[ETH_ALEN];
+            node_addr(source, 0, order[s]);
+            errors += (batman_db_addbrcid(source, r - 1) == false) ? 0 : 1;
+        }
+
+        check_time += now_sec() - start;
+        start = now_sec();
+
+        for(s = 0; s < sources; s++) {
+            uint8_t source[ETH_ALEN];
+            node_addr(source, 0, order[s]);
+            errors += (batman_db_addbrcid(source, r) == true) ? 0 : 1;
+        }
+
+        insert_time += now_sec() - start;
+    }
+
+    printf("%d sources: check    %6.1f ns per call\n", sources, check_time * 1e9 / sources / rounds);
+    printf("%d sources: insert   %6.1f ns per call\n", sources, insert_time * 1e9 / sources / rounds);
+
+    // sources expire all the time, about the given number of them is logged
+    batman_db_change_brc_log_timeout(timeout);
+    uint64_t begin = hf_time_ms();
+    uint64_t now = begin;
+    double expire_time = 0;
+    int next = sources;
+
+    while(now < begin + 3 * timeout) {
+        int due = sources + (now - begin) * sources / timeout;
+
+        start = now_sec();
+
+        for(; next < due; next++) {
+            uint8_t source[ETH_ALEN];
+            node_addr(source, 0, next);
+            errors += (batman_db_addbrcid(source, 0) == true) ? 0 : 1;
+            calls++;
+        }
+
+        expire_time += now_sec() - start;
+
+        while(hf_time_ms() == now);
+
+        now = hf_time_ms();
+    }
+
+    printf("%d sources: expiring %6.1f ns per call, %u logged\n", sources, expire_time * 1e9 / calls, brclog_ts->size);
+
+    // only what was added within the timeout and the tick it ends in may be left
+    int allowed = (brclog_ts->tick + 1) * sources / timeout + sources;
+
+    if(brclog_ts->size > allowed) {
+        printf("%u logged, at most %d allowed\n", brclog_ts->size, allowed);
+        errors++;
+    }
+
+    printf("errors %d\n", errors);
+    free(order);
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
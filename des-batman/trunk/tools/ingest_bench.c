@@ -0,0 +1,201 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+/*
+ * Measure the OGM processing rate of the database with several threads.
+ *
+ * Every thread stands for the receive thread of one mesh interface: it
+ * receives the OGMs of all originators from its own neighbors and runs
+ * batman_db_processogm for each of them, as ogm_bench does with one. The
+ * threads work on the same originators at the same time, so they meet on
+ * the originator locks, and the routing table is filled by the first
+ * interval, so they only take the write lock then. The same OGMs are
+ * processed with 1, 2, 4, ... threads up to the given number. Prints the
+ * OGMs processed per second over all threads.
+ *
+ * Afterwards every originator has to be known with the last sequence
+ * number, otherwise the run fails.
+ *
+ * usage: ingest_bench [threads] [originators] [neighbors] [intervals]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "../src/config.h"
+#include "../src/helper.h"
+#include "../src/database/batman_database.h"
+
+uint16_t ogm_interval       = OGM_INTERVAL_MS;
+uint16_t ogm_size           = OGM_SIZE;
+uint8_t window_size         = WINDOW_SIZE;
+uint32_t brc_log_timeout    = BROADCAST_LOG_TIMEOUT;
+uint16_t ogm_aggr_window    = OGM_AGGR_WINDOW_MS;
+uint16_t ogm_aggr_jitter    = OGM_AGGR_JITTER_MS;
+uint8_t ogm_aggr_max        = OGM_AGGR_MAX;
+bool ogm_precursor_mode     = USE_PRECURSOR_LIST;
+bool resend_ogm_always      = RESEND_OGM_ALWAYS;
+
+typedef struct receiver {
+    pthread_t           thread;
+    dessert_meshif_t    iface;
+    unsigned int        seed;
+    long                ogms;
+} receiver_t;
+
+static int originators;
+static int neighbors;
+static int intervals;
+static pthread_barrier_t start_barrier;
+
+static void node_addr(uint8_t addr[ETH_ALEN], int net, int i) {
+    uint8_t a[ETH_ALEN] = {0x02, net, 0x00, 0x00, (i >> 8) & 0xff, i & 0xff};
+    memcpy(addr, a, ETH_ALEN);
+}
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void* receive(void* arg) {
+    receiver_t* rcv = arg;
+    int i, o, n;
+
+    pthread_barrier_wait(&start_barrier);
+
+    for(i = 1; i <= intervals; i++) {
+        uint64_t timestamp = hf_time_ms();
+
+        for(o = 0; o < originators; o++) {
+            uint8_t orig[ETH_ALEN];
+            node_addr(orig, 0, o);
+
+            for(n = 0; n < neighbors; n++) {
+                uint8_t neighbor[ETH_ALEN];
+
+                if(rand_r(&rcv->seed) % 100 >= 80) {
+                    continue;
+                }
+
+                node_addr(neighbor, 1, n);
+                batman_db_processogm(orig, &rcv->iface, neighbor, i, false, false, timestamp);
+                rcv->ogms++;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static int run(receiver_t* receivers, int threads) {
+    long ogms = 0;
+    int errors = 0;
+    int t, o;
+
+    pthread_barrier_init(&start_barrier, NULL, threads + 1);
+
+    for(t = 0; t < threads; t++) {
+        receivers[t].seed = t + 1;
+        receivers[t].ogms = 0;
+        pthread_create(&receivers[t].thread, NULL, receive, &receivers[t]);
+    }
+
+    pthread_barrier_wait(&start_barrier);
+    double start = now_sec();
+
+    for(t = 0; t < threads; t++) {
+        pthread_join(receivers[t].thread, NULL);
+        ogms += receivers[t].ogms;
+    }
+
+    double elapsed = now_sec() - start;
+    pthread_barrier_destroy(&start_barrier);
+
+    batman_db_rlock();
+
+    for(o = 0; o < originators; o++) {
+        uint8_t orig[ETH_ALEN];
+        node_addr(orig, 0, o);
+
+        if(batman_db_getroutesn(orig) != intervals) {
+            errors++;
+        }
+    }
+
+    batman_db_unlock();
+
+    printf("%-13s %2d threads, %d originators x %d neighbors: %.2f M OGMs/s, %.0f ns per OGM, errors %d\n",
+           ogm_precursor_mode ? "precursors" : "newest only", threads, originators, neighbors,
+           ogms / elapsed / 1e6, elapsed * 1e9 / ogms, errors);
+
+    batman_db_wlock();
+
+    for(o = 0; o < originators; o++) {
+        uint8_t orig[ETH_ALEN];
+        node_addr(orig, 0, o);
+        batman_db_deleteroute(orig);
+    }
+
+    batman_db_unlock();
+    return errors;
+}
+
+int main(int argc, char** argv) {
+    int max_threads = (argc > 1) ? atoi(argv[1]) : 4;
+    receiver_t* receivers = calloc(max_threads, sizeof(receiver_t));
+    int errors = 0;
+    int mode, t, n;
+
+    originators = (argc > 2) ? atoi(argv[2]) : 500;
+    neighbors = (argc > 3) ? atoi(argv[3]) : 20;
+    intervals = (argc > 4) ? atoi(argv[4]) : 100;
+
+    batman_db_init();
+
+    for(t = 0; t < max_threads; t++) {
+        uint8_t hwaddr[ETH_ALEN] = {0x02, 0xff, 0x00, 0x00, 0x00, t};
+        memcpy(receivers[t].iface.hwaddr, hwaddr, ETH_ALEN);
+        snprintf(receivers[t].iface.if_name, sizeof(receivers[t].iface.if_name), "mesh%d", t);
+
+        for(n = 0; n < neighbors; n++) {
+            uint8_t neighbor[ETH_ALEN];
+            node_addr(neighbor, 1, n);
+            batman_db_cap2Dneigh(neighbor, &receivers[t].iface);
+        }
+    }
+
+    for(mode = false; mode <= true; mode++) {
+        ogm_precursor_mode = mode;
+
+        for(t = 1; t <= max_threads; t *= 2) {
+            errors += run(receivers, t);
+        }
+    }
+
+    free(receivers);
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
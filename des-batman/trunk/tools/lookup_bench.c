@@ -0,0 +1,210 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+/*
+ * Measure the route lookup cost per forwarded packet.
+ *
+ * Fills the routing table with OGMs of the given number of originators,
+ * each received over the given number of next hops, and looks up random
+ * originators as the data handler does for every packet, with the read
+ * lock held:
+ *
+ *  best route        batman_db_getbestroute, without precursor mode
+ *  no loop           batman_db_getbestroute_arl, the best next hop is not
+ *                    in the precursors of the packet
+ *  best loops        the best next hop is in the precursors, the next one
+ *                    is taken from the sorted candidates
+ *  candidates loop   all candidates are in the precursors, the remaining
+ *                    next hops are searched
+ *
+ * The precursors are copied into the packet before every lookup, as the
+ * lookup adds this node to them. Prints the time per lookup.
+ *
+ * usage: lookup_bench [originators] [next hops] [lookups]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../src/config.h"
+#include "../src/helper.h"
+#include "../src/database/batman_database.h"
+
+uint16_t ogm_interval       = OGM_INTERVAL_MS;
+uint16_t ogm_size           = OGM_SIZE;
+uint8_t window_size         = WINDOW_SIZE;
+uint32_t brc_log_timeout    = BROADCAST_LOG_TIMEOUT;
+uint16_t ogm_aggr_window    = OGM_AGGR_WINDOW_MS;
+uint16_t ogm_aggr_jitter    = OGM_AGGR_JITTER_MS;
+uint8_t ogm_aggr_max        = OGM_AGGR_MAX;
+bool ogm_precursor_mode     = USE_PRECURSOR_LIST;
+bool resend_ogm_always      = RESEND_OGM_ALWAYS;
+
+/** candidates put into the precursors for "candidates loop", more than kept per destination */
+#define LOOPING_NEXT_HOPS   (OGM_PREC_LIST_SIZE / 2 + 4)
+
+enum { BEST_ROUTE, NO_LOOP, BEST_LOOPS, CANDIDATES_LOOP, CASES };
+
+static const char* case_names[] = {"best route", "no loop", "best loops", "candidates loop"};
+
+static dessert_meshif_t iface;
+
+static void node_addr(uint8_t addr[ETH_ALEN], int net, int i) {
+    uint8_t a[ETH_ALEN] = {0x02, net, 0x00, 0x00, (i >> 8) & 0xff, i & 0xff};
+    memcpy(addr, a, ETH_ALEN);
+}
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    int originators = (argc > 1) ? atoi(argv[1]) : 500;
+    int next_hops = (argc > 2) ? atoi(argv[2]) : 20;
+    long lookups = (argc > 3) ? atol(argv[3]) : 2000000;
+    hf_prec_filter_t* precursors[CASES];
+    int* targets = malloc(lookups * sizeof(int));
+    int errors = 0;
+    int o, n, s, c;
+    long i;
+
+    srand(1);
+    ogm_precursor_mode = true;
+    batman_db_init();
+    batman_db_wlock();
+
+    // every OGM is captured over each next hop that delivers it, with a link quality per next hop
+    for(s = 1; s <= window_size; s++) {
+        for(o = 0; o < originators; o++) {
+            uint8_t orig[ETH_ALEN];
+            node_addr(orig, 0, o);
+
+            for(n = 0; n < next_hops; n++) {
+                uint8_t next_hop[ETH_ALEN];
+                node_addr(next_hop, 1, n);
+
+                if(rand() % 100 < 100 - 90 * ((n + o) % next_hops) / next_hops) {
+                    batman_db_captureroute(orig, &iface, hf_time_ms(), next_hop, s);
+                }
+            }
+        }
+    }
+
+    batman_db_unlock();
+
+    // precursors of each case and originator
+    for(c = 0; c < CASES; c++) {
+        precursors[c] = calloc(originators, sizeof(hf_prec_filter_t));
+    }
+
+    batman_db_rlock();
+
+    for(o = 0; o < originators; o++) {
+        uint8_t orig[ETH_ALEN];
+        uint8_t next_hop[ETH_ALEN];
+        dessert_meshif_t* out_iface;
+        hf_prec_filter_t looping;
+
+        node_addr(orig, 0, o);
+        hf_prec_init(&precursors[NO_LOOP][o]);
+        hf_prec_init(&looping);
+
+        for(n = 0; n < LOOPING_NEXT_HOPS; n++) {
+            hf_prec_filter_t used = looping;
+
+            if(batman_db_getbestroute_arl(orig, &out_iface, next_hop, &used) == false) {
+                break;
+            }
+
+            hf_prec_add(&looping, next_hop);
+
+            if(n == 0) {
+                precursors[BEST_LOOPS][o] = looping;
+            }
+        }
+
+        precursors[CANDIDATES_LOOP][o] = looping;
+    }
+
+    batman_db_unlock();
+
+    for(i = 0; i < lookups; i++) {
+        targets[i] = rand() % originators;
+    }
+
+    // warm up the caches
+    batman_db_rlock();
+
+    for(i = 0; i < lookups; i++) {
+        uint8_t orig[ETH_ALEN];
+        uint8_t next_hop[ETH_ALEN];
+        dessert_meshif_t* out_iface;
+        node_addr(orig, 0, targets[i]);
+        batman_db_getbestroute(orig, &out_iface, next_hop);
+    }
+
+    batman_db_unlock();
+
+    printf("%d originators x %d next hops:\n", originators, next_hops);
+
+    for(c = 0; c < CASES; c++) {
+        long found = 0;
+
+        batman_db_rlock();
+        double start = now_sec();
+
+        for(i = 0; i < lookups; i++) {
+            uint8_t orig[ETH_ALEN];
+            uint8_t next_hop[ETH_ALEN];
+            dessert_meshif_t* out_iface;
+            node_addr(orig, 0, targets[i]);
+
+            if(c == BEST_ROUTE) {
+                found += batman_db_getbestroute(orig, &out_iface, next_hop);
+            }
+            else {
+                hf_prec_filter_t packet = precursors[c][targets[i]];
+                found += batman_db_getbestroute_arl(orig, &out_iface, next_hop, &packet);
+            }
+        }
+
+        double elapsed = now_sec() - start;
+        batman_db_unlock();
+
+        printf("  %-16s %6.1f ns per lookup, %ld of %ld found\n", case_names[c], elapsed * 1e9 / lookups, found, lookups);
+
+        if(found == 0) {
+            errors++;
+        }
+    }
+
+    for(c = 0; c < CASES; c++) {
+        free(precursors[c]);
+    }
+
+    free(targets);
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
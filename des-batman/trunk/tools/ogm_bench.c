@@ -0,0 +1,149 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+/*
+ * Measure the OGM processing rate of the database.
+ *
+ * Every OGM interval each originator sends a new sequence number, which is
+ * received over every bidirectional neighbor with a link quality fixed per
+ * originator and neighbor, in random order. Each received copy goes
+ * through batman_db_processogm, the transaction the OGM handler runs.
+ * Measured once with and once without precursor mode: without it only the
+ * first copy of a sequence number is captured, with it all of them.
+ * Prints the OGMs processed per second.
+ *
+ * usage: ogm_bench [originators] [neighbors] [intervals]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../src/config.h"
+#include "../src/helper.h"
+#include "../src/database/batman_database.h"
+
+uint16_t ogm_interval       = OGM_INTERVAL_MS;
+uint16_t ogm_size           = OGM_SIZE;
+uint8_t window_size         = WINDOW_SIZE;
+uint32_t brc_log_timeout    = BROADCAST_LOG_TIMEOUT;
+uint16_t ogm_aggr_window    = OGM_AGGR_WINDOW_MS;
+uint16_t ogm_aggr_jitter    = OGM_AGGR_JITTER_MS;
+uint8_t ogm_aggr_max        = OGM_AGGR_MAX;
+bool ogm_precursor_mode     = USE_PRECURSOR_LIST;
+bool resend_ogm_always      = RESEND_OGM_ALWAYS;
+
+static dessert_meshif_t iface;
+
+static void node_addr(uint8_t addr[ETH_ALEN], int net, int i) {
+    uint8_t a[ETH_ALEN] = {0x02, net, 0x00, 0x00, (i >> 8) & 0xff, i & 0xff};
+    memcpy(addr, a, ETH_ALEN);
+}
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run(int originators, int neighbors, int intervals) {
+    uint8_t (*quality)[neighbors] = malloc(originators * neighbors);
+    int* order = malloc(neighbors * sizeof(int));
+    long ogms = 0;
+    long captured = 0;
+    double elapsed = 0;
+    int o, n, i;
+
+    for(o = 0; o < originators; o++) {
+        for(n = 0; n < neighbors; n++) {
+            quality[o][n] = 20 + rand() % 81;
+        }
+    }
+
+    for(i = 1; i <= intervals; i++) {
+        uint64_t timestamp = hf_time_ms();
+
+        for(o = 0; o < originators; o++) {
+            uint8_t orig[ETH_ALEN];
+            node_addr(orig, 0, o);
+
+            for(n = 0; n < neighbors; n++) {
+                int k = rand() % (n + 1);
+                order[n] = order[k];
+                order[k] = n;
+            }
+
+            double start = now_sec();
+
+            for(n = 0; n < neighbors; n++) {
+                uint8_t neighbor[ETH_ALEN];
+
+                if(rand() % 100 >= quality[o][order[n]]) {
+                    continue;
+                }
+
+                node_addr(neighbor, 1, order[n]);
+                int result = batman_db_processogm(orig, &iface, neighbor, i, false, false, timestamp);
+                captured += (result & BATMAN_DB_OGM_CAPTURED) ? 1 : 0;
+                ogms++;
+            }
+
+            elapsed += now_sec() - start;
+        }
+    }
+
+    printf("%-13s %d originators x %d neighbors: %.2f M OGMs/s, %.0f ns per OGM, %ld of %ld captured\n",
+           ogm_precursor_mode ? "precursors" : "newest only", originators, neighbors,
+           ogms / elapsed / 1e6, elapsed * 1e9 / ogms, captured, ogms);
+
+    for(o = 0; o < originators; o++) {
+        uint8_t orig[ETH_ALEN];
+        node_addr(orig, 0, o);
+        batman_db_deleteroute(orig);
+    }
+
+    free(order);
+    free(quality);
+}
+
+int main(int argc, char** argv) {
+    int originators = (argc > 1) ? atoi(argv[1]) : 500;
+    int neighbors = (argc > 2) ? atoi(argv[2]) : 20;
+    int intervals = (argc > 3) ? atoi(argv[3]) : 200;
+    int n;
+
+    srand(1);
+    batman_db_init();
+
+    for(n = 0; n < neighbors; n++) {
+        uint8_t neighbor[ETH_ALEN];
+        node_addr(neighbor, 1, n);
+        batman_db_cap2Dneigh(neighbor, &iface);
+    }
+
+    ogm_precursor_mode = false;
+    run(originators, neighbors, intervals);
+    ogm_precursor_mode = true;
+    run(originators, neighbors, intervals);
+    return EXIT_SUCCESS;
+}
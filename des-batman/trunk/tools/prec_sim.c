@@ -0,0 +1,338 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+
+/*
+ * Simulate the precursors of OGMs in a mesh to measure airtime and loop
+ * avoidance of the precursor filter against the former precursor list.
+ *
+ * The nodes are placed at random in a unit square, with links between
+ * nodes closer than the radio range. Every node originates one OGM, which
+ * is flooded in precursor mode: a node that receives a copy checks whether
+ * it is in the precursors. If not, it captures the route and adds itself,
+ * and it rebroadcasts the first copy it captures after adding itself once
+ * more, as the OGM handler does. Each transmission reaches all neighbors
+ * after a random delay. The flood runs once with the former list, the last
+ * OGM_PREC_LIST_SIZE addresses in 6 bytes each plus a count, and once with
+ * hf_prec_filter_t, on the same mesh with the same delays. The full path of
+ * every copy is kept aside as the truth:
+ *
+ *  loops        copies received by a node on their path
+ *  missed       loops captured anyway, the route would point back
+ *  false drops  copies dropped although the node is not on their path
+ *
+ * Afterwards the false positive rate of the filter is measured for 1 to
+ * 2 * OGM_PREC_LIST_SIZE added addresses, the number of hops a data packet
+ * took for loop avoidance. The run fails if the filter misses more loops
+ * than the list, forgets one of the last OGM_PREC_LIST_SIZE / 2 addresses or
+ * exceeds 1% false positives with up to OGM_PREC_LIST_SIZE addresses.
+ *
+ * usage: prec_sim [nodes] [neighbors per node] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../src/config.h"
+#include "../src/helper.h"
+
+uint16_t ogm_interval       = OGM_INTERVAL_MS;
+uint16_t ogm_size           = OGM_SIZE;
+uint8_t window_size         = WINDOW_SIZE;
+uint32_t brc_log_timeout    = BROADCAST_LOG_TIMEOUT;
+uint16_t ogm_aggr_window    = OGM_AGGR_WINDOW_MS;
+uint16_t ogm_aggr_jitter    = OGM_AGGR_JITTER_MS;
+uint8_t ogm_aggr_max        = OGM_AGGR_MAX;
+bool ogm_precursor_mode     = USE_PRECURSOR_LIST;
+bool resend_ogm_always      = RESEND_OGM_ALWAYS;
+
+/** OGM fields besides the precursors: version, flags, gw_flags, sequence_num, gw_port, originator */
+#define OGM_FIXED_BYTES     (3 + 2 + 2 + ETH_ALEN)
+/** type and length of the extension */
+#define EXT_HDR_BYTES       2
+/** former precursor list: addresses and count */
+#define LIST_BYTES          (OGM_PREC_LIST_SIZE * ETH_ALEN + 1)
+#define MAX_DELAY           10
+#define FP_TESTS            100000
+
+enum { LIST, FILTER, MODES };
+
+static const char* mode_names[] = {"list", "filter"};
+
+/** former precursor list, with the same sliding and duplicates as the handler */
+typedef struct prec_list {
+    int         nodes[OGM_PREC_LIST_SIZE];
+    int         count;
+} prec_list_t;
+
+typedef struct copy {
+    int                 sender;
+    int                 time;
+    int                 path_len;
+    int*                path;
+    prec_list_t         list;
+    hf_prec_filter_t    filter;
+} copy_t;
+
+typedef struct stats {
+    long        transmissions;
+    long        bytes;
+    long        received;
+    long        captured;
+    long        loops;
+    long        missed;
+    long        false_drops;
+} stats_t;
+
+static int nodes;
+static uint8_t (*addrs)[ETH_ALEN];
+static char* links;
+static int* delays;
+
+static void list_add(prec_list_t* list, int node) {
+    if(list->count < OGM_PREC_LIST_SIZE) {
+        list->nodes[list->count++] = node;
+    }
+    else {
+        memmove(list->nodes, list->nodes + 1, (OGM_PREC_LIST_SIZE - 1) * sizeof(int));
+        list->nodes[OGM_PREC_LIST_SIZE - 1] = node;
+    }
+}
+
+static int list_contains(const prec_list_t* list, int node) {
+    int i;
+
+    for(i = list->count - 1; i >= 0; i--) {
+        if(list->nodes[i] == node) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void add_myself(copy_t* c, int mode, int node) {
+    if(mode == LIST) {
+        list_add(&c->list, node);
+    }
+    else {
+        hf_prec_add(&c->filter, addrs[node]);
+    }
+}
+
+static void flood(int mode, int orig, stats_t* st) {
+    copy_t* queue = malloc(nodes * sizeof(copy_t));
+    char* rebroadcasted = calloc(nodes, 1);
+    int queued = 0;
+    int r;
+
+    // originator sends with empty precursors
+    memset(&queue[0], 0, sizeof(copy_t));
+    queue[0].sender = orig;
+    queue[0].path = malloc(nodes * sizeof(int));
+    hf_prec_init(&queue[0].filter);
+    queued = 1;
+    rebroadcasted[orig] = true;
+
+    while(queued > 0) {
+        int first = 0;
+        int i;
+
+        for(i = 1; i < queued; i++) {
+            if(queue[i].time < queue[first].time) {
+                first = i;
+            }
+        }
+
+        copy_t tx = queue[first];
+        queue[first] = queue[--queued];
+
+        st->transmissions++;
+        st->bytes += EXT_HDR_BYTES + OGM_FIXED_BYTES + ((mode == LIST) ? LIST_BYTES : sizeof(hf_prec_filter_t));
+
+        for(r = 0; r < nodes; r++) {
+            if(!links[tx.sender * nodes + r] || r == orig) {
+                continue;
+            }
+
+            int on_path = false;
+
+            for(i = 0; i < tx.path_len; i++) {
+                on_path |= (tx.path[i] == r);
+            }
+
+            int in_prec = (mode == LIST) ? list_contains(&tx.list, r) : hf_prec_contains(&tx.filter, addrs[r]);
+
+            st->received++;
+            st->loops += on_path;
+            st->missed += on_path && !in_prec;
+            st->false_drops += !on_path && in_prec;
+
+            if(in_prec) {
+                continue;
+            }
+
+            st->captured++;
+
+            if(rebroadcasted[r]) {
+                continue;
+            }
+
+            // captured -> add myself, rebroadcast -> add myself again
+            copy_t* c = &queue[queued++];
+            *c = tx;
+            c->sender = r;
+            c->time = tx.time + delays[tx.sender * nodes + r];
+            c->path = malloc(nodes * sizeof(int));
+            memcpy(c->path, tx.path, tx.path_len * sizeof(int));
+            c->path[c->path_len++] = r;
+            add_myself(c, mode, r);
+            add_myself(c, mode, r);
+            rebroadcasted[r] = true;
+        }
+
+        free(tx.path);
+    }
+
+    free(rebroadcasted);
+    free(queue);
+}
+
+static void random_addr(uint8_t addr[ETH_ALEN]) {
+    int i;
+
+    for(i = 0; i < ETH_ALEN; i++) {
+        addr[i] = rand() & 0xff;
+    }
+
+    addr[0] = (addr[0] & 0xfc) | 0x02;
+}
+
+int main(int argc, char** argv) {
+    nodes = (argc > 1) ? atoi(argv[1]) : 200;
+    double degree = (argc > 2) ? atof(argv[2]) : 10;
+    int seed = (argc > 3) ? atoi(argv[3]) : 1;
+    double range = sqrt(degree / (M_PI * nodes));
+    double* x = malloc(nodes * sizeof(double));
+    double* y = malloc(nodes * sizeof(double));
+    stats_t st[MODES];
+    long link_count = 0;
+    int errors = 0;
+    int mode, i, j, k;
+
+    srand(seed);
+    addrs = malloc(nodes * ETH_ALEN);
+    links = calloc(nodes * nodes, 1);
+    delays = malloc(nodes * nodes * sizeof(int));
+
+    for(i = 0; i < nodes; i++) {
+        x[i] = rand() / (double) RAND_MAX;
+        y[i] = rand() / (double) RAND_MAX;
+        random_addr(addrs[i]);
+    }
+
+    for(i = 0; i < nodes; i++) {
+        for(j = 0; j < nodes; j++) {
+            double dx = x[i] - x[j];
+            double dy = y[i] - y[j];
+            links[i * nodes + j] = (i != j) && (dx * dx + dy * dy < range * range);
+            link_count += links[i * nodes + j];
+            delays[i * nodes + j] = 1 + rand() % MAX_DELAY;
+        }
+    }
+
+    memset(st, 0, sizeof(st));
+
+    for(mode = LIST; mode < MODES; mode++) {
+        for(i = 0; i < nodes; i++) {
+            flood(mode, i, &st[mode]);
+        }
+    }
+
+    printf("%d nodes, %.1f neighbors per node, one OGM per node:\n", nodes, (double) link_count / nodes);
+
+    for(mode = LIST; mode < MODES; mode++) {
+        printf("  %-7s %3ld bytes per OGM, %ld transmissions, %ld bytes, %ld received, %ld captured, "
+               "%ld loops, %ld missed, %ld false drops (%.3f%%)\n",
+               mode_names[mode], st[mode].bytes / st[mode].transmissions, st[mode].transmissions, st[mode].bytes,
+               st[mode].received, st[mode].captured, st[mode].loops, st[mode].missed, st[mode].false_drops,
+               100.0 * st[mode].false_drops / (st[mode].received - st[mode].loops));
+    }
+
+    printf("  airtime of OGMs saved by the filter: %.1f%%\n", 100.0 - 100.0 * st[FILTER].bytes / st[LIST].bytes);
+
+    if(st[FILTER].missed > st[LIST].missed) {
+        errors++;
+    }
+
+    // false positives and forgotten addresses of the filter by number of added addresses
+    printf("filter with %d bits x 2, %d hashes:\n", PREC_FILTER_BITS, PREC_FILTER_HASHES);
+
+    for(k = 1; k <= 2 * OGM_PREC_LIST_SIZE; k++) {
+        uint8_t (*added)[ETH_ALEN] = malloc(k * ETH_ALEN);
+        long false_positives = 0;
+        long forgotten = 0;
+        int t;
+
+        for(t = 0; t < FP_TESTS / 100; t++) {
+            hf_prec_filter_t filter;
+            hf_prec_init(&filter);
+
+            for(i = 0; i < k; i++) {
+                random_addr(added[i]);
+                hf_prec_add(&filter, added[i]);
+            }
+
+            for(i = 0; i < k; i++) {
+                // the last OGM_PREC_LIST_SIZE / 2 addresses must be remembered
+                if(k - i <= OGM_PREC_LIST_SIZE / 2 && hf_prec_contains(&filter, added[i]) == false) {
+                    forgotten++;
+                }
+            }
+
+            for(i = 0; i < 100; i++) {
+                uint8_t other[ETH_ALEN];
+                random_addr(other);
+                false_positives += hf_prec_contains(&filter, other);
+            }
+        }
+
+        printf("  %2d addresses: %.3f%% false positives, %ld of the last %d forgotten\n",
+               k, 100.0 * false_positives / FP_TESTS, forgotten, OGM_PREC_LIST_SIZE / 2);
+
+        if(forgotten > 0 || (k <= OGM_PREC_LIST_SIZE && false_positives * 100 > FP_TESTS)) {
+            errors++;
+        }
+
+        free(added);
+    }
+
+    printf("errors %d\n", errors);
+    free(delays);
+    free(links);
+    free(addrs);
+    free(y);
+    free(x);
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,556 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+/*
+ * Compare the next hop rankings of the routing table against the former
+ * implementation: sliding windows as linked lists of sequence numbers that
+ * are shifted up to every new sequence number of the originator (the
+ * reference below is the former batman_sw.c and batman_db_nht_shiftuptoseq).
+ *
+ * Several originators send OGMs with lost sequence numbers over links of
+ * changing quality, received on three interfaces, across the sequence
+ * number wraparound and with window size changes in between. Two streams:
+ *
+ *  newest only   each sequence number is captured once, over the link it
+ *                arrives first (as without precursor mode): best interface
+ *                and best next hop have to be the same as in the reference
+ *  all copies    each sequence number is captured over every link it
+ *                arrives (as in precursor mode): the best next hop may be
+ *                another one with the same count
+ *
+ * After every OGM the loop avoiding lookup is called with random next hops
+ * of the originator in the precursor filter. It has to return the best next
+ * hop if not in the filter, otherwise one with the highest count of all
+ * next hops not in the filter.
+ *
+ * usage: rank_test [rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/config.h"
+#include "../src/helper.h"
+#include "../src/database/routing_table/batman_rt.h"
+
+uint16_t ogm_interval       = OGM_INTERVAL_MS;
+uint16_t ogm_size           = OGM_SIZE;
+uint8_t window_size         = WINDOW_SIZE;
+uint32_t brc_log_timeout    = BROADCAST_LOG_TIMEOUT;
+uint16_t ogm_aggr_window    = OGM_AGGR_WINDOW_MS;
+uint16_t ogm_aggr_jitter    = OGM_AGGR_JITTER_MS;
+uint8_t ogm_aggr_max        = OGM_AGGR_MAX;
+bool ogm_precursor_mode     = USE_PRECURSOR_LIST;
+bool resend_ogm_always      = RESEND_OGM_ALWAYS;
+
+#define ORIGINATORS     16
+#define IFACES          3
+#define NEXT_HOPS       6       // per interface, more than RT_CANDIDATE_COUNT in total
+#define MAX_ERRORS      20
+
+static const uint8_t window_sizes[] = {WINDOW_SIZE, 64, 7, 255, 1, 130};
+
+static dessert_meshif_t ifaces[IFACES];
+static int errors = 0;
+
+#define FAIL(...) do { if(errors++ < MAX_ERRORS) { printf(__VA_ARGS__); printf("\n"); } } while(0)
+
+// ------------------- reference: former sliding window ------------------------
+
+typedef struct ref_sw_element {
+    struct ref_sw_element*  prev;
+    struct ref_sw_element*  next;
+    uint16_t                seq_num;
+} ref_sw_element_t;
+
+typedef struct ref_sw {
+    ref_sw_element_t*   head;
+    ref_sw_element_t*   tail;
+    uint16_t            size;
+    uint8_t             window_size;
+} ref_sw_t;
+
+static void ref_sw_init(ref_sw_t* sw, uint8_t ws) {
+    sw->head = NULL;
+    sw->tail = NULL;
+    sw->size = 0;
+    sw->window_size = ws;
+}
+
+static void ref_sw_clear(ref_sw_t* sw) {
+    while(sw->tail != NULL) {
+        ref_sw_element_t* el = sw->tail;
+        sw->tail = el->next;
+        free(el);
+    }
+}
+
+static void ref_sw_dropsn(ref_sw_t* sw, uint16_t seq_num) {
+    ref_sw_element_t* search_el = sw->tail;
+
+    while(search_el != NULL && hf_seq_comp_i_j(seq_num, search_el->seq_num + sw->window_size) >= 0) {
+        search_el = search_el->next;
+
+        if(search_el != NULL) {
+            search_el->prev = NULL;
+        }
+
+        free(sw->tail);
+
+        if(sw->tail == sw->head) {
+            sw->tail = sw->head = search_el;
+        }
+        else {
+            sw->tail = search_el;
+        }
+
+        sw->size--;
+    }
+}
+
+static void ref_sw_addsn(ref_sw_t* sw, uint16_t seq_num) {
+    ref_sw_element_t* new_el;
+
+    if((sw->head != NULL) && (hf_seq_comp_i_j(sw->head->seq_num, seq_num + sw->window_size) >= 0)) {
+        return;
+    }
+
+    new_el = calloc(1, sizeof(ref_sw_element_t));
+    new_el->seq_num = seq_num;
+
+    if(sw->size == 0) {
+        sw->head = sw->tail = new_el;
+        sw->size = 1;
+        return;
+    }
+
+    ref_sw_element_t* search_el = sw->head;
+
+    while(search_el->prev != NULL && hf_seq_comp_i_j(search_el->seq_num, seq_num) >= 0) {
+        if(search_el->seq_num == seq_num) {
+            free(new_el);
+            return;
+        }
+
+        search_el = search_el->prev;
+    }
+
+    if(search_el->seq_num == seq_num) {
+        free(new_el);
+        return;
+    }
+
+    if(hf_seq_comp_i_j(search_el->seq_num, seq_num) < 0) {
+        new_el->prev = search_el;
+        new_el->next = search_el->next;
+        search_el->next = new_el;
+
+        if(new_el->next != NULL) {
+            new_el->next->prev = new_el;
+        }
+
+        if(sw->head == search_el) {
+            sw->head = new_el;
+        }
+    }
+    else {
+        new_el->prev = search_el->prev;
+        new_el->next = search_el;
+        search_el->prev = new_el;
+
+        if(new_el->prev != NULL) {
+            new_el->prev->next = new_el;
+        }
+
+        if(sw->tail == search_el) {
+            sw->tail = new_el;
+        }
+    }
+
+    sw->size++;
+    ref_sw_dropsn(sw, sw->head->seq_num);
+}
+
+static void ref_sw_chage_size(ref_sw_t* sw, uint8_t ws) {
+    sw->window_size = ws;
+
+    if(sw->head != NULL) {
+        ref_sw_dropsn(sw, sw->head->seq_num);
+    }
+}
+
+// ------------------- reference: former ranking -------------------------------
+
+/** next hops and interfaces are kept in table order, as in the hash tables */
+typedef struct ref_nh {
+    uint8_t     addr[ETH_ALEN];
+    ref_sw_t    sw;
+} ref_nh_t;
+
+typedef struct ref_iface {
+    int         iface;
+    ref_nh_t    nh[NEXT_HOPS];
+    int         nh_count;
+    int         best;
+} ref_iface_t;
+
+typedef struct ref_entry {
+    ref_iface_t if_entrys[IFACES];
+    int         if_count;
+    int         best_iface;
+    uint16_t    curr_seq_num;
+    int         valid;
+} ref_entry_t;
+
+static ref_entry_t ref[ORIGINATORS];
+
+static void ref_shiftuptoseq(ref_iface_t* rif, uint16_t seq_num) {
+    int i = 0;
+
+    rif->best = (rif->nh_count > 0) ? 0 : -1;
+
+    while(i < rif->nh_count) {
+        ref_sw_dropsn(&rif->nh[i].sw, seq_num);
+
+        if(rif->nh[rif->best].sw.size + WINDOW_SWITCH_DIFF <= rif->nh[i].sw.size) {
+            rif->best = i;
+        }
+
+        if(rif->nh[i].sw.size == 0) {
+            ref_sw_clear(&rif->nh[i].sw);
+            memmove(&rif->nh[i], &rif->nh[i + 1], (rif->nh_count - i - 1) * sizeof(ref_nh_t));
+            rif->nh_count--;
+
+            if(rif->best == i) {
+                rif->best = (rif->nh_count > 0) ? 0 : -1;
+            }
+            else if(rif->best > i) {
+                rif->best--;
+            }
+
+            continue;
+        }
+
+        i++;
+    }
+}
+
+static void ref_addroute(int orig, int iface, const uint8_t nexthop[ETH_ALEN], uint16_t seq_num) {
+    ref_entry_t* re = &ref[orig];
+    ref_iface_t* rif = NULL;
+    int i;
+
+    if(re->valid == false) {
+        re->valid = true;
+        re->if_count = 0;
+        re->best_iface = 0;
+    }
+
+    for(i = 0; i < re->if_count; i++) {
+        if(re->if_entrys[i].iface == iface) {
+            rif = &re->if_entrys[i];
+        }
+    }
+
+    if(rif == NULL) {
+        rif = &re->if_entrys[re->if_count++];
+        rif->iface = iface;
+        rif->nh_count = 0;
+        rif->best = -1;
+    }
+
+    re->curr_seq_num = seq_num;
+    i = 0;
+
+    while(i < re->if_count) {
+        rif = &re->if_entrys[i];
+
+        if(rif->iface == iface) {
+            ref_nh_t* nh = NULL;
+            int n;
+
+            for(n = 0; n < rif->nh_count; n++) {
+                if(memcmp(rif->nh[n].addr, nexthop, ETH_ALEN) == 0) {
+                    nh = &rif->nh[n];
+                }
+            }
+
+            if(nh == NULL) {
+                nh = &rif->nh[rif->nh_count++];
+                memcpy(nh->addr, nexthop, ETH_ALEN);
+                ref_sw_init(&nh->sw, window_size);
+            }
+
+            ref_sw_addsn(&nh->sw, seq_num);
+        }
+
+        ref_shiftuptoseq(rif, seq_num);
+
+        // the former code did not check for an output iface without next hop, it would have crashed
+        ref_iface_t* best = &re->if_entrys[re->best_iface];
+
+        if(rif->best != -1 &&
+           (best->best == -1 || best->nh[best->best].sw.size + WINDOW_SWITCH_DIFF <= rif->nh[rif->best].sw.size)) {
+            re->best_iface = i;
+        }
+
+        if(rif->best == -1) {
+            memmove(&re->if_entrys[i], &re->if_entrys[i + 1], (re->if_count - i - 1) * sizeof(ref_iface_t));
+            re->if_count--;
+
+            if(re->best_iface == i) {
+                re->best_iface = 0;
+            }
+            else if(re->best_iface > i) {
+                re->best_iface--;
+            }
+
+            continue;
+        }
+
+        i++;
+    }
+}
+
+/**
+ * The former code changed the size relative to the newest sequence number of
+ * each window and left the counts of windows behind the originator too high
+ * until its next OGM. They are shifted to the originator here as well, so
+ * both compare the same counts in the meantime.
+ */
+static void ref_change_window_size(uint8_t ws) {
+    int o, i, n;
+
+    for(o = 0; o < ORIGINATORS; o++) {
+        for(i = 0; ref[o].valid && i < ref[o].if_count; i++) {
+            for(n = 0; n < ref[o].if_entrys[i].nh_count; n++) {
+                ref_sw_chage_size(&ref[o].if_entrys[i].nh[n].sw, ws);
+                ref_sw_dropsn(&ref[o].if_entrys[i].nh[n].sw, ref[o].curr_seq_num);
+            }
+        }
+    }
+}
+
+/** count of the next hop in the reference, -1 if not known */
+static int ref_count(int orig, dessert_meshif_t* iface, const uint8_t nexthop[ETH_ALEN]) {
+    int i, n;
+
+    for(i = 0; i < ref[orig].if_count; i++) {
+        ref_iface_t* rif = &ref[orig].if_entrys[i];
+
+        for(n = 0; iface == &ifaces[rif->iface] && n < rif->nh_count; n++) {
+            if(memcmp(rif->nh[n].addr, nexthop, ETH_ALEN) == 0) {
+                return rif->nh[n].sw.size;
+            }
+        }
+    }
+
+    return -1;
+}
+
+// ------------------- test ----------------------------------------------------
+
+typedef struct sim_link {
+    int         iface;
+    uint8_t     nexthop[ETH_ALEN];
+    int         quality;    // percent of OGMs received
+} sim_link_t;
+
+static sim_link_t links[ORIGINATORS][IFACES * NEXT_HOPS];
+static uint16_t seq_nums[ORIGINATORS];
+
+static void orig_addr(uint8_t addr[ETH_ALEN], int orig) {
+    uint8_t a[ETH_ALEN] = {0x02, 0x00, 0x00, 0x00, 0x00, orig};
+    memcpy(addr, a, ETH_ALEN);
+}
+
+static void check_route(int orig, const char* stream, int exact) {
+    uint8_t dest[ETH_ALEN];
+    uint8_t nexthop[ETH_ALEN];
+    dessert_meshif_t* iface;
+    ref_entry_t* re = &ref[orig];
+
+    orig_addr(dest, orig);
+
+    if(batman_db_rt_getbestroute(dest, &iface, nexthop) == false) {
+        FAIL("%s: no route to originator %d", stream, orig);
+        return;
+    }
+
+    ref_iface_t* rif = &re->if_entrys[re->best_iface];
+    ref_nh_t* best = &rif->nh[rif->best];
+
+    if(iface != &ifaces[rif->iface]) {
+        FAIL("%s: originator %d over iface %d instead of %d", stream, orig, (int)(iface - ifaces), rif->iface);
+        return;
+    }
+
+    if(exact && memcmp(nexthop, best->addr, ETH_ALEN) != 0) {
+        FAIL("%s: originator %d over " MAC " instead of " MAC, stream, orig, EXPLODE_ARRAY6(nexthop), EXPLODE_ARRAY6(best->addr));
+    }
+    else if(ref_count(orig, iface, nexthop) != best->sw.size) {
+        FAIL("%s: originator %d over " MAC " with count %d instead of %d", stream, orig,
+             EXPLODE_ARRAY6(nexthop), ref_count(orig, iface, nexthop), best->sw.size);
+    }
+
+    // loop avoidance: some next hops of the originator are precursors
+    hf_prec_filter_t filter;
+    hf_prec_filter_t used;
+    int excluded = rand() % (OGM_PREC_LIST_SIZE / 2 + 1);
+    int i, n;
+
+    hf_prec_init(&filter);
+
+    for(n = 0; n < excluded; n++) {
+        hf_prec_add(&filter, links[orig][rand() % (IFACES * NEXT_HOPS)].nexthop);
+    }
+
+    if(rand() % 2) {
+        hf_prec_add(&filter, nexthop);
+    }
+
+    int best_excluded = hf_prec_contains(&filter, nexthop);
+    int expected = -1;
+
+    for(i = 0; i < re->if_count; i++) {
+        for(n = 0; n < re->if_entrys[i].nh_count; n++) {
+            ref_nh_t* nh = &re->if_entrys[i].nh[n];
+
+            if(hf_prec_contains(&filter, nh->addr) == false && nh->sw.size > expected) {
+                expected = nh->sw.size;
+            }
+        }
+    }
+
+    uint8_t best_nexthop[ETH_ALEN];
+    dessert_meshif_t* best_iface = iface;
+    memcpy(best_nexthop, nexthop, ETH_ALEN);
+    used = filter;
+
+    int found = batman_db_rt_getbestroute_arl(dest, &iface, nexthop, &used);
+
+    if(found != (expected != -1)) {
+        FAIL("%s: originator %d loop free route %s", stream, orig, found ? "found but none expected" : "not found");
+    }
+    else if(found && best_excluded == false && (iface != best_iface || memcmp(nexthop, best_nexthop, ETH_ALEN) != 0)) {
+        FAIL("%s: originator %d loop free route is not the best route", stream, orig);
+    }
+    else if(found && best_excluded && (hf_prec_contains(&filter, nexthop) || ref_count(orig, iface, nexthop) != expected)) {
+        FAIL("%s: originator %d loop free route " MAC " with count %d instead of %d", stream, orig,
+             EXPLODE_ARRAY6(nexthop), ref_count(orig, iface, nexthop), expected);
+    }
+}
+
+static void run_stream(const char* stream, int all_copies, int rounds) {
+    int r, o, l;
+    int phase = 0;
+
+    memset(ref, 0, sizeof(ref));
+    window_size = window_sizes[0];
+    batman_db_rt_init();
+
+    for(o = 0; o < ORIGINATORS; o++) {
+        // start close to the wraparound
+        seq_nums[o] = SEQNO_MAX - 3000 + rand() % 2000;
+
+        for(l = 0; l < IFACES * NEXT_HOPS; l++) {
+            uint8_t nexthop[ETH_ALEN] = {0x02, 0x01, 0x00, 0x00, o, l % (NEXT_HOPS + 2)};
+            links[o][l].iface = l / NEXT_HOPS;
+            memcpy(links[o][l].nexthop, nexthop, ETH_ALEN);
+            links[o][l].quality = rand() % 101;
+        }
+    }
+
+    for(r = 1; r <= rounds; r++) {
+        if(r % (rounds / 6 + 1) == 0) {
+            // change window size of all windows
+            window_size = window_sizes[++phase % sizeof(window_sizes)];
+            batman_db_rt_change_window_size(window_size);
+            ref_change_window_size(window_size);
+        }
+
+        for(o = 0; o < ORIGINATORS; o++) {
+            uint8_t dest[ETH_ALEN];
+            int order[IFACES * NEXT_HOPS];
+            int captured = false;
+
+            orig_addr(dest, o);
+            // lost sequence numbers, some of them for a long time
+            seq_nums[o] += (rand() % 50 == 0) ? 1 + rand() % 300 : 1 + rand() % 3;
+
+            if(rand() % 20 == 0) {
+                links[o][rand() % (IFACES * NEXT_HOPS)].quality = rand() % 101;
+            }
+
+            for(l = 0; l < IFACES * NEXT_HOPS; l++) {
+                int k = rand() % (l + 1);
+                order[l] = order[k];
+                order[k] = l;
+            }
+
+            for(l = 0; l < IFACES * NEXT_HOPS; l++) {
+                sim_link_t* link = &links[o][order[l]];
+
+                if(rand() % 100 >= link->quality || (captured && all_copies == false)) {
+                    continue;
+                }
+
+                batman_db_rt_addroute(dest, &ifaces[link->iface], r, link->nexthop, seq_nums[o]);
+                ref_addroute(o, link->iface, link->nexthop, seq_nums[o]);
+                captured = true;
+                check_route(o, stream, all_copies == false);
+            }
+        }
+    }
+
+    for(o = 0; o < ORIGINATORS; o++) {
+        uint8_t dest[ETH_ALEN];
+        int i, n;
+
+        orig_addr(dest, o);
+        batman_db_rt_deleteroute(dest);
+
+        for(i = 0; ref[o].valid && i < ref[o].if_count; i++) {
+            for(n = 0; n < ref[o].if_entrys[i].nh_count; n++) {
+                ref_sw_clear(&ref[o].if_entrys[i].nh[n].sw);
+            }
+        }
+    }
+
+    printf("%-12s %d rounds, %d originators: errors %d\n", stream, rounds, ORIGINATORS, errors);
+}
+
+int main(int argc, char** argv) {
+    int rounds = (argc > 1) ? atoi(argv[1]) : 20000;
+    int i;
+
+    for(i = 0; i < IFACES; i++) {
+        uint8_t hwaddr[ETH_ALEN] = {0x02, 0xff, 0x00, 0x00, 0x00, i};
+        memcpy(ifaces[i].hwaddr, hwaddr, ETH_ALEN);
+    }
+
+    srand(1);
+    run_stream("newest only", false, rounds);
+    run_stream("all copies", true, rounds);
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
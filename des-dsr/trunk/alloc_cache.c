@@ -1,115 +1,310 @@
 #include "dsr.h"
 
-//#define CHUNK_SIZE DESSERT_MAXFRAMELEN
-// \todo remove magic number
-#define CHUNK_SIZE 2500
-#define CACHE_SIZE 500
+/*
+ * Every thread keeps a magazine of free buffers per size class and serves
+ * allocations from it without locking. Buffers move between the magazines
+ * and a shared per class depot in chains of ALLOC_CACHE_BATCH buffers, so
+ * the depot mutex is only taken once per batch. The depot stores whole
+ * chains and holds at most CACHE_SIZE buffers per class; surplus chains are
+ * freed. A small header in front of every buffer records its class, so a
+ * buffer may be freed by another thread than the one that allocated it.
+ */
+
+#define ALLOC_CACHE_BIG ALLOC_CACHE_CLASSES
 
-pthread_mutex_t _alloc_mutex = PTHREAD_MUTEX_INITIALIZER;
+typedef struct el {
+    struct el* next;        /* next buffer of the chain */
+    struct el* next_batch;  /* depot only: first buffer of the next chain */
+} el_t;
+
+typedef union alloc_hdr {
+    uint32_t cls;
+    uint8_t pad[16];        /* keeps the buffer 16 byte aligned */
+} alloc_hdr_t;
+
+typedef struct depot {
+    pthread_mutex_t mutex;
+    el_t* batches;
+    dsr_alloc_cache_stats_t stats;
+} depot_t;
+
+typedef struct magazine {
+    el_t* head;
+    int len;
+} magazine_t;
+
+static const size_t _class_sizes[ALLOC_CACHE_CLASSES] = ALLOC_CACHE_CLASS_SIZES;
+
+static depot_t _depot[ALLOC_CACHE_CLASSES + 1];
+static pthread_once_t _init_once = PTHREAD_ONCE_INIT;
+static pthread_key_t _thread_key;
+
+static __thread magazine_t _magazines[ALLOC_CACHE_CLASSES];
+static __thread int _thread_registered = 0;
 
 #ifdef CACHE_STATISTICS
-int cache_allocs;
-int cache_underrun;
-int cache_deallocs;
-int cache_overflow;
-int cache_max;
-int cache_mean;
+#define _STAT_INC(cls, field) __sync_fetch_and_add(&_depot[cls].stats.field, 1)
+#else
+#define _STAT_INC(cls, field)
 #endif
 
-int ll_len = 0;
-int cache_size = 0;
+static void _return_batch(int cls);
 
-typedef struct el {
+static void _thread_exit(void* data) {
+    int cls;
 
-    struct el* next;
+    for(cls = 0; cls < ALLOC_CACHE_CLASSES; cls++) {
+        magazine_t* mag = &_magazines[cls];
 
-} el_t;
+        while(mag->len >= ALLOC_CACHE_BATCH) {
+            _return_batch(cls);
+        }
 
-el_t* ll_head = NULL;
+        while(mag->head) {
+            el_t* el = mag->head;
+            mag->head = el->next;
+            free(((alloc_hdr_t*) el) - 1);
+            __sync_fetch_and_add(&_depot[cls].stats.overflow, 1);
+        }
 
-#ifdef CACHE_STATISTICS
-int cache_statistics(void* data, struct timeval* scheduled,
-                     struct timeval* interval) {
+        mag->len = 0;
+    }
+}
 
-    dessert_info("   allocs: %.10i  deallocs: %.10i  cache_max: %i  ", cache_allocs, cache_deallocs, cache_max);
-    dessert_info(" underrun: %.10i  overflow: %.10i     ll_len: %i  ", cache_underrun, cache_overflow, ll_len);
-    dessert_info(" cache_size: %i", cache_size);
+static void _init(void) {
+    int cls;
 
-    return (0);
+    for(cls = 0; cls <= ALLOC_CACHE_CLASSES; cls++) {
+        pthread_mutex_init(&_depot[cls].mutex, NULL);
+        _depot[cls].batches = NULL;
+        memset(&_depot[cls].stats, 0, sizeof(dsr_alloc_cache_stats_t));
+        _depot[cls].stats.size = (cls < ALLOC_CACHE_CLASSES) ? _class_sizes[cls] : 0;
+    }
+
+    pthread_key_create(&_thread_key, _thread_exit);
 }
-#endif
 
-static inline dessert_msg_t* alloc() {
-    dessert_msg_t* ptr;
+/* the key destructor flushes the magazines when the thread exits */
+static inline void _register_thread(void) {
+    pthread_once(&_init_once, _init);
+    pthread_setspecific(_thread_key, _magazines);
+    _thread_registered = 1;
+}
 
-    pthread_mutex_lock(&_alloc_mutex); 	/* LOCK */
+static inline int _size_to_class(size_t size) {
+    int cls;
 
-#ifdef CACHE_STATISTICS
-    cache_allocs++;
-#endif
+    for(cls = 0; cls < ALLOC_CACHE_CLASSES; cls++) {
+        if(size <= _class_sizes[cls]) {
+            return cls;
+        }
+    }
 
-    if(unlikely(ll_len == 0)) {
-        ptr = malloc(CHUNK_SIZE);
-#ifdef CACHE_STATISTICS
-        cache_underrun++;
-        cache_size++;
-#endif
-        assert(ptr != NULL);
+    return ALLOC_CACHE_BIG;
+}
+
+/** moves one chain from the depot into the empty magazine of class cls */
+static void _refill(int cls) {
+    depot_t* depot = &_depot[cls];
+    magazine_t* mag = &_magazines[cls];
+
+    pthread_mutex_lock(&depot->mutex); 	/* LOCK */
+
+    if(likely(depot->batches != NULL)) {
+        mag->head = depot->batches;
+        mag->len = ALLOC_CACHE_BATCH;
+        depot->batches = depot->batches->next_batch;
+        depot->stats.depot_len -= ALLOC_CACHE_BATCH;
+        depot->stats.refills++;
+    }
+
+    pthread_mutex_unlock(&depot->mutex); /* UNLOCK */
+}
+
+/** moves the first ALLOC_CACHE_BATCH buffers of the magazine of class cls to the depot */
+static void _return_batch(int cls) {
+    depot_t* depot = &_depot[cls];
+    magazine_t* mag = &_magazines[cls];
+    el_t* chain = mag->head;
+    el_t* tail = chain;
+    int i;
+
+    for(i = 1; i < ALLOC_CACHE_BATCH; i++) {
+        tail = tail->next;
+    }
+
+    mag->head = tail->next;
+    mag->len -= ALLOC_CACHE_BATCH;
+    tail->next = NULL;
+
+    pthread_mutex_lock(&depot->mutex); 	/* LOCK */
+
+    if(likely(depot->stats.depot_len + ALLOC_CACHE_BATCH <= CACHE_SIZE)) {
+        chain->next_batch = depot->batches;
+        depot->batches = chain;
+        depot->stats.depot_len += ALLOC_CACHE_BATCH;
+        depot->stats.returns++;
+
+        if(depot->stats.depot_len > depot->stats.depot_max) {
+            depot->stats.depot_max = depot->stats.depot_len;
+        }
+
+        chain = NULL;
     }
     else {
-        ptr = (dessert_msg_t*)ll_head;
-        ll_head = ll_head->next;
-        ll_len--;
+        __sync_fetch_and_add(&depot->stats.overflow, ALLOC_CACHE_BATCH);
     }
 
-    pthread_mutex_unlock(&_alloc_mutex); /* UNLOCK */
+    pthread_mutex_unlock(&depot->mutex); /* UNLOCK */
 
-    return ptr;
+    while(chain) {
+        el_t* el = chain;
+        chain = el->next;
+        free(((alloc_hdr_t*) el) - 1);
+    }
 }
 
-static inline void dealloc(dessert_msg_t* ptr) {
+/** allocates a buffer of at least size bytes from the cache
+ * @arg size number of usable bytes
+ * @return the buffer, to be released with dsr_alloc_cache_free
+ **/
+void* dsr_alloc_cache_alloc(size_t size) {
+    int cls = _size_to_class(size);
+    magazine_t* mag;
+    alloc_hdr_t* hdr;
+    el_t* el;
+
+    if(unlikely(!_thread_registered)) {
+        _register_thread();
+    }
 
-    pthread_mutex_lock(&_alloc_mutex); 	/* LOCK */
+    _STAT_INC(cls, allocs);
 
-#ifdef CACHE_STATISTICS
-    cache_deallocs++;
-#endif
+    if(unlikely(cls == ALLOC_CACHE_BIG)) {
+        hdr = malloc(sizeof(alloc_hdr_t) + size);
+        assert(hdr != NULL);
+        hdr->cls = cls;
+        __sync_fetch_and_add(&_depot[cls].stats.underrun, 1);
+        return hdr + 1;
+    }
 
-    if(unlikely(ll_len >= CACHE_SIZE)) {
-        free(ptr);
-#ifdef CACHE_STATISTICS
-        cache_overflow++;
-        cache_size--;
-#endif
+    mag = &_magazines[cls];
+
+    if(unlikely(mag->head == NULL)) {
+        _refill(cls);
+
+        if(mag->head == NULL) {
+            hdr = malloc(sizeof(alloc_hdr_t) + _class_sizes[cls]);
+            assert(hdr != NULL);
+            hdr->cls = cls;
+            __sync_fetch_and_add(&_depot[cls].stats.underrun, 1);
+            return hdr + 1;
+        }
     }
-    else {
-        ((el_t*) ptr)->next = ll_head;
-        ll_head = (el_t*) ptr;
-        ll_len++;
+
+    el = mag->head;
+    mag->head = el->next;
+    mag->len--;
+
+    return el;
+}
+
+/** returns a buffer to the cache of the calling thread
+ * @arg *ptr buffer from dsr_alloc_cache_alloc, possibly of another thread
+ **/
+void dsr_alloc_cache_free(void* ptr) {
+    alloc_hdr_t* hdr = ((alloc_hdr_t*) ptr) - 1;
+    int cls = hdr->cls;
+    magazine_t* mag;
+    el_t* el = ptr;
+
+    if(unlikely(!_thread_registered)) {
+        _register_thread();
+    }
+
+    _STAT_INC(cls, deallocs);
+
+    if(unlikely(cls == ALLOC_CACHE_BIG)) {
+        free(hdr);
+        __sync_fetch_and_add(&_depot[cls].stats.overflow, 1);
+        return;
+    }
+
+    mag = &_magazines[cls];
+    el->next = mag->head;
+    mag->head = el;
+    mag->len++;
+
+    if(unlikely(mag->len >= ALLOC_CACHE_MAGAZINE_SIZE)) {
+        _return_batch(cls);
+    }
+}
+
+/** copies the counters of all size classes
+ * @arg stats (out) one entry per class plus one for plain malloc allocations
+ **/
+void dsr_alloc_cache_get_stats(dsr_alloc_cache_stats_t stats[ALLOC_CACHE_CLASSES + 1]) {
+    int cls;
+
+    pthread_once(&_init_once, _init);
+
+    for(cls = 0; cls <= ALLOC_CACHE_CLASSES; cls++) {
+        pthread_mutex_lock(&_depot[cls].mutex);
+        stats[cls] = _depot[cls].stats;
+        pthread_mutex_unlock(&_depot[cls].mutex);
+    }
+}
+
 #ifdef CACHE_STATISTICS
+int cache_statistics(void* data, struct timeval* scheduled,
+                     struct timeval* interval) {
+    dsr_alloc_cache_stats_t stats[ALLOC_CACHE_CLASSES + 1];
+    int cls;
 
-        if(ll_len > cache_max) {
-            cache_max = ll_len;
-        }
+    dsr_alloc_cache_get_stats(stats);
+
+    for(cls = 0; cls <= ALLOC_CACHE_CLASSES; cls++) {
+        dessert_info(" size: %5zu  allocs: %.10u  deallocs: %.10u  depot: %u/%u ",
+                     stats[cls].size, stats[cls].allocs, stats[cls].deallocs, stats[cls].depot_len, stats[cls].depot_max);
+        dessert_info(" refills: %.10u  returns: %.10u  underrun: %.10u  overflow: %.10u",
+                     stats[cls].refills, stats[cls].returns, stats[cls].underrun, stats[cls].overflow);
+    }
 
+    return (0);
+}
+#endif
+
+/* the last class, size 0, counts the buffers too large for the cache */
+int dessert_cli_cmd_showalloccache(struct cli_def* cli, char* command, char* argv[], int argc) {
+    dsr_alloc_cache_stats_t stats[ALLOC_CACHE_CLASSES + 1];
+    int cls;
+
+    dsr_alloc_cache_get_stats(stats);
+
+    for(cls = 0; cls <= ALLOC_CACHE_CLASSES; cls++) {
+        cli_print(cli, "class[%i] size[%zu] refills[%u] returns[%u] underrun[%u] overflow[%u] depot[%u] depot_max[%u]",
+                  cls, stats[cls].size, stats[cls].refills, stats[cls].returns, stats[cls].underrun,
+                  stats[cls].overflow, stats[cls].depot_len, stats[cls].depot_max);
+#ifdef CACHE_STATISTICS
+        cli_print(cli, "         allocs[%u] deallocs[%u]", stats[cls].allocs, stats[cls].deallocs);
 #endif
     }
 
-    pthread_mutex_unlock(&_alloc_mutex); /* UNLOCK */
+    return CLI_OK;
 }
 
 /** generates a copy of a dessert_msg
  * @arg **msgnew (out) pointer to return message address
  * @arg *msgold pointer to the message to clone
- * @arg sparse whether to allocate DESSERT_MAXFRAMELEN or only hlen+plen
+ * @arg sparse whether to allocate CHUNK_SIZE or only hlen+plen
  * @return DESSERT_OK on success, -errno otherwise
  **/
-int dsr_dessert_msg_clone(dessert_msg_t** msgnew, const dessert_msg_t* msgold) {
+int dsr_dessert_msg_clone(dessert_msg_t** msgnew, const dessert_msg_t* msgold, int sparse) {
 
     dessert_msg_t* msg;
     size_t msglen = ntohs(msgold->hlen) + ntohs(msgold->plen);
 
-    msg = alloc(CHUNK_SIZE);
+    msg = dsr_alloc_cache_alloc((sparse || msglen > CHUNK_SIZE) ? msglen : CHUNK_SIZE);
 
     if(msg == NULL) {
         return (DESSERT_ERR);
@@ -119,6 +314,10 @@ int dsr_dessert_msg_clone(dessert_msg_t** msgnew, const dessert_msg_t* msgold) {
 
     msg->flags &= DESSERT_RX_FLAG_SPARSE ^ DESSERT_RX_FLAG_SPARSE;
 
+    if(sparse) {
+        msg->flags |= DESSERT_RX_FLAG_SPARSE;
+    }
+
     *msgnew = msg;
     return (DESSERT_OK);
 }
@@ -130,7 +329,7 @@ int dsr_dessert_msg_clone(dessert_msg_t** msgnew, const dessert_msg_t* msgold) {
 int dsr_dessert_msg_new(dessert_msg_t** msgout) {
     dessert_msg_t* msg;
 
-    msg = alloc(CHUNK_SIZE);
+    msg = dsr_alloc_cache_alloc(CHUNK_SIZE);
 
     if(msg == NULL) {
         dessert_err("failed to allocate buffer for new message!");
@@ -157,7 +356,6 @@ int dsr_dessert_msg_new(dessert_msg_t** msgout) {
  * @arg *msg message to free
  **/
 void dsr_dessert_msg_destroy(dessert_msg_t* msg) {
-    dealloc(msg);
+    dsr_alloc_cache_free(msg);
 }
 
-
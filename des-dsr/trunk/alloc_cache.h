@@ -4,24 +4,55 @@
 
 #include "dsr.h"
 
+//#define CHUNK_SIZE DESSERT_MAXFRAMELEN
+// \todo remove magic number
+#define CHUNK_SIZE 2500
+
+/* usable buffer sizes of the size classes, ascending; larger requests go to malloc.
+ * Messages are only created and cloned with CHUNK_SIZE buffers, smaller classes
+ * would only pay off for sparse clones. */
+#define ALLOC_CACHE_CLASS_SIZES { CHUNK_SIZE }
+#define ALLOC_CACHE_CLASSES 1
+
+/* buffers moved between a thread's magazine and the shared depot at once */
+#define ALLOC_CACHE_BATCH 32
+/* a thread returns a batch to the depot when its magazine holds this many buffers */
+#define ALLOC_CACHE_MAGAZINE_SIZE (2 * ALLOC_CACHE_BATCH)
+/* buffers kept in the depot per class; surplus batches are freed */
+#define CACHE_SIZE 512
+
+typedef struct dsr_alloc_cache_stats {
+    size_t size;            /* usable buffer size */
+    uint32_t refills;       /* batches handed from the depot to a thread */
+    uint32_t returns;       /* batches handed from a thread to the depot */
+    uint32_t underrun;      /* buffers allocated with malloc */
+    uint32_t overflow;      /* buffers released with free */
+    uint32_t depot_len;     /* buffers currently in the depot */
+    uint32_t depot_max;
 #ifdef CACHE_STATISTICS
-extern int cache_allocs;
-extern int cache_underrun;
-extern int cache_deallocs;
-extern int cache_overflow;
-extern int cache_max;
-extern int cache_mean;
+    uint32_t allocs;
+    uint32_t deallocs;
+#endif
+} dsr_alloc_cache_stats_t;
 
+#ifdef CACHE_STATISTICS
 int cache_statistics(void* data, struct timeval* scheduled,
                      struct timeval* interval);
 #endif
 
-int dsr_dessert_msg_clone(dessert_msg_t** msgnew, const dessert_msg_t* msgold);
+void* dsr_alloc_cache_alloc(size_t size);
+void dsr_alloc_cache_free(void* ptr);
+/* class index ALLOC_CACHE_CLASSES collects the requests served by plain malloc */
+void dsr_alloc_cache_get_stats(dsr_alloc_cache_stats_t stats[ALLOC_CACHE_CLASSES + 1]);
+
+int dsr_dessert_msg_clone(dessert_msg_t** msgnew, const dessert_msg_t* msgold, int sparse);
 int dsr_dessert_msg_new(dessert_msg_t** msgout);
 void dsr_dessert_msg_destroy(dessert_msg_t* msg);
 
+int dessert_cli_cmd_showalloccache(struct cli_def* cli, char* command, char* argv[], int argc);
+
 
-#define dessert_msg_clone(a,b,s) dsr_dessert_msg_clone(a,b)
+#define dessert_msg_clone(a,b,s) dsr_dessert_msg_clone(a,b,s)
 #define dessert_msg_new(m) dsr_dessert_msg_new(m)
 #define dessert_msg_destroy(m) dsr_dessert_msg_destroy(m)
 
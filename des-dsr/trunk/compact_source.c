@@ -0,0 +1,653 @@
+/******************************************************************************
+ Copyright 2010, David Gutzmann, Freie Universitaet Berlin (FUB).
+ All rights reserved.
+
+ These sources were originally developed by David Gutzmann
+ at Freie Universitaet Berlin (http://www.fu-berlin.de/),
+ Computer Systems and Telematics / Distributed, Embedded Systems (DES) group
+ (http://cst.mi.fu-berlin.de/, http://www.des-testbed.net/)
+ ------------------------------------------------------------------------------
+ This program is free software: you can redistribute it and/or modify it under
+ the terms of the GNU General Public License as published by the Free Software
+ Foundation, either version 3 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with
+ this program. If not, see http://www.gnu.org/licenses/ .
+ ------------------------------------------------------------------------------
+ For further information and questions please use the web site
+ http://www.des-testbed.net/
+ ------------------------------------------------------------------------------
+
+ ******************************************************************************/
+
+#include "dsr.h"
+
+/* id table */
+dsr_compact_source_node_t* _dsr_compact_source_nodes = NULL;
+pthread_rwlock_t _dsr_compact_source_nodes_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+#define _NODES_READLOCK pthread_rwlock_rdlock(&_dsr_compact_source_nodes_rwlock)
+#define _NODES_WRITELOCK pthread_rwlock_wrlock(&_dsr_compact_source_nodes_rwlock)
+#define _NODES_UNLOCK pthread_rwlock_unlock(&_dsr_compact_source_nodes_rwlock)
+
+/* flows of other sources by first address and flow id, own flows by route */
+dsr_compact_source_flow_t* _dsr_compact_source_flows = NULL;
+dsr_compact_source_flow_t* _dsr_compact_source_own_flows = NULL;
+pthread_mutex_t _dsr_compact_source_flows_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define _FLOWS_LOCK pthread_mutex_lock(&_dsr_compact_source_flows_mutex)
+#define _FLOWS_UNLOCK pthread_mutex_unlock(&_dsr_compact_source_flows_mutex)
+
+#define _COUNT(field, n) __atomic_fetch_add(&_stats.field, (n), __ATOMIC_RELAXED)
+
+static uint16_t _next_flow = 0;
+static dsr_compact_source_stats_t _stats;
+
+static inline int _learn(const uint8_t* address, int len, int write);
+static inline int _resolve(uint16_t id, uint8_t address[ETHER_ADDR_LEN]);
+static inline int _decode(const dsr_compact_source_ext_t* compact, int install, dsr_path_t* path);
+static inline void _install_flow(const uint8_t source[ETHER_ADDR_LEN], uint16_t flow_id, const uint8_t* address, int len, const struct timeval* now);
+static inline void _flow_key(uint8_t key[ETHER_ADDR_LEN + sizeof(uint16_t)], const uint8_t source[ETHER_ADDR_LEN], uint16_t flow_id);
+static inline int _is_confirmed(const uint8_t source[ETHER_ADDR_LEN], uint16_t flow_id);
+static inline int _add_compact(dessert_msg_t* msg, const dsr_compact_source_ext_t* compact);
+static inline void _set_ids(dsr_compact_source_ext_t* compact, const dsr_source_ext_t* source, int hops);
+
+/** FNV-1a over the address, folded to 16 bits */
+uint16_t dsr_compact_source_id(const uint8_t address[ETHER_ADDR_LEN]) {
+    uint32_t hash = 2166136261u;
+    int i;
+
+    for(i = 0; i < ETHER_ADDR_LEN; i++) {
+        hash = (hash ^ address[i]) * 16777619u;
+    }
+
+    return (uint16_t)((hash >> 16) ^ hash);
+}
+
+int dsr_compact_source_learn(const uint8_t* address, int len) {
+    int ambiguous;
+
+    /* mostly the addresses are known already */
+    _NODES_READLOCK;
+    ambiguous = _learn(address, len, 0);
+    _NODES_UNLOCK;
+
+    if(ambiguous < 0) {
+        _NODES_WRITELOCK;
+        ambiguous = _learn(address, len, 1);
+        _NODES_UNLOCK;
+    }
+
+    return ambiguous;
+}
+
+int dsr_compact_source_resolve(uint16_t id, uint8_t address[ETHER_ADDR_LEN]) {
+    int res;
+
+    _NODES_READLOCK;
+    res = _resolve(id, address);
+    _NODES_UNLOCK;
+
+    return res;
+}
+
+/** Called with the DSR_EXT_SOURCE in place and the next hop set, before the
+ *  msg is counted and sent. @a originated is 0 for a msg forwarded as a relay:
+ *  if it arrived compact the DSR_EXT_SOURCE decoded from it is removed again,
+ *  otherwise it is sent unchanged. A relay sends a FLOW msg as IDS (or FULL)
+ *  as long as its next hop has not acknowledged a msg of the flow. */
+int dsr_msg_compact_source_ext(dessert_msg_t* msg, int originated) {
+    dessert_ext_t* source_ext;
+    dessert_ext_t* ext;
+    dsr_source_ext_t* source;
+    dsr_compact_source_ext_t compact;
+    dsr_compact_source_flow_t* flow = NULL;
+    struct timeval now;
+    size_t full_len, compact_len;
+    int mode, hops, form;
+
+    if(!dessert_msg_getext(msg, &source_ext, DSR_EXT_SOURCE, 0)) {
+        return DSR_COMPACT_SOURCE_FORM_FULL;
+    }
+
+    source = (dsr_source_ext_t*) source_ext->data;
+
+    if(dessert_msg_getext(msg, &ext, DSR_EXT_COMPACT_SOURCE, 0)) {
+        dsr_compact_source_ext_t* in = (dsr_compact_source_ext_t*) ext->data;
+        form = in->flags & DSR_COMPACT_SOURCE_FORM_MASK;
+
+        if(form == DSR_COMPACT_SOURCE_FORM_FULL) {
+            return form;
+        }
+
+        in->flags = (source->flags & ~DSR_COMPACT_SOURCE_FORM_MASK) | form;
+        in->salvage = source->salvage;
+        in->segments_left = source->segments_left;
+
+        if(form == DSR_COMPACT_SOURCE_FORM_FLOW && dsr_conf_get_compact_source() == DSR_COMPACT_SOURCE_FLOWS
+           && !_is_confirmed(in->source, ntohs(in->flow))) {
+            /* the next hop may have missed the msgs with the route */
+            hops = dsr_source_get_address_count(source);
+            memcpy(&compact, in, DSR_COMPACT_SOURCE_EXTENSION_HDRLEN);
+            compact.flags = (compact.flags & ~DSR_COMPACT_SOURCE_FORM_MASK) | DSR_COMPACT_SOURCE_FORM_IDS;
+            _set_ids(&compact, source, hops);
+
+            if(dsr_compact_source_learn(source->address, hops) > 0 || _add_compact(msg, &compact) != DSR_COMPACT_SOURCE_SUCCESS) {
+                in->flags = (in->flags & ~DSR_COMPACT_SOURCE_FORM_MASK) | DSR_COMPACT_SOURCE_FORM_FULL;
+                return DSR_COMPACT_SOURCE_FORM_FULL;
+            }
+
+            /* the first one is the extension the msg arrived with */
+            dessert_msg_getext(msg, &ext, DSR_EXT_COMPACT_SOURCE, 0);
+            dessert_msg_delext(msg, ext);
+            return DSR_COMPACT_SOURCE_FORM_IDS;
+        }
+
+        dessert_msg_delext(msg, source_ext);
+        return form;
+    }
+
+    mode = dsr_conf_get_compact_source();
+
+    /* data msgs only, route discovery and errors keep the full route */
+    if(!originated || mode == DSR_COMPACT_SOURCE_OFF || !dessert_msg_getext(msg, &ext, DESSERT_EXT_ETH, 0)) {
+        return DSR_COMPACT_SOURCE_FORM_FULL;
+    }
+
+    hops = dsr_source_get_address_count(source);
+    full_len = DESSERT_EXTLEN + DSR_SOURCE_EXTENSION_HDRLEN + hops * ETHER_ADDR_LEN;
+
+    /* the receivers add the DSR_EXT_SOURCE to the compact one again */
+    if(hops < 2 || ntohs(msg->hlen) + ntohs(msg->plen) + DESSERT_EXTLEN + DSR_COMPACT_SOURCE_EXTENSION_HDRLEN
+       + (hops - 1) * sizeof(uint16_t) > DESSERT_MAXFRAMELEN) {
+        _COUNT(sent[DSR_COMPACT_SOURCE_FORM_FULL], 1);
+        _COUNT(bytes_full, full_len);
+        _COUNT(bytes_sent, full_len);
+        return DSR_COMPACT_SOURCE_FORM_FULL;
+    }
+
+    gettimeofday(&now, NULL);
+
+    _FLOWS_LOCK;
+    HASH_FIND(hh, _dsr_compact_source_own_flows, source->address, hops * ETHER_ADDR_LEN, flow);
+
+    if(flow == NULL) {
+        flow = malloc(sizeof(dsr_compact_source_flow_t));
+        assert(flow != NULL);
+        flow->len = hops;
+        ADDR_N_CPY(flow->address, source->address, hops);
+        flow->packets = 0;
+        flow->confirmed = 0;
+        HASH_ADD(hh, _dsr_compact_source_own_flows, address, hops * ETHER_ADDR_LEN, flow);
+        _stats.own_flows++;
+    }
+    else if(now.tv_sec - flow->last_used.tv_sec >= DSR_CONFVAR_COMPACT_SOURCE_FLOW_TIMEOUT_SECS / 2) {
+        /* the relays may forget the flow before its next msg */
+        flow->packets = 0;
+    }
+
+    if(flow->packets == 0) {
+        if(++_next_flow == 0) {
+            ++_next_flow;
+        }
+
+        flow->flow = _next_flow;
+        flow->confirmed = 0;
+        form = DSR_COMPACT_SOURCE_FORM_FULL;
+    }
+    else if(mode == DSR_COMPACT_SOURCE_FLOWS && flow->confirmed
+            && flow->packets % DSR_CONFVAR_COMPACT_SOURCE_REFRESH_PACKETS != 0) {
+        form = DSR_COMPACT_SOURCE_FORM_FLOW;
+    }
+    else {
+        form = DSR_COMPACT_SOURCE_FORM_IDS;
+    }
+
+    flow->packets++;
+    flow->last_used = now;
+    compact.flow = (mode == DSR_COMPACT_SOURCE_FLOWS) ? htons(flow->flow) : 0;
+
+    if(mode == DSR_COMPACT_SOURCE_FLOWS) {
+        /* to decode the passive ACKs of the next hop */
+        _install_flow(source->address, flow->flow, source->address, hops, &now);
+    }
+
+    _FLOWS_UNLOCK;
+
+    /* a flow needs no ids; an id shared with another node is not sent */
+    if(form != DSR_COMPACT_SOURCE_FORM_FLOW && dsr_compact_source_learn(source->address, hops) > 0) {
+        form = DSR_COMPACT_SOURCE_FORM_FULL;
+    }
+
+    _COUNT(bytes_full, full_len);
+
+    if(form == DSR_COMPACT_SOURCE_FORM_FULL && mode == DSR_COMPACT_SOURCE_IDS) {
+        _COUNT(sent[form], 1);
+        _COUNT(bytes_sent, full_len);
+        return form;
+    }
+
+    compact.flags = (source->flags & ~DSR_COMPACT_SOURCE_FORM_MASK) | form;
+    compact.salvage = source->salvage;
+    compact.segments_left = source->segments_left;
+    compact.len = 0;
+    ADDR_CPY(compact.source, source->address);
+
+    if(form == DSR_COMPACT_SOURCE_FORM_IDS) {
+        _set_ids(&compact, source, hops);
+    }
+
+    if(_add_compact(msg, &compact) != DSR_COMPACT_SOURCE_SUCCESS) {
+        dessert_debug("COMPACT_SOURCE: no room for the extension, the route is sent in full");
+        _COUNT(sent[DSR_COMPACT_SOURCE_FORM_FULL], 1);
+        _COUNT(bytes_sent, full_len);
+        return DSR_COMPACT_SOURCE_FORM_FULL;
+    }
+
+    compact_len = DSR_COMPACT_SOURCE_EXTENSION_HDRLEN + compact.len * sizeof(uint16_t);
+    _COUNT(sent[form], 1);
+    _COUNT(bytes_sent, DESSERT_EXTLEN + compact_len + ((form == DSR_COMPACT_SOURCE_FORM_FULL) ? full_len : 0));
+
+    return form;
+}
+
+void dsr_compact_source_confirm(const dessert_msg_t* msg) {
+    dessert_ext_t* ext;
+    dsr_compact_source_flow_t* flow = NULL;
+
+    if(dsr_conf_get_compact_source() != DSR_COMPACT_SOURCE_FLOWS || !dessert_msg_getext(msg, &ext, DESSERT_EXT_ETH, 0)) {
+        return;
+    }
+
+    _FLOWS_LOCK;
+
+    if(dessert_msg_getext(msg, &ext, DSR_EXT_COMPACT_SOURCE, 0)) {
+        /* forwarded as a relay */
+        dsr_compact_source_ext_t* compact = (dsr_compact_source_ext_t*) ext->data;
+        uint8_t key[ETHER_ADDR_LEN + sizeof(uint16_t)];
+
+        _flow_key(key, compact->source, ntohs(compact->flow));
+        HASH_FIND(hh, _dsr_compact_source_flows, key, sizeof(key), flow);
+    }
+    else if(dessert_msg_getext(msg, &ext, DSR_EXT_SOURCE, 0)) {
+        /* originated, buffered before the DSR_EXT_SOURCE was replaced */
+        dsr_source_ext_t* source = (dsr_source_ext_t*) ext->data;
+
+        HASH_FIND(hh, _dsr_compact_source_own_flows, source->address, dsr_source_get_address_count(source) * ETHER_ADDR_LEN, flow);
+    }
+
+    if(flow != NULL) {
+        flow->confirmed = 1;
+    }
+
+    _FLOWS_UNLOCK;
+}
+
+void dsr_compact_source_get_stats(dsr_compact_source_stats_t* stats) {
+    _NODES_READLOCK;
+    _FLOWS_LOCK;
+    *stats = _stats;
+    _FLOWS_UNLOCK;
+    _NODES_UNLOCK;
+}
+
+/******************************************************************************
+ *
+ * Callbacks --
+ *
+ ******************************************************************************/
+
+/** Turns a DSR_EXT_COMPACT_SOURCE back into a DSR_EXT_SOURCE, after the
+ *  statistics have counted the msg as received and before anything else
+ *  looks at the route. Installs the flows of msgs for this node. */
+dessert_cb_result compact_source_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, dessert_meshif_t* iface, dessert_frameid_t id) {
+    dessert_ext_t* compact_ext;
+    dessert_ext_t* source_ext;
+    dsr_compact_source_ext_t* compact;
+    dsr_source_ext_t* source;
+    dsr_path_t path;
+    struct timeval now;
+    uint8_t flags, salvage, segments_left;
+    int install = (proc->lflags & DESSERT_RX_FLAG_L2_DST) ? 1 : 0;
+    int form, res;
+
+    if(!dessert_msg_getext(msg, &compact_ext, DSR_EXT_COMPACT_SOURCE, 0)) {
+        if(dsr_conf_get_compact_source() != DSR_COMPACT_SOURCE_OFF && dessert_msg_getext(msg, &source_ext, DSR_EXT_SOURCE, 0)) {
+            source = (dsr_source_ext_t*) source_ext->data;
+            dsr_compact_source_learn(source->address, dsr_source_get_address_count(source));
+        }
+
+        return DESSERT_MSG_KEEP;
+    }
+
+    if(dessert_ext_getdatalen(compact_ext) < DSR_COMPACT_SOURCE_EXTENSION_HDRLEN) {
+        dessert_warn("COMPACT_SOURCE[%"PRIi64"]: malformed extension from " MAC, id, EXPLODE_ARRAY6(msg->l2h.ether_shost));
+        return DESSERT_MSG_DROP;
+    }
+
+    compact = (dsr_compact_source_ext_t*) compact_ext->data;
+    form = compact->flags & DSR_COMPACT_SOURCE_FORM_MASK;
+
+    if(dessert_msg_getext(msg, &source_ext, DSR_EXT_SOURCE, 0)) {
+        /* the first msg of a flow or a retransmission */
+        source = (dsr_source_ext_t*) source_ext->data;
+        dsr_compact_source_learn(source->address, dsr_source_get_address_count(source));
+
+        if(compact->flow != 0 && install) {
+            gettimeofday(&now, NULL);
+            _FLOWS_LOCK;
+            _install_flow(compact->source, ntohs(compact->flow), source->address, dsr_source_get_address_count(source), &now);
+            _FLOWS_UNLOCK;
+        }
+
+        _COUNT(received[DSR_COMPACT_SOURCE_FORM_FULL], 1);
+        return DESSERT_MSG_KEEP;
+    }
+
+    if(proc->lflags & DESSERT_RX_FLAG_SPARSE) {
+        return DESSERT_MSG_NEEDNOSPARSE;
+    }
+
+    if(dessert_ext_getdatalen(compact_ext) < DSR_COMPACT_SOURCE_EXTENSION_HDRLEN + compact->len * sizeof(uint16_t)
+       || compact->len > DSR_COMPACT_SOURCE_MAX_IDS_IN_OPTION
+       || (form == DSR_COMPACT_SOURCE_FORM_IDS && compact->len == 0)) {
+        dessert_warn("COMPACT_SOURCE[%"PRIi64"]: malformed extension from " MAC, id, EXPLODE_ARRAY6(msg->l2h.ether_shost));
+        return DESSERT_MSG_DROP;
+    }
+
+    _COUNT(received[form], 1);
+    res = _decode(compact, install, &path);
+
+    if(res != DSR_COMPACT_SOURCE_SUCCESS) {
+        if(res == DSR_COMPACT_SOURCE_ERROR_UNKNOWN_ID) {
+            _COUNT(unknown_ids, 1);
+        }
+        else if(res == DSR_COMPACT_SOURCE_ERROR_AMBIGUOUS_ID) {
+            _COUNT(ambiguous_ids, 1);
+        }
+        else {
+            _COUNT(unknown_flows, 1);
+        }
+
+        dessert_debug("COMPACT_SOURCE[%"PRIi64"]: cannot decode the route from " MAC " (%i), dropped", id, EXPLODE_ARRAY6(compact->source), res);
+        return DESSERT_MSG_DROP;
+    }
+
+    flags = compact->flags & ~DSR_COMPACT_SOURCE_FORM_MASK;
+    salvage = compact->salvage;
+    segments_left = compact->segments_left;
+
+    source = dsr_msg_add_source_ext(msg, &path, segments_left);
+
+    if(source == NULL) {
+        dessert_warn("COMPACT_SOURCE[%"PRIi64"]: no room for the DSR_EXT_SOURCE, dropped", id);
+        return DESSERT_MSG_DROP;
+    }
+
+    source->flags = flags;
+    source->salvage = salvage;
+
+    return DESSERT_MSG_KEEP;
+}
+
+/******************************************************************************
+ *
+ * Periodic tasks --
+ *
+ ******************************************************************************/
+
+dessert_per_result_t cleanup_compact_source(void* data, struct timeval* scheduled, struct timeval* interval) {
+    dsr_compact_source_flow_t* flow = NULL;
+    dsr_compact_source_flow_t* tmp = NULL;
+    struct timeval now;
+    time_t expiration_threshold;
+
+    gettimeofday(&now, NULL);
+    expiration_threshold = now.tv_sec - (time_t) DSR_CONFVAR_COMPACT_SOURCE_FLOW_TIMEOUT_SECS;
+
+    _FLOWS_LOCK;
+
+    HASH_ITER(hh, _dsr_compact_source_flows, flow, tmp) {
+        if(flow->last_used.tv_sec < expiration_threshold) {
+            HASH_DELETE(hh, _dsr_compact_source_flows, flow);
+            free(flow);
+            _stats.flows--;
+        }
+    }
+
+    HASH_ITER(hh, _dsr_compact_source_own_flows, flow, tmp) {
+        if(flow->last_used.tv_sec < expiration_threshold) {
+            HASH_DELETE(hh, _dsr_compact_source_own_flows, flow);
+            free(flow);
+            _stats.own_flows--;
+        }
+    }
+
+    _FLOWS_UNLOCK;
+
+    return DESSERT_PER_KEEP;
+}
+
+/******************************************************************************
+ *
+ * C L I --
+ *
+ ******************************************************************************/
+
+int dessert_cli_cmd_showcompactsource(struct cli_def* cli, char* command, char* argv[], int argc) {
+    dsr_compact_source_stats_t s;
+
+    dsr_compact_source_get_stats(&s);
+
+    cli_print(cli, "mode[%i] nodes[%"PRIu64"] ambiguous ids[%"PRIu64"] flows[%"PRIu64"] own flows[%"PRIu64"]",
+              dsr_conf_get_compact_source(), s.nodes, s.ambiguous, s.flows, s.own_flows);
+    cli_print(cli, "sent full[%"PRIu64"] ids[%"PRIu64"] flow[%"PRIu64"] source route bytes[%"PRIu64"] of [%"PRIu64"] as DSR_EXT_SOURCE",
+              s.sent[DSR_COMPACT_SOURCE_FORM_FULL], s.sent[DSR_COMPACT_SOURCE_FORM_IDS], s.sent[DSR_COMPACT_SOURCE_FORM_FLOW],
+              s.bytes_sent, s.bytes_full);
+    cli_print(cli, "received full[%"PRIu64"] ids[%"PRIu64"] flow[%"PRIu64"] dropped unknown ids[%"PRIu64"] ambiguous ids[%"PRIu64"] unknown flows[%"PRIu64"]",
+              s.received[DSR_COMPACT_SOURCE_FORM_FULL], s.received[DSR_COMPACT_SOURCE_FORM_IDS], s.received[DSR_COMPACT_SOURCE_FORM_FLOW],
+              s.unknown_ids, s.ambiguous_ids, s.unknown_flows);
+
+    return CLI_OK;
+}
+
+/******************************************************************************
+ *
+ * LOCAL
+ *
+ ******************************************************************************/
+
+/** -1 if @a write is not set and the table has to change */
+static inline int _learn(const uint8_t* address, int len, int write) {
+    dsr_compact_source_node_t* node;
+    int ambiguous = 0;
+    int i;
+
+    for(i = 0; i < len; i++) {
+        const uint8_t* a = address + i * ETHER_ADDR_LEN;
+        uint16_t id = dsr_compact_source_id(a);
+
+        node = NULL;
+        HASH_FIND(hh, _dsr_compact_source_nodes, &id, sizeof(id), node);
+
+        if(node == NULL) {
+            if(!write) {
+                return -1;
+            }
+
+            node = malloc(sizeof(dsr_compact_source_node_t));
+            assert(node != NULL);
+            node->id = id;
+            ADDR_CPY(node->address, a);
+            node->ambiguous = 0;
+            HASH_ADD(hh, _dsr_compact_source_nodes, id, sizeof(id), node);
+            _stats.nodes++;
+        }
+        else if(!node->ambiguous && ADDR_CMP(node->address, a) != 0) {
+            if(!write) {
+                return -1;
+            }
+
+            dessert_info("COMPACT_SOURCE: " MAC " and " MAC " share the id %04x, it is not used", EXPLODE_ARRAY6(node->address), EXPLODE_ARRAY6(a), id);
+            node->ambiguous = 1;
+            _stats.ambiguous++;
+        }
+
+        if(node->ambiguous) {
+            ambiguous++;
+        }
+    }
+
+    return ambiguous;
+}
+
+static inline int _resolve(uint16_t id, uint8_t address[ETHER_ADDR_LEN]) {
+    dsr_compact_source_node_t* node = NULL;
+
+    HASH_FIND(hh, _dsr_compact_source_nodes, &id, sizeof(id), node);
+
+    if(node == NULL) {
+        return DSR_COMPACT_SOURCE_ERROR_UNKNOWN_ID;
+    }
+
+    if(node->ambiguous) {
+        return DSR_COMPACT_SOURCE_ERROR_AMBIGUOUS_ID;
+    }
+
+    ADDR_CPY(address, node->address);
+    return DSR_COMPACT_SOURCE_SUCCESS;
+}
+
+/** the route of @a compact, from the id table or the flows */
+static inline int _decode(const dsr_compact_source_ext_t* compact, int install, dsr_path_t* path) {
+    dsr_compact_source_flow_t* flow = NULL;
+    uint8_t key[ETHER_ADDR_LEN + sizeof(uint16_t)];
+    uint16_t flow_id = ntohs(compact->flow);
+    struct timeval now;
+    int res = DSR_COMPACT_SOURCE_SUCCESS;
+    int i;
+
+    gettimeofday(&now, NULL);
+
+    if((compact->flags & DSR_COMPACT_SOURCE_FORM_MASK) == DSR_COMPACT_SOURCE_FORM_IDS) {
+        ADDR_CPY(ADDR_IDX(path, 0), compact->source);
+        path->len = compact->len + 1;
+
+        _NODES_READLOCK;
+
+        for(i = 0; i < compact->len && res == DSR_COMPACT_SOURCE_SUCCESS; i++) {
+            res = _resolve(ntohs(compact->id[i]), ADDR_IDX(path, i + 1));
+        }
+
+        _NODES_UNLOCK;
+
+        if(res == DSR_COMPACT_SOURCE_SUCCESS && flow_id != 0 && install) {
+            _FLOWS_LOCK;
+            _install_flow(compact->source, flow_id, path->address, path->len, &now);
+            _FLOWS_UNLOCK;
+        }
+
+        return res;
+    }
+
+    _flow_key(key, compact->source, flow_id);
+
+    _FLOWS_LOCK;
+    HASH_FIND(hh, _dsr_compact_source_flows, key, sizeof(key), flow);
+
+    if(flow == NULL) {
+        _FLOWS_UNLOCK;
+        return DSR_COMPACT_SOURCE_ERROR_UNKNOWN_FLOW;
+    }
+
+    flow->last_used = now;
+    path->len = flow->len;
+    ADDR_N_CPY(path->address, flow->address, flow->len);
+
+    _FLOWS_UNLOCK;
+
+    return DSR_COMPACT_SOURCE_SUCCESS;
+}
+
+/** called with the flows locked */
+static inline void _install_flow(const uint8_t source[ETHER_ADDR_LEN], uint16_t flow_id, const uint8_t* address, int len, const struct timeval* now) {
+    dsr_compact_source_flow_t* flow = NULL;
+    uint8_t key[ETHER_ADDR_LEN + sizeof(uint16_t)];
+
+    _flow_key(key, source, flow_id);
+    HASH_FIND(hh, _dsr_compact_source_flows, key, sizeof(key), flow);
+
+    if(flow == NULL) {
+        flow = malloc(sizeof(dsr_compact_source_flow_t));
+        assert(flow != NULL);
+        memcpy(flow->key, key, sizeof(key));
+        flow->flow = flow_id;
+        flow->packets = 0;
+        flow->confirmed = 0;
+        HASH_ADD(hh, _dsr_compact_source_flows, key, sizeof(key), flow);
+        _stats.flows++;
+    }
+    else if(flow->len != len || ADDR_N_CMP(flow->address, address, len) != 0) {
+        /* the next hop may be another one */
+        flow->confirmed = 0;
+    }
+
+    /* the source may have used the flow id for another route before */
+    flow->len = len;
+    ADDR_N_CPY(flow->address, address, len);
+    flow->last_used = *now;
+}
+
+static inline void _flow_key(uint8_t key[ETHER_ADDR_LEN + sizeof(uint16_t)], const uint8_t source[ETHER_ADDR_LEN], uint16_t flow_id) {
+    ADDR_CPY(key, source);
+    memcpy(key + ETHER_ADDR_LEN, &flow_id, sizeof(uint16_t));
+}
+
+/** called with the flows unlocked */
+static inline int _is_confirmed(const uint8_t source[ETHER_ADDR_LEN], uint16_t flow_id) {
+    dsr_compact_source_flow_t* flow = NULL;
+    uint8_t key[ETHER_ADDR_LEN + sizeof(uint16_t)];
+    int confirmed;
+
+    _flow_key(key, source, flow_id);
+
+    _FLOWS_LOCK;
+    HASH_FIND(hh, _dsr_compact_source_flows, key, sizeof(key), flow);
+    confirmed = (flow != NULL) ? flow->confirmed : 0;
+    _FLOWS_UNLOCK;
+
+    return confirmed;
+}
+
+static inline void _set_ids(dsr_compact_source_ext_t* compact, const dsr_source_ext_t* source, int hops) {
+    int i;
+
+    compact->len = hops - 1;
+
+    for(i = 1; i < hops; i++) {
+        compact->id[i - 1] = htons(dsr_compact_source_id(dsr_source_get_address_begin_by_index(source, i)));
+    }
+}
+
+/** Adds @a compact to @a msg and, unless its form is FULL, removes the
+ *  DSR_EXT_SOURCE. The msg is left unchanged if there is no room. */
+static inline int _add_compact(dessert_msg_t* msg, const dsr_compact_source_ext_t* compact) {
+    dessert_ext_t* ext;
+    size_t compact_len = DSR_COMPACT_SOURCE_EXTENSION_HDRLEN + compact->len * sizeof(uint16_t);
+
+    if(dessert_msg_addext(msg, &ext, DSR_EXT_COMPACT_SOURCE, compact_len) != DESSERT_OK) {
+        return DSR_COMPACT_SOURCE_ERROR_NO_ROOM;
+    }
+
+    memcpy(ext->data, compact, compact_len);
+
+    if((compact->flags & DSR_COMPACT_SOURCE_FORM_MASK) != DSR_COMPACT_SOURCE_FORM_FULL
+       && dessert_msg_getext(msg, &ext, DSR_EXT_SOURCE, 0)) {
+        dessert_msg_delext(msg, ext);
+    }
+
+    return DSR_COMPACT_SOURCE_SUCCESS;
+}
@@ -0,0 +1,132 @@
+/******************************************************************************
+ Copyright 2010, David Gutzmann, Freie Universitaet Berlin (FUB).
+ All rights reserved.
+
+ These sources were originally developed by David Gutzmann
+ at Freie Universitaet Berlin (http://www.fu-berlin.de/),
+ Computer Systems and Telematics / Distributed, Embedded Systems (DES) group
+ (http://cst.mi.fu-berlin.de/, http://www.des-testbed.net/)
+ ------------------------------------------------------------------------------
+ This program is free software: you can redistribute it and/or modify it under
+ the terms of the GNU General Public License as published by the Free Software
+ Foundation, either version 3 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with
+ this program. If not, see http://www.gnu.org/licenses/ .
+ ------------------------------------------------------------------------------
+ For further information and questions please use the web site
+ http://www.des-testbed.net/
+ ------------------------------------------------------------------------------
+
+ ******************************************************************************/
+#ifndef COMPACT_SOURCE_H_
+#define COMPACT_SOURCE_H_
+
+#include "dsr.h"
+
+/******************************************************************************
+ *
+ * Compact source routes
+ *
+ * A DSR_EXT_SOURCE carries 6 bytes per hop. With "set compact_source" the
+ * source of a data msg replaces it on the wire by a DSR_EXT_COMPACT_SOURCE
+ * (see extensions.h) in one of three forms:
+ *  FULL  the DSR_EXT_SOURCE is kept, the compact one only adds the flow id
+ *  IDS   a 16 bit id per hop, a hash of the address
+ *  FLOW  only the flow id; the relays have the route of the flow
+ * Every node keeps a table of the ids of the addresses it has seen in full
+ * source routes (route discovery, the first msg of a flow); an id shared by
+ * two of them is never sent and not resolved. The source sends the first
+ * msg of a route (and the first after a pause) FULL, so the relays learn its
+ * addresses and, with flows, its route. Mode IDS then sends IDS, mode FLOWS
+ * sends IDS, which also carry the flow id, until the next hop acknowledged a
+ * msg of the flow (network or passive ACK, see maintenance_buffer.c), then
+ * FLOW and IDS every DSR_CONFVAR_COMPACT_SOURCE_REFRESH_PACKETS msgs.
+ * Without route maintenance a flow is never confirmed and stays at IDS.
+ * Retransmissions from the maintenance buffer carry the full route again.
+ *
+ * The receiver turns the compact extension back into a DSR_EXT_SOURCE in
+ * compact_source_meshrx_cb, so the rest of the packet path is unchanged; a
+ * relay sends the msg on in the form it arrived in, but a FLOW msg as IDS
+ * while its own next hop has not confirmed the flow, so a relay that missed
+ * the first msgs learns the route again. A msg that does not fit with the
+ * compact extension keeps the DSR_EXT_SOURCE (FULL). A msg whose ids or flow
+ * the receiver does not know is dropped and left to route maintenance.
+ * All nodes of a network should use the same mode.
+ ******************************************************************************/
+
+#define DSR_COMPACT_SOURCE_OFF                             0
+#define DSR_COMPACT_SOURCE_IDS                             1
+#define DSR_COMPACT_SOURCE_FLOWS                           2
+
+/* the forms, in the lower bits of dsr_compact_source_ext->flags */
+#define DSR_COMPACT_SOURCE_FORM_FULL                       0
+#define DSR_COMPACT_SOURCE_FORM_IDS                        1
+#define DSR_COMPACT_SOURCE_FORM_FLOW                       2
+
+#define DSR_COMPACT_SOURCE_SUCCESS                         0
+#define DSR_COMPACT_SOURCE_ERROR_UNKNOWN_ID               -1
+#define DSR_COMPACT_SOURCE_ERROR_AMBIGUOUS_ID             -2
+#define DSR_COMPACT_SOURCE_ERROR_UNKNOWN_FLOW             -3
+#define DSR_COMPACT_SOURCE_ERROR_NO_ROOM                  -4
+
+/** an id and the address it stands for, or that several addresses share it */
+typedef struct dsr_compact_source_node {
+    uint16_t id;                                /* key */
+    uint8_t address[ETHER_ADDR_LEN];            /* the first one seen */
+    uint8_t ambiguous;
+    UT_hash_handle hh;
+} dsr_compact_source_node_t;
+
+/** a route known by flow id (relays) or by its addresses (the source) */
+typedef struct dsr_compact_source_flow {
+    uint8_t key[ETHER_ADDR_LEN + sizeof(uint16_t)]; /* first address, flow id; key at the relays */
+    uint16_t flow;
+    uint32_t packets;                           /* sent on the flow, at the source */
+    uint8_t confirmed;                          /* the next hop acknowledged a msg of the flow */
+    struct timeval last_used;
+    int len;
+    uint8_t address[DSR_SOURCE_MAX_ADDRESSES_IN_OPTION* ETHER_ADDR_LEN]; /* key at the source */
+    UT_hash_handle hh;
+} dsr_compact_source_flow_t;
+
+typedef struct dsr_compact_source_stats {
+    uint64_t nodes;                             /* in the id table */
+    uint64_t ambiguous;                         /* ids shared by several nodes */
+    uint64_t flows;                             /* routes of other sources */
+    uint64_t own_flows;
+    uint64_t sent[3];                           /* by DSR_COMPACT_SOURCE_FORM_* */
+    uint64_t bytes_full;                        /* the source routes sent, as DSR_EXT_SOURCE */
+    uint64_t bytes_sent;                        /* the same, as sent */
+    uint64_t received[3];                       /* by DSR_COMPACT_SOURCE_FORM_* */
+    uint64_t unknown_ids;                       /* msgs dropped */
+    uint64_t ambiguous_ids;
+    uint64_t unknown_flows;
+} dsr_compact_source_stats_t;
+
+/** the id of @a address */
+uint16_t dsr_compact_source_id(const uint8_t address[ETHER_ADDR_LEN]);
+/** adds the @a len addresses of a route to the id table, returns how many have an ambiguous id */
+int dsr_compact_source_learn(const uint8_t* address, int len);
+/** the address of @a id, DSR_COMPACT_SOURCE_SUCCESS or an error */
+int dsr_compact_source_resolve(uint16_t id, uint8_t address[ETHER_ADDR_LEN]);
+
+/** replaces the DSR_EXT_SOURCE of @a msg before it is sent, returns the form it is sent in */
+int dsr_msg_compact_source_ext(dessert_msg_t* msg, int originated);
+/** the next hop acknowledged @a msg, as kept by the maintenance buffer: it knows the flow of the msg */
+void dsr_compact_source_confirm(const dessert_msg_t* msg);
+
+void dsr_compact_source_get_stats(dsr_compact_source_stats_t* stats);
+
+dessert_cb_result compact_source_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, dessert_meshif_t* iface, dessert_frameid_t id);
+
+dessert_per_result_t cleanup_compact_source(void* data, struct timeval* scheduled, struct timeval* interval);
+
+int dessert_cli_cmd_showcompactsource(struct cli_def* cli, char* command, char* argv[], int argc);
+
+#endif /* COMPACT_SOURCE_H_ */
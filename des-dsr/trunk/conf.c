@@ -41,9 +41,13 @@ int dsr_cli_cmd_set_routemaintenance_network_ack_status(struct cli_def* cli, cha
 int dsr_cli_cmd_set_retransmission_count(struct cli_def* cli, char* command, char* argv[], int argc);
 int dsr_cli_cmd_set_retransmission_timeout(struct cli_def* cli, char* command, char* argv[], int argc);
 int dsr_cli_cmd_set_sendbuffer_timeout(struct cli_def* cli, char* command, char* argv[], int argc);
+int dsr_cli_cmd_set_sendbuffer_drain_rate(struct cli_def* cli, char* command, char* argv[], int argc);
+int dsr_cli_cmd_set_sendbuffer_drain_burst(struct cli_def* cli, char* command, char* argv[], int argc);
 int dsr_cli_cmd_set_routediscovery_timeout(struct cli_def* cli, char* command, char* argv[], int argc);
 int dsr_cli_cmd_set_routediscovery_maximum_retries(struct cli_def* cli, char* command, char* argv[], int argc);
 int dsr_cli_cmd_set_routediscovery_expanding_ring_search_status(struct cli_def* cli, char* command, char* argv[], int argc);
+int dsr_cli_cmd_set_statistics_export(struct cli_def* cli, char* command, char* argv[], int argc);
+int dsr_cli_cmd_set_compact_source(struct cli_def* cli, char* command, char* argv[], int argc);
 
 int dsr_cli_cmd_info_conf(struct cli_def* cli, char* command, char* argv[], int argc);
 
@@ -52,9 +56,13 @@ static inline int _set_routemaintenance_network_ack_status(int status);
 static inline int _set_retransmission_count(int count);
 static inline int _set_retransmission_timeout(__suseconds_t timeout);
 static inline int _set_sendbuffer_timeout(__suseconds_t timeout);
+static inline int _set_sendbuffer_drain_rate(uint32_t rate);
+static inline int _set_sendbuffer_drain_burst(uint32_t burst);
 static inline int _set_routediscovery_timeout(__suseconds_t timeout);
 static inline int _set_routediscovery_maximum_retries(int count);
 static inline int _set_routediscovery_expanding_ring_search_status(int status);
+static inline int _set_statistics_export(const char* file, uint32_t interval, int format);
+static inline int _set_compact_source(int mode);
 
 inline void dsr_conf_initialize(void) {
     _set_routemaintenance_passive_ack_status(DSR_CONFVAR_ROUTEMAINTENANCE_PASSIVE_ACK);
@@ -62,9 +70,12 @@ inline void dsr_conf_initialize(void) {
     _set_retransmission_count(DSR_CONFVAR_RETRANSMISSION_COUNT);
     _set_retransmission_timeout(DSR_CONFVAR_RETRANSMISSION_TIMEOUT);
     _set_sendbuffer_timeout(DSR_CONFVAR_SENDBUFFER_TIMEOUT);
+    _set_sendbuffer_drain_rate(DSR_CONFVAR_SENDBUFFER_DRAIN_RATE);
+    _set_sendbuffer_drain_burst(DSR_CONFVAR_SENDBUFFER_DRAIN_BURST);
     _set_routediscovery_timeout(DSR_CONFVAR_ROUTEDISCOVERY_TIMEOUT);
     _set_routediscovery_maximum_retries(DSR_CONFVAR_ROUTEDISCOVERY_MAXIMUM_RETRIES);
     _set_routediscovery_expanding_ring_search_status(DSR_CONFVAR_ROUTEDISCOVERY_EXPANDING_RING_SEARCH);
+    _set_compact_source(DSR_CONFVAR_COMPACT_SOURCE);
 }
 
 void dsr_conf_register_cli_callbacks(struct cli_command* cli_cfg_set, struct cli_command* cli_exec_info) {
@@ -88,6 +99,14 @@ void dsr_conf_register_cli_callbacks(struct cli_command* cli_cfg_set, struct cli
         dsr_cli_cmd_set_sendbuffer_timeout, PRIVILEGE_UNPRIVILEGED, MODE_CONFIG,
         "set sendbuffer timeout (time to wait for a route)");
 
+    cli_register_command(dessert_cli, cli_cfg_set , "sendbuffer_drain_rate",
+        dsr_cli_cmd_set_sendbuffer_drain_rate, PRIVILEGE_UNPRIVILEGED, MODE_CONFIG,
+        "set sendbuffer drain rate (msgs/s per destination once a route is found, 0 sends all at once)");
+
+    cli_register_command(dessert_cli, cli_cfg_set , "sendbuffer_drain_burst",
+        dsr_cli_cmd_set_sendbuffer_drain_burst, PRIVILEGE_UNPRIVILEGED, MODE_CONFIG,
+        "set sendbuffer drain burst (msgs sent at once when a route is found)");
+
     cli_register_command(dessert_cli, cli_cfg_set , "routediscovery_timeout",
         dsr_cli_cmd_set_routediscovery_timeout, PRIVILEGE_UNPRIVILEGED, MODE_CONFIG,
         "set route discovery timeout (initial time to wait for a REPL)");
@@ -100,6 +119,18 @@ void dsr_conf_register_cli_callbacks(struct cli_command* cli_cfg_set, struct cli
         dsr_cli_cmd_set_routediscovery_expanding_ring_search_status, PRIVILEGE_UNPRIVILEGED, MODE_CONFIG,
         "set route discovery expanding ring search feature");
 
+    cli_register_command(dessert_cli, cli_cfg_set , "statistics_export",
+        dsr_cli_cmd_set_statistics_export, PRIVILEGE_UNPRIVILEGED, MODE_CONFIG,
+        "append the statistics to a file every n seconds (csv or json, 0 s stops)");
+
+    cli_register_command(dessert_cli, cli_cfg_set , "compact_source",
+        dsr_cli_cmd_set_compact_source, PRIVILEGE_UNPRIVILEGED, MODE_CONFIG,
+        "set compact source routes for data msgs (0 off, 1 node ids, 2 flow ids)");
+
+    cli_register_command(dessert_cli, cli_cfg_set , "variant",
+        dsr_cli_cmd_set_variant, PRIVILEGE_UNPRIVILEGED, MODE_CONFIG,
+        "set the protocol variant (at startup only)");
+
     cli_register_command(dessert_cli, cli_exec_info , "conf",
         dsr_cli_cmd_info_conf, PRIVILEGE_UNPRIVILEGED, MODE_EXEC,
         "show the current configuration (set *)");
@@ -145,6 +176,22 @@ inline __suseconds_t dsr_conf_get_sendbuffer_timeout(void) {
     return timeout_copy;
 }
 
+inline uint32_t dsr_conf_get_sendbuffer_drain_rate(void) {
+    uint32_t rate_copy;
+    _CONF_READLOCK;
+    rate_copy = dsr_conf.sendbuffer_drain_rate;
+    _CONF_UNLOCK;
+    return rate_copy;
+}
+
+inline uint32_t dsr_conf_get_sendbuffer_drain_burst(void) {
+    uint32_t burst_copy;
+    _CONF_READLOCK;
+    burst_copy = dsr_conf.sendbuffer_drain_burst;
+    _CONF_UNLOCK;
+    return burst_copy;
+}
+
 inline __suseconds_t dsr_conf_get_routediscovery_timeout(void) {
     __suseconds_t timeout_copy;
     _CONF_READLOCK;
@@ -169,6 +216,28 @@ inline int dsr_conf_get_routediscovery_expanding_ring_search(void) {
     return status;
 }
 
+inline int dsr_conf_get_compact_source(void) {
+    int mode;
+    _CONF_READLOCK;
+    mode = dsr_conf.compact_source;
+    _CONF_UNLOCK;
+    return mode;
+}
+
+/** copies the statistics export file to @a file, returns its format or -1 if there is none */
+inline int dsr_conf_get_statistics_export(char file[DSR_CONF_STATISTICS_EXPORT_FILE_LEN]) {
+    int format = -1;
+    _CONF_READLOCK;
+
+    if(dsr_conf.statistics_export_interval != 0) {
+        memcpy(file, dsr_conf.statistics_export_file, DSR_CONF_STATISTICS_EXPORT_FILE_LEN);
+        format = dsr_conf.statistics_export_format;
+    }
+
+    _CONF_UNLOCK;
+    return format;
+}
+
 /******************************************************************************
  *
  * C L I --
@@ -250,6 +319,36 @@ int dsr_cli_cmd_set_sendbuffer_timeout(struct cli_def* cli, char* command, char*
     return (i == 0 ? CLI_OK : CLI_ERROR);
 }
 
+/** CLI command - exec mode - set sendbuffer_drain_rate $n */
+int dsr_cli_cmd_set_sendbuffer_drain_rate(struct cli_def* cli, char* command, char* argv[], int argc) {
+    uint32_t rate;
+    int i;
+
+    if(argc != 1 || sscanf(argv[0], "%u", &rate) != 1) {
+        cli_print(cli, "usage %s [sendbuffer drain rate (msgs/s)]\n", command);
+        return CLI_ERROR;
+    }
+
+    i = _set_sendbuffer_drain_rate(rate);
+
+    return (i == 0 ? CLI_OK : CLI_ERROR);
+}
+
+/** CLI command - exec mode - set sendbuffer_drain_burst $n */
+int dsr_cli_cmd_set_sendbuffer_drain_burst(struct cli_def* cli, char* command, char* argv[], int argc) {
+    uint32_t burst;
+    int i;
+
+    if(argc != 1 || sscanf(argv[0], "%u", &burst) != 1 || burst == 0) {
+        cli_print(cli, "usage %s [sendbuffer drain burst (msgs, > 0)]\n", command);
+        return CLI_ERROR;
+    }
+
+    i = _set_sendbuffer_drain_burst(burst);
+
+    return (i == 0 ? CLI_OK : CLI_ERROR);
+}
+
 /** CLI command - exec mode - set routediscovery_timeout $n */
 int dsr_cli_cmd_set_routediscovery_timeout(struct cli_def* cli, char* command, char* argv[], int argc) {
     __suseconds_t timeout;
@@ -295,17 +394,64 @@ int dsr_cli_cmd_set_routediscovery_expanding_ring_search_status(struct cli_def*
     return (i == 0 ? CLI_OK : CLI_ERROR);
 }
 
+/** CLI command - exec mode - set compact_source $n */
+int dsr_cli_cmd_set_compact_source(struct cli_def* cli, char* command, char* argv[], int argc) {
+    int mode;
+    int i;
+
+    if(argc != 1 || sscanf(argv[0], "%i", &mode) != 1
+       || mode < DSR_COMPACT_SOURCE_OFF || mode > DSR_COMPACT_SOURCE_FLOWS) {
+        cli_print(cli, "usage %s [0 off, 1 ids, 2 flows]\n", command);
+        return CLI_ERROR;
+    }
+
+    i = _set_compact_source(mode);
+
+    return (i == 0 ? CLI_OK : CLI_ERROR);
+}
+
+/** CLI command - exec mode - set statistics_export $file $secs [csv|json] */
+int dsr_cli_cmd_set_statistics_export(struct cli_def* cli, char* command, char* argv[], int argc) {
+    uint32_t interval;
+    int format = DSR_STATISTICS_FORMAT_CSV;
+    int i;
+
+    if(argc == 3 && strcmp(argv[2], "json") == 0) {
+        format = DSR_STATISTICS_FORMAT_JSON;
+    }
+
+    if(argc < 2 || argc > 3 || sscanf(argv[1], "%u", &interval) != 1
+       || (argc == 3 && strcmp(argv[2], "csv") != 0 && strcmp(argv[2], "json") != 0)
+       || strlen(argv[0]) >= DSR_CONF_STATISTICS_EXPORT_FILE_LEN) {
+        cli_print(cli, "usage %s [file] [interval (s), 0 stops] [csv|json]\n", command);
+        return CLI_ERROR;
+    }
+
+    i = _set_statistics_export(argv[0], interval, format);
+
+    return (i == 0 ? CLI_OK : CLI_ERROR);
+}
+
 /** CLI command - exec mode - info conf  */
 int dsr_cli_cmd_info_conf(struct cli_def* cli, char* command, char* argv[], int argc) {
     _CONF_READLOCK;
+    cli_print(cli, "variant %s", dsr_variant->name);
     cli_print(cli, "retransmission count %i", dsr_conf.retransmission_count);
     cli_print(cli, "retransmission timeout %li", dsr_conf.retransmission_timeout);
     cli_print(cli, "sendbuffer timeout %li", dsr_conf.sendbuffer_timeout);
+    cli_print(cli, "sendbuffer drain rate %u", dsr_conf.sendbuffer_drain_rate);
+    cli_print(cli, "sendbuffer drain burst %u", dsr_conf.sendbuffer_drain_burst);
     cli_print(cli, "route discovery timeout %li", dsr_conf.routediscovery_timeout);
     cli_print(cli, "route discovery maximum retries %i", dsr_conf.routediscovery_maximum_retries);
     cli_print(cli, "route discovery expanding ring search %i", dsr_conf.routediscovery_expanding_ring_search);
     cli_print(cli, "routemaintenance network ack %i", dsr_conf.routemaintenance_network_ack);
     cli_print(cli, "routemaintenance passive ack %i", dsr_conf.routemaintenance_passive_ack);
+    cli_print(cli, "compact source %i", dsr_conf.compact_source);
+
+    if(dsr_conf.statistics_export_interval != 0) {
+        cli_print(cli, "statistics export %s every %u s (%s)", dsr_conf.statistics_export_file, dsr_conf.statistics_export_interval,
+                  dsr_conf.statistics_export_format == DSR_STATISTICS_FORMAT_JSON ? "json" : "csv");
+    }
     _CONF_UNLOCK;
     return CLI_OK;
 }
@@ -345,7 +491,7 @@ static inline int _set_retransmission_timeout(__suseconds_t timeout) {
     maintenance_buffer_cleanup_interval.tv_sec = 0;
     maintenance_buffer_cleanup_interval.tv_usec = 0;
 
-    TIMEVAL_ADD_SAFE(&maintenance_buffer_cleanup_interval, 0, 5000); //XXX HOTFIX
+    TIMEVAL_ADD_SAFE(&maintenance_buffer_cleanup_interval, 0, DSR_CONFVAR_MAINTENANCE_BUFFER_WHEEL_TICK_USECS);
 
     dessert_info("setting retransmission timeout to %li", timeout);
 
@@ -370,6 +516,22 @@ static inline int _set_sendbuffer_timeout(__suseconds_t timeout) {
     _SAFE_RETURN(CLI_OK);
 }
 
+static inline int _set_sendbuffer_drain_rate(uint32_t rate) {
+    dessert_info("setting sendbuffer drain rate to %u", rate);
+
+    _CONF_WRITELOCK;
+    dsr_conf.sendbuffer_drain_rate = rate;
+    _SAFE_RETURN(CLI_OK);
+}
+
+static inline int _set_sendbuffer_drain_burst(uint32_t burst) {
+    dessert_info("setting sendbuffer drain burst to %u", burst);
+
+    _CONF_WRITELOCK;
+    dsr_conf.sendbuffer_drain_burst = burst;
+    _SAFE_RETURN(CLI_OK);
+}
+
 static inline int _set_routediscovery_timeout(__suseconds_t timeout) {
     struct timeval routediscovery_run_interval;
     routediscovery_run_interval.tv_sec = 0;
@@ -408,3 +570,37 @@ static inline int _set_routediscovery_expanding_ring_search_status(int status) {
     dsr_conf.routediscovery_expanding_ring_search = status;
     _SAFE_RETURN(CLI_OK);
 }
+
+static inline int _set_compact_source(int mode) {
+    dessert_info("setting compact source to %i", mode);
+
+    _CONF_WRITELOCK;
+    dsr_conf.compact_source = mode;
+    _SAFE_RETURN(CLI_OK);
+}
+
+static inline int _set_statistics_export(const char* file, uint32_t interval, int format) {
+    struct timeval statistics_export_interval;
+    statistics_export_interval.tv_sec = interval;
+    statistics_export_interval.tv_usec = 0;
+
+    dessert_info("setting statistics export to %s every %u s", file, interval);
+
+    _CONF_WRITELOCK;
+    snprintf(dsr_conf.statistics_export_file, DSR_CONF_STATISTICS_EXPORT_FILE_LEN, "%s", file);
+    dsr_conf.statistics_export_format = format;
+    dsr_conf.statistics_export_interval = interval;
+
+    if(dsr_conf.statistics_export_periodic != NULL) {
+        dessert_periodic_del(dsr_conf.statistics_export_periodic);
+        dsr_conf.statistics_export_periodic = NULL;
+    }
+
+    if(interval != 0) {
+        dsr_conf.statistics_export_periodic = dessert_periodic_add(dsr_statistics_export_periodic, NULL, NULL, &statistics_export_interval);
+    }
+
+    _CONF_UNLOCK;
+
+    return ((interval == 0 || dsr_conf.statistics_export_periodic != NULL) ? CLI_OK : CLI_ERROR);
+}
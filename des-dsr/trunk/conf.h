@@ -29,6 +29,8 @@
 
 #include "dsr.h"
 
+#define DSR_CONF_STATISTICS_EXPORT_FILE_LEN 256
+
 typedef struct dsr_conf {
 
     int routemaintenance_passive_ack;
@@ -38,12 +40,20 @@ typedef struct dsr_conf {
     dessert_periodic_t* retransmission_timeout_periodic;
 
     __suseconds_t sendbuffer_timeout;
+    uint32_t sendbuffer_drain_rate;
+    uint32_t sendbuffer_drain_burst;
 
     __suseconds_t routediscovery_timeout;
     dessert_periodic_t* routediscovery_timeout_periodic;
     int routediscovery_maximum_retries;
     int routediscovery_expanding_ring_search;
 
+    int compact_source;
+
+    char statistics_export_file[DSR_CONF_STATISTICS_EXPORT_FILE_LEN];
+    int statistics_export_format;
+    uint32_t statistics_export_interval;
+    dessert_periodic_t* statistics_export_periodic;
 
 } dsr_conf_t;
 
@@ -57,10 +67,16 @@ inline int dsr_conf_get_retransmission_count(void);
 inline __suseconds_t dsr_conf_get_retransmission_timeout(void);
 
 inline __suseconds_t dsr_conf_get_sendbuffer_timeout(void);
+inline uint32_t dsr_conf_get_sendbuffer_drain_rate(void);
+inline uint32_t dsr_conf_get_sendbuffer_drain_burst(void);
 
 inline __suseconds_t dsr_conf_get_routediscovery_timeout(void);
 inline int dsr_conf_get_routediscovery_maximum_retries(void);
 
 inline int dsr_conf_get_routediscovery_expanding_ring_search(void);
 
+inline int dsr_conf_get_compact_source(void);
+
+inline int dsr_conf_get_statistics_export(char file[DSR_CONF_STATISTICS_EXPORT_FILE_LEN]);
+
 #endif /* CONF_H_ */
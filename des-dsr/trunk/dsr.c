@@ -98,11 +98,7 @@ int sys2dsr_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, dessert
         res = -1;
     }
     else {
-#if (LOAD_BALANCING == 0)
-        res = dsr_routecache_get_first(eth->ether_dhost, &path);
-#elif (LOAD_BALANCING == 1)
-        res = dsr_routecache_get_next_round_robin(eth->ether_dhost, &path);
-#endif
+        res = DSR_VARIANT_CALL(get_path)(eth->ether_dhost, &path);
     }
 
     if(res == -1) {
@@ -275,32 +271,12 @@ int rreq_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, des
             DSR_RREQ_GET_HOPCOUNT(rreq) + 1,
             dsr_rreq_get_weight_incl_hop_to_self(iface, rreq));
 
-#if (PROTOCOL == MDSR_PROTOKOLL_1)
-        dsr_path_t* rreq_path;
-        dsr_path_new_from_rreq(&rreq_path, rreq);
-        res = dsr_mdsr_is_repl_ok(rreq->data[0].address, ntohs(rreq->identification), rreq->target_address, rreq_path);
-        if(res != DSR_MDSR_REPLY_OK) {
-            dessert_debug("RREQ[%"PRIi64"]: Dropping due to MDSR rules...", id);
-            return DESSERT_MSG_DROP;
-        }
-        else {
-            dessert_debug("RREQ[%"PRIi64"]: Replying according to MDSR rules...", id);
-        }
+        res = DSR_VARIANT_CALL(reply_rreq)(iface, rreq);
 
-#endif
-
-#if (PROTOCOL == SMR || PROTOCOL == BACKUPPATH_VARIANT_1 || PROTOCOL == BACKUPPATH_VARIANT_2)
-        res = dsr_smr_is_repl_ok(rreq->data[0].address, ntohs(rreq->identification), rreq->target_address, iface, rreq);
-
-        if(res != DSR_SMR_REPLY_OK) {
-            dessert_debug("RREQ[%"PRIi64"]: Not replying due to SMR rules...", id);
+        if(res != DSR_RREQTABLE_REPLY_OK) {
+            dessert_debug("RREQ[%"PRIi64"]: Not replying due to %s rules...", id, dsr_variant->name);
             return DESSERT_MSG_DROP;
         }
-        else {
-            dessert_debug("RREQ[%"PRIi64"]: Replying according to SMR rules...", id);
-        }
-
-#endif
 
         /* DONE: Send REPL (RREQ handling) rfc4728 p66
          If the Target Address field in the Route Request matches this
@@ -417,60 +393,15 @@ int rreq_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, des
             //return DESSERT_MSG_DROP; // remove if ENHANCEMENT done
         }
 
-#if (PROTOCOL == ETXDSR)
-        uint32_t weight = dsr_rreq_get_weight_incl_hop_to_self(iface, rreq);
-        res = dsr_is_rreqcache_entry_present_and_worse_than(rreq->data[0].address,
-                ntohs(rreq->identification), rreq->target_address, weight);
+        /* DONE: Route Request Table (RREQ handling) rfc4728 p67/68, or the
+         forwarding rules of the ETX, SMR and backup path variants */
+        res = DSR_VARIANT_CALL(forward_rreq)(iface, msg, rreq);
 
         if(res == DSR_RREQTABLE_DONT_FORWARD_RREQ) {
-            dessert_debug("RREQ[%"PRIi64"]: dropping RREQ due to ETX rules", id);
+            dessert_debug("RREQ[%"PRIi64"]: dropping RREQ due to %s rules", id, dsr_variant->name);
             return DESSERT_MSG_DROP;
         }
 
-#endif
-#if ((PROTOCOL == DSR) || PROTOCOL == MDSR_PROTOKOLL_1)
-        /* DONE: Route Request Table (RREQ handling, search entry) rfc4728 p67
-         Else, the node MUST search its Route Request Table for an entry
-         for the initiator of this Route Request (the IP Source Address
-         field). */
-
-        /*If such an entry is found in the table, the node MUST
-         search the cache of Identification values of recently received
-         Route Requests in that table entry, to determine if an entry is
-         present in the cache matching the Identification value and target
-         node address in this Route Request.*/
-        res = dsr_is_rreqcache_entry_present(rreq->data[0].address,
-                                             ntohs(rreq->identification), rreq->target_address);
-
-        if(res == DSR_RREQTABLE_DONT_FORWARD_RREQ) {
-            /*If such an (Identification, target address) entry is found in this cache
-             * in this entry in the Route Request Table, then the node MUST discard
-             * the entire packet carrying the Route Request option. */
-            dessert_debug("RREQ[%"PRIi64"]: seen this RREQ before, dropping it", id);
-            return DESSERT_MSG_DROP;
-        }
-
-        /* Else, this node SHOULD further process the Route Request according
-         to the following sequence of steps:
-
-         o  DONE: Route Request Table (RREQ handling, add entry) rfc4728 p68
-         Add an entry for this Route Request in its cache of
-         (Identification, target address) values of recently received
-         Route Requests. */
-        res = dsr_add_node_to_rreqtable_cache( rreq->data[0].address, ntohs(rreq->identification), rreq->target_address);
-        assert(res == DSR_RREQTABLE_SUCCESS);
-#endif
-#if (PROTOCOL == SMR || PROTOCOL == BACKUPPATH_VARIANT_1 || PROTOCOL == BACKUPPATH_VARIANT_2)
-        uint32_t weight = dsr_rreq_get_weight_incl_hop_to_self(iface, rreq);
-        res = dsr_smr_is_rreq_forward_ok(rreq->data[0].address, ntohs(rreq->identification), rreq->target_address, weight, msg->l2h.ether_shost);
-
-        if(res == DSR_RREQTABLE_DONT_FORWARD_RREQ) {
-            dessert_debug("RREQ[%"PRIi64"]: dropping RREQ due to SMR/BACKUPPATH rules", id);
-            return DESSERT_MSG_DROP;
-        }
-
-#endif
-
         /* TODO_ENHANCEMENT: Cached Route Reply (RREQ handling) rfc4728 p68
          This node SHOULD search its own Route Cache for a route (from
          itself, as if it were the source of a packet) to the target of
@@ -522,8 +453,6 @@ int repl_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, des
     /* TODO: bei LINKCACHE==1 für alle msgs im sendbuffer clever einzeln prüfen ob route zum ziel jetzt besteht */
     if(ADDR_CMP(dessert_l25_defsrc, repl->data[0].address) == 0) {
 
-#if (LINKCACHE == 1)
-
         /* DONE: Route Cache (REPL handling, caching)
          -If the DSR Options header contains a Route Reply option, the node
          SHOULD extract the source route from the Route Reply and add this
@@ -551,10 +480,6 @@ int repl_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, des
          addresses, the node MUST then process the Route Reply option as
          described in Section 8.2.6. */
 
-        dsr_msg_cache_repl_ext_to_linkcache(repl);
-
-#else /* NO LINKCACHE */
-
         /* DONE: Route Cache (REPL handling, add path) rfc4728 p 74
          Section 8.1.4 describes the general processing for a received packet,
          including the addition of routing information from options in the
@@ -572,9 +497,8 @@ int repl_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, des
          Send Buffer.  This general procedure handles all processing required
          for a received Route Reply option. */
 
-        dsr_msg_cache_repl_ext_to_routecache(repl);
+        DSR_VARIANT_CALL(cache_repl)(repl);
 
-#endif
         dsr_rreqtable_got_repl(repl->data[DSR_REPL_GET_HOPCOUNT(repl) - 1].address);
         dsr_sendbuffer_send_msgs_to(
             repl->data[DSR_REPL_GET_HOPCOUNT(repl) - 1].address);
@@ -729,7 +653,7 @@ int ack_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, dess
 
     dsr_blacklist_remove_node(ack->ack_source_address);
 
-    if(unlikely(dsr_maintenance_buffer_delete_msg(ntohs(ack->identification)) != DSR_MAINTENANCE_BUFFER_SUCCESS)) {
+    if(unlikely(dsr_maintenance_buffer_delete_msg(ack->ack_source_address, ntohs(ack->identification)) != DSR_MAINTENANCE_BUFFER_SUCCESS)) {
         dessert_err("ACK[%"PRIi64"]: Could not remove ack->id[%i] from maintbuf", id, ntohs(ack->identification));
     }
 
@@ -740,21 +664,15 @@ int ack_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, dess
      identified by the ACK Source Address field to the node identified
      by the ACK Destination Address field. */
 
-#if (LINKCACHE == 1)
-    uint16_t link_weight;
-#if (METRIC == HC)
-    link_weight = 100;
-#elif (METRIC == ETX)
-    link_weight = dsr_etx_encode(dsr_etx_get_value(ack->ack_destination_address, ack->ack_source_address));
-#endif
+    if(LINKCACHE == 1) {
+        uint16_t link_weight = DSR_VARIANT_CALL(hop_weight)(ack->ack_destination_address, ack->ack_source_address);
 
-    if(dsr_linkcache_add_link(ack->ack_source_address, ack->ack_destination_address, link_weight) == DSR_LINKCACHE_SUCCESS) {
-        /* DONE: Route Cache (ACK handling, trigger update)*/
-        dsr_linkcache_run_dijkstra(dessert_l25_defsrc);
+        if(dsr_linkcache_add_link(ack->ack_source_address, ack->ack_destination_address, link_weight) == DSR_LINKCACHE_SUCCESS) {
+            /* DONE: Route Cache (ACK handling, trigger update)*/
+            dsr_linkcache_run_dijkstra(dessert_l25_defsrc);
+        }
     }
 
-#endif
-
     return DESSERT_MSG_KEEP;
 }
 
@@ -819,22 +737,24 @@ int source_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, d
                 dsr_source_get_address_count(source),
                 source->segments_left);
 
-#if (LINKCACHE == 1)
-            dsr_msg_cache_source_ext_to_linkcache(source, DSR_REPL_EXTENSION_IN_MSG);
-#else
-            /* TODO */
-#endif
+            if(LINKCACHE == 1) {
+                dsr_msg_cache_source_ext_to_linkcache(source, DSR_REPL_EXTENSION_IN_MSG);
+            }
+            else {
+                /* TODO */
+            }
         }
         else {
             /* no REPL extension present. cache all links */
             dessert_debug("SOURCE[%"PRIi64"]: NO REPL present, address count[%i] segments_left[%i] caching all links...", id,
                 dsr_source_get_address_count(source),
                 source->segments_left);
-#if (LINKCACHE == 1)
-            dsr_msg_cache_source_ext_to_linkcache(source, DSR_NO_REPL_EXTENSION_IN_MSG);
-#else
-            /* TODO */
-#endif
+            if(LINKCACHE == 1) {
+                dsr_msg_cache_source_ext_to_linkcache(source, DSR_NO_REPL_EXTENSION_IN_MSG);
+            }
+            else {
+                /* TODO */
+            }
         }
     }
 
@@ -1009,6 +929,7 @@ check_segments_left:
                         dsr_msg_send_with_route_maintenance(msg, iface, out_iface, DSR_MAINTENANCE_BUFFER_NEXTHOP_REACHABILITY_ACKREQ_ACK);
                     }
                     else {
+                        dsr_msg_compact_source_ext(msg, 0);
                         dsr_statistics_tx_msg(out_iface->hwaddr, msg->l2h.ether_dhost, msg);
                         int res = dessert_meshsend_fast(msg, out_iface);
                         assert(res == DESSERT_OK);
@@ -1019,6 +940,7 @@ check_segments_left:
                 dsr_msg_send_with_route_maintenance(msg, iface, out_iface, DSR_MAINTENANCE_BUFFER_NEXTHOP_REACHABILITY_ACKREQ_ACK);
             }
             else {
+                dsr_msg_compact_source_ext(msg, 0);
                 dsr_statistics_tx_msg(out_iface->hwaddr, msg->l2h.ether_dhost, msg);
                 int res = dessert_meshsend_fast(msg, out_iface);
                 assert(res == DESSERT_OK);
@@ -1069,6 +991,11 @@ int main(int argc, char** argv) {
 
     dsr_conf_initialize();
 
+    /**************************************************************************
+     * choose the protocol variant, dessert_init needs its protocol string
+     *************************************************************************/
+    const char* unknown_variant = dsr_variant_configure(cfg);
+
     /**************************************************************************
      * initialize dessert framework
      *************************************************************************/
@@ -1079,6 +1006,12 @@ int main(int argc, char** argv) {
      *************************************************************************/
     dessert_logcfg(DESSERT_LOG_NOSTDERR | DESSERT_LOG_NOSYSLOG | DESSERT_LOG_RBUF | DESSERT_LOG_FILE);
 
+    if(unknown_variant != NULL) {
+        dessert_err("unknown variant %s, keeping %s", unknown_variant, dsr_variant->name);
+    }
+
+    dessert_info("protocol variant %s", dsr_variant->name);
+
     /**************************************************************************
      * initialize cli
      *************************************************************************/
@@ -1094,24 +1027,39 @@ int main(int argc, char** argv) {
     cli_register_command(dessert_cli, dessert_cli_cfg_iface, "mesh",
         dessert_cli_cmd_addmeshif, PRIVILEGE_PRIVILEGED, MODE_CONFIG,
         "initialize dsr interface");
-#if (LINKCACHE == 1)
-    cli_register_command(dessert_cli, cli_exec_info, "linkcache",
-        dessert_cli_cmd_showlinkcache, PRIVILEGE_UNPRIVILEGED, MODE_EXEC,
-        "Print the linkcache data.");
-#endif
+    if(LINKCACHE == 1) {
+        cli_register_command(dessert_cli, cli_exec_info, "linkcache",
+            dessert_cli_cmd_showlinkcache, PRIVILEGE_UNPRIVILEGED, MODE_EXEC,
+            "Print the linkcache data.");
+    }
 
+    if(METRIC == ETX) {
+        cli_register_command(dessert_cli, cli_exec_info, "etx",
+            dessert_cli_cmd_showetx, PRIVILEGE_UNPRIVILEGED, MODE_EXEC,
+            "Print the ETX metric data.");
+        cli_register_command(dessert_cli, cli_exec_info, "unicastetx",
+            dessert_cli_cmd_showunicastetx, PRIVILEGE_UNPRIVILEGED, MODE_EXEC,
+            "Print the unicast ETX metric data.");
+    }
 
-#if (METRIC == ETX)
-    cli_register_command(dessert_cli, cli_exec_info, "etx",
-        dessert_cli_cmd_showetx, PRIVILEGE_UNPRIVILEGED, MODE_EXEC,
-        "Print the ETX metric data.");
-    cli_register_command(dessert_cli, cli_exec_info, "unicastetx",
-        dessert_cli_cmd_showunicastetx, PRIVILEGE_UNPRIVILEGED, MODE_EXEC,
-        "Print the unicast ETX metric data.");
-#endif
+    cli_register_command(dessert_cli, cli_exec_info, "variant",
+        dessert_cli_cmd_showvariant, PRIVILEGE_UNPRIVILEGED, MODE_EXEC,
+        "Print the protocol variant and its strategies.");
     cli_register_command(dessert_cli, cli_exec_info, "statistics",
         dessert_cli_cmd_showstatistics, PRIVILEGE_UNPRIVILEGED, MODE_EXEC,
         "Print statistics data.");
+    cli_register_command(dessert_cli, cli_exec_info, "alloc_cache",
+        dessert_cli_cmd_showalloccache, PRIVILEGE_UNPRIVILEGED, MODE_EXEC,
+        "Print the per size class counters of the message buffer cache.");
+    cli_register_command(dessert_cli, cli_exec_info, "sendbuffer",
+        dessert_cli_cmd_showsendbuffer, PRIVILEGE_UNPRIVILEGED, MODE_EXEC,
+        "Print the send buffer queue depths and drop counters.");
+    cli_register_command(dessert_cli, cli_exec_info, "compact_source",
+        dessert_cli_cmd_showcompactsource, PRIVILEGE_UNPRIVILEGED, MODE_EXEC,
+        "Print the node id table, flow and compact source route counters.");
+    cli_register_command(dessert_cli, cli_exec_info, "maintenance_buffer",
+        dessert_cli_cmd_showmaintenancebuffer, PRIVILEGE_UNPRIVILEGED, MODE_EXEC,
+        "Print the maintenance buffer retransmission and ACK counters.");
 
     dessert_debug("initializing cli done");
 
@@ -1135,12 +1083,13 @@ int main(int argc, char** argv) {
     //dessert_meshrxcb_add(debug_cb, 30);
     dessert_meshrxcb_add(loopcheck_cb, 50);
     dessert_meshrxcb_add(statistics_meshrx_cb, 60);
+    dessert_meshrxcb_add(compact_source_meshrx_cb, 62);
     dessert_meshrxcb_add(maintenance_buffer_passive_ack_meshrx_cb, 65);
 
-#if (METRIC == ETX)
-    dessert_meshrxcb_add(etx_meshrx_cb, 70);
-    dessert_meshrxcb_add(unicast_etx_meshrx_cb, 75);
-#endif
+    if(METRIC == ETX) {
+        dessert_meshrxcb_add(etx_meshrx_cb, 70);
+        dessert_meshrxcb_add(unicast_etx_meshrx_cb, 75);
+    }
 
     dessert_meshrxcb_add(dessert_mesh_ipttl, 80);
 
@@ -1175,37 +1124,35 @@ int main(int argc, char** argv) {
     rreqtable_cleanup_interval.tv_usec = 0;
     dessert_periodic_add(cleanup_rreqtable, NULL, NULL, &rreqtable_cleanup_interval);
 
-    struct timeval sendbuffer_cleanup_interval;
-    sendbuffer_cleanup_interval.tv_sec = DSR_CONFVAR_SENDBUFFER_CLEANUP_INTERVAL_SECS;
-    sendbuffer_cleanup_interval.tv_usec = 0;
-    dessert_periodic_add(cleanup_sendbuffer, NULL, NULL, &sendbuffer_cleanup_interval);
-
-#if (METRIC == ETX)
-    struct timeval etx_probes_interval;
-    etx_probes_interval.tv_sec = DSR_CONFVAR_ETX_PROBE_RATE_SECS;
-    etx_probes_interval.tv_usec = 0;
-    dessert_periodic_add(dsr_etx_send_probes, NULL, NULL, &etx_probes_interval);
-
-    struct timeval unicastetx_probes_interval;
-    unicastetx_probes_interval.tv_sec = DSR_CONFVAR_ETX_PROBE_RATE_SECS;
-    unicastetx_probes_interval.tv_usec = 0;
-    struct timeval unicastetx_probes_schedule;
-    gettimeofday(&unicastetx_probes_schedule, NULL);
-    TIMEVAL_ADD_SAFE(&unicastetx_probes_schedule, 0, 500000);
-    dessert_periodic_add(dsr_unicastetx_send_probes, NULL, &unicastetx_probes_schedule, &etx_probes_interval);
-
-    struct timeval etx_cleanup_interval;
-    etx_cleanup_interval.tv_sec = DSR_CONFVAR_ETX_LAST_SEEN_TIME_SECS;
-    etx_cleanup_interval.tv_usec = 0;
-    dessert_periodic_add(dsr_etx_cleanup, NULL, NULL, &etx_cleanup_interval);
-#endif
+    struct timeval compact_source_cleanup_interval;
+    compact_source_cleanup_interval.tv_sec = DSR_CONFVAR_COMPACT_SOURCE_CLEANUP_INTERVAL_SECS;
+    compact_source_cleanup_interval.tv_usec = 0;
+    dessert_periodic_add(cleanup_compact_source, NULL, NULL, &compact_source_cleanup_interval);
+
+    struct timeval sendbuffer_run_interval;
+    sendbuffer_run_interval.tv_sec = 0;
+    sendbuffer_run_interval.tv_usec = DSR_CONFVAR_SENDBUFFER_RUN_INTERVAL_USECS;
+    dessert_periodic_add(run_sendbuffer, NULL, NULL, &sendbuffer_run_interval);
+
+    if(METRIC == ETX) {
+        struct timeval etx_probes_interval;
+        etx_probes_interval.tv_sec = 0;
+        etx_probes_interval.tv_usec = 0;
+        TIMEVAL_ADD_SAFE(&etx_probes_interval, 0, DSR_CONFVAR_ETX_PROBE_INTERVAL_MSECS * 1000);
+        dessert_periodic_add(dsr_etx_send_probes, NULL, NULL, &etx_probes_interval);
+
+        struct timeval etx_cleanup_interval;
+        etx_cleanup_interval.tv_sec = DSR_CONFVAR_ETX_LAST_SEEN_TIME_SECS;
+        etx_cleanup_interval.tv_usec = 0;
+        dessert_periodic_add(dsr_etx_cleanup, NULL, NULL, &etx_cleanup_interval);
+    }
 
-#if (LINKCACHE == 1)
-    struct timeval dijkstra_interval;
-    dijkstra_interval.tv_sec = DSR_CONFVAR_DIJKSTRA_SECS;
-    dijkstra_interval.tv_usec = 0;
-    dessert_periodic_add(dsr_linkcache_run_dijkstra_periodic, NULL, NULL, &dijkstra_interval);
-#endif
+    if(LINKCACHE == 1) {
+        struct timeval dijkstra_interval;
+        dijkstra_interval.tv_sec = DSR_CONFVAR_DIJKSTRA_SECS;
+        dijkstra_interval.tv_usec = 0;
+        dessert_periodic_add(dsr_linkcache_run_dijkstra_periodic, NULL, NULL, &dijkstra_interval);
+    }
 
 #ifdef CACHE_STATISTICS
     struct timeval cache_statistics_interval;
@@ -1218,17 +1165,17 @@ int main(int argc, char** argv) {
      * initialize data structures
      *************************************************************************/
     dessert_info("initializing data structures");
-#if (LINKCACHE == 1)
-    dsr_linkcache_init(dessert_l25_defsrc);
-
-    dessert_meshif_t* meshif;
-    pthread_rwlock_rdlock(&dessert_cfglock);
-    DL_FOREACH(dessert_meshiflist_get(), meshif) {
-        dsr_linkcache_add_link(dessert_l25_defsrc, meshif->hwaddr, 0);
-        dsr_linkcache_add_link(meshif->hwaddr, dessert_l25_defsrc, 0);
+    if(LINKCACHE == 1) {
+        dsr_linkcache_init(dessert_l25_defsrc);
+
+        dessert_meshif_t* meshif;
+        pthread_rwlock_rdlock(&dessert_cfglock);
+        DL_FOREACH(dessert_meshiflist_get(), meshif) {
+            dsr_linkcache_add_link(dessert_l25_defsrc, meshif->hwaddr, 0);
+            dsr_linkcache_add_link(meshif->hwaddr, dessert_l25_defsrc, 0);
+        }
+        pthread_rwlock_unlock(&dessert_cfglock);
     }
-    pthread_rwlock_unlock(&dessert_cfglock);
-#endif
     dessert_debug("initializing data structures done");
 
     /**************************************************************************
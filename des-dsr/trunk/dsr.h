@@ -128,6 +128,15 @@
 #    define LINKCACHE 0
 #    define LOAD_BALANCING 1
 #    define DSR_CONFVAR_ROUTECACHE_KEEP_PATHS 2
+#elif (DAEMON == 11)
+/* every variant in one binary, chosen at startup with "set variant" (see variant.h) */
+#    define DAEMON_NAME "des-dsr-multi"
+#    define DSR_VARIANT_RUNTIME 1
+#    define DESSERT_PROTO_STRING (dsr_variant->proto_string)
+#    define PROTOCOL (dsr_variant->protocol)
+#    define METRIC (dsr_variant->metric)
+#    define LINKCACHE (dsr_variant->linkcache)
+#    define LOAD_BALANCING (dsr_variant->load_balancing)
 #else
 #    define DAEMON_NAME "des-dsr-mdsr"
 #    define DESSERT_PROTO_STRING "DSR5"
@@ -148,8 +157,13 @@
 #   define METRIC HC
 #endif
 
+#ifndef DSR_VARIANT_RUNTIME
+#   define DSR_VARIANT_RUNTIME 0
+#endif
+
 
 #define DSR_CONFVAR_RREQTABLE_REQUESTTABLEIDS                 32 /* rfc4728 p95 states 16*/
+#define DSR_CONFVAR_RREQTABLE_STRIPES                         16 /* independently locked parts of the table */
 
 #define DSR_CONFVAR_BLACKLIST_CLEANUP_INTERVAL_SECS           10
 #define DSR_CONFVAR_BLACKLIST_REVERT_TO_QUESTIONABLE_SECS     60
@@ -159,29 +173,38 @@
 #define DSR_CONFVAR_ROUTEMAINTENANCE_NETWORK_ACK               0
 #define DSR_CONFVAR_RETRANSMISSION_COUNT                       0 /* cli: set retransmission_count     */
 #define DSR_CONFVAR_RETRANSMISSION_TIMEOUT                 50000 /* cli: set retransmission_timeout   */
+#define DSR_CONFVAR_MAINTENANCE_BUFFER_WHEEL_TICK_USECS     5000 /* retransmission timer granularity */
+#define DSR_CONFVAR_MAINTENANCE_BUFFER_WHEEL_SLOTS           256 /* one revolution covers 1.28 s */
 
-#define DSR_CONFVAR_SENDBUFFER_CLEANUP_INTERVAL_SECS           1
+#define DSR_CONFVAR_SENDBUFFER_RUN_INTERVAL_USECS          10000 /* drain queues, expire msgs */
 #define DSR_CONFVAR_SENDBUFFER_TIMEOUT                  20000000 /* cli: set sendbuffer_timeout */
+#define DSR_CONFVAR_SENDBUFFER_WHEEL_TICK_USECS           100000 /* timeout granularity */
+#define DSR_CONFVAR_SENDBUFFER_WHEEL_SLOTS                   256 /* one revolution covers the default timeout */
+#define DSR_CONFVAR_SENDBUFFER_MAX_PACKETS                  1024
+#define DSR_CONFVAR_SENDBUFFER_MAX_BYTES                 1048576 /* hlen + plen of all buffered msgs */
+#define DSR_CONFVAR_SENDBUFFER_MAX_PACKETS_PER_DEST           64
+#define DSR_CONFVAR_SENDBUFFER_DRAIN_RATE                    500 /* cli: set sendbuffer_drain_rate (msgs/s, 0: unpaced) */
+#define DSR_CONFVAR_SENDBUFFER_DRAIN_BURST                    16 /* cli: set sendbuffer_drain_burst */
 
 #define DSR_CONFVAR_RREQTABLE_CLEANUP_INTERVAL_SECS           60
 #define DSR_CONFVAR_ROUTEDISCOVERY_TIMEOUT               1000000 /* cli: set routediscovery_timeout */
 #define DSR_CONFVAR_ROUTEDISCOVERY_MAXIMUM_RETRIES             3
 #define DSR_CONFVAR_ROUTEDISCOVERY_EXPANDING_RING_SEARCH       0
 
-#if (PROTOCOL == SMR || PROTOCOL == BACKUPPATH_VARIANT_1 || PROTOCOL == BACKUPPATH_VARIANT_2)
 #define DSR_CONFVAR_SMR_RREQCACHE_NEIGHBOR_LIST_MAX_LEN       30
 #define DSR_CONFVAR_SMR_RREQCACHE_REPLY_TIMEOUT_MSECS    1000000
-#endif
 
-#if (METRIC == ETX)
-#define DSR_CONFVAR_ETX_PROBE_RATE_SECS                        1
+#define DSR_CONFVAR_ETX_PROBE_INTERVAL_MSECS                 250
 #define DSR_CONFVAR_ETX_WINDOW_SIZE_SECS                      16
+#define DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES                 (DSR_CONFVAR_ETX_WINDOW_SIZE_SECS * 1000 / DSR_CONFVAR_ETX_PROBE_INTERVAL_MSECS) /* at most 64 */
 #define DSR_CONFVAR_ETX_LAST_SEEN_TIME_SECS                (2 * DSR_CONFVAR_ETX_WINDOW_SIZE_SECS)
-#endif
 
-#if (LINKCACHE == 1)
 #define DSR_CONFVAR_DIJKSTRA_SECS                              4
-#endif
+
+#define DSR_CONFVAR_COMPACT_SOURCE                             0 /* cli: set compact_source (0 off, 1 ids, 2 flows) */
+#define DSR_CONFVAR_COMPACT_SOURCE_REFRESH_PACKETS            32 /* every n-th msg of a flow carries the ids */
+#define DSR_CONFVAR_COMPACT_SOURCE_FLOW_TIMEOUT_SECS          10 /* relays forget idle flows */
+#define DSR_CONFVAR_COMPACT_SOURCE_CLEANUP_INTERVAL_SECS       5
 
 #include <stdlib.h>
 #include <unistd.h>
@@ -204,22 +227,17 @@
 #include "conf.h"
 #include "statistics.h"
 #include "extensions.h"
-
-#if (METRIC == ETX)
 #include "etx.h"
-#endif
-
 #include "helper.h"
+#include "pathset.h"
 #include "blacklist.h"
-
-#if (LINKCACHE == 1)
 #include "linkcache.h"
-#endif
-
 #include "sendbuffer.h"
 #include "rreqtable.h"
 #include "routecache.h"
+#include "compact_source.h"
 #include "maintenance_buffer.h"
+#include "variant.h"
 
 #include "alloc_cache.h"
 
@@ -27,29 +27,53 @@
 
 #include "dsr.h"
 
-#if (METRIC == ETX)
+/*
+ * Every link (local interface -> remote host) is kept once in the link
+ * table, addressed by its id, with the window of the broadcast and of the
+ * unicast probes. The ETX of a window is computed when a probe is counted
+ * or the window advances and kept with it, so looking up a hop weight is
+ * finding the id of the link and nothing else. The ids are found by
+ * (local, remote) in an open addressing index; the periodic tasks walk
+ * the link table.
+ */
+
+#if (DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES > 64 || DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES < 1)
+#error "the ETX window has to fit into 64 probes"
+#endif
 
 pthread_rwlock_t _dsr_etx_rwlock = PTHREAD_RWLOCK_INITIALIZER;
 #define _ETX_READLOCK pthread_rwlock_rdlock(&_dsr_etx_rwlock)
 #define _ETX_WRITELOCK pthread_rwlock_wrlock(&_dsr_etx_rwlock)
 #define _ETX_UNLOCK pthread_rwlock_unlock(&_dsr_etx_rwlock)
 
-#define ETX_DATA_TYPE_BROADCAST 0
-#define ETX_DATA_TYPE_UNICAST   1
+#define _ETX_INFINITE ((UINT16_MAX) / 100)
+
+/* unicast probes are only sent over links with a broadcast ETX up to this */
+#define _ETX_UNICAST_PROBE_THRESHOLD 7.0
 
 int etx_time = 0;
-int unicast_etx_time = 0;
-dsr_etx_window_data_t* etx_data = NULL;
-dsr_etx_window_data_t* unicast_etx_data = NULL;
 
+static dsr_etx_link_t** _links = NULL;      /* by dsr_etx_link_t.id */
+static uint32_t _links_len = 0;             /* ids handed out so far */
+static uint32_t _links_size = 0;
+static uint32_t* _free_id = NULL;           /* stack of unused ids below _links_len */
+static uint32_t _free_id_len = 0;
+static uint32_t* _index = NULL;             /* link ids by hash of (local, remote), linear probing */
+static uint32_t _index_size = 0;            /* a power of two, at least twice the links */
+static uint32_t _index_len = 0;             /* links in the index */
 
 /* local forward declarations */
 static inline void _count_probe(int etx_data_type, const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN], uint8_t my_probes);
-static inline uint8_t _extract_my_probes(const uint8_t local[ETHER_ADDR_LEN], const uint8_t len, const dsr_etx_data_t data[DSR_ETX_MAX_DATA_IN_EXTENSION]);
-static inline uint8_t _get_probes_received_in_window(const dsr_etx_window_data_t* data);
-static inline double _get_value_by_window_data(dsr_etx_window_data_t* data);
-static inline dsr_etx_window_data_t* _get_window_data_by_key(int etx_data_type, const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]);
-static inline dsr_etx_window_data_t* _new_window_data(int etx_data_type, const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]);
+static inline uint8_t _extract_my_probes(const uint8_t local[ETHER_ADDR_LEN], const dsr_etx_ext_t* etx);
+static inline uint8_t _get_probes_received_in_window(const dsr_etx_window_t* window);
+static inline void _update_value(dsr_etx_window_t* window);
+static inline dsr_etx_link_t* _get_link_by_key(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]);
+static inline void _index_add(dsr_etx_link_t* link);
+static inline void _index_remove(dsr_etx_link_t* link);
+static inline dsr_etx_link_t* _new_link(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]);
+static inline void _remove_link(dsr_etx_link_t* link);
+static inline void _reset_window(dsr_etx_window_t* window);
+static inline int _print_links(struct cli_def* cli, int etx_data_type);
 static inline double _etx_w_r(void);
 static inline double _etx_d_f(uint8_t my_probes);
 static inline double _etx_d_r(uint8_t probes_received);
@@ -58,15 +82,15 @@ static inline double _etx_d_r(uint8_t probes_received);
 inline double dsr_etx_get_value(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]) {
     _ETX_READLOCK;
 
-    dsr_etx_window_data_t* data = _get_window_data_by_key(ETX_DATA_TYPE_BROADCAST, local, remote);
+    dsr_etx_link_t* link = _get_link_by_key(local, remote);
 
-    if(data == NULL) {
+    if(link == NULL || !link->window[ETX_DATA_TYPE_BROADCAST].active) {
         dessert_err("window data is NULL for link (" MAC ")-(" MAC ")", EXPLODE_ARRAY6(local), EXPLODE_ARRAY6(remote));
         _ETX_UNLOCK;
-        return ((UINT16_MAX) / 100);
+        return _ETX_INFINITE;
     }
 
-    double value = _get_value_by_window_data(data);
+    double value = link->window[ETX_DATA_TYPE_BROADCAST].value;
     _ETX_UNLOCK;
 
     return value;
@@ -75,15 +99,15 @@ inline double dsr_etx_get_value(const uint8_t local[ETHER_ADDR_LEN], const uint8
 inline double dsr_unicast_etx_get_value(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]) {
     _ETX_READLOCK;
 
-    dsr_etx_window_data_t* data = _get_window_data_by_key(ETX_DATA_TYPE_UNICAST, local, remote);
+    dsr_etx_link_t* link = _get_link_by_key(local, remote);
 
-    if(data == NULL) {
+    if(link == NULL || !link->window[ETX_DATA_TYPE_UNICAST].active) {
         dessert_err("unicast window data is NULL for link (" MAC ")-(" MAC ")", EXPLODE_ARRAY6(local), EXPLODE_ARRAY6(remote));
         _ETX_UNLOCK;
-        return ((UINT16_MAX) / 100);
+        return _ETX_INFINITE;
     }
 
-    double value = _get_value_by_window_data(data);
+    double value = link->window[ETX_DATA_TYPE_UNICAST].value;
     _ETX_UNLOCK;
     return value;
 }
@@ -91,15 +115,15 @@ inline double dsr_unicast_etx_get_value(const uint8_t local[ETHER_ADDR_LEN], con
 inline double dsr_etx_get_forward_value(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]) {
     _ETX_READLOCK;
 
-    dsr_etx_window_data_t* data = _get_window_data_by_key(ETX_DATA_TYPE_BROADCAST, local, remote);
+    dsr_etx_link_t* link = _get_link_by_key(local, remote);
 
-    if(data == NULL) {
+    if(link == NULL || !link->window[ETX_DATA_TYPE_BROADCAST].active) {
         dessert_err("window data is NULL for link (" MAC ")-(" MAC ")", EXPLODE_ARRAY6(local), EXPLODE_ARRAY6(remote));
         _ETX_UNLOCK;
         return 0;
     }
 
-    uint8_t my_probes = data->my_probes;
+    uint8_t my_probes = link->window[ETX_DATA_TYPE_BROADCAST].my_probes;
 
     _ETX_UNLOCK;
 
@@ -110,6 +134,24 @@ inline uint16_t dsr_etx_encode(double etx) {
     return etx * 100;
 }
 
+/** ETX metric: the encoded ETX of the link between @a local and @a remote. */
+inline uint16_t dsr_etx_get_hop_weight(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]) {
+    _ETX_READLOCK;
+
+    dsr_etx_link_t* link = _get_link_by_key(local, remote);
+
+    if(link == NULL || !link->window[ETX_DATA_TYPE_BROADCAST].active) {
+        dessert_err("window data is NULL for link (" MAC ")-(" MAC ")", EXPLODE_ARRAY6(local), EXPLODE_ARRAY6(remote));
+        _ETX_UNLOCK;
+        return dsr_etx_encode(_ETX_INFINITE);
+    }
+
+    uint16_t weight = link->window[ETX_DATA_TYPE_BROADCAST].weight;
+    _ETX_UNLOCK;
+
+    return weight;
+}
+
 dessert_cb_result etx_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, dessert_meshif_t* iface, dessert_frameid_t id) {
     dessert_ext_t* etx_ext;
     dsr_etx_ext_t* etx;
@@ -121,7 +163,7 @@ dessert_cb_result etx_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc
         etx = (dsr_etx_ext_t*) etx_ext->data;
     }
 
-    uint8_t my_probes = _extract_my_probes(iface->hwaddr, etx->len, etx->data);
+    uint8_t my_probes = _extract_my_probes(iface->hwaddr, etx);
 
     _ETX_WRITELOCK;
     _count_probe(ETX_DATA_TYPE_BROADCAST, iface->hwaddr, msg->l2h.ether_shost, my_probes);
@@ -145,7 +187,7 @@ int unicast_etx_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* pr
         return DESSERT_MSG_DROP;
     }
 
-    uint8_t my_probes = _extract_my_probes(iface->hwaddr, etx->len, etx->data);
+    uint8_t my_probes = _extract_my_probes(iface->hwaddr, etx);
 
     _ETX_WRITELOCK;
     _count_probe(ETX_DATA_TYPE_UNICAST, iface->hwaddr, msg->l2h.ether_shost, my_probes);
@@ -165,6 +207,7 @@ inline dsr_etx_ext_t* dsr_msg_add_etx_ext(dessert_msg_t* msg, uint8_t ETX_TYPE)
 
     etx = (dsr_etx_ext_t*) etx_ext->data;
     etx->len = 0;
+    etx->window = DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES;
     memset(etx->data, 170, DSR_ETX_DATA_LENGTH); /* 170 is 10101010 */
 
     return etx;
@@ -177,49 +220,11 @@ inline dsr_etx_ext_t* dsr_msg_add_etx_ext(dessert_msg_t* msg, uint8_t ETX_TYPE)
  ******************************************************************************/
 
 int dessert_cli_cmd_showetx(struct cli_def* cli, char* command, char* argv[], int argc) {
-    dsr_etx_window_data_t* data;
-
-    _ETX_READLOCK;
-
-    double etx;
-    int encoded;
-    int i = 0;
-
-    HASH_FOREACH(hh, etx_data, data) {
-        i++;
-        etx = _get_value_by_window_data(data);
-        encoded = dsr_etx_encode(etx);
-        cli_print(cli,
-                  "[%03d] local interface [" MAC "] remote host [" MAC "] ETX [%03.2f] encoded [%06d] my_probes [%02u] probes_received [%02u]",
-                  i, EXPLODE_ARRAY6(data->local_address), EXPLODE_ARRAY6(data->remote_address), etx, encoded,
-                  data->my_probes, _get_probes_received_in_window(data));
-    }
-
-    _ETX_UNLOCK;
-
-    return CLI_OK;
+    return _print_links(cli, ETX_DATA_TYPE_BROADCAST);
 }
 
 int dessert_cli_cmd_showunicastetx(struct cli_def* cli, char* command, char* argv[], int argc) {
-    dsr_etx_window_data_t* data;
-
-    _ETX_READLOCK;
-    double etx;
-    int encoded;
-    int i = 0;
-
-    HASH_FOREACH(hh, unicast_etx_data, data) {
-        i++;
-        etx = _get_value_by_window_data(data);
-        encoded = dsr_etx_encode(etx);
-        cli_print(cli,
-                  "[%03d] local interface [" MAC "] remote host [" MAC "] ETX [%03.2f] encoded [%06d] my_probes [%02u] probes_received [%02u]",
-                  i, EXPLODE_ARRAY6(data->local_address), EXPLODE_ARRAY6(data->remote_address), etx, encoded,
-                  data->my_probes, _get_probes_received_in_window(data));
-    }
-    _ETX_UNLOCK;
-
-    return CLI_OK;
+    return _print_links(cli, ETX_DATA_TYPE_UNICAST);
 }
 
 /******************************************************************************
@@ -228,30 +233,73 @@ int dessert_cli_cmd_showunicastetx(struct cli_def* cli, char* command, char* arg
  *
  ******************************************************************************/
 
+/** Sends the broadcast probe and the unicast probes of every interface,
+ *  then advances the broadcast and unicast windows of all links. */
 dessert_per_result_t dsr_etx_send_probes(void* data, struct timeval* scheduled, struct timeval* interval) {
-    dsr_etx_window_data_t* el;
-
+    dsr_etx_link_t* link;
     dessert_meshif_t* meshif;
     dessert_msg_t* etx_msg;
+    dessert_msg_t* unicast_etx_msg;
     dsr_etx_ext_t* etx;
+    dsr_etx_ext_t* unicast_etx;
     dsr_etx_data_t* piggy_data;
+    uint32_t id;
     int len = 0;
+
+    _ETX_WRITELOCK;
+
+    /* probe the links good enough to carry unicast traffic with unicast probes, too */
+    for(id = 0; id < _links_len; id++) {
+        link = _links[id];
+
+        if(link != NULL && !link->window[ETX_DATA_TYPE_UNICAST].active
+           && link->window[ETX_DATA_TYPE_BROADCAST].active
+           && link->window[ETX_DATA_TYPE_BROADCAST].value <= _ETX_UNICAST_PROBE_THRESHOLD) {
+            link->window[ETX_DATA_TYPE_UNICAST].active = 1;
+            gettimeofday(&link->window[ETX_DATA_TYPE_UNICAST].last_probe, NULL);
+        }
+    }
+
+    _ETX_UNLOCK;
+
     MESHIFLIST_ITERATOR_START(meshif) {
         dessert_msg_new(&etx_msg);
         etx = dsr_msg_add_etx_ext(etx_msg, DSR_EXT_ETX);
-        //		dsr_msg_add_etx_ext(etx_msg, DSR_EXT_ETX);
-        //		dsr_msg_add_etx_ext(etx_msg, DSR_EXT_ETX);
-        //		dsr_msg_add_etx_ext(etx_msg, DSR_EXT_ETX);
-        /* could be heavily optimized --> store neighbors per interface */
+
+        dessert_msg_new(&unicast_etx_msg);
+        unicast_etx = dsr_msg_add_etx_ext(unicast_etx_msg, DSR_EXT_UNICAST_ETX);
+        dsr_msg_add_etx_ext(unicast_etx_msg, DSR_EXT_UNICAST_ETX);
+        dsr_msg_add_etx_ext(unicast_etx_msg, DSR_EXT_UNICAST_ETX);
+        dsr_msg_add_etx_ext(unicast_etx_msg, DSR_EXT_UNICAST_ETX);
+
         len = 0;
         _ETX_READLOCK;
-        HASH_FOREACH(hh, etx_data, el) {
-            if(ADDR_CMP(el->local_address, meshif->hwaddr) == 0) {
+
+        for(id = 0; id < _links_len; id++) {
+            link = _links[id];
+
+            if(link == NULL || ADDR_CMP(link->local_address, meshif->hwaddr) != 0) {
+                continue;
+            }
+
+            if(link->window[ETX_DATA_TYPE_BROADCAST].active && len < DSR_ETX_MAX_DATA_IN_EXTENSION) {
                 piggy_data = &etx->data[len++];
-                ADDR_CPY(piggy_data->address, el->remote_address);
-                piggy_data->probes_received = _get_probes_received_in_window(el);
+                ADDR_CPY(piggy_data->address, link->remote_address);
+                piggy_data->probes_received = _get_probes_received_in_window(&link->window[ETX_DATA_TYPE_BROADCAST]);
+            }
+
+            if(link->window[ETX_DATA_TYPE_UNICAST].active) {
+                piggy_data = &unicast_etx->data[0];
+                ADDR_CPY(piggy_data->address, link->remote_address);
+                piggy_data->probes_received = _get_probes_received_in_window(&link->window[ETX_DATA_TYPE_UNICAST]);
+
+                unicast_etx->len = 1;
+                ADDR_CPY(unicast_etx_msg->l2h.ether_dhost, link->remote_address);
+                dsr_statistics_emit_msg(meshif->hwaddr, unicast_etx_msg->l2h.ether_dhost, unicast_etx_msg);
+                dessert_meshsend_fast(unicast_etx_msg, meshif);
             }
         }
+
         etx->len = len;
         _ETX_UNLOCK;
 
@@ -260,120 +308,73 @@ dessert_per_result_t dsr_etx_send_probes(void* data, struct timeval* scheduled,
         dsr_statistics_emit_msg(meshif->hwaddr, etx_msg->l2h.ether_dhost, etx_msg);
         dessert_meshsend_fast(etx_msg, meshif);
         dessert_msg_destroy(etx_msg);
+        dessert_msg_destroy(unicast_etx_msg);
     }
     MESHIFLIST_ITERATOR_STOP;
 
     _ETX_WRITELOCK;
     /* increment etx time MODULO etx window size*/
-    etx_time = etx_time + 1 ;
-    etx_time = etx_time % DSR_CONFVAR_ETX_WINDOW_SIZE_SECS;
+    etx_time = (etx_time + 1) % DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES;
 
-    /* clear the corresponding bit in all etx windows*/
-    HASH_FOREACH(hh, etx_data, el) {
-        el->probes &= ~(1 << etx_time);
-    }
-    _ETX_UNLOCK;
+    /* clear the corresponding bit in all etx windows, only those losing a probe change their ETX */
+    for(id = 0; id < _links_len; id++) {
+        link = _links[id];
 
-    return DESSERT_PER_KEEP;
-}
-
-dessert_per_result_t dsr_unicastetx_send_probes(void* data, struct timeval* scheduled, struct timeval* interval) {
-    dsr_etx_window_data_t* el;
-    dsr_etx_window_data_t* unicast_el;
-
-    dessert_meshif_t* meshif;
-    dessert_msg_t* etx_msg;
-    dsr_etx_ext_t* etx;
-    dsr_etx_data_t* piggy_data;
-
-    _ETX_WRITELOCK;
-    HASH_FOREACH(hh, etx_data, el) {
-        if(_get_value_by_window_data(el) <= 7.0) {
-            unicast_el = _get_window_data_by_key(ETX_DATA_TYPE_UNICAST, el->local_address, el->remote_address);
-            if(unicast_el == NULL) {
-                unicast_el = _new_window_data(ETX_DATA_TYPE_UNICAST, el->local_address, el->remote_address);
-            }
+        if(link == NULL) {
+            continue;
         }
-    }
-    el = NULL;
-    _ETX_UNLOCK;
 
-    MESHIFLIST_ITERATOR_START(meshif) {
-        dessert_msg_new(&etx_msg);
-        etx = dsr_msg_add_etx_ext(etx_msg, DSR_EXT_UNICAST_ETX);
-        dsr_msg_add_etx_ext(etx_msg, DSR_EXT_UNICAST_ETX);
-        dsr_msg_add_etx_ext(etx_msg, DSR_EXT_UNICAST_ETX);
-        dsr_msg_add_etx_ext(etx_msg, DSR_EXT_UNICAST_ETX);
+        int type;
 
-        /* could be heavily optimized --> store neighbors per interface */
-        _ETX_READLOCK;
-        HASH_FOREACH(hh, unicast_etx_data, el) {
-            if(ADDR_CMP(el->local_address, meshif->hwaddr) == 0) {
-                piggy_data = &etx->data[0];
-                ADDR_CPY(piggy_data->address, el->remote_address);
-                piggy_data->probes_received = _get_probes_received_in_window(el);
-
-                etx->len = 1;
-                ADDR_CPY(etx_msg->l2h.ether_dhost, el->remote_address);
-                dsr_statistics_emit_msg(meshif->hwaddr, etx_msg->l2h.ether_dhost, etx_msg);
-                dessert_meshsend_fast(etx_msg, meshif);
+        for(type = ETX_DATA_TYPE_BROADCAST; type <= ETX_DATA_TYPE_UNICAST; type++) {
+            dsr_etx_window_t* window = &link->window[type];
+
+            if(window->probes & ((uint64_t) 1 << etx_time)) {
+                window->probes &= ~((uint64_t) 1 << etx_time);
+                _update_value(window);
             }
         }
-        _ETX_UNLOCK;
-        dessert_msg_destroy(etx_msg);
     }
-    MESHIFLIST_ITERATOR_STOP;
 
-    _ETX_WRITELOCK;
-    /* increment unietx time MODULO etx window size*/
-    unicast_etx_time = unicast_etx_time + 1 ;
-    unicast_etx_time = unicast_etx_time % DSR_CONFVAR_ETX_WINDOW_SIZE_SECS;
-
-    /* clear the corresponding bit in all unietx windows*/
-    HASH_FOREACH(hh, unicast_etx_data, el) {
-        el->probes &= ~(1 << unicast_etx_time);
-    }
     _ETX_UNLOCK;
 
     return DESSERT_PER_KEEP;
 }
 
 dessert_per_result_t dsr_etx_cleanup(void* data, struct timeval* scheduled, struct timeval* interval) {
-    dsr_etx_window_data_t* window_data = NULL;
-    dsr_etx_window_data_t* next_window_data = NULL;
-
-    _ETX_WRITELOCK;
+    dsr_etx_link_t* link;
+    struct timeval now;
+    uint32_t id;
 
-    window_data = etx_data;
+    if(scheduled == NULL) {
+        gettimeofday(&now, NULL);
+        scheduled = &now;
+    }
 
-    while(window_data) {
-        next_window_data = window_data->hh.next;
+    _ETX_WRITELOCK;
 
-        if(window_data->last_probe.tv_sec
-           + DSR_CONFVAR_ETX_LAST_SEEN_TIME_SECS < scheduled->tv_sec) {
+    for(id = 0; id < _links_len; id++) {
+        link = _links[id];
 
-            HASH_DELETE(hh, etx_data, window_data);
-            dessert_info("ETX: Removing link " MAC " <--> " MAC " . No probes were received for %u seconds.", EXPLODE_ARRAY6(window_data->local_address), EXPLODE_ARRAY6(window_data->remote_address), DSR_CONFVAR_ETX_LAST_SEEN_TIME_SECS);
-            free(window_data);
-            window_data = NULL;
+        if(link == NULL) {
+            continue;
         }
 
-        window_data = next_window_data;
-    }
-
-    window_data = unicast_etx_data;
-
-    while(window_data) {
-        next_window_data = window_data->hh.next;
+        if(link->window[ETX_DATA_TYPE_BROADCAST].active
+           && link->window[ETX_DATA_TYPE_BROADCAST].last_probe.tv_sec + DSR_CONFVAR_ETX_LAST_SEEN_TIME_SECS < scheduled->tv_sec) {
+            dessert_info("ETX: Removing link " MAC " <--> " MAC " . No probes were received for %u seconds.", EXPLODE_ARRAY6(link->local_address), EXPLODE_ARRAY6(link->remote_address), DSR_CONFVAR_ETX_LAST_SEEN_TIME_SECS);
+            _reset_window(&link->window[ETX_DATA_TYPE_BROADCAST]);
+        }
 
-        if(window_data->last_probe.tv_sec + DSR_CONFVAR_ETX_LAST_SEEN_TIME_SECS < scheduled->tv_sec) {
-            HASH_DELETE(hh, unicast_etx_data, window_data);
-            dessert_info("UNICASTETX: Removing link " MAC " <--> " MAC " . No probes were received for %u seconds.", EXPLODE_ARRAY6(window_data->local_address), EXPLODE_ARRAY6(window_data->remote_address), DSR_CONFVAR_ETX_LAST_SEEN_TIME_SECS);
-            free(window_data);
-            window_data = NULL;
+        if(link->window[ETX_DATA_TYPE_UNICAST].active
+           && link->window[ETX_DATA_TYPE_UNICAST].last_probe.tv_sec + DSR_CONFVAR_ETX_LAST_SEEN_TIME_SECS < scheduled->tv_sec) {
+            dessert_info("UNICASTETX: Removing link " MAC " <--> " MAC " . No probes were received for %u seconds.", EXPLODE_ARRAY6(link->local_address), EXPLODE_ARRAY6(link->remote_address), DSR_CONFVAR_ETX_LAST_SEEN_TIME_SECS);
+            _reset_window(&link->window[ETX_DATA_TYPE_UNICAST]);
         }
 
-        window_data = next_window_data;
+        if(!link->window[ETX_DATA_TYPE_BROADCAST].active && !link->window[ETX_DATA_TYPE_UNICAST].active) {
+            _remove_link(link);
+        }
     }
 
     _ETX_UNLOCK;
@@ -388,33 +389,46 @@ dessert_per_result_t dsr_etx_cleanup(void* data, struct timeval* scheduled, stru
  ******************************************************************************/
 
 
-static inline uint8_t _get_probes_received_in_window(const dsr_etx_window_data_t* data) {
-    if(data == NULL) {
+static inline uint8_t _get_probes_received_in_window(const dsr_etx_window_t* window) {
+    if(window == NULL) {
         return 0;
     }
 
-    return __builtin_popcount(data->probes);
+    return __builtin_popcountll(window->probes);
 }
 
-static inline double _get_value_by_window_data(dsr_etx_window_data_t* data) {
-    assert(data != NULL);
-
-    uint8_t my_probes = data->my_probes;
-    uint8_t probes_received = _get_probes_received_in_window(data);
+/** computes the ETX of @a window, after its probes or my_probes changed */
+static inline void _update_value(dsr_etx_window_t* window) {
+    uint8_t my_probes = window->my_probes;
+    uint8_t probes_received = _get_probes_received_in_window(window);
 
     if(my_probes == 0 || probes_received == 0) {
-        return ((UINT16_MAX) / 100);
+        window->value = _ETX_INFINITE;
+    }
+    else {
+        window->value = 1 / (_etx_d_f(my_probes) * _etx_d_r(probes_received));
     }
 
-    return 1 / (_etx_d_f(my_probes) * _etx_d_r(probes_received));
+    window->weight = dsr_etx_encode(window->value);
 }
 
-static inline uint8_t _extract_my_probes(const uint8_t local[ETHER_ADDR_LEN], const uint8_t len, const dsr_etx_data_t data[DSR_ETX_MAX_DATA_IN_EXTENSION]) {
+/** the probes of @a local counted by the sender of @a etx, scaled from its window to ours */
+static inline uint8_t _extract_my_probes(const uint8_t local[ETHER_ADDR_LEN], const dsr_etx_ext_t* etx) {
     int i = 0;
 
-    for(; i < len; i++) {
-        if(ADDR_CMP(data[i].address, local) == 0) {
-            return data[i].probes_received;
+    if(etx->window == 0) {
+        return 0;
+    }
+
+    for(; i < etx->len && i < DSR_ETX_MAX_DATA_IN_EXTENSION; i++) {
+        if(ADDR_CMP(etx->data[i].address, local) == 0) {
+            uint32_t probes = etx->data[i].probes_received;
+
+            if(etx->window != DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES) {
+                probes = (probes * DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES + etx->window / 2) / etx->window;
+            }
+
+            return (probes < DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES) ? probes : DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES;
         }
     }
 
@@ -422,74 +436,183 @@ static inline uint8_t _extract_my_probes(const uint8_t local[ETHER_ADDR_LEN], co
 }
 
 static inline void _count_probe(int etx_data_type, const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN], uint8_t my_probes) {
-    dsr_etx_window_data_t* data = NULL;
+    dsr_etx_link_t* link = NULL;
 
-    data = _get_window_data_by_key(etx_data_type, local, remote);
+    link = _get_link_by_key(local, remote);
 
-    if(data == NULL) {
-        data = _new_window_data(etx_data_type, local, remote);
+    if(link == NULL) {
+        link = _new_link(local, remote);
     }
 
-    assert(data != NULL);
+    assert(link != NULL);
+
+    dsr_etx_window_t* window = &link->window[etx_data_type];
+    uint64_t probes = window->probes | ((uint64_t) 1 << etx_time);
 
-    gettimeofday(&data->last_probe, NULL);
+    gettimeofday(&window->last_probe, NULL);
+    window->active = 1;
 
-    if(etx_data_type == ETX_DATA_TYPE_BROADCAST) {
-        data->probes |= 1 << etx_time;
+    if(probes != window->probes || my_probes != window->my_probes) {
+        window->probes = probes;
+        window->my_probes = my_probes;
+        _update_value(window);
     }
-    else {
-        data->probes |= 1 << unicast_etx_time;
+}
+
+static inline dsr_etx_link_t* _get_link_by_key(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]) {
+    if(_index_len == 0) {
+        return NULL;
     }
 
-    data->my_probes = my_probes;
+    uint32_t mask = _index_size - 1;
+    uint32_t i = ADDR_PAIR_HASH(local, remote) & mask;
+
+    while(_index[i] != DSR_ETX_NO_LINK) {
+        dsr_etx_link_t* link = _links[_index[i]];
 
+        if(ADDR_CMP(link->remote_address, remote) == 0 && ADDR_CMP(link->local_address, local) == 0) {
+            return link;
+        }
+
+        i = (i + 1) & mask;
+    }
+
+    return NULL;
 }
 
-static inline dsr_etx_window_data_t* _get_window_data_by_key(int etx_data_type, const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]) {
-    dsr_etx_window_data_t* data = NULL;
-    dsr_etx_window_data_lookup_key_t lookup_key;
+/** puts @a link into the index, growing it to keep it at most half full */
+static inline void _index_add(dsr_etx_link_t* link) {
+    uint32_t i;
 
-    ADDR_CPY(lookup_key.local_address, local);
-    ADDR_CPY(lookup_key.remote_address, remote);
+    if(2 * (_index_len + 1) > _index_size) {
+        uint32_t id;
 
-    if(etx_data_type == ETX_DATA_TYPE_BROADCAST) {
-        HASH_FIND(hh, etx_data, &lookup_key, DSR_ETX_WINDOW_DATA_LOOKUP_KEY_SIZE, data);
-    }
-    else {
-        HASH_FIND(hh, unicast_etx_data, &lookup_key, DSR_ETX_WINDOW_DATA_LOOKUP_KEY_SIZE, data);
+        _index_size = _index_size ? 2 * _index_size : 128;
+        _index = realloc(_index, _index_size * sizeof(uint32_t));
+        assert(_index != NULL);
+
+        for(i = 0; i < _index_size; i++) {
+            _index[i] = DSR_ETX_NO_LINK;
+        }
+
+        _index_len = 0;
+
+        for(id = 0; id < _links_len; id++) {
+            if(_links[id] != NULL && _links[id] != link) {
+                _index_add(_links[id]);
+            }
+        }
     }
 
-    return data;
+    for(i = link->hash & (_index_size - 1); _index[i] != DSR_ETX_NO_LINK; i = (i + 1) & (_index_size - 1));
+
+    _index[i] = link->id;
+    _index_len++;
 }
 
-static inline dsr_etx_window_data_t* _new_window_data(int etx_data_type, const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]) {
-    dsr_etx_window_data_t* data = NULL;
+/** takes @a link out of the index, moving back the links probed past it */
+static inline void _index_remove(dsr_etx_link_t* link) {
+    uint32_t mask = _index_size - 1;
+    uint32_t i = link->hash & mask;
+    uint32_t j;
 
-    struct timeval now;
-    gettimeofday(&now, NULL);
+    while(_index[i] != link->id) {
+        i = (i + 1) & mask;
+    }
+
+    for(j = (i + 1) & mask; _index[j] != DSR_ETX_NO_LINK; j = (j + 1) & mask) {
+        uint32_t home = _links[_index[j]]->hash & mask;
+
+        /* the link at j may move to i if its home slot is not in (i, j] */
+        if(((j - home) & mask) >= ((j - i) & mask)) {
+            _index[i] = _index[j];
+            i = j;
+        }
+    }
+
+    _index[i] = DSR_ETX_NO_LINK;
+    _index_len--;
+}
+
+static inline dsr_etx_link_t* _new_link(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]) {
+    dsr_etx_link_t* link = NULL;
 
-    data = malloc(sizeof(dsr_etx_window_data_t));
-    assert(data != NULL);
+    link = malloc(sizeof(dsr_etx_link_t));
+    assert(link != NULL);
 
-    ADDR_CPY(data->local_address, local);
-    ADDR_CPY(data->remote_address, remote);
-    data->probes = 0;
-    data->my_probes = 0;
-    data->last_probe.tv_sec = now.tv_sec;
-    data->last_probe.tv_usec = now.tv_usec;
+    ADDR_CPY(link->local_address, local);
+    ADDR_CPY(link->remote_address, remote);
+    _reset_window(&link->window[ETX_DATA_TYPE_BROADCAST]);
+    _reset_window(&link->window[ETX_DATA_TYPE_UNICAST]);
 
-    if(etx_data_type == ETX_DATA_TYPE_BROADCAST) {
-        HASH_ADD(hh, etx_data, local_address, DSR_ETX_WINDOW_DATA_LOOKUP_KEY_SIZE, data);
+    /* reuse a free id before handing out a new one */
+    if(_free_id_len > 0) {
+        link->id = _free_id[--_free_id_len];
     }
     else {
-        HASH_ADD(hh, unicast_etx_data, local_address, DSR_ETX_WINDOW_DATA_LOOKUP_KEY_SIZE, data);
+        if(_links_len == _links_size) {
+            _links_size = _links_size ? 2 * _links_size : 64;
+            _links = realloc(_links, _links_size * sizeof(dsr_etx_link_t*));
+            _free_id = realloc(_free_id, _links_size * sizeof(uint32_t));
+            assert(_links != NULL && _free_id != NULL);
+        }
+
+        link->id = _links_len++;
     }
 
-    return data;
+    _links[link->id] = link;
+    link->hash = ADDR_PAIR_HASH(local, remote);
+    _index_add(link);
+
+    return link;
+}
+
+static inline void _remove_link(dsr_etx_link_t* link) {
+    _index_remove(link);
+    _links[link->id] = NULL;
+    _free_id[_free_id_len++] = link->id;
+    free(link);
+}
+
+static inline void _reset_window(dsr_etx_window_t* window) {
+    window->probes = 0;
+    window->my_probes = 0;
+    window->active = 0;
+    window->last_probe.tv_sec = 0;
+    window->last_probe.tv_usec = 0;
+    _update_value(window);
+}
+
+static inline int _print_links(struct cli_def* cli, int etx_data_type) {
+    dsr_etx_link_t* link;
+    uint32_t id;
+    int i = 0;
+
+    _ETX_READLOCK;
+
+    for(id = 0; id < _links_len; id++) {
+        link = _links[id];
+
+        if(link == NULL || !link->window[etx_data_type].active) {
+            continue;
+        }
+
+        dsr_etx_window_t* window = &link->window[etx_data_type];
+
+        i++;
+        cli_print(cli,
+                  "[%03d] local interface [" MAC "] remote host [" MAC "] ETX [%03.2f] encoded [%06d] my_probes [%02u] probes_received [%02u]",
+                  i, EXPLODE_ARRAY6(link->local_address), EXPLODE_ARRAY6(link->remote_address), window->value, window->weight,
+                  window->my_probes, _get_probes_received_in_window(window));
+    }
+
+    _ETX_UNLOCK;
+
+    return CLI_OK;
 }
 
 static inline double _etx_w_r(void) {
-    return DSR_CONFVAR_ETX_WINDOW_SIZE_SECS / DSR_CONFVAR_ETX_PROBE_RATE_SECS;
+    return DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES;
 }
 
 static inline double _etx_d_f(uint8_t my_probes) {
@@ -499,8 +622,3 @@ static inline double _etx_d_f(uint8_t my_probes) {
 static inline double _etx_d_r(uint8_t probes_received) {
     return probes_received / _etx_w_r();
 }
-
-
-#endif /* (METRIC == ETX) */
-
-
@@ -36,13 +36,13 @@
  *
  ******************************************************************************/
 
-#define DSR_ETX_EXTENSION_HDRLEN (sizeof(uint8_t))
+#define DSR_ETX_EXTENSION_HDRLEN (2 * sizeof(uint8_t))
 
 #define DSR_ETX_MAX_DATA_IN_EXTENSION ((DESSERT_MAXEXTDATALEN - DSR_ETX_EXTENSION_HDRLEN) / sizeof(dsr_etx_data_t))
 
 #define DSR_ETX_DATA_LENGTH (DSR_ETX_MAX_DATA_IN_EXTENSION * sizeof(dsr_etx_data_t))
 
-#define DSR_ETX_EXTENSION_LENGTH (DSR_ETX_DATA_LENGTH + sizeof(uint8_t) )
+#define DSR_ETX_EXTENSION_LENGTH (DSR_ETX_DATA_LENGTH + DSR_ETX_EXTENSION_HDRLEN)
 
 typedef struct __attribute__((__packed__)) dsr_etx_data {
     uint8_t address[ETHER_ADDR_LEN];
@@ -51,30 +51,40 @@ typedef struct __attribute__((__packed__)) dsr_etx_data {
 
 typedef struct __attribute__((__packed__)) dsr_etx_ext {
     uint8_t len;
+    uint8_t window;     /* probes in the window of the sender, probes_received counts out of it */
     dsr_etx_data_t data[DSR_ETX_MAX_DATA_IN_EXTENSION];
 } dsr_etx_ext_t;
 
 
-typedef struct __attribute__((__packed__)) dsr_etx_window_data {
-    uint8_t local_address[ETHER_ADDR_LEN];  /* key part 1 */
-    uint8_t remote_address[ETHER_ADDR_LEN]; /* key part 2 */
-    uint16_t probes;   /* reverse delivery probes received by me       (bits set) [up-to-date] */
-    uint8_t my_probes; /* forward delivery probes received by neighbor (count)    [last known] */
+#define ETX_DATA_TYPE_BROADCAST 0
+#define ETX_DATA_TYPE_UNICAST   1
+
+#define DSR_ETX_NO_LINK (UINT32_MAX)
+
+/** the probes of one kind (broadcast or unicast) over a link */
+typedef struct dsr_etx_window {
+    uint64_t probes;    /* reverse delivery probes received by me       (bits set) [up-to-date] */
+    uint8_t my_probes;  /* forward delivery probes received by neighbor (count)    [last known] */
+    uint8_t active;     /* a probe was received or unicast probing was started */
+    uint16_t weight;    /* value, encoded */
+    double value;       /* ETX, recomputed when probes or my_probes change */
     struct timeval last_probe;
-    UT_hash_handle hh;
-} dsr_etx_window_data_t;
+} dsr_etx_window_t;
 
-typedef struct __attribute__((__packed__)) dsr_etx_window_data_lookup_key {
+/** a link of the ETX link table, interned once and addressed by its id */
+typedef struct dsr_etx_link {
     uint8_t local_address[ETHER_ADDR_LEN];  /* key part 1 */
     uint8_t remote_address[ETHER_ADDR_LEN]; /* key part 2 */
-} dsr_etx_window_data_lookup_key_t;
-
-#define DSR_ETX_WINDOW_DATA_LOOKUP_KEY_SIZE (sizeof(dsr_etx_window_data_lookup_key_t))
+    uint32_t id;                            /* index into the link table */
+    uint32_t hash;                          /* of the key, for the link index */
+    dsr_etx_window_t window[2];             /* by ETX_DATA_TYPE_* */
+} dsr_etx_link_t;
 
 
 inline double dsr_etx_get_value(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]);
 inline double dsr_unicast_etx_get_value(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]);
 inline double dsr_etx_get_forward_value(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]);
+inline uint16_t dsr_etx_get_hop_weight(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]);
 
 inline uint16_t dsr_etx_encode(double etx);
 inline uint16_t dsr_etx_encode_to_network(double etx);
@@ -89,7 +99,6 @@ int dessert_cli_cmd_showetx(struct cli_def* cli, char* command, char* argv[], in
 int dessert_cli_cmd_showunicastetx(struct cli_def* cli, char* command, char* argv[], int argc);
 
 dessert_per_result_t dsr_etx_send_probes(void* data, struct timeval* scheduled, struct timeval* interval);
-dessert_per_result_t dsr_unicastetx_send_probes(void* data, struct timeval* scheduled, struct timeval* interval);
 dessert_per_result_t dsr_etx_cleanup(void* data, struct timeval* scheduled,	struct timeval* interval);
 
 
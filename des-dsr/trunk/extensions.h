@@ -36,10 +36,12 @@
 #define DSR_EXT_ACK       DESSERT_EXT_USER+4
 #define DSR_EXT_SOURCE    DESSERT_EXT_USER+5
 
-#if (METRIC == ETX)
-#define DSR_EXT_ETX         DESSERT_EXT_USER+6
-#define DSR_EXT_UNICAST_ETX DESSERT_EXT_USER+7
-#endif
+/* USER+6 and USER+7 carried ETX probes without the window size, counted
+ * out of 16 probes; they are not reused, so older nodes ignore the probes */
+#define DSR_EXT_ETX         DESSERT_EXT_USER+9
+#define DSR_EXT_UNICAST_ETX DESSERT_EXT_USER+10
+
+#define DSR_EXT_COMPACT_SOURCE DESSERT_EXT_USER+8
 
 #define DSR_DONOT_FORWARD_TO_NETWORK_LAYER 0x0001
 #define DSR_REPL_EXTENSION_IN_MSG          0x0002
@@ -306,7 +308,7 @@ typedef struct __attribute__((__packed__)) dsr_ack_ext {
 
 #define dsr_source_get_sizeof(source) (source->opt_data_len +1)
 
-#define dsr_source_get_address_begin_by_index(source, i) (source->address + (i * ETHER_ADDR_LEN))
+#define dsr_source_get_address_begin_by_index(source, i) (source->address + ((i) * ETHER_ADDR_LEN))
 
 #define DSR_SOURCE_FIRST_LAST_HOP_EXTERNAL 128
 #define DSR_SOURCE_FLAG_LAST_HOP_EXTERNAL   64
@@ -369,4 +371,50 @@ typedef struct __attribute__((__packed__)) dsr_source_ext {
 
 } dsr_source_ext_t;
 
+/******************************************************************************
+ *
+ * COMPACT SOURCE - DSR SOURCE ROUTE with 16 bit node ids or only a flow id
+ *
+ * Not part of rfc4728, see compact_source.h. Replaces the DSR_EXT_SOURCE of
+ * data msgs on the wire; every receiver turns it back into a DSR_EXT_SOURCE.
+ ******************************************************************************/
+
+/** Length, in octets, of a dsr_compact_source_ext excluding ids */
+#define DSR_COMPACT_SOURCE_EXTENSION_HDRLEN (4 + sizeof(uint16_t) + ETHER_ADDR_LEN)
+
+/** Maximum count of ids in a dsr_compact_source_ext, the first address is never sent as id */
+#define DSR_COMPACT_SOURCE_MAX_IDS_IN_OPTION (DSR_SOURCE_MAX_ADDRESSES_IN_OPTION - 1)
+
+/** the bits of dsr_compact_source_ext->flags naming the form, DSR_COMPACT_SOURCE_FORM_* */
+#define DSR_COMPACT_SOURCE_FORM_MASK 0x03
+
+typedef struct __attribute__((__packed__)) dsr_compact_source_ext {
+
+    /** The flags of the DSR_EXT_SOURCE; the lower two bits hold the form:
+     FULL  the DSR_EXT_SOURCE is in the msg as well, no ids
+     IDS   len ids follow, Address[i] is the node with id[i - 1]
+     FLOW  no ids, the receiver has the route of the flow */
+    uint8_t flags;
+
+    /** As in the DSR_EXT_SOURCE */
+    uint8_t salvage;
+
+    /** As in the DSR_EXT_SOURCE */
+    uint8_t segments_left;
+
+    /** Number of ids present */
+    uint8_t len;
+
+    /** Network byte order. Set by the source, 0 if there is no flow. The
+     first address and the flow id name the route at the receivers. */
+    uint16_t flow;
+
+    /** Address[0] of the source route */
+    uint8_t source[ETHER_ADDR_LEN];
+
+    /** Network byte order, the ids of Address[1..len] */
+    uint16_t id[DSR_COMPACT_SOURCE_MAX_IDS_IN_OPTION];
+
+} dsr_compact_source_ext_t;
+
 #endif /* DSR_EXTENSIONS_H_ */
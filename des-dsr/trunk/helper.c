@@ -55,6 +55,7 @@ inline void dsr_msg_send_via_path(dessert_msg_t* msg, dsr_path_t* path) {
                 dsr_msg_send_with_route_maintenance(msg, NULL, outif, DSR_MAINTENANCE_BUFFER_NEXTHOP_REACHABILITY_ACKREQ_ACK);
             }
             else {
+                dsr_msg_compact_source_ext(msg, 1);
                 dsr_statistics_emit_msg(outif->hwaddr, msg->l2h.ether_dhost, msg);
                 int res = dessert_meshsend_fast(msg, outif);
                 assert(res == DESSERT_OK);
@@ -65,6 +66,7 @@ inline void dsr_msg_send_via_path(dessert_msg_t* msg, dsr_path_t* path) {
         dsr_msg_send_with_route_maintenance(msg, NULL, outif, DSR_MAINTENANCE_BUFFER_NEXTHOP_REACHABILITY_ACKREQ_ACK);
     }
     else {
+        dsr_msg_compact_source_ext(msg, 1);
         dsr_statistics_emit_msg(outif->hwaddr, msg->l2h.ether_dhost, msg);
         int res = dessert_meshsend_fast(msg, outif);
         assert(res == DESSERT_OK);
@@ -93,6 +95,7 @@ inline void dsr_msg_send_via_path_delay(dessert_msg_t* msg, dsr_path_t* path, __
                 dsr_msg_send_with_route_maintenance_delay(msg, NULL, outif, delay, DSR_MAINTENANCE_BUFFER_NEXTHOP_REACHABILITY_ACKREQ_ACK);
             }
             else {
+                dsr_msg_compact_source_ext(msg, 1);
                 dsr_statistics_emit_msg(outif->hwaddr, msg->l2h.ether_dhost, msg);
                 int res = dessert_meshsend_fast(msg, outif);
                 assert(res == DESSERT_OK);
@@ -103,6 +106,7 @@ inline void dsr_msg_send_via_path_delay(dessert_msg_t* msg, dsr_path_t* path, __
         dsr_msg_send_with_route_maintenance_delay(msg, NULL, outif, delay, DSR_MAINTENANCE_BUFFER_NEXTHOP_REACHABILITY_ACKREQ_ACK);
     }
     else {
+        dsr_msg_compact_source_ext(msg, 1);
         dsr_statistics_emit_msg(outif->hwaddr, msg->l2h.ether_dhost, msg);
         int res = dessert_meshsend_fast(msg, outif);
         assert(res == DESSERT_OK);
@@ -141,6 +145,9 @@ inline int dsr_msg_send_with_route_maintenance(dessert_msg_t* msg, dessert_meshi
     res = dsr_maintenance_buffer_add_msg(id, cloned, in_iface_address, out_iface->hwaddr);
     assert(res == DESSERT_OK);
 
+    /* the clone keeps the full route for retransmissions and route errors */
+    dsr_msg_compact_source_ext(msg, in_iface == NULL);
+
     if(in_iface == NULL) {
         dsr_statistics_emit_msg(out_iface->hwaddr, msg->l2h.ether_dhost, msg);
     }
@@ -321,11 +328,7 @@ inline void dsr_propagate_rreq(dessert_meshif_t* iface, dessert_msg_t* msg, dsr_
 
             uint16_t hop_weight = 0;
 
-#if (METRIC == ETX)
-            hop_weight = dsr_etx_encode(dsr_etx_get_value(iface->hwaddr,msg->l2h.ether_shost));
-#else
-            hop_weight = 100;
-#endif
+            hop_weight = DSR_VARIANT_CALL(hop_weight)(iface->hwaddr, msg->l2h.ether_shost);
 
             new_rreq->data[DSR_RREQ_GET_HOPCOUNT(new_rreq) - 1].weight = htons(hop_weight);
             dsr_statistics_tx_msg(iface->hwaddr, msg->l2h.ether_dhost, msg);
@@ -366,12 +369,7 @@ inline void dsr_propagate_rreq(dessert_meshif_t* iface, dessert_msg_t* msg, dsr_
 
             uint16_t hop_weight = 0;
 
-#if (METRIC == ETX)
-            hop_weight = dsr_etx_encode(dsr_etx_get_value(iface->hwaddr,
-                                        msg->l2h.ether_shost));
-#else
-            hop_weight = 100;
-#endif
+            hop_weight = DSR_VARIANT_CALL(hop_weight)(iface->hwaddr, msg->l2h.ether_shost);
 
             new_rreq->data[DSR_RREQ_GET_HOPCOUNT(new_rreq) - 2].weight
             = htons(hop_weight);
@@ -550,11 +548,7 @@ inline dsr_repl_ext_t* dsr_msg_add_repl_ext(dessert_msg_t* repl_msg, dsr_rreq_ex
         ADDR_CPY(repl->data[i+1].address, &(dessert_l25_defsrc));
 
         uint16_t last_hop_weight;
-#if (METRIC == ETX)
-        last_hop_weight = dsr_etx_encode(dsr_etx_get_value(iface->hwaddr, repl_msg->l2h.ether_dhost));
-#else
-        last_hop_weight = 100;
-#endif
+        last_hop_weight = DSR_VARIANT_CALL(hop_weight)(iface->hwaddr, repl_msg->l2h.ether_dhost);
 
         repl->data[i].weight = htons(last_hop_weight);
         repl->data[i+1].weight = htons(0);
@@ -616,7 +610,6 @@ inline dsr_source_ext_t* dsr_msg_add_source_ext(dessert_msg_t* msg, dsr_path_t*
     return NULL;
 }
 
-#if (LINKCACHE == 0)
 inline void dsr_msg_cache_repl_ext_to_routecache(dsr_repl_ext_t* repl) {
     assert(repl != NULL);
 
@@ -639,7 +632,6 @@ inline void dsr_msg_cache_repl_ext_to_routecache(dsr_repl_ext_t* repl) {
     dessert_info("Caching REPL with [%u] hops and weight[%u] for dest[" MAC "] to routecache ", DSR_REPL_GET_HOPCOUNT(repl), path->weight, EXPLODE_ARRAY6(ADDR_IDX(path, i - 1)));
     dsr_routecache_add_path(ADDR_IDX(path, i - 1), path);
 }
-#endif
 
 #if (CACHE_FROM_SOURCE_EXT == 1)
 inline void dsr_msg_cache_source_ext_to_linkcache(dsr_source_ext_t* source, int repl_present) {
@@ -674,7 +666,6 @@ inline void dsr_msg_cache_source_ext_to_linkcache(dsr_source_ext_t* source, int
 }
 #endif
 
-#if (LINKCACHE == 1)
 inline void dsr_msg_cache_repl_ext_to_linkcache(dsr_repl_ext_t* repl) {
     assert(repl != NULL);
 
@@ -701,7 +692,6 @@ inline void dsr_msg_cache_repl_ext_to_linkcache(dsr_repl_ext_t* repl) {
 
     dessert_info("Cached REPL with [%u] hops and weight [%u]", DSR_REPL_GET_HOPCOUNT(repl), weight);
 }
-#endif
 
 inline dsr_rreq_identification_t dsr_new_rreq_identification() {
     dsr_rreq_identification_t id;
@@ -848,17 +838,18 @@ inline uint32_t dsr_rreq_get_weight_incl_hop_to_self(const dessert_meshif_t* ifa
 
     weight = dsr_rreq_get_weight(rreq);
 
-#if (METRIC == ETX)
-    hop_weight = dsr_etx_encode(dsr_etx_get_value(iface->hwaddr, rreq->data[DSR_RREQ_GET_HOPCOUNT(rreq)-1].address));
-#else
-    hop_weight = 100;
-#endif
+    hop_weight = DSR_VARIANT_CALL(hop_weight)(iface->hwaddr, rreq->data[DSR_RREQ_GET_HOPCOUNT(rreq)-1].address);
 
     weight += hop_weight;
 
     return weight;
 }
 
+/** Hop count metric: every hop weighs the same. */
+inline uint16_t dsr_hc_get_hop_weight(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]) {
+    return 100;
+}
+
 inline uint32_t dsr_rreq_get_weight(dsr_rreq_ext_t* rreq) {
     assert(rreq != NULL);
 
@@ -55,19 +55,10 @@ inline dsr_rerr_ext_t* dsr_msg_add_rerr_ext(dessert_msg_t* msg,
     const uint8_t type_specific_information[6]);
 inline dsr_source_ext_t* dsr_msg_add_source_ext(dessert_msg_t* msg, dsr_path_t* path, int segments_left);
 
-#if (LINKCACHE == 0)
 inline void dsr_msg_cache_repl_ext_to_routecache(dsr_repl_ext_t* repl);
-#endif
-
-#if (LINKCACHE == 1)
 inline void dsr_msg_cache_source_ext_to_linkcache(dsr_source_ext_t* source, int repl_present);
-
-#if (METRIC != HC)
 inline void dsr_msg_cache_repl_ext_to_linkcache(dsr_repl_ext_t* repl);
 
-#endif
-#endif
-
 inline int dsr_msg_send_with_route_maintenance(dessert_msg_t* msg, dessert_meshif_t* in_iface, dessert_meshif_t* out_iface, int nexthop_reachability);
 inline int dsr_msg_send_with_route_maintenance_delay(dessert_msg_t* msg, const dessert_meshif_t* in_iface, const dessert_meshif_t* out_iface, __suseconds_t delay, int nexthop_reachability);
 
@@ -97,6 +88,7 @@ inline void dsr_path_new_from_reversed_patharray(dsr_path_t** path, uint8_t* fro
 inline void dsr_path_new_from_rreq(dsr_path_t** path, dsr_rreq_ext_t* rreq);
 
 inline uint32_t dsr_rreq_get_weight_incl_hop_to_self(const dessert_meshif_t* iface, dsr_rreq_ext_t* rreq);
+inline uint16_t dsr_hc_get_hop_weight(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]);
 inline uint32_t dsr_rreq_get_weight(dsr_rreq_ext_t* rreq);
 
 inline void dsr_path_print_to_debug(dsr_path_t* path);
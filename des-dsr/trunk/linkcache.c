@@ -27,7 +27,18 @@
 
 #include "dsr.h"
 
-#if (LINKCACHE == 1)
+/*
+ * Every node is interned once: it gets an entry in the dsr_linkcache hash
+ * and an index into _nodes. Links are kept in a realloc-grown adjacency
+ * array per node with the weight inline, so Dijkstra relaxes an edge
+ * without any hash lookup.
+ *
+ * Dijkstra uses an indexed binary heap and leaves a shortest path tree in
+ * _spt (distance, predecessor, hop count and first hop per node index).
+ * Path queries are served from the tree. Every change of the topology marks
+ * the tree dirty; it is rebuilt by the next dsr_linkcache_run_dijkstra()
+ * or by the next query, whichever comes first.
+ */
 
 /* LINKCACHE */
 dsr_linkcache_t* dsr_linkcache = NULL; // this is a MUST for uthash
@@ -38,8 +49,30 @@ pthread_rwlock_t _dsr_linkcache_rwlock = PTHREAD_RWLOCK_INITIALIZER;
 
 #define _SAFE_RETURN(x) _LINKCACHE_UNLOCK; return(x)
 
+/* -------------------------------DIJKSTRA----------------------------------- */
+typedef struct _spt_node {
+    uint32_t d;           /** shortest-path estimate               */
+    uint32_t p;           /** predecessor                          */
+    uint32_t first_hop;   /** node after the source on the path    */
+    uint32_t heap_pos;    /** position in _heap while queued       */
+    uint16_t hops;        /** number of links from the source      */
+} _spt_node_t;
+
+#define _NOT_QUEUED (UINT32_MAX)
+
+static dsr_linkcache_t** _nodes = NULL;   /* indexed by dsr_linkcache_t.idx */
+static uint32_t _nodes_len = 0;           /* indices handed out so far */
+static uint32_t _nodes_size = 0;
+static uint32_t* _free_idx = NULL;        /* stack of unused indices below _nodes_len */
+static uint32_t _free_idx_len = 0;
+
+static _spt_node_t* _spt = NULL;
+static uint32_t* _heap = NULL;
+static uint32_t _spt_source = DSR_LINKCACHE_NO_NODE;
+static int _spt_dirty = 1;
+/* -------------------------------DIJKSTRA----------------------------------- */
+
 /* local forward declarations */
-static inline uint16_t _dsr_linkcache_get_weight_XXX(uint8_t u[ETHER_ADDR_LEN], uint8_t v[ETHER_ADDR_LEN]);
 static inline dsr_linkcache_t* _add_new_node(const uint8_t u[ETHER_ADDR_LEN]);
 static inline void _remove_node(dsr_linkcache_t* u);
 static inline void _remove_node_if_detached(dsr_linkcache_t* u);
@@ -48,10 +81,12 @@ static inline int _is_detached_node(const dsr_linkcache_t* u);
 static inline int _ADJ_COUNT(const dsr_linkcache_t* u);
 static inline int _has_adjacent_nodes(const dsr_linkcache_t* u);
 static inline int _is_adjacent_to_nodes(const dsr_linkcache_t* u);
-static inline dsr_adjacency_list_t* _add_new_adjentry(dsr_linkcache_t* u, dsr_linkcache_t* v, const uint16_t weight);
-static inline void _remove_adjentry(dsr_linkcache_t* u, dsr_adjacency_list_t* v);
-static inline dsr_adjacency_list_t* _get_adjentry_by_keys(const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[ETHER_ADDR_LEN]);
-static inline dsr_adjacency_list_t* _get_adjentry_by_key(dsr_linkcache_t* u, const uint8_t v[ETHER_ADDR_LEN]);
+static inline dsr_adjacency_t* _add_new_adjentry(dsr_linkcache_t* u, dsr_linkcache_t* v, const uint16_t weight);
+static inline void _remove_adjentry(dsr_linkcache_t* u, dsr_adjacency_t* v);
+static inline dsr_adjacency_t* _get_adjentry_by_keys(const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[ETHER_ADDR_LEN]);
+static inline dsr_adjacency_t* _get_adjentry_by_key(dsr_linkcache_t* u, const uint8_t v[ETHER_ADDR_LEN]);
+static void _dijkstra(dsr_linkcache_t* s);
+static inline int _spt_is_current(const dsr_linkcache_t* s);
 
 int dsr_linkcache_add_link(uint8_t u[ETHER_ADDR_LEN], uint8_t v[ETHER_ADDR_LEN], uint16_t weight) {
     assert(ADDR_CMP(u, v) != 0);
@@ -59,7 +94,7 @@ int dsr_linkcache_add_link(uint8_t u[ETHER_ADDR_LEN], uint8_t v[ETHER_ADDR_LEN],
 
     dsr_linkcache_t* u_lc_el = NULL;
     dsr_linkcache_t* v_lc_el = NULL;
-    dsr_adjacency_list_t* v_adj_el = NULL;
+    dsr_adjacency_t* v_adj_el = NULL;
 
     _LINKCACHE_WRITELOCK;
 
@@ -91,16 +126,27 @@ int dsr_linkcache_add_link(uint8_t u[ETHER_ADDR_LEN], uint8_t v[ETHER_ADDR_LEN],
         assert(v_adj_el == NULL);
         /* add v to u_lc_el:adj as v_adj_el */
         v_adj_el = _add_new_adjentry(u_lc_el, v_lc_el, weight);
-        assert(v_adj_el != NULL);
+
+        if(v_adj_el == NULL) {
+            /* adjacency array of u is full: unwind the nodes added above */
+            _remove_node_if_detached(v_lc_el);
+            _remove_node_if_detached(u_lc_el);
+            _SAFE_RETURN(DSR_LINKCACHE_ERROR_MEMORY_ALLOCATION);
+        }
     }
     else {
         assert(v_adj_el != NULL);
-#if (METRIC != HC)
-        v_adj_el->weight = weight;
+
+        if(METRIC == HC) {
+            _SAFE_RETURN(DSR_LINKCACHE_ERROR_LINK_ALREADY_IN_CACHE);
+        }
+
+        if(v_adj_el->weight != weight) {
+            v_adj_el->weight = weight;
+            _spt_dirty = 1;
+        }
+
         _SAFE_RETURN(DSR_LINKCACHE_SUCCESS);
-#else
-        _SAFE_RETURN(DSR_LINKCACHE_ERROR_LINK_ALREADY_IN_CACHE);
-#endif
     }
 
 #ifndef NDEBUG
@@ -118,7 +164,7 @@ int dsr_linkcache_remove_link(const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[E
     assert(ADDR_CMP(u, v) != 0);
 
     dsr_linkcache_t* u_lc_el;
-    dsr_adjacency_list_t* v_adj_el;
+    dsr_adjacency_t* v_adj_el;
     dsr_linkcache_t* v_lc_el;
 
     _LINKCACHE_WRITELOCK;
@@ -137,9 +183,9 @@ int dsr_linkcache_remove_link(const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[E
         goto no_such_link_error;
     }
 
-    /* remove v_adj_el from u_lc_el'a adjacency list, however backup v_adj_el->hop as
-     * we need it later on */
-    v_lc_el = v_adj_el->hop;
+    /* remove v_adj_el from u_lc_el'a adjacency list, however backup the node
+     * of v as we need it later on */
+    v_lc_el = _nodes[v_adj_el->v];
 
 
 #ifndef NDEBUG
@@ -172,22 +218,8 @@ no_such_link_error:
     return DSR_LINKCACHE_ERROR_NO_SUCH_LINK;
 }
 
-static inline uint16_t _dsr_linkcache_get_weight_XXX(uint8_t u[ETHER_ADDR_LEN], uint8_t v[ETHER_ADDR_LEN]) {
-    dsr_adjacency_list_t* v_adj_el;
-
-    /* test if v exists as v_adj_el in u's adjacency list*/
-
-    v_adj_el = _get_adjentry_by_keys(u, v);
-
-    if(v_adj_el == NULL) {
-        return 0;
-    }
-
-    return v_adj_el->weight;
-}
-
 int dsr_linkcache_get_weight(uint8_t u[ETHER_ADDR_LEN], uint8_t v[ETHER_ADDR_LEN], uint16_t* weight) {
-    dsr_adjacency_list_t* v_adj_el;
+    dsr_adjacency_t* v_adj_el;
 
     _LINKCACHE_READLOCK;
 
@@ -206,7 +238,7 @@ int dsr_linkcache_get_weight(uint8_t u[ETHER_ADDR_LEN], uint8_t v[ETHER_ADDR_LEN
 }
 
 int dsr_linkcache_set_weight(uint8_t u[ETHER_ADDR_LEN], uint8_t v[ETHER_ADDR_LEN], uint16_t* weight) {
-    dsr_adjacency_list_t* v_adj_el;
+    dsr_adjacency_t* v_adj_el;
 
     _LINKCACHE_WRITELOCK;
 
@@ -216,27 +248,55 @@ int dsr_linkcache_set_weight(uint8_t u[ETHER_ADDR_LEN], uint8_t v[ETHER_ADDR_LEN
         _SAFE_RETURN(DSR_LINKCACHE_ERROR_NO_SUCH_LINK);
     }
 
-    v_adj_el->weight = *weight;
+    if(v_adj_el->weight != *weight) {
+        v_adj_el->weight = *weight;
+        _spt_dirty = 1;
+    }
 
     _LINKCACHE_UNLOCK;
 
     return DSR_LINKCACHE_SUCCESS;
 }
 
-int dsr_linkcache_get_shortest_path(const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[ETHER_ADDR_LEN], dsr_path_t** path) {
-    *path = NULL;
-    uint8_t path_d_to_s[DSR_SOURCE_MAX_ADDRESSES_IN_OPTION * ETHER_ADDR_LEN];
+/** Takes the read lock and makes sure the shortest path tree is rooted in
+ *  @a u and up to date. If it is not, the write lock is taken instead and
+ *  the tree is rebuilt. Either way the caller has to release the lock.
+ *
+ * @return the source node, NULL if @a u is not in the link cache
+ */
+static dsr_linkcache_t* _lock_current_spt(const uint8_t u[ETHER_ADDR_LEN]) {
     dsr_linkcache_t* s;
-    dsr_linkcache_t* d;
-
-    dsr_linkcache_t* hop;
-    int hop_index = -1;
-    int path_index;
 
     _LINKCACHE_READLOCK;
 
     s = _get_node_by_key(u);
 
+    if(likely(s == NULL || _spt_is_current(s))) {
+        return s;
+    }
+
+    _LINKCACHE_UNLOCK;
+    _LINKCACHE_WRITELOCK;
+
+    s = _get_node_by_key(u);
+
+    if(s != NULL && !_spt_is_current(s)) {
+        _dijkstra(s);
+    }
+
+    return s;
+}
+
+int dsr_linkcache_get_shortest_path(const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[ETHER_ADDR_LEN], dsr_path_t** path) {
+    *path = NULL;
+    dsr_linkcache_t* s;
+    dsr_linkcache_t* d;
+    uint32_t hop;
+    int hop_index;
+    int path_len;
+
+    s = _lock_current_spt(u);
+
     if(s == NULL) {
 #ifdef DEBUG_LINKCACHE
         dessert_err("[LINKCACHE]: Link cache not initialized!");
@@ -257,62 +317,63 @@ int dsr_linkcache_get_shortest_path(const uint8_t u[ETHER_ADDR_LEN], const uint8
     dessert_debug("[LINKCACHE]: Destination node found.");
 #endif
 
-    *path = malloc(sizeof(dsr_path_t));
-    (*path)->weight = 0;
-
-    dsr_linkcache_t* prev_hop = NULL;
-
-    for(hop = d; hop != NULL; hop = hop->p) {
-        memcpy(path_d_to_s + (++hop_index * ETHER_ADDR_LEN), hop->address, ETHER_ADDR_LEN);
-
-        if(prev_hop != NULL) {
-            (*path)->weight += _dsr_linkcache_get_weight_XXX(hop->address, prev_hop->address);
-        }
-
-        prev_hop = hop;
+    if(_spt[d->idx].d == INFINITE) {
 #ifdef DEBUG_LINKCACHE
-        dessert_debug("[LINKCACHE]:    --> Copying hop [" MAC "] to path_d_to_s[%d] ",
-            EXPLODE_ARRAY6((path_d_to_s + (hop_index * ETHER_ADDR_LEN))),
-            hop_index * ETHER_ADDR_LEN);
+        dessert_debug("[LINKCACHE]: Destination not reachable from src!");
 #endif
+        _SAFE_RETURN(DSR_ROUTECACHE_ERROR_NO_PATH_TO_DESTINATION);
     }
 
-    if(memcmp(path_d_to_s + (hop_index * ETHER_ADDR_LEN), s->address, ETHER_ADDR_LEN) != 0) {
-#ifdef DEBUG_LINKCACHE
-        dessert_debug("[LINKCACHE]: Path not ending in src but in [" MAC "]!",
-            EXPLODE_ARRAY6((path_d_to_s + (hop_index * ETHER_ADDR_LEN))));
-#endif
-        free(*path);
-        *path = NULL;
+    path_len = _spt[d->idx].hops + 1;
 
+    if(path_len > DSR_SOURCE_MAX_ADDRESSES_IN_OPTION) {
+        dessert_debug("[LINKCACHE]: path with [%d] hops too long for a source route", path_len);
         _SAFE_RETURN(DSR_ROUTECACHE_ERROR_NO_PATH_TO_DESTINATION);
     }
 
-    for(path_index = 0; hop_index >= 0;) {
-#ifdef DEBUG_LINKCACHE
-        dessert_debug("[LINKCACHE]:    --> Copying [%d] -> [%d]", path_index, hop_index);
-#endif
-        memcpy((*path)->address + (path_index * ETHER_ADDR_LEN), path_d_to_s + (hop_index * ETHER_ADDR_LEN), ETHER_ADDR_LEN);
-        path_index++;
-        hop_index--;
-    }
+    *path = malloc(sizeof(dsr_path_t));
+    (*path)->weight = _spt[d->idx].d;
 
+    /* the hop count of every node on the tree is its index in the path */
+    for(hop = d->idx, hop_index = path_len - 1; hop_index >= 0; hop = _spt[hop].p, hop_index--) {
+        memcpy((*path)->address + (hop_index * ETHER_ADDR_LEN), _nodes[hop]->address, ETHER_ADDR_LEN);
 #ifdef DEBUG_LINKCACHE
-    dessert_debug("[LINKCACHE]: Copied path with hop-length [%d]. ", path_index);
+        dessert_debug("[LINKCACHE]:    --> Copying hop [" MAC "] to path[%d] ",
+            EXPLODE_ARRAY6(_nodes[hop]->address), hop_index);
 #endif
+    }
 
+    assert(hop == DSR_LINKCACHE_NO_NODE);
 
     _LINKCACHE_UNLOCK;
 
-    if(path_index == 0) {
-        return DSR_ROUTECACHE_ERROR_NO_PATH_TO_DESTINATION;
+    (*path)->len = path_len;
+    dessert_debug("[LINKCACHE]: path length[%d]", (*path)->len);
+
+    return (path_len);
+}
+
+int dsr_linkcache_get_first_hop(const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[ETHER_ADDR_LEN], uint8_t hop[ETHER_ADDR_LEN]) {
+    dsr_linkcache_t* s;
+    dsr_linkcache_t* d;
+
+    s = _lock_current_spt(u);
+
+    if(s == NULL) {
+        _SAFE_RETURN(DSR_ROUTECACHE_ERROR_LINKCACHE_NOT_INITIALIZED);
     }
 
+    d = _get_node_by_key(v);
 
-    (*path)->len = path_index;
-    dessert_debug("[LINKCACHE]: path length[%d]", (*path)->len);
+    if(d == NULL || d == s || _spt[d->idx].d == INFINITE) {
+        _SAFE_RETURN(DSR_ROUTECACHE_ERROR_NO_PATH_TO_DESTINATION);
+    }
 
-    return (path_index);
+    ADDR_CPY(hop, _nodes[_spt[d->idx].first_hop]->address);
+
+    _LINKCACHE_UNLOCK;
+
+    return DSR_ROUTECACHE_SUCCESS;
 }
 
 int dsr_linkcache_run_dijkstra(uint8_t u[ETHER_ADDR_LEN]) {
@@ -327,13 +388,15 @@ int dsr_linkcache_run_dijkstra(uint8_t u[ETHER_ADDR_LEN]) {
         _SAFE_RETURN(DSR_ROUTECACHE_ERROR_LINKCACHE_NOT_INITIALIZED);
     }
 
-    dessert_info("[LINKCACHE]: Running DIJKSTRA for source[" MAC "]", EXPLODE_ARRAY6(s->address));
+    if(!_spt_is_current(s)) {
+        dessert_info("[LINKCACHE]: Running DIJKSTRA for source[" MAC "]", EXPLODE_ARRAY6(s->address));
 
-    DIJKSTRA(dsr_linkcache, WEIGHT, s);
+        _dijkstra(s);
 
 #ifdef DEBUG_LINKCACHE
-    dessert_debug("[LINKCACHE]: Dijkstra done.");
+        dessert_debug("[LINKCACHE]: Dijkstra done.");
 #endif
+    }
 
     _LINKCACHE_UNLOCK;
     return DSR_ROUTECACHE_SUCCESS;
@@ -341,8 +404,7 @@ int dsr_linkcache_run_dijkstra(uint8_t u[ETHER_ADDR_LEN]) {
 
 void dsr_linkcache_print() {
     dsr_linkcache_t* u;
-    dsr_linkcache_t* v;
-    dsr_adjacency_list_t* adj;
+    dsr_adjacency_t* adj;
 
     _LINKCACHE_READLOCK;
 
@@ -351,9 +413,8 @@ void dsr_linkcache_print() {
     for(u = dsr_linkcache; u != NULL; u = u->hh.next) {
         dessert_debug("[LINKCACHE]:   | [" MAC "] _in_use(%u) adjs(%u)", EXPLODE_ARRAY6(u->address), u->in_use, _ADJ_COUNT(u));
 
-        for(adj = u->adj; adj != NULL; adj = adj->hh.next) {
-            v = adj->hop;
-            dessert_debug("[LINKCACHE]:      ->[" MAC "]  weight[%u]", EXPLODE_ARRAY6(v->address), adj->weight);
+        for(adj = u->adj; adj < u->adj + u->adj_len; adj++) {
+            dessert_debug("[LINKCACHE]:      ->[" MAC "]  weight[%u]", EXPLODE_ARRAY6(_nodes[adj->v]->address), adj->weight);
         }
 
     }
@@ -387,17 +448,15 @@ int dsr_linkcache_init(uint8_t default_src[ETHER_ADDR_LEN]) {
 
 int dessert_cli_cmd_showlinkcache(struct cli_def* cli, char* command, char* argv[], int argc) {
     dsr_linkcache_t* u;
-    dsr_linkcache_t* v;
-    dsr_adjacency_list_t* adj;
+    dsr_adjacency_t* adj;
 
     _LINKCACHE_READLOCK;
 
     for(u = dsr_linkcache; u != NULL; u = u->hh.next) {
         cli_print(cli, "|   [" MAC "] _in_use(%3u) adjs(%3u)", EXPLODE_ARRAY6(u->address), u->in_use, _ADJ_COUNT(u));
 
-        for(adj = u->adj; adj != NULL; adj = adj->hh.next) {
-            v = adj->hop;
-            cli_print(cli, "|-->[" MAC "]-->[" MAC "]  weight[%06u]", EXPLODE_ARRAY6(u->address), EXPLODE_ARRAY6(v->address), adj->weight);
+        for(adj = u->adj; adj < u->adj + u->adj_len; adj++) {
+            cli_print(cli, "|-->[" MAC "]-->[" MAC "]  weight[%06u]", EXPLODE_ARRAY6(u->address), EXPLODE_ARRAY6(_nodes[adj->v]->address), adj->weight);
         }
 
     }
@@ -425,23 +484,154 @@ dessert_per_result_t dsr_linkcache_run_dijkstra_periodic(void* data, struct time
  *
  ******************************************************************************/
 
+/******************************************************************************
+ * dijkstra
+ ******************************************************************************/
+
+static inline int _spt_is_current(const dsr_linkcache_t* s) {
+    return (!_spt_dirty && _spt_source == s->idx) ? 1 : 0;
+}
+
+static inline void _heap_place(uint32_t pos, uint32_t u) {
+    _heap[pos] = u;
+    _spt[u].heap_pos = pos;
+}
+
+static inline void _heap_up(uint32_t pos) {
+    uint32_t u = _heap[pos];
+
+    while(pos > 0 && _spt[_heap[(pos - 1) / 2]].d > _spt[u].d) {
+        _heap_place(pos, _heap[(pos - 1) / 2]);
+        pos = (pos - 1) / 2;
+    }
+
+    _heap_place(pos, u);
+}
+
+static inline uint32_t _heap_extract_min(uint32_t* heap_len) {
+    uint32_t min = _heap[0];
+    uint32_t u = _heap[--(*heap_len)];
+    uint32_t pos = 0;
+    uint32_t child;
+
+    while((child = 2 * pos + 1) < *heap_len) {
+        if(child + 1 < *heap_len && _spt[_heap[child + 1]].d < _spt[_heap[child]].d) {
+            child++;
+        }
+
+        if(_spt[_heap[child]].d >= _spt[u].d) {
+            break;
+        }
+
+        _heap_place(pos, _heap[child]);
+        pos = child;
+    }
+
+    if(*heap_len > 0) {
+        _heap_place(pos, u);
+    }
+
+    _spt[min].heap_pos = _NOT_QUEUED;
+    return min;
+}
+
+/** ***************************************************************************
+ * Dijkstra's algorithm for single-source shortest paths, adaptation from     *
+ * Introduction to Algorithms, 2/e, Cormen et. al., p.595                     *
+ * O((|V| + |E|) log |V|) with an indexed binary heap as priority queue; only *
+ * nodes reached so far are queued                                            *
+ ******************************************************************************/
+static void _dijkstra(dsr_linkcache_t* s) {
+    uint32_t heap_len = 0;
+    uint32_t i;
+
+    /* INITIALIZE_SINGLE_SOURCE */
+    for(i = 0; i < _nodes_len; i++) {
+        _spt[i].d = INFINITE;
+        _spt[i].p = DSR_LINKCACHE_NO_NODE;
+        _spt[i].heap_pos = _NOT_QUEUED;
+    }
+
+    _spt[s->idx].d = 0;
+    _spt[s->idx].hops = 0;
+    _spt[s->idx].first_hop = s->idx;
+    _heap_place(heap_len++, s->idx);
+
+    while(heap_len > 0) {
+        uint32_t u = _heap_extract_min(&heap_len);
+        dsr_adjacency_t* adj = _nodes[u]->adj;
+        dsr_adjacency_t* end = adj + _nodes[u]->adj_len;
+
+        for(; adj < end; adj++) {
+            uint32_t v = adj->v;
+            uint32_t d = _spt[u].d + adj->weight;
+
+            /* RELAX */
+            if(_spt[v].d > d) {
+                if(_spt[v].d == INFINITE) {
+                    _heap_place(heap_len++, v);
+                }
+
+                _spt[v].d = d;
+                _spt[v].p = u;
+                _spt[v].hops = _spt[u].hops + 1;
+                _spt[v].first_hop = (u == s->idx) ? v : _spt[u].first_hop;
+                _heap_up(_spt[v].heap_pos);
+            }
+        }
+    }
+
+    _spt_source = s->idx;
+    _spt_dirty = 0;
+}
+
 /******************************************************************************
  * nodes
  ******************************************************************************/
 
+/** hands out a free node table index, growing the table and the Dijkstra
+ *  arrays if there is none */
+static inline uint32_t _alloc_idx(void) {
+    if(_free_idx_len > 0) {
+        return _free_idx[--_free_idx_len];
+    }
+
+    if(_nodes_len == _nodes_size) {
+        _nodes_size = _nodes_size ? 2 * _nodes_size : 64;
+        _nodes = realloc(_nodes, _nodes_size * sizeof(dsr_linkcache_t*));
+        _free_idx = realloc(_free_idx, _nodes_size * sizeof(uint32_t));
+        _spt = realloc(_spt, _nodes_size * sizeof(_spt_node_t));
+        _heap = realloc(_heap, _nodes_size * sizeof(uint32_t));
+        assert(_nodes != NULL && _free_idx != NULL && _spt != NULL && _heap != NULL);
+    }
+
+    return _nodes_len++;
+}
+
 static inline dsr_linkcache_t* _add_new_node(const uint8_t u[ETHER_ADDR_LEN]) {
     dsr_linkcache_t* u_lc_el;
+    uint32_t idx;
 
     assert(_get_node_by_key(u) == NULL);
 
     u_lc_el = malloc(sizeof(dsr_linkcache_t));
     assert(u_lc_el != NULL);
 
+    idx = _alloc_idx();
+
     memcpy(u_lc_el->address, u, ETHER_ADDR_LEN);
+    u_lc_el->idx = idx;
     u_lc_el->in_use = 0;
-    u_lc_el->adj = NULL; /* MUST for uthash*/
+    u_lc_el->adj = NULL;
+    u_lc_el->adj_len = 0;
+    u_lc_el->adj_size = 0;
     HASH_ADD(hh, dsr_linkcache, address, ETHER_ADDR_LEN, u_lc_el);
 
+    _nodes[idx] = u_lc_el;
+    /* not reached by the current tree */
+    _spt[idx].d = INFINITE;
+    _spt[idx].p = DSR_LINKCACHE_NO_NODE;
+
     assert(_get_node_by_key(u) != NULL);
 
     return u_lc_el;
@@ -462,6 +652,10 @@ static inline void _remove_node(dsr_linkcache_t* u) {
 #endif
 
     HASH_DELETE(hh, dsr_linkcache, u);
+    _nodes[u->idx] = NULL;
+    _free_idx[_free_idx_len++] = u->idx;
+    _spt_dirty = 1;
+    free(u->adj);
     free(u);
     u = NULL;
 
@@ -519,7 +713,7 @@ static inline int _has_adjacent_nodes(const dsr_linkcache_t* u) {
 }
 
 static inline int _ADJ_COUNT(const dsr_linkcache_t* u) {
-    return HASH_CNT(hh, u->adj);
+    return u->adj_len;
 }
 
 /** Tests whether @a *u is adjacent to any other nodes.
@@ -537,8 +731,8 @@ static inline int _is_adjacent_to_nodes(const dsr_linkcache_t* u) {
  * adjacency entries
  ******************************************************************************/
 
-static inline dsr_adjacency_list_t* _add_new_adjentry(dsr_linkcache_t* u, dsr_linkcache_t* v, uint16_t weight) {
-    dsr_adjacency_list_t* v_adj_el = NULL;
+static inline dsr_adjacency_t* _add_new_adjentry(dsr_linkcache_t* u, dsr_linkcache_t* v, uint16_t weight) {
+    dsr_adjacency_t* v_adj_el = NULL;
 
     assert(u != NULL);
     assert(v != NULL);
@@ -548,15 +742,21 @@ static inline dsr_adjacency_list_t* _add_new_adjentry(dsr_linkcache_t* u, dsr_li
     int v_in_use  = v->in_use;
 #endif
 
-    v_adj_el = malloc(sizeof(dsr_adjacency_list_t));
-    assert(v_adj_el != NULL);
+    if(u->adj_len == u->adj_size) {
+        if(u->adj_size == UINT16_MAX) {
+            return NULL;
+        }
 
-    memcpy(v_adj_el->address, v->address, ETHER_ADDR_LEN);
-    v_adj_el->weight = weight;
-    v_adj_el->hop = v;
-    (v_adj_el->hop)->in_use++;
+        u->adj_size = (u->adj_size == 0) ? 4 : ((u->adj_size > UINT16_MAX / 2) ? UINT16_MAX : 2 * u->adj_size);
+        u->adj = realloc(u->adj, u->adj_size * sizeof(dsr_adjacency_t));
+        assert(u->adj != NULL);
+    }
 
-    HASH_ADD(hh, u->adj, address, ETHER_ADDR_LEN, v_adj_el);
+    v_adj_el = &u->adj[u->adj_len++];
+    v_adj_el->v = v->idx;
+    v_adj_el->weight = weight;
+    v->in_use++;
+    _spt_dirty = 1;
 
 #ifndef NDEBUG
     assert(_ADJ_COUNT(u) == u_adj_cnt + 1);
@@ -566,37 +766,35 @@ static inline dsr_adjacency_list_t* _add_new_adjentry(dsr_linkcache_t* u, dsr_li
     return v_adj_el;
 }
 
-/** Removes the adjacency entry @a *v from @a *u's adjacency list
+/** Removes the adjacency entry @a *v from @a *u's adjacency list by moving
+ *  the last entry into its place.
  *
  * @param *u the adjacency list to delete from
  * @param *v the entry to remove
-
- * @return pointer to the node which was removed from @a u's adjacency list
  */
-static inline void _remove_adjentry(dsr_linkcache_t* u, dsr_adjacency_list_t* v) {
+static inline void _remove_adjentry(dsr_linkcache_t* u, dsr_adjacency_t* v) {
     assert(u != NULL);
     assert(v != NULL);
-    assert(v->hop != NULL);
+    assert(_nodes[v->v] != NULL);
 #ifndef NDEBUG
     int u_adj_cnt = _ADJ_COUNT(u);
-    int v_in_use  = (v->hop)->in_use;
+    dsr_linkcache_t* v_lc_el = _nodes[v->v];
+    int v_in_use  = v_lc_el->in_use;
 #endif
 
-    HASH_DELETE(hh, u->adj, v);
-    (v->hop)->in_use--;
+    _nodes[v->v]->in_use--;
+    *v = u->adj[--u->adj_len];
+    _spt_dirty = 1;
 
 #ifndef NDEBUG
     assert(_ADJ_COUNT(u) == u_adj_cnt - 1);
-    assert((v->hop)->in_use == v_in_use - 1);
+    assert(v_lc_el->in_use == v_in_use - 1);
 #endif
-
-    free(v);
-    v = NULL;
 }
 
-static inline dsr_adjacency_list_t* _get_adjentry_by_keys(const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[ETHER_ADDR_LEN]) {
+static inline dsr_adjacency_t* _get_adjentry_by_keys(const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[ETHER_ADDR_LEN]) {
     dsr_linkcache_t* u_lc_el;
-    dsr_adjacency_list_t* v_adj_el;
+    dsr_adjacency_t* v_adj_el;
 
     /* test if u exists as u_lc_el in link cache */
     u_lc_el = _get_node_by_key(u);
@@ -613,15 +811,24 @@ static inline dsr_adjacency_list_t* _get_adjentry_by_keys(const uint8_t u[ETHER_
     return v_adj_el;
 }
 
-static inline dsr_adjacency_list_t* _get_adjentry_by_key(dsr_linkcache_t* u, const uint8_t v[ETHER_ADDR_LEN]) {
-    dsr_adjacency_list_t* v_adj_el;
+static inline dsr_adjacency_t* _get_adjentry_by_key(dsr_linkcache_t* u, const uint8_t v[ETHER_ADDR_LEN]) {
+    dsr_linkcache_t* v_lc_el;
+    dsr_adjacency_t* adj;
 
     assert(u != NULL);
 
-    /* find v as v_adj_el in u's adjacency list */
-    HASH_FIND(hh, u->adj, v, ETHER_ADDR_LEN, v_adj_el);
+    /* find v as node, then in u's adjacency array */
+    v_lc_el = _get_node_by_key(v);
 
-    return v_adj_el;
-}
+    if(v_lc_el == NULL) {
+        return NULL;
+    }
 
-#endif /* LINKCACHE */
+    for(adj = u->adj; adj < u->adj + u->adj_len; adj++) {
+        if(adj->v == v_lc_el->idx) {
+            return adj;
+        }
+    }
+
+    return NULL;
+}
@@ -44,6 +44,7 @@ int dsr_linkcache_remove_link(const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[E
 int dsr_linkcache_get_weight(uint8_t u[ETHER_ADDR_LEN], uint8_t v[ETHER_ADDR_LEN], uint16_t* weight);
 int dsr_linkcache_set_weight(uint8_t u[ETHER_ADDR_LEN], uint8_t v[ETHER_ADDR_LEN], uint16_t* weight);
 int dsr_linkcache_get_shortest_path(const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[ETHER_ADDR_LEN], dsr_path_t** path);
+int dsr_linkcache_get_first_hop(const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[ETHER_ADDR_LEN], uint8_t hop[ETHER_ADDR_LEN]);
 int dsr_linkcache_run_dijkstra(uint8_t u[ETHER_ADDR_LEN]);
 void dsr_linkcache_print(void);
 
@@ -51,82 +52,24 @@ int dessert_cli_cmd_showlinkcache(struct cli_def* cli, char* command, char* argv
 
 dessert_per_result_t dsr_linkcache_run_dijkstra_periodic(void* data, struct timeval* scheduled, struct timeval* interval);
 
-typedef struct dsr_adjacency_list {
-    uint8_t address[ETHER_ADDR_LEN]; /* key */
-    struct dsr_linkcache* hop;
+/** a link u->v, stored in u's adjacency array */
+typedef struct dsr_adjacency {
+    uint32_t v;      /* node table index of v */
     uint16_t weight; /* in 'fixed point' notation, e.g. 1.00 is 100 . MAX is 65535   */
-    UT_hash_handle hh;
-} dsr_adjacency_list_t;
+} dsr_adjacency_t;
 
+/** a node of the link cache, interned once and addressed by its node table index */
 typedef struct dsr_linkcache {
     uint8_t address[ETHER_ADDR_LEN]; /* key */
-    struct dsr_adjacency_list* adj;
-    uint8_t in_use; /** counts how often v appears in other nodes adjacency lists*/
+    uint32_t idx;              /** index into the node table                  */
+    dsr_adjacency_t* adj;      /** outgoing links                             */
+    uint16_t adj_len;
+    uint16_t adj_size;
+    uint32_t in_use;           /** counts how often v appears in other nodes adjacency lists*/
     UT_hash_handle hh;
-    /* -------------------------------DIJKSTRA------------------------------- */
-    uint16_t d;                 /** shortest-path estimate             */
-    struct dsr_linkcache* p;   /** predecessor                        */
-    UT_hash_handle qh;         /** hash handle for min priority queue */
-    /* -------------------------------DIJKSTRA------------------------------- */
 } dsr_linkcache_t;
 
-#define WEIGHT(u,v) _dsr_linkcache_get_weight_XXX(u->address,v->address)
-#define HOPCOUNT(u,v) 100
-
-/* -------------------------------DIJKSTRA----------------------------------- */
-
-#define INFINITE (UINT16_MAX)
-
-#define D(u) u->d
-#define P(u) u->p
-
-#define INITIALIZE_SINGLE_SOURCE(G,s) do {                                     \
-	                                      dsr_linkcache_t *v;                  \
-                                          HASH_FOREACH(hh, G,v){               \
-                                             D(v) = INFINITE;                  \
-                                             P(v) = NULL;                      \
-                                          }                                    \
-                                          D(s) = 0;                            \
-                                      } while(0)
-
-#define RELAX(u,v,w) do {                                                      \
-		               if(D(v) > (D(u) + w(u,v))){                             \
-                           D(v) = (D(u) + w(u,v));                             \
-                           P(v) = u;                                           \
-                       }                                                       \
-                   } while(0)
-
-#define EXTRACT_MIN(Q,u) do {                                                  \
-	                         dsr_linkcache_t *x;                               \
-	                         u = Q;                                            \
-	                         HASH_FOREACH(qh, Q,x) {                           \
-	                        	if(x->d < u->d) u = x;                         \
-	                         }                                                 \
-	                         HASH_DELETE(qh,Q,u);                              \
-                         } while(0)
-
-/** ***************************************************************************
- * Dijkstra's algorithm for single-source shortest paths, adaptation from     *
- * Introduction to Algorithms, 2/e, Cormen et. al., p.595                     *
- * O(|V|^2 + |E|) due to the linear EXTRACT_MIN based on a linked list        *
- ******************************************************************************/
-#define DIJKSTRA(G,w,s) do {                                                   \
-                            dsr_linkcache_t *Q = NULL; /* MUST for uthash */   \
-                            dsr_linkcache_t *u;                                \
-                            dsr_adjacency_list_t *v;                           \
-                                                                               \
-	                        INITIALIZE_SINGLE_SOURCE(G,s);                     \
-	                        HASH_SELECT(qh,Q,hh,G,COND_true); /* Q <- V[G] */  \
-                            while (HASH_CNT(qh,Q) > 0) {  /* Q != {} */        \
-                                EXTRACT_MIN(Q,u);                              \
-                                HASH_FOREACH(hh, u->adj,v) RELAX(u,v->hop,w);  \
-                            }                                                  \
-                        } while(0)
-
-/* -------------------------------DIJKSTRA-helpers--------------------------- */
-
-#define COND_true(x) 1
-
-/* -------------------------------DIJKSTRA----------------------------------- */
+#define INFINITE (UINT32_MAX)
+#define DSR_LINKCACHE_NO_NODE (UINT32_MAX)
 
 #endif /* LINKCACHE_H_ */
@@ -39,6 +39,22 @@
 #define ADDR_CMP(    _a,    _b    ) memcmp(  (_a),    (_b),        ETHER_ADDR_LEN)
 #define ADDR_N_CMP(  _a,    _b, _n) memcmp(  (_a),    (_b), (_n) * ETHER_ADDR_LEN)
 
+/** hash of the link (local, remote), for the open addressing link indices */
+static inline uint32_t ADDR_PAIR_HASH(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]) {
+    uint64_t l = 0;
+    uint64_t r = 0;
+
+    memcpy(&l, local, ETHER_ADDR_LEN);
+    memcpy(&r, remote, ETHER_ADDR_LEN);
+
+    uint64_t h = (l * 0x9e3779b97f4a7c15ULL) ^ r;
+    h ^= h >> 31;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 29;
+
+    return (uint32_t) h;
+}
+
 /** compares two struct timeval - a>=b==1, a<=b==-1 - >= later, <= earlier */
 static inline int TIMEVAL_COMPARE(struct timeval* a, struct timeval* b) {
     if(a->tv_sec > b->tv_sec) {
@@ -27,7 +27,42 @@
 
 #include "dsr.h"
 
+/*
+ * Every msg sent with route maintenance is kept until it is acknowledged,
+ * keyed by its next hop and identification as found in an ACK. It is also
+ * linked into the list of its link (outgoing interface -> next hop), so a
+ * link error or a passive ACK drops all msgs over the link without looking
+ * at the others, into the list of its source route (source -> destination),
+ * so an overheard msg only is compared with msgs of the same flow, and into
+ * the slot of a timer wheel its next retransmission falls into.
+ *
+ * The buffer holds the msg it was given and retransmits that very msg, no
+ * clone. Retransmissions and link errors are handled after the lock is
+ * released; a reference keeps the msg alive if it is acknowledged
+ * meanwhile.
+ */
+
 dsr_maintenance_buffer_t* dsr_maintenance_buffer = NULL;
+static dsr_maintenance_buffer_list_t* _links = NULL;
+static dsr_maintenance_buffer_list_t* _flows = NULL;
+
+static dsr_maintenance_buffer_t* _wheel[DSR_CONFVAR_MAINTENANCE_BUFFER_WHEEL_SLOTS];
+static uint64_t _wheel_tick = 0;
+
+static dsr_maintenance_buffer_stats_t _stats;
+
+/* due msgs of one cleanup_maintenance_buffer run, handled without the lock */
+#define _FIRED_RETRANSMIT  0
+#define _FIRED_LINK_ERROR  1
+#define _FIRED_DROP        2
+
+typedef struct dsr_maintenance_buffer_fired {
+    dsr_maintenance_buffer_t* mb_el;
+    int action;
+} dsr_maintenance_buffer_fired_t;
+
+static dsr_maintenance_buffer_fired_t* _fired = NULL;
+static size_t _fired_size = 0;
 
 pthread_rwlock_t _dsr_maintenance_buffer_rwlock = PTHREAD_RWLOCK_INITIALIZER;
 #define _MB_READLOCK pthread_rwlock_rdlock(&_dsr_maintenance_buffer_rwlock)
@@ -36,94 +71,67 @@ pthread_rwlock_t _dsr_maintenance_buffer_rwlock = PTHREAD_RWLOCK_INITIALIZER;
 
 #define _SAFE_RETURN(x) do {_MB_UNLOCK; return(x);} while(0)
 
-/* local forward declarations */
-static inline int _remove_all_el_with_link(const uint8_t out_interface[ETHER_ADDR_LEN], const uint8_t msg_dhost[ETHER_ADDR_LEN], dsr_maintenance_buffer_t* dont_delete_mb_el);
-static inline dsr_maintenance_buffer_t* _get_msg_by_key(uint16_t id);
-static inline void _add_el_to_buffer(dsr_maintenance_buffer_t* mb_el);
-static inline void _remove_el_from_buffer(dsr_maintenance_buffer_t* mb_el);
-static inline void _readd_el_after_retransmission(dsr_maintenance_buffer_t* mb_el, __suseconds_t timeout);
-static inline void _destroy_el(dsr_maintenance_buffer_t* mb_el);
-static inline int _is_passive_ack(const dessert_msg_t* candidate_msg, const uint8_t source_src[ETHER_ADDR_LEN], const uint8_t source_dst[ETHER_ADDR_LEN], const uint8_t source_sl, const uint8_t source_hops);
-
-inline int dsr_maintenance_buffer_add_msg(const uint16_t id, dessert_msg_t* msg, const uint8_t in_iface_address[ETHER_ADDR_LEN], const uint8_t out_iface_address[ETHER_ADDR_LEN]) {
-    dsr_maintenance_buffer_t* mb_el = NULL;
-
-    _MB_WRITELOCK;
-
-    mb_el = _get_msg_by_key(id);
+#define _LIST_ADD(head, el, next, prev) do { \
+        (el)->prev = NULL; \
+        (el)->next = (head); \
+        if((head) != NULL) { (head)->prev = (el); } \
+        (head) = (el); \
+    } while(0)
 
-    if(mb_el != NULL) {
-        _SAFE_RETURN(DSR_MAINTENANCE_BUFFER_ERROR_MESSAGE_ALREADY_IN_BUFFER);
-    }
-
-    mb_el = malloc(sizeof(dsr_maintenance_buffer_t));
-    mb_el->identification = id;
-    gettimeofday(&(mb_el->error_threshold), NULL);
-    TIMEVAL_ADD(&mb_el->error_threshold, 0, dsr_conf_get_retransmission_timeout());
-    mb_el->msg = msg;
-    ADDR_CPY(mb_el->out_iface_address, out_iface_address);
-    ADDR_CPY(mb_el->in_iface_address, in_iface_address);
-    mb_el->retransmission_count = 0;
+#define _LIST_DELETE(head, el, next, prev) do { \
+        if((el)->prev != NULL) { (el)->prev->next = (el)->next; } \
+        else { (head) = (el)->next; } \
+        if((el)->next != NULL) { (el)->next->prev = (el)->prev; } \
+    } while(0)
 
-    _add_el_to_buffer(mb_el);
+/* local forward declarations */
+static inline uint64_t _now_tick(void);
+static inline uint64_t _ticks(__suseconds_t usecs);
+static inline int _add_el(const uint16_t id, dessert_msg_t* msg, const uint8_t in_iface_address[ETHER_ADDR_LEN], const uint8_t out_iface_address[ETHER_ADDR_LEN], __suseconds_t delay, int retransmission_count);
+static inline dsr_maintenance_buffer_list_t* _get_list(dsr_maintenance_buffer_list_t** lists, const uint8_t a[ETHER_ADDR_LEN], const uint8_t b[ETHER_ADDR_LEN], int create);
+static inline void _release_list(dsr_maintenance_buffer_list_t** lists, dsr_maintenance_buffer_list_t* list);
+static inline void _schedule_el(dsr_maintenance_buffer_t* mb_el, uint64_t expires);
+static inline void _unlink_el(dsr_maintenance_buffer_t* mb_el);
+static inline void _remove_el(dsr_maintenance_buffer_t* mb_el);
+static inline void _unref_el(dsr_maintenance_buffer_t* mb_el);
+static inline int _purge_link(dsr_maintenance_buffer_list_t* link, dsr_maintenance_buffer_t* keep);
+static inline void _fire(dsr_maintenance_buffer_t* mb_el, int action, size_t* fired_len);
+static inline void _handle_fired(dsr_maintenance_buffer_fired_t* fired);
 
-    _SAFE_RETURN(DSR_MAINTENANCE_BUFFER_SUCCESS);
+inline int dsr_maintenance_buffer_add_msg(const uint16_t id, dessert_msg_t* msg, const uint8_t in_iface_address[ETHER_ADDR_LEN], const uint8_t out_iface_address[ETHER_ADDR_LEN]) {
+    return _add_el(id, msg, in_iface_address, out_iface_address, dsr_conf_get_retransmission_timeout(), 0);
 }
 
 inline int dsr_maintenance_buffer_add_msg_delay(const uint16_t id,
     dessert_msg_t* msg, const uint8_t in_iface_address[ETHER_ADDR_LEN],
     const uint8_t out_iface_address[ETHER_ADDR_LEN], __suseconds_t delay) {
 
-    dsr_maintenance_buffer_t* mb_el = NULL;
-
-    _MB_WRITELOCK;
-
-    mb_el = _get_msg_by_key(id);
-
-    if(mb_el != NULL) {
-        _SAFE_RETURN(DSR_MAINTENANCE_BUFFER_ERROR_MESSAGE_ALREADY_IN_BUFFER);
-    }
-
-    mb_el = malloc(sizeof(dsr_maintenance_buffer_t));
-    mb_el->identification = id;
-    gettimeofday(&(mb_el->error_threshold), NULL);
-    TIMEVAL_ADD(&mb_el->error_threshold, 0, delay);
-    mb_el->msg = msg;
-    ADDR_CPY(mb_el->out_iface_address, out_iface_address);
-    ADDR_CPY(mb_el->in_iface_address, in_iface_address);
-    mb_el->retransmission_count = -1;
-
-    _add_el_to_buffer(mb_el);
-
-    _SAFE_RETURN(DSR_MAINTENANCE_BUFFER_SUCCESS);
+    /* the first "retransmission" is the delayed transmission */
+    return _add_el(id, msg, in_iface_address, out_iface_address, delay, -1);
 }
 
-inline int dsr_maintenance_buffer_delete_msg(const uint16_t id) {
+inline int dsr_maintenance_buffer_delete_msg(const uint8_t nexthop[ETHER_ADDR_LEN], const uint16_t id) {
+    dsr_maintenance_buffer_key_t key;
     dsr_maintenance_buffer_t* mb_el = NULL;
-    dsr_maintenance_buffer_t* tbd_mb_el = NULL;
+
+    memset(&key, 0, sizeof(key));
+    ADDR_CPY(key.nexthop, nexthop);
+    key.identification = id;
 
     _MB_WRITELOCK;
 
-    mb_el = _get_msg_by_key(id);
+    HASH_FIND(hh, dsr_maintenance_buffer, &key, sizeof(key), mb_el);
 
     if(mb_el == NULL) {
-        dessert_debug("MB: no such msg id(%d)", id);
+        dessert_debug("MB: no such msg nexthop[" MAC "] id(%d)", EXPLODE_ARRAY6(nexthop), id);
         _SAFE_RETURN(DSR_MAINTENANCE_BUFFER_ERROR_NO_SUCH_MESSAGE);
     }
-    else {
-        struct timeval now;
-        struct timeval diff;
-        gettimeofday(&now, NULL);
-        TIMEVAL_SUB(&mb_el->error_threshold, &now, &diff);
-        dessert_debug("####\nMB: diff: %i secs %i usecs", diff.tv_sec, diff.tv_usec);
-
-        tbd_mb_el = mb_el;
-        _remove_el_from_buffer(mb_el);
-        dessert_msg_destroy(tbd_mb_el->msg);
-        _destroy_el(tbd_mb_el);
-        //		dessert_debug("MB: Removed msg for id (%d)", id);
-        _SAFE_RETURN(DSR_MAINTENANCE_BUFFER_SUCCESS);
-    }
+
+    _stats.acks++;
+    dsr_compact_source_confirm(mb_el->msg);
+    _remove_el(mb_el);
+    //		dessert_debug("MB: Removed msg for id (%d)", id);
+    _SAFE_RETURN(DSR_MAINTENANCE_BUFFER_SUCCESS);
 }
 
 int maintenance_buffer_passive_ack_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, dessert_meshif_t* iface, dessert_frameid_t id) {
@@ -149,42 +157,38 @@ int maintenance_buffer_passive_ack_meshrx_cb(dessert_msg_t* msg, size_t len, des
         source = (dsr_source_ext_t*) source_ext->data;
     }
 
-    uint8_t source_src[ETHER_ADDR_LEN];
-    uint8_t source_dst[ETHER_ADDR_LEN];
     uint8_t source_sl = source->segments_left;
     uint8_t source_hops = dsr_source_get_address_count(source);
 
-    ADDR_CPY(source_src, dsr_source_get_address_begin_by_index(source, 0));
-    ADDR_CPY(source_dst, dsr_source_get_address_begin_by_index(source, source_hops - 1));
-
     _MB_WRITELOCK;
 
-    dsr_maintenance_buffer_t* mb_el = NULL;
-    dsr_maintenance_buffer_t* next_mb_el = NULL;
-
-    mb_el = dsr_maintenance_buffer;
-
-    while(mb_el) {
-        if(_is_passive_ack(mb_el->msg, source_src, source_dst, source_sl, source_hops) == 0) {
-            dessert_debug("PASSIVE_SOURCE[%"PRIi64"]: overheard DSR_EXT_SOURCE in msg ... is a passive ACK", id);
-            int removed = _remove_all_el_with_link(mb_el->out_iface_address, mb_el->msg->l2h.ether_dhost, mb_el);
-            dessert_debug("PASSIVE_SOURCE[%"PRIi64"]: removed [%i] elements due to the passive ack", id, removed);
-
-            /* cleanup */
-            next_mb_el = mb_el->hh.next;
-            _remove_el_from_buffer(mb_el);
-            dessert_msg_destroy(mb_el->msg);
-            _destroy_el(mb_el);
-
-            if(next_mb_el == NULL) {
-                break;
+    /* a msg of ours on the same source route, but fewer segments left: it
+     * was forwarded by our next hop (or a later one). Removing a match may
+     * free the flow, so it is looked up again for the next one. */
+    while(1) {
+        dsr_maintenance_buffer_list_t* flow = _get_list(&_flows, dsr_source_get_address_begin_by_index(source, 0),
+                                              dsr_source_get_address_begin_by_index(source, source_hops - 1), 0);
+        dsr_maintenance_buffer_t* mb_el = NULL;
+
+        if(flow != NULL) {
+            for(mb_el = flow->msgs; mb_el != NULL; mb_el = mb_el->flow_next) {
+                if(mb_el->source_hops == source_hops && source_sl < mb_el->source_sl) {
+                    break;
+                }
             }
         }
-        else {
-            next_mb_el = mb_el->hh.next;
+
+        if(mb_el == NULL) {
+            break;
         }
 
-        mb_el = next_mb_el;
+        dessert_debug("PASSIVE_SOURCE[%"PRIi64"]: overheard DSR_EXT_SOURCE in msg ... is a passive ACK", id);
+        int removed = _purge_link(mb_el->link, mb_el);
+        dessert_debug("PASSIVE_SOURCE[%"PRIi64"]: removed [%i] elements due to the passive ack", id, removed);
+
+        _stats.passive_acks++;
+        dsr_compact_source_confirm(mb_el->msg);
+        _remove_el(mb_el);
     }
 
     _MB_UNLOCK;
@@ -192,131 +196,138 @@ int maintenance_buffer_passive_ack_meshrx_cb(dessert_msg_t* msg, size_t len, des
     return DESSERT_MSG_KEEP;
 }
 
+void dsr_maintenance_buffer_get_stats(dsr_maintenance_buffer_stats_t* stats) {
+    _MB_READLOCK;
+    *stats = _stats;
+    _MB_UNLOCK;
+}
+
 /******************************************************************************
  *
  * Periodic tasks --
  *
  ******************************************************************************/
 
+/** Retransmits the msgs whose retransmission timer expired; a msg out of
+ *  retransmissions breaks its link. Visits each wheel slot once at most. */
 dessert_per_result_t cleanup_maintenance_buffer(void* data, struct timeval* scheduled, struct timeval* interval) {
-    dsr_maintenance_buffer_t* mb_el = NULL;
-    dsr_maintenance_buffer_t* next_mb_el = NULL;
-
-    dessert_msg_t* msg = NULL;
-
-    struct timeval now;
+    uint64_t now_tick = _now_tick();
+    uint64_t visited = 0;
+    size_t fired_len = 0;
+    size_t i;
 
     _MB_WRITELOCK;
 
-    gettimeofday(&now, NULL);
     int RETRANSMISSION_COUNT = dsr_conf_get_retransmission_count();
-    __suseconds_t RETRANSMISSION_TIMEOUT = dsr_conf_get_retransmission_timeout();
+    uint64_t RETRANSMISSION_TICKS = _ticks(dsr_conf_get_retransmission_timeout());
 
-    //dessert_info("Maintenance buffer: cleanup.");
-
-    mb_el = dsr_maintenance_buffer;
+    if(_wheel_tick == 0) {
+        _SAFE_RETURN(DESSERT_PER_KEEP);
+    }
 
-    while(mb_el) {
-        if(TIMEVAL_COMPARE(&now, &mb_el->error_threshold) >= 0) {
-            msg = mb_el->msg;
+    while(_wheel_tick <= now_tick && visited < DSR_CONFVAR_MAINTENANCE_BUFFER_WHEEL_SLOTS) {
+        dsr_maintenance_buffer_t* mb_el = _wheel[_wheel_tick % DSR_CONFVAR_MAINTENANCE_BUFFER_WHEEL_SLOTS];
 
-            dessert_debug("MB: now: %i secs %i usecs", now.tv_sec, now.tv_usec);
-            dessert_debug("MB: el : %i secs %i usecs", mb_el->error_threshold.tv_sec, mb_el->error_threshold.tv_usec);
+        while(mb_el) {
+            dsr_maintenance_buffer_t* next_mb_el = mb_el->wheel_next;
 
-            dessert_debug("MB: el is [%i]usecs too late (relative to sched. [%i]usecs)", now.tv_usec - mb_el->error_threshold.tv_usec, scheduled->tv_usec - mb_el->error_threshold.tv_usec);
+            /* msgs of a later revolution stay in the slot */
+            if(mb_el->expires > now_tick) {
+                mb_el = next_mb_el;
+                continue;
+            }
 
             if(mb_el->retransmission_count < RETRANSMISSION_COUNT) {
-                dessert_debug("MB: id[%i] retransmitting... %d/%d", mb_el->identification, mb_el->retransmission_count + 1, RETRANSMISSION_COUNT);
-
-                /* retransmit the msg*/
-                dessert_msg_t* cloned;
-                dessert_msg_clone(&cloned, msg, false);
+                dessert_debug("MB: id[%i] retransmitting... %d/%d", mb_el->key.identification, mb_el->retransmission_count + 1, RETRANSMISSION_COUNT);
 
-                next_mb_el = mb_el->hh.next;
-                _readd_el_after_retransmission(mb_el, RETRANSMISSION_TIMEOUT);
+                mb_el->retransmission_count++;
 
-                if(ADDR_CMP(mb_el->in_iface_address, ether_null) == 0) {
-                    dsr_statistics_emit_msg(mb_el->out_iface_address, cloned->l2h.ether_dhost, cloned);
+                if(mb_el->retransmission_count > 0) {
+                    _stats.retransmissions++;
                 }
-                else {
-                    dsr_statistics_tx_msg(mb_el->out_iface_address, cloned->l2h.ether_dhost, cloned);
-                }
-
-                dessert_meshsend_fast_hwaddr(cloned, mb_el->out_iface_address);
-                dessert_msg_destroy(cloned);
-
-                mb_el = next_mb_el;
 
+                /* timers are kept relative to the first transmission, but none is due before the next tick */
+                uint64_t expires = mb_el->expires + RETRANSMISSION_TICKS;
+                _LIST_DELETE(_wheel[_wheel_tick % DSR_CONFVAR_MAINTENANCE_BUFFER_WHEEL_SLOTS], mb_el, wheel_next, wheel_prev);
+                _schedule_el(mb_el, (expires > now_tick) ? expires : now_tick + 1);
+                mb_el->refs++;
+                _fire(mb_el, _FIRED_RETRANSMIT, &fired_len);
+            }
+            /* retransmission limit reached; with ETX a link only breaks once its unicast ETX is poor, too */
+            else if(METRIC != ETX || dsr_unicast_etx_get_value(mb_el->out_iface_address, mb_el->key.nexthop) >= 3.0) {
+                int removed = _purge_link(mb_el->link, mb_el);
+                dessert_debug("MB: removed [%i] elements due to the link error", removed);
+
+                /* a purged msg may have been the next one in this slot */
+                next_mb_el = mb_el->wheel_next;
+                _stats.link_errors++;
+                _unlink_el(mb_el);
+                _fire(mb_el, _FIRED_LINK_ERROR, &fired_len);
             }
             else {
-                /* retransmission limit reached, emit rerr */
-
-#if (METRIC == ETX)
-                if(dsr_unicast_etx_get_value(mb_el->out_iface_address, msg->l2h.ether_dhost) >= 3.0) {
-#endif
-                    dessert_debug("MB: id[%d] Link error [" MAC "]->[" MAC "]", mb_el->identification, EXPLODE_ARRAY6(mb_el->out_iface_address), EXPLODE_ARRAY6(msg->l2h.ether_dhost));
-                    dessert_debug("We got the msg from " MAC , EXPLODE_ARRAY6(msg->l2h.ether_shost));
-                    /* dont expect mb_el->msg->l2h.ether_shost to be part of the failed link
-                     * because of interface changes, only mb_el->out_iface_address is valid!
-                     * mb_el->msg->l2h.ether_dhost is fine, because we set it already before
-                     * adding the msg to mb*/
-                    dsr_routecache_process_link_error(mb_el->out_iface_address,
-                                                      msg->l2h.ether_dhost);
-
-                    int removed = _remove_all_el_with_link(mb_el->out_iface_address, msg->l2h.ether_dhost, mb_el);
-                    dessert_debug("MB: removed [%i] elements due to the link error", removed);
-
-                    /* DONE: Blacklist (REPL handling, add entry) rfc4728 p74
-                     When using a MAC protocol that requires bidirectional links for
-                     unicast transmission, a unidirectional link may be discovered by the
-                     propagation of the Route Request.  When the Route Reply is sent over
-                     the reverse path, a forwarding node may discover that the next-hop is
-                     unreachable.  In this case, it MUST add the next-hop address to its
-                     blacklist (Section 4.6). */
-                    if(dessert_msg_get_ext_count(msg, DSR_EXT_REPL) > 0) {
-                        dsr_blacklist_add_node(msg->l2h.ether_dhost);
-                    }
-
-                    if(ADDR_CMP(mb_el->in_iface_address, ether_null) == 0) {
-                        /* sys2dsr was sending entity */
-                        dessert_debug("MB: Sending entity was sys2dsr.");
-                    }
-                    else {
-                        /* source_meshrx_cb was sending entity */
-                        dessert_debug("MB: Sending entity was source_meshrx_cb.");
-
-                        dsr_send_rerr_for_msg(msg, mb_el->in_iface_address,
-                                              mb_el->out_iface_address);
-                    }
-
-#if (METRIC == ETX)
-                }
+                next_mb_el = mb_el->wheel_next;
+                _unlink_el(mb_el);
+                _fire(mb_el, _FIRED_DROP, &fired_len);
+            }
 
-#endif
+            mb_el = next_mb_el;
+        }
 
-                /* cleanup */
-                next_mb_el = mb_el->hh.next;
-                _remove_el_from_buffer(mb_el);
-                _destroy_el(mb_el);
-                dessert_msg_destroy(msg);
+        _wheel_tick++;
+        visited++;
+    }
 
-                if(next_mb_el == NULL) {
-                    break;
-                }
+    if(_wheel_tick <= now_tick) {
+        _wheel_tick = now_tick + 1;
+    }
 
-                mb_el = next_mb_el;
-            }
+    _MB_UNLOCK;
 
-        }
-        else if(TIMEVAL_COMPARE(&now, &mb_el->error_threshold) == -1) {
-            /* the maintenance buffer is sorted in insertion order*/
+    for(i = 0; i < fired_len; i++) {
+        _handle_fired(&_fired[i]);
+    }
+
+    if(fired_len > 0) {
+        _MB_WRITELOCK;
 
-            _SAFE_RETURN((0));
+        for(i = 0; i < fired_len; i++) {
+            _unref_el(_fired[i].mb_el);
         }
+
+        _MB_UNLOCK;
     }
 
-    _SAFE_RETURN((0));
+    return DESSERT_PER_KEEP;
+}
+
+/******************************************************************************
+ *
+ * C L I --
+ *
+ ******************************************************************************/
+
+int dessert_cli_cmd_showmaintenancebuffer(struct cli_def* cli, char* command, char* argv[], int argc) {
+    dsr_maintenance_buffer_list_t* link = NULL;
+    dsr_maintenance_buffer_t* mb_el = NULL;
+
+    _MB_READLOCK;
+    cli_print(cli, "msgs[%u] added[%u] retransmissions[%u] acks[%u] passive_acks[%u] link_errors[%u] purged[%u]",
+              _stats.len, _stats.added, _stats.retransmissions, _stats.acks, _stats.passive_acks,
+              _stats.link_errors, _stats.purged);
+
+    HASH_FOREACH(hh, _links, link) {
+        int msgs = 0;
 
+        for(mb_el = link->msgs; mb_el != NULL; mb_el = mb_el->link_next) {
+            msgs++;
+        }
+
+        cli_print(cli, "link[" MAC "]->[" MAC "] msgs[%i]",
+                  EXPLODE_ARRAY6(link->key), EXPLODE_ARRAY6(link->key + ETHER_ADDR_LEN), msgs);
+    }
+
+    _MB_UNLOCK;
+    return CLI_OK;
 }
 
 /******************************************************************************
@@ -325,95 +336,227 @@ dessert_per_result_t cleanup_maintenance_buffer(void* data, struct timeval* sche
  *
  ******************************************************************************/
 
-static inline int _is_passive_ack(const dessert_msg_t* candidate_msg, const uint8_t source_src[ETHER_ADDR_LEN], const uint8_t source_dst[ETHER_ADDR_LEN], const uint8_t source_sl, const uint8_t source_hops) {
-    dessert_ext_t* candidate_source_ext;
-    dsr_source_ext_t* candidate_source;
+static inline uint64_t _now_tick(void) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return ((uint64_t) now.tv_sec * 1000000 + now.tv_usec) / DSR_CONFVAR_MAINTENANCE_BUFFER_WHEEL_TICK_USECS;
+}
 
-    /* if there is no source extension in the message, just return */
-    if(!dessert_msg_getext(candidate_msg, &candidate_source_ext, DSR_EXT_SOURCE, 0)) {
-        return -1;
+/** @a usecs in wheel ticks, rounded up */
+static inline uint64_t _ticks(__suseconds_t usecs) {
+    return (usecs + DSR_CONFVAR_MAINTENANCE_BUFFER_WHEEL_TICK_USECS - 1) / DSR_CONFVAR_MAINTENANCE_BUFFER_WHEEL_TICK_USECS;
+}
+
+/** takes over @a msg, whose l2h.ether_dhost has to be set already */
+static inline int _add_el(const uint16_t id, dessert_msg_t* msg, const uint8_t in_iface_address[ETHER_ADDR_LEN], const uint8_t out_iface_address[ETHER_ADDR_LEN], __suseconds_t delay, int retransmission_count) {
+    dsr_maintenance_buffer_t* mb_el = NULL;
+    dessert_ext_t* source_ext;
+    uint64_t now_tick = _now_tick();
+
+    mb_el = malloc(sizeof(dsr_maintenance_buffer_t));
+    assert(mb_el != NULL);
+
+    memset(&mb_el->key, 0, sizeof(mb_el->key));
+    ADDR_CPY(mb_el->key.nexthop, msg->l2h.ether_dhost);
+    mb_el->key.identification = id;
+    mb_el->msg = msg;
+    mb_el->refs = 1;
+    ADDR_CPY(mb_el->out_iface_address, out_iface_address);
+    ADDR_CPY(mb_el->in_iface_address, in_iface_address);
+    mb_el->retransmission_count = retransmission_count;
+    mb_el->source_hops = 0;
+    mb_el->source_sl = 0;
+    mb_el->flow = NULL;
+
+    _MB_WRITELOCK;
+
+    dsr_maintenance_buffer_t* present = NULL;
+    HASH_FIND(hh, dsr_maintenance_buffer, &mb_el->key, sizeof(mb_el->key), present);
+
+    if(present != NULL) {
+        free(mb_el);
+        _SAFE_RETURN(DSR_MAINTENANCE_BUFFER_ERROR_MESSAGE_ALREADY_IN_BUFFER);
     }
-    else {
-        candidate_source = (dsr_source_ext_t*) candidate_source_ext->data;
+
+    HASH_ADD(hh, dsr_maintenance_buffer, key, sizeof(mb_el->key), mb_el);
+
+    mb_el->link = _get_list(&_links, out_iface_address, mb_el->key.nexthop, 1);
+    _LIST_ADD(mb_el->link->msgs, mb_el, link_next, link_prev);
+
+    if(dessert_msg_getext(msg, &source_ext, DSR_EXT_SOURCE, 0)) {
+        dsr_source_ext_t* source = (dsr_source_ext_t*) source_ext->data;
+
+        mb_el->source_hops = dsr_source_get_address_count(source);
+        mb_el->source_sl = source->segments_left;
+        mb_el->flow = _get_list(&_flows, dsr_source_get_address_begin_by_index(source, 0),
+                                dsr_source_get_address_begin_by_index(source, mb_el->source_hops - 1), 1);
+        _LIST_ADD(mb_el->flow->msgs, mb_el, flow_next, flow_prev);
+    }
+
+    if(_wheel_tick == 0) {
+        _wheel_tick = now_tick;
     }
 
-    uint8_t candidate_source_src[ETHER_ADDR_LEN];
-    uint8_t candidate_source_dst[ETHER_ADDR_LEN];
-    uint8_t candidate_source_sl = candidate_source->segments_left;
-    uint8_t candidate_source_hops = dsr_source_get_address_count(candidate_source);
+    _schedule_el(mb_el, now_tick + _ticks(delay));
 
-    ADDR_CPY(candidate_source_src, dsr_source_get_address_begin_by_index(candidate_source, 0));
-    ADDR_CPY(candidate_source_dst, dsr_source_get_address_begin_by_index(candidate_source, candidate_source_hops - 1));
+    _stats.len++;
+    _stats.added++;
+
+    _SAFE_RETURN(DSR_MAINTENANCE_BUFFER_SUCCESS);
+}
 
+/** the list of the link or flow @a a -> @a b, a new one if there is none and @a create is set */
+static inline dsr_maintenance_buffer_list_t* _get_list(dsr_maintenance_buffer_list_t** lists, const uint8_t a[ETHER_ADDR_LEN], const uint8_t b[ETHER_ADDR_LEN], int create) {
+    dsr_maintenance_buffer_list_t* list = NULL;
+    uint8_t key[2 * ETHER_ADDR_LEN];
 
-    if(candidate_source_hops == source_hops
-       && ADDR_CMP(candidate_source_src, source_src) == 0
-       && ADDR_CMP(candidate_source_dst, source_dst) == 0 && source_sl
-       < candidate_source_sl) {
+    memcpy(key, a, ETHER_ADDR_LEN);
+    memcpy(key + ETHER_ADDR_LEN, b, ETHER_ADDR_LEN);
 
-        /* is PASSIVE_ACK */
+    HASH_FIND(hh, *lists, key, sizeof(key), list);
 
-        return 0;
+    if(list == NULL && create) {
+        list = malloc(sizeof(dsr_maintenance_buffer_list_t));
+        assert(list != NULL);
+        memcpy(list->key, key, sizeof(key));
+        list->msgs = NULL;
+        HASH_ADD(hh, *lists, key, sizeof(key), list);
     }
 
-    return -1;
+    return list;
 }
 
-static inline int _remove_all_el_with_link(const uint8_t out_interface[ETHER_ADDR_LEN], const uint8_t msg_dhost[ETHER_ADDR_LEN], dsr_maintenance_buffer_t* dont_delete_mb_el) {
-    dsr_maintenance_buffer_t* buffer;
-    dsr_maintenance_buffer_t* next_buffer;
-    int elements_removed = 0;
+static inline void _release_list(dsr_maintenance_buffer_list_t** lists, dsr_maintenance_buffer_list_t* list) {
+    if(list->msgs == NULL) {
+        HASH_DELETE(hh, *lists, list);
+        free(list);
+    }
+}
 
-    buffer = dsr_maintenance_buffer;
+/** links @a mb_el into the wheel slot of tick @a expires, never before the current tick */
+static inline void _schedule_el(dsr_maintenance_buffer_t* mb_el, uint64_t expires) {
+    if(expires < _wheel_tick) {
+        expires = _wheel_tick;
+    }
 
-    while(buffer) {
-        next_buffer = buffer->hh.next;
+    mb_el->expires = expires;
+    _LIST_ADD(_wheel[expires % DSR_CONFVAR_MAINTENANCE_BUFFER_WHEEL_SLOTS], mb_el, wheel_next, wheel_prev);
+}
 
-        if(buffer != dont_delete_mb_el && ADDR_CMP(buffer->out_iface_address, out_interface) == 0 &&
-           ADDR_CMP(buffer->msg->l2h.ether_dhost, msg_dhost) == 0) {
+/** unlinks @a mb_el from the hash, its lists and the timer wheel, the reference of the buffer is kept */
+static inline void _unlink_el(dsr_maintenance_buffer_t* mb_el) {
+    assert(mb_el->link != NULL);
 
-            _remove_el_from_buffer(buffer);
-            elements_removed++;
-            dessert_msg_destroy(buffer->msg);
-            _destroy_el(buffer);
+    HASH_DELETE(hh, dsr_maintenance_buffer, mb_el);
+    _LIST_DELETE(_wheel[mb_el->expires % DSR_CONFVAR_MAINTENANCE_BUFFER_WHEEL_SLOTS], mb_el, wheel_next, wheel_prev);
 
-        }
+    _LIST_DELETE(mb_el->link->msgs, mb_el, link_next, link_prev);
+    _release_list(&_links, mb_el->link);
+    mb_el->link = NULL;
 
-        buffer = next_buffer;
+    if(mb_el->flow != NULL) {
+        _LIST_DELETE(mb_el->flow->msgs, mb_el, flow_next, flow_prev);
+        _release_list(&_flows, mb_el->flow);
+        mb_el->flow = NULL;
     }
 
-    return elements_removed;
+    _stats.len--;
 }
 
-static inline void _add_el_to_buffer(dsr_maintenance_buffer_t* mb_el) {
-    assert(mb_el != NULL);
-    HASH_ADD(hh, dsr_maintenance_buffer, identification, sizeof(uint16_t), mb_el);
+static inline void _remove_el(dsr_maintenance_buffer_t* mb_el) {
+    _unlink_el(mb_el);
+    _unref_el(mb_el);
 }
 
-static inline void _remove_el_from_buffer(dsr_maintenance_buffer_t* mb_el) {
-    assert(mb_el != NULL);
-    HASH_DELETE(hh, dsr_maintenance_buffer, mb_el);
+static inline void _unref_el(dsr_maintenance_buffer_t* mb_el) {
+    assert(mb_el->refs > 0);
+
+    if(--mb_el->refs == 0) {
+        dessert_msg_destroy(mb_el->msg);
+        free(mb_el);
+    }
 }
 
-static inline void _destroy_el(dsr_maintenance_buffer_t* mb_el) {
-    assert(mb_el != NULL);
-    free(mb_el);
-    mb_el = NULL;
+/** removes all msgs over @a link but @a keep, which has to be one of them */
+static inline int _purge_link(dsr_maintenance_buffer_list_t* link, dsr_maintenance_buffer_t* keep) {
+    dsr_maintenance_buffer_t* mb_el = link->msgs;
+    int removed = 0;
+
+    assert(keep->link == link);
+
+    while(mb_el) {
+        dsr_maintenance_buffer_t* next_mb_el = mb_el->link_next;
+
+        if(mb_el != keep) {
+            _remove_el(mb_el);
+            removed++;
+        }
+
+        mb_el = next_mb_el;
+    }
+
+    _stats.purged += removed;
+    return removed;
 }
 
-static inline void _readd_el_after_retransmission(
-    dsr_maintenance_buffer_t* mb_el, __suseconds_t timeout) {
-    _remove_el_from_buffer(mb_el);
-    mb_el->retransmission_count++;
-    TIMEVAL_ADD_SAFE(&mb_el->error_threshold, 0, timeout);
-    _add_el_to_buffer(mb_el);
+/** remembers @a mb_el, whose reference is handed over, for after the lock is released */
+static inline void _fire(dsr_maintenance_buffer_t* mb_el, int action, size_t* fired_len) {
+    if(*fired_len == _fired_size) {
+        _fired_size = _fired_size ? 2 * _fired_size : 64;
+        _fired = realloc(_fired, _fired_size * sizeof(dsr_maintenance_buffer_fired_t));
+        assert(_fired != NULL);
+    }
+
+    _fired[*fired_len].mb_el = mb_el;
+    _fired[*fired_len].action = action;
+    (*fired_len)++;
 }
 
-static inline dsr_maintenance_buffer_t* _get_msg_by_key(uint16_t id) {
-    dsr_maintenance_buffer_t* mb_el;
+static inline void _handle_fired(dsr_maintenance_buffer_fired_t* fired) {
+    dsr_maintenance_buffer_t* mb_el = fired->mb_el;
+    dessert_msg_t* msg = mb_el->msg;
 
-    HASH_FIND(hh, dsr_maintenance_buffer, &id, sizeof(id), mb_el);
+    if(fired->action == _FIRED_RETRANSMIT) {
+        /* retransmit the msg */
+        if(ADDR_CMP(mb_el->in_iface_address, ether_null) == 0) {
+            dsr_statistics_emit_msg(mb_el->out_iface_address, msg->l2h.ether_dhost, msg);
+        }
+        else {
+            dsr_statistics_tx_msg(mb_el->out_iface_address, msg->l2h.ether_dhost, msg);
+        }
 
-    return mb_el;
-}
+        dessert_meshsend_fast_hwaddr(msg, mb_el->out_iface_address);
+    }
+    else if(fired->action == _FIRED_LINK_ERROR) {
+        dessert_debug("MB: id[%d] Link error [" MAC "]->[" MAC "]", mb_el->key.identification, EXPLODE_ARRAY6(mb_el->out_iface_address), EXPLODE_ARRAY6(mb_el->key.nexthop));
+        dessert_debug("We got the msg from " MAC , EXPLODE_ARRAY6(msg->l2h.ether_shost));
+        /* dont expect mb_el->msg->l2h.ether_shost to be part of the failed link
+         * because of interface changes, only mb_el->out_iface_address is valid!
+         * mb_el->key.nexthop is fine, because it is taken from
+         * msg->l2h.ether_dhost when adding the msg to mb*/
+        dsr_routecache_process_link_error(mb_el->out_iface_address, mb_el->key.nexthop);
+
+        /* DONE: Blacklist (REPL handling, add entry) rfc4728 p74
+         When using a MAC protocol that requires bidirectional links for
+         unicast transmission, a unidirectional link may be discovered by the
+         propagation of the Route Request.  When the Route Reply is sent over
+         the reverse path, a forwarding node may discover that the next-hop is
+         unreachable.  In this case, it MUST add the next-hop address to its
+         blacklist (Section 4.6). */
+        if(dessert_msg_get_ext_count(msg, DSR_EXT_REPL) > 0) {
+            dsr_blacklist_add_node(mb_el->key.nexthop);
+        }
+
+        if(ADDR_CMP(mb_el->in_iface_address, ether_null) == 0) {
+            /* sys2dsr was sending entity */
+            dessert_debug("MB: Sending entity was sys2dsr.");
+        }
+        else {
+            /* source_meshrx_cb was sending entity */
+            dessert_debug("MB: Sending entity was source_meshrx_cb.");
 
+            dsr_send_rerr_for_msg(msg, mb_el->in_iface_address,
+                                  mb_el->out_iface_address);
+        }
+    }
+}
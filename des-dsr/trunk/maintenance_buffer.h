@@ -38,15 +38,53 @@
 #define DSR_MAINTENANCE_BUFFER_NEXTHOP_REACHABILITY_PASSIVE        0
 #define DSR_MAINTENANCE_BUFFER_NEXTHOP_REACHABILITY_ACKREQ_ACK     1
 
-typedef struct __attribute__((__packed__)) dsr_maintenance_buffer {
-    uint16_t identification; /* key for uthash */
+typedef struct dsr_maintenance_buffer dsr_maintenance_buffer_t;
+typedef struct dsr_maintenance_buffer_list dsr_maintenance_buffer_list_t;
+
+typedef struct __attribute__((__packed__)) dsr_maintenance_buffer_key {
+    uint8_t nexthop[ETHER_ADDR_LEN];     /* l2h.ether_dhost of the msg */
+    uint16_t identification;
+} dsr_maintenance_buffer_key_t;
+
+/** a msg waiting for its ACK or passive ACK, linked into the list of its
+ *  link, the list of its flow and a timer wheel slot */
+struct dsr_maintenance_buffer {
+    dsr_maintenance_buffer_key_t key;   /* key for uthash */
     dessert_msg_t* msg;
+    int refs;                           /* the buffer and retransmissions in flight */
     uint8_t in_iface_address[ETHER_ADDR_LEN];
     uint8_t out_iface_address[ETHER_ADDR_LEN];
     int retransmission_count;
-    struct timeval error_threshold;
+    uint64_t expires;                   /* timer wheel tick of the next retransmission */
+    uint8_t source_hops;                /* of the DSR_EXT_SOURCE, for passive ACKs */
+    uint8_t source_sl;
+    dsr_maintenance_buffer_list_t* link; /* out_iface_address -> nexthop */
+    dsr_maintenance_buffer_list_t* flow; /* source route source -> destination, NULL without one */
+    dsr_maintenance_buffer_t* link_next;
+    dsr_maintenance_buffer_t* link_prev;
+    dsr_maintenance_buffer_t* flow_next;
+    dsr_maintenance_buffer_t* flow_prev;
+    dsr_maintenance_buffer_t* wheel_next;
+    dsr_maintenance_buffer_t* wheel_prev;
+    UT_hash_handle hh;
+};
+
+/** all buffered msgs sent over one link or along one source route */
+struct dsr_maintenance_buffer_list {
+    uint8_t key[2 * ETHER_ADDR_LEN];
+    dsr_maintenance_buffer_t* msgs;
     UT_hash_handle hh;
-} dsr_maintenance_buffer_t;
+};
+
+typedef struct dsr_maintenance_buffer_stats {
+    uint32_t len;
+    uint32_t added;
+    uint32_t retransmissions;
+    uint32_t acks;
+    uint32_t passive_acks;
+    uint32_t link_errors;
+    uint32_t purged;                    /* removed along with a link error or passive ACK of their link */
+} dsr_maintenance_buffer_stats_t;
 
 int maintenance_buffer_passive_ack_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, dessert_meshif_t* iface, dessert_frameid_t id);
 
@@ -60,6 +98,10 @@ inline int dsr_maintenance_buffer_add_msg(
 
 inline int dsr_maintenance_buffer_add_msg_delay(const uint16_t id, dessert_msg_t* msg, const uint8_t in_iface_address[ETHER_ADDR_LEN], const uint8_t out_iface_address[ETHER_ADDR_LEN], __suseconds_t delay);
 
-inline int dsr_maintenance_buffer_delete_msg(const uint16_t id);
+inline int dsr_maintenance_buffer_delete_msg(const uint8_t nexthop[ETHER_ADDR_LEN], const uint16_t id);
+
+void dsr_maintenance_buffer_get_stats(dsr_maintenance_buffer_stats_t* stats);
+
+int dessert_cli_cmd_showmaintenancebuffer(struct cli_def* cli, char* command, char* argv[], int argc);
 
 #endif /* MAINTENANCE_BUFFER_H_ */
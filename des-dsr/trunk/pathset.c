@@ -0,0 +1,395 @@
+/******************************************************************************
+ Copyright 2010, David Gutzmann, Freie Universitaet Berlin (FUB).
+ All rights reserved.
+
+ These sources were originally developed by David Gutzmann
+ at Freie Universitaet Berlin (http://www.fu-berlin.de/),
+ Computer Systems and Telematics / Distributed, Embedded Systems (DES) group
+ (http://cst.mi.fu-berlin.de/, http://www.des-testbed.net/)
+ ------------------------------------------------------------------------------
+ This program is free software: you can redistribute it and/or modify it under
+ the terms of the GNU General Public License as published by the Free Software
+ Foundation, either version 3 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with
+ this program. If not, see http://www.gnu.org/licenses/ .
+ ------------------------------------------------------------------------------
+ For further information and questions please use the web site
+ http://www.des-testbed.net/
+ ------------------------------------------------------------------------------
+
+ ******************************************************************************/
+
+#include "dsr.h"
+
+#define _WORD_BITS 64
+#define _MIN_SLOTS 64
+#define _MIN_PATHS 8
+#define _MIN_IDS 128
+
+#define _BIT_IS_SET(bits, n) ((bits)[(n) / _WORD_BITS] & (1ULL << ((n) % _WORD_BITS)))
+
+/* local forward declarations */
+static inline uint64_t _get_key(const uint8_t address[ETHER_ADDR_LEN]);
+static inline uint32_t _hash(uint64_t key);
+static inline uint16_t _get_node_id(dsr_pathset_t* set, const uint8_t address[ETHER_ADDR_LEN]);
+static inline void _reserve_paths(dsr_pathset_t* set, int paths);
+static inline void _reserve_ids(dsr_pathset_t* set, int ids);
+static inline void _grow_nodes(dsr_pathset_t* set, int slots);
+static inline void _update_bits(dsr_pathset_t* set);
+static inline int _nodes_in_common(dsr_pathset_t* set, int i, int j);
+static inline int _links_in_common(dsr_pathset_t* set, int i, int j);
+
+inline void dsr_pathset_init(dsr_pathset_t* set, int flags) {
+    assert(set != NULL);
+
+    memset(set, 0, sizeof(dsr_pathset_t));
+    set->flags = flags;
+}
+
+inline void dsr_pathset_destroy(dsr_pathset_t* set) {
+    assert(set != NULL);
+
+    free(set->paths);
+    free(set->ids);
+    free(set->nodes);
+    free(set->node_ids);
+    free(set->bits);
+
+    dsr_pathset_init(set, set->flags);
+}
+
+inline void dsr_pathset_reserve(dsr_pathset_t* set, int paths, int addresses) {
+    int slots = _MIN_SLOTS;
+
+    assert(set != NULL);
+
+    _reserve_paths(set, paths);
+    _reserve_ids(set, set->ids_len + addresses);
+
+    while(slots < (set->node_count + addresses) * 2) {
+        slots *= 2;
+    }
+
+    if(slots > set->node_slots) {
+        _grow_nodes(set, slots);
+    }
+}
+
+inline int dsr_pathset_add(dsr_pathset_t* set, const uint8_t* address, size_t stride, int len, uint32_t weight, void* data) {
+    dsr_pathset_path_t* path;
+    int i;
+
+    assert(set != NULL);
+    assert(address != NULL);
+    assert(len >= 0);
+
+    _reserve_paths(set, set->count + 1);
+    _reserve_ids(set, set->ids_len + len);
+
+    path = &set->paths[set->count];
+    path->ids = set->ids_len;
+    path->len = len;
+    path->weight = weight;
+    path->data = data;
+
+    for(i = 0; i < len; i++) {
+        set->ids[set->ids_len++] = _get_node_id(set, address + i * stride);
+    }
+
+    return set->count++;
+}
+
+inline int dsr_pathset_add_path(dsr_pathset_t* set, dsr_path_t* path, void* data) {
+    assert(path != NULL);
+
+    return dsr_pathset_add(set, path->address, ETHER_ADDR_LEN, path->len, path->weight, data);
+}
+
+inline void dsr_pathset_remove_last(dsr_pathset_t* set) {
+    assert(set != NULL);
+    assert(set->count > 0);
+
+    /* the node numbers of the path stay allocated */
+    set->count--;
+    set->ids_len = set->paths[set->count].ids;
+
+    if(set->bits_count > set->count) {
+        set->bits_count = set->count;
+    }
+}
+
+inline void* dsr_pathset_get_data(dsr_pathset_t* set, int i) {
+    assert(set != NULL);
+    assert(i >= 0 && i < set->count);
+
+    return set->paths[i].data;
+}
+
+inline int dsr_pathset_nodes_in_common(dsr_pathset_t* set, int i, int j) {
+    assert(set != NULL);
+    assert(i >= 0 && i < set->count);
+    assert(j >= 0 && j < set->count);
+
+    _update_bits(set);
+
+    return _nodes_in_common(set, i, j);
+}
+
+inline int dsr_pathset_links_in_common(dsr_pathset_t* set, int i, int j) {
+    assert(set != NULL);
+    assert(i >= 0 && i < set->count);
+    assert(j >= 0 && j < set->count);
+
+    _update_bits(set);
+
+    return _links_in_common(set, i, j);
+}
+
+inline int dsr_pathset_select_disjoint(dsr_pathset_t* set, int* selected, int selected_len, int k) {
+    int i, s;
+
+    assert(set != NULL);
+    assert(selected != NULL);
+
+    if(k > set->count) {
+        k = set->count;
+    }
+
+    _update_bits(set);
+
+    while(selected_len < k) {
+        int best = -1;
+        int best_nodes = 0;
+        int best_links = 0;
+
+        for(i = 0; i < set->count; i++) {
+            dsr_pathset_path_t* path = &set->paths[i];
+            int nodes = 0;
+            int links = 0;
+
+            for(s = 0; s < selected_len && selected[s] != i; s++) {
+                nodes += _nodes_in_common(set, i, selected[s]);
+            }
+
+            if(s < selected_len || (best >= 0 && nodes > best_nodes)) {
+                continue; /* already selected or worse */
+            }
+
+            for(s = 0; s < selected_len; s++) {
+                links += _links_in_common(set, i, selected[s]);
+            }
+
+            if(best < 0
+               || nodes < best_nodes
+               || (nodes == best_nodes && links < best_links)
+               || (nodes == best_nodes && links == best_links && path->weight < set->paths[best].weight)
+               || (nodes == best_nodes && links == best_links && path->weight == set->paths[best].weight
+                   && path->len < set->paths[best].len)) {
+                best = i;
+                best_nodes = nodes;
+                best_links = links;
+            }
+        }
+
+        assert(best >= 0);
+        selected[selected_len++] = best;
+    }
+
+    return selected_len;
+}
+
+/******************************************************************************
+ *
+ * LOCAL
+ *
+ ******************************************************************************/
+
+/** The address as integer; never 0, that marks an empty slot. */
+static inline uint64_t _get_key(const uint8_t address[ETHER_ADDR_LEN]) {
+    uint32_t high;
+    uint16_t low;
+
+    memcpy(&high, address, sizeof(high));
+    memcpy(&low, address + sizeof(high), sizeof(low));
+
+    return (1ULL << 48) | ((uint64_t) high << 16) | low;
+}
+
+static inline uint32_t _hash(uint64_t key) {
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static inline uint16_t _get_node_id(dsr_pathset_t* set, const uint8_t address[ETHER_ADDR_LEN]) {
+    uint64_t key = _get_key(address);
+    uint32_t i;
+
+    if((set->node_count + 1) * 2 > set->node_slots) {
+        _grow_nodes(set, (set->node_slots == 0) ? _MIN_SLOTS : set->node_slots * 2);
+    }
+
+    for(i = _hash(key) & (set->node_slots - 1); set->nodes[i] != 0; i = (i + 1) & (set->node_slots - 1)) {
+        if(set->nodes[i] == key) {
+            return set->node_ids[i];
+        }
+    }
+
+    assert(set->node_count <= UINT16_MAX);
+    set->nodes[i] = key;
+    set->node_ids[i] = set->node_count++;
+
+    return set->node_ids[i];
+}
+
+static inline void _reserve_paths(dsr_pathset_t* set, int paths) {
+    if(paths <= set->size) {
+        return;
+    }
+
+    if(set->size == 0) {
+        set->size = _MIN_PATHS;
+    }
+
+    while(paths > set->size) {
+        set->size *= 2;
+    }
+
+    set->paths = realloc(set->paths, set->size * sizeof(dsr_pathset_path_t));
+    assert(set->paths != NULL);
+}
+
+static inline void _reserve_ids(dsr_pathset_t* set, int ids) {
+    if(ids <= set->ids_size) {
+        return;
+    }
+
+    if(set->ids_size == 0) {
+        set->ids_size = _MIN_IDS;
+    }
+
+    while(ids > set->ids_size) {
+        set->ids_size *= 2;
+    }
+
+    set->ids = realloc(set->ids, set->ids_size * sizeof(uint16_t));
+    assert(set->ids != NULL);
+}
+
+/** Rehashes the node numbers into @a slots slots, a power of two. */
+static inline void _grow_nodes(dsr_pathset_t* set, int slots) {
+    uint64_t* old = set->nodes;
+    uint16_t* old_ids = set->node_ids;
+    int old_slots = set->node_slots;
+    int i;
+
+    set->node_slots = slots;
+    set->nodes = calloc(set->node_slots, sizeof(uint64_t));
+    set->node_ids = malloc(set->node_slots * sizeof(uint16_t));
+    assert(set->nodes != NULL);
+    assert(set->node_ids != NULL);
+
+    for(i = 0; i < old_slots; i++) {
+        uint32_t j;
+
+        if(old[i] == 0) {
+            continue;
+        }
+
+        for(j = _hash(old[i]) & (set->node_slots - 1); set->nodes[j] != 0; j = (j + 1) & (set->node_slots - 1));
+
+        set->nodes[j] = old[i];
+        set->node_ids[j] = old_ids[i];
+    }
+
+    free(old);
+    free(old_ids);
+}
+
+/** Sets the bits of the paths added since the last query; all of them anew
+ *  if there are more nodes or paths than the bits have room for. */
+static inline void _update_bits(dsr_pathset_t* set) {
+    int i, n;
+
+    if(set->bits_count == set->count) {
+        return;
+    }
+
+    if(set->bits == NULL || set->node_count > set->node_words * _WORD_BITS || set->count > set->bits_size) {
+        if(set->node_words == 0) {
+            set->node_words = 1;
+        }
+
+        while(set->node_count > set->node_words * _WORD_BITS) {
+            set->node_words *= 2;
+        }
+
+        set->bits_size = set->size;
+        set->bits_count = 0;
+
+        free(set->bits);
+        set->bits = malloc(set->bits_size * set->node_words * sizeof(uint64_t));
+        assert(set->bits != NULL);
+    }
+
+    for(i = set->bits_count; i < set->count; i++) {
+        dsr_pathset_path_t* path = &set->paths[i];
+        uint16_t* ids = set->ids + path->ids;
+        uint64_t* bits = set->bits + i * set->node_words;
+
+        memset(bits, 0, set->node_words * sizeof(uint64_t));
+
+        for(n = 0; n < path->len; n++) {
+            bits[ids[n] / _WORD_BITS] |= 1ULL << (ids[n] % _WORD_BITS);
+        }
+    }
+
+    set->bits_count = set->count;
+}
+
+static inline int _nodes_in_common(dsr_pathset_t* set, int i, int j) {
+    uint64_t* a = set->bits + i * set->node_words;
+    uint64_t* b = set->bits + j * set->node_words;
+    int count = 0;
+    int w;
+
+    for(w = 0; w < set->node_words; w++) {
+        uint64_t common = a[w] & b[w];
+
+        /* sparse: most words have nothing in common, and the popcount may be a libgcc call */
+        if(common != 0) {
+            count += __builtin_popcountll(common);
+        }
+    }
+
+    return count;
+}
+
+static inline int _links_in_common(dsr_pathset_t* set, int i, int j) {
+    dsr_pathset_path_t* a = &set->paths[i];
+    dsr_pathset_path_t* b = &set->paths[j];
+    uint16_t* a_ids = set->ids + a->ids;
+    uint16_t* b_ids = set->ids + b->ids;
+    uint64_t* b_bits = set->bits + j * set->node_words;
+    int first_link = (set->flags & DSR_PATHSET_SKIP_FIRST_LINK) ? 1 : 0;
+    int count = 0;
+    int p, q;
+
+    for(p = first_link; p + 1 < a->len; p++) {
+        if(!_BIT_IS_SET(b_bits, a_ids[p]) || !_BIT_IS_SET(b_bits, a_ids[p + 1])) {
+            continue;
+        }
+
+        for(q = first_link; q + 1 < b->len; q++) {
+            if(b_ids[q] == a_ids[p] && b_ids[q + 1] == a_ids[p + 1]) {
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,102 @@
+/******************************************************************************
+ Copyright 2010, David Gutzmann, Freie Universitaet Berlin (FUB).
+ All rights reserved.
+
+ These sources were originally developed by David Gutzmann
+ at Freie Universitaet Berlin (http://www.fu-berlin.de/),
+ Computer Systems and Telematics / Distributed, Embedded Systems (DES) group
+ (http://cst.mi.fu-berlin.de/, http://www.des-testbed.net/)
+ ------------------------------------------------------------------------------
+ This program is free software: you can redistribute it and/or modify it under
+ the terms of the GNU General Public License as published by the Free Software
+ Foundation, either version 3 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with
+ this program. If not, see http://www.gnu.org/licenses/ .
+ ------------------------------------------------------------------------------
+ For further information and questions please use the web site
+ http://www.des-testbed.net/
+ ------------------------------------------------------------------------------
+
+ ******************************************************************************/
+#ifndef PATHSET_H_
+#define PATHSET_H_
+
+#include "dsr.h"
+
+/******************************************************************************
+ *
+ * Path set
+ *
+ * A small set of paths, e.g. the routes that answered one route discovery,
+ * compared for node and link disjointness. The nodes of the set are numbered
+ * as paths are added and every path keeps a bitset of its node numbers, so
+ * the nodes two paths have in common are a popcount over a few words instead
+ * of a comparison of every address of one path with every address of the
+ * other. A (directed) link u-v of one path can only be on the other one if
+ * both u and v are, which two bit tests tell; only then is the successor of
+ * u on the other path looked up.
+ ******************************************************************************/
+
+/** Flag for dsr_pathset_init: ignore the first link of every path. */
+#define DSR_PATHSET_SKIP_FIRST_LINK                      0x01
+
+typedef struct dsr_pathset_path {
+    int ids; /* offset of the node numbers in path order */
+    int len;
+    uint32_t weight;
+    void* data;
+} dsr_pathset_path_t;
+
+typedef struct dsr_pathset {
+    int flags;
+    dsr_pathset_path_t* paths;
+    int count;
+    int size;
+    uint16_t* ids;
+    int ids_len;
+    int ids_size;
+    /* node numbers: open addressing on the address as integer, 0 marks an empty slot */
+    uint64_t* nodes;
+    uint16_t* node_ids;
+    int node_count;
+    int node_slots;
+    /* node_words words of node bits per path, set for the first bits_count
+     * paths, for the others on the next query */
+    uint64_t* bits;
+    int bits_count;
+    int bits_size;
+    int node_words;
+} dsr_pathset_t;
+
+inline void dsr_pathset_init(dsr_pathset_t* set, int flags);
+inline void dsr_pathset_destroy(dsr_pathset_t* set);
+/** Makes room for @a paths paths of @a addresses addresses in total, so
+ *  adding them allocates nothing. */
+inline void dsr_pathset_reserve(dsr_pathset_t* set, int paths, int addresses);
+
+/** Adds the path of @a len addresses starting at @a address, @a stride bytes
+ *  apart, and returns its index in the set. */
+inline int dsr_pathset_add(dsr_pathset_t* set, const uint8_t* address, size_t stride, int len, uint32_t weight, void* data);
+inline int dsr_pathset_add_path(dsr_pathset_t* set, dsr_path_t* path, void* data);
+/** Removes the path added last. */
+inline void dsr_pathset_remove_last(dsr_pathset_t* set);
+
+inline void* dsr_pathset_get_data(dsr_pathset_t* set, int i);
+
+inline int dsr_pathset_nodes_in_common(dsr_pathset_t* set, int i, int j);
+inline int dsr_pathset_links_in_common(dsr_pathset_t* set, int i, int j);
+
+/** Extends the @a selected_len paths in @a selected up to @a k paths. Each
+ *  step takes the path with the fewest nodes, then links, in common with
+ *  the paths selected so far (summed over them); ties go to the smaller
+ *  weight, then to the fewer hops, then to the path added first. Returns the
+ *  new selected_len. */
+inline int dsr_pathset_select_disjoint(dsr_pathset_t* set, int* selected, int selected_len, int k);
+
+#endif /* PATHSET_H_ */
@@ -33,7 +33,17 @@ pthread_rwlock_t _dsr_routecache_rwlock = PTHREAD_RWLOCK_INITIALIZER;
 #define _ROUTECACHE_UNLOCK pthread_rwlock_unlock(&_dsr_routecache_rwlock)
 #define _SAFE_RETURN(x) _ROUTECACHE_UNLOCK; return(x);
 
+/*
+ * Every destination keeps its paths in a small array, bounded by
+ * DSR_ROUTECACHE_MAX_PATHS. Each cached path is registered in _links, an
+ * inverted index from every link u->v of the path to the paths using it,
+ * so a link error only touches the affected paths. A hash over the hops
+ * of every path makes duplicate detection a compare of two integers in
+ * the common case.
+ */
+
 dsr_routecache_t* dsr_routecache = NULL;
+static dsr_routecache_link_t* _links = NULL;
 
 /* local forward declarations */
 static inline void _delete_all_paths_with_link(const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[ETHER_ADDR_LEN]);
@@ -41,7 +51,7 @@ static inline dsr_routecache_t* _get_entry_by_key(const uint8_t dest[ETHER_ADDR_
 static inline dsr_routecache_t* _add_new_entry(const uint8_t dest[ETHER_ADDR_LEN]);
 static inline void _remove_entry(dsr_routecache_t* dest_rc_el);
 static inline void _add_to_pathlist(dsr_routecache_t* rc_el, dsr_path_t* path);
-static inline void _remove_from_pathlist(dsr_routecache_t* rc_el, dsr_path_t* path);
+static inline void _remove_from_pathlist(dsr_routecache_path_t* rc_path);
 
 /**
  *
@@ -61,9 +71,12 @@ int dsr_routecache_get_first(const uint8_t dest[ETHER_ADDR_LEN], dsr_path_t* pat
 
     if(dest_rc_el == NULL) {
         //		dessert_debug("[ROUTECACHE] 2a: No Path found in RC.");
-#if (LINKCACHE == 1)
         dsr_path_t* p = NULL;
 
+        if(LINKCACHE == 0) {
+            _SAFE_RETURN(DSR_ROUTECACHE_ERROR_NO_PATH_TO_DESTINATION);
+        }
+
         if(dsr_linkcache_get_shortest_path(dessert_l25_defsrc, dest, &p) < 0) {
             //			dessert_debug("[ROUTECACHE] 3a: ... No Path found in LC.");
             _SAFE_RETURN(DSR_ROUTECACHE_ERROR_NO_PATH_TO_DESTINATION);
@@ -74,13 +87,6 @@ int dsr_routecache_get_first(const uint8_t dest[ETHER_ADDR_LEN], dsr_path_t* pat
             dest_rc_el = _add_new_entry(dest);
             _add_to_pathlist(dest_rc_el, p);
         }
-
-#else /* NO LINKCACHE */
-        _ROUTECACHE_UNLOCK;
-
-        return DSR_ROUTECACHE_ERROR_NO_PATH_TO_DESTINATION;
-#endif /* LINKCACHE == 1*/
-
     }
     else {
 
@@ -88,7 +94,7 @@ int dsr_routecache_get_first(const uint8_t dest[ETHER_ADDR_LEN], dsr_path_t* pat
     }
 
     /* paths in path list are sorted, so the first path has least weight */
-    memcpy(path, dest_rc_el->paths, sizeof(dsr_path_t));
+    memcpy(path, dest_rc_el->paths[0]->path, sizeof(dsr_path_t));
     path->next = NULL;
     path->prev = NULL;
     //	dessert_debug("[ROUTECACHE]  4: ... Copied path with length[%d]", path->len);
@@ -117,21 +123,13 @@ int dsr_routecache_get_next_round_robin(const uint8_t dest[ETHER_ADDR_LEN], dsr_
         //		dessert_debug("[ROUTECACHE] 2b: ... Path found in RC.");
     }
 
-    memcpy(path, dest_rc_el->paths, sizeof(dsr_path_t));
+    memcpy(path, dest_rc_el->paths[dest_rc_el->rr_index]->path, sizeof(dsr_path_t));
     path->next = NULL;
     path->prev = NULL;
     //	dessert_debug("[ROUTECACHE]  4: ... Copied path with length[%d]... now round-robin", path->len);
 
     /* load balancing (round-robin) - the first will be the last... */
-    if((dest_rc_el->paths)->next != NULL) {
-        dsr_path_t* first = dest_rc_el->paths;
-        DL_DELETE(dest_rc_el->paths, first);
-        DL_APPEND(dest_rc_el->paths, first);
-
-    }
-    else {
-        //		dessert_debug("only one path in the routecache");
-    }
+    dest_rc_el->rr_index = (dest_rc_el->rr_index + 1) % dest_rc_el->route_count;
 
     _ROUTECACHE_UNLOCK;
     //	dsr_routecache_print_routecache_to_debug();
@@ -143,14 +141,10 @@ void dsr_routecache_process_link_error(const uint8_t u[ETHER_ADDR_LEN], const ui
     _delete_all_paths_with_link(u, v);
     _ROUTECACHE_UNLOCK;
 
-#if (LINKCACHE == 1)
-
-    if(dsr_linkcache_remove_link(u, v) == DSR_LINKCACHE_SUCCESS) {
+    if(LINKCACHE == 1 && dsr_linkcache_remove_link(u, v) == DSR_LINKCACHE_SUCCESS) {
         /* the link was removed, run Dijkstra again */
         dsr_linkcache_run_dijkstra(dessert_l25_defsrc);
     }
-
-#endif /* LINKCACHE */
 }
 
 void dsr_routecache_add_path(const uint8_t dest[ETHER_ADDR_LEN], dsr_path_t* path) {
@@ -172,21 +166,64 @@ void dsr_routecache_add_path(const uint8_t dest[ETHER_ADDR_LEN], dsr_path_t* pat
 }
 
 void dsr_routecache_print_routecache_to_debug() {
-    dsr_path_t* iter_path = NULL;
     dsr_routecache_t* rc_el = NULL;
+    size_t i;
 
     _ROUTECACHE_READLOCK;
 
     HASH_FOREACH(hh, dsr_routecache, rc_el) {
         dessert_debug("ROUTECACHE: dest[" MAC "] routes[%u]", EXPLODE_ARRAY6(rc_el->address), rc_el->route_count);
-        DL_FOREACH(rc_el->paths, iter_path) {
-            dsr_path_print_to_debug(iter_path);
+
+        for(i = 0; i < rc_el->route_count; i++) {
+            dsr_path_print_to_debug(rc_el->paths[i]->path);
         }
     }
 
     _ROUTECACHE_UNLOCK;
 }
 
+/* The insert_position policies of the variants: the position a new path has
+ * to be inserted at to keep the variant specific order, or -1 if it is not
+ * cached at all. Called with the route cache locked. */
+
+/** add every new path, keep them sorted by weight; equal paths keep their order */
+int dsr_routecache_insert_by_weight(dsr_routecache_t* rc_el, dsr_path_t* path) {
+    size_t i;
+
+    for(i = 0; i < rc_el->route_count; i++) {
+        if(dsr_path_cmp(path, rc_el->paths[i]->path) < 0) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/** MDSR: up to DSR_ROUTECACHE_MAX_PATHS paths are used, keep them in insertion order */
+int dsr_routecache_insert_in_order(dsr_routecache_t* rc_el, dsr_path_t* path) {
+    return rc_el->route_count;
+}
+
+/** SMR, backup path variant 2: only two paths are used, keep them in insertion order */
+int dsr_routecache_insert_two_in_order(dsr_routecache_t* rc_el, dsr_path_t* path) {
+    if(rc_el->route_count <= 1) {
+        return rc_el->route_count;
+    }
+
+    dessert_err("Destination replied with more than two(2) REPLs!");
+    return -1;
+}
+
+/** backup path variant 1: only two paths are used, but the primary path arrives second */
+int dsr_routecache_insert_primary_second(dsr_routecache_t* rc_el, dsr_path_t* path) {
+    if(rc_el->route_count <= 1) {
+        return 0;
+    }
+
+    dessert_err("Destination replied with more than two(2) REPLs!");
+    return -1;
+}
+
 /******************************************************************************
  *
  * C L I --
@@ -201,37 +238,32 @@ void dsr_routecache_print_routecache_to_debug() {
  *
  ******************************************************************************/
 
+
+static inline void _link_key(uint8_t key[2 * ETHER_ADDR_LEN], const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[ETHER_ADDR_LEN]) {
+    ADDR_CPY(key, u);
+    ADDR_CPY(key + ETHER_ADDR_LEN, v);
+}
+
 static inline void _delete_all_paths_with_link(const uint8_t u[ETHER_ADDR_LEN], const uint8_t v[ETHER_ADDR_LEN]) {
+    uint8_t key[2 * ETHER_ADDR_LEN];
+    dsr_routecache_link_t* link = NULL;
     dsr_routecache_t* rc_el = NULL;
-    dsr_routecache_t* next_rc_el = NULL;
-    dsr_path_t* iter_path = NULL;
-    dsr_path_t* tbd_path = NULL;
-
-    rc_el = dsr_routecache;
 
-    while(rc_el) {
-        next_rc_el = rc_el->hh.next;
+    _link_key(key, u, v);
 
-        iter_path = rc_el->paths;
+    /* removing the last path using the link also removes the link entry */
+    HASH_FIND(hh, _links, key, sizeof(key), link);
 
-        while(iter_path) {
-            if(dsr_path_contains_link(iter_path, u, v) == DSR_PATH_LINK_FOUND) {
-                tbd_path = iter_path;
-                _remove_from_pathlist(rc_el, iter_path);
-                iter_path = iter_path->next;
-                free(tbd_path);
-            }
-            else {
-                iter_path = iter_path->next;
-            }
-        }
+    while(link) {
+        rc_el = link->refs->rc_path->dest;
+        _remove_from_pathlist(link->refs->rc_path);
 
         if(rc_el->route_count == 0) {
             _remove_entry(rc_el);
             free(rc_el);
         }
 
-        rc_el = next_rc_el;
+        HASH_FIND(hh, _links, key, sizeof(key), link);
     }
 }
 
@@ -254,7 +286,7 @@ static inline dsr_routecache_t* _add_new_entry(const uint8_t dest[ETHER_ADDR_LEN
 
     memcpy(dest_rc_el->address, dest, ETHER_ADDR_LEN);
     dest_rc_el->route_count = 0;
-    dest_rc_el->paths = NULL;
+    dest_rc_el->rr_index = 0;
 
     HASH_ADD(hh, dsr_routecache, address, ETHER_ADDR_LEN, dest_rc_el);
     dessert_debug("Added rc_el for dest[" MAC "]", EXPLODE_ARRAY6(dest));
@@ -267,15 +299,85 @@ static inline void _remove_entry(dsr_routecache_t* dest_rc_el) {
     HASH_DELETE(hh, dsr_routecache, dest_rc_el);
 }
 
+/** FNV-1a over the hops of @a path */
+static inline uint32_t _path_hash(const dsr_path_t* path) {
+    uint32_t hash = 2166136261u;
+    int i;
+
+    for(i = 0; i < path->len * ETHER_ADDR_LEN; i++) {
+        hash = (hash ^ path->address[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+/** Registers every link of the cached path in the inverted index. */
+static inline void _index_path(dsr_routecache_path_t* rc_path) {
+    dsr_path_t* path = rc_path->path;
+    dsr_routecache_link_t* link;
+    int i;
+
+    if(path->len < 2) {
+        rc_path->refs = NULL;
+        return;
+    }
+
+    rc_path->refs = malloc((path->len - 1) * sizeof(dsr_routecache_linkref_t));
+    assert(rc_path->refs != NULL);
+
+    for(i = 0; i < path->len - 1; i++) {
+        uint8_t key[2 * ETHER_ADDR_LEN];
+
+        _link_key(key, ADDR_IDX(path, i), ADDR_IDX(path, i + 1));
+        HASH_FIND(hh, _links, key, sizeof(key), link);
+
+        if(link == NULL) {
+            link = malloc(sizeof(dsr_routecache_link_t));
+            assert(link != NULL);
+            memcpy(link->key, key, sizeof(key));
+            link->refs = NULL;
+            HASH_ADD(hh, _links, key, sizeof(key), link);
+        }
+
+        rc_path->refs[i].rc_path = rc_path;
+        rc_path->refs[i].link = link;
+        DL_APPEND(link->refs, &rc_path->refs[i]);
+    }
+}
+
+static inline void _unindex_path(dsr_routecache_path_t* rc_path) {
+    int i;
+
+    for(i = 0; i < rc_path->path->len - 1; i++) {
+        dsr_routecache_link_t* link = rc_path->refs[i].link;
+
+        DL_DELETE(link->refs, &rc_path->refs[i]);
+
+        if(link->refs == NULL) {
+            HASH_DELETE(hh, _links, link);
+            free(link);
+        }
+    }
+
+    free(rc_path->refs);
+    rc_path->refs = NULL;
+}
+
 static inline void _add_to_pathlist(dsr_routecache_t* rc_el, dsr_path_t* path) {
     assert(path != NULL);
     assert(rc_el != NULL);
     assert(path->len > 0);
 
+    dsr_routecache_path_t* rc_path;
+    uint32_t hash = _path_hash(path);
+    int pos;
+    size_t i;
+
     /* only add if path isn't already in the cache */
-    dsr_path_t* check_path;
-    DL_FOREACH(rc_el->paths, check_path) {
-        if(dsr_path_cmp(path, check_path) == 0) {
+    for(i = 0; i < rc_el->route_count; i++) {
+        dsr_path_t* check_path = rc_el->paths[i]->path;
+
+        if(rc_el->paths[i]->hash == hash && dsr_path_cmp(path, check_path) == 0) {
             /* dsr_path_cmp only compares len and weight, so check if the hops match in detail */
             if(dsr_path_hops_ident(path, check_path) == 0) {
                 /* paths are identical */
@@ -285,79 +387,49 @@ static inline void _add_to_pathlist(dsr_routecache_t* rc_el, dsr_path_t* path) {
         }
     }
 
-#if (PROTOCOL == MDSR_PROTOKOLL_1)
-    /* up to DSR_CONFVAR_ROUTECACHE_KEEP_PATHS paths are used, keep them in insertion order */
-    DL_APPEND(rc_el->paths, path);
-    rc_el->route_count++;
-#elif  (PROTOCOL == SMR)
+    pos = DSR_VARIANT_CALL(insert_position)(rc_el, path);
 
-    /* only two paths are used, keep them in insertion order */
-    if(rc_el->route_count <= 1) {
-        DL_APPEND(rc_el->paths, path);
-        rc_el->route_count++;
-    }
-    else {
-        dessert_err("Destination replied with more than two(2) REPLs!");
+    /* a path that would be dropped right away is not cached at all */
+    if(pos < 0 || pos >= DSR_ROUTECACHE_MAX_PATHS) {
         free(path);
+        return;
     }
 
-#elif (PROTOCOL == BACKUPPATH_VARIANT_1)
-
-    /* only two paths are used, but the primary path arrives second */
-    if(rc_el->route_count == 0) {
-        DL_APPEND(rc_el->paths, path);
-        rc_el->route_count++;
-    }
-    else if(rc_el->route_count == 1) {
-        DL_PREPEND(rc_el->paths , path);
-        rc_el->route_count++;
-    }
-    else {
-        dessert_err("Destination replied with more than two(2) REPLs!");
-        free(path);
-    }
+    rc_path = malloc(sizeof(dsr_routecache_path_t));
+    assert(rc_path != NULL);
+    rc_path->path = path;
+    rc_path->hash = hash;
+    rc_path->dest = rc_el;
+    _index_path(rc_path);
 
-#elif (PROTOCOL == BACKUPPATH_VARIANT_2)
+    memmove(&rc_el->paths[pos + 1], &rc_el->paths[pos], (rc_el->route_count - pos) * sizeof(dsr_routecache_path_t*));
+    rc_el->paths[pos] = rc_path;
+    rc_el->route_count++;
+    rc_el->rr_index = 0;
 
-    /* only two paths are used, keep them in insertion order */
-    if(rc_el->route_count <= 1) {
-        DL_APPEND(rc_el->paths, path);
-        rc_el->route_count++;
+    /* keep only the first DSR_ROUTECACHE_MAX_PATHS paths to dest */
+    if(rc_el->route_count > DSR_ROUTECACHE_MAX_PATHS) {
+        dessert_debug("Deleting %i needless backup paths...", rc_el->route_count - DSR_ROUTECACHE_MAX_PATHS);
+        _remove_from_pathlist(rc_el->paths[rc_el->route_count - 1]);
     }
-    else {
-        dessert_err("Destination replied with more than two(2) REPLs!");
-        free(path);
-    }
-
-#else
-    /* add every new path, keep them sorted by weight */
-    DL_APPEND(rc_el->paths, path);
-    rc_el->route_count++;
-    DL_SORT(rc_el->paths, dsr_path_cmp);
-#endif
+}
 
-#if (DSR_CONFVAR_ROUTECACHE_KEEP_PATHS > 0)
-    /* keep only the first DSR_CONFVAR_ROUTECACHE_KEEP_PATHS paths to dest */
-    dsr_path_t* tbd;
+/** Removes @a rc_path from its destination and from the link index and frees it. */
+static inline void _remove_from_pathlist(dsr_routecache_path_t* rc_path) {
+    assert(rc_path != NULL);
 
-    if(rc_el->route_count > DSR_CONFVAR_ROUTECACHE_KEEP_PATHS) {
-        dessert_debug("Deleting %i needless backup paths...", rc_el->route_count - DSR_CONFVAR_ROUTECACHE_KEEP_PATHS);
+    dsr_routecache_t* rc_el = rc_path->dest;
+    size_t i;
 
-        while(rc_el->route_count > DSR_CONFVAR_ROUTECACHE_KEEP_PATHS) {
-            tbd = (rc_el->paths)->prev;
-            DL_DELETE(rc_el->paths, tbd);
-            rc_el->route_count--;
-            free(tbd);
-        }
+    for(i = 0; rc_el->paths[i] != rc_path; i++) {
+        assert(i < rc_el->route_count);
     }
 
-#endif
-}
-
-static inline void _remove_from_pathlist(dsr_routecache_t* rc_el, dsr_path_t* path) {
-    assert(path != NULL);
-    assert(rc_el != NULL);
-
-    DL_DELETE(rc_el->paths, path);
+    memmove(&rc_el->paths[i], &rc_el->paths[i + 1], (rc_el->route_count - i - 1) * sizeof(dsr_routecache_path_t*));
     rc_el->route_count--;
+    rc_el->rr_index = 0;
+
+    _unindex_path(rc_path);
+    free(rc_path->path);
+    free(rc_path);
 }
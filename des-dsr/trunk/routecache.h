@@ -35,18 +35,55 @@
 #define DSR_ROUTECACHE_ERROR_NO_PATH_TO_DESTINATION       -2
 #define DSR_ROUTECACHE_ERROR_LINKCACHE_NOT_INITIALIZED    -3
 
-typedef struct __attribute__((__packed__)) dsr_routecache {
+/* paths kept per destination; the variants without a limit use at most two.
+ * DSR_ROUTECACHE_PATHS_SIZE bounds it for every variant of the build. */
+#if (DSR_VARIANT_RUNTIME == 1)
+#define DSR_ROUTECACHE_MAX_PATHS (dsr_variant->keep_paths)
+#define DSR_ROUTECACHE_PATHS_SIZE 2
+#elif (DSR_CONFVAR_ROUTECACHE_KEEP_PATHS > 0)
+#define DSR_ROUTECACHE_MAX_PATHS DSR_CONFVAR_ROUTECACHE_KEEP_PATHS
+#define DSR_ROUTECACHE_PATHS_SIZE DSR_ROUTECACHE_MAX_PATHS
+#else
+#define DSR_ROUTECACHE_MAX_PATHS 2
+#define DSR_ROUTECACHE_PATHS_SIZE DSR_ROUTECACHE_MAX_PATHS
+#endif
+
+typedef struct dsr_routecache_path {
+    dsr_path_t* path;
+    uint32_t hash;                            /* over the hops, for duplicate detection */
+    struct dsr_routecache* dest;
+    struct dsr_routecache_linkref* refs;      /* one per link of the path */
+} dsr_routecache_path_t;
+
+typedef struct dsr_routecache {
 
     uint8_t address[ETHER_ADDR_LEN];
 
     size_t route_count;
 
-    dsr_path_t* paths;
+    size_t rr_index;                          /* next path for round-robin */
+
+    /* sorted by weight (or in variant specific order), one spare slot for inserting */
+    dsr_routecache_path_t* paths[DSR_ROUTECACHE_PATHS_SIZE + 1];
 
     UT_hash_handle hh;
 
 } dsr_routecache_t;
 
+/** inverted index: every cached path using the link u->v */
+typedef struct dsr_routecache_link {
+    uint8_t key[2 * ETHER_ADDR_LEN];          /* u, v */
+    struct dsr_routecache_linkref* refs;
+    UT_hash_handle hh;
+} dsr_routecache_link_t;
+
+typedef struct dsr_routecache_linkref {
+    dsr_routecache_path_t* rc_path;
+    dsr_routecache_link_t* link;
+    struct dsr_routecache_linkref* prev;
+    struct dsr_routecache_linkref* next;
+} dsr_routecache_linkref_t;
+
 extern dsr_routecache_t* dsr_routecache;
 
 int dsr_routecache_get_first(const uint8_t dest[ETHER_ADDR_LEN], dsr_path_t* path);
@@ -55,4 +92,10 @@ void dsr_routecache_process_link_error(const uint8_t u[ETHER_ADDR_LEN], const ui
 void dsr_routecache_add_path(const uint8_t dest[ETHER_ADDR_LEN], dsr_path_t* path);
 void dsr_routecache_print_routecache_to_debug();
 
+/* route cache policies of the variants, see dsr_variant_t */
+int dsr_routecache_insert_by_weight(dsr_routecache_t* rc_el, dsr_path_t* path);
+int dsr_routecache_insert_in_order(dsr_routecache_t* rc_el, dsr_path_t* path);
+int dsr_routecache_insert_two_in_order(dsr_routecache_t* rc_el, dsr_path_t* path);
+int dsr_routecache_insert_primary_second(dsr_routecache_t* rc_el, dsr_path_t* path);
+
 #endif /* ROUTECACHE_H_ */
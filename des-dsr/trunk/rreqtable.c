@@ -27,64 +27,110 @@
 
 #include "dsr.h"
 
-/* RREQTABLE */
-dsr_rreqtable_t* _dsr_rreqtable = NULL; // this is a MUST for uthash
-
-pthread_rwlock_t _dsr_rreqtable_rwlock = PTHREAD_RWLOCK_INITIALIZER;
-#define _RREQTABLE_READLOCK pthread_rwlock_rdlock(&_dsr_rreqtable_rwlock)
-#define _RREQTABLE_WRITELOCK pthread_rwlock_wrlock(&_dsr_rreqtable_rwlock)
-#define _RREQTABLE_UNLOCK pthread_rwlock_unlock(&_dsr_rreqtable_rwlock)
-
-#define _SAFE_RETURN(x) do {_RREQTABLE_UNLOCK; return(x);} while(0)
+/*
+ * The entries are spread over DSR_CONFVAR_RREQTABLE_STRIPES hash tables by
+ * their address, each behind its own lock, so RREQs from different
+ * sources don't contend.
+ *
+ * Route discovery retries and the end of the SMR/backup path reply
+ * windows are kept as timers in one deadline heap. run_rreqtable only
+ * pops the due timers instead of visiting every entry and rreqcache.
+ * Timers are not removed when an entry is reset, rescheduled or
+ * destroyed; a popped timer is ignored if its entry no longer has the
+ * same deadline.
+ */
+
+typedef struct dsr_rreqtable_stripe {
+    pthread_rwlock_t lock;
+    dsr_rreqtable_t* table; // NULL is a MUST for uthash
+} dsr_rreqtable_stripe_t;
+
+static dsr_rreqtable_stripe_t _stripes[DSR_CONFVAR_RREQTABLE_STRIPES] = {
+    [0 ... DSR_CONFVAR_RREQTABLE_STRIPES - 1] = { PTHREAD_RWLOCK_INITIALIZER, NULL }
+};
+
+#define _RREQTABLE_READLOCK(stripe) pthread_rwlock_rdlock(&(stripe)->lock)
+#define _RREQTABLE_WRITELOCK(stripe) pthread_rwlock_wrlock(&(stripe)->lock)
+#define _RREQTABLE_UNLOCK(stripe) pthread_rwlock_unlock(&(stripe)->lock)
+
+#define _SAFE_RETURN(stripe, x) do {_RREQTABLE_UNLOCK(stripe); return(x);} while(0)
+
+#define _TIMER_DISCOVERY 0 /* next RREQ of a route discovery is due */
+#define _TIMER_REPLY     1 /* reply window of a rreqcache entry closes */
+
+typedef struct dsr_rreqtable_timer {
+    struct timeval deadline;
+    int type;
+    uint8_t address[ETHER_ADDR_LEN];   /* the rreqtable entry */
+    dsr_rreqcache_lookup_key_t key;    /* the rreqcache entry of a _TIMER_REPLY */
+} dsr_rreqtable_timer_t;
+
+static pthread_mutex_t _timers_mutex = PTHREAD_MUTEX_INITIALIZER;
+static dsr_rreqtable_timer_t* _timers = NULL; /* binary min heap on deadline */
+static size_t _timers_len = 0;
+static size_t _timers_size = 0;
 
 /* local forward declarations */
-static inline dsr_rreqtable_t* _add_new_entry(const uint8_t address[ETHER_ADDR_LEN]);
-static inline void _remove_entry(dsr_rreqtable_t* node);
+static inline dsr_rreqtable_stripe_t* _get_stripe(const uint8_t address[ETHER_ADDR_LEN]);
+static inline dsr_rreqtable_t* _add_new_entry(dsr_rreqtable_stripe_t* stripe, const uint8_t address[ETHER_ADDR_LEN]);
+static inline void _remove_entry(dsr_rreqtable_stripe_t* stripe, dsr_rreqtable_t* node);
 static inline void _reset_entry(dsr_rreqtable_t* node);
-static inline dsr_rreqtable_t* _get_entry_for_key(const uint8_t address[ETHER_ADDR_LEN]);
+static inline dsr_rreqtable_t* _get_entry_for_key(dsr_rreqtable_stripe_t* stripe, const uint8_t address[ETHER_ADDR_LEN]);
 static inline void _mark_entry_used(dsr_rreqtable_t* node);
 
 static inline int _is_routediscovery_ok_now(struct timeval* now, dsr_rreqtable_t* node);
 
+static inline void _heap_up(size_t pos);
+static inline void _heap_down(size_t pos);
+static inline void _schedule_timer(int type, const uint8_t address[ETHER_ADDR_LEN], const dsr_rreqcache_lookup_key_t* key, const struct timeval* deadline);
+static inline void _run_timer(struct timeval* now, dsr_rreqtable_timer_t* timer);
+
 static inline dsr_rreqcache_t* _add_rreqcache_entry(dsr_rreqtable_t* node, const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN]);
 static inline dsr_rreqcache_t* _get_rreqcache_entry_for_key(dsr_rreqtable_t* node, const dsr_rreqcache_lookup_key_t* lookup_key);
-static inline dsr_rreqcache_t* _get_rreqcache_entry(const uint8_t address[ETHER_ADDR_LEN], const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN]);
+static inline dsr_rreqcache_t* _get_rreqcache_entry(dsr_rreqtable_stripe_t* stripe, const uint8_t address[ETHER_ADDR_LEN], const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN]);
 static inline dsr_rreqcache_t* _get_rreqcache_entry_for_node(dsr_rreqtable_t* node, const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN]);
 static inline void _destroy_rreqcache_entry(dsr_rreqtable_t* node, dsr_rreqcache_t* cacheentry);
 
-#if (PROTOCOL == SMR || PROTOCOL == BACKUPPATH_VARIANT_1 || PROTOCOL == BACKUPPATH_VARIANT_2)
+static inline dsr_smr_rreqcache_t* _get_smr(dsr_rreqcache_t* cacheentry);
 static inline dsr_smr_rreqcache_candidate_t* _new_dsr_smr_rreqcache_candidate(const dessert_meshif_t* iface, dsr_rreq_ext_t* rreq);
 static inline void _destroy_dsr_smr_rreq_candidate(dsr_smr_rreqcache_candidate_t* candidate);
-static inline int _get_nodes_in_common(dsr_smr_rreqcache_candidate_t* sd, dsr_smr_rreqcache_candidate_t* c);
-static inline int _get_links_in_common(dsr_smr_rreqcache_candidate_t* sd, dsr_smr_rreqcache_candidate_t* c);
-#endif
+static inline int _add_candidate_to_pathset(dsr_pathset_t* set, dsr_smr_rreqcache_candidate_t* candidate);
+static inline dsr_smr_rreqcache_candidate_t* _choose_max_disjoint(dsr_smr_rreqcache_t* smr);
+static inline dsr_smr_rreqcache_candidate_t* _choose_min_weight(dsr_smr_rreqcache_t* smr);
+static inline void _choose_and_reply(dsr_smr_rreqcache_t* smr);
 
 inline int dsr_rreqtable_is_routediscovery_ok_now(const uint8_t dest[ETHER_ADDR_LEN]) {
+    dsr_rreqtable_stripe_t* stripe = _get_stripe(dest);
     dsr_rreqtable_t* node = NULL;
     struct timeval now;
     int res = 0;
 
-    _RREQTABLE_WRITELOCK;
-    node = _get_entry_for_key(dest);
+    _RREQTABLE_WRITELOCK(stripe);
+    node = _get_entry_for_key(stripe, dest);
 
     if(node == NULL) {
-        node = _add_new_entry(dest);
+        node = _add_new_entry(stripe, dest);
     }
 
     gettimeofday(&now, NULL);
     res = _is_routediscovery_ok_now(&now, node);
-    _RREQTABLE_UNLOCK;
+    _RREQTABLE_UNLOCK(stripe);
 
     return res;
 }
 
 inline void dsr_rreqtable_got_repl(const uint8_t dest[ETHER_ADDR_LEN]) {
+    dsr_rreqtable_stripe_t* stripe = _get_stripe(dest);
     dsr_rreqtable_t* node = NULL;
 
-    _RREQTABLE_WRITELOCK;
-    node = _get_entry_for_key(dest);
-    _reset_entry(node);
-    _RREQTABLE_UNLOCK;
+    _RREQTABLE_WRITELOCK(stripe);
+    node = _get_entry_for_key(stripe, dest);
+
+    if(node != NULL) {
+        _reset_entry(node);
+    }
+
+    _RREQTABLE_UNLOCK(stripe);
 }
 
 /** Add an entry to a rreqcache in the Route Request Table.
@@ -94,19 +140,20 @@ inline void dsr_rreqtable_got_repl(const uint8_t dest[ETHER_ADDR_LEN]) {
  * @return DSR_RREQTABLE_SUCCESS
  * @return DSR_RREQTABLE_ERROR_MEMORY_ALLOCATION */
 inline int dsr_add_node_to_rreqtable_cache(const uint8_t address[ETHER_ADDR_LEN], const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN]) {
+    dsr_rreqtable_stripe_t* stripe = _get_stripe(address);
     dsr_rreqtable_t* node;
 
-    _RREQTABLE_WRITELOCK;
+    _RREQTABLE_WRITELOCK(stripe);
 
-    node = _get_entry_for_key(address);
+    node = _get_entry_for_key(stripe, address);
 
     if(node == NULL) {
-        node = _add_new_entry(address);
+        node = _add_new_entry(stripe, address);
     }
 
     _add_rreqcache_entry(node, identification, target_address);
 
-    _RREQTABLE_UNLOCK;
+    _RREQTABLE_UNLOCK(stripe);
     return DSR_RREQTABLE_SUCCESS;
 }
 
@@ -118,26 +165,27 @@ inline int dsr_add_node_to_rreqtable_cache(const uint8_t address[ETHER_ADDR_LEN]
  * @return DSR_RREQTABLE_RREQCACHE_ENTRY_PRESENT
  * @return DSR_RREQTABLE_ERROR_MEMORY_ALLOCATION */
 inline int dsr_is_rreqcache_entry_present(const uint8_t address[ETHER_ADDR_LEN], const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN]) {
+    dsr_rreqtable_stripe_t* stripe = _get_stripe(address);
     dsr_rreqcache_t* cacheentry;
 
-    _RREQTABLE_WRITELOCK;
-    cacheentry = _get_rreqcache_entry(address, identification, target_address);
-    _RREQTABLE_UNLOCK;
+    _RREQTABLE_WRITELOCK(stripe);
+    cacheentry = _get_rreqcache_entry(stripe, address, identification, target_address);
+    _RREQTABLE_UNLOCK(stripe);
 
     return (cacheentry == NULL ? DSR_RREQTABLE_FORWARD_RREQ : DSR_RREQTABLE_DONT_FORWARD_RREQ);
 }
 
-#if (METRIC == ETX)
 inline int dsr_is_rreqcache_entry_present_and_worse_than(const uint8_t address[ETHER_ADDR_LEN], const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN], uint32_t weight) {
+    dsr_rreqtable_stripe_t* stripe = _get_stripe(address);
     dsr_rreqtable_t* node;
     dsr_rreqcache_t* cacheentry;
 
-    _RREQTABLE_WRITELOCK;
+    _RREQTABLE_WRITELOCK(stripe);
 
-    node = _get_entry_for_key(address);
+    node = _get_entry_for_key(stripe, address);
 
     if(node == NULL) {
-        node = _add_new_entry(address);
+        node = _add_new_entry(stripe, address);
     }
 
     assert(node != NULL);
@@ -154,30 +202,29 @@ inline int dsr_is_rreqcache_entry_present_and_worse_than(const uint8_t address[E
     /* test if weight is not worse than best so far */
     if(weight >= cacheentry->best_weight) {
         dessert_debug("rreqcache_entry->weight old[%u] new[%u]", cacheentry->best_weight, weight);
-        _SAFE_RETURN(DSR_RREQTABLE_DONT_FORWARD_RREQ);
+        _SAFE_RETURN(stripe, DSR_RREQTABLE_DONT_FORWARD_RREQ);
     }
 
 forward_rreq:
     /* update best weight forwarded so far */
     cacheentry->best_weight = weight;
 
-    _RREQTABLE_UNLOCK;
+    _RREQTABLE_UNLOCK(stripe);
 
     return DSR_RREQTABLE_FORWARD_RREQ;
 }
-#endif
 
-#if (PROTOCOL == MDSR_PROTOKOLL_1)
 inline int dsr_mdsr_is_repl_ok(const uint8_t address[ETHER_ADDR_LEN], const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN], dsr_path_t* path) {
+    dsr_rreqtable_stripe_t* stripe = _get_stripe(address);
     dsr_rreqtable_t* node;
     dsr_rreqcache_t* cacheentry;
 
-    _RREQTABLE_WRITELOCK;
+    _RREQTABLE_WRITELOCK(stripe);
 
-    node = _get_entry_for_key(address);
+    node = _get_entry_for_key(stripe, address);
 
     if(node == NULL) {
-        node = _add_new_entry(address);
+        node = _add_new_entry(stripe, address);
     }
 
     assert(node != NULL);
@@ -190,53 +237,46 @@ inline int dsr_mdsr_is_repl_ok(const uint8_t address[ETHER_ADDR_LEN], const uint
 
     assert(cacheentry != NULL);
 
-    if(cacheentry->path_list == NULL) {
-        DL_APPEND(cacheentry->path_list, path);
-        _SAFE_RETURN(DSR_MDSR_REPLY_OK);
+    int i, new;
+    int common_link_found = 0;
+
+    if(cacheentry->paths == NULL) {
+        cacheentry->paths = malloc(sizeof(dsr_pathset_t));
+        assert(cacheentry->paths != NULL);
+        dsr_pathset_init(cacheentry->paths, DSR_PATHSET_SKIP_FIRST_LINK);
     }
 
-    dsr_path_t* p;
-    int common_link_found = 0;
-    DL_FOREACH(cacheentry->path_list, p) {
-        if(dsr_path_is_linkdisjoint(path, p) == DSR_PATH_LINK_FOUND) {
+    new = dsr_pathset_add_path(cacheentry->paths, path, NULL);
+
+    for(i = 0; i < new; i++) {
+        if(dsr_pathset_links_in_common(cacheentry->paths, new, i) > 0) {
             common_link_found = 1;
             dessert_debug("RREQTABLE: common link found...");
             dsr_path_print_to_debug(path);
-            dsr_path_print_to_debug(p);
             break;
         }
-        else {
-            dessert_debug("RREQTABLE: NO common link found...");
-            dsr_path_print_to_debug(path);
-            dsr_path_print_to_debug(p);
-        }
     }
 
-    if(common_link_found == 0) {
-        DL_APPEND(cacheentry->path_list, path);
-    }
-    else {
-        free(path);
+    if(common_link_found == 1) {
+        dsr_pathset_remove_last(cacheentry->paths);
     }
 
-    _RREQTABLE_UNLOCK;
+    _RREQTABLE_UNLOCK(stripe);
 
     return (common_link_found == 1 ? DSR_MDSR_REPLY_NOT_OK : DSR_MDSR_REPLY_OK);
 }
-#endif
-
-#if (PROTOCOL == SMR || PROTOCOL == BACKUPPATH_VARIANT_1 || PROTOCOL == BACKUPPATH_VARIANT_2)
 
 inline int dsr_smr_is_repl_ok(const uint8_t address[ETHER_ADDR_LEN], const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN], const dessert_meshif_t* iface, dsr_rreq_ext_t* rreq) {
+    dsr_rreqtable_stripe_t* stripe = _get_stripe(address);
     dsr_rreqtable_t* node;
     dsr_rreqcache_t* cacheentry;
 
-    _RREQTABLE_WRITELOCK;
+    _RREQTABLE_WRITELOCK(stripe);
 
-    node = _get_entry_for_key(address);
+    node = _get_entry_for_key(stripe, address);
 
     if(node == NULL) {
-        node = _add_new_entry(address);
+        node = _add_new_entry(stripe, address);
     }
 
     assert(node != NULL);
@@ -249,72 +289,89 @@ inline int dsr_smr_is_repl_ok(const uint8_t address[ETHER_ADDR_LEN], const uint1
 
     assert(cacheentry != NULL);
 
+    dsr_smr_rreqcache_t* smr = _get_smr(cacheentry);
     dsr_smr_rreqcache_candidate_t* candidate;
     candidate = _new_dsr_smr_rreqcache_candidate(iface, rreq);
 
-    if(cacheentry->shortest_delay == NULL) {
-        cacheentry->shortest_delay = candidate;
-        gettimeofday(&cacheentry->timeout, NULL);
-        TIMEVAL_ADD_SAFE(&cacheentry->timeout, 0, DSR_CONFVAR_SMR_RREQCACHE_REPLY_TIMEOUT_MSECS);
-        _SAFE_RETURN(DSR_SMR_REPLY_OK);
+    if(smr->shortest_delay == NULL) {
+        smr->shortest_delay = candidate;
+        gettimeofday(&smr->timeout, NULL);
+        TIMEVAL_ADD_SAFE(&smr->timeout, 0, DSR_CONFVAR_SMR_RREQCACHE_REPLY_TIMEOUT_MSECS);
+        _schedule_timer(_TIMER_REPLY, address, (dsr_rreqcache_lookup_key_t*) cacheentry, &smr->timeout);
+        _SAFE_RETURN(stripe, DSR_SMR_REPLY_OK);
     }
 
-    DL_APPEND(cacheentry->candidates, candidate);
+    DL_APPEND(smr->candidates, candidate);
 
-    _RREQTABLE_UNLOCK;
+    _RREQTABLE_UNLOCK(stripe);
 
     return DSR_SMR_REPLY_NOT_OK;
 }
 
 inline int dsr_smr_is_rreq_forward_ok(const uint8_t address[ETHER_ADDR_LEN], const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN], uint32_t weight, uint8_t neighbor[ETHER_ADDR_LEN]) {
+    dsr_rreqtable_stripe_t* stripe = _get_stripe(address);
     dsr_rreqtable_t* node;
     dsr_rreqcache_t* cacheentry;
 
-    _RREQTABLE_WRITELOCK;
+    _RREQTABLE_WRITELOCK(stripe);
 
-    node = _get_entry_for_key(address);
+    node = _get_entry_for_key(stripe, address);
 
     if(node == NULL) {
-        node = _add_new_entry(address);
+        node = _add_new_entry(stripe, address);
     }
 
     assert(node != NULL);
 
     cacheentry = _get_rreqcache_entry_for_node(node, identification, target_address);
 
+    dsr_smr_rreqcache_t* smr;
+
     if(cacheentry == NULL) {
         cacheentry = _add_rreqcache_entry(node, identification, target_address);
+        smr = _get_smr(cacheentry);
         goto forward_rreq;
     }
 
     assert(cacheentry != NULL);
+    smr = _get_smr(cacheentry);
 
     /* test if neighbor is in list */
     int i;
 
-    for(i = 0; i < cacheentry->neighbor_list_len; i++) {
-        if(ADDR_CMP(ADDR_IDX(cacheentry, i), neighbor) == 0) {
-            _SAFE_RETURN(DSR_RREQTABLE_DONT_FORWARD_RREQ);
+    for(i = 0; i < smr->neighbor_list_len; i++) {
+        if(ADDR_CMP(ADDR_IDX(smr, i), neighbor) == 0) {
+            _SAFE_RETURN(stripe, DSR_RREQTABLE_DONT_FORWARD_RREQ);
         }
     }
 
     /* test if weight is not worse than best so far */
-    if(weight > cacheentry->weight) {
-        _SAFE_RETURN(DSR_RREQTABLE_DONT_FORWARD_RREQ);
+    if(weight > smr->weight) {
+        _SAFE_RETURN(stripe, DSR_RREQTABLE_DONT_FORWARD_RREQ);
     }
 
 
 forward_rreq:
     /* add neighbor and update best weight forwarded so far */
-    ADDR_CPY(ADDR_IDX(cacheentry, cacheentry->neighbor_list_len), neighbor);
-    cacheentry->neighbor_list_len++;
-    cacheentry->weight = weight;
+    ADDR_CPY(ADDR_IDX(smr, smr->neighbor_list_len), neighbor);
+    smr->neighbor_list_len++;
+    smr->weight = weight;
 
-    _RREQTABLE_UNLOCK;
+    _RREQTABLE_UNLOCK(stripe);
 
     return DSR_RREQTABLE_FORWARD_RREQ;
 }
 
+/** The SMR state of @a cacheentry, allocated on first use. */
+static inline dsr_smr_rreqcache_t* _get_smr(dsr_rreqcache_t* cacheentry) {
+    if(cacheentry->smr == NULL) {
+        cacheentry->smr = calloc(1, sizeof(dsr_smr_rreqcache_t));
+        assert(cacheentry->smr != NULL);
+    }
+
+    return cacheentry->smr;
+}
+
 static inline dsr_smr_rreqcache_candidate_t* _new_dsr_smr_rreqcache_candidate(const dessert_meshif_t* iface, dsr_rreq_ext_t* rreq) {
     assert(iface != NULL);
     assert(rreq != NULL);
@@ -343,77 +400,199 @@ static inline void _destroy_dsr_smr_rreq_candidate(dsr_smr_rreqcache_candidate_t
     free(candidate);
 }
 
-static inline int _get_nodes_in_common(dsr_smr_rreqcache_candidate_t* sd, dsr_smr_rreqcache_candidate_t* c) {
-    assert(sd != NULL);
-    assert(c != NULL);
-    assert(sd->rreq != NULL);
-    assert(c->rreq != NULL);
+static inline int _add_candidate_to_pathset(dsr_pathset_t* set, dsr_smr_rreqcache_candidate_t* candidate) {
+    assert(candidate != NULL);
+    assert(candidate->rreq != NULL);
+
+    return dsr_pathset_add(set, candidate->rreq->data[0].address, sizeof(dsr_hop_data_t),
+                           DSR_RREQ_GET_HOPCOUNT(candidate->rreq),
+                           dsr_rreq_get_weight_incl_hop_to_self(candidate->iface, candidate->rreq),
+                           candidate);
+}
+
+/** The candidate path that is maximally disjoint to the shortest delay path (SMR, backup path 2). */
+static inline dsr_smr_rreqcache_candidate_t* _choose_max_disjoint(dsr_smr_rreqcache_t* smr) {
+    dsr_smr_rreqcache_candidate_t* the_chosen_one = NULL;
+    dsr_smr_rreqcache_candidate_t* candidate = NULL;
+    dsr_pathset_t set;
+    int selected[2];
+    int paths = 1;
+    int hops;
 
-    dsr_rreq_ext_t* s; /* the shorter rreq w.r.t. hopcount */
-    dsr_rreq_ext_t* l; /* the longer rreq w.r.t. hopcount */
-    int nodes_in_common = 0;
+    assert(smr->shortest_delay != NULL);
+    hops = DSR_RREQ_GET_HOPCOUNT(smr->shortest_delay->rreq);
 
-    if(DSR_RREQ_GET_HOPCOUNT(sd->rreq) <= DSR_RREQ_GET_HOPCOUNT(c->rreq)) {
-        s = sd->rreq;
-        l = c->rreq;
+    DL_FOREACH(smr->candidates, candidate) {
+        paths++;
+        hops += DSR_RREQ_GET_HOPCOUNT(candidate->rreq);
     }
-    else {
-        s = c->rreq;
-        l = sd->rreq;
+
+    dsr_pathset_init(&set, 0);
+    dsr_pathset_reserve(&set, paths, hops);
+    selected[0] = _add_candidate_to_pathset(&set, smr->shortest_delay);
+
+    DL_FOREACH(smr->candidates, candidate) {
+        _add_candidate_to_pathset(&set, candidate);
     }
 
-    int i;
+    if(dsr_pathset_select_disjoint(&set, selected, 1, 2) == 2) {
+        the_chosen_one = dsr_pathset_get_data(&set, selected[1]);
+    }
 
-    for(i = 0; i < DSR_RREQ_GET_HOPCOUNT(s); i++) {
-        int j;
+    dsr_pathset_destroy(&set);
 
-        for(j = 0; j < DSR_RREQ_GET_HOPCOUNT(l); j++) {
-            if(ADDR_CMP(s->data[i].address, l->data[j].address) == 0) {
-                nodes_in_common++;
-            }
+    return the_chosen_one;
+}
+
+/** The candidate path that has minimal weight (backup path 1). */
+static inline dsr_smr_rreqcache_candidate_t* _choose_min_weight(dsr_smr_rreqcache_t* smr) {
+    dsr_smr_rreqcache_candidate_t* the_chosen_one = NULL;
+    dsr_smr_rreqcache_candidate_t* candidate = NULL;
+    uint32_t weight = 0;
+    int hopcount = 0;
+    uint32_t cand_weight = 0;
+    int cand_hopcount = 0;
+
+    weight = dsr_rreq_get_weight_incl_hop_to_self((smr->candidates)->iface, (smr->candidates)->rreq);
+    hopcount = DSR_RREQ_GET_HOPCOUNT((smr->candidates)->rreq);
+    the_chosen_one = smr->candidates;
+
+    DL_FOREACH((smr->candidates)->next, candidate) {
+        cand_weight = dsr_rreq_get_weight_incl_hop_to_self(candidate->iface, candidate->rreq);
+        cand_hopcount = DSR_RREQ_GET_HOPCOUNT(candidate->rreq);
+
+        if(cand_weight < weight) {
+            goto new_chosen_one;
+        }
+        else if(cand_weight == weight) {
+            goto test_hopcount;
+        }
+        else {
+            continue;
+        }
+
+    test_hopcount:
+
+        if(cand_hopcount < hopcount) {
+            goto new_chosen_one;
+        }
+        else {
+            continue;
         }
+
+    new_chosen_one:
+        weight = cand_weight;
+        hopcount = cand_hopcount;
+        the_chosen_one = candidate;
     }
 
-    return nodes_in_common;
+    return the_chosen_one;
 }
 
-static inline int _get_links_in_common(dsr_smr_rreqcache_candidate_t* sd, dsr_smr_rreqcache_candidate_t* c) {
-    assert(sd != NULL);
-    assert(c != NULL);
-    assert(sd->rreq != NULL);
-    assert(c->rreq != NULL);
-
-    dsr_rreq_ext_t* s; /* the shorter rreq w.r.t. hopcount */
-    dsr_rreq_ext_t* l; /* the longer rreq w.r.t. hopcount */
-    int links_in_common = 0;
+/** Replies the candidate path chosen for @a smr once its reply window is closed. */
+static inline void _choose_and_reply(dsr_smr_rreqcache_t* smr) {
+    dsr_smr_rreqcache_candidate_t* the_chosen_one = NULL;
 
-    if(DSR_RREQ_GET_HOPCOUNT(sd->rreq) <= DSR_RREQ_GET_HOPCOUNT(c->rreq)) {
-        s = sd->rreq;
-        l = c->rreq;
+    if(smr->candidates != NULL) {
+        if(PROTOCOL == BACKUPPATH_VARIANT_1) {
+            the_chosen_one = _choose_min_weight(smr);
+        }
+        else {
+            the_chosen_one = _choose_max_disjoint(smr);
+        }
     }
     else {
-        s = c->rreq;
-        l = sd->rreq;
+        /* NOOP: no candidate paths to choose from */
+        dessert_debug("RREQTABLE: there are no candidate paths we could choose from!");
     }
 
-    int i;
+    if(the_chosen_one != NULL) {
+        dsr_send_repl(the_chosen_one->iface, the_chosen_one->rreq);
+        dessert_debug("RREQTABLE: replying the maximal-disjoint path to source[" MAC "] for id[%i].", EXPLODE_ARRAY6(the_chosen_one->rreq->data[0].address), ntohs(the_chosen_one->rreq->identification));
+    }
 
-    for(i = 1; i < DSR_RREQ_GET_HOPCOUNT(s); i++) {
-        int j;
+    smr->complete = 1;
+}
 
-        for(j = 1; j < DSR_RREQ_GET_HOPCOUNT(l); j++) {
-            if(ADDR_CMP(s->data[i-1].address, l->data[i-1].address) == 0
-               &&
-               ADDR_CMP(s->data[i].address, l->data[i].address) == 0) {
-                links_in_common++;
-            }
-        }
+/* RREQ forwarding rules and reply selection of the variants */
+
+/** DSR, MDSR: forward the first copy of every RREQ only. */
+int dsr_rreqtable_forward_rreq_once(dessert_meshif_t* iface, dessert_msg_t* msg, dsr_rreq_ext_t* rreq) {
+    int res;
+
+    /* DONE: Route Request Table (RREQ handling, search entry) rfc4728 p67
+     Else, the node MUST search its Route Request Table for an entry
+     for the initiator of this Route Request (the IP Source Address
+     field). */
+
+    /*If such an entry is found in the table, the node MUST
+     search the cache of Identification values of recently received
+     Route Requests in that table entry, to determine if an entry is
+     present in the cache matching the Identification value and target
+     node address in this Route Request.*/
+    res = dsr_is_rreqcache_entry_present(rreq->data[0].address,
+                                         ntohs(rreq->identification), rreq->target_address);
+
+    if(res == DSR_RREQTABLE_DONT_FORWARD_RREQ) {
+        /*If such an (Identification, target address) entry is found in this cache
+         * in this entry in the Route Request Table, then the node MUST discard
+         * the entire packet carrying the Route Request option. */
+        return DSR_RREQTABLE_DONT_FORWARD_RREQ;
     }
 
-    return links_in_common;
+    /* Else, this node SHOULD further process the Route Request according
+     to the following sequence of steps:
+
+     o  DONE: Route Request Table (RREQ handling, add entry) rfc4728 p68
+     Add an entry for this Route Request in its cache of
+     (Identification, target address) values of recently received
+     Route Requests. */
+    res = dsr_add_node_to_rreqtable_cache( rreq->data[0].address, ntohs(rreq->identification), rreq->target_address);
+    assert(res == DSR_RREQTABLE_SUCCESS);
+
+    return DSR_RREQTABLE_FORWARD_RREQ;
 }
 
-#endif
+/** ETXDSR: forward every copy of a RREQ that is better than all forwarded before. */
+int dsr_rreqtable_forward_rreq_if_better(dessert_meshif_t* iface, dessert_msg_t* msg, dsr_rreq_ext_t* rreq) {
+    uint32_t weight = dsr_rreq_get_weight_incl_hop_to_self(iface, rreq);
+
+    return dsr_is_rreqcache_entry_present_and_worse_than(rreq->data[0].address,
+            ntohs(rreq->identification), rreq->target_address, weight);
+}
+
+/** SMR, backup path: forward copies from new neighbors that are not worse than all forwarded before. */
+int dsr_rreqtable_forward_rreq_smr(dessert_meshif_t* iface, dessert_msg_t* msg, dsr_rreq_ext_t* rreq) {
+    uint32_t weight = dsr_rreq_get_weight_incl_hop_to_self(iface, rreq);
+
+    return dsr_smr_is_rreq_forward_ok(rreq->data[0].address, ntohs(rreq->identification), rreq->target_address, weight, msg->l2h.ether_shost);
+}
+
+/** DSR, ETXDSR: reply every RREQ received as target. */
+int dsr_rreqtable_reply_rreq_always(dessert_meshif_t* iface, dsr_rreq_ext_t* rreq) {
+    return DSR_RREQTABLE_REPLY_OK;
+}
+
+/** MDSR: reply every RREQ whose path is link disjoint to all replied before. */
+int dsr_rreqtable_reply_rreq_mdsr(dessert_meshif_t* iface, dsr_rreq_ext_t* rreq) {
+    dsr_path_t* rreq_path;
+    int res;
+
+    dsr_path_new_from_rreq(&rreq_path, rreq);
+    res = dsr_mdsr_is_repl_ok(rreq->data[0].address, ntohs(rreq->identification), rreq->target_address, rreq_path);
+    free(rreq_path);
+
+    return (res == DSR_MDSR_REPLY_OK ? DSR_RREQTABLE_REPLY_OK : DSR_RREQTABLE_REPLY_NOT_OK);
+}
+
+/** SMR, backup path: reply the first RREQ at once, choose the second when the reply window closes. */
+int dsr_rreqtable_reply_rreq_smr(dessert_meshif_t* iface, dsr_rreq_ext_t* rreq) {
+    int res;
+
+    res = dsr_smr_is_repl_ok(rreq->data[0].address, ntohs(rreq->identification), rreq->target_address, iface, rreq);
+
+    return (res == DSR_SMR_REPLY_OK ? DSR_RREQTABLE_REPLY_OK : DSR_RREQTABLE_REPLY_NOT_OK);
+}
 
 /******************************************************************************
  *
@@ -422,189 +601,36 @@ static inline int _get_links_in_common(dsr_smr_rreqcache_candidate_t* sd, dsr_sm
  ******************************************************************************/
 
 dessert_per_result_t run_rreqtable(void* data, struct timeval* scheduled, struct timeval* interval) {
-    dsr_rreqtable_t* iter_node = NULL;
+    dsr_rreqtable_timer_t* due = NULL;
+    size_t due_len = 0;
+    size_t due_size = 0;
     struct timeval now;
-    int is_ok = 0;
-
-    _RREQTABLE_WRITELOCK;
+    size_t i;
 
     gettimeofday(&now, NULL);
 
-    iter_node = _dsr_rreqtable;
-
-    while(iter_node) {
-        if(iter_node->timeout.tv_sec != 0) {
-            /* otherwise this node is in reset state */
-            is_ok = _is_routediscovery_ok_now(&now, iter_node);
+    /* collect the due timers first, the entries are locked by their stripe afterwards */
+    pthread_mutex_lock(&_timers_mutex);
 
-            if(is_ok > 0) {
-                int ttl = is_ok;
-                /* send another RREQ */
-                dsr_send_rreq(iter_node->address,
-                              dsr_new_rreq_identification(), ttl);
-
-            }
-            else if(is_ok == DSR_RREQTABLE_DISCOVERY_MAX_TIMEOUT_REACHED) {
-                dessert_debug("DSR_RREQTABLE_DISCOVERY_MAX_TIMEOUT_REACHED dest[" MAC "]", EXPLODE_ARRAY6(iter_node->address));
-                _reset_entry(iter_node);
-            }
-            else if(is_ok == DSR_RREQTABLE_DISCOVERY_WAIT) {
-                /* NOOP */
-            }
+    while(_timers_len > 0 && TIMEVAL_COMPARE(&now, &_timers[0].deadline) >= 0) {
+        if(due_len == due_size) {
+            due_size = (due_size == 0) ? 64 : 2 * due_size;
+            due = realloc(due, due_size * sizeof(dsr_rreqtable_timer_t));
+            assert(due != NULL);
         }
 
-        iter_node = iter_node->hh.next;
+        due[due_len++] = _timers[0];
+        _timers[0] = _timers[--_timers_len];
+        _heap_down(0);
     }
 
-#if (PROTOCOL == SMR || PROTOCOL == BACKUPPATH_VARIANT_1 || PROTOCOL == BACKUPPATH_VARIANT_2)
-    dsr_rreqcache_t* cacheentry = NULL;
+    pthread_mutex_unlock(&_timers_mutex);
 
-    iter_node = _dsr_rreqtable;
-
-    while(iter_node) {
-        HASH_FOREACH(hh, iter_node->rreqcache, cacheentry) {
-
-            if(cacheentry->complete == 0 && TIMEVAL_COMPARE(&now, &cacheentry->timeout) >= 0) {
-                /* time is up: choose one of the candidate paths */
-                dsr_smr_rreqcache_candidate_t* the_chosen_one = NULL;
-                dsr_smr_rreqcache_candidate_t* candidate = NULL;
-
-                if(cacheentry->candidates != NULL) {
-#    if (PROTOCOL == SMR || PROTOCOL == BACKUPPATH_VARIANT_2)
-                    /* choose the candidate path that is maximally disjoint to the shortest delay path */
-                    int nodes_in_common = 0;
-                    int links_in_common = 0;
-                    uint32_t weight = 0;
-                    int hopcount = 0;
-
-                    int cand_nodes_in_common = 0;
-                    int cand_links_in_common = 0;
-                    uint32_t cand_weight = 0;
-                    int cand_hopcount = 0;
-
-                    nodes_in_common = _get_nodes_in_common(cacheentry->shortest_delay, cacheentry->candidates);
-                    links_in_common = _get_links_in_common(cacheentry->shortest_delay, cacheentry->candidates);
-                    weight = dsr_rreq_get_weight_incl_hop_to_self((cacheentry->candidates)->iface, (cacheentry->candidates)->rreq);
-                    hopcount = DSR_RREQ_GET_HOPCOUNT((cacheentry->candidates)->rreq);
-                    the_chosen_one = cacheentry->candidates;
-
-                    DL_FOREACH((cacheentry->candidates)->next, candidate) {
-                        cand_nodes_in_common = _get_nodes_in_common(cacheentry->shortest_delay, candidate);
-                        cand_links_in_common = _get_links_in_common(cacheentry->shortest_delay, candidate);
-                        cand_weight = dsr_rreq_get_weight_incl_hop_to_self(candidate->iface, candidate->rreq);
-                        cand_hopcount = DSR_RREQ_GET_HOPCOUNT(candidate->rreq);
-
-                        if(cand_nodes_in_common < nodes_in_common)	{
-                            goto new_chosen_one;
-                        }
-                        else if(cand_nodes_in_common == nodes_in_common) {
-                            goto test_links_in_common;
-                        }
-                        else {
-                            continue;
-                        }
-
-                    test_links_in_common:
-
-                        if(cand_links_in_common < links_in_common) {
-                            goto new_chosen_one;
-                        }
-                        else if(cand_links_in_common == links_in_common) {
-                            goto test_weight;
-                        }
-                        else {
-                            continue;
-                        }
-
-                    test_weight:
-
-                        if(cand_weight < weight) {
-                            goto new_chosen_one;
-                        }
-                        else if(cand_weight == weight) {
-                            goto test_hopcount;
-                        }
-                        else {
-                            continue;
-                        }
-
-                    test_hopcount:
-
-                        if(cand_hopcount < hopcount) {
-                            goto new_chosen_one;
-                        }
-                        else {
-                            continue;
-                        }
-
-                    new_chosen_one:
-                        nodes_in_common = cand_nodes_in_common;
-                        links_in_common = cand_links_in_common;
-                        weight = cand_weight;
-                        hopcount = cand_weight;
-                        the_chosen_one = candidate;
-                    }
-#    elif (PROTOCOL == BACKUPPATH_VARIANT_1)
-                    /* choose the candidate path that has minimal weight */
-                    uint32_t weight = 0;
-                    int hopcount = 0;
-                    uint32_t cand_weight = 0;
-                    int cand_hopcount = 0;
-
-                    weight = dsr_rreq_get_weight_incl_hop_to_self((cacheentry->candidates)->iface, (cacheentry->candidates)->rreq);
-                    hopcount = DSR_RREQ_GET_HOPCOUNT((cacheentry->candidates)->rreq);
-                    the_chosen_one = cacheentry->candidates;
-
-                    DL_FOREACH((cacheentry->candidates)->next, candidate) {
-                        cand_weight = dsr_rreq_get_weight_incl_hop_to_self(candidate->iface, candidate->rreq);
-                        cand_hopcount = DSR_RREQ_GET_HOPCOUNT(candidate->rreq);
-
-                        if(cand_weight < weight) {
-                            goto new_chosen_one;
-                        }
-                        else if(cand_weight == weight) {
-                            goto test_hopcount;
-                        }
-                        else {
-                            continue;
-                        }
-
-                    test_hopcount:
-
-                        if(cand_hopcount < hopcount) {
-                            goto new_chosen_one;
-                        }
-                        else {
-                            continue;
-                        }
-
-                    new_chosen_one:
-                        weight = cand_weight;
-                        hopcount = cand_weight;
-                        the_chosen_one = candidate;
-                    }
-
-#    endif
-                }
-                else {
-                    /* NOOP: no candidate paths to choose from */
-                    dessert_debug("RREQTABLE: there are no candidate paths we could choose from!");
-                }
-
-                if(the_chosen_one != NULL) {
-                    dsr_send_repl(the_chosen_one->iface, the_chosen_one->rreq);
-                    dessert_debug("RREQTABLE: replying the maximal-disjoint path to source[" MAC "] for id[%i].", EXPLODE_ARRAY6(the_chosen_one->rreq->data[0].address), ntohs(the_chosen_one->rreq->identification));
-                }
-
-                cacheentry->complete = 1;
-            }
-        }
-        iter_node = iter_node->hh.next;
+    for(i = 0; i < due_len; i++) {
+        _run_timer(&now, &due[i]);
     }
 
-#endif
-
-    _RREQTABLE_UNLOCK;
+    free(due);
 
     return DESSERT_PER_KEEP;
 }
@@ -613,27 +639,32 @@ dessert_per_result_t cleanup_rreqtable(void* data, struct timeval* scheduled, st
     dsr_rreqtable_t* iter_node = NULL;
     dsr_rreqtable_t* next_node = NULL;
     struct timeval timeout;
-
-    _RREQTABLE_WRITELOCK;
+    int i;
 
     gettimeofday(&timeout, NULL);
     timeout.tv_sec -= DSR_CONFVAR_RREQTABLE_CLEANUP_INTERVAL_SECS;
 
-    iter_node = _dsr_rreqtable;
+    for(i = 0; i < DSR_CONFVAR_RREQTABLE_STRIPES; i++) {
+        dsr_rreqtable_stripe_t* stripe = &_stripes[i];
+
+        _RREQTABLE_WRITELOCK(stripe);
+
+        iter_node = stripe->table;
 
-    while(iter_node) {
-        next_node = iter_node->hh.next;
+        while(iter_node) {
+            next_node = iter_node->hh.next;
 
-        if(TIMEVAL_COMPARE(&timeout, &iter_node->last_used) >= 0) {
-            dessert_info("RREQTABLE: removing entry dest[" MAC "], not used for %usecs", EXPLODE_ARRAY6(iter_node->address), DSR_CONFVAR_RREQTABLE_CLEANUP_INTERVAL_SECS);
-            _remove_entry(iter_node);
+            if(TIMEVAL_COMPARE(&timeout, &iter_node->last_used) >= 0) {
+                dessert_info("RREQTABLE: removing entry dest[" MAC "], not used for %usecs", EXPLODE_ARRAY6(iter_node->address), DSR_CONFVAR_RREQTABLE_CLEANUP_INTERVAL_SECS);
+                _remove_entry(stripe, iter_node);
+            }
+
+            iter_node = next_node;
         }
 
-        iter_node = next_node;
+        _RREQTABLE_UNLOCK(stripe);
     }
 
-    _RREQTABLE_UNLOCK;
-
     return DESSERT_PER_KEEP;
 }
 
@@ -645,7 +676,12 @@ dessert_per_result_t cleanup_rreqtable(void* data, struct timeval* scheduled, st
 
 /* RREQTABLE */
 
-static inline dsr_rreqtable_t* _add_new_entry(const uint8_t address[ETHER_ADDR_LEN]) {
+static inline dsr_rreqtable_stripe_t* _get_stripe(const uint8_t address[ETHER_ADDR_LEN]) {
+    /* the last bytes of a MAC address vary most */
+    return &_stripes[(address[3] ^ address[4] ^ address[5]) % DSR_CONFVAR_RREQTABLE_STRIPES];
+}
+
+static inline dsr_rreqtable_t* _add_new_entry(dsr_rreqtable_stripe_t* stripe, const uint8_t address[ETHER_ADDR_LEN]) {
     dsr_rreqtable_t* node = NULL;
 
     node = malloc(sizeof(dsr_rreqtable_t));
@@ -656,15 +692,15 @@ static inline dsr_rreqtable_t* _add_new_entry(const uint8_t address[ETHER_ADDR_L
     node->rreqcache = NULL; // this is a MUST for uthash
     node->last_used.tv_sec = 0;
     node->last_used.tv_usec = 0;
-    HASH_ADD(hh, _dsr_rreqtable, address, ETHER_ADDR_LEN, node);
+    HASH_ADD(hh, stripe->table, address, ETHER_ADDR_LEN, node);
 
     return node;
 }
 
-static inline void _remove_entry(dsr_rreqtable_t* node) {
+static inline void _remove_entry(dsr_rreqtable_stripe_t* stripe, dsr_rreqtable_t* node) {
     assert(node != NULL);
 
-    HASH_DELETE(hh, _dsr_rreqtable, node);
+    HASH_DELETE(hh, stripe->table, node);
 
     while(node->rreqcache) {
         _destroy_rreqcache_entry(node, node->rreqcache);
@@ -682,10 +718,10 @@ static inline void _reset_entry(dsr_rreqtable_t* node) {
     node->timeout.tv_sec = node->timeout.tv_usec = 0;
 }
 
-static inline dsr_rreqtable_t* _get_entry_for_key(const uint8_t address[ETHER_ADDR_LEN]) {
+static inline dsr_rreqtable_t* _get_entry_for_key(dsr_rreqtable_stripe_t* stripe, const uint8_t address[ETHER_ADDR_LEN]) {
     dsr_rreqtable_t* node = NULL;
 
-    HASH_FIND(hh, _dsr_rreqtable, address, ETHER_ADDR_LEN, node);
+    HASH_FIND(hh, stripe->table, address, ETHER_ADDR_LEN, node);
 
     return node;
 }
@@ -734,6 +770,7 @@ static inline int _is_routediscovery_ok_now(struct timeval* now, dsr_rreqtable_t
         __suseconds_t timeout = timeout_factor * initial_timeout;
         TIMEVAL_ADD_SAFE(&node->timeout, 0, timeout);
         node->rreqs_since_repl++;
+        _schedule_timer(_TIMER_DISCOVERY, node->address, NULL, &node->timeout);
 
         is_ok = 1;
     }
@@ -741,6 +778,108 @@ static inline int _is_routediscovery_ok_now(struct timeval* now, dsr_rreqtable_t
     return (is_ok ? (int) node->ttl : DSR_RREQTABLE_DISCOVERY_WAIT);
 }
 
+/* TIMERS */
+
+static inline void _heap_up(size_t pos) {
+    dsr_rreqtable_timer_t timer = _timers[pos];
+
+    while(pos > 0 && TIMEVAL_COMPARE(&timer.deadline, &_timers[(pos - 1) / 2].deadline) < 0) {
+        _timers[pos] = _timers[(pos - 1) / 2];
+        pos = (pos - 1) / 2;
+    }
+
+    _timers[pos] = timer;
+}
+
+static inline void _heap_down(size_t pos) {
+    dsr_rreqtable_timer_t timer = _timers[pos];
+    size_t child;
+
+    while((child = 2 * pos + 1) < _timers_len) {
+        if(child + 1 < _timers_len && TIMEVAL_COMPARE(&_timers[child + 1].deadline, &_timers[child].deadline) < 0) {
+            child++;
+        }
+
+        if(TIMEVAL_COMPARE(&_timers[child].deadline, &timer.deadline) >= 0) {
+            break;
+        }
+
+        _timers[pos] = _timers[child];
+        pos = child;
+    }
+
+    _timers[pos] = timer;
+}
+
+static inline void _schedule_timer(int type, const uint8_t address[ETHER_ADDR_LEN], const dsr_rreqcache_lookup_key_t* key, const struct timeval* deadline) {
+    dsr_rreqtable_timer_t* timer;
+
+    pthread_mutex_lock(&_timers_mutex);
+
+    if(_timers_len == _timers_size) {
+        _timers_size = (_timers_size == 0) ? 256 : 2 * _timers_size;
+        _timers = realloc(_timers, _timers_size * sizeof(dsr_rreqtable_timer_t));
+        assert(_timers != NULL);
+    }
+
+    timer = &_timers[_timers_len];
+    timer->deadline = *deadline;
+    timer->type = type;
+    ADDR_CPY(timer->address, address);
+
+    if(key != NULL) {
+        memcpy(&timer->key, key, sizeof(dsr_rreqcache_lookup_key_t));
+    }
+    else {
+        memset(&timer->key, 0, sizeof(dsr_rreqcache_lookup_key_t));
+    }
+
+    _heap_up(_timers_len++);
+
+    pthread_mutex_unlock(&_timers_mutex);
+}
+
+/** Runs a popped timer unless its entry was reset, rescheduled or removed meanwhile. */
+static inline void _run_timer(struct timeval* now, dsr_rreqtable_timer_t* timer) {
+    dsr_rreqtable_stripe_t* stripe = _get_stripe(timer->address);
+    dsr_rreqtable_t* node = NULL;
+    int is_ok = 0;
+
+    _RREQTABLE_WRITELOCK(stripe);
+
+    node = _get_entry_for_key(stripe, timer->address);
+
+    if(node != NULL && timer->type == _TIMER_DISCOVERY
+       && node->timeout.tv_sec != 0 && TIMEVAL_COMPARE(&node->timeout, &timer->deadline) == 0) {
+        is_ok = _is_routediscovery_ok_now(now, node);
+
+        if(is_ok > 0) {
+            int ttl = is_ok;
+            /* send another RREQ */
+            dsr_send_rreq(node->address,
+                          dsr_new_rreq_identification(), ttl);
+        }
+        else if(is_ok == DSR_RREQTABLE_DISCOVERY_MAX_TIMEOUT_REACHED) {
+            dessert_debug("DSR_RREQTABLE_DISCOVERY_MAX_TIMEOUT_REACHED dest[" MAC "]", EXPLODE_ARRAY6(node->address));
+            _reset_entry(node);
+        }
+    }
+
+    else if(node != NULL && timer->type == _TIMER_REPLY) {
+        dsr_rreqcache_t* cacheentry = NULL;
+
+        HASH_FIND(hh, node->rreqcache, &timer->key, sizeof(dsr_rreqcache_lookup_key_t), cacheentry);
+
+        if(cacheentry != NULL && cacheentry->smr != NULL && cacheentry->smr->complete == 0
+           && TIMEVAL_COMPARE(&cacheentry->smr->timeout, &timer->deadline) == 0) {
+            /* time is up: choose one of the candidate paths */
+            _choose_and_reply(cacheentry->smr);
+        }
+    }
+
+    _RREQTABLE_UNLOCK(stripe);
+}
+
 /* RREQCACHE */
 
 static inline dsr_rreqcache_t* _add_rreqcache_entry(dsr_rreqtable_t* node, const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN]) {
@@ -754,20 +893,9 @@ static inline dsr_rreqcache_t* _add_rreqcache_entry(dsr_rreqtable_t* node, const
     cacheentry->identification = identification;
     ADDR_CPY(cacheentry->target_address, target_address);
 
-#if (PROTOCOL == MDSR_PROTOKOLL_1)
-    cacheentry->path_list = NULL;
-#endif
-
-#if (PROTOCOL == SMR || PROTOCOL == BACKUPPATH_VARIANT_1 || PROTOCOL == BACKUPPATH_VARIANT_2)
-    cacheentry->neighbor_list_len = 0;
-    cacheentry->shortest_delay = NULL;
-    cacheentry->candidates = NULL;
-    cacheentry->complete = 0;
-#endif
-
-#if (METRIC == ETX)
+    cacheentry->paths = NULL;
+    cacheentry->smr = NULL;
     cacheentry->best_weight = 65535; /* best weight for this id so far */
-#endif
 
     if(HASH_CNT(hh, node->rreqcache) == DSR_CONFVAR_RREQTABLE_REQUESTTABLEIDS) {
         _destroy_rreqcache_entry(node, node->rreqcache); /* FIFO */
@@ -790,12 +918,12 @@ static inline dsr_rreqcache_t* _get_rreqcache_entry_for_node(dsr_rreqtable_t* no
     return cacheentry;
 }
 
-static inline dsr_rreqcache_t* _get_rreqcache_entry(const uint8_t address[ETHER_ADDR_LEN], const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN]) {
+static inline dsr_rreqcache_t* _get_rreqcache_entry(dsr_rreqtable_stripe_t* stripe, const uint8_t address[ETHER_ADDR_LEN], const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN]) {
     dsr_rreqtable_t* node = NULL;
     dsr_rreqcache_t* cacheentry = NULL;
     dsr_rreqcache_lookup_key_t lookupkey;
 
-    node = _get_entry_for_key(address);
+    node = _get_entry_for_key(stripe, address);
 
     if(node == NULL) {
         return NULL;
@@ -832,29 +960,27 @@ static inline void _mark_entry_used(dsr_rreqtable_t* node) {
 static inline void _destroy_rreqcache_entry(dsr_rreqtable_t* node, dsr_rreqcache_t* cacheentry) {
     HASH_DELETE(hh, node->rreqcache, cacheentry);
 
-#if (PROTOCOL == MDSR_PROTOKOLL_1)
-    dsr_path_t* path;
-
-    while(cacheentry->path_list) {
-        path = cacheentry->path_list;
-        DL_DELETE(cacheentry->path_list, path);
-        free(path);
+    if(cacheentry->paths != NULL) {
+        dsr_pathset_destroy(cacheentry->paths);
+        free(cacheentry->paths);
     }
 
-#endif
+    if(cacheentry->smr != NULL) {
+        dsr_smr_rreqcache_t* smr = cacheentry->smr;
+        dsr_smr_rreqcache_candidate_t* candidate;
 
-#if (PROTOCOL == SMR || PROTOCOL == BACKUPPATH_VARIANT_1 || PROTOCOL == BACKUPPATH_VARIANT_2)
-    free(cacheentry->shortest_delay);
+        if(smr->shortest_delay != NULL) {
+            _destroy_dsr_smr_rreq_candidate(smr->shortest_delay);
+        }
 
-    dsr_smr_rreqcache_candidate_t* candidate;
+        while(smr->candidates) {
+            candidate = smr->candidates;
+            DL_DELETE(smr->candidates, candidate);
+            _destroy_dsr_smr_rreq_candidate(candidate);
+        }
 
-    while(cacheentry->candidates) {
-        candidate = cacheentry->candidates;
-        DL_DELETE(cacheentry->candidates, candidate);
-        free(candidate);
+        free(smr);
     }
 
-#endif
-
     free(cacheentry);
 }
@@ -63,18 +63,15 @@ inline int dsr_is_rreqcache_entry_present(const uint8_t address[ETHER_ADDR_LEN],
 /** Add an entry to a rreqcache in the Route Request Table.*/
 inline int dsr_add_node_to_rreqtable_cache(const uint8_t address[ETHER_ADDR_LEN], const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN]);
 
-#if (METRIC == ETX)
 inline int dsr_is_rreqcache_entry_present_and_worse_than(const uint8_t address[ETHER_ADDR_LEN], const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN], uint32_t weight);
-#endif
 
-#if (PROTOCOL == MDSR_PROTOKOLL_1)
 #define DSR_MDSR_REPLY_OK                                 0
 #define DSR_MDSR_REPLY_NOT_OK                             1
 
+/** Tests if @a path is link disjoint to all paths replied so far for this
+ *  RREQ and remembers it if so. The caller keeps ownership of @a path. */
 inline int dsr_mdsr_is_repl_ok(const uint8_t address[ETHER_ADDR_LEN], const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN], dsr_path_t* path);
-#endif
 
-#if (PROTOCOL == SMR || PROTOCOL == BACKUPPATH_VARIANT_1 || PROTOCOL == BACKUPPATH_VARIANT_2)
 #define DSR_SMR_REPLY_OK                                 0
 #define DSR_SMR_REPLY_NOT_OK                             1
 
@@ -89,23 +86,26 @@ inline int dsr_smr_is_repl_ok(const uint8_t address[ETHER_ADDR_LEN], const uint1
 
 inline int dsr_smr_is_rreq_forward_ok(const uint8_t address[ETHER_ADDR_LEN], const uint16_t identification, const uint8_t target_address[ETHER_ADDR_LEN], uint32_t weight, uint8_t neighbor[ETHER_ADDR_LEN]);
 
-#endif
+#define DSR_RREQTABLE_REPLY_OK                            0
+#define DSR_RREQTABLE_REPLY_NOT_OK                        1
+
+/* RREQ forwarding rules of the variants, see dsr_variant_t */
+int dsr_rreqtable_forward_rreq_once(dessert_meshif_t* iface, dessert_msg_t* msg, dsr_rreq_ext_t* rreq);
+int dsr_rreqtable_forward_rreq_if_better(dessert_meshif_t* iface, dessert_msg_t* msg, dsr_rreq_ext_t* rreq);
+int dsr_rreqtable_forward_rreq_smr(dessert_meshif_t* iface, dessert_msg_t* msg, dsr_rreq_ext_t* rreq);
+
+/* reply selection of the variants at the target of a RREQ, see dsr_variant_t */
+int dsr_rreqtable_reply_rreq_always(dessert_meshif_t* iface, dsr_rreq_ext_t* rreq);
+int dsr_rreqtable_reply_rreq_mdsr(dessert_meshif_t* iface, dsr_rreq_ext_t* rreq);
+int dsr_rreqtable_reply_rreq_smr(dessert_meshif_t* iface, dsr_rreq_ext_t* rreq);
 
 dessert_per_result_t run_rreqtable(void* data, struct timeval* scheduled, struct timeval* interval);
 dessert_per_result_t cleanup_rreqtable(void* data, struct timeval* scheduled, struct timeval* interval);
 
 #define DSR_RREQTABLE_RREQCACHE_KEYLEN (sizeof(uint16_t) + ETHER_ADDR_LEN)
 
-typedef struct __attribute__((__packed__)) dsr_rreqcache {
-    uint16_t identification; /* key: part 1 -- in network byte order! */
-    uint8_t target_address[ETHER_ADDR_LEN]; /* key: part 2 */
-#if (METRIC == ETX)
-    uint32_t best_weight; /* best weight for this id so far */
-#endif
-#if (PROTOCOL == MDSR_PROTOKOLL_1)
-    dsr_path_t* path_list; /* List with paths we replied to source */
-#endif
-#if (PROTOCOL == SMR || PROTOCOL == BACKUPPATH_VARIANT_1 || PROTOCOL == BACKUPPATH_VARIANT_2)
+/** state of the SMR and backup path variants per rreqcache entry */
+typedef struct dsr_smr_rreqcache {
     /* data about RREQs we forwarded*/
     uint32_t weight; /* best weight so far */
     int neighbor_list_len;
@@ -116,7 +116,14 @@ typedef struct __attribute__((__packed__)) dsr_rreqcache {
     struct timeval timeout; /* time at which we reply to source  */
     dsr_smr_rreqcache_candidate_t* candidates;
     int complete; /* did we sent the second reply yet? */
-#endif
+} dsr_smr_rreqcache_t;
+
+typedef struct __attribute__((__packed__)) dsr_rreqcache {
+    uint16_t identification; /* key: part 1 -- in network byte order! */
+    uint8_t target_address[ETHER_ADDR_LEN]; /* key: part 2 */
+    uint32_t best_weight; /* best weight for this id so far (ETX) */
+    dsr_pathset_t* paths; /* paths we replied to source, NULL until the first (MDSR) */
+    dsr_smr_rreqcache_t* smr; /* NULL until the first RREQ forwarded or received as target (SMR, backup path) */
     UT_hash_handle hh;
 } dsr_rreqcache_t;
 
@@ -31,134 +31,365 @@ pthread_rwlock_t _dsr_sendbuffer_rwlock = PTHREAD_RWLOCK_INITIALIZER;
 #define _SB_READLOCK pthread_rwlock_rdlock(&_dsr_sendbuffer_rwlock)
 #define _SB_WRITELOCK pthread_rwlock_wrlock(&_dsr_sendbuffer_rwlock)
 #define _SB_UNLOCK pthread_rwlock_unlock(&_dsr_sendbuffer_rwlock)
-#define _SAFE_RETURN(x) _SB_UNLOCK; return(x);
+
+/*
+ * Buffered msgs are kept in one queue per destination, found by hash. A
+ * msg is also linked into the slot of a timer wheel its timeout falls
+ * into, so expiring msgs only needs to look at the current slot. Once a
+ * route to a destination is known, its queue is put on the draining list
+ * and run_sendbuffer sends the msgs paced by a token bucket per queue.
+ */
+
+#define _TOKEN 1000000ULL
 
 dsr_sendbuffer_t* sendbuffer = NULL;
+static dsr_sendbuffer_t* _draining = NULL;
+
+static dsr_sendbuffer_entry_t* _wheel[DSR_CONFVAR_SENDBUFFER_WHEEL_SLOTS];
+static uint64_t _wheel_tick = 0;
+
+static dsr_sendbuffer_stats_t _stats;
 
 /* local forward declarations */
-static inline void _destroy_entry(dsr_sendbuffer_t* buffer);
+static inline uint64_t _now_usecs(void);
+static inline dsr_sendbuffer_t* _get_queue(const uint8_t dest[ETHER_ADDR_LEN]);
+static inline void _remove_queue(dsr_sendbuffer_t* queue);
+static inline dsr_sendbuffer_entry_t* _unlink_entry(dsr_sendbuffer_entry_t* entry);
+static inline void _drain_queue(dsr_sendbuffer_t* queue, dsr_path_t* path, uint64_t now);
+static inline void _expire(uint64_t now);
+static inline void _destroy_entry(dsr_sendbuffer_entry_t* entry);
 
 inline void dsr_sendbuffer_add(const uint8_t dest[ETHER_ADDR_LEN], dessert_msg_t* msg) {
-    dsr_sendbuffer_t* new = NULL;
+    dsr_sendbuffer_entry_t* new = NULL;
+    dsr_sendbuffer_t* queue = NULL;
+    uint64_t now = _now_usecs();
+    __suseconds_t timeout = dsr_conf_get_sendbuffer_timeout();
+    size_t slot;
 
-    new = malloc(sizeof(dsr_sendbuffer_t));
+    new = malloc(sizeof(dsr_sendbuffer_entry_t));
     assert(new != NULL);
 
+    new->msg = msg;
+    new->size = ntohs(msg->hlen) + ntohs(msg->plen);
+
     _SB_WRITELOCK;
 
-    ADDR_CPY(new->dest, dest);
-    new->msg = msg;
-    gettimeofday(&new->timeout, NULL);
-    TIMEVAL_ADD_SAFE(&new->timeout, 0, dsr_conf_get_sendbuffer_timeout());
-    dessert_debug("SENDBUFFER: adding msg to [" MAC "] timeout in %usecs", EXPLODE_ARRAY6(dest), dsr_conf_get_sendbuffer_timeout() / 1000000);
+    if(_wheel_tick == 0) {
+        _wheel_tick = now / DSR_CONFVAR_SENDBUFFER_WHEEL_TICK_USECS;
+    }
+
+    queue = _get_queue(dest);
+
+    /* a full queue loses its oldest msg */
+    if(queue->len >= DSR_CONFVAR_SENDBUFFER_MAX_PACKETS_PER_DEST) {
+        _destroy_entry(_unlink_entry(queue->msgs));
+        _stats.drops_dest++;
+    }
+
+    /* the global budget only makes room at the expense of the same destination */
+    while(queue->len > 0 && (_stats.len >= DSR_CONFVAR_SENDBUFFER_MAX_PACKETS
+                             || _stats.bytes + new->size > DSR_CONFVAR_SENDBUFFER_MAX_BYTES)) {
+        _destroy_entry(_unlink_entry(queue->msgs));
+        _stats.drops_budget++;
+    }
+
+    if(_stats.len >= DSR_CONFVAR_SENDBUFFER_MAX_PACKETS
+       || _stats.bytes + new->size > DSR_CONFVAR_SENDBUFFER_MAX_BYTES) {
+        dessert_debug("SENDBUFFER: budget exhausted, dropping msg to [" MAC "]", EXPLODE_ARRAY6(dest));
+        _stats.drops_budget++;
+        _remove_queue(queue);
+        _destroy_entry(new);
+        _SB_UNLOCK;
+        return;
+    }
+
+    new->queue = queue;
+    DL_APPEND(queue->msgs, new);
+    queue->len++;
+    queue->bytes += new->size;
+
+    /* the slot a timeout falls into is never behind the current tick */
+    new->expires = (now + timeout + DSR_CONFVAR_SENDBUFFER_WHEEL_TICK_USECS - 1) / DSR_CONFVAR_SENDBUFFER_WHEEL_TICK_USECS;
+
+    if(new->expires < _wheel_tick) {
+        new->expires = _wheel_tick;
+    }
+
+    slot = new->expires % DSR_CONFVAR_SENDBUFFER_WHEEL_SLOTS;
+    new->wheel_prev = NULL;
+    new->wheel_next = _wheel[slot];
+
+    if(_wheel[slot] != NULL) {
+        _wheel[slot]->wheel_prev = new;
+    }
+
+    _wheel[slot] = new;
 
-    DL_APPEND(sendbuffer, new);
+    _stats.len++;
+    _stats.bytes += new->size;
+    _stats.enqueued++;
+
+    if(_stats.len > _stats.max_len) {
+        _stats.max_len = _stats.len;
+    }
+
+    dessert_debug("SENDBUFFER: adding msg to [" MAC "] timeout in %lisecs", EXPLODE_ARRAY6(dest), timeout / 1000000);
 
     _SB_UNLOCK;
 }
 
+/** Starts draining the queue of @a dest, called whenever a route to @a dest was added.
+ *  Up to the burst size of the token bucket leaves at once, the rest is sent by run_sendbuffer. */
 inline void dsr_sendbuffer_send_msgs_to(const uint8_t dest[ETHER_ADDR_LEN]) {
     dsr_path_t path;
 
-#if (LOAD_BALANCING == 0)
-    int res = dsr_routecache_get_first(dest, &path);
-#elif (LOAD_BALANCING == 1)
-    int res = dsr_routecache_get_next_round_robin(dest, &path);
-#endif
+    int res = DSR_VARIANT_CALL(get_path)(dest, &path);
     assert(res == DSR_ROUTECACHE_SUCCESS);
 
     if(res == DSR_ROUTECACHE_SUCCESS) {
-        dsr_sendbuffer_t* iter_buffer = NULL;
-        dsr_sendbuffer_t* tbd_buffer = NULL;
-
-        __suseconds_t delay = 1000; /* 10ms */
-        int delay_factor = 1;
+        dsr_sendbuffer_t* queue = NULL;
+        uint64_t now = _now_usecs();
 
         _SB_WRITELOCK;
-        iter_buffer = sendbuffer;
-
-        while(iter_buffer) {
-            if(ADDR_CMP(dest, iter_buffer->dest) == 0) {
-                dessert_debug("SENDBUFFER: msg for dest[" MAC "] found.", EXPLODE_ARRAY6(iter_buffer->dest));
-                tbd_buffer = iter_buffer;
-                DL_DELETE(sendbuffer, iter_buffer);
-                iter_buffer = iter_buffer->next;
-                /* delay every msg by an increasing factor */
-                dsr_msg_send_via_path_delay(tbd_buffer->msg, &path, delay_factor * delay);
-                delay_factor++;
-                _destroy_entry(tbd_buffer);
-            }
-            else {
-                iter_buffer = iter_buffer->next;
-            }
+        HASH_FIND(hh, sendbuffer, dest, ETHER_ADDR_LEN, queue);
+
+        if(queue == NULL) {
+            _SB_UNLOCK;
+            return;
+        }
+
+        dessert_debug("SENDBUFFER: %u msgs for dest[" MAC "] found.", queue->len, EXPLODE_ARRAY6(dest));
+
+        if(!queue->draining) {
+            queue->draining = 1;
+            queue->tokens = dsr_conf_get_sendbuffer_drain_burst() * _TOKEN;
+            queue->last_refill = now;
+            DL_APPEND(_draining, queue);
+            _stats.draining++;
         }
 
+        _drain_queue(queue, &path, now);
         _SB_UNLOCK;
     }
 }
 
+void dsr_sendbuffer_get_stats(dsr_sendbuffer_stats_t* stats) {
+    _SB_READLOCK;
+    memcpy(stats, &_stats, sizeof(dsr_sendbuffer_stats_t));
+    _SB_UNLOCK;
+}
+
 /******************************************************************************
  *
  * Periodic tasks --
  *
  ******************************************************************************/
 
-dessert_per_result_t cleanup_sendbuffer(void* data, struct timeval* scheduled, struct timeval* interval) {
-    dsr_sendbuffer_t* iter_buffer = NULL;
-    dsr_sendbuffer_t* tbd_buffer = NULL;
-
-    struct timeval now;
+/** Sends the msgs of all draining queues the token buckets allow and drops
+ *  the msgs that timed out since the last run. */
+dessert_per_result_t run_sendbuffer(void* data, struct timeval* scheduled, struct timeval* interval) {
+    dsr_sendbuffer_t* queue = NULL;
+    dsr_sendbuffer_t* next_queue = NULL;
+    uint64_t now = _now_usecs();
 
     _SB_WRITELOCK;
 
-    gettimeofday(&now, NULL);
-    iter_buffer = sendbuffer;
-    int i = 0;
-
-    while(iter_buffer) {
-        if(TIMEVAL_COMPARE(&now, &iter_buffer->timeout) >= 0) {
-            //			dessert_debug("\n"
-            //					"now.tvsec     [%li]\n"
-            //					"timeout.tvsec [%lu]", now.tv_sec, iter_buffer->timeout.tv_sec);
-            tbd_buffer = iter_buffer;
-            DL_DELETE(sendbuffer, iter_buffer);
-            iter_buffer = iter_buffer->next;
-            dessert_debug("SENDBUFER: Removing msg to [" MAC "], no route in %usecs", EXPLODE_ARRAY6(tbd_buffer->dest), dsr_conf_get_sendbuffer_timeout() / 1000000);
-            _destroy_entry(tbd_buffer);
+    queue = _draining;
+
+    while(queue) {
+        dsr_path_t path;
+        int res = DSR_VARIANT_CALL(get_path)(queue->dest, &path);
+        next_queue = queue->next;
+
+        if(res == DSR_ROUTECACHE_SUCCESS) {
+            _drain_queue(queue, &path, now);
         }
         else {
-            iter_buffer = iter_buffer->next;
-            i++;
+            /* the route broke meanwhile, wait for the next REPL or the timeout */
+            DL_DELETE(_draining, queue);
+            queue->draining = 0;
+            _stats.draining--;
         }
+
+        queue = next_queue;
     }
 
+    _expire(now);
+
     _SB_UNLOCK;
 
     return DESSERT_PER_KEEP;
 }
 
+/******************************************************************************
+ *
+ * C L I --
+ *
+ ******************************************************************************/
+
+/** CLI command - exec mode - info sendbuffer */
+int dessert_cli_cmd_showsendbuffer(struct cli_def* cli, char* command, char* argv[], int argc) {
+    dsr_sendbuffer_t* queue = NULL;
+
+    _SB_READLOCK;
+    cli_print(cli, "queues[%u] draining[%u] msgs[%u] bytes[%zu] max_msgs[%u]",
+              _stats.queues, _stats.draining, _stats.len, _stats.bytes, _stats.max_len);
+    cli_print(cli, "enqueued[%u] sent[%u] timeouts[%u] drops_dest[%u] drops_budget[%u]",
+              _stats.enqueued, _stats.sent, _stats.timeouts, _stats.drops_dest, _stats.drops_budget);
+
+    HASH_FOREACH(hh, sendbuffer, queue) {
+        cli_print(cli, "dest[" MAC "] msgs[%u] bytes[%zu] draining[%i]",
+                  EXPLODE_ARRAY6(queue->dest), queue->len, queue->bytes, queue->draining);
+    }
+
+    _SB_UNLOCK;
+    return CLI_OK;
+}
+
 /******************************************************************************
  *
  * LOCAL
  *
  ******************************************************************************/
 
-static inline void _destroy_entry(dsr_sendbuffer_t* buffer) {
-    dessert_msg_destroy(buffer->msg);
-    free(buffer);
+static inline uint64_t _now_usecs(void) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (uint64_t) now.tv_sec * 1000000 + now.tv_usec;
+}
+
+/** returns the queue of @a dest, a new one if there is none yet */
+static inline dsr_sendbuffer_t* _get_queue(const uint8_t dest[ETHER_ADDR_LEN]) {
+    dsr_sendbuffer_t* queue = NULL;
+
+    HASH_FIND(hh, sendbuffer, dest, ETHER_ADDR_LEN, queue);
+
+    if(queue == NULL) {
+        queue = malloc(sizeof(dsr_sendbuffer_t));
+        assert(queue != NULL);
+        memset(queue, 0, sizeof(dsr_sendbuffer_t));
+        ADDR_CPY(queue->dest, dest);
+        HASH_ADD(hh, sendbuffer, dest, ETHER_ADDR_LEN, queue);
+        _stats.queues++;
+    }
+
+    return queue;
+}
+
+/** removes and frees @a queue if it holds no msgs anymore */
+static inline void _remove_queue(dsr_sendbuffer_t* queue) {
+    if(queue->len > 0) {
+        return;
+    }
+
+    if(queue->draining) {
+        DL_DELETE(_draining, queue);
+        _stats.draining--;
+    }
+
+    HASH_DELETE(hh, sendbuffer, queue);
+    _stats.queues--;
+    free(queue);
+}
+
+/** unlinks @a entry from its queue and from the timer wheel */
+static inline dsr_sendbuffer_entry_t* _unlink_entry(dsr_sendbuffer_entry_t* entry) {
+    dsr_sendbuffer_t* queue = entry->queue;
+    size_t slot = entry->expires % DSR_CONFVAR_SENDBUFFER_WHEEL_SLOTS;
+
+    DL_DELETE(queue->msgs, entry);
+    queue->len--;
+    queue->bytes -= entry->size;
+
+    if(entry->wheel_prev != NULL) {
+        entry->wheel_prev->wheel_next = entry->wheel_next;
+    }
+    else {
+        _wheel[slot] = entry->wheel_next;
+    }
+
+    if(entry->wheel_next != NULL) {
+        entry->wheel_next->wheel_prev = entry->wheel_prev;
+    }
+
+    _stats.len--;
+    _stats.bytes -= entry->size;
+    return entry;
 }
 
+/** refills the token bucket of @a queue and sends as many msgs via @a path as it allows;
+ *  a drain rate of 0 sends all msgs at once */
+static inline void _drain_queue(dsr_sendbuffer_t* queue, dsr_path_t* path, uint64_t now) {
+    uint32_t rate = dsr_conf_get_sendbuffer_drain_rate();
+    uint64_t burst = dsr_conf_get_sendbuffer_drain_burst() * _TOKEN;
+
+    if(rate > 0) {
+        if(now > queue->last_refill) {
+            queue->tokens += (now - queue->last_refill) * rate;
+        }
+
+        if(queue->tokens > burst) {
+            queue->tokens = burst;
+        }
+
+        queue->last_refill = now;
+    }
+
+    while(queue->msgs != NULL && (rate == 0 || queue->tokens >= _TOKEN)) {
+        dsr_sendbuffer_entry_t* entry = _unlink_entry(queue->msgs);
 
+        dsr_msg_send_via_path_delay(entry->msg, path, 0);
+        _stats.sent++;
+        _destroy_entry(entry);
 
+        if(rate > 0) {
+            queue->tokens -= _TOKEN;
+        }
+    }
 
+    _remove_queue(queue);
+}
 
+/** drops all msgs whose timeout expired up to @a now, visiting each wheel slot once at most */
+static inline void _expire(uint64_t now) {
+    uint64_t now_tick = now / DSR_CONFVAR_SENDBUFFER_WHEEL_TICK_USECS;
+    uint64_t visited = 0;
 
+    if(_wheel_tick == 0) {
+        return;
+    }
 
+    while(_wheel_tick <= now_tick && visited < DSR_CONFVAR_SENDBUFFER_WHEEL_SLOTS) {
+        dsr_sendbuffer_entry_t* entry = _wheel[_wheel_tick % DSR_CONFVAR_SENDBUFFER_WHEEL_SLOTS];
 
+        while(entry) {
+            dsr_sendbuffer_entry_t* next = entry->wheel_next;
 
+            /* entries of a later revolution stay in the slot */
+            if(entry->expires <= now_tick) {
+                dsr_sendbuffer_t* queue = entry->queue;
 
+                _unlink_entry(entry);
 
+                dessert_debug("SENDBUFER: Removing msg to [" MAC "], no route in time", EXPLODE_ARRAY6(queue->dest));
+                _stats.timeouts++;
+                _destroy_entry(entry);
+                _remove_queue(queue);
+            }
 
+            entry = next;
+        }
 
+        _wheel_tick++;
+        visited++;
+    }
 
+    if(_wheel_tick <= now_tick) {
+        _wheel_tick = now_tick + 1;
+    }
+}
 
+static inline void _destroy_entry(dsr_sendbuffer_entry_t* entry) {
+    dessert_msg_destroy(entry->msg);
+    free(entry);
+}
@@ -31,19 +31,55 @@
 #include "dsr.h"
 
 typedef struct dsr_sendbuffer dsr_sendbuffer_t;
+typedef struct dsr_sendbuffer_entry dsr_sendbuffer_entry_t;
+
+/** a buffered msg, linked into the queue of its destination and into a timer wheel slot */
+struct dsr_sendbuffer_entry {
+    dessert_msg_t* msg;
+    size_t size;
+    uint64_t expires;                   /* timer wheel tick the msg is dropped at */
+    dsr_sendbuffer_t* queue;
+    dsr_sendbuffer_entry_t* next;
+    dsr_sendbuffer_entry_t* prev;
+    dsr_sendbuffer_entry_t* wheel_next;
+    dsr_sendbuffer_entry_t* wheel_prev;
+};
+
+/** the queue of all buffered msgs to one destination */
 struct dsr_sendbuffer {
     uint8_t dest[ETHER_ADDR_LEN];
-    struct timeval timeout;
-    dessert_msg_t* msg;
-    dsr_sendbuffer_t* next;
+    dsr_sendbuffer_entry_t* msgs;       /* oldest first */
+    uint32_t len;
+    size_t bytes;
+    int draining;                       /* a route is known, msgs leave paced */
+    uint64_t tokens;                    /* token bucket, in millionths of a msg */
+    uint64_t last_refill;
+    dsr_sendbuffer_t* next;             /* list of draining queues */
     dsr_sendbuffer_t* prev;
+    UT_hash_handle hh;
 };
 
-
-#endif /* SENDBUFFER_H_ */
+typedef struct dsr_sendbuffer_stats {
+    uint32_t queues;
+    uint32_t draining;
+    uint32_t len;
+    size_t bytes;
+    uint32_t max_len;                   /* high water mark of len */
+    uint32_t enqueued;
+    uint32_t sent;
+    uint32_t timeouts;
+    uint32_t drops_dest;                /* oldest msg dropped, queue of destination full */
+    uint32_t drops_budget;              /* msg dropped, global packet or byte budget exhausted */
+} dsr_sendbuffer_stats_t;
 
 inline void dsr_sendbuffer_add(const uint8_t dest[ETHER_ADDR_LEN], dessert_msg_t* msg);
 
 inline void dsr_sendbuffer_send_msgs_to(const uint8_t dest[ETHER_ADDR_LEN]);
 
-dessert_per_result_t cleanup_sendbuffer(void* data, struct timeval* scheduled, struct timeval* interval);
+void dsr_sendbuffer_get_stats(dsr_sendbuffer_stats_t* stats);
+
+dessert_per_result_t run_sendbuffer(void* data, struct timeval* scheduled, struct timeval* interval);
+
+int dessert_cli_cmd_showsendbuffer(struct cli_def* cli, char* command, char* argv[], int argc);
+
+#endif /* SENDBUFFER_H_ */
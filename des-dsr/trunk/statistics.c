@@ -26,19 +26,88 @@
  ******************************************************************************/
 
 #include "dsr.h"
-
-pthread_mutex_t _dsr_statistics_mutex = PTHREAD_MUTEX_INITIALIZER;
-#define _STATISTICS_LOCK pthread_mutex_lock(&_dsr_statistics_mutex)
-#define _STATISTICS_UNLOCK pthread_mutex_unlock(&_dsr_statistics_mutex)
-#define _SAFE_RETURN(x) _STATISTICS_UNLOCK; return(x);
-
-static inline dsr_statistics_link_t* _get_link_data(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]);
-static inline dsr_statistics_link_t* _new_link_data(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]);
-static void _print_link_statistics_to_cli(struct cli_def* cli, uint8_t local[ETHER_ADDR_LEN], uint8_t remote[ETHER_ADDR_LEN], dsr_statistics_data_t data);
-
-static dsr_statistics_t _stat;
+#include <stdarg.h>
+
+/*
+ * Every thread counts into a block of its own, so the packet path takes no
+ * lock. Only the owner writes the counters of a block: an increment is a
+ * plain load and add followed by a relaxed atomic store, which a reader can
+ * not see torn. The blocks are summed up when the statistics are printed or
+ * exported. A block outlives its thread and is taken over by the next thread
+ * counting, so no counts are lost.
+ */
+
+#define _DATA_COUNTERS (sizeof(dsr_statistics_data_t) / sizeof(uint64_t))
+#define _EMIT_COUNTERS (sizeof(dsr_statistics_emit_t) / sizeof(uint64_t))
+#define _LINE_LEN 4096
+
+#define _ADD(field, n) __atomic_store_n(&(field), (field) + (n), __ATOMIC_RELAXED)
+#define _COUNT(field, n) _ADD(block->total.field, n); _ADD(link->data.field, n)
+
+typedef struct block {
+    dsr_statistics_emit_t emit;
+    dsr_statistics_data_t total;
+    dsr_statistics_link_t** links;  /* open addressing on local and remote */
+    uint32_t size;                  /* slots, a power of two */
+    uint32_t len;                   /* links, at most size / 2 */
+    int active;                     /* owned by a running thread */
+    pthread_mutex_t mutex;          /* owner: while adding links, readers: while walking them */
+    struct block* next;
+} block_t;
+
+typedef struct out {
+    struct cli_def* cli;
+    FILE* file;
+} out_t;
+
+/* in the order of dsr_statistics_data_t */
+static const char* _data_names[] = {
+    "rx_rreq", "tx_rreq",
+    "rx_repl", "prx_repl", "tx_repl",
+    "rx_source", "prx_source", "tx_source",
+    "rx_ack", "prx_ack", "tx_ack",
+    "rx_ackreq", "prx_ackreq", "tx_ackreq",
+    "rx_etx", "prx_etx", "tx_etx",
+    "rx_uetx", "prx_uetx", "tx_uetx",
+    "rx_rerr", "prx_rerr", "tx_rerr",
+    "rx_data", "rx_data_bytes", "prx_data", "prx_data_bytes", "tx_data", "tx_data_bytes",
+    "rx_routing", "rx_routing_bytes", "prx_routing", "prx_routing_bytes", "tx_routing", "tx_routing_bytes"
+};
+
+/* the names in the stat-%i lines of info statistics */
+static const char* _data_cli_names[] = {
+    "rx_rreq", "tx_rreq",
+    "rx_repl", "prx_repl", "tx_repl",
+    "rx_s", "prx_s", "tx_s",
+    "rx_a", "prx_a", "tx_a",
+    "rx_ar", "prx_ar", "tx_ar",
+    "rx_e", "prx_e", "tx_e",
+    "rx_ue", "prx_ue", "tx_ue",
+    "rx_err", "prx_err", "tx_err",
+    "rx_d", "rx_db", "prx_d", "prx_db", "tx_d", "tx_db",
+    "rx_r", "rx_rb", "prx_r", "prx_rb", "tx_r", "tx_rb"
+};
+
+/* in the order of dsr_statistics_emit_t, without the emit_ prefix */
+static const char* _emit_names[] = {
+    "rreq", "repl", "source", "ack", "ackreq", "etx", "uetx", "rerr",
+    "data", "data_bytes", "routing", "routing_bytes"
+};
+
+static block_t* _blocks = NULL;
+static pthread_mutex_t _blocks_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t _init_once = PTHREAD_ONCE_INIT;
+static pthread_key_t _thread_key;
+
+static __thread block_t* _block = NULL;
+
+static inline block_t* _get_block(void);
+static inline dsr_statistics_link_t* _get_link_data(block_t* block, const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]);
+static dsr_statistics_link_t* _new_link_data(block_t* block, const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]);
+static void _write(out_t* out, int format, int header);
 
 int statistics_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, dessert_meshif_t* iface, dessert_frameid_t id) {
+    block_t* block = _get_block();
     dsr_statistics_link_t* link = NULL;
     dessert_ext_t* ext = NULL;
     int promiscous = 0;
@@ -50,313 +119,531 @@ int statistics_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* pro
         promiscous = 1;
     }
 
-    _STATISTICS_LOCK;
+    link = _get_link_data(block, iface->hwaddr, msg->l2h.ether_shost);
 
-    link = _get_link_data(iface->hwaddr, msg->l2h.ether_shost);
-
-    _stat.total.rx_data_bytes += ntohs(msg->plen);
-    _stat.total.rx_routing_bytes += ntohs(msg->hlen);
-    link->data.rx_data_bytes += ntohs(msg->plen);
-    link->data.rx_routing_bytes += ntohs(msg->hlen);
+    _COUNT(rx_data_bytes, ntohs(msg->plen));
+    _COUNT(rx_routing_bytes, ntohs(msg->hlen));
 
     if(dessert_msg_getext(msg, &ext, DESSERT_EXT_ETH, 0) > 0) {
-        _stat.total.rx_data++;
-        link->data.rx_data++;
+        _COUNT(rx_data, 1);
     }
     else {
-        _stat.total.rx_routing++;
-        link->data.rx_routing++;
+        _COUNT(rx_routing, 1);
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_RREQ, 0) > 0) {
-        _stat.total.rx_rreq++;
-        link->data.rx_rreq++;
+        _COUNT(rx_rreq, 1);
     }
 
-    if(dessert_msg_getext(msg, &ext, DSR_EXT_SOURCE, 0) > 0) {
-        _stat.total.rx_source++;
-        link->data.rx_source++;
+    if(dessert_msg_getext(msg, &ext, DSR_EXT_SOURCE, 0) > 0 || dessert_msg_getext(msg, &ext, DSR_EXT_COMPACT_SOURCE, 0) > 0) {
+        _COUNT(rx_source, 1);
 
         if(promiscous) {
-            _stat.total.prx_source++;
-            link->data.prx_source++;
+            _COUNT(prx_source, 1);
         }
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_REPL, 0) > 0) {
-        _stat.total.rx_repl++;
-        link->data.rx_repl++;
+        _COUNT(rx_repl, 1);
 
         if(promiscous) {
-            _stat.total.prx_repl++;
-            link->data.prx_repl++;
+            _COUNT(prx_repl, 1);
         }
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_RERR, 0) > 0) {
-        _stat.total.rx_rerr++;
-        link->data.rx_rerr++;
+        _COUNT(rx_rerr, 1);
 
         if(promiscous) {
-            _stat.total.prx_rerr++;
-            link->data.prx_rerr++;
+            _COUNT(prx_rerr, 1);
         }
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_ACK, 0) > 0) {
-        _stat.total.rx_ack++;
-        link->data.rx_ack++;
+        _COUNT(rx_ack, 1);
 
         if(promiscous) {
-            _stat.total.prx_ack++;
-            link->data.prx_ack++;
+            _COUNT(prx_ack, 1);
         }
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_ACKREQ, 0) > 0) {
-        _stat.total.rx_ackreq++;
-        link->data.rx_ackreq++;
+        _COUNT(rx_ackreq, 1);
 
         if(promiscous) {
-            _stat.total.prx_ackreq++;
-            link->data.prx_ackreq++;
+            _COUNT(prx_ackreq, 1);
         }
     }
 
 
-#if (METRIC == ETX)
-    else if(dessert_msg_getext(msg, &ext, DSR_EXT_ETX, 0) > 0) {
-        _stat.total.rx_etx++;
-        link->data.rx_etx++;
+    else if(METRIC == ETX && dessert_msg_getext(msg, &ext, DSR_EXT_ETX, 0) > 0) {
+        _COUNT(rx_etx, 1);
 
         if(promiscous) {
-            _stat.total.prx_etx++;
-            link->data.prx_etx++;
+            _COUNT(prx_etx, 1);
         }
     }
-    else if(dessert_msg_getext(msg, &ext, DSR_EXT_UNICAST_ETX, 0) > 0) {
-        _stat.total.rx_uetx++;
-        link->data.rx_uetx++;
+    else if(METRIC == ETX && dessert_msg_getext(msg, &ext, DSR_EXT_UNICAST_ETX, 0) > 0) {
+        _COUNT(rx_uetx, 1);
 
         if(promiscous) {
-            _stat.total.prx_uetx++;
-            link->data.prx_uetx++;
+            _COUNT(prx_uetx, 1);
         }
     }
 
-#endif
-
-    _STATISTICS_UNLOCK;
-
     return DESSERT_MSG_KEEP;
 }
 
 inline void dsr_statistics_emit_msg(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN], dessert_msg_t* msg) {
+    block_t* block = _get_block();
     dessert_ext_t* ext = NULL;
 
-    _STATISTICS_LOCK;
-
-    _stat.emit_data_bytes += ntohs(msg->plen);
-    _stat.emit_routing_bytes += ntohs(msg->hlen);
+    _ADD(block->emit.emit_data_bytes, ntohs(msg->plen));
+    _ADD(block->emit.emit_routing_bytes, ntohs(msg->hlen));
 
     if(dessert_msg_getext(msg, &ext, DESSERT_EXT_ETH, 0) > 0) {
-        _stat.emit_data++;
+        _ADD(block->emit.emit_data, 1);
     }
     else {
-        _stat.emit_routing++;
+        _ADD(block->emit.emit_routing, 1);
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_RREQ, 0) > 0) {
-        _stat.emit_rreq++;
+        _ADD(block->emit.emit_rreq, 1);
     }
 
-    if(dessert_msg_getext(msg, &ext, DSR_EXT_SOURCE, 0) > 0) {
-        _stat.emit_source++;
+    if(dessert_msg_getext(msg, &ext, DSR_EXT_SOURCE, 0) > 0 || dessert_msg_getext(msg, &ext, DSR_EXT_COMPACT_SOURCE, 0) > 0) {
+        _ADD(block->emit.emit_source, 1);
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_REPL, 0) > 0) {
-        _stat.emit_repl++;
+        _ADD(block->emit.emit_repl, 1);
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_RERR, 0) > 0) {
-        _stat.emit_rerr++;
+        _ADD(block->emit.emit_rerr, 1);
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_ACK, 0) > 0) {
-        _stat.emit_ack++;
+        _ADD(block->emit.emit_ack, 1);
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_ACKREQ, 0) > 0) {
-        _stat.emit_ackreq++;
+        _ADD(block->emit.emit_ackreq, 1);
     }
 
 
-#if (METRIC == ETX)
-    else if(dessert_msg_getext(msg, &ext, DSR_EXT_ETX, 0) > 0) {
-        _stat.emit_etx++;
+    else if(METRIC == ETX && dessert_msg_getext(msg, &ext, DSR_EXT_ETX, 0) > 0) {
+        _ADD(block->emit.emit_etx, 1);
     }
-    else if(dessert_msg_getext(msg, &ext, DSR_EXT_UNICAST_ETX, 0) > 0) {
-        _stat.emit_uetx++;
+    else if(METRIC == ETX && dessert_msg_getext(msg, &ext, DSR_EXT_UNICAST_ETX, 0) > 0) {
+        _ADD(block->emit.emit_uetx, 1);
     }
 
-#endif
-
-    _STATISTICS_UNLOCK;
-
     dsr_statistics_tx_msg(local, remote, msg);
 }
 
 inline void dsr_statistics_tx_msg(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN], dessert_msg_t* msg) {
+    block_t* block = _get_block();
     dsr_statistics_link_t* link = NULL;
     dessert_ext_t* ext = NULL;
 
-    _STATISTICS_LOCK;
+    link = _get_link_data(block, local, remote);
 
-    link = _get_link_data(local, remote);
-
-    _stat.total.tx_data_bytes += ntohs(msg->plen);
-    _stat.total.tx_routing_bytes += ntohs(msg->hlen);
-    link->data.tx_data_bytes += ntohs(msg->plen);
-    link->data.tx_routing_bytes += ntohs(msg->hlen);
+    _COUNT(tx_data_bytes, ntohs(msg->plen));
+    _COUNT(tx_routing_bytes, ntohs(msg->hlen));
 
     if(dessert_msg_getext(msg, &ext, DESSERT_EXT_ETH, 0) > 0) {
-        _stat.total.tx_data++;
-        link->data.tx_data++;
+        _COUNT(tx_data, 1);
     }
     else {
-        _stat.total.tx_routing++;
-        link->data.tx_routing++;
+        _COUNT(tx_routing, 1);
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_RREQ, 0) > 0) {
-        _stat.total.tx_rreq++;
-        link->data.tx_rreq++;
+        _COUNT(tx_rreq, 1);
     }
 
-    if(dessert_msg_getext(msg, &ext, DSR_EXT_SOURCE, 0) > 0) {
-        _stat.total.tx_source++;
-        link->data.tx_source++;
+    if(dessert_msg_getext(msg, &ext, DSR_EXT_SOURCE, 0) > 0 || dessert_msg_getext(msg, &ext, DSR_EXT_COMPACT_SOURCE, 0) > 0) {
+        _COUNT(tx_source, 1);
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_REPL, 0) > 0) {
-        _stat.total.tx_repl++;
-        link->data.tx_repl++;
+        _COUNT(tx_repl, 1);
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_RERR, 0) > 0) {
-        _stat.total.tx_rerr++;
-        link->data.tx_rerr++;
+        _COUNT(tx_rerr, 1);
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_ACK, 0) > 0) {
-        _stat.total.tx_ack++;
-        link->data.tx_ack++;
+        _COUNT(tx_ack, 1);
     }
 
     if(dessert_msg_getext(msg, &ext, DSR_EXT_ACKREQ, 0) > 0) {
-        _stat.total.tx_ackreq++;
-        link->data.tx_ackreq++;
+        _COUNT(tx_ackreq, 1);
     }
 
-#if (METRIC == ETX)
-    else if(dessert_msg_getext(msg, &ext, DSR_EXT_ETX, 0) > 0) {
-        _stat.total.tx_etx++;
-        link->data.tx_etx++;
+    else if(METRIC == ETX && dessert_msg_getext(msg, &ext, DSR_EXT_ETX, 0) > 0) {
+        _COUNT(tx_etx, 1);
     }
-    else if(dessert_msg_getext(msg, &ext, DSR_EXT_UNICAST_ETX, 0) > 0) {
-        _stat.total.tx_uetx++;
-        link->data.tx_uetx++;
+    else if(METRIC == ETX && dessert_msg_getext(msg, &ext, DSR_EXT_UNICAST_ETX, 0) > 0) {
+        _COUNT(tx_uetx, 1);
     }
+}
 
-#endif
+static inline void _sum(uint64_t* dst, uint64_t* src, size_t n) {
+    size_t i;
 
-    _STATISTICS_UNLOCK;
+    for(i = 0; i < n; i++) {
+        dst[i] += __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
 }
 
-int dessert_cli_cmd_showstatistics(struct cli_def* cli, char* command, char* argv[], int argc) {
-    dsr_statistics_link_t* link = NULL;
+/** sums up the counters of all threads into @a stat, free it with dsr_statistics_free */
+void dsr_statistics_get(dsr_statistics_t* stat) {
+    block_t* block;
+    uint32_t i;
+
+    memset(stat, 0, sizeof(dsr_statistics_t));
+
+    pthread_mutex_lock(&_blocks_mutex);
+
+    LL_FOREACH(_blocks, block) {
+        _sum((uint64_t*) &stat->emit, (uint64_t*) &block->emit, _EMIT_COUNTERS);
+        _sum((uint64_t*) &stat->total, (uint64_t*) &block->total, _DATA_COUNTERS);
+
+        pthread_mutex_lock(&block->mutex);
+
+        for(i = 0; i < block->size; i++) {
+            dsr_statistics_link_t* link = block->links[i];
+            dsr_statistics_link_t* sum = NULL;
+
+            if(link == NULL) {
+                continue;
+            }
+
+            HASH_FIND(hh, stat->nodes, link->local, sizeof(dsr_statistics_link_lookup_key_t), sum);
+
+            if(sum == NULL) {
+                sum = calloc(1, sizeof(dsr_statistics_link_t));
+                assert(sum != NULL);
+                ADDR_CPY(sum->local, link->local);
+                ADDR_CPY(sum->remote, link->remote);
+                HASH_ADD(hh, stat->nodes, local, sizeof(dsr_statistics_link_lookup_key_t), sum);
+            }
+
+            _sum((uint64_t*) &sum->data, (uint64_t*) &link->data, _DATA_COUNTERS);
+        }
+
+        pthread_mutex_unlock(&block->mutex);
+    }
+
+    pthread_mutex_unlock(&_blocks_mutex);
+}
+
+void dsr_statistics_free(dsr_statistics_t* stat) {
+    dsr_statistics_link_t* link;
+    dsr_statistics_link_t* tmp;
+
+    HASH_ITER(hh, stat->nodes, link, tmp) {
+        HASH_DEL(stat->nodes, link);
+        free(link);
+    }
+}
+
+/** appends the statistics to @a file, with a header line if the file is new or empty (CSV) */
+int dsr_statistics_export(const char* file, int format) {
+    out_t out = { NULL, NULL };
 
-    _STATISTICS_LOCK;
-    cli_print(cli, "emit [" MAC "] [" MAC "] "
-              "rreq[%i] repl[%i] source[%i] ack[%i] ackreq[%i] etx[%i] uetx[%i] "
-              "rerr[%i] data[%i] data_bytes[%i] routing[%i] routing_bytes[%i]",
-              EXPLODE_ARRAY6(dessert_l25_defsrc), EXPLODE_ARRAY6(ether_null), _stat.emit_rreq, _stat.emit_repl,
-              _stat.emit_source, _stat.emit_ack, _stat.emit_ackreq,
-              _stat.emit_etx, _stat.emit_uetx, _stat.emit_rerr, _stat.emit_data,
-              _stat.emit_data_bytes, _stat.emit_routing, _stat.emit_routing_bytes);
+    out.file = fopen(file, "a");
 
-    /* print the total*/
-    _print_link_statistics_to_cli(cli, dessert_l25_defsrc, ether_null, _stat.total);
+    if(out.file == NULL) {
+        dessert_warn("could not open statistics export file %s", file);
+        return -1;
+    }
+
+    fseek(out.file, 0, SEEK_END);
+    _write(&out, format, (ftell(out.file) == 0));
+    fclose(out.file);
+
+    return 0;
+}
+
+/** exports to the file set with set statistics_export */
+dessert_per_result_t dsr_statistics_export_periodic(void* data, struct timeval* scheduled, struct timeval* interval) {
+    char file[DSR_CONF_STATISTICS_EXPORT_FILE_LEN];
+    int format = dsr_conf_get_statistics_export(file);
 
-    HASH_FOREACH(hh, _stat.nodes, link) {
-        _print_link_statistics_to_cli(cli, link->local, link->remote, link->data);
+    if(format >= 0) {
+        dsr_statistics_export(file, format);
     }
 
-    _STATISTICS_UNLOCK;
+    return DESSERT_PER_KEEP;
+}
+
+/** CLI command - exec mode - info statistics [csv|json] */
+int dessert_cli_cmd_showstatistics(struct cli_def* cli, char* command, char* argv[], int argc) {
+    out_t out = { cli, NULL };
+
+    if(argc == 0) {
+        _write(&out, DSR_STATISTICS_FORMAT_CLI, 0);
+    }
+    else if(argc == 1 && strcmp(argv[0], "csv") == 0) {
+        _write(&out, DSR_STATISTICS_FORMAT_CSV, 1);
+    }
+    else if(argc == 1 && strcmp(argv[0], "json") == 0) {
+        _write(&out, DSR_STATISTICS_FORMAT_JSON, 0);
+    }
+    else {
+        cli_print(cli, "usage %s [csv|json]\n", command);
+        return CLI_ERROR;
+    }
 
     return CLI_OK;
 }
 
-static void _print_link_statistics_to_cli(struct cli_def* cli, uint8_t local[ETHER_ADDR_LEN], uint8_t remote[ETHER_ADDR_LEN], dsr_statistics_data_t data) {
-    int total = 0;
-
-    if(ADDR_CMP(remote, ether_null) == 0) {
-        total = 1;
-    }
-
-    cli_print(cli, "stat-%i [" MAC "] [" MAC "] "
-        "rx_rreq[%i] tx_rreq[%i] rx_repl[%i] prx_repl[%i] tx_repl[%i] rx_s[%i] "
-        "prx_s[%i] tx_s[%i] rx_a[%i] prx_a[%i] tx_a[%i] rx_ar[%i] "
-        "prx_ar[%i] tx_ar[%i] rx_e[%i] prx_e[%i] tx_e[%i] rx_ue[%i] "
-        "prx_ue[%i] tx_ue[%i] rx_err[%i] prx_err[%i] tx_err[%i] rx_d[%i] "
-        "rx_db[%i] prx_d[%i] prx_db[%i] tx_d[%i] tx_db[%i] rx_r[%i] "
-        "rx_rb[%i] prx_r[%i] prx_rb[%i] tx_r[%i] tx_rb[%i]",
-        total, local[0], local[1], local[2], local[3], local[4], local[5],
-        remote[0], remote[1], remote[2], remote[3], remote[4], remote[5],
-        data.rx_rreq, data.tx_rreq, data.rx_repl, data.prx_repl, data.tx_repl, data.rx_source,
-        data.prx_source, data.tx_source, data.rx_ack, data.prx_ack, data.tx_ack, data.rx_ackreq,
-        data.prx_ackreq, data.tx_ackreq, data.rx_etx, data.prx_etx, data.tx_etx, data.rx_uetx,
-        data.prx_uetx, data.tx_uetx, data.rx_rerr, data.prx_rerr, data.tx_rerr, data.rx_data,
-        data.rx_data_bytes, data.prx_data, data.prx_data_bytes, data.tx_data, data.tx_data_bytes, data.rx_routing,
-        data.rx_routing_bytes, data.prx_routing, data.prx_routing_bytes, data.tx_routing, data.tx_routing_bytes);
+static void _append(char* line, size_t* len, const char* format, ...) {
+    va_list args;
+    int n;
+
+    if(*len >= _LINE_LEN) {
+        return;
+    }
+
+    va_start(args, format);
+    n = vsnprintf(line + *len, _LINE_LEN - *len, format, args);
+    va_end(args);
+
+    if(n > 0) {
+        *len += n;
+    }
 }
 
+static void _out(out_t* out, const char* line) {
+    if(out->cli != NULL) {
+        cli_print(out->cli, "%s", line);
+    }
+    else {
+        fprintf(out->file, "%s\n", line);
+    }
+}
 
-static inline dsr_statistics_link_t* _get_link_data(
-    const uint8_t local[ETHER_ADDR_LEN],
-    const uint8_t remote[ETHER_ADDR_LEN]) {
+/** one line per link; the emit counters go with the total, whose remote address is all zero */
+static void _write_link(out_t* out, int format, const char* now, uint8_t local[ETHER_ADDR_LEN], uint8_t remote[ETHER_ADDR_LEN], dsr_statistics_data_t* data, dsr_statistics_emit_t* emit) {
+    uint64_t* d = (uint64_t*) data;
+    uint64_t* e = (uint64_t*) emit;
+    char line[_LINE_LEN];
+    size_t len = 0;
+    size_t i;
+
+    if(format == DSR_STATISTICS_FORMAT_CLI) {
+        if(emit != NULL) {
+            _append(line, &len, "emit [" MAC "] [" MAC "]", EXPLODE_ARRAY6(local), EXPLODE_ARRAY6(remote));
+
+            for(i = 0; i < _EMIT_COUNTERS; i++) {
+                _append(line, &len, " %s[%" PRIu64 "]", _emit_names[i], e[i]);
+            }
+
+            _out(out, line);
+            len = 0;
+        }
 
-    dsr_statistics_link_t* data = NULL;
-    dsr_statistics_link_lookup_key_t lookupkey;
+        _append(line, &len, "stat-%i [" MAC "] [" MAC "]", (emit != NULL), EXPLODE_ARRAY6(local), EXPLODE_ARRAY6(remote));
 
-    ADDR_CPY(lookupkey.local, local);
-    ADDR_CPY(lookupkey.remote, remote);
+        for(i = 0; i < _DATA_COUNTERS; i++) {
+            _append(line, &len, " %s[%" PRIu64 "]", _data_cli_names[i], d[i]);
+        }
+    }
+    else if(format == DSR_STATISTICS_FORMAT_CSV) {
+        _append(line, &len, "%s," MAC "," MAC, now, EXPLODE_ARRAY6(local), EXPLODE_ARRAY6(remote));
 
-    HASH_FIND(hh, _stat.nodes, &lookupkey, sizeof(dsr_statistics_link_lookup_key_t), data);
+        for(i = 0; i < _DATA_COUNTERS; i++) {
+            _append(line, &len, ",%" PRIu64, d[i]);
+        }
 
-    if(data == NULL) {
-        data = _new_link_data(local, remote);
+        for(i = 0; i < _EMIT_COUNTERS; i++) {
+            if(emit != NULL) {
+                _append(line, &len, ",%" PRIu64, e[i]);
+            }
+            else {
+                _append(line, &len, ",");
+            }
+        }
     }
     else {
+        _append(line, &len, "{\"time\":%s,\"local\":\"" MAC "\",\"remote\":\"" MAC "\"", now, EXPLODE_ARRAY6(local), EXPLODE_ARRAY6(remote));
+
+        for(i = 0; i < _DATA_COUNTERS; i++) {
+            _append(line, &len, ",\"%s\":%" PRIu64, _data_names[i], d[i]);
+        }
+
+        for(i = 0; emit != NULL && i < _EMIT_COUNTERS; i++) {
+            _append(line, &len, ",\"emit_%s\":%" PRIu64, _emit_names[i], e[i]);
+        }
+
+        _append(line, &len, "}");
+    }
+
+    _out(out, line);
+}
+
+/** writes all statistics in @a format, CSV starting with a header line if @a header is set */
+static void _write(out_t* out, int format, int header) {
+    dsr_statistics_t stat;
+    dsr_statistics_link_t* link = NULL;
+    struct timeval tv;
+    char now[32];
+
+    gettimeofday(&tv, NULL);
+    snprintf(now, sizeof(now), "%ld.%03ld", (long) tv.tv_sec, (long) tv.tv_usec / 1000);
+
+    if(format == DSR_STATISTICS_FORMAT_CSV && header) {
+        char line[_LINE_LEN];
+        size_t len = 0;
+        size_t i;
+
+        _append(line, &len, "time,local,remote");
+
+        for(i = 0; i < _DATA_COUNTERS; i++) {
+            _append(line, &len, ",%s", _data_names[i]);
+        }
+
+        for(i = 0; i < _EMIT_COUNTERS; i++) {
+            _append(line, &len, ",emit_%s", _emit_names[i]);
+        }
+
+        _out(out, line);
+    }
+
+    dsr_statistics_get(&stat);
+
+    /* the total */
+    _write_link(out, format, now, dessert_l25_defsrc, ether_null, &stat.total, &stat.emit);
+
+    HASH_FOREACH(hh, stat.nodes, link) {
+        _write_link(out, format, now, link->local, link->remote, &link->data, NULL);
+    }
+
+    dsr_statistics_free(&stat);
+}
+
+static void _thread_exit(void* data) {
+    block_t* block = data;
+
+    pthread_mutex_lock(&_blocks_mutex);
+    block->active = 0;
+    pthread_mutex_unlock(&_blocks_mutex);
+}
+
+static void _init(void) {
+    pthread_key_create(&_thread_key, _thread_exit);
+}
+
+/* takes over the block of a thread that has exited or adds a new one; the
+ * key destructor hands the block back when the thread exits */
+static block_t* _register_thread(void) {
+    block_t* block;
+
+    pthread_once(&_init_once, _init);
+
+    pthread_mutex_lock(&_blocks_mutex);
+
+    LL_FOREACH(_blocks, block) {
+        if(!block->active) {
+            break;
+        }
+    }
+
+    if(block == NULL) {
+        block = calloc(1, sizeof(block_t));
+        assert(block != NULL);
+        pthread_mutex_init(&block->mutex, NULL);
+        LL_PREPEND(_blocks, block);
     }
 
-    return data;
+    block->active = 1;
+    pthread_mutex_unlock(&_blocks_mutex);
+
+    pthread_setspecific(_thread_key, block);
+    _block = block;
+
+    return block;
 }
 
-static inline dsr_statistics_link_t* _new_link_data(
+static inline block_t* _get_block(void) {
+    if(unlikely(_block == NULL)) {
+        return _register_thread();
+    }
+
+    return _block;
+}
+
+/* only called by the owner of the block, which is the only one changing its links */
+static inline dsr_statistics_link_t* _get_link_data(
+    block_t* block,
     const uint8_t local[ETHER_ADDR_LEN],
     const uint8_t remote[ETHER_ADDR_LEN]) {
 
-    dsr_statistics_link_t* data = NULL;
+    dsr_statistics_link_t* link;
+    uint32_t mask = block->size - 1;
+    uint32_t i;
+
+    if(likely(block->size != 0)) {
+        for(i = ADDR_PAIR_HASH(local, remote) & mask; (link = block->links[i]) != NULL; i = (i + 1) & mask) {
+            if(ADDR_CMP(link->remote, remote) == 0 && ADDR_CMP(link->local, local) == 0) {
+                return link;
+            }
+        }
+    }
+
+    return _new_link_data(block, local, remote);
+}
+
+static dsr_statistics_link_t* _new_link_data(
+    block_t* block,
+    const uint8_t local[ETHER_ADDR_LEN],
+    const uint8_t remote[ETHER_ADDR_LEN]) {
+
+    dsr_statistics_link_t* link = NULL;
+    uint32_t i;
+
+    link = calloc(1, sizeof(dsr_statistics_link_t));
+    assert(link != NULL);
+
+    ADDR_CPY(link->local, local);
+    ADDR_CPY(link->remote, remote);
+
+    pthread_mutex_lock(&block->mutex);
+
+    /* keep the table at most half full */
+    if(2 * (block->len + 1) > block->size) {
+        dsr_statistics_link_t** old = block->links;
+        uint32_t old_size = block->size;
+
+        block->size = old_size ? 2 * old_size : 16;
+        block->links = calloc(block->size, sizeof(dsr_statistics_link_t*));
+        assert(block->links != NULL);
+
+        for(i = 0; i < old_size; i++) {
+            if(old[i] != NULL) {
+                uint32_t j;
+
+                for(j = ADDR_PAIR_HASH(old[i]->local, old[i]->remote) & (block->size - 1); block->links[j] != NULL; j = (j + 1) & (block->size - 1));
+
+                block->links[j] = old[i];
+            }
+        }
+
+        free(old);
+    }
 
-    data = malloc(sizeof(dsr_statistics_link_t));
-    assert(data != NULL);
+    for(i = ADDR_PAIR_HASH(local, remote) & (block->size - 1); block->links[i] != NULL; i = (i + 1) & (block->size - 1));
 
-    ADDR_CPY(data->local, local);
-    ADDR_CPY(data->remote, remote);
-    memset(&(data->data), 0, sizeof(dsr_statistics_data_t));
+    block->links[i] = link;
+    block->len++;
 
-    HASH_ADD(hh, _stat.nodes, local, sizeof(dsr_statistics_link_lookup_key_t), data);
+    pthread_mutex_unlock(&block->mutex);
 
-    return data;
+    return link;
 }
@@ -28,80 +28,90 @@
 #ifndef STATISTICS_H_
 #define STATISTICS_H_
 
+#define DSR_STATISTICS_FORMAT_CLI  0 /* the stat-%i lines of info statistics */
+#define DSR_STATISTICS_FORMAT_CSV  1
+#define DSR_STATISTICS_FORMAT_JSON 2 /* one object per line */
+
+/* all counters are uint64_t, in the order of the names in statistics.c */
 typedef struct dsr_statistics_data {
 
-    int rx_rreq;
-    int tx_rreq;
+    uint64_t rx_rreq;
+    uint64_t tx_rreq;
 
-    int rx_repl;
-    int prx_repl;
-    int tx_repl;
+    uint64_t rx_repl;
+    uint64_t prx_repl;
+    uint64_t tx_repl;
 
-    int rx_source;
-    int prx_source;
-    int tx_source;
+    uint64_t rx_source;
+    uint64_t prx_source;
+    uint64_t tx_source;
 
-    int rx_ack;
-    int prx_ack;
-    int tx_ack;
+    uint64_t rx_ack;
+    uint64_t prx_ack;
+    uint64_t tx_ack;
 
-    int rx_ackreq;
-    int prx_ackreq;
-    int tx_ackreq;
+    uint64_t rx_ackreq;
+    uint64_t prx_ackreq;
+    uint64_t tx_ackreq;
 
-    int rx_etx;
-    int prx_etx;
-    int tx_etx;
+    uint64_t rx_etx;
+    uint64_t prx_etx;
+    uint64_t tx_etx;
 
-    int rx_uetx;
-    int prx_uetx;
-    int tx_uetx;
+    uint64_t rx_uetx;
+    uint64_t prx_uetx;
+    uint64_t tx_uetx;
 
-    int rx_rerr;
-    int prx_rerr;
-    int tx_rerr;
+    uint64_t rx_rerr;
+    uint64_t prx_rerr;
+    uint64_t tx_rerr;
 
-    int rx_data;
-    int rx_data_bytes;
-    int prx_data;
-    int prx_data_bytes;
-    int tx_data;
-    int tx_data_bytes;
+    uint64_t rx_data;
+    uint64_t rx_data_bytes;
+    uint64_t prx_data;
+    uint64_t prx_data_bytes;
+    uint64_t tx_data;
+    uint64_t tx_data_bytes;
 
-    int rx_routing;
-    int rx_routing_bytes;
-    int prx_routing;
-    int prx_routing_bytes;
-    int tx_routing;
-    int tx_routing_bytes;
+    uint64_t rx_routing;
+    uint64_t rx_routing_bytes;
+    uint64_t prx_routing;
+    uint64_t prx_routing_bytes;
+    uint64_t tx_routing;
+    uint64_t tx_routing_bytes;
 
 } dsr_statistics_data_t ;
 
+typedef struct dsr_statistics_emit {
+    uint64_t emit_rreq;
+    uint64_t emit_repl;
+    uint64_t emit_source;
+    uint64_t emit_ack;
+    uint64_t emit_ackreq;
+    uint64_t emit_etx;
+    uint64_t emit_uetx;
+    uint64_t emit_rerr;
+    uint64_t emit_data;
+    uint64_t emit_data_bytes;
+    uint64_t emit_routing;
+    uint64_t emit_routing_bytes;
+} dsr_statistics_emit_t;
+
 typedef struct __attribute__((__packed__)) dsr_statistics_link_lookup_key {
     uint8_t local[ETHER_ADDR_LEN];   /* key: part 1 */
     uint8_t remote[ETHER_ADDR_LEN]; /* key: part 2 */
 } dsr_statistics_link_lookup_key_t;
 
-typedef struct __attribute__((__packed__)) dsr_statistics_link {
+typedef struct dsr_statistics_link {
     uint8_t local[ETHER_ADDR_LEN];
     uint8_t remote[ETHER_ADDR_LEN];
     dsr_statistics_data_t data;
-    UT_hash_handle hh;
+    UT_hash_handle hh; /* only used in a dsr_statistics_t */
 } dsr_statistics_link_t;
 
+/** The counters of all threads summed up, see dsr_statistics_get. */
 typedef struct dsr_statistics {
-    int emit_rreq;
-    int emit_repl;
-    int emit_source;
-    int emit_ack;
-    int emit_ackreq;
-    int emit_etx;
-    int emit_uetx;
-    int emit_rerr;
-    int emit_data;
-    int emit_data_bytes;
-    int emit_routing;
-    int emit_routing_bytes;
+    dsr_statistics_emit_t emit;
     dsr_statistics_data_t total;
     dsr_statistics_link_t* nodes;
 } dsr_statistics_t;
@@ -110,6 +120,12 @@ int statistics_meshrx_cb(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* pro
 
 inline void dsr_statistics_emit_msg(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN], dessert_msg_t* msg);
 inline void dsr_statistics_tx_msg(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN], dessert_msg_t* msg);
+
+void dsr_statistics_get(dsr_statistics_t* stat);
+void dsr_statistics_free(dsr_statistics_t* stat);
+int dsr_statistics_export(const char* file, int format);
+dessert_per_result_t dsr_statistics_export_periodic(void* data, struct timeval* scheduled, struct timeval* interval);
+
 int dessert_cli_cmd_showstatistics(struct cli_def* cli, char* command, char* argv[], int argc);
 
 #endif /* STATISTICS_H_ */
@@ -0,0 +1,235 @@
+#include "../dsr.h"
+#include <string.h>
+#include <time.h>
+
+/*
+ * Multi-threaded alloc/free benchmark of the message buffer cache.
+ *
+ * usage: alloccache-bench [threads] [ops per thread]
+ *
+ * Compares plain malloc, the former single mutex freelist (copied below)
+ * and dsr_alloc_cache_alloc in two patterns:
+ *  burst   every thread allocates BURST buffers and frees them again
+ *  handoff threads work in pairs, one allocates and the other one frees,
+ *          like messages queued by the rx threads and sent by a periodic
+ */
+
+#define BURST 16
+#define RING_SIZE 256
+#define MSG_SIZE CHUNK_SIZE
+
+/******************************************************************************
+ * the former alloc_cache: one freelist behind one mutex
+ ******************************************************************************/
+#define OLD_CACHE_SIZE 500
+
+typedef struct old_el {
+    struct old_el* next;
+} old_el_t;
+
+static pthread_mutex_t old_mutex = PTHREAD_MUTEX_INITIALIZER;
+static old_el_t* old_head = NULL;
+static int old_len = 0;
+
+static void* old_alloc(size_t size) {
+    void* ptr;
+
+    pthread_mutex_lock(&old_mutex);
+
+    if(old_len == 0) {
+        ptr = malloc(CHUNK_SIZE);
+    }
+    else {
+        ptr = old_head;
+        old_head = old_head->next;
+        old_len--;
+    }
+
+    pthread_mutex_unlock(&old_mutex);
+    return ptr;
+}
+
+static void old_free(void* ptr) {
+    pthread_mutex_lock(&old_mutex);
+
+    if(old_len >= OLD_CACHE_SIZE) {
+        free(ptr);
+    }
+    else {
+        ((old_el_t*) ptr)->next = old_head;
+        old_head = ptr;
+        old_len++;
+    }
+
+    pthread_mutex_unlock(&old_mutex);
+}
+
+/******************************************************************************
+ * benchmark
+ ******************************************************************************/
+typedef struct allocator {
+    const char* name;
+    void* (*alloc)(size_t size);
+    void (*free)(void* ptr);
+} allocator_t;
+
+static allocator_t allocators[] = {
+    { "malloc", malloc, free },
+    { "old cache", old_alloc, old_free },
+    { "alloc_cache", dsr_alloc_cache_alloc, dsr_alloc_cache_free },
+};
+
+/* single producer single consumer ring between the threads of a pair */
+typedef struct ring {
+    void* slot[RING_SIZE];
+    volatile unsigned int head;
+    volatile unsigned int tail;
+} ring_t;
+
+typedef struct worker {
+    pthread_t thread;
+    allocator_t* a;
+    ring_t* ring;
+    long ops;
+} worker_t;
+
+static void* burst_worker(void* data) {
+    worker_t* w = data;
+    void* buf[BURST];
+    long n;
+    int i;
+
+    for(n = 0; n < w->ops; n += BURST) {
+        for(i = 0; i < BURST; i++) {
+            buf[i] = w->a->alloc(MSG_SIZE);
+            *(volatile char*) buf[i] = 0;
+        }
+
+        for(i = 0; i < BURST; i++) {
+            w->a->free(buf[i]);
+        }
+    }
+
+    return NULL;
+}
+
+static void* producer_worker(void* data) {
+    worker_t* w = data;
+    ring_t* r = w->ring;
+    long n;
+
+    for(n = 0; n < w->ops; n++) {
+        void* ptr = w->a->alloc(MSG_SIZE);
+        *(volatile char*) ptr = 0;
+
+        while(r->head - r->tail == RING_SIZE) {
+            sched_yield();
+        }
+
+        r->slot[r->head % RING_SIZE] = ptr;
+        __sync_synchronize();
+        r->head++;
+    }
+
+    return NULL;
+}
+
+static void* consumer_worker(void* data) {
+    worker_t* w = data;
+    ring_t* r = w->ring;
+    long n;
+
+    for(n = 0; n < w->ops; n++) {
+        void* ptr;
+
+        while(r->head == r->tail) {
+            sched_yield();
+        }
+
+        __sync_synchronize();
+        ptr = r->slot[r->tail % RING_SIZE];
+        r->tail++;
+        w->a->free(ptr);
+    }
+
+    return NULL;
+}
+
+static double now_secs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double run(allocator_t* a, int threads, long ops, int handoff) {
+    worker_t* w = calloc(threads, sizeof(worker_t));
+    ring_t* rings = calloc(threads / 2 + 1, sizeof(ring_t));
+    double start;
+    int i;
+
+    start = now_secs();
+
+    for(i = 0; i < threads; i++) {
+        void* (*fn)(void*) = burst_worker;
+        w[i].a = a;
+        w[i].ops = ops;
+
+        if(handoff) {
+            w[i].ring = &rings[i / 2];
+            fn = (i % 2) ? consumer_worker : producer_worker;
+        }
+
+        pthread_create(&w[i].thread, NULL, fn, &w[i]);
+    }
+
+    for(i = 0; i < threads; i++) {
+        pthread_join(w[i].thread, NULL);
+    }
+
+    start = now_secs() - start;
+    free(rings);
+    free(w);
+
+    /* ns per alloc/free pair */
+    return start * 1e9 / ((double) ops * (handoff ? threads / 2 : threads));
+}
+
+int main(int argc, char** argv) {
+    int threads = (argc > 1) ? atoi(argv[1]) : 4;
+    long ops = (argc > 2) ? atol(argv[2]) : 2000000;
+    dsr_alloc_cache_stats_t stats[ALLOC_CACHE_CLASSES + 1];
+    int handoff;
+    unsigned int i;
+    int t;
+
+    if(threads < 2) {
+        threads = 2;
+    }
+
+    threads &= ~1;
+
+    printf("%-8s %-8s %-12s %12s\n", "pattern", "threads", "allocator", "ns/op");
+
+    for(handoff = 0; handoff <= 1; handoff++) {
+        for(t = 1; t <= threads; t *= 2) {
+            if(handoff && t < 2) {
+                continue;
+            }
+
+            for(i = 0; i < sizeof(allocators) / sizeof(allocators[0]); i++) {
+                printf("%-8s %-8i %-12s %12.1f\n", handoff ? "handoff" : "burst", t,
+                       allocators[i].name, run(&allocators[i], t, ops, handoff));
+            }
+        }
+    }
+
+    dsr_alloc_cache_get_stats(stats);
+
+    for(t = 0; t <= ALLOC_CACHE_CLASSES; t++) {
+        printf("class[%i] size[%zu] refills[%u] returns[%u] underrun[%u] overflow[%u] depot_max[%u]\n",
+               t, stats[t].size, stats[t].refills, stats[t].returns, stats[t].underrun,
+               stats[t].overflow, stats[t].depot_max);
+    }
+
+    return 0;
+}
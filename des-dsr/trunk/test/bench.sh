@@ -0,0 +1,115 @@
+#!/bin/sh
+#
+# Builds the tests and benchmarks of test/ once with PROFILE=debug and once
+# with PROFILE=release per variant, runs them and reports the run time of
+# every benchmark and the speedup of the release build. Both builds use the
+# flags of the profile only (BENCH_CFLAGS is cleared), so debug is what a
+# make dsr daemon runs with. The tests run before the benchmarks of a build;
+# blacklist-test waits for the blacklist timeouts, about 3 minutes. The
+# output of the builds, tests and benchmarks goes to bench.log. Exits with 1
+# if a build, test or benchmark failed.
+#
+# usage: sh test/bench.sh [DAEMON values], from the directory of the Makefile
+
+MAKE=${MAKE:-make}
+VARIANTS=${*:-"0 1 2 3 4 5 6 7 8 9 10 11"}
+LOG=bench.log
+TIMES=bench.times
+
+TESTS=${TESTS-"linkcache-test linkcache2-test source-test blacklist-test pathset-test maintenance-buffer-test sendbuffer-test compact-source-test"}
+BENCHES="forward-bench alloccache-bench routecache-bench pathset-bench variant-bench rreqtable-bench etx-bench statistics-bench compact-source-bench"
+
+# the arguments of a benchmark, sized to take about a second in a debug build
+args() {
+    case $1 in
+        forward-bench)      echo "100000" ;;
+        alloccache-bench)   echo "4 200000" ;;
+        routecache-bench)   echo "2000 500" ;;
+        pathset-bench)      echo "50" ;;
+        variant-bench)      echo "500000" ;;
+        rreqtable-bench)    echo "1000 2" ;;
+        etx-bench)          echo "200 50 200" ;;
+        statistics-bench)   echo "200000 2" ;;
+        compact-source-bench) echo "20000 64 2000" ;;
+    esac
+}
+
+name() {
+    case $1 in
+        0)  echo "des-dsr-hc" ;;
+        1)  echo "des-dsr" ;;
+        2)  echo "des-dsr-etx" ;;
+        3)  echo "des-dsr-linkcache" ;;
+        4)  echo "des-dsr-linkcache-etx" ;;
+        5)  echo "des-dsr-mdsr" ;;
+        6)  echo "des-dsr-smr" ;;
+        7)  echo "des-dsr-backuppath1" ;;
+        8)  echo "des-dsr-backuppath2" ;;
+        9)  echo "des-dsr-etx-backup" ;;
+        10) echo "des-dsr-etx-lb" ;;
+        11) echo "des-dsr-multi" ;;
+        *)  echo "DAEMON=$1" ;;
+    esac
+}
+
+now() {
+    date +%s.%N
+}
+
+: > $LOG
+: > $TIMES
+failed=0
+printf "%-22s %-20s %9s %9s %8s\n" "variant" "benchmark" "debug s" "release s" "speedup"
+
+for variant in $VARIANTS; do
+    for profile in debug release; do
+        $MAKE clean >> $LOG 2>&1
+
+        if ! $MAKE PROFILE=$profile BENCH_CFLAGS= DAEMON=$variant $TESTS $BENCHES >> $LOG 2>&1; then
+            echo "$(name $variant): $profile build failed, see $LOG"
+            failed=1
+            continue
+        fi
+
+        for test in $TESTS; do
+            echo "### $(name $variant) $profile $test" >> $LOG
+
+            if ! ./$test >> $LOG 2>&1; then
+                echo "$(name $variant): $profile $test failed, see $LOG"
+                failed=1
+            fi
+        done
+
+        for bench in $BENCHES; do
+            echo "### $(name $variant) $profile $bench $(args $bench)" >> $LOG
+            start=$(now)
+
+            if ./$bench $(args $bench) >> $LOG 2>&1; then
+                status=ok
+            else
+                status=failed
+                failed=1
+            fi
+
+            echo "$variant $bench $profile $start $(now) $status" >> $TIMES
+        done
+    done
+
+    for bench in $BENCHES; do
+        awk -v variant=$variant -v bench=$bench -v name=$(name $variant) '
+            $1 == variant && $2 == bench { t[$3] = $5 - $4; if($6 != "ok") failed = failed " " $3 }
+            END {
+                if(!("debug" in t) || !("release" in t)) {
+                    printf "%-22s %-20s not built\n", name, bench
+                }
+                else {
+                    printf "%-22s %-20s %9.2f %9.2f %7.1fx%s\n", name, bench, t["debug"], t["release"],
+                           t["debug"] / t["release"], failed ? "  failed:" failed : ""
+                }
+            }' $TIMES
+    done
+done
+
+$MAKE clean >> $LOG 2>&1
+rm -f $TIMES
+exit $failed
@@ -0,0 +1,201 @@
+#include "../dsr.h"
+#include <time.h>
+
+/*
+ * Compact source route benchmark. Data msgs along random routes of a few
+ * lengths are sent with every compact_source mode: the source replaces the
+ * DSR_EXT_SOURCE (dsr_msg_compact_source_ext), the next hop decodes it
+ * (compact_source_meshrx_cb) and compacts it again as a relay. Each msg is
+ * acknowledged (dsr_compact_source_confirm) at the source and the relay as
+ * the maintenance buffer would, so a flow is sent FLOW from the batch after
+ * its first msg on. Reported per
+ * route length and mode are the bytes of the route on the wire, the saving
+ * against the DSR_EXT_SOURCE and the time to encode, decode and re-encode
+ * per msg. Every decoded route is checked against the one sent, and every
+ * re-encoded msg against the msg on the wire. At the end the ids of a number
+ * of random nodes are learned and the ambiguous ones counted.
+ *
+ * usage: compact-source-bench [msgs] [routes per length] [nodes]
+ */
+
+#define BATCH 256
+#define PAYLOAD 1000
+
+extern dsr_conf_t dsr_conf;
+
+static const int route_lens[] = { 2, 3, 5, 8, 12 };
+static const char* mode_names[] = { "off", "ids", "flows" };
+
+static void bench_addr(uint8_t addr[ETHER_ADDR_LEN], uint8_t type, uint32_t n) {
+    addr[0] = 0x02;
+    addr[1] = type;
+    addr[2] = (n >> 24) & 0xff;
+    addr[3] = (n >> 16) & 0xff;
+    addr[4] = (n >> 8) & 0xff;
+    addr[5] = n & 0xff;
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static dessert_msg_t* bench_msg(dsr_path_t* path) {
+    dessert_msg_t* msg;
+    dessert_ext_t* ext;
+    dsr_source_ext_t* source;
+
+    dessert_msg_new(&msg);
+    dessert_msg_addext(msg, &ext, DESSERT_EXT_ETH, ETHER_HDR_LEN);
+    msg->plen = htons(PAYLOAD);
+    source = dsr_msg_add_source_ext(msg, path, path->len - 2);
+    ADDR_CPY(msg->l2h.ether_dhost, dsr_source_indicated_next_hop_begin(source));
+
+    return msg;
+}
+
+/* the DSR_EXT_SOURCE of @msg is @path */
+static int bench_check(dessert_msg_t* msg, dsr_path_t* path) {
+    dessert_ext_t* ext;
+    dsr_source_ext_t* source;
+
+    if(dessert_msg_getext(msg, &ext, DSR_EXT_SOURCE, 0) < 1) {
+        return 0;
+    }
+
+    source = (dsr_source_ext_t*) ext->data;
+
+    return dsr_source_get_address_count(source) == path->len
+           && source->segments_left == path->len - 2
+           && ADDR_N_CMP(source->address, path->address, path->len) == 0;
+}
+
+int main(int argc, char** argv) {
+    int msgs = (argc > 1) ? atoi(argv[1]) : 100000;
+    int routes = (argc > 2) ? atoi(argv[2]) : 64;
+    int nodes = (argc > 3) ? atoi(argv[3]) : 2000;
+    dsr_path_t* path = calloc(routes, sizeof(dsr_path_t));
+    dessert_msg_t* msg[BATCH];
+    size_t wire_hlen[BATCH];
+    dsr_compact_source_stats_t stats;
+    dessert_msg_proc_t proc;
+    dessert_meshif_t iface;
+    uint8_t addr[ETHER_ADDR_LEN];
+    int errors = 0;
+    int l, mode, r, i, b, n;
+
+    srand(1);
+    memset(&iface, 0, sizeof(iface));
+    bench_addr(iface.hwaddr, 0, 0);
+
+    printf("%5s %-6s %11s %11s %7s %10s %10s %10s\n", "hops", "mode", "route bytes", "full bytes", "saving",
+           "encode ns", "decode ns", "relay ns");
+
+    for(l = 0; l < sizeof(route_lens) / sizeof(route_lens[0]); l++) {
+        for(r = 0; r < routes; r++) {
+            path[r].len = route_lens[l];
+            ADDR_CPY(ADDR_IDX((&path[r]), 0), iface.hwaddr);
+
+            for(i = 1; i < path[r].len; i++) {
+                bench_addr(ADDR_IDX((&path[r]), i), 1 + l, r * 16 + i);
+            }
+        }
+
+        for(mode = DSR_COMPACT_SOURCE_OFF; mode <= DSR_COMPACT_SOURCE_FLOWS; mode++) {
+            double t_encode = 0, t_decode = 0, t_relay = 0, t;
+            uint64_t route_bytes = 0, full_bytes = 0;
+
+            dsr_conf.compact_source = mode;
+
+            for(n = 0; n < msgs; n += BATCH) {
+                int batch = (msgs - n < BATCH) ? msgs - n : BATCH;
+
+                for(b = 0; b < batch; b++) {
+                    msg[b] = bench_msg(&path[(n + b) % routes]);
+                    full_bytes += ntohs(msg[b]->hlen);
+                    /* the ACK of an earlier msg of the flow */
+                    dsr_compact_source_confirm(msg[b]);
+                }
+
+                /* at the source */
+                t = bench_now();
+
+                for(b = 0; b < batch; b++) {
+                    dsr_msg_compact_source_ext(msg[b], 1);
+                }
+
+                t_encode += bench_now() - t;
+
+                for(b = 0; b < batch; b++) {
+                    wire_hlen[b] = ntohs(msg[b]->hlen);
+                    route_bytes += wire_hlen[b];
+                }
+
+                /* at the next hop */
+                memset(&proc, 0, sizeof(proc));
+                proc.lflags = DESSERT_RX_FLAG_L2_DST;
+                t = bench_now();
+
+                for(b = 0; b < batch; b++) {
+                    if(compact_source_meshrx_cb(msg[b], 0, &proc, &iface, n + b) != DESSERT_MSG_KEEP) {
+                        errors++;
+                    }
+                }
+
+                t_decode += bench_now() - t;
+
+                for(b = 0; b < batch; b++) {
+                    if(!bench_check(msg[b], &path[(n + b) % routes])) {
+                        errors++;
+                    }
+
+                    dsr_compact_source_confirm(msg[b]);
+                }
+
+                /* sent on unchanged, as a relay that does not advance the route */
+                t = bench_now();
+
+                for(b = 0; b < batch; b++) {
+                    dsr_msg_compact_source_ext(msg[b], 0);
+                }
+
+                t_relay += bench_now() - t;
+
+                for(b = 0; b < batch; b++) {
+                    if(ntohs(msg[b]->hlen) != wire_hlen[b]) {
+                        errors++;
+                    }
+
+                    dessert_msg_destroy(msg[b]);
+                }
+            }
+
+            /* without the header of the msg and the DESSERT_EXT_ETH */
+            full_bytes -= (uint64_t) msgs * (sizeof(dessert_msg_t) + DESSERT_EXTLEN + ETHER_HDR_LEN);
+            route_bytes -= (uint64_t) msgs * (sizeof(dessert_msg_t) + DESSERT_EXTLEN + ETHER_HDR_LEN);
+
+            printf("%5d %-6s %11.1f %11.1f %6.1f%% %10.1f %10.1f %10.1f\n", route_lens[l] - 1, mode_names[mode],
+                   (double) route_bytes / msgs, (double) full_bytes / msgs, 100.0 * (full_bytes - route_bytes) / full_bytes,
+                   t_encode * 1e3 / msgs, t_decode * 1e3 / msgs, t_relay * 1e3 / msgs);
+        }
+    }
+
+    dsr_compact_source_get_stats(&stats);
+    printf("sent full %" PRIu64 " ids %" PRIu64 " flow %" PRIu64 "  received full %" PRIu64 " ids %" PRIu64 " flow %" PRIu64
+           "  unknown ids %" PRIu64 " ambiguous ids %" PRIu64 " unknown flows %" PRIu64 "\n",
+           stats.sent[DSR_COMPACT_SOURCE_FORM_FULL], stats.sent[DSR_COMPACT_SOURCE_FORM_IDS], stats.sent[DSR_COMPACT_SOURCE_FORM_FLOW],
+           stats.received[DSR_COMPACT_SOURCE_FORM_FULL], stats.received[DSR_COMPACT_SOURCE_FORM_IDS], stats.received[DSR_COMPACT_SOURCE_FORM_FLOW],
+           stats.unknown_ids, stats.ambiguous_ids, stats.unknown_flows);
+
+    for(i = 0; i < nodes; i++) {
+        bench_addr(addr, 0x10, rand());
+        dsr_compact_source_learn(addr, 1);
+    }
+
+    dsr_compact_source_get_stats(&stats);
+    printf("id table: nodes %" PRIu64 "  ambiguous ids %" PRIu64 "  errors %d\n", stats.nodes, stats.ambiguous, errors);
+
+    free(path);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,320 @@
+#include "../dsr.h"
+
+/*
+ * Compact source route tests with mode FLOWS. The harness is the source
+ * (own routes start at the address of the interface) and a relay for the
+ * routes of another source S, whose msgs are built by hand; the next hop of
+ * the relay is the harness again. Checked are:
+ *  source   a route is sent FULL, then IDS until the next hop acknowledged
+ *           a msg of the flow, then FLOW and IDS every
+ *           DSR_CONFVAR_COMPACT_SOURCE_REFRESH_PACKETS msgs
+ *  missed   a relay that missed the first msg drops FLOW msgs of S and
+ *           learns the flow from the next IDS msg
+ *  relay    the relay sends a FLOW msg on as IDS until its next hop
+ *           acknowledged a msg of the flow, as FLOW after that, and as IDS
+ *           again when the route of the flow changes
+ *  full     the relay keeps the DSR_EXT_SOURCE (FULL) if the ids do not fit
+ *           into the msg or one of them is ambiguous
+ *  short    an extension shorter than its header or its ids is dropped
+ *
+ * usage: compact-source-test
+ */
+
+#define PAYLOAD 100
+
+extern dsr_conf_t dsr_conf;
+
+static int errors = 0;
+
+#define CHECK(x) do { if(!(x)) { printf("FAILED line %i: %s\n", __LINE__, #x); errors++; } } while(0)
+
+static dessert_meshif_t iface;
+static uint8_t source_s[ETHER_ADDR_LEN];
+
+static void test_addr(uint8_t addr[ETHER_ADDR_LEN], uint8_t type, uint32_t n) {
+    addr[0] = 0x02;
+    addr[1] = type;
+    addr[2] = (n >> 24) & 0xff;
+    addr[3] = (n >> 16) & 0xff;
+    addr[4] = (n >> 8) & 0xff;
+    addr[5] = n & 0xff;
+}
+
+/* [first, the harness, n, n + 1] */
+static void test_path(dsr_path_t* path, const uint8_t first[ETHER_ADDR_LEN], uint32_t n) {
+    memset(path, 0, sizeof(dsr_path_t));
+    ADDR_CPY(ADDR_IDX(path, 0), first);
+    ADDR_CPY(ADDR_IDX(path, 1), iface.hwaddr);
+    test_addr(ADDR_IDX(path, 2), 1, n);
+    test_addr(ADDR_IDX(path, 3), 1, n + 1);
+    path->len = 4;
+}
+
+static dessert_msg_t* test_data_msg(void) {
+    dessert_msg_t* msg;
+    dessert_ext_t* ext;
+
+    dessert_msg_new(&msg);
+    dessert_msg_addext(msg, &ext, DESSERT_EXT_ETH, ETHER_HDR_LEN);
+    msg->plen = htons(PAYLOAD);
+
+    return msg;
+}
+
+/* a msg of S on @path as the relay receives it, with the ids if @form is IDS */
+static dessert_msg_t* test_relay_msg(dsr_path_t* path, uint16_t flow, int form) {
+    dessert_msg_t* msg = test_data_msg();
+    dessert_ext_t* ext;
+    dsr_compact_source_ext_t* compact;
+    int i, len = (form == DSR_COMPACT_SOURCE_FORM_IDS) ? path->len - 1 : 0;
+
+    dessert_msg_addext(msg, &ext, DSR_EXT_COMPACT_SOURCE, DSR_COMPACT_SOURCE_EXTENSION_HDRLEN + len * sizeof(uint16_t));
+    compact = (dsr_compact_source_ext_t*) ext->data;
+    compact->flags = form;
+    compact->salvage = 0;
+    compact->segments_left = path->len - 3;
+    compact->len = len;
+    compact->flow = htons(flow);
+    ADDR_CPY(compact->source, ADDR_IDX(path, 0));
+
+    for(i = 0; i < len; i++) {
+        compact->id[i] = htons(dsr_compact_source_id(ADDR_IDX(path, i + 1)));
+    }
+
+    return msg;
+}
+
+static int test_receive(dessert_msg_t* msg) {
+    dessert_msg_proc_t proc;
+
+    memset(&proc, 0, sizeof(proc));
+    proc.lflags = DESSERT_RX_FLAG_L2_DST;
+
+    return compact_source_meshrx_cb(msg, 0, &proc, &iface, 0);
+}
+
+static dsr_compact_source_ext_t* test_compact(dessert_msg_t* msg) {
+    dessert_ext_t* ext;
+
+    if(dessert_msg_get_ext_count(msg, DSR_EXT_COMPACT_SOURCE) != 1) {
+        return NULL;
+    }
+
+    dessert_msg_getext(msg, &ext, DSR_EXT_COMPACT_SOURCE, 0);
+    return (dsr_compact_source_ext_t*) ext->data;
+}
+
+/* the msg carries @path in its DSR_EXT_SOURCE */
+static int test_has_path(dessert_msg_t* msg, dsr_path_t* path) {
+    dessert_ext_t* ext;
+    dsr_source_ext_t* source;
+
+    if(!dessert_msg_getext(msg, &ext, DSR_EXT_SOURCE, 0)) {
+        return 0;
+    }
+
+    source = (dsr_source_ext_t*) ext->data;
+
+    return dsr_source_get_address_count(source) == path->len
+           && ADDR_N_CMP(source->address, path->address, path->len) == 0;
+}
+
+/* received and sent on by the relay, returns the form it is sent in */
+static int test_relay(dessert_msg_t* msg, dsr_path_t* path) {
+    CHECK(test_receive(msg) == DESSERT_MSG_KEEP);
+    CHECK(test_has_path(msg, path));
+    return dsr_msg_compact_source_ext(msg, 0);
+}
+
+static void test_source(void) {
+    dsr_path_t path;
+    dessert_msg_t* msg;
+    int i;
+
+    test_path(&path, iface.hwaddr, 100);
+
+    /* the ACK of the next hop is for the msg as buffered, with the DSR_EXT_SOURCE */
+    for(i = 0; i < 2 * DSR_CONFVAR_COMPACT_SOURCE_REFRESH_PACKETS + 2; i++) {
+        int form;
+
+        msg = test_data_msg();
+        dsr_msg_add_source_ext(msg, &path, path.len - 2);
+
+        if(i == 3) {
+            dsr_compact_source_confirm(msg);
+        }
+
+        form = dsr_msg_compact_source_ext(msg, 1);
+
+        if(i == 0) {
+            CHECK(form == DSR_COMPACT_SOURCE_FORM_FULL);
+            CHECK(test_has_path(msg, &path));
+        }
+        else if(i < 3 || i % DSR_CONFVAR_COMPACT_SOURCE_REFRESH_PACKETS == 0) {
+            CHECK(form == DSR_COMPACT_SOURCE_FORM_IDS);
+        }
+        else {
+            CHECK(form == DSR_COMPACT_SOURCE_FORM_FLOW);
+        }
+
+        CHECK(test_compact(msg) != NULL && (test_compact(msg)->flags & DSR_COMPACT_SOURCE_FORM_MASK) == form);
+        CHECK(test_compact(msg) != NULL && test_compact(msg)->flow != 0);
+        dessert_msg_destroy(msg);
+    }
+}
+
+static void test_missed_and_relay(void) {
+    dsr_compact_source_stats_t before, stats;
+    dsr_compact_source_ext_t* compact;
+    dessert_msg_t* msg;
+    dsr_path_t path, changed;
+    size_t hlen;
+    int i;
+
+    test_path(&path, source_s, 200);
+    test_path(&changed, source_s, 300);
+    dsr_compact_source_learn(path.address, path.len);
+    dsr_compact_source_learn(changed.address, changed.len);
+
+    /* missed */
+    dsr_compact_source_get_stats(&before);
+    msg = test_relay_msg(&path, 7, DSR_COMPACT_SOURCE_FORM_FLOW);
+    CHECK(test_receive(msg) == DESSERT_MSG_DROP);
+    dessert_msg_destroy(msg);
+    dsr_compact_source_get_stats(&stats);
+    CHECK(stats.unknown_flows - before.unknown_flows == 1);
+
+    msg = test_relay_msg(&path, 7, DSR_COMPACT_SOURCE_FORM_IDS);
+    CHECK(test_relay(msg, &path) == DSR_COMPACT_SOURCE_FORM_IDS);
+    dessert_msg_destroy(msg);
+
+    /* relay, the next hop has not confirmed the flow yet */
+    for(i = 0; i < 2; i++) {
+        msg = test_relay_msg(&path, 7, DSR_COMPACT_SOURCE_FORM_FLOW);
+        CHECK(test_relay(msg, &path) == DSR_COMPACT_SOURCE_FORM_IDS);
+        compact = test_compact(msg);
+        CHECK(compact != NULL && (compact->flags & DSR_COMPACT_SOURCE_FORM_MASK) == DSR_COMPACT_SOURCE_FORM_IDS);
+        CHECK(compact != NULL && compact->len == path.len - 1 && ntohs(compact->flow) == 7);
+        CHECK(dessert_msg_get_ext_count(msg, DSR_EXT_SOURCE) == 0);
+
+        /* the next hop can decode it */
+        CHECK(test_receive(msg) == DESSERT_MSG_KEEP);
+        CHECK(test_has_path(msg, &path));
+        dessert_msg_destroy(msg);
+    }
+
+    /* the next hop acknowledged a msg of the flow */
+    msg = test_relay_msg(&path, 7, DSR_COMPACT_SOURCE_FORM_FLOW);
+    CHECK(test_receive(msg) == DESSERT_MSG_KEEP);
+    dsr_compact_source_confirm(msg);
+    dessert_msg_destroy(msg);
+
+    msg = test_relay_msg(&path, 7, DSR_COMPACT_SOURCE_FORM_FLOW);
+    hlen = ntohs(msg->hlen);
+    CHECK(test_relay(msg, &path) == DSR_COMPACT_SOURCE_FORM_FLOW);
+    CHECK(ntohs(msg->hlen) == hlen);
+    dessert_msg_destroy(msg);
+
+    /* the route of the flow changed */
+    msg = test_relay_msg(&changed, 7, DSR_COMPACT_SOURCE_FORM_IDS);
+    CHECK(test_relay(msg, &changed) == DSR_COMPACT_SOURCE_FORM_IDS);
+    dessert_msg_destroy(msg);
+
+    msg = test_relay_msg(&changed, 7, DSR_COMPACT_SOURCE_FORM_FLOW);
+    CHECK(test_relay(msg, &changed) == DSR_COMPACT_SOURCE_FORM_IDS);
+    dessert_msg_destroy(msg);
+}
+
+static void test_full(void) {
+    dsr_compact_source_ext_t* compact;
+    dessert_msg_t* msg;
+    dsr_path_t path;
+    uint8_t addr[ETHER_ADDR_LEN];
+    uint32_t n;
+
+    test_path(&path, source_s, 400);
+    dsr_compact_source_learn(path.address, path.len);
+    msg = test_relay_msg(&path, 8, DSR_COMPACT_SOURCE_FORM_IDS);
+    CHECK(test_relay(msg, &path) == DSR_COMPACT_SOURCE_FORM_IDS);
+    dessert_msg_destroy(msg);
+
+    /* no room for the ids */
+    msg = test_relay_msg(&path, 8, DSR_COMPACT_SOURCE_FORM_FLOW);
+    CHECK(test_receive(msg) == DESSERT_MSG_KEEP);
+    msg->plen = htons(DESSERT_MAXFRAMELEN - ntohs(msg->hlen) - DESSERT_EXTLEN);
+    CHECK(dsr_msg_compact_source_ext(msg, 0) == DSR_COMPACT_SOURCE_FORM_FULL);
+    compact = test_compact(msg);
+    CHECK(compact != NULL && (compact->flags & DSR_COMPACT_SOURCE_FORM_MASK) == DSR_COMPACT_SOURCE_FORM_FULL);
+    CHECK(test_has_path(msg, &path));
+    dessert_msg_destroy(msg);
+
+    /* another node with the id of a hop of the flow */
+    for(n = 0; ; n++) {
+        test_addr(addr, 0x10, n);
+
+        if(dsr_compact_source_id(addr) == dsr_compact_source_id(ADDR_IDX((&path), 2))) {
+            break;
+        }
+    }
+
+    CHECK(dsr_compact_source_learn(addr, 1) == 1);
+    msg = test_relay_msg(&path, 8, DSR_COMPACT_SOURCE_FORM_FLOW);
+    CHECK(test_relay(msg, &path) == DSR_COMPACT_SOURCE_FORM_FULL);
+    compact = test_compact(msg);
+    CHECK(compact != NULL && (compact->flags & DSR_COMPACT_SOURCE_FORM_MASK) == DSR_COMPACT_SOURCE_FORM_FULL);
+    CHECK(test_has_path(msg, &path));
+    dessert_msg_destroy(msg);
+}
+
+static void test_short(void) {
+    dessert_msg_t* msg;
+    dessert_ext_t* ext;
+    dsr_path_t path;
+    int len;
+
+    test_path(&path, source_s, 500);
+
+    /* also next to a DSR_EXT_SOURCE, whose bytes would be read as the flow */
+    for(len = 0; len < DSR_COMPACT_SOURCE_EXTENSION_HDRLEN; len++) {
+        msg = test_data_msg();
+        dessert_msg_addext(msg, &ext, DSR_EXT_COMPACT_SOURCE, len);
+        memset(ext->data, DSR_COMPACT_SOURCE_FORM_IDS, len);
+        CHECK(test_receive(msg) == DESSERT_MSG_DROP);
+        dessert_msg_destroy(msg);
+
+        msg = test_data_msg();
+        dessert_msg_addext(msg, &ext, DSR_EXT_COMPACT_SOURCE, len);
+        memset(ext->data, DSR_COMPACT_SOURCE_FORM_FULL, len);
+        dsr_msg_add_source_ext(msg, &path, path.len - 2);
+        CHECK(test_receive(msg) == DESSERT_MSG_DROP);
+        dessert_msg_destroy(msg);
+    }
+
+    /* a header announcing more ids than follow */
+    msg = test_data_msg();
+    dessert_msg_addext(msg, &ext, DSR_EXT_COMPACT_SOURCE, DSR_COMPACT_SOURCE_EXTENSION_HDRLEN + sizeof(uint16_t));
+    memset(ext->data, 0, DSR_COMPACT_SOURCE_EXTENSION_HDRLEN + sizeof(uint16_t));
+    ((dsr_compact_source_ext_t*) ext->data)->flags = DSR_COMPACT_SOURCE_FORM_IDS;
+    ((dsr_compact_source_ext_t*) ext->data)->len = 3;
+    CHECK(test_receive(msg) == DESSERT_MSG_DROP);
+    dessert_msg_destroy(msg);
+}
+
+int main(int argc, char** argv) {
+    memset(&iface, 0, sizeof(iface));
+    test_addr(iface.hwaddr, 0, 0);
+    test_addr(dessert_l25_defsrc, 0, 1);
+    test_addr(source_s, 2, 0);
+
+    dsr_conf_initialize();
+    dsr_conf.compact_source = DSR_COMPACT_SOURCE_FLOWS;
+
+    test_source();
+    test_missed_and_relay();
+    test_full();
+    test_short();
+
+    printf("compact-source-test: %i errors\n", errors);
+
+    return errors ? 1 : 0;
+}
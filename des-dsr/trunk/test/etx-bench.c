@@ -0,0 +1,202 @@
+#include "../dsr.h"
+#include <time.h>
+
+/*
+ * ETX path weight benchmark. Probes of a few hundred links are fed to
+ * etx_meshrx_cb for a full window, then the weights of random paths are
+ * summed hop by hop
+ *  recompute  looking up the window of the hop and computing its ETX, as
+ *             dsr_etx_get_value did before the values were cached; done on
+ *             a copy of the probes kept by the benchmark
+ *  cached     dsr_etx_get_hop_weight
+ * The cached weight of every link is checked against the recomputed one.
+ *
+ * usage: etx-bench [paths] [neighbors per interface] [rounds]
+ */
+
+#define IFACES 2
+#define MIN_HOPS 2
+#define MAX_HOPS 8
+
+typedef struct bench_window {
+    uint8_t key[2 * ETHER_ADDR_LEN];
+    uint64_t probes;
+    uint8_t my_probes;
+    UT_hash_handle hh;
+} bench_window_t;
+
+static bench_window_t* windows = NULL;
+static pthread_rwlock_t windows_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+static void bench_addr(uint8_t addr[ETHER_ADDR_LEN], uint8_t type, uint32_t n) {
+    addr[0] = 0x02;
+    addr[1] = type;
+    addr[2] = (n >> 24) & 0xff;
+    addr[3] = (n >> 16) & 0xff;
+    addr[4] = (n >> 8) & 0xff;
+    addr[5] = n & 0xff;
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* the hop weight as it was computed per query */
+static uint16_t bench_recompute(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]) {
+    uint8_t key[2 * ETHER_ADDR_LEN];
+    bench_window_t* w = NULL;
+    double etx = (UINT16_MAX) / 100;
+
+    memcpy(key, local, ETHER_ADDR_LEN);
+    memcpy(key + ETHER_ADDR_LEN, remote, ETHER_ADDR_LEN);
+
+    pthread_rwlock_rdlock(&windows_lock);
+    HASH_FIND(hh, windows, key, sizeof(key), w);
+
+    if(w != NULL) {
+        uint8_t probes_received = __builtin_popcountll(w->probes);
+        double w_r = DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES;
+
+        if(w->my_probes != 0 && probes_received != 0) {
+            etx = 1 / ((w->my_probes / w_r) * (probes_received / w_r));
+        }
+    }
+
+    pthread_rwlock_unlock(&windows_lock);
+    return dsr_etx_encode(etx);
+}
+
+static void bench_probe(dessert_meshif_t* iface, const uint8_t remote[ETHER_ADDR_LEN], uint8_t my_probes, int time) {
+    dessert_msg_t* msg;
+    dessert_msg_proc_t proc;
+    dsr_etx_ext_t* etx;
+    bench_window_t* w = NULL;
+    uint8_t key[2 * ETHER_ADDR_LEN];
+
+    dessert_msg_new(&msg);
+    etx = dsr_msg_add_etx_ext(msg, DSR_EXT_ETX);
+    etx->len = 1;
+    ADDR_CPY(etx->data[0].address, iface->hwaddr);
+    etx->data[0].probes_received = my_probes;
+    ADDR_CPY(msg->l2h.ether_shost, remote);
+
+    memset(&proc, 0, sizeof(proc));
+    etx_meshrx_cb(msg, 0, &proc, iface, 0);
+    dessert_msg_destroy(msg);
+
+    memcpy(key, iface->hwaddr, ETHER_ADDR_LEN);
+    memcpy(key + ETHER_ADDR_LEN, remote, ETHER_ADDR_LEN);
+    HASH_FIND(hh, windows, key, sizeof(key), w);
+
+    if(w == NULL) {
+        w = calloc(1, sizeof(bench_window_t));
+        memcpy(w->key, key, sizeof(key));
+        HASH_ADD(hh, windows, key, sizeof(key), w);
+    }
+
+    w->probes |= (uint64_t) 1 << time;
+    w->my_probes = my_probes;
+}
+
+int main(int argc, char** argv) {
+    int paths = (argc > 1) ? atoi(argv[1]) : 1000;
+    int neighbors = (argc > 2) ? atoi(argv[2]) : 100;
+    int rounds = (argc > 3) ? atoi(argv[3]) : 1000;
+    int links = IFACES * neighbors;
+    dessert_meshif_t iface[IFACES];
+    uint8_t (*remote)[ETHER_ADDR_LEN] = calloc(neighbors, ETHER_ADDR_LEN);
+    int* len = calloc(paths, sizeof(int));
+    int (*hop)[MAX_HOPS] = calloc(paths, sizeof(*hop));
+    volatile uint32_t sink = 0;
+    double t, t_recompute, t_cached;
+    int hops = 0, mismatches = 0;
+    int r, p, i, l, time;
+    bench_window_t* w;
+
+    srand(1);
+    memset(iface, 0, sizeof(iface));
+
+    for(i = 0; i < IFACES; i++) {
+        bench_addr(iface[i].hwaddr, 0, i);
+    }
+
+    for(i = 0; i < neighbors; i++) {
+        bench_addr(remote[i], 1, i);
+    }
+
+    /* a full window of probes: every link has its own delivery ratio */
+    for(time = 0; time < DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES; time++) {
+        for(l = 0; l < links; l++) {
+            if(rand() % 100 < 40 + l % 60) {
+                bench_probe(&iface[l % IFACES], remote[l / IFACES], 1 + rand() % DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES, time);
+            }
+        }
+
+        /* no mesh interfaces are registered, so this only advances the windows */
+        dsr_etx_send_probes(NULL, NULL, NULL);
+
+        HASH_FOREACH(hh, windows, w) {
+            w->probes &= ~((uint64_t) 1 << ((time + 1) % DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES));
+        }
+    }
+
+    for(l = 0; l < links; l++) {
+        if(dsr_etx_get_hop_weight(iface[l % IFACES].hwaddr, remote[l / IFACES]) != bench_recompute(iface[l % IFACES].hwaddr, remote[l / IFACES])) {
+            mismatches++;
+        }
+    }
+
+    for(p = 0; p < paths; p++) {
+        len[p] = MIN_HOPS + rand() % (MAX_HOPS - MIN_HOPS + 1);
+        hops += len[p];
+
+        for(i = 0; i < len[p]; i++) {
+            hop[p][i] = rand() % links;
+        }
+    }
+
+    t = bench_now();
+
+    for(r = 0; r < rounds; r++) {
+        for(p = 0; p < paths; p++) {
+            uint32_t weight = 0;
+
+            for(i = 0; i < len[p]; i++) {
+                weight += bench_recompute(iface[hop[p][i] % IFACES].hwaddr, remote[hop[p][i] / IFACES]);
+            }
+
+            sink += weight;
+        }
+    }
+
+    t_recompute = bench_now() - t;
+    t = bench_now();
+
+    for(r = 0; r < rounds; r++) {
+        for(p = 0; p < paths; p++) {
+            uint32_t weight = 0;
+
+            for(i = 0; i < len[p]; i++) {
+                weight += dsr_etx_get_hop_weight(iface[hop[p][i] % IFACES].hwaddr, remote[hop[p][i] / IFACES]);
+            }
+
+            sink += weight;
+        }
+    }
+
+    t_cached = bench_now() - t;
+
+    printf("links %d window %d probes: per path (%.1f hops) recompute %.1f ns  cached %.1f ns\n",
+           links, DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES, (double) hops / paths,
+           t_recompute * 1e3 / ((double) rounds * paths), t_cached * 1e3 / ((double) rounds * paths));
+    printf("links %d window %d probes: per hop recompute %.1f ns  cached %.1f ns  mismatches %d\n",
+           links, DSR_CONFVAR_ETX_WINDOW_SIZE_PROBES,
+           t_recompute * 1e3 / ((double) rounds * hops), t_cached * 1e3 / ((double) rounds * hops), mismatches);
+
+    free(hop);
+    free(len);
+    free(remote);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,262 @@
+#include "../dsr.h"
+#include <time.h>
+
+/*
+ * Synthetic forwarding workload: the packet path of a relay in the middle
+ * of a mesh, without libdessert receiving and sending the frames. Per
+ * packet a source routed data msg arrives and is forwarded as
+ * source_meshrx_cb does: counted by statistics_meshrx_cb, the route
+ * advanced, an ACKREQ added, a clone put into the maintenance buffer and
+ * the msg counted as sent. Every ORIGIN_EVERY packets the node also
+ * originates one as sys2dsr_cb and dsr_msg_send_via_path do: the path is
+ * taken from the route cache through dsr_variant and a source route added.
+ * The next hops acknowledge every BATCH packets as ack_meshrx_cb handles
+ * it, then the maintenance buffer runs. Reported are the time per packet
+ * and the packets per second; every msg has to be acknowledged.
+ *
+ * The variant is the one of the build, or picked at runtime in a DAEMON=11
+ * build. test/bench.sh runs this as part of make bench.
+ *
+ * usage: forward-bench [packets] [destinations] [variant]
+ */
+
+#define NEIGHBORS 16
+#define RELAYS 64
+#define ROUTE_LEN 6             /* [source, previous, self, next, relay, dest] */
+#define SELF_INDEX 2
+#define ORIGIN_EVERY 4
+#define BATCH 64
+#define PAYLOAD 1000
+
+extern dsr_conf_t dsr_conf;
+
+typedef struct bench_ack {
+    uint8_t nexthop[ETHER_ADDR_LEN];
+    uint16_t id;
+} bench_ack_t;
+
+static dessert_meshif_t iface;
+static bench_ack_t acks[2 * BATCH];
+static int ack_count = 0;
+static uint64_t sent = 0;
+static uint64_t acked = 0;
+
+static void bench_addr(uint8_t addr[ETHER_ADDR_LEN], uint8_t type, uint32_t n) {
+    addr[0] = 0x02;
+    addr[1] = type;
+    addr[2] = (n >> 24) & 0xff;
+    addr[3] = (n >> 16) & 0xff;
+    addr[4] = (n >> 8) & 0xff;
+    addr[5] = n & 0xff;
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* dsr_msg_send_with_route_maintenance with a network ACK, without putting the frame on the wire */
+static void bench_send(dessert_msg_t* msg, dessert_meshif_t* in_iface) {
+    dessert_msg_t* cloned;
+    uint16_t id = dsr_new_ackreq_identification();
+
+    dsr_msg_add_ackreq_ext(msg, id);
+    dessert_msg_clone(&cloned, msg, false);
+    dsr_maintenance_buffer_add_msg(id, cloned, (in_iface != NULL) ? in_iface->hwaddr : ether_null, iface.hwaddr);
+
+    if(in_iface == NULL) {
+        dsr_statistics_emit_msg(iface.hwaddr, msg->l2h.ether_dhost, msg);
+    }
+    else {
+        dsr_statistics_tx_msg(iface.hwaddr, msg->l2h.ether_dhost, msg);
+    }
+
+    ADDR_CPY(acks[ack_count].nexthop, msg->l2h.ether_dhost);
+    acks[ack_count].id = id;
+    ack_count++;
+    sent++;
+}
+
+/* a msg as received from the previous hop, self at SELF_INDEX */
+static dessert_msg_t* bench_incoming(int n) {
+    dessert_msg_t* msg;
+    dessert_ext_t* ext;
+    dsr_path_t path;
+
+    memset(&path, 0, sizeof(path));
+    bench_addr(ADDR_IDX((&path), 0), 3, n);
+    bench_addr(ADDR_IDX((&path), 1), 1, n % NEIGHBORS);
+    ADDR_CPY(ADDR_IDX((&path), SELF_INDEX), iface.hwaddr);
+    bench_addr(ADDR_IDX((&path), 3), 1, (n + 1) % NEIGHBORS);
+    bench_addr(ADDR_IDX((&path), 4), 4, n % RELAYS);
+    bench_addr(ADDR_IDX((&path), 5), 2, n);
+    path.len = ROUTE_LEN;
+
+    dessert_msg_new(&msg);
+    dessert_msg_addext(msg, &ext, DESSERT_EXT_ETH, ETHER_HDR_LEN);
+    dsr_msg_add_source_ext(msg, &path, ROUTE_LEN - 1 - SELF_INDEX);
+    ADDR_CPY(msg->l2h.ether_shost, ADDR_IDX((&path), 1));
+    ADDR_CPY(msg->l2h.ether_dhost, iface.hwaddr);
+    msg->plen = htons(PAYLOAD);
+
+    return msg;
+}
+
+static void bench_forward(dessert_msg_t* incoming) {
+    dessert_msg_t* msg;
+    dessert_msg_proc_t proc;
+    dessert_ext_t* ext;
+    dsr_source_ext_t* source;
+
+    /* the buffer the frame is received into */
+    dessert_msg_clone(&msg, incoming, false);
+    memset(&proc, 0, sizeof(proc));
+    proc.lflags = DESSERT_RX_FLAG_L2_DST;
+
+    statistics_meshrx_cb(msg, 0, &proc, &iface, 0);
+
+    dessert_msg_getext(msg, &ext, DSR_EXT_SOURCE, 0);
+    source = (dsr_source_ext_t*) ext->data;
+    source->segments_left--;
+    ADDR_CPY(msg->l2h.ether_dhost, dsr_source_indicated_next_hop_begin(source));
+
+    bench_send(msg, &iface);
+    dessert_msg_destroy(msg);
+}
+
+static void bench_originate(const uint8_t dest[ETHER_ADDR_LEN]) {
+    dessert_msg_t* msg;
+    dessert_ext_t* ext;
+    dsr_path_t path;
+    dsr_source_ext_t* source;
+
+    if(DSR_VARIANT_CALL(get_path)(dest, &path) != DSR_ROUTECACHE_SUCCESS) {
+        return;
+    }
+
+    dessert_msg_new(&msg);
+    dessert_msg_addext(msg, &ext, DESSERT_EXT_ETH, ETHER_HDR_LEN);
+    msg->plen = htons(PAYLOAD);
+
+    source = dsr_msg_add_source_ext(msg, &path, path.len - 2);
+    ADDR_CPY(msg->l2h.ether_dhost, dsr_source_indicated_next_hop_begin(source));
+
+    bench_send(msg, NULL);
+    dessert_msg_destroy(msg);
+}
+
+/* the ACKs of the next hops, then a run of the maintenance buffer */
+static void bench_acks(void) {
+    int i;
+
+    for(i = 0; i < ack_count; i++) {
+        dsr_blacklist_remove_node(acks[i].nexthop);
+
+        if(dsr_maintenance_buffer_delete_msg(acks[i].nexthop, acks[i].id) == DSR_MAINTENANCE_BUFFER_SUCCESS) {
+            acked++;
+        }
+
+        if(dsr_variant->linkcache == 1) {
+            uint16_t link_weight = DSR_VARIANT_CALL(hop_weight)(iface.hwaddr, acks[i].nexthop);
+
+            if(dsr_linkcache_add_link(acks[i].nexthop, iface.hwaddr, link_weight) == DSR_LINKCACHE_SUCCESS) {
+                dsr_linkcache_run_dijkstra(dessert_l25_defsrc);
+            }
+        }
+    }
+
+    ack_count = 0;
+    cleanup_maintenance_buffer(NULL, NULL, NULL);
+}
+
+int main(int argc, char** argv) {
+    int packets = (argc > 1) ? atoi(argv[1]) : 1000000;
+    int dests = (argc > 2) ? atoi(argv[2]) : 256;
+    uint8_t (*addr)[ETHER_ADDR_LEN] = calloc(dests, ETHER_ADDR_LEN);
+    dessert_msg_t* incoming[NEIGHBORS];
+    dsr_maintenance_buffer_stats_t stats;
+    double t;
+    int d, k, i;
+
+#if (DSR_VARIANT_RUNTIME == 1)
+
+    if(argc > 3 && (dsr_variant = dsr_variant_get(argv[3])) == NULL) {
+        printf("unknown variant %s\n", argv[3]);
+        return 1;
+    }
+
+#endif
+
+    srand(1);
+    memset(&iface, 0, sizeof(iface));
+    bench_addr(iface.hwaddr, 0, 0);
+    bench_addr(dessert_l25_defsrc, 0, 1);
+
+    dsr_conf.routemaintenance_network_ack = 1;
+    dsr_conf.retransmission_count = 2;
+    dsr_conf.retransmission_timeout = DSR_CONFVAR_RETRANSMISSION_TIMEOUT;
+
+    if(dsr_variant->linkcache == 1) {
+        dsr_linkcache_init(dessert_l25_defsrc);
+        dsr_linkcache_add_link(dessert_l25_defsrc, iface.hwaddr, 0);
+        dsr_linkcache_add_link(iface.hwaddr, dessert_l25_defsrc, 0);
+    }
+
+    /* [self, neighbor, relays..., dest] */
+    for(d = 0; d < dests; d++) {
+        bench_addr(addr[d], 2, d);
+
+        for(k = 0; k < dsr_variant->keep_paths; k++) {
+            dsr_path_t* path = malloc(sizeof(dsr_path_t));
+            int relays = rand() % 4;
+
+            memset(path, 0, sizeof(dsr_path_t));
+            ADDR_CPY(ADDR_IDX(path, 0), iface.hwaddr);
+            bench_addr(ADDR_IDX(path, 1), 1, rand() % NEIGHBORS);
+
+            for(i = 0; i < relays; i++) {
+                bench_addr(ADDR_IDX(path, 2 + i), 4, rand() % RELAYS);
+            }
+
+            ADDR_CPY(ADDR_IDX(path, 2 + relays), addr[d]);
+            path->len = 3 + relays;
+            path->weight = path->len * 100 + rand() % 100;
+            dsr_routecache_add_path(addr[d], path);
+        }
+    }
+
+    for(i = 0; i < NEIGHBORS; i++) {
+        incoming[i] = bench_incoming(i);
+    }
+
+    t = bench_now();
+
+    for(i = 0; i < packets; i++) {
+        bench_forward(incoming[i % NEIGHBORS]);
+
+        if(i % ORIGIN_EVERY == 0) {
+            bench_originate(addr[(i / ORIGIN_EVERY) % dests]);
+        }
+
+        if(ack_count >= BATCH) {
+            bench_acks();
+        }
+    }
+
+    bench_acks();
+    t = bench_now() - t;
+
+    dsr_maintenance_buffer_get_stats(&stats);
+
+    printf("%s: packets %d (+%llu originated)  %.1f ns/packet  %.0f packets/s  acked %llu/%llu  buffered %llu\n",
+           dsr_variant->name, packets, (unsigned long long)(sent - packets), t * 1e3 / sent, sent / t * 1e6,
+           (unsigned long long) acked, (unsigned long long) sent, (unsigned long long) stats.len);
+
+    for(i = 0; i < NEIGHBORS; i++) {
+        dessert_msg_destroy(incoming[i]);
+    }
+
+    free(addr);
+    return (acked == sent && stats.len == 0) ? 0 : 1;
+}
@@ -1,7 +1,193 @@
 #include "../dsr.h"
+#include <time.h>
 
 dsr_linkcache_t* lc = NULL;
 
+/*
+ * After the add/remove sequence below, random topologies with 1k to 10k
+ * links are loaded into the link cache. Every shortest path is checked
+ * against a Bellman-Ford reference and the time for Dijkstra and for the
+ * path queries is reported.
+ *
+ * usage: linkcache2-test [rounds]
+ */
+
+#define BENCH_DEGREE 4
+
+/* every run gets its own addresses, the source of a run is never removed */
+static uint8_t bench_net = 0;
+
+typedef struct bench_link {
+    uint32_t u;
+    uint32_t v;
+    uint16_t weight;
+} bench_link_t;
+
+static void bench_addr(uint8_t addr[ETHER_ADDR_LEN], uint32_t n) {
+    addr[0] = 0x02;
+    addr[1] = bench_net;
+    addr[2] = (n >> 24) & 0xff;
+    addr[3] = (n >> 16) & 0xff;
+    addr[4] = (n >> 8) & 0xff;
+    addr[5] = n & 0xff;
+}
+
+static uint32_t bench_addr_to_node(const uint8_t addr[ETHER_ADDR_LEN]) {
+    return (addr[2] << 24) | (addr[3] << 16) | (addr[4] << 8) | addr[5];
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* node 0 is the source; a ring keeps all nodes reachable, the rest is random */
+static int bench_topology(bench_link_t* links, int link_cnt, int node_cnt) {
+    int i, n = 0;
+
+    for(i = 0; i < node_cnt; i++) {
+        links[n].u = i;
+        links[n].v = (i + 1) % node_cnt;
+        links[n++].weight = 100 + rand() % 400;
+    }
+
+    while(n < link_cnt) {
+        int j;
+        links[n].u = rand() % node_cnt;
+        links[n].v = rand() % node_cnt;
+        links[n].weight = 100 + rand() % 400;
+
+        if(links[n].u == links[n].v) {
+            continue;
+        }
+
+        for(j = 0; j < n; j++) {
+            if(links[j].u == links[n].u && links[j].v == links[n].v) {
+                break;
+            }
+        }
+
+        if(j == n) {
+            n++;
+        }
+    }
+
+    return n;
+}
+
+static void bench_bellman_ford(bench_link_t* links, int link_cnt, int node_cnt, uint32_t* dist) {
+    int i, changed = 1;
+
+    for(i = 0; i < node_cnt; i++) {
+        dist[i] = UINT32_MAX;
+    }
+
+    dist[0] = 0;
+
+    while(changed) {
+        changed = 0;
+
+        for(i = 0; i < link_cnt; i++) {
+            if(dist[links[i].u] != UINT32_MAX && dist[links[i].u] + links[i].weight < dist[links[i].v]) {
+                dist[links[i].v] = dist[links[i].u] + links[i].weight;
+                changed = 1;
+            }
+        }
+    }
+}
+
+static int bench_run(int link_cnt, int rounds) {
+    int node_cnt = link_cnt / BENCH_DEGREE;
+    bench_link_t* links = malloc(link_cnt * sizeof(bench_link_t));
+    uint32_t* dist = malloc(node_cnt * sizeof(uint32_t));
+    uint8_t u[ETHER_ADDR_LEN], v[ETHER_ADDR_LEN], s[ETHER_ADDR_LEN];
+    dsr_path_t* path;
+    double t_dijkstra = 0, t_query = 0, t;
+    int errors = 0, queries = 0;
+    int i, r, hop;
+
+    bench_net++;
+    link_cnt = bench_topology(links, link_cnt, node_cnt);
+    bench_addr(s, 0);
+    dsr_linkcache_init(s);
+
+    for(i = 0; i < link_cnt; i++) {
+        bench_addr(u, links[i].u);
+        bench_addr(v, links[i].v);
+        dsr_linkcache_add_link(u, v, links[i].weight);
+    }
+
+    bench_bellman_ford(links, link_cnt, node_cnt, dist);
+
+    for(r = 0; r < rounds; r++) {
+        /* touch one weight so the shortest path tree is rebuilt */
+        uint16_t weight = links[r % link_cnt].weight + 1;
+        bench_addr(u, links[r % link_cnt].u);
+        bench_addr(v, links[r % link_cnt].v);
+        dsr_linkcache_set_weight(u, v, &weight);
+        weight = links[r % link_cnt].weight;
+        dsr_linkcache_set_weight(u, v, &weight);
+
+        t = bench_now();
+        dsr_linkcache_run_dijkstra(s);
+        t_dijkstra += bench_now() - t;
+
+        for(i = 1; i < node_cnt; i++) {
+            int len;
+            bench_addr(v, i);
+            t = bench_now();
+            len = dsr_linkcache_get_shortest_path(s, v, &path);
+            t_query += bench_now() - t;
+            queries++;
+
+            if(len <= 0) {
+                if(dist[i] != UINT32_MAX && len != DSR_ROUTECACHE_ERROR_NO_PATH_TO_DESTINATION) {
+                    errors++;
+                }
+
+                continue;
+            }
+
+            if(r == 0) {
+                uint32_t sum = 0;
+
+                for(hop = 0; hop + 1 < len; hop++) {
+                    uint16_t w;
+
+                    if(dsr_linkcache_get_weight(path->address + hop * ETHER_ADDR_LEN,
+                                                path->address + (hop + 1) * ETHER_ADDR_LEN, &w) != DSR_LINKCACHE_SUCCESS) {
+                        errors++;
+                        break;
+                    }
+
+                    sum += w;
+                }
+
+                if(sum != dist[i] || path->weight != dist[i] || ADDR_CMP(path->address, s) != 0
+                   || bench_addr_to_node(path->address + (len - 1) * ETHER_ADDR_LEN) != (uint32_t) i) {
+                    errors++;
+                }
+            }
+
+            free(path);
+        }
+    }
+
+    printf("links %6d nodes %5d: dijkstra %9.1f us  query %6.3f us  errors %d\n",
+           link_cnt, node_cnt, t_dijkstra / rounds, t_query / queries, errors);
+
+    for(i = 0; i < link_cnt; i++) {
+        bench_addr(u, links[i].u);
+        bench_addr(v, links[i].v);
+        dsr_linkcache_remove_link(u, v);
+    }
+
+    free(dist);
+    free(links);
+    return errors;
+}
+
 int main(int argc, char** argv) {
     uint8_t n_1[ETHER_ADDR_LEN] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 };
     uint8_t n_2[ETHER_ADDR_LEN] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x02 };
@@ -9,6 +195,8 @@ int main(int argc, char** argv) {
     uint8_t n_4[ETHER_ADDR_LEN] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x04 };
     uint8_t n_5[ETHER_ADDR_LEN] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x05 };
     uint8_t n_6[ETHER_ADDR_LEN] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x06 };
+    int rounds = (argc > 1) ? atoi(argv[1]) : 10;
+    int errors = 0;
 
     dsr_linkcache_init(n_1);
 
@@ -35,5 +223,12 @@ int main(int argc, char** argv) {
     dsr_linkcache_remove_link(n_6, n_2);
 
     dsr_linkcache_print();
-    return 0;
+
+    srand(1);
+    errors += bench_run(1000, rounds);
+    errors += bench_run(2000, rounds);
+    errors += bench_run(5000, rounds);
+    errors += bench_run(10000, rounds);
+
+    return errors ? 1 : 0;
 }
@@ -0,0 +1,411 @@
+#include "../dsr.h"
+
+/*
+ * Maintenance buffer tests over simulated lossy links. The harness takes
+ * the place of dessert_meshsend_fast_hwaddr, the only way the buffer
+ * sends, and decides per transmission whether the link drops the msg; a
+ * msg getting through is acknowledged with the next poll of the buffer,
+ * as an ACK of the next hop would be. Checked are:
+ *  clean    every msg is sent once and acknowledged
+ *  drops    links dropping the first n transmissions: a msg is sent
+ *           min(n + 1, retransmission count + 1) times, its link breaks
+ *           (the route over it is gone) iff n > retransmission count
+ *  dead     a dead link breaks once, its other msgs are purged with it,
+ *           a good link next to it is not affected
+ *  passive  an overheard msg of the same source route with fewer segments
+ *           left acknowledges a msg and purges its link mates
+ *  random   random loss, every msg's fate checked against the drops drawn
+ *
+ * usage: maintenance-buffer-test [random msgs] [loss %]
+ */
+
+#define COUNT 3                 /* retransmission count */
+#define TIMEOUT 10000           /* retransmission timeout */
+#define POLL 1000               /* poll interval of the buffer */
+#define MAX_MSGS 1024
+#define MAX_LINKS 16
+
+extern dsr_conf_t dsr_conf;
+
+static int errors = 0;
+
+#define CHECK(x) do { if(!(x)) { printf("FAILED line %i: %s\n", __LINE__, #x); errors++; } } while(0)
+
+typedef struct test_link {
+    uint8_t nexthop[ETHER_ADDR_LEN];
+    int drops;                  /* transmissions still to drop */
+    int loss;                   /* %, after drops */
+    int ack;                    /* acknowledge what gets through */
+} test_link_t;
+
+typedef struct test_msg {
+    test_link_t* link;
+    uint16_t id;
+    int sends;
+    uint32_t dropped;           /* bit i: transmission i was dropped */
+    int acked;
+} test_msg_t;
+
+static uint8_t local[ETHER_ADDR_LEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+static test_link_t links[MAX_LINKS];
+static test_msg_t msgs[MAX_MSGS];
+static int msg_count = 0;
+static int acks[MAX_MSGS];      /* msgs to acknowledge with the next poll */
+static int ack_count = 0;
+
+static void test_addr(uint8_t addr[ETHER_ADDR_LEN], uint8_t type, uint32_t n) {
+    addr[0] = 0x02;
+    addr[1] = type;
+    addr[2] = (n >> 24) & 0xff;
+    addr[3] = (n >> 16) & 0xff;
+    addr[4] = (n >> 8) & 0xff;
+    addr[5] = n & 0xff;
+}
+
+/* the link, replacing the one of libdessert */
+int dessert_meshsend_fast_hwaddr(dessert_msg_t* msg, const uint8_t hwaddr[ETHER_ADDR_LEN]) {
+    test_msg_t* m = &msgs[msg->u16];
+    test_link_t* link = m->link;
+    int drop = 0;
+
+    if(ADDR_CMP(hwaddr, local) != 0 || ADDR_CMP(msg->l2h.ether_dhost, link->nexthop) != 0) {
+        printf("msg %i sent over the wrong link\n", msg->u16);
+        errors++;
+    }
+
+    if(link->drops > 0) {
+        link->drops--;
+        drop = 1;
+    }
+    else if(link->loss > 0 && rand() % 100 < link->loss) {
+        drop = 1;
+    }
+
+    if(drop) {
+        m->dropped |= 1 << m->sends;
+    }
+    else if(link->ack) {
+        acks[ack_count++] = msg->u16;
+    }
+
+    m->sends++;
+    return DESSERT_OK;
+}
+
+static void test_reset(int link_count) {
+    int i;
+
+    memset(links, 0, sizeof(links));
+    memset(msgs, 0, sizeof(msgs));
+    msg_count = 0;
+    ack_count = 0;
+
+    for(i = 0; i < link_count; i++) {
+        test_addr(links[i].nexthop, 1, i);
+        links[i].ack = 1;
+    }
+}
+
+/* a msg over @a link, with a source route if @a path is given */
+static int test_add(test_link_t* link, dsr_path_t* path, int segments_left) {
+    dessert_msg_t* msg;
+    test_msg_t* m = &msgs[msg_count];
+
+    dessert_msg_new(&msg);
+    ADDR_CPY(msg->l2h.ether_shost, local);
+    ADDR_CPY(msg->l2h.ether_dhost, link->nexthop);
+    msg->u16 = msg_count;
+
+    if(path != NULL) {
+        dsr_msg_add_source_ext(msg, path, segments_left);
+    }
+
+    m->link = link;
+    m->id = dsr_new_ackreq_identification();
+
+    /* sent with the first poll, as dsr_msg_send_with_route_maintenance_delay does */
+    CHECK(dsr_maintenance_buffer_add_msg_delay(m->id, msg, ether_null, local, 0) == DSR_MAINTENANCE_BUFFER_SUCCESS);
+
+    return msg_count++;
+}
+
+/* one poll: the ACKs of the last poll arrive, then the due retransmissions */
+static void test_poll(void) {
+    int i;
+
+    usleep(POLL);
+
+    for(i = 0; i < ack_count; i++) {
+        test_msg_t* m = &msgs[acks[i]];
+
+        if(dsr_maintenance_buffer_delete_msg(m->link->nexthop, m->id) == DSR_MAINTENANCE_BUFFER_SUCCESS) {
+            m->acked = 1;
+        }
+    }
+
+    ack_count = 0;
+    cleanup_maintenance_buffer(NULL, NULL, NULL);
+}
+
+static void test_run(void) {
+    dsr_maintenance_buffer_stats_t stats;
+    int polls = 0;
+
+    do {
+        test_poll();
+        dsr_maintenance_buffer_get_stats(&stats);
+    }
+    while(stats.len > 0 && ++polls < 10 * (COUNT + 1) * TIMEOUT / POLL);
+
+    CHECK(stats.len == 0);
+}
+
+/* a route [local, nexthop, dest] in the route cache, to see link errors */
+static void test_add_route(test_link_t* link, uint8_t dest[ETHER_ADDR_LEN]) {
+    dsr_path_t* path = malloc(sizeof(dsr_path_t));
+
+    memset(path, 0, sizeof(dsr_path_t));
+    ADDR_CPY(ADDR_IDX(path, 0), local);
+    ADDR_CPY(ADDR_IDX(path, 1), link->nexthop);
+    ADDR_CPY(ADDR_IDX(path, 2), dest);
+    path->len = 3;
+    path->weight = 2;
+    dsr_routecache_add_path(dest, path);
+}
+
+static int test_has_route(uint8_t dest[ETHER_ADDR_LEN]) {
+    dsr_path_t path;
+    return dsr_routecache_get_first(dest, &path) == DSR_ROUTECACHE_SUCCESS;
+}
+
+static void test_stats(dsr_maintenance_buffer_stats_t* diff, dsr_maintenance_buffer_stats_t* before) {
+    dsr_maintenance_buffer_stats_t now;
+
+    dsr_maintenance_buffer_get_stats(&now);
+    diff->added = now.added - before->added;
+    diff->retransmissions = now.retransmissions - before->retransmissions;
+    diff->acks = now.acks - before->acks;
+    diff->passive_acks = now.passive_acks - before->passive_acks;
+    diff->link_errors = now.link_errors - before->link_errors;
+    diff->purged = now.purged - before->purged;
+    *before = now;
+}
+
+static void test_clean(dsr_maintenance_buffer_stats_t* stats) {
+    dsr_maintenance_buffer_stats_t diff;
+    int i;
+
+    test_reset(4);
+
+    for(i = 0; i < 100; i++) {
+        test_add(&links[i % 4], NULL, 0);
+    }
+
+    test_run();
+    test_stats(&diff, stats);
+
+    for(i = 0; i < msg_count; i++) {
+        CHECK(msgs[i].sends == 1);
+        CHECK(msgs[i].acked);
+    }
+
+    CHECK(diff.added == 100);
+    CHECK(diff.acks == 100);
+    CHECK(diff.retransmissions == 0);
+    CHECK(diff.link_errors == 0);
+}
+
+static void test_drops(dsr_maintenance_buffer_stats_t* stats) {
+    dsr_maintenance_buffer_stats_t diff;
+    uint8_t dest[COUNT + 3][ETHER_ADDR_LEN];
+    uint32_t retransmissions = 0;
+    int i;
+
+    /* link i drops the first i transmissions */
+    test_reset(COUNT + 3);
+
+    for(i = 0; i < COUNT + 3; i++) {
+        links[i].drops = i;
+        test_addr(dest[i], 2, i);
+        test_add_route(&links[i], dest[i]);
+        test_add(&links[i], NULL, 0);
+    }
+
+    test_run();
+    test_stats(&diff, stats);
+
+    for(i = 0; i < COUNT + 3; i++) {
+        int sends = (i + 1 < COUNT + 1) ? i + 1 : COUNT + 1;
+
+        CHECK(msgs[i].sends == sends);
+        CHECK(msgs[i].acked == (i <= COUNT));
+        CHECK(test_has_route(dest[i]) == (i <= COUNT));
+        retransmissions += sends - 1;
+    }
+
+    CHECK(diff.retransmissions == retransmissions);
+    CHECK(diff.link_errors == 2);
+    CHECK(diff.purged == 0);
+}
+
+static void test_dead(dsr_maintenance_buffer_stats_t* stats) {
+    dsr_maintenance_buffer_stats_t diff;
+    int i;
+
+    test_reset(2);
+    links[0].loss = 100;
+
+    for(i = 0; i < 40; i++) {
+        test_add(&links[i % 2], NULL, 0);
+    }
+
+    test_run();
+    test_stats(&diff, stats);
+
+    for(i = 0; i < msg_count; i++) {
+        if(msgs[i].link == &links[0]) {
+            CHECK(!msgs[i].acked);
+            CHECK(msgs[i].sends >= 1 && msgs[i].sends <= COUNT + 1);
+        }
+        else {
+            CHECK(msgs[i].acked);
+            CHECK(msgs[i].sends == 1);
+        }
+    }
+
+    CHECK(diff.link_errors == 1);
+    CHECK(diff.purged == 19);
+    CHECK(diff.acks == 20);
+}
+
+static void test_passive(dsr_maintenance_buffer_stats_t* stats) {
+    dsr_maintenance_buffer_stats_t diff;
+    dsr_maintenance_buffer_stats_t now;
+    dessert_msg_proc_t proc;
+    dessert_msg_t* overheard;
+    dsr_path_t route;
+    dsr_path_t* path = &route;
+    int i;
+
+    /* [source, local, nexthop, dest], sent by local with 1 segment left */
+    test_reset(2);
+    links[0].ack = 0;
+    memset(path, 0, sizeof(dsr_path_t));
+    test_addr(ADDR_IDX(path, 0), 3, 0);
+    ADDR_CPY(ADDR_IDX(path, 1), local);
+    ADDR_CPY(ADDR_IDX(path, 2), links[0].nexthop);
+    test_addr(ADDR_IDX(path, 3), 2, 0);
+    path->len = 4;
+
+    test_add(&links[0], path, 1);
+    test_add(&links[0], NULL, 0);
+
+    /* sent with the first poll of the next wheel tick at the latest */
+    for(i = 0; i < 100 && msgs[1].sends == 0; i++) {
+        test_poll();
+    }
+
+    dsr_conf.routemaintenance_passive_ack = 1;
+    memset(&proc, 0, sizeof(proc));
+
+    /* the own msg once more: no passive ACK */
+    dessert_msg_new(&overheard);
+    dsr_msg_add_source_ext(overheard, path, 1);
+    maintenance_buffer_passive_ack_meshrx_cb(overheard, 0, &proc, NULL, 0);
+    dessert_msg_destroy(overheard);
+
+    dsr_maintenance_buffer_get_stats(&now);
+    CHECK(now.len == 2);
+
+    /* forwarded by the next hop: a passive ACK, the second msg goes with it */
+    dessert_msg_new(&overheard);
+    dsr_msg_add_source_ext(overheard, path, 0);
+    maintenance_buffer_passive_ack_meshrx_cb(overheard, 0, &proc, NULL, 0);
+    dessert_msg_destroy(overheard);
+
+    dsr_conf.routemaintenance_passive_ack = 0;
+    test_stats(&diff, stats);
+
+    for(i = 0; i < msg_count; i++) {
+        CHECK(msgs[i].sends == 1);
+    }
+
+    CHECK(diff.passive_acks == 1);
+    CHECK(diff.purged == 1);
+    CHECK(diff.retransmissions == 0);
+
+    dsr_maintenance_buffer_get_stats(&now);
+    CHECK(now.len == 0);
+}
+
+static void test_random(dsr_maintenance_buffer_stats_t* stats, int count, int loss) {
+    dsr_maintenance_buffer_stats_t diff;
+    uint32_t retransmissions = 0;
+    uint32_t acked = 0;
+    int i, k;
+
+    test_reset(MAX_LINKS);
+
+    for(i = 0; i < MAX_LINKS; i++) {
+        links[i].loss = loss;
+    }
+
+    for(i = 0; i < count; i++) {
+        test_add(&links[rand() % MAX_LINKS], NULL, 0);
+    }
+
+    test_run();
+    test_stats(&diff, stats);
+
+    for(i = 0; i < msg_count; i++) {
+        test_msg_t* m = &msgs[i];
+
+        CHECK(m->sends >= 1 && m->sends <= COUNT + 1);
+
+        if(m->acked) {
+            /* retransmitted until the first transmission getting through */
+            for(k = 0; k < m->sends - 1; k++) {
+                CHECK(m->dropped & (1 << k));
+            }
+
+            CHECK(!(m->dropped & (1 << (m->sends - 1))));
+            acked++;
+        }
+
+        retransmissions += m->sends - 1;
+    }
+
+    CHECK(diff.retransmissions == retransmissions);
+    CHECK(diff.acks == acked);
+    CHECK(diff.acks + diff.link_errors + diff.purged == (uint32_t) count);
+
+    printf("random: msgs %i loss %i%%  retransmissions %u acks %u link errors %u purged %u\n",
+           count, loss, diff.retransmissions, diff.acks, diff.link_errors, diff.purged);
+}
+
+int main(int argc, char** argv) {
+    int count = (argc > 1) ? atoi(argv[1]) : 500;
+    int loss = (argc > 2) ? atoi(argv[2]) : 30;
+    dsr_maintenance_buffer_stats_t stats;
+
+    if(count > MAX_MSGS) {
+        count = MAX_MSGS;
+    }
+
+    srand(1);
+
+    dsr_conf.retransmission_count = COUNT;
+    dsr_conf.retransmission_timeout = TIMEOUT;
+    dsr_conf.routemaintenance_passive_ack = 0;
+    memset(&stats, 0, sizeof(stats));
+
+    test_clean(&stats);
+    test_drops(&stats);
+    test_dead(&stats);
+    test_passive(&stats);
+    test_random(&stats, count, loss);
+
+    printf("maintenance-buffer-test: %i errors\n", errors);
+
+    return errors ? 1 : 0;
+}
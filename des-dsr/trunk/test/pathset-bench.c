@@ -0,0 +1,242 @@
+#include "../dsr.h"
+#include <time.h>
+
+/*
+ * Reply selection benchmark. A candidate set is the shortest delay route
+ * plus a full neighbor list of candidate routes, all hop lists as in a
+ * RREQ. Per candidate set it reports:
+ *  loops    choosing the candidate most disjoint to the shortest delay
+ *           route by comparing every address of one route with every
+ *           address of the other, as rreqtable.c used to
+ *  pathset  the same choice with a dsr_pathset_t, building it included
+ *  k=3      selecting 3 maximally disjoint routes with a dsr_pathset_t
+ * and per pair of routes the nodes and links in common, by comparing every
+ * address pair and with a dsr_pathset_t already built. Both choices are
+ * checked to agree. The candidate sets are reused
+ * round after round, like RREQs still in the cache.
+ *
+ * usage: pathset-bench [rounds] [relays]
+ */
+
+#ifndef DSR_CONFVAR_SMR_RREQCACHE_NEIGHBOR_LIST_MAX_LEN
+#define DSR_CONFVAR_SMR_RREQCACHE_NEIGHBOR_LIST_MAX_LEN 30
+#endif
+
+#define CANDIDATES (DSR_CONFVAR_SMR_RREQCACHE_NEIGHBOR_LIST_MAX_LEN + 1)
+#define MIN_HOPS 3
+#define MAX_HOPS 12
+#define SETS 64
+
+typedef struct bench_route {
+    dsr_hop_data_t data[MAX_HOPS];
+    int len;
+    uint32_t weight;
+} bench_route_t;
+
+static void bench_addr(uint8_t addr[ETHER_ADDR_LEN], uint8_t type, uint32_t n) {
+    addr[0] = 0x02;
+    addr[1] = type;
+    addr[2] = (n >> 24) & 0xff;
+    addr[3] = (n >> 16) & 0xff;
+    addr[4] = (n >> 8) & 0xff;
+    addr[5] = n & 0xff;
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* source, then distinct relays */
+static void bench_route(bench_route_t* r, int relays) {
+    int i, j;
+
+    r->len = MIN_HOPS + rand() % (MAX_HOPS - MIN_HOPS + 1);
+    r->weight = r->len * 100 + rand() % 50;
+    bench_addr(r->data[0].address, 0, 0);
+
+    for(i = 1; i < r->len; i++) {
+        do {
+            bench_addr(r->data[i].address, 1, rand() % relays);
+
+            for(j = 1; j < i && ADDR_CMP(r->data[i].address, r->data[j].address) != 0; j++);
+        }
+        while(j < i);
+    }
+}
+
+static int loops_nodes(bench_route_t* a, bench_route_t* b) {
+    int i, j, n = 0;
+
+    for(i = 0; i < a->len; i++) {
+        for(j = 0; j < b->len; j++) {
+            if(ADDR_CMP(a->data[i].address, b->data[j].address) == 0) {
+                n++;
+            }
+        }
+    }
+
+    return n;
+}
+
+static int loops_links(bench_route_t* a, bench_route_t* b) {
+    int i, j, n = 0;
+
+    for(i = 1; i < a->len; i++) {
+        for(j = 1; j < b->len; j++) {
+            if(ADDR_CMP(a->data[i - 1].address, b->data[j - 1].address) == 0
+               && ADDR_CMP(a->data[i].address, b->data[j].address) == 0) {
+                n++;
+            }
+        }
+    }
+
+    return n;
+}
+
+static int loops_choose(bench_route_t* routes) {
+    int best = -1, best_nodes = 0, best_links = 0;
+    int i;
+
+    for(i = 1; i < CANDIDATES; i++) {
+        int nodes = loops_nodes(routes, &routes[i]);
+        int links = loops_links(routes, &routes[i]);
+
+        if(best < 0
+           || nodes < best_nodes
+           || (nodes == best_nodes && links < best_links)
+           || (nodes == best_nodes && links == best_links && routes[i].weight < routes[best].weight)
+           || (nodes == best_nodes && links == best_links && routes[i].weight == routes[best].weight
+               && routes[i].len < routes[best].len)) {
+            best = i;
+            best_nodes = nodes;
+            best_links = links;
+        }
+    }
+
+    return best;
+}
+
+static void pathset_build(dsr_pathset_t* set, bench_route_t* routes) {
+    int addresses = 0;
+    int i;
+
+    dsr_pathset_init(set, 0);
+
+    for(i = 0; i < CANDIDATES; i++) {
+        addresses += routes[i].len;
+    }
+
+    dsr_pathset_reserve(set, CANDIDATES, addresses);
+
+    for(i = 0; i < CANDIDATES; i++) {
+        dsr_pathset_add(set, routes[i].data[0].address, sizeof(dsr_hop_data_t), routes[i].len, routes[i].weight, &routes[i]);
+    }
+}
+
+int main(int argc, char** argv) {
+    int rounds = (argc > 1) ? atoi(argv[1]) : 500;
+    int relays = (argc > 2) ? atoi(argv[2]) : 100;
+    bench_route_t* routes = malloc(SETS * CANDIDATES * sizeof(bench_route_t));
+    int chosen[SETS];
+    double t, t_loops, t_pathset, t_k3, t_pair_loops, t_pair_pathset;
+    volatile int common = 0;
+    int mismatches = 0;
+    int r, s, i;
+
+    srand(1);
+
+    for(i = 0; i < SETS * CANDIDATES; i++) {
+        bench_route(&routes[i], relays);
+    }
+
+    t = bench_now();
+
+    for(r = 0; r < rounds; r++) {
+        for(s = 0; s < SETS; s++) {
+            chosen[s] = loops_choose(&routes[s * CANDIDATES]);
+        }
+    }
+
+    t_loops = (bench_now() - t) / (rounds * SETS);
+
+    t = bench_now();
+
+    for(r = 0; r < rounds; r++) {
+        for(s = 0; s < SETS; s++) {
+            dsr_pathset_t set;
+            int selected[2] = { 0 };
+
+            pathset_build(&set, &routes[s * CANDIDATES]);
+            dsr_pathset_select_disjoint(&set, selected, 1, 2);
+
+            if(selected[1] != chosen[s]) {
+                mismatches++;
+            }
+
+            dsr_pathset_destroy(&set);
+        }
+    }
+
+    t_pathset = (bench_now() - t) / (rounds * SETS);
+
+    t = bench_now();
+
+    for(r = 0; r < rounds; r++) {
+        for(s = 0; s < SETS; s++) {
+            dsr_pathset_t set;
+            int selected[3] = { 0 };
+
+            pathset_build(&set, &routes[s * CANDIDATES]);
+            dsr_pathset_select_disjoint(&set, selected, 1, 3);
+            dsr_pathset_destroy(&set);
+        }
+    }
+
+    t_k3 = (bench_now() - t) / (rounds * SETS);
+
+    t = bench_now();
+
+    for(r = 0; r < rounds; r++) {
+        for(s = 0; s < SETS; s++) {
+            for(i = 1; i < CANDIDATES; i++) {
+                common += loops_nodes(&routes[s * CANDIDATES], &routes[s * CANDIDATES + i]);
+                common += loops_links(&routes[s * CANDIDATES], &routes[s * CANDIDATES + i]);
+            }
+        }
+    }
+
+    t_pair_loops = (bench_now() - t) * 1e3 / (rounds * SETS * (CANDIDATES - 1));
+
+    t_pair_pathset = 0;
+
+    for(s = 0; s < SETS; s++) {
+        dsr_pathset_t set;
+
+        pathset_build(&set, &routes[s * CANDIDATES]);
+        dsr_pathset_nodes_in_common(&set, 0, 0);
+
+        t = bench_now();
+
+        for(r = 0; r < rounds; r++) {
+            for(i = 1; i < CANDIDATES; i++) {
+                common += dsr_pathset_nodes_in_common(&set, 0, i);
+                common += dsr_pathset_links_in_common(&set, 0, i);
+            }
+        }
+
+        t_pair_pathset += bench_now() - t;
+        dsr_pathset_destroy(&set);
+    }
+
+    t_pair_pathset = t_pair_pathset * 1e3 / (rounds * SETS * (CANDIDATES - 1));
+
+    printf("candidates %d relays %d: loops %.3f us  pathset %.3f us  k=3 %.3f us  mismatches %d\n",
+           CANDIDATES, relays, t_loops, t_pathset, t_k3, mismatches);
+    printf("candidates %d relays %d: per pair loops %.1f ns  pathset %.1f ns\n",
+           CANDIDATES, relays, t_pair_loops, t_pair_pathset);
+
+    free(routes);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,228 @@
+#include "../dsr.h"
+
+/*
+ * Path set unit tests: hand-made paths with known nodes and links in
+ * common, the selection of disjoint paths, and random paths over enough
+ * nodes to grow the bitsets several times, checked against a comparison
+ * of every address pair.
+ *
+ * usage: pathset-test [random paths]
+ */
+
+#define MAX_LEN 16
+#define RELAYS 500
+
+static int errors = 0;
+
+#define CHECK(x) do { if(!(x)) { printf("FAILED line %i: %s\n", __LINE__, #x); errors++; } } while(0)
+
+static void test_addr(uint8_t addr[ETHER_ADDR_LEN], uint32_t n) {
+    addr[0] = 0x02;
+    addr[1] = 0x00;
+    addr[2] = (n >> 24) & 0xff;
+    addr[3] = (n >> 16) & 0xff;
+    addr[4] = (n >> 8) & 0xff;
+    addr[5] = n & 0xff;
+}
+
+/* the path through the nodes in @a nodes, terminated by 0 */
+static int test_add(dsr_pathset_t* set, const uint32_t* nodes, uint32_t weight) {
+    uint8_t address[MAX_LEN * ETHER_ADDR_LEN];
+    int len;
+
+    for(len = 0; nodes[len] != 0; len++) {
+        test_addr(address + len * ETHER_ADDR_LEN, nodes[len]);
+    }
+
+    return dsr_pathset_add(set, address, ETHER_ADDR_LEN, len, weight, NULL);
+}
+
+static void test_common(void) {
+    dsr_pathset_t set;
+    uint32_t p0[] = { 1, 2, 3, 4, 9, 0 };
+    uint32_t p1[] = { 1, 5, 3, 4, 9, 0 };  /* nodes 1 3 4 9, link 3-4 4-9 */
+    uint32_t p2[] = { 1, 6, 7, 9, 0 };     /* nodes 1 9 */
+    uint32_t p3[] = { 1, 2, 8, 9, 0 };     /* nodes 1 2 9, link 1-2 */
+    uint32_t p4[] = { 1, 4, 3, 2, 9, 0 };  /* nodes 1 2 3 4 9, reversed links only */
+
+    dsr_pathset_init(&set, 0);
+
+    CHECK(test_add(&set, p0, 400) == 0);
+    CHECK(test_add(&set, p1, 400) == 1);
+    CHECK(test_add(&set, p2, 300) == 2);
+    CHECK(test_add(&set, p3, 300) == 3);
+    CHECK(test_add(&set, p4, 400) == 4);
+
+    CHECK(dsr_pathset_nodes_in_common(&set, 0, 0) == 5);
+    CHECK(dsr_pathset_links_in_common(&set, 0, 0) == 4);
+    CHECK(dsr_pathset_nodes_in_common(&set, 0, 1) == 4);
+    CHECK(dsr_pathset_links_in_common(&set, 0, 1) == 2);
+    CHECK(dsr_pathset_nodes_in_common(&set, 1, 0) == 4);
+    CHECK(dsr_pathset_links_in_common(&set, 1, 0) == 2);
+    CHECK(dsr_pathset_nodes_in_common(&set, 0, 2) == 2);
+    CHECK(dsr_pathset_links_in_common(&set, 0, 2) == 0);
+    CHECK(dsr_pathset_nodes_in_common(&set, 0, 3) == 3);
+    CHECK(dsr_pathset_links_in_common(&set, 0, 3) == 1);
+    CHECK(dsr_pathset_nodes_in_common(&set, 0, 4) == 5);
+    CHECK(dsr_pathset_links_in_common(&set, 0, 4) == 0);
+
+    dsr_pathset_destroy(&set);
+
+    /* the first link is the same for both, so it does not count */
+    dsr_pathset_init(&set, DSR_PATHSET_SKIP_FIRST_LINK);
+
+    CHECK(test_add(&set, p0, 400) == 0);
+    CHECK(test_add(&set, p3, 300) == 1);
+    CHECK(test_add(&set, p1, 400) == 2);
+    CHECK(dsr_pathset_links_in_common(&set, 0, 1) == 0);
+    CHECK(dsr_pathset_links_in_common(&set, 0, 2) == 2);
+
+    dsr_pathset_remove_last(&set);
+    CHECK(set.count == 2);
+    CHECK(test_add(&set, p2, 300) == 2);
+    CHECK(dsr_pathset_links_in_common(&set, 0, 2) == 0);
+    CHECK(dsr_pathset_nodes_in_common(&set, 0, 2) == 2);
+
+    dsr_pathset_destroy(&set);
+}
+
+static void test_select(void) {
+    dsr_pathset_t set;
+    uint32_t sd[] = { 1, 2, 3, 4, 9, 0 };
+    uint32_t c0[] = { 1, 2, 3, 5, 9, 0 };  /* 4 nodes in common */
+    uint32_t c1[] = { 1, 6, 7, 9, 0 };     /* 2 nodes in common, weight 500 */
+    uint32_t c2[] = { 1, 8, 10, 11, 9, 0 }; /* 2 nodes in common, weight 500, longer */
+    uint32_t c3[] = { 1, 12, 13, 9, 0 };   /* 2 nodes in common, weight 400 */
+    uint32_t c4[] = { 1, 6, 13, 9, 0 };    /* weight 100, shares a relay with c1 and c3 */
+    int selected[6];
+    int n;
+
+    dsr_pathset_init(&set, 0);
+
+    /* empty set */
+    selected[0] = -1;
+    CHECK(dsr_pathset_select_disjoint(&set, selected, 0, 2) == 0);
+
+    selected[0] = test_add(&set, sd, 100);
+    test_add(&set, c0, 300);
+    test_add(&set, c1, 500);
+    test_add(&set, c2, 500);
+
+    /* equal in nodes, links and weight: the fewer hops wins */
+    CHECK(dsr_pathset_select_disjoint(&set, selected, 1, 2) == 2);
+    CHECK(selected[1] == 2);
+
+    /* the smaller weight wins */
+    test_add(&set, c3, 400);
+    CHECK(dsr_pathset_select_disjoint(&set, selected, 1, 2) == 2);
+    CHECK(selected[1] == 4);
+
+    /* the third path avoids the relays of the first two */
+    test_add(&set, c4, 100);
+    n = dsr_pathset_select_disjoint(&set, selected, 1, 3);
+    CHECK(n == 3);
+    CHECK(selected[1] == 5);
+    CHECK(selected[2] == 3);
+
+    /* more paths asked for than there are */
+    n = dsr_pathset_select_disjoint(&set, selected, 0, 10);
+    CHECK(n == 6);
+    CHECK(selected[0] == 5); /* weight 100 and 4 nodes, before sd's 5 */
+    CHECK(selected[5] == 1);
+
+    dsr_pathset_destroy(&set);
+}
+
+/* nodes in common by comparing every node of one path with every node of the other */
+static int ref_nodes(const uint32_t* a, int a_len, const uint32_t* b, int b_len) {
+    int i, j, n = 0;
+
+    for(i = 0; i < a_len; i++) {
+        for(j = 0; j < b_len; j++) {
+            if(a[i] == b[j]) {
+                n++;
+            }
+        }
+    }
+
+    return n;
+}
+
+static int ref_links(const uint32_t* a, int a_len, const uint32_t* b, int b_len, int first) {
+    int i, j, n = 0;
+
+    for(i = first + 1; i < a_len; i++) {
+        for(j = first + 1; j < b_len; j++) {
+            if(a[i - 1] == b[j - 1] && a[i] == b[j]) {
+                n++;
+            }
+        }
+    }
+
+    return n;
+}
+
+static void test_random(int count, int flags) {
+    dsr_pathset_t set;
+    uint32_t (*nodes)[MAX_LEN + 1] = calloc(count, sizeof(*nodes));
+    int* len = calloc(count, sizeof(int));
+    int first = (flags & DSR_PATHSET_SKIP_FIRST_LINK) ? 1 : 0;
+    int i, j, n;
+
+    dsr_pathset_init(&set, flags);
+
+    for(i = 0; i < count; i++) {
+        len[i] = 2 + rand() % (MAX_LEN - 1);
+        nodes[i][0] = 1;
+
+        for(n = 1; n < len[i] - 1; n++) {
+            /* no node twice on the same path */
+            do {
+                nodes[i][n] = 2 + rand() % RELAYS;
+
+                for(j = 1; j < n && nodes[i][j] != nodes[i][n]; j++);
+            }
+            while(j < n);
+        }
+
+        nodes[i][len[i] - 1] = RELAYS + 2;
+        nodes[i][len[i]] = 0;
+
+        CHECK(test_add(&set, nodes[i], len[i]) == i);
+    }
+
+    for(i = 0; i < count; i++) {
+        for(j = 0; j < count; j++) {
+            CHECK(dsr_pathset_nodes_in_common(&set, i, j) == ref_nodes(nodes[i], len[i], nodes[j], len[j]));
+            CHECK(dsr_pathset_links_in_common(&set, i, j) == ref_links(nodes[i], len[i], nodes[j], len[j], first));
+        }
+
+        if(i == count / 2) {
+            /* more paths and nodes after the bits were set */
+            CHECK(test_add(&set, nodes[0], len[0]) == count);
+            dsr_pathset_remove_last(&set);
+        }
+    }
+
+    CHECK(set.node_count <= RELAYS + 2);
+    CHECK(set.node_words * 64 >= set.node_count);
+
+    dsr_pathset_destroy(&set);
+    free(len);
+    free(nodes);
+}
+
+int main(int argc, char** argv) {
+    int count = (argc > 1) ? atoi(argv[1]) : 300;
+
+    srand(1);
+
+    test_common();
+    test_select();
+    test_random(count, 0);
+    test_random(count, DSR_PATHSET_SKIP_FIRST_LINK);
+
+    printf("pathset-test: %i errors\n", errors);
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+#include "../dsr.h"
+#include <time.h>
+
+/*
+ * Route cache benchmark: about 10k cached paths over a shared pool of relay
+ * nodes, followed by a stream of link errors. After every error the
+ * affected destinations get a fresh path, so the cache stays full. Every
+ * CHECK_INTERVAL errors all cached paths are checked to no longer use the
+ * broken link.
+ *
+ * usage: routecache-bench [paths] [link errors]
+ */
+
+#define RELAYS 400
+#define MAX_RELAYS_PER_PATH 6
+#define CHECK_INTERVAL 50
+
+static uint8_t src[ETHER_ADDR_LEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+static void bench_addr(uint8_t addr[ETHER_ADDR_LEN], uint8_t type, uint32_t n) {
+    addr[0] = 0x02;
+    addr[1] = type;
+    addr[2] = (n >> 24) & 0xff;
+    addr[3] = (n >> 16) & 0xff;
+    addr[4] = (n >> 8) & 0xff;
+    addr[5] = n & 0xff;
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* src, 1..MAX_RELAYS_PER_PATH distinct relays, dest */
+static dsr_path_t* bench_path(uint32_t dest) {
+    dsr_path_t* path = malloc(sizeof(dsr_path_t));
+    int relays = 1 + rand() % MAX_RELAYS_PER_PATH;
+    int i, j;
+
+    memset(path, 0, sizeof(dsr_path_t));
+    ADDR_CPY(ADDR_IDX(path, 0), src);
+
+    for(i = 1; i <= relays; i++) {
+        uint8_t relay[ETHER_ADDR_LEN];
+
+        do {
+            bench_addr(relay, 1, rand() % RELAYS);
+
+            for(j = 1; j < i; j++) {
+                if(ADDR_CMP(relay, ADDR_IDX(path, j)) == 0) {
+                    break;
+                }
+            }
+        }
+        while(j < i);
+
+        ADDR_CPY(ADDR_IDX(path, i), relay);
+    }
+
+    bench_addr(ADDR_IDX(path, relays + 1), 2, dest);
+    path->len = relays + 2;
+    path->weight = path->len * 100 + rand() % 100;
+    return path;
+}
+
+static void bench_add(uint32_t dest) {
+    uint8_t addr[ETHER_ADDR_LEN];
+
+    bench_addr(addr, 2, dest);
+    dsr_routecache_add_path(addr, bench_path(dest));
+}
+
+int main(int argc, char** argv) {
+    int paths = (argc > 1) ? atoi(argv[1]) : 10000;
+    int errors = (argc > 2) ? atoi(argv[2]) : 2000;
+    int dests = paths / DSR_ROUTECACHE_MAX_PATHS;
+    uint8_t broken[2 * ETHER_ADDR_LEN];
+    double t_add = 0, t_error = 0, t;
+    long adds = 0, refills = 0;
+    int failures = 0;
+    int d, e, k;
+
+    srand(1);
+
+    t = bench_now();
+
+    for(d = 0; d < dests; d++) {
+        for(k = 0; k < DSR_ROUTECACHE_MAX_PATHS; k++) {
+            bench_add(d);
+            adds++;
+        }
+    }
+
+    t_add = bench_now() - t;
+
+    for(e = 0; e < errors; e++) {
+        dsr_path_t path;
+        uint8_t addr[ETHER_ADDR_LEN];
+        int hop;
+
+        /* break a link of some cached path */
+        do {
+            bench_addr(addr, 2, rand() % dests);
+        }
+        while(dsr_routecache_get_first(addr, &path) != DSR_ROUTECACHE_SUCCESS);
+
+        hop = rand() % (path.len - 1);
+        memcpy(broken, ADDR_IDX((&path), hop), ETHER_ADDR_LEN);
+        memcpy(broken + ETHER_ADDR_LEN, ADDR_IDX((&path), hop + 1), ETHER_ADDR_LEN);
+
+        t = bench_now();
+        dsr_routecache_process_link_error(broken, broken + ETHER_ADDR_LEN);
+        t_error += bench_now() - t;
+
+        if(e % CHECK_INTERVAL == 0) {
+            dsr_routecache_t* rc_el;
+            size_t i;
+
+            HASH_FOREACH(hh, dsr_routecache, rc_el) {
+                for(i = 0; i < rc_el->route_count; i++) {
+                    if(dsr_path_contains_link(rc_el->paths[i]->path, broken, broken + ETHER_ADDR_LEN) == DSR_PATH_LINK_FOUND) {
+                        failures++;
+                    }
+                }
+            }
+        }
+
+        /* refill destinations that lost paths */
+        for(d = 0; d < dests; d++) {
+            dsr_routecache_t* rc_el;
+
+            bench_addr(addr, 2, d);
+            HASH_FIND(hh, dsr_routecache, addr, ETHER_ADDR_LEN, rc_el);
+
+            if(rc_el == NULL || rc_el->route_count < DSR_ROUTECACHE_MAX_PATHS) {
+                t = bench_now();
+                bench_add(d);
+                t_add += bench_now() - t;
+                adds++;
+                refills++;
+            }
+        }
+    }
+
+    printf("paths %d dests %d: add %.3f us  link error %.3f us  refills/error %.1f  failures %d\n",
+           dests * DSR_ROUTECACHE_MAX_PATHS, dests, t_add / adds, t_error / errors,
+           (double) refills / errors, failures);
+
+    return failures ? 1 : 0;
+}
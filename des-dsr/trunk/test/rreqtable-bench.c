@@ -0,0 +1,151 @@
+#include "../dsr.h"
+#include <time.h>
+
+/*
+ * Route discovery scheduler benchmark. Thousands of route discoveries
+ * are started at once; in the SMR and backup path variants every
+ * discovery also opens a reply window. Reported are:
+ *  start   time to start one discovery (and open one reply window)
+ *  idle    one run_rreqtable while nothing is due
+ *  due     one run_rreqtable per due timer, all discoveries retry at once
+ *  threads rreqcache lookups per second of threads working on
+ *          disjoint RREQ sources
+ *
+ * The variant is the one of the build, so build once per PROTOCOL:
+ *   make clean rreqtable-bench DAEMON=6
+ * or pick it at runtime in a DAEMON=11 build.
+ *
+ * usage: rreqtable-bench [discoveries] [threads] [variant]
+ */
+
+#define IDLE_RUNS 100
+#define THREAD_OPS 200000
+#define TIMEOUT 200000 /* initial route discovery timeout */
+
+extern dsr_conf_t dsr_conf;
+
+static void bench_addr(uint8_t addr[ETHER_ADDR_LEN], uint8_t type, uint32_t n) {
+    addr[0] = 0x02;
+    addr[1] = type;
+    addr[2] = (n >> 24) & 0xff;
+    addr[3] = (n >> 16) & 0xff;
+    addr[4] = (n >> 8) & 0xff;
+    addr[5] = n & 0xff;
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+typedef struct bench_thread {
+    pthread_t thread;
+    int id;
+} bench_thread_t;
+
+static void* bench_worker(void* data) {
+    bench_thread_t* t = data;
+    uint8_t src[ETHER_ADDR_LEN], target[ETHER_ADDR_LEN];
+    int i;
+
+    bench_addr(target, 3, 0);
+
+    for(i = 0; i < THREAD_OPS; i++) {
+        /* 64 sources per thread, RREQs of a source are mostly seen before */
+        bench_addr(src, 4, t->id * 64 + i % 64);
+
+        if(dsr_is_rreqcache_entry_present(src, htons(i / 256), target) == DSR_RREQTABLE_FORWARD_RREQ) {
+            dsr_add_node_to_rreqtable_cache(src, htons(i / 256), target);
+        }
+    }
+
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    int discoveries = (argc > 1) ? atoi(argv[1]) : 5000;
+    int threads = (argc > 2) ? atoi(argv[2]) : 4;
+    bench_thread_t* workers = calloc(threads, sizeof(bench_thread_t));
+    uint8_t addr[ETHER_ADDR_LEN];
+    double t, t_start, t_idle, t_due;
+    int due = discoveries;
+    int i;
+    dessert_meshif_t iface;
+    dsr_rreq_ext_t rreq;
+    uint8_t self[ETHER_ADDR_LEN];
+
+#if (DSR_VARIANT_RUNTIME == 1)
+
+    if(argc > 3 && (dsr_variant = dsr_variant_get(argv[3])) == NULL) {
+        printf("unknown variant %s\n", argv[3]);
+        return 1;
+    }
+
+#endif
+
+    memset(&iface, 0, sizeof(iface));
+    memset(&rreq, 0, sizeof(rreq));
+    rreq.opt_data_len = DSR_RREQ_INITIAL_OPT_DATA_LEN;
+    bench_addr(self, 0, 0);
+
+    dsr_conf.routediscovery_timeout = TIMEOUT;
+    dsr_conf.routediscovery_maximum_retries = 3;
+    dsr_conf.routediscovery_expanding_ring_search = 0;
+
+    t = bench_now();
+
+    for(i = 0; i < discoveries; i++) {
+        bench_addr(addr, 2, i);
+        dsr_rreqtable_is_routediscovery_ok_now(addr);
+
+        if(_DSR_VARIANT_IS_SMR(PROTOCOL)) {
+            /* a single reply per window, so closing it sends nothing */
+            bench_addr(addr, 1, i);
+            dsr_smr_is_repl_ok(addr, htons(i), self, &iface, &rreq);
+        }
+    }
+
+    t_start = (bench_now() - t) / discoveries;
+
+    t = bench_now();
+
+    for(i = 0; i < IDLE_RUNS; i++) {
+        run_rreqtable(NULL, NULL, NULL);
+    }
+
+    t_idle = (bench_now() - t) / IDLE_RUNS;
+
+    /* the first retry of every discovery, plus every reply window in SMR */
+    if(_DSR_VARIANT_IS_SMR(PROTOCOL)) {
+        usleep(DSR_CONFVAR_SMR_RREQCACHE_REPLY_TIMEOUT_MSECS);
+        due += discoveries;
+    }
+    else {
+        usleep(TIMEOUT);
+    }
+
+    t = bench_now();
+    run_rreqtable(NULL, NULL, NULL);
+    t_due = (bench_now() - t) / due;
+
+    printf("%s: discoveries %d  start %.3f us  idle run %.3f us  due %.3f us/timer\n",
+           dsr_variant->name, discoveries, t_start, t_idle, t_due);
+
+    t = bench_now();
+
+    for(i = 0; i < threads; i++) {
+        workers[i].id = i;
+        pthread_create(&workers[i].thread, NULL, bench_worker, &workers[i]);
+    }
+
+    for(i = 0; i < threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    t = bench_now() - t;
+    printf("%s: threads %d  %.0f rreqcache lookups/s\n", dsr_variant->name, threads, threads * (double) THREAD_OPS / t * 1e6);
+
+    free(workers);
+    return 0;
+}
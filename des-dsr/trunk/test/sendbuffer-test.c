@@ -0,0 +1,213 @@
+#include "../dsr.h"
+#include <unistd.h>
+
+/*
+ * Send buffer tests on the real clock, the timer wheel ticks every
+ * DSR_CONFVAR_SENDBUFFER_WHEEL_TICK_USECS. The harness takes the place of
+ * the interface lookup of libdessert, sent msgs end in the maintenance
+ * buffer. Checked are:
+ *  pacing   a route to a queued destination sends the burst of the token
+ *           bucket at once and the rest with run_sendbuffer, never more
+ *           than the burst per run, also after a pause, and not faster
+ *           than the drain rate
+ *  unpaced  a drain rate of 0 sends all msgs at once
+ *  expiry   msgs are dropped by the first run after their timeout, each
+ *           with the timeout it was queued with, and not before
+ *  limits   a destination keeps its newest msgs only, the queue of a
+ *           destination without msgs is removed
+ *
+ * usage: sendbuffer-test
+ */
+
+#define RATE 200                /* msgs/s */
+#define BURST 4
+#define MSGS 40
+#define TICK DSR_CONFVAR_SENDBUFFER_WHEEL_TICK_USECS
+
+extern dsr_conf_t dsr_conf;
+
+static int errors = 0;
+
+#define CHECK(x) do { if(!(x)) { printf("FAILED line %i: %s\n", __LINE__, #x); errors++; } } while(0)
+
+static dessert_meshif_t iface;
+
+static void test_addr(uint8_t addr[ETHER_ADDR_LEN], uint8_t type, uint32_t n) {
+    addr[0] = 0x02;
+    addr[1] = type;
+    addr[2] = (n >> 24) & 0xff;
+    addr[3] = (n >> 16) & 0xff;
+    addr[4] = (n >> 8) & 0xff;
+    addr[5] = n & 0xff;
+}
+
+/* the only interface, replacing the lookup of libdessert */
+dessert_meshif_t* dessert_meshif_get_hwaddr(const uint8_t hwaddr[ETHER_ADDR_LEN]) {
+    return &iface;
+}
+
+static uint64_t test_now(void) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (uint64_t) now.tv_sec * 1000000 + now.tv_usec;
+}
+
+static void test_sleep_until(uint64_t usecs) {
+    uint64_t now = test_now();
+
+    if(usecs > now) {
+        usleep(usecs - now);
+    }
+}
+
+static dsr_sendbuffer_stats_t test_stats(void) {
+    dsr_sendbuffer_stats_t stats;
+    dsr_sendbuffer_get_stats(&stats);
+    return stats;
+}
+
+static void test_queue(const uint8_t dest[ETHER_ADDR_LEN], int count) {
+    int i;
+
+    for(i = 0; i < count; i++) {
+        dessert_msg_t* msg;
+        dessert_msg_new(&msg);
+        dsr_sendbuffer_add(dest, msg);
+    }
+}
+
+/* a route [self, neighbor, dest] */
+static void test_route(const uint8_t dest[ETHER_ADDR_LEN]) {
+    dsr_path_t* path = malloc(sizeof(dsr_path_t));
+
+    memset(path, 0, sizeof(dsr_path_t));
+    ADDR_CPY(ADDR_IDX(path, 0), iface.hwaddr);
+    test_addr(ADDR_IDX(path, 1), 1, 0);
+    ADDR_CPY(ADDR_IDX(path, 2), dest);
+    path->len = 3;
+    path->weight = 300;
+    dsr_routecache_add_path((uint8_t*) dest, path);
+}
+
+static void test_pacing(void) {
+    uint8_t dest[ETHER_ADDR_LEN];
+    dsr_sendbuffer_stats_t before = test_stats();
+    uint32_t sent;
+    uint64_t start;
+
+    test_addr(dest, 2, 1);
+    dsr_conf.sendbuffer_drain_rate = RATE;
+    dsr_conf.sendbuffer_drain_burst = BURST;
+    test_queue(dest, MSGS);
+    test_route(dest);
+
+    start = test_now();
+    dsr_sendbuffer_send_msgs_to(dest);
+    sent = test_stats().sent;
+    CHECK(sent - before.sent == BURST);
+
+    /* tokens of a longer pause are capped at the burst */
+    usleep(4 * BURST * 1000000 / RATE);
+    run_sendbuffer(NULL, NULL, NULL);
+    CHECK(test_stats().sent - sent == BURST);
+    sent = test_stats().sent;
+
+    while(test_stats().len > 0 && test_now() - start < 2000000) {
+        usleep(10000);
+        run_sendbuffer(NULL, NULL, NULL);
+        CHECK(test_stats().sent - sent <= BURST);
+        sent = test_stats().sent;
+    }
+
+    /* the token of the last msg is ready (MSGS - BURST) / RATE after the burst */
+    CHECK(sent - before.sent == MSGS);
+    CHECK(test_now() - start >= (uint64_t)(MSGS - BURST) * 1000000 / RATE);
+    CHECK(test_stats().queues == 0);
+    CHECK(test_stats().draining == 0);
+    printf("pacing: %u msgs in %.0f ms\n", sent - before.sent, (test_now() - start) / 1e3);
+}
+
+static void test_unpaced(void) {
+    uint8_t dest[ETHER_ADDR_LEN];
+    dsr_sendbuffer_stats_t before = test_stats();
+
+    test_addr(dest, 2, 2);
+    dsr_conf.sendbuffer_drain_rate = 0;
+    test_queue(dest, MSGS);
+    test_route(dest);
+    dsr_sendbuffer_send_msgs_to(dest);
+
+    CHECK(test_stats().sent - before.sent == MSGS);
+    CHECK(test_stats().len == 0);
+    CHECK(test_stats().queues == 0);
+}
+
+static void test_expiry(void) {
+    uint8_t dest[ETHER_ADDR_LEN];
+    dsr_sendbuffer_stats_t before = test_stats();
+    uint64_t start = test_now();
+
+    /* half of the msgs with a short, half with a long timeout, all to one destination */
+    test_addr(dest, 2, 3);
+    dsr_conf.sendbuffer_timeout = 3 * TICK;
+    test_queue(dest, MSGS / 2);
+    dsr_conf.sendbuffer_timeout = 8 * TICK;
+    test_queue(dest, MSGS / 2);
+
+    usleep(TICK);
+    run_sendbuffer(NULL, NULL, NULL);
+    CHECK(test_stats().timeouts == before.timeouts);
+    CHECK(test_stats().len == MSGS);
+
+    /* a timeout may round up to the next tick */
+    test_sleep_until(start + 5 * TICK);
+    run_sendbuffer(NULL, NULL, NULL);
+    CHECK(test_stats().timeouts - before.timeouts == MSGS / 2);
+    CHECK(test_stats().len == MSGS / 2);
+    CHECK(test_stats().queues == 1);
+
+    test_sleep_until(start + 10 * TICK);
+    run_sendbuffer(NULL, NULL, NULL);
+    CHECK(test_stats().timeouts - before.timeouts == MSGS);
+    CHECK(test_stats().len == 0);
+    CHECK(test_stats().queues == 0);
+}
+
+static void test_limits(void) {
+    uint8_t dest[ETHER_ADDR_LEN];
+    dsr_sendbuffer_stats_t before = test_stats();
+
+    test_addr(dest, 2, 4);
+    dsr_conf.sendbuffer_timeout = TICK;
+    test_queue(dest, DSR_CONFVAR_SENDBUFFER_MAX_PACKETS_PER_DEST + 6);
+    CHECK(test_stats().drops_dest - before.drops_dest == 6);
+    CHECK(test_stats().len == DSR_CONFVAR_SENDBUFFER_MAX_PACKETS_PER_DEST);
+
+    usleep(3 * TICK);
+    run_sendbuffer(NULL, NULL, NULL);
+    CHECK(test_stats().len == 0);
+    CHECK(test_stats().queues == 0);
+}
+
+int main(int argc, char** argv) {
+    memset(&iface, 0, sizeof(iface));
+    test_addr(iface.hwaddr, 0, 0);
+    test_addr(dessert_l25_defsrc, 0, 1);
+
+    dsr_conf_initialize();
+    dsr_conf.routemaintenance_passive_ack = 0;
+    dsr_conf.routemaintenance_network_ack = 1;
+
+    if(dsr_variant->linkcache == 1) {
+        dsr_linkcache_init(dessert_l25_defsrc);
+    }
+
+    test_pacing();
+    test_unpaced();
+    test_expiry();
+    test_limits();
+
+    printf("sendbuffer-test: %i errors\n", errors);
+
+    return errors ? 1 : 0;
+}
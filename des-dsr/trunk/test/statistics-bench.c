@@ -0,0 +1,284 @@
+#include "../dsr.h"
+#include <time.h>
+
+/*
+ * Statistics overhead benchmark. Threads send and receive msgs on links
+ * of their own and count every msg as helper.c and the mesh rx callback
+ * do. Per msg of all threads it reports:
+ *  off       no counting at all
+ *  locked    counting with one global lock and a single link hash, as
+ *            statistics.c used to; done on a copy kept by the benchmark
+ *  lockfree  dsr_statistics_tx_msg and statistics_meshrx_cb, counting into
+ *            the block of the thread
+ * and the time to sum up the blocks and to append them to a CSV file. The
+ * summed up counters are checked against the msgs sent and received.
+ *
+ * usage: statistics-bench [msgs per thread] [max threads] [links per thread]
+ */
+
+#define EXPORT_FILE "/tmp/statistics-bench.csv"
+
+typedef struct bench_link {
+    uint8_t key[2 * ETHER_ADDR_LEN];
+    int counters[35];
+    UT_hash_handle hh;
+} bench_link_t;
+
+typedef struct bench_thread {
+    pthread_t thread;
+    int id;
+    int mode;
+} bench_thread_t;
+
+enum { MODE_OFF, MODE_LOCKED, MODE_LOCKFREE };
+
+static const char* mode_names[] = { "off", "locked", "lockfree" };
+
+static int msgs = 1000000;
+static int links = 16;
+static bench_link_t* locked_links = NULL;
+static int locked_total[35];
+static pthread_mutex_t locked_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void bench_addr(uint8_t addr[ETHER_ADDR_LEN], uint8_t type, uint32_t n) {
+    addr[0] = 0x02;
+    addr[1] = type;
+    addr[2] = (n >> 24) & 0xff;
+    addr[3] = (n >> 16) & 0xff;
+    addr[4] = (n >> 8) & 0xff;
+    addr[5] = n & 0xff;
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* a data msg with a source route, a routing msg with a RREQ */
+static dessert_msg_t* bench_new_msg(int data) {
+    dessert_msg_t* msg;
+    dessert_ext_t* ext;
+
+    dessert_msg_new(&msg);
+
+    if(data) {
+        dessert_msg_addext(msg, &ext, DESSERT_EXT_ETH, ETHER_HDR_LEN);
+        dessert_msg_addext(msg, &ext, DSR_EXT_SOURCE, 2 + 4 * ETHER_ADDR_LEN);
+        msg->plen = htons(1000);
+    }
+    else {
+        dessert_msg_addext(msg, &ext, DSR_EXT_RREQ, 4 + 2 * ETHER_ADDR_LEN);
+    }
+
+    return msg;
+}
+
+/* the old dsr_statistics_tx_msg, reduced to the same lookups and counts */
+static void bench_locked_tx(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN], dessert_msg_t* msg) {
+    bench_link_t* link = NULL;
+    dessert_ext_t* ext = NULL;
+    uint8_t key[2 * ETHER_ADDR_LEN];
+
+    memcpy(key, local, ETHER_ADDR_LEN);
+    memcpy(key + ETHER_ADDR_LEN, remote, ETHER_ADDR_LEN);
+
+    pthread_mutex_lock(&locked_mutex);
+    HASH_FIND(hh, locked_links, key, sizeof(key), link);
+
+    if(link == NULL) {
+        link = calloc(1, sizeof(bench_link_t));
+        memcpy(link->key, key, sizeof(key));
+        HASH_ADD(hh, locked_links, key, sizeof(key), link);
+    }
+
+    locked_total[0] += ntohs(msg->plen);
+    locked_total[1] += ntohs(msg->hlen);
+    link->counters[0] += ntohs(msg->plen);
+    link->counters[1] += ntohs(msg->hlen);
+
+    if(dessert_msg_getext(msg, &ext, DESSERT_EXT_ETH, 0) > 0) {
+        locked_total[2]++;
+        link->counters[2]++;
+    }
+    else {
+        locked_total[3]++;
+        link->counters[3]++;
+    }
+
+    if(dessert_msg_getext(msg, &ext, DSR_EXT_RREQ, 0) > 0) {
+        locked_total[4]++;
+        link->counters[4]++;
+    }
+
+    if(dessert_msg_getext(msg, &ext, DSR_EXT_SOURCE, 0) > 0) {
+        locked_total[5]++;
+        link->counters[5]++;
+    }
+
+    if(dessert_msg_getext(msg, &ext, DSR_EXT_REPL, 0) > 0) {
+        locked_total[6]++;
+        link->counters[6]++;
+    }
+
+    if(dessert_msg_getext(msg, &ext, DSR_EXT_RERR, 0) > 0) {
+        locked_total[7]++;
+        link->counters[7]++;
+    }
+
+    if(dessert_msg_getext(msg, &ext, DSR_EXT_ACK, 0) > 0) {
+        locked_total[8]++;
+        link->counters[8]++;
+    }
+
+    if(dessert_msg_getext(msg, &ext, DSR_EXT_ACKREQ, 0) > 0) {
+        locked_total[9]++;
+        link->counters[9]++;
+    }
+
+    pthread_mutex_unlock(&locked_mutex);
+}
+
+static void* bench_worker(void* data) {
+    bench_thread_t* t = data;
+    dessert_meshif_t iface;
+    dessert_msg_proc_t proc;
+    uint8_t (*remote)[ETHER_ADDR_LEN] = calloc(links, ETHER_ADDR_LEN);
+    dessert_msg_t* bench_msg[2];
+    int i;
+
+    bench_msg[0] = bench_new_msg(1);
+    bench_msg[1] = bench_new_msg(0);
+
+    memset(&iface, 0, sizeof(iface));
+    memset(&proc, 0, sizeof(proc));
+    proc.lflags = DESSERT_RX_FLAG_L2_DST;
+    bench_addr(iface.hwaddr, 0, t->id);
+
+    for(i = 0; i < links; i++) {
+        bench_addr(remote[i], 1, t->id * links + i);
+    }
+
+    for(i = 0; i < msgs; i++) {
+        dessert_msg_t* msg = bench_msg[i & 1];
+
+        switch(t->mode) {
+            case MODE_OFF:
+                __asm__ volatile("" : : "r"(msg) : "memory");
+                break;
+            case MODE_LOCKED:
+                bench_locked_tx(iface.hwaddr, remote[i % links], msg);
+                break;
+            case MODE_LOCKFREE:
+                if(i & 2) {
+                    dsr_statistics_tx_msg(iface.hwaddr, remote[i % links], msg);
+                }
+                else {
+                    ADDR_CPY(msg->l2h.ether_shost, remote[i % links]);
+                    statistics_meshrx_cb(msg, 0, &proc, &iface, 0);
+                }
+
+                break;
+        }
+    }
+
+    dessert_msg_destroy(bench_msg[0]);
+    dessert_msg_destroy(bench_msg[1]);
+    free(remote);
+    return NULL;
+}
+
+static double bench_run(int threads, int mode) {
+    bench_thread_t* workers = calloc(threads, sizeof(bench_thread_t));
+    double t = bench_now();
+    int i;
+
+    for(i = 0; i < threads; i++) {
+        workers[i].id = i;
+        workers[i].mode = mode;
+        pthread_create(&workers[i].thread, NULL, bench_worker, &workers[i]);
+    }
+
+    for(i = 0; i < threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    t = bench_now() - t;
+
+    free(workers);
+    return t * 1e3 / ((double) threads * msgs);
+}
+
+int main(int argc, char** argv) {
+    int max_threads = (argc > 2) ? atoi(argv[2]) : 4;
+    uint64_t expected_msgs = 0;
+    dsr_statistics_t stat;
+    dsr_statistics_link_t* link;
+    double t, t_get, t_export;
+    int threads, mode, lines = 0, nodes = 0, errors = 0;
+    char line[4096];
+    FILE* f;
+
+    msgs = (argc > 1) ? atoi(argv[1]) : msgs;
+    links = (argc > 3) ? atoi(argv[3]) : links;
+
+    for(threads = 1; threads <= max_threads; threads *= 2) {
+        double ns[3];
+
+        for(mode = MODE_OFF; mode <= MODE_LOCKFREE; mode++) {
+            ns[mode] = bench_run(threads, mode);
+        }
+
+        expected_msgs += (uint64_t) threads * msgs;
+        printf("threads %d links %d: per msg %s %.1f ns  %s %.1f ns  %s %.1f ns\n", threads, links,
+               mode_names[MODE_OFF], ns[MODE_OFF], mode_names[MODE_LOCKED], ns[MODE_LOCKED],
+               mode_names[MODE_LOCKFREE], ns[MODE_LOCKFREE]);
+    }
+
+    t = bench_now();
+    dsr_statistics_get(&stat);
+    t_get = bench_now() - t;
+
+    if(stat.total.tx_data + stat.total.tx_routing + stat.total.rx_data + stat.total.rx_routing != expected_msgs) {
+        printf("counted %" PRIu64 " msgs, sent and received %" PRIu64 "\n",
+               stat.total.tx_data + stat.total.tx_routing + stat.total.rx_data + stat.total.rx_routing, expected_msgs);
+        errors++;
+    }
+
+    if(stat.total.rx_source + stat.total.tx_source != stat.total.rx_data + stat.total.tx_data
+       || stat.total.rx_rreq + stat.total.tx_rreq != stat.total.rx_routing + stat.total.tx_routing) {
+        printf("extension counters do not match the msg counters\n");
+        errors++;
+    }
+
+    HASH_FOREACH(hh, stat.nodes, link) {
+        nodes++;
+    }
+
+    dsr_statistics_free(&stat);
+
+    unlink(EXPORT_FILE);
+    t = bench_now();
+    dsr_statistics_export(EXPORT_FILE, DSR_STATISTICS_FORMAT_CSV);
+    t_export = bench_now() - t;
+
+    /* a header line, the total and one line per link */
+    if((f = fopen(EXPORT_FILE, "r")) != NULL) {
+        while(fgets(line, sizeof(line), f) != NULL) {
+            lines++;
+        }
+
+        fclose(f);
+    }
+
+    if(lines != nodes + 2) {
+        printf("export has %d lines for %d links\n", lines, nodes);
+        errors++;
+    }
+
+    unlink(EXPORT_FILE);
+
+    printf("links %d: sum up %.1f us  csv export %.1f us  errors %d\n", nodes, t_get, t_export, errors);
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+#include "../dsr.h"
+#include <time.h>
+
+/*
+ * Variant dispatch benchmark: the per packet cost of calling the variant
+ * functions through dsr_variant. A route cache is filled with paths to
+ * some hundred destinations, then per packet a path is looked up and the
+ * weight of a hop is taken. Every call is made
+ *  direct   to the function by name, as the #if builds did
+ *  variant  through DSR_VARIANT_CALL, a direct call again in a single
+ *           variant build, an indirect one through dsr_variant in
+ *           des-dsr-multi
+ *  table    through dsr_variants[] with an index the compiler can't see,
+ *           always an indirect call
+ * and the overhead of variant and table over direct is reported. The
+ * direct calls and the table entry are those of des-dsr, so build once
+ * as des-dsr and once as des-dsr-multi:
+ *   make clean variant-bench DAEMON=1
+ *   make clean variant-bench DAEMON=11
+ *
+ * usage: variant-bench [packets] [destinations]
+ */
+
+#define RELAYS 50
+#define MAX_RELAYS_PER_PATH 6
+
+static uint8_t src[ETHER_ADDR_LEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+static void bench_addr(uint8_t addr[ETHER_ADDR_LEN], uint8_t type, uint32_t n) {
+    addr[0] = 0x02;
+    addr[1] = type;
+    addr[2] = (n >> 24) & 0xff;
+    addr[3] = (n >> 16) & 0xff;
+    addr[4] = (n >> 8) & 0xff;
+    addr[5] = n & 0xff;
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* src, 1..MAX_RELAYS_PER_PATH relays, dest */
+static dsr_path_t* bench_path(uint32_t dest) {
+    dsr_path_t* path = malloc(sizeof(dsr_path_t));
+    int relays = 1 + rand() % MAX_RELAYS_PER_PATH;
+    int i;
+
+    memset(path, 0, sizeof(dsr_path_t));
+    ADDR_CPY(ADDR_IDX(path, 0), src);
+
+    for(i = 1; i <= relays; i++) {
+        bench_addr(ADDR_IDX(path, i), 1, (dest + i) % RELAYS);
+    }
+
+    bench_addr(ADDR_IDX(path, relays + 1), 2, dest);
+    path->len = relays + 2;
+    path->weight = path->len * 100 + rand() % 100;
+    return path;
+}
+
+static void bench_report(const char* what, double direct, double variant, double table, int packets) {
+    printf("%s: %-10s direct %.2f ns  variant %.2f ns (%+.1f%%)  table %.2f ns (%+.1f%%)\n",
+           dsr_variant->name, what, direct * 1e3 / packets, variant * 1e3 / packets,
+           (variant - direct) * 100 / direct, table * 1e3 / packets, (table - direct) * 100 / direct);
+}
+
+int main(int argc, char** argv) {
+    int packets = (argc > 1) ? atoi(argv[1]) : 5000000;
+    int dests = (argc > 2) ? atoi(argv[2]) : 256;
+    uint8_t (*addr)[ETHER_ADDR_LEN] = calloc(dests, ETHER_ADDR_LEN);
+    volatile int index = 0;
+    volatile uint32_t sink = 0;
+    dsr_path_t path;
+    double t, t_direct, t_variant, t_table;
+    int d, k, i;
+
+#if (DSR_VARIANT_RUNTIME == 1)
+    dsr_variant = dsr_variant_get("des-dsr");
+#endif
+
+    /* the table entry doing the same as the direct calls */
+    while(strcmp(dsr_variants[index].name, "des-dsr") != 0) {
+        index++;
+    }
+
+    if(dsr_variant->get_path != dsr_routecache_get_first || dsr_variant->hop_weight != dsr_etx_get_hop_weight) {
+        printf("%s: variant calls other functions than direct and table\n", dsr_variant->name);
+    }
+
+    srand(1);
+
+    for(d = 0; d < dests; d++) {
+        bench_addr(addr[d], 2, d);
+
+        for(k = 0; k < DSR_ROUTECACHE_MAX_PATHS; k++) {
+            dsr_routecache_add_path(addr[d], bench_path(d));
+        }
+    }
+
+    /* path lookups */
+    t = bench_now();
+
+    for(i = 0; i < packets; i++) {
+        sink += dsr_routecache_get_first(addr[i % dests], &path);
+    }
+
+    t_direct = bench_now() - t;
+    t = bench_now();
+
+    for(i = 0; i < packets; i++) {
+        sink += DSR_VARIANT_CALL(get_path)(addr[i % dests], &path);
+    }
+
+    t_variant = bench_now() - t;
+    t = bench_now();
+
+    for(i = 0; i < packets; i++) {
+        sink += dsr_variants[index].get_path(addr[i % dests], &path);
+    }
+
+    t_table = bench_now() - t;
+    bench_report("get_path", t_direct, t_variant, t_table, packets);
+
+    /* hop weights */
+    t = bench_now();
+
+    for(i = 0; i < packets; i++) {
+        sink += dsr_etx_get_hop_weight(src, addr[i % dests]);
+    }
+
+    t_direct = bench_now() - t;
+    t = bench_now();
+
+    for(i = 0; i < packets; i++) {
+        sink += DSR_VARIANT_CALL(hop_weight)(src, addr[i % dests]);
+    }
+
+    t_variant = bench_now() - t;
+    t = bench_now();
+
+    for(i = 0; i < packets; i++) {
+        sink += dsr_variants[index].hop_weight(src, addr[i % dests]);
+    }
+
+    t_table = bench_now() - t;
+    bench_report("hop_weight", t_direct, t_variant, t_table, packets);
+
+    free(addr);
+    return 0;
+}
@@ -0,0 +1,137 @@
+/******************************************************************************
+ Copyright 2010, David Gutzmann, Freie Universitaet Berlin (FUB).
+ All rights reserved.
+
+ These sources were originally developed by David Gutzmann
+ at Freie Universitaet Berlin (http://www.fu-berlin.de/),
+ Computer Systems and Telematics / Distributed, Embedded Systems (DES) group
+ (http://cst.mi.fu-berlin.de/, http://www.des-testbed.net/)
+ ------------------------------------------------------------------------------
+ This program is free software: you can redistribute it and/or modify it under
+ the terms of the GNU General Public License as published by the Free Software
+ Foundation, either version 3 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with
+ this program. If not, see http://www.gnu.org/licenses/ .
+ ------------------------------------------------------------------------------
+ For further information and questions please use the web site
+ http://www.des-testbed.net/
+ ------------------------------------------------------------------------------
+
+ ******************************************************************************/
+
+#include "dsr.h"
+
+#define _NAME_PREFIX "des-dsr-"
+
+/* the single variant builds, by DAEMON */
+const dsr_variant_t dsr_variants[] = {
+    DSR_VARIANT("des-dsr-hc",            "DSRH", DSR,                  HC,  0, 0, 1),
+    DSR_VARIANT("des-dsr",               "DSR1", DSR,                  ETX, 0, 0, 1),
+    DSR_VARIANT("des-dsr-etx",           "DSR2", ETXDSR,               ETX, 0, 0, 1),
+    DSR_VARIANT("des-dsr-linkcache",     "DSR3", DSR,                  ETX, 1, 0, 1),
+    DSR_VARIANT("des-dsr-linkcache-etx", "DSR4", ETXDSR,               ETX, 1, 0, 1),
+    DSR_VARIANT("des-dsr-mdsr",          "DSR5", MDSR_PROTOKOLL_1,     ETX, 0, 0, 2),
+    DSR_VARIANT("des-dsr-smr",           "DSR6", SMR,                  ETX, 0, 1, 2),
+    DSR_VARIANT("des-dsr-backuppath1",   "DSR7", BACKUPPATH_VARIANT_1, ETX, 0, 0, 2),
+    DSR_VARIANT("des-dsr-backuppath2",   "DSR8", BACKUPPATH_VARIANT_2, ETX, 0, 0, 2),
+    DSR_VARIANT("des-dsr-etx-backup",    "DSR9", ETXDSR,               ETX, 0, 0, 2),
+    DSR_VARIANT("des-dsr-etx-lb",        "DSR0", ETXDSR,               ETX, 0, 1, 2),
+    { .name = NULL }
+};
+
+#if (DSR_VARIANT_RUNTIME == 1)
+const dsr_variant_t* dsr_variant = &dsr_variants[1];
+#endif
+
+/** The variant called @a name, with or without the "des-dsr-" prefix, or NULL. */
+const dsr_variant_t* dsr_variant_get(const char* name) {
+    const dsr_variant_t* v;
+
+    for(v = dsr_variants; v->name != NULL; v++) {
+        if(strcmp(v->name, name) == 0
+           || (strncmp(v->name, _NAME_PREFIX, strlen(_NAME_PREFIX)) == 0 && strcmp(v->name + strlen(_NAME_PREFIX), name) == 0)) {
+            return v;
+        }
+    }
+
+    return NULL;
+}
+
+/** Chooses the variant named by a "set variant <name>" line of @a cfg. Has
+ *  to run before dessert_init, which takes the protocol string of the
+ *  variant, so the line is looked up before the config is applied. Logging
+ *  is not set up yet, so nothing is logged here.
+ *  @return the name of an unknown variant in @a cfg, NULL if there is none */
+const char* dsr_variant_configure(FILE* cfg) {
+#if (DSR_VARIANT_RUNTIME == 1)
+    static char unknown_name[64];
+    char line[256];
+    char name[64];
+    const char* unknown = NULL;
+    long pos;
+
+    /* the config may be a pipe, then there is no looking ahead */
+    if(cfg == NULL || (pos = ftell(cfg)) < 0) {
+        return NULL;
+    }
+
+    while(fgets(line, sizeof(line), cfg) != NULL) {
+        if(sscanf(line, " set variant %63s", name) == 1) {
+            const dsr_variant_t* v = dsr_variant_get(name);
+
+            if(v == NULL) {
+                strcpy(unknown_name, name);
+                unknown = unknown_name;
+            }
+            else {
+                dsr_variant = v;
+            }
+        }
+    }
+
+    fseek(cfg, pos, SEEK_SET);
+    return unknown;
+#else
+    return NULL;
+#endif
+}
+
+/** CLI command - config mode - set variant $name */
+int dsr_cli_cmd_set_variant(struct cli_def* cli, char* command, char* argv[], int argc) {
+    const dsr_variant_t* v;
+
+    if(argc != 1 || (v = dsr_variant_get(argv[0])) == NULL) {
+        cli_print(cli, "usage %s [variant]\n", command);
+        return CLI_ERROR;
+    }
+
+    /* the caches, the rreqtable and the protocol string belong to the variant */
+    if(strcmp(v->name, dsr_variant->name) != 0) {
+        cli_print(cli, "running %s, the variant is chosen at startup by \"set variant\" in the config file", dsr_variant->name);
+        return CLI_ERROR;
+    }
+
+    return CLI_OK;
+}
+
+int dessert_cli_cmd_showvariant(struct cli_def* cli, char* command, char* argv[], int argc) {
+    cli_print(cli, "variant[%s] proto[%s] protocol[%i] metric[%i] linkcache[%i] load_balancing[%i] keep_paths[%i]",
+              dsr_variant->name, dsr_variant->proto_string, dsr_variant->protocol, dsr_variant->metric,
+              dsr_variant->linkcache, dsr_variant->load_balancing, dsr_variant->keep_paths);
+
+#if (DSR_VARIANT_RUNTIME == 1)
+    const dsr_variant_t* v;
+
+    for(v = dsr_variants; v->name != NULL; v++) {
+        cli_print(cli, "available[%s]", v->name);
+    }
+#endif
+
+    return CLI_OK;
+}
@@ -0,0 +1,135 @@
+/******************************************************************************
+ Copyright 2010, David Gutzmann, Freie Universitaet Berlin (FUB).
+ All rights reserved.
+
+ These sources were originally developed by David Gutzmann
+ at Freie Universitaet Berlin (http://www.fu-berlin.de/),
+ Computer Systems and Telematics / Distributed, Embedded Systems (DES) group
+ (http://cst.mi.fu-berlin.de/, http://www.des-testbed.net/)
+ ------------------------------------------------------------------------------
+ This program is free software: you can redistribute it and/or modify it under
+ the terms of the GNU General Public License as published by the Free Software
+ Foundation, either version 3 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along with
+ this program. If not, see http://www.gnu.org/licenses/ .
+ ------------------------------------------------------------------------------
+ For further information and questions please use the web site
+ http://www.des-testbed.net/
+ ------------------------------------------------------------------------------
+
+ ******************************************************************************/
+#ifndef VARIANT_H_
+#define VARIANT_H_
+
+#include "dsr.h"
+
+/******************************************************************************
+ *
+ * Protocol variants
+ *
+ * A variant is a choice of PROTOCOL, METRIC, LINKCACHE and LOAD_BALANCING
+ * together with the functions that differ between them on the packet path.
+ * Those are called with DSR_VARIANT_CALL(hook)(args). Every DAEMON but one
+ * builds a single variant: there the hook is picked by the preprocessor, so
+ * the call is a direct call even without optimization, and dsr_variant is a
+ * constant the compiler sees, so the tests of PROTOCOL, METRIC, ... fold away
+ * as the #ifs did before. DAEMON 11 (des-dsr-multi) builds all of them;
+ * dsr_variant is chosen at startup by a "set variant <name>" line in the
+ * config file, the hooks are called through it and the tests look at it at
+ * runtime.
+ ******************************************************************************/
+
+typedef struct dsr_variant {
+    const char* name;         /* DAEMON_NAME of the single variant build */
+    const char* proto_string; /* DESSERT_PROTO_STRING, variants don't talk to each other */
+    int protocol;
+    int metric;
+    int linkcache;
+    int load_balancing;
+    int keep_paths;           /* paths kept per destination in the route cache */
+
+    /** route cache policy: the path the next packet to @a dest is sent on */
+    int (*get_path)(const uint8_t dest[ETHER_ADDR_LEN], dsr_path_t* path);
+    /** route cache policy: position of a new path in the path list of its destination, -1 to drop it */
+    int (*insert_position)(dsr_routecache_t* rc_el, dsr_path_t* path);
+    /** metric: weight of the hop between @a local and @a remote */
+    uint16_t (*hop_weight)(const uint8_t local[ETHER_ADDR_LEN], const uint8_t remote[ETHER_ADDR_LEN]);
+    /** link cache: caches the route of a REPL to a route discovery of ours */
+    void (*cache_repl)(dsr_repl_ext_t* repl);
+    /** RREQ forwarding rule, DSR_RREQTABLE_FORWARD_RREQ or DSR_RREQTABLE_DONT_FORWARD_RREQ */
+    int (*forward_rreq)(dessert_meshif_t* iface, dessert_msg_t* msg, dsr_rreq_ext_t* rreq);
+    /** reply selection at the target, DSR_RREQTABLE_REPLY_OK or DSR_RREQTABLE_REPLY_NOT_OK */
+    int (*reply_rreq)(dessert_meshif_t* iface, dsr_rreq_ext_t* rreq);
+} dsr_variant_t;
+
+#define _DSR_VARIANT_IS_SMR(_protocol) \
+    ((_protocol) == SMR || (_protocol) == BACKUPPATH_VARIANT_1 || (_protocol) == BACKUPPATH_VARIANT_2)
+
+/* the function of each hook for a choice of PROTOCOL, METRIC, LINKCACHE and LOAD_BALANCING */
+#define _DSR_VARIANT_get_path(_protocol, _metric, _linkcache, _load_balancing) \
+    (((_load_balancing) == 1) ? dsr_routecache_get_next_round_robin : dsr_routecache_get_first)
+#define _DSR_VARIANT_insert_position(_protocol, _metric, _linkcache, _load_balancing) \
+    (((_protocol) == MDSR_PROTOKOLL_1) ? dsr_routecache_insert_in_order \
+     : ((_protocol) == SMR || (_protocol) == BACKUPPATH_VARIANT_2) ? dsr_routecache_insert_two_in_order \
+     : ((_protocol) == BACKUPPATH_VARIANT_1) ? dsr_routecache_insert_primary_second \
+     : dsr_routecache_insert_by_weight)
+#define _DSR_VARIANT_hop_weight(_protocol, _metric, _linkcache, _load_balancing) \
+    (((_metric) == ETX) ? dsr_etx_get_hop_weight : dsr_hc_get_hop_weight)
+#define _DSR_VARIANT_cache_repl(_protocol, _metric, _linkcache, _load_balancing) \
+    (((_linkcache) == 1) ? dsr_msg_cache_repl_ext_to_linkcache : dsr_msg_cache_repl_ext_to_routecache)
+#define _DSR_VARIANT_forward_rreq(_protocol, _metric, _linkcache, _load_balancing) \
+    (((_protocol) == ETXDSR) ? dsr_rreqtable_forward_rreq_if_better \
+     : _DSR_VARIANT_IS_SMR(_protocol) ? dsr_rreqtable_forward_rreq_smr \
+     : dsr_rreqtable_forward_rreq_once)
+#define _DSR_VARIANT_reply_rreq(_protocol, _metric, _linkcache, _load_balancing) \
+    (((_protocol) == MDSR_PROTOKOLL_1) ? dsr_rreqtable_reply_rreq_mdsr \
+     : _DSR_VARIANT_IS_SMR(_protocol) ? dsr_rreqtable_reply_rreq_smr \
+     : dsr_rreqtable_reply_rreq_always)
+
+#define _DSR_VARIANT_HOOK(_hook, _protocol, _metric, _linkcache, _load_balancing) \
+    ._hook = _DSR_VARIANT_##_hook(_protocol, _metric, _linkcache, _load_balancing)
+
+/** Initializer of a dsr_variant_t, picks the functions from the choices. */
+#define DSR_VARIANT(_name, _proto_string, _protocol, _metric, _linkcache, _load_balancing, _keep_paths) { \
+    .name = _name, \
+    .proto_string = _proto_string, \
+    .protocol = _protocol, \
+    .metric = _metric, \
+    .linkcache = _linkcache, \
+    .load_balancing = _load_balancing, \
+    .keep_paths = _keep_paths, \
+    _DSR_VARIANT_HOOK(get_path, _protocol, _metric, _linkcache, _load_balancing), \
+    _DSR_VARIANT_HOOK(insert_position, _protocol, _metric, _linkcache, _load_balancing), \
+    _DSR_VARIANT_HOOK(hop_weight, _protocol, _metric, _linkcache, _load_balancing), \
+    _DSR_VARIANT_HOOK(cache_repl, _protocol, _metric, _linkcache, _load_balancing), \
+    _DSR_VARIANT_HOOK(forward_rreq, _protocol, _metric, _linkcache, _load_balancing), \
+    _DSR_VARIANT_HOOK(reply_rreq, _protocol, _metric, _linkcache, _load_balancing) \
+}
+
+/** all variants, terminated by an entry without name */
+extern const dsr_variant_t dsr_variants[];
+
+#if (DSR_VARIANT_RUNTIME == 1)
+extern const dsr_variant_t* dsr_variant;
+/** the function of @a _hook of the variant, call as DSR_VARIANT_CALL(hook)(args) */
+#define DSR_VARIANT_CALL(_hook) (dsr_variant->_hook)
+#else
+static const dsr_variant_t _dsr_variant_compiled = DSR_VARIANT(DAEMON_NAME, DESSERT_PROTO_STRING,
+        PROTOCOL, METRIC, LINKCACHE, LOAD_BALANCING, DSR_ROUTECACHE_MAX_PATHS);
+#define dsr_variant (&_dsr_variant_compiled)
+#define DSR_VARIANT_CALL(_hook) _DSR_VARIANT_##_hook(PROTOCOL, METRIC, LINKCACHE, LOAD_BALANCING)
+#endif
+
+const dsr_variant_t* dsr_variant_get(const char* name);
+const char* dsr_variant_configure(FILE* cfg);
+
+int dsr_cli_cmd_set_variant(struct cli_def* cli, char* command, char* argv[], int argc);
+int dessert_cli_cmd_showvariant(struct cli_def* cli, char* command, char* argv[], int argc);
+
+#endif /* VARIANT_H_ */
@@ -38,6 +38,14 @@ dessert_result_t lsr_db_tc_neighbor_update(mac_addr node_addr, mac_addr neighbor
 }
 
 bool lsr_db_broadcast_check_seq_nr(mac_addr node_addr, uint16_t seq_nr) {
+	//most flooded packets are duplicates: filter them without the write lock
+	pthread_rwlock_rdlock(&db_lock);
+	bool seen = lsr_tc_seen_broadcast_seq_nr(node_addr, seq_nr);
+	pthread_rwlock_unlock(&db_lock);
+	if(seen) {
+		return false;
+	}
+
 	pthread_rwlock_wrlock(&db_lock);
 	bool result = lsr_tc_check_broadcast_seq_nr(node_addr, seq_nr);
 	pthread_rwlock_unlock(&db_lock);
@@ -11,11 +11,6 @@ typedef struct neighbor_info {
 	uint8_t weight;
 } neighbor_info_t;
 
-struct seq_interval {
-	uint16_t start; //inclusive
-	uint16_t end; //exclusive
-};
-
 dessert_result_t lsr_db_dump_neighbor_table(neighbor_info_t **result, int *neighbor_count);
 
 /**
@@ -1,17 +1,14 @@
 #include "lsr_node.h"
 #include "lsr_tc.h"
 #include "lsr_database.h"
-
-static const uint64_t SEQ_NR_THRESHOLD = 500; //consider sequence numbers of at most threshold smaller then the current as older
+#include "../lsr_config.h"
 
 node_t *lsr_node_new(mac_addr addr) {
 	node_t *this = calloc(1, sizeof(*this));
-	this->multicast_seq_nr = 0;
-	this->unicast_seq_nr = 0;
 	this->timeout.tv_sec = INT32_MAX;
 	this->timeout.tv_usec = 999999;
-	this->multicast_gaps = NULL;
-	this->unicast_gaps = NULL;
+	this->multicast_seq = NULL;
+	this->unicast_seq = NULL;
 	this->neighbors = NULL;
 	this->next_hop = NULL;
 	this->weight = INFINITE_WEIGHT;
@@ -40,8 +37,8 @@ bool lsr_node_age(node_t *this, const struct timeval *now) {
 }
 
 void lsr_node_delete(node_t *this) {
-	free(this->multicast_gaps);
-	free(this->unicast_gaps);
+	free(this->multicast_seq);
+	free(this->unicast_seq);
 	free(this->neighbors);
 	free(this);
 }
@@ -92,89 +89,34 @@ void lsr_node_update_neighbor(node_t *this, node_t *neighbor, struct timeval tim
 	this->neighbors[i].weight = weight;
 }
 
-static int _gap_insert_index(struct seq_interval *gaps, uint16_t seq_nr){
-	int insert_index = 0;
-	for(int i = 0; i < GAP_COUNT; ++i) {
-		if(gaps[i].start == gaps[i].end) {
-			insert_index = i;
-			break;
-		}
-		if(seq_nr - gaps[i].start < seq_nr - gaps[insert_index].start) {
-			insert_index = i;
-		}
-	}
-	return insert_index;
-}
-
-static void _split_gap(struct seq_interval *gaps, uint64_t x, int index, uint16_t seq_nr) {
-	if(x == gaps[index].start) {
-		gaps[index].start = x + 1;
-		return;
-	}
-	if(x == gaps[index].end - 1U) {
-		gaps[index].end = x;
-		return;
-	}
-	
-	int insert_index = _gap_insert_index(gaps, seq_nr);
-	
-	gaps[insert_index].start = gaps[index].start;
-	gaps[insert_index].end = x;
-	gaps[index].start = x + 1;
-}
-
-static uint64_t _guess_seq_nr(uint64_t old, uint16_t new) {
-	uint64_t guess = new;
-	if(guess >= old) {
-		return guess;
-	}
-	guess += ((old - guess) & ~(uint64_t)UINT16_MAX);
-	while(guess < old - min(old, SEQ_NR_THRESHOLD)) {
-		guess += UINT16_MAX + 1;
-	}
-	return guess;
-}
-
-static bool _lsr_node_check_seq_nr(uint64_t *old, struct seq_interval *gaps, uint16_t seq_nr) {
-	uint64_t guess = _guess_seq_nr(*old, seq_nr);
-	if(guess > *old) {
-		if(guess > *old + 1) { //need to create a new gap
-			if(guess > *old + SEQ_NR_THRESHOLD) { //seq nr made a big jump -- invalidate old gaps
-				memset(gaps, 0, GAP_COUNT * sizeof(struct seq_interval));
-			}
-			int insert_index = _gap_insert_index(gaps, seq_nr);
-			gaps[insert_index].start = *old + 1;
-			gaps[insert_index].end = guess;
-		}
-		*old = guess;
-		return true;
-	}
-	for(int i = 0; i < GAP_COUNT; ++i) {
-		if(gaps[i].start <= guess && gaps[i].end > guess) {
-			_split_gap(gaps, guess, i, seq_nr);
-			return true;
-		}
-	}
-	return false;
+static lsr_seq_t *_seq_new(void) {
+	lsr_seq_t *seq = malloc(sizeof(lsr_seq_t));
+	lsr_seq_init(seq, SEQ_BACKEND);
+	return seq;
 }
 
 bool lsr_node_check_broadcast_seq_nr(node_t *node, uint16_t seq_nr) {
-	if(!node->multicast_gaps) {
-		node->multicast_gaps = calloc(GAP_COUNT, sizeof(struct seq_interval));
+	if(!node->multicast_seq) {
+		node->multicast_seq = _seq_new();
 	}
-	return _lsr_node_check_seq_nr(&(node->multicast_seq_nr), node->multicast_gaps, seq_nr);
+	return lsr_seq_check(node->multicast_seq, seq_nr);
 }
 
 bool lsr_node_check_unicast_seq_nr(node_t *node, uint16_t seq_nr) {
-	if(!node->unicast_gaps) {
-		node->unicast_gaps = calloc(GAP_COUNT, sizeof(struct seq_interval));
+	if(!node->unicast_seq) {
+		node->unicast_seq = _seq_new();
 	}
-	return _lsr_node_check_seq_nr(&(node->unicast_seq_nr), node->unicast_gaps, seq_nr);
+	return lsr_seq_check(node->unicast_seq, seq_nr);
+}
+
+//true if seq_nr is a known duplicate; records nothing
+bool lsr_node_seen_broadcast_seq_nr(node_t *node, uint16_t seq_nr) {
+	return node->multicast_seq && lsr_seq_seen(node->multicast_seq, seq_nr);
 }
 
 char *lsr_node_to_string(node_t *this) {
 	static char buf[1024];
 	snprintf(buf, sizeof(buf), MAC " %10ld.%06ld\tmulti-nr: %"
-	         PRIu64 "\tuni-nr: %" PRIu64 "\tweight: %" PRIu32 "\tngbr#: %" PRIu8, EXPLODE_ARRAY6(this->addr), this->timeout.tv_sec, this->timeout.tv_usec, this->multicast_seq_nr, this->unicast_seq_nr, this->weight, this->neighbor_count);
+	         PRIu64 "\tuni-nr: %" PRIu64 "\tweight: %" PRIu32 "\tngbr#: %" PRIu8, EXPLODE_ARRAY6(this->addr), this->timeout.tv_sec, this->timeout.tv_usec, this->multicast_seq ? this->multicast_seq->highest : 0, this->unicast_seq ? this->unicast_seq->highest : 0, this->weight, this->neighbor_count);
 	return buf;
 }
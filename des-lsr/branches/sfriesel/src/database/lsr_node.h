@@ -3,15 +3,12 @@
 
 #include <uthash.h>
 #include <dessert.h>
-
-#define GAP_COUNT 8
+#include "lsr_seq.h"
 
 typedef struct node {
-	uint64_t multicast_seq_nr;           //the highest seen multicast sequence number of this node
-	uint64_t unicast_seq_nr;             //the highest seen unicast sequence number of this node
 	struct timeval timeout;              //time when this node info becomes stale and should be removed
-	struct seq_interval *multicast_gaps; //list multicast seq id's of this not seen yet, but close before multicast_seq_nr
-	struct seq_interval *unicast_gaps;   //list unicast seq id's of this not seen yet, but close before unicast_seq_nr
+	lsr_seq_t *multicast_seq;            //seen multicast sequence numbers of this node, allocated on first use
+	lsr_seq_t *unicast_seq;              //seen unicast sequence numbers of this node, allocated on first use
 	struct edge *neighbors;              //list of edges pointing to neighboring nodes (accordings to the node's TC)
 	struct neighbor *next_hop;           //the level 2 hop which should be used for forwarding to this node
 	uint32_t weight;                     //total weight of the route to this node
@@ -28,6 +25,7 @@ void lsr_node_set_timeout(node_t *this, struct timeval timeout);
 void lsr_node_update_neighbor(node_t *this, node_t *neighbor, struct timeval timeout, uint8_t weight);
 bool lsr_node_check_broadcast_seq_nr(node_t *node, uint16_t seq_nr);
 bool lsr_node_check_unicast_seq_nr(node_t *node, uint16_t seq_nr);
+bool lsr_node_seen_broadcast_seq_nr(node_t *node, uint16_t seq_nr);
 char *lsr_node_to_string(node_t *this);
 
 #endif
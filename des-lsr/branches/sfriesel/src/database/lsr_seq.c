@@ -0,0 +1,173 @@
+#include "lsr_seq.h"
+#include <string.h>
+
+void lsr_seq_init(lsr_seq_t *this, enum lsr_seq_backend backend) {
+	memset(this, 0, sizeof(*this));
+	this->backend = backend;
+	this->empty = true;
+}
+
+uint64_t lsr_seq_guess(uint64_t old, uint16_t seq_nr) {
+	uint64_t guess = seq_nr;
+	if(guess >= old) {
+		return guess;
+	}
+	guess += ((old - guess) & ~(uint64_t)UINT16_MAX);
+	uint64_t lower = old > LSR_SEQ_THRESHOLD ? old - LSR_SEQ_THRESHOLD : 0;
+	while(guess < lower) {
+		guess += UINT16_MAX + 1;
+	}
+	return guess;
+}
+
+// --- INTERVAL BACKEND --- //
+
+static bool _interval_seen(const lsr_seq_t *this, uint64_t guess) {
+	for(int i = 0; i < LSR_SEQ_GAP_COUNT; ++i) {
+		if(this->gaps[i].start <= guess && this->gaps[i].end > guess) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// index of an empty gap, or of the oldest gap if all are in use
+static int _gap_insert_index(lsr_seq_t *this) {
+	int insert_index = 0;
+	for(int i = 0; i < LSR_SEQ_GAP_COUNT; ++i) {
+		if(this->gaps[i].start == this->gaps[i].end) {
+			return i;
+		}
+		if(this->gaps[i].start < this->gaps[insert_index].start) {
+			insert_index = i;
+		}
+	}
+	return insert_index;
+}
+
+static void _interval_advance(lsr_seq_t *this, uint64_t guess) {
+	if(guess > this->highest + LSR_SEQ_THRESHOLD) { //seq nr made a big jump -- invalidate old gaps
+		memset(this->gaps, 0, sizeof(this->gaps));
+	}
+	if(guess > this->highest + 1) {
+		int i = _gap_insert_index(this);
+		this->gaps[i].start = this->highest + 1;
+		this->gaps[i].end = guess;
+	}
+}
+
+static void _interval_mark(lsr_seq_t *this, uint64_t guess) {
+	for(int i = 0; i < LSR_SEQ_GAP_COUNT; ++i) {
+		struct seq_interval *gap = &this->gaps[i];
+		if(gap->start > guess || gap->end <= guess) {
+			continue;
+		}
+		if(guess == gap->start) {
+			gap->start++;
+		}
+		else if(guess == gap->end - 1) {
+			gap->end--;
+		}
+		else { //split gap, the lower half may replace the oldest gap
+			uint64_t start = gap->start;
+			gap->start = guess + 1;
+			int j = _gap_insert_index(this);
+			if(this->gaps[j].start != this->gaps[j].end && this->gaps[j].start > start) {
+				return; //all gaps in use and the lower half is the oldest: forget it
+			}
+			this->gaps[j].start = start;
+			this->gaps[j].end = guess;
+		}
+		return;
+	}
+}
+
+// --- BITMAP BACKEND --- //
+
+static bool _bitmap_seen(const lsr_seq_t *this, uint64_t guess) {
+	uint64_t bit = this->highest - guess;
+	if(bit >= LSR_SEQ_BITMAP_BITS) {
+		return true;
+	}
+	return this->bitmap[bit / 64] & ((uint64_t)1 << (bit % 64));
+}
+
+// shift the window up by highest - guess bits, word by word
+static void _bitmap_advance(lsr_seq_t *this, uint64_t guess) {
+	uint64_t shift = guess - this->highest;
+	if(shift >= LSR_SEQ_BITMAP_BITS) {
+		memset(this->bitmap, 0, sizeof(this->bitmap));
+		return;
+	}
+	int words = shift / 64;
+	int bits = shift % 64;
+	for(int i = LSR_SEQ_BITMAP_WORDS - 1; i >= 0; --i) {
+		uint64_t w = i >= words ? this->bitmap[i - words] << bits : 0;
+		if(bits && i > words) {
+			w |= this->bitmap[i - words - 1] >> (64 - bits);
+		}
+		this->bitmap[i] = w;
+	}
+}
+
+static void _bitmap_mark(lsr_seq_t *this, uint64_t guess) {
+	uint64_t bit = this->highest - guess;
+	this->bitmap[bit / 64] |= (uint64_t)1 << (bit % 64);
+}
+
+// --- COMMON API --- //
+
+static bool _seen(const lsr_seq_t *this, uint16_t seq_nr) {
+	if(this->empty) {
+		return false;
+	}
+	uint64_t guess = lsr_seq_guess(this->highest, seq_nr);
+	if(guess > this->highest) {
+		return false;
+	}
+	return this->backend == LSR_SEQ_BITMAP ? _bitmap_seen(this, guess) : _interval_seen(this, guess);
+}
+
+bool lsr_seq_seen(const lsr_seq_t *this, uint16_t seq_nr) {
+	uint32_t version;
+	bool seen;
+	do {
+		version = __atomic_load_n(&this->version, __ATOMIC_ACQUIRE);
+		seen = !(version & 1) && _seen(this, seq_nr);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while((version & 1) || version != __atomic_load_n(&this->version, __ATOMIC_RELAXED));
+	return seen;
+}
+
+bool lsr_seq_check(lsr_seq_t *this, uint16_t seq_nr) {
+	if(_seen(this, seq_nr)) {
+		return false;
+	}
+
+	__atomic_store_n(&this->version, this->version + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	uint64_t guess = this->empty ? seq_nr : lsr_seq_guess(this->highest, seq_nr);
+	if(this->empty) {
+		this->empty = false;
+		this->highest = guess;
+	}
+	if(guess > this->highest) {
+		if(this->backend == LSR_SEQ_BITMAP) {
+			_bitmap_advance(this, guess);
+		}
+		else {
+			_interval_advance(this, guess);
+		}
+		this->highest = guess;
+	}
+	if(this->backend == LSR_SEQ_BITMAP) {
+		_bitmap_mark(this, guess);
+	}
+	else {
+		_interval_mark(this, guess);
+	}
+
+	__atomic_store_n(&this->version, this->version + 1, __ATOMIC_RELEASE);
+	return true;
+}
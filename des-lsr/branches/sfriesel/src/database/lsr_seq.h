@@ -0,0 +1,76 @@
+#ifndef LSR_SEQ
+#define LSR_SEQ
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Duplicate detection for 16 bit wire sequence numbers.
+ *
+ * Incoming numbers are extended to 64 bit relative to the highest number
+ * seen so far (see lsr_seq_guess) and recorded in one of two backends:
+ *
+ *  - LSR_SEQ_INTERVAL keeps up to LSR_SEQ_GAP_COUNT intervals of numbers
+ *    below the highest one that have not been seen yet. Cheap for mostly
+ *    in-order streams, but bursts of reordering can run out of gaps.
+ *  - LSR_SEQ_BITMAP keeps one bit per number for the LSR_SEQ_BITMAP_BITS
+ *    numbers below the highest one. Exact inside the window at a fixed
+ *    64 byte cost.
+ *
+ * The module does not depend on libdessert and has no global state, so it
+ * can be dropped into the other daemons as is.
+ *
+ * Writers (lsr_seq_check) must be serialized by the caller. lsr_seq_seen()
+ * does not modify the tracker and may run concurrently with a writer: a
+ * version counter that is odd while a write is in progress makes readers
+ * retry instead of returning a torn result.
+ */
+
+#define LSR_SEQ_GAP_COUNT      8
+#define LSR_SEQ_BITMAP_WORDS   8
+#define LSR_SEQ_BITMAP_BITS    (LSR_SEQ_BITMAP_WORDS * 64)
+// numbers at most this far below the highest one are considered older, larger distances a wraparound
+#define LSR_SEQ_THRESHOLD      500
+
+enum lsr_seq_backend {
+	LSR_SEQ_INTERVAL,
+	LSR_SEQ_BITMAP,
+};
+
+struct seq_interval {
+	uint64_t start; //inclusive
+	uint64_t end; //exclusive
+};
+
+typedef struct lsr_seq {
+	uint64_t highest;                 //highest seen sequence number, extended to 64 bit
+	uint32_t version;                 //odd while a write is in progress
+	uint8_t  backend;                 //enum lsr_seq_backend
+	bool     empty;                   //nothing recorded yet
+	union {
+		struct seq_interval gaps[LSR_SEQ_GAP_COUNT];  //not yet seen numbers below highest
+		uint64_t bitmap[LSR_SEQ_BITMAP_WORDS];        //bit i set: highest - i seen
+	};
+} lsr_seq_t;
+
+void lsr_seq_init(lsr_seq_t *this, enum lsr_seq_backend backend);
+
+/**
+ * Record seq_nr.
+ * returns: true if seq_nr was not seen before, false for a duplicate or a number too old to tell
+ */
+bool lsr_seq_check(lsr_seq_t *this, uint16_t seq_nr);
+
+/**
+ * Same verdict as lsr_seq_check, but nothing is recorded. Safe to call
+ * concurrently with a writer.
+ * returns: true if seq_nr was already seen or is too old to tell
+ */
+bool lsr_seq_seen(const lsr_seq_t *this, uint16_t seq_nr);
+
+/**
+ * returns: the 64 bit sequence number closest to (or above) old whose lower 16 bit are seq_nr
+ */
+uint64_t lsr_seq_guess(uint64_t old, uint16_t seq_nr);
+
+#endif
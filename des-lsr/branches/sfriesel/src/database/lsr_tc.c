@@ -76,6 +76,14 @@ bool lsr_tc_check_broadcast_seq_nr(mac_addr node_addr, uint16_t seq_nr) {
 	return lsr_node_check_broadcast_seq_nr(node, seq_nr);
 }
 
+bool lsr_tc_seen_broadcast_seq_nr(mac_addr node_addr, uint16_t seq_nr) {
+	node_t *node = lsr_tc_get_node(node_addr);
+	if (!node) {
+		return false;
+	}
+	return lsr_node_seen_broadcast_seq_nr(node, seq_nr);
+}
+
 dessert_result_t lsr_tc_get_next_hop(mac_addr dest_addr, mac_addr *next_hop, dessert_meshif_t **iface) {
 	node_t *dest = NULL;
 	HASH_FIND(hh, node_set, dest_addr, ETH_ALEN, dest);
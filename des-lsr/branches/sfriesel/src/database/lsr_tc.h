@@ -17,6 +17,7 @@ dessert_result_t lsr_tc_update_node_neighbor(mac_addr node_addr, mac_addr neighb
 node_t *lsr_tc_get_node(mac_addr node_addr);
 node_t *lsr_tc_get_or_create_node(mac_addr addr);
 bool lsr_tc_check_broadcast_seq_nr(mac_addr node_addr, uint16_t seq_nr);
+bool lsr_tc_seen_broadcast_seq_nr(mac_addr node_addr, uint16_t seq_nr);
 bool lsr_tc_check_unicast_seq_nr(mac_addr node_addr, uint16_t seq_nr);
 dessert_result_t lsr_tc_age_all(void);
 dessert_result_t lsr_tc_dijkstra(void);
@@ -19,6 +19,9 @@
 
 #define LSR_TTL_MAX             UINT8_MAX
 
+// duplicate detection backend, see database/lsr_seq.h
+#define SEQ_BACKEND             LSR_SEQ_BITMAP
+
 extern uint16_t tc_interval;
 extern uint16_t hello_interval;
 extern uint16_t neighbor_aging_interval;
@@ -0,0 +1,107 @@
+#include "../src/database/lsr_seq.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Throughput of the duplicate detector backends, per traffic pattern:
+ *
+ *  in order    every number once, in order
+ *  reordered   every seventh number five places late
+ *  duplicates  a random mix of new numbers and repeats of the last 40
+ *  seen        lsr_seq_seen, the lock-free read of the broadcast check,
+ *              on the duplicates stream
+ *
+ * A few thousand trackers are used round robin, as one per originator,
+ * so the numbers include cache misses. A backend slower than 1M checks/s
+ * on any pattern fails the run.
+ *
+ * usage: seq-bench [checks] [trackers]
+ */
+
+#define MIN_RATE 1e6
+
+enum { IN_ORDER, REORDERED, DUPLICATES, SEEN, PATTERNS };
+
+static const char *backend_names[] = { "interval", "bitmap" };
+static const char *pattern_names[] = { "in order", "reordered", "duplicates", "seen" };
+
+static double now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+	long checks = (argc > 1) ? atol(argv[1]) : 20000000;
+	int tracker_count = (argc > 2) ? atoi(argv[2]) : 4096;
+	lsr_seq_t *trackers = malloc(tracker_count * sizeof(lsr_seq_t));
+	uint16_t *stream = malloc(checks * sizeof(uint16_t));
+	int errors = 0;
+
+	printf("%-10s", "backend");
+	for(int p = 0; p < PATTERNS; ++p) {
+		printf(" %12s", pattern_names[p]);
+	}
+	printf("   (M checks/s, %d trackers)\n", tracker_count);
+
+	for(int backend = LSR_SEQ_INTERVAL; backend <= LSR_SEQ_BITMAP; ++backend) {
+		printf("%-10s", backend_names[backend]);
+		for(int p = 0; p < PATTERNS; ++p) {
+			long accepted = 0;
+			uint16_t highest = 0;
+
+			// the numbers of one tracker, tracker i gets every tracker_count-th
+			srand(p);
+			for(long i = 0; i < checks; ++i) {
+				long n = i / tracker_count;
+				switch(p) {
+				case IN_ORDER:
+					stream[i] = n;
+					break;
+				case REORDERED:
+					stream[i] = (n % 7 == 0) ? n - 5 : n;
+					break;
+				default:
+					if(rand() % 100 < 60) {
+						highest++;
+					}
+					stream[i] = highest - rand() % 40;
+					break;
+				}
+			}
+			for(int t = 0; t < tracker_count; ++t) {
+				lsr_seq_init(&trackers[t], backend);
+			}
+			if(p == SEEN) {
+				for(long i = 0; i < checks; ++i) {
+					lsr_seq_check(&trackers[i % tracker_count], stream[i]);
+				}
+			}
+
+			double start = now();
+			if(p == SEEN) {
+				for(long i = 0; i < checks; ++i) {
+					accepted += lsr_seq_seen(&trackers[i % tracker_count], stream[i]);
+				}
+			}
+			else {
+				for(long i = 0; i < checks; ++i) {
+					accepted += lsr_seq_check(&trackers[i % tracker_count], stream[i]);
+				}
+			}
+			double rate = checks / (now() - start);
+
+			printf(" %12.1f", rate / 1e6);
+			if(rate < MIN_RATE || accepted == 0) {
+				errors++;
+			}
+		}
+		printf("\n");
+	}
+
+	free(stream);
+	free(trackers);
+	printf("errors %d\n", errors);
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,205 @@
+#include "../src/database/lsr_seq.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Tests of the duplicate detector, for both backends:
+ *
+ *  guess       lsr_seq_guess for every 16 bit number against 64 bit
+ *              references around many wraparounds
+ *  wraparound  every 16 bit start value, followed by a run of numbers
+ *              across the wraparound, each one new once and then a duplicate
+ *  window      a number d below the highest one, for every d up to
+ *              LSR_SEQ_THRESHOLD
+ *  reordering  random streams with late, duplicated and lost numbers over
+ *              several wraparounds, checked against a set of the numbers
+ *              seen so far: no backend may accept a duplicate, the bitmap
+ *              must accept every new number inside its window, the
+ *              intervals every new number as long as no gap was evicted
+ *  reader      lsr_seq_seen in one thread while another one records
+ *
+ * usage: seq-test
+ */
+
+#define RUN_LEN (LSR_SEQ_THRESHOLD + 100)
+#define STREAM_LEN 3000000
+#define REF_BITS 22
+
+static const char *backend_names[] = { "interval", "bitmap" };
+static int errors = 0;
+
+#define FAIL(...) do { if(errors++ < 20) { printf(__VA_ARGS__); printf("\n"); } } while(0)
+
+static void test_guess() {
+	static const uint64_t bases[] = { 0, 1, LSR_SEQ_THRESHOLD, 65535, 65536, 65536 + LSR_SEQ_THRESHOLD, 3 * 65536 - 1, (uint64_t)1 << 40 };
+	for(unsigned b = 0; b < sizeof(bases) / sizeof(bases[0]); ++b) {
+		for(int delta = -1000; delta <= 1000; delta += 7) {
+			if(delta < 0 && bases[b] < (uint64_t)-delta) {
+				continue;
+			}
+			uint64_t old = bases[b] + delta;
+			uint64_t lower = old > LSR_SEQ_THRESHOLD ? old - LSR_SEQ_THRESHOLD : 0;
+			for(uint32_t seq_nr = 0; seq_nr <= UINT16_MAX; ++seq_nr) {
+				uint64_t guess = lsr_seq_guess(old, seq_nr);
+				if((guess & UINT16_MAX) != seq_nr || guess < lower || guess >= lower + UINT16_MAX + 1) {
+					FAIL("guess: old %llu seq_nr %u gave %llu", (unsigned long long)old, seq_nr, (unsigned long long)guess);
+				}
+			}
+		}
+	}
+}
+
+static void test_wraparound(int backend) {
+	for(uint32_t start = 0; start <= UINT16_MAX; ++start) {
+		lsr_seq_t seq;
+		lsr_seq_init(&seq, backend);
+		for(uint32_t i = 0; i < RUN_LEN; ++i) {
+			uint16_t seq_nr = start + i;
+			if(lsr_seq_seen(&seq, seq_nr) || !lsr_seq_check(&seq, seq_nr)) {
+				FAIL("%s wraparound: start %u, %u not new", backend_names[backend], start, seq_nr);
+			}
+			if(!lsr_seq_seen(&seq, seq_nr) || lsr_seq_check(&seq, seq_nr)) {
+				FAIL("%s wraparound: start %u, %u not a duplicate", backend_names[backend], start, seq_nr);
+			}
+		}
+		// the oldest number still taken as older than the highest one
+		uint16_t oldest = start + RUN_LEN - 1 - LSR_SEQ_THRESHOLD;
+		if(lsr_seq_check(&seq, oldest)) {
+			FAIL("%s wraparound: start %u, %u new again", backend_names[backend], start, oldest);
+		}
+	}
+}
+
+static void test_window(int backend) {
+	for(uint32_t d = 1; d <= LSR_SEQ_THRESHOLD; ++d) {
+		lsr_seq_t seq;
+		uint16_t highest = 65530 + d;
+		lsr_seq_init(&seq, backend);
+		lsr_seq_check(&seq, highest - d - 1);
+		lsr_seq_check(&seq, highest);
+		// the intervals keep the whole gap, the bitmap (wider than LSR_SEQ_THRESHOLD) every number in it
+		if(!lsr_seq_check(&seq, highest - d)) {
+			FAIL("%s window: %u below the highest number not new", backend_names[backend], d);
+		}
+		if(lsr_seq_check(&seq, highest - d)) {
+			FAIL("%s window: %u below the highest number accepted twice", backend_names[backend], d);
+		}
+	}
+}
+
+// a random stream against a set of the numbers seen, indexed by the low REF_BITS bits of their 64 bit value
+static void test_reordering(int backend, int late_percent, int max_late, int lost_percent) {
+	static uint8_t seen[1 << REF_BITS];
+	uint64_t late[64];
+	int late_count = 0;
+	long rejected = 0;
+	uint64_t next = 70000, highest = next - 1, first = highest;
+	lsr_seq_t seq;
+
+	memset(seen, 0, sizeof(seen));
+	lsr_seq_init(&seq, backend);
+	srand(backend * 1000 + late_percent);
+	lsr_seq_check(&seq, first);
+	seen[first & ((1 << REF_BITS) - 1)] = 1;
+
+	for(long i = 0; i < STREAM_LEN; ++i) {
+		uint64_t n;
+		int r = rand() % 100;
+		if(late_count && (r < 30 || late_count == max_late)) {
+			int k = rand() % late_count;
+			n = late[k];
+			late[k] = late[--late_count];
+		}
+		else if(r < 40) {
+			n = highest - rand() % 40;	// a duplicate or an old number
+		}
+		else {
+			n = next++;
+			if(rand() % 100 < late_percent && late_count < max_late) {
+				late[late_count++] = n;
+				continue;
+			}
+			if(rand() % 100 < lost_percent) {
+				continue;
+			}
+		}
+		// numbers older than the reference window are cleared as the stream passes them
+		if(n > highest) {
+			for(uint64_t k = highest + 1; k <= n; ++k) {
+				seen[(k + (1 << (REF_BITS - 1))) & ((1 << REF_BITS) - 1)] = 0;
+			}
+			highest = n;
+		}
+
+		bool known = seen[n & ((1 << REF_BITS) - 1)];
+		// numbers below the first one of the stream are too old to tell for both backends
+		bool in_window = n > first && highest - n < LSR_SEQ_BITMAP_BITS && highest - n < LSR_SEQ_THRESHOLD;
+		bool was_seen = lsr_seq_seen(&seq, n);
+		bool accepted = lsr_seq_check(&seq, n);
+		if(was_seen == accepted) {
+			FAIL("%s reordering: seen and check disagree on %llu", backend_names[backend], (unsigned long long)n);
+		}
+		if(accepted && known) {
+			FAIL("%s reordering: duplicate %llu accepted", backend_names[backend], (unsigned long long)n);
+		}
+		if(!accepted && !known && in_window) {
+			rejected++;
+		}
+		if(accepted) {
+			seen[n & ((1 << REF_BITS) - 1)] = 1;
+		}
+	}
+
+	// at most max_late open gaps: the intervals must not have evicted one either
+	if(rejected && (backend == LSR_SEQ_BITMAP || max_late < LSR_SEQ_GAP_COUNT)) {
+		FAIL("%s reordering: %ld new numbers rejected with %d late", backend_names[backend], rejected, max_late);
+	}
+	printf("%-8s reordering: %d%% late (at most %d), %d%% lost: %ld new numbers rejected\n",
+		backend_names[backend], late_percent, max_late, lost_percent, rejected);
+}
+
+static lsr_seq_t shared;
+static volatile uint32_t recorded;
+
+static void *reader(void *arg) {
+	(void)arg;
+	uint32_t last = 0;
+	while(last < STREAM_LEN) {
+		uint32_t n = __atomic_load_n(&recorded, __ATOMIC_ACQUIRE);
+		bool seen = lsr_seq_seen(&shared, n);
+		// unless the writer went on so far that n looks like the next wraparound
+		if(n && !seen && __atomic_load_n(&recorded, __ATOMIC_ACQUIRE) - n < LSR_SEQ_THRESHOLD) {
+			FAIL("reader: recorded %u not seen", n);
+		}
+		last = n;
+	}
+	return NULL;
+}
+
+static void test_reader(int backend) {
+	pthread_t thread;
+	lsr_seq_init(&shared, backend);
+	recorded = 0;
+	pthread_create(&thread, NULL, reader, NULL);
+	for(uint32_t n = 1; n <= STREAM_LEN; ++n) {
+		lsr_seq_check(&shared, n);
+		__atomic_store_n(&recorded, n, __ATOMIC_RELEASE);
+	}
+	pthread_join(thread, NULL);
+}
+
+int main() {
+	test_guess();
+	for(int backend = LSR_SEQ_INTERVAL; backend <= LSR_SEQ_BITMAP; ++backend) {
+		test_wraparound(backend);
+		test_window(backend);
+		test_reordering(backend, 5, LSR_SEQ_GAP_COUNT - 1, 0);
+		test_reordering(backend, 10, 16, 1);
+		test_reordering(backend, 30, 60, 5);
+		test_reader(backend);
+	}
+	printf("errors %d\n", errors);
+	return errors ? 1 : 0;
+}
@@ -40,7 +40,10 @@ int main (int argc, char** argv) {
 	cli_register_command(dessert_cli, dessert_cli_show, "refresh_list", cli_show_refresh_list, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "show refresh NH interval");
 	cli_register_command(dessert_cli, cli_cfg_set, "refresh_rt", cli_set_refresh_rt, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "set refresh RT interval");
 	cli_register_command(dessert_cli, dessert_cli_show, "refresh_rt", cli_show_refresh_rt, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "show refresh RT interval");
+	cli_register_command(dessert_cli, cli_cfg_set, "rt_holddown", cli_set_rt_holddown, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "set RT calculation hold-down");
+	cli_register_command(dessert_cli, dessert_cli_show, "rt_holddown", cli_show_rt_holddown, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "show RT calculation hold-down");
 	cli_register_command(dessert_cli, dessert_cli_show, "rt", cli_show_rt, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "show RT");
+	cli_register_command(dessert_cli, dessert_cli_show, "counters", cli_show_counters, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "show TC and RT calculation counters");
 
 	/* callback registration */
 	dessert_sysrxcb_add(sys_to_mesh, 10);
@@ -11,10 +11,15 @@
 #define TC_INTERVAL					4000 	// milliseconds
 #define NH_REFRESH_INTERVAL			4000 	// milliseconds
 #define RT_REFRESH_INTERVAL			5000 	// milliseconds
+#define RT_HOLDDOWN					500 	// milliseconds
 #define NH_ENTRY_AGE				32
 #define RT_ENTRY_AGE				32
 #define TTL_MAX 					3
 
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
 //////////////// PERIODICS
 extern u_int16_t					hello_interval;
 extern u_int16_t 					tc_interval;
@@ -22,19 +27,24 @@ extern u_int16_t 					nh_refresh_interval;
 extern u_int16_t 					rt_refresh_interval;
 extern u_int16_t 					nh_entry_age;
 extern u_int16_t 					rt_entry_age;
+extern u_int16_t 					rt_holddown;
 extern dessert_periodic_t *			periodic_send_hello;
 extern dessert_periodic_t *			periodic_send_tc;
-extern dessert_periodic_t *			periodic_refresh_nh;
-extern dessert_periodic_t *			periodic_refresh_rt;
+extern dessert_periodic_t *			periodic_age_topology;
+extern pthread_rwlock_t				pp_rwlock;
+
+//////////////// COUNTERS
+extern u_int32_t 					tc_received;
+extern u_int32_t 					tc_topology_changed;
+extern u_int32_t 					rt_recomputations;
+extern u_int32_t 					tc_edges_refused;
 
 //////////////// FUNCTIONS FROM des-lsr_routingLogic.c
 void init_logic();
 dessert_per_result_t send_hello(void *data, struct timeval *scheduled, struct timeval *interval);
 dessert_per_result_t send_tc(void *data, struct timeval *scheduled, struct timeval *interval);
-dessert_per_result_t refresh_list();
-
-void init_rt();
-dessert_per_result_t refresh_rt();
+void schedule_aging();
+dessert_per_result_t age_topology(void *data, struct timeval *scheduled, struct timeval *interval);
 
 //////////////// FUNCTIONS FROM des-lsr_packetHandler.c
 int sys_to_mesh(dessert_msg_t *msg, size_t len, dessert_msg_proc_t *proc, dessert_sysif_t *sysif, dessert_frameid_t id);
@@ -54,7 +64,10 @@ int cli_set_refresh_list(struct cli_def* cli, char* command, char* argv[], int a
 int cli_show_refresh_list(struct cli_def* cli, char* command, char* argv[], int argc);
 int cli_set_refresh_rt(struct cli_def* cli, char* command, char* argv[], int argc);
 int cli_show_refresh_rt(struct cli_def* cli, char* command, char* argv[], int argc);
+int cli_set_rt_holddown(struct cli_def* cli, char* command, char* argv[], int argc);
+int cli_show_rt_holddown(struct cli_def* cli, char* command, char* argv[], int argc);
 int cli_show_rt(struct cli_def* cli, char* command, char* argv[], int argc);
+int cli_show_counters(struct cli_def* cli, char* command, char* argv[], int argc);
 
 //////////////// FUNCTIONS FROM des-lsr_dijkstra.c
 void shortest_path(uint8_t *addr);
@@ -51,11 +51,7 @@ int cli_set_refresh_list(struct cli_def *cli, char *command, char *argv[], int a
 	}
 
 	nh_refresh_interval = (u_int16_t) strtoul(argv[0], NULL, 10);
-	dessert_periodic_del(periodic_refresh_nh);
-	struct timeval refresh_neighbor_t;
-	refresh_neighbor_t.tv_sec = nh_refresh_interval / 1000;
-	refresh_neighbor_t.tv_usec = (nh_refresh_interval % 1000) * 1000;
-	periodic_refresh_nh = dessert_periodic_add(refresh_list, NULL, NULL, &refresh_neighbor_t);
+	schedule_aging();
 	dessert_notice("setting NH refresh interval to %d ms\n", nh_refresh_interval);
     return CLI_OK;
 }
@@ -72,11 +68,7 @@ int cli_set_refresh_rt(struct cli_def *cli, char *command, char *argv[], int arg
 	}
 
 	rt_refresh_interval = (u_int16_t) strtoul(argv[0], NULL, 10);
-	dessert_periodic_del(periodic_refresh_rt);
-	struct timeval refresh_rt_t;
-	refresh_rt_t.tv_sec = rt_refresh_interval / 1000;
-	refresh_rt_t.tv_usec = (rt_refresh_interval % 1000) * 1000;
-	periodic_refresh_rt = dessert_periodic_add(refresh_rt, NULL, NULL, &refresh_rt_t);
+	schedule_aging();
 	dessert_notice("setting RT refresh interval to %d ms\n", rt_refresh_interval);
     return CLI_OK;
 }
@@ -118,27 +110,58 @@ int cli_show_rt_entry_age(struct cli_def *cli, char *command, char *argv[], int
     return CLI_OK;
 }
 
+int cli_set_rt_holddown(struct cli_def *cli, char *command, char *argv[], int argc) {
+	if(argc != 1) {
+		cli_print(cli, "usage %s [interval]\n", command);
+		return CLI_ERROR;
+	}
+
+	rt_holddown = (u_int16_t) strtoul(argv[0], NULL, 10);
+	dessert_notice("setting RT hold-down to %d ms\n", rt_holddown);
+    return CLI_OK;
+}
+
+int cli_show_rt_holddown(struct cli_def *cli, char *command, char *argv[], int argc) {
+	cli_print(cli, "RT hold-down = %d ms\n", rt_holddown);
+    return CLI_OK;
+}
+
+int cli_show_counters(struct cli_def *cli, char *command, char *argv[], int argc) {
+	cli_print(cli, "TCs received          = %u", tc_received);
+	cli_print(cli, "TCs changing topology = %u", tc_topology_changed);
+	cli_print(cli, "RT recomputations     = %u", rt_recomputations);
+	cli_print(cli, "TC links refused      = %u", tc_edges_refused);
+    return CLI_OK;
+}
+
 int cli_show_rt(struct cli_def *cli, char *command, char *argv[], int argc) {
-	all_nodes_t *node = all_nodes_head;
 	char rt[1000];
+	struct timeval now;
+	gettimeofday(&now, NULL);
+
+	pthread_rwlock_rdlock(&pp_rwlock);
+	all_nodes_t *node = all_nodes_head;
 
 	if (!node) {
+		pthread_rwlock_unlock(&pp_rwlock);
 		return CLI_OK;
 	}
 
 	cli_print(cli, "##############################################################################################");
-	cli_print(cli, "## MAC\t\t\t# NEXT HOP\t\t# DISTANCE\t# SEQ NR\t# ENTRY AGE ##");
+	cli_print(cli, "## MAC\t\t\t# NEXT HOP\t\t# DISTANCE\t# SEQ NR\t# EXPIRES (s) ##");
 	cli_print(cli, "##############################################################################################");
 
 	while (node) {
-		sprintf(rt, "## " MAC "\t# " MAC "\t# %d\t\t# %d\t\t# %d\t    ##\t",
+		long expires = node->has_tc ? (long) (node->expires.tv_sec - now.tv_sec) : 0;
+		sprintf(rt, "## " MAC "\t# " MAC "\t# %d\t\t# %d\t\t# %ld\t    ##\t",
 				node->addr[0], node->addr[1], node->addr[2], node->addr[3],
 				node->addr[4], node->addr[5], node->next_hop[0], node->next_hop[1],
 				node->next_hop[2], node->next_hop[3], node->next_hop[4],
-				node->next_hop[5], node->distance, node->seq_nr, node->entry_age);
-		cli_print(cli, rt);
+				node->next_hop[5], node->distance, node->seq_nr, expires);
+		cli_print(cli, "%s", rt);
 		node = node->hh.next;
 	}
+	pthread_rwlock_unlock(&pp_rwlock);
 
 	cli_print(cli, "##############################################################################################");
 	return CLI_OK;
@@ -3,104 +3,72 @@
 #include <pthread.h>
 #include <string.h>
 
-all_nodes_t* find_addr (uint8_t *addr) {
-	all_nodes_t *node = all_nodes_head;
-	while (node) {
-		if (memcmp(node->addr, addr, ETH_ALEN) == 0) {
-			return node;
-		}
-		node = node->hh.next;
-	}
-	return NULL;
-}
-
-int check_visited () {
-	all_nodes_t *node = all_nodes_head;
-	while (node) {
-		if (node->visited == 0) {
-			return 0;
-		}
-		node = node->hh.next;
-	}
-	return 1;
-}
-
 all_nodes_t* get_low_unvisit_dist () {
-	all_nodes_t *node = all_nodes_head;
+	node_id_t id, max_id = topo_node_id_max();
 	all_nodes_t *lowest = NULL;
-	while (node) {
-		if (!node->visited) {
+	for (id = 0; id < max_id; id++) {
+		all_nodes_t *node = topo_node_by_id(id);
+		if (node && !node->visited && node->distance < INFINITY) {
 			if (lowest == NULL || node->distance < lowest->distance) {
 				lowest = node;
 			}
 		}
-		node = node->hh.next;
 	}
 	return lowest;
 }
 
 void shortest_path (uint8_t *addr) {
-	if (!all_nodes_head) {
-		return;
-	}
-
-	all_nodes_t *node = find_addr(addr);
-	all_nodes_t *current = all_nodes_head;
-	node_neighbors_t *current_neighbors;
-	all_nodes_t *ptr = all_nodes_head;
+	node_id_t id, max_id = topo_node_id_max();
+	all_nodes_t *self = topo_get_node(addr);
+	all_nodes_t *current;
+	all_nodes_t *ptr;
 
 	/* Part I */
-	// set all nodes as unvisited, distance to infinity and prev hop to broadcast
-	while (current) {
-		current->visited = 0;
-		current->distance = INFINITY;
-		memcpy(current->prev_hop, ether_broadcast, ETH_ALEN * sizeof(u_int8_t));
-		memcpy(current->next_hop, ether_broadcast, ETH_ALEN * sizeof(u_int8_t));
-		current = current->hh.next;
+	// set all nodes as unvisited, distance to infinity and prev hop to none
+	for (id = 0; id < max_id; id++) {
+		current = topo_node_by_id(id);
+		if (current) {
+			current->visited = 0;
+			current->distance = INFINITY;
+			current->prev_hop = NODE_ID_NONE;
+			memcpy(current->next_hop, ether_broadcast, ETH_ALEN * sizeof(u_int8_t));
+		}
 	}
 
 	/* Part II */
-	// set distance of start node to 0 and prev to itself
-	node->distance = 0;
-	memcpy(node->prev_hop, node->addr, ETH_ALEN * sizeof(u_int8_t));
-	memcpy(node->next_hop, node->addr, ETH_ALEN * sizeof(u_int8_t));
+	// set distance of start node to 0; its links are the direct neighbors
+	if (self) {
+		self->visited = 1;
+		self->distance = 0;
+		memcpy(self->next_hop, self->addr, ETH_ALEN * sizeof(u_int8_t));
+	}
+	node_neighbors_t *neighbor;
+	for (neighbor = dir_neighbors_head; neighbor; neighbor = neighbor->hh.next) {
+		ptr = topo_node_by_id(neighbor->id);
+		if (neighbor->weight < ptr->distance) {
+			ptr->distance = neighbor->weight;
+			ptr->prev_hop = self ? self->id : NODE_ID_NONE;
+			memcpy(ptr->next_hop, ptr->addr, ETH_ALEN * sizeof(u_int8_t));
+		}
+	}
 
 	/* Part III */
-	// while there are some unvisited nodes
-	while (!check_visited()) {
-		// set unvisited node with lowest distance as current and visited
-		current = get_low_unvisit_dist();
+	// while there are reachable unvisited nodes
+	while ((current = get_low_unvisit_dist())) {
 		current->visited = 1;
 
 		// for all unvisited neighbors of current
-		current_neighbors = current->neighbors;
-		while (current_neighbors) {
-			ptr = find_addr(current_neighbors->addr);
-
-			// if old distance is larger then new; overwrite and set current to prev hop
-			if (ptr) {
-				if (current->distance + current_neighbors->weight < ptr->distance) {
-					ptr->distance = current->distance + current_neighbors->weight;
-					memcpy(ptr->prev_hop, current->addr, ETH_ALEN * sizeof(u_int8_t));
-				}
-			}
-			current_neighbors = current_neighbors->hh.next;
-		}
-	}
+		int i;
+		for (i = 0; i < current->edge_count; i++) {
+			edge_t *edge = &current->edges[i];
+			ptr = topo_node_by_id(edge->target);
 
-	/* PART IV */
-	// find next_hops for all nodes (go routing tree back to source)
-	node = all_nodes_head;
-	while (node) {
-		if (memcmp(node->addr, addr, ETH_ALEN * sizeof(int))) {
-			ptr = find_addr(node->prev_hop);
-			if (memcmp(node->prev_hop, ether_broadcast, ETH_ALEN)) {
-				while (memcmp(ptr->prev_hop, addr, ETH_ALEN * sizeof(u_int8_t))) {
-					ptr = find_addr(ptr->prev_hop);
-				}
-				memcpy(node->next_hop, ptr->addr, ETH_ALEN * sizeof(u_int8_t));
+			// if old distance is larger then new; overwrite and inherit the first hop of current
+			if (!ptr->visited && current->distance + edge->weight < ptr->distance) {
+				ptr->distance = current->distance + edge->weight;
+				ptr->prev_hop = current->id;
+				memcpy(ptr->next_hop, current->next_hop, ETH_ALEN * sizeof(u_int8_t));
 			}
 		}
-		node = node->hh.next;
 	}
 }
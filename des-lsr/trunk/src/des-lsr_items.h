@@ -4,30 +4,72 @@
 
 #define INFINITY 200
 
+// size of one neighbor entry in the TC extension (addr, entry_age, weight)
+#define TC_ENTRY_SIZE (ETH_ALEN + 2)
+// neighbor entries fitting into one TC extension after its size byte; larger lists span several extensions
+#define TC_MAX_ENTRIES_PER_EXT ((DESSERT_MAXEXTDATALEN - 1) / TC_ENTRY_SIZE)
+
 //////////////// DATABASE
-// a hashmap for all neighbours of a node
+// interned index of a node in the node table
+typedef u_int16_t node_id_t;
+#define NODE_ID_NONE UINT16_MAX
+
+// a directed link of a node as advertised in its TC
+typedef struct edge {
+	node_id_t target;
+	u_int8_t weight;
+	u_int8_t tc_mark;	// seq_nr of the last TC listing this link
+} edge_t;
+
+// a hashmap for all direct neighbours
 typedef struct node_neighbors {
 	u_int8_t addr[ETH_ALEN];
-	u_int8_t entry_age;
 	u_int8_t weight;
+	node_id_t id;		// interned node of this neighbor
+	struct timeval expires;
+	struct node_neighbors *prev, *next;	// aging queue, ordered by expires
 	UT_hash_handle hh;
-} __attribute__((__packed__)) node_neighbors_t;
+} node_neighbors_t;
 extern node_neighbors_t *dir_neighbors_head;
 
 // a hashmap for all nodes
 typedef struct all_nodes {
 	u_int8_t addr[ETH_ALEN];
 	u_int8_t next_hop[ETH_ALEN];
-	u_int8_t prev_hop[ETH_ALEN];
-	u_int8_t entry_age;
+	node_id_t id;
+	node_id_t prev_hop;
+	u_int16_t refcnt;	// edges and neighbor entries pointing here + 1 while TC info is held
+	u_int8_t has_tc;	// TC info of this node is held and in the aging queue
 	u_int8_t seq_nr;
 	u_int8_t distance;
 	u_int8_t visited;
-	node_neighbors_t* neighbors;
+	u_int16_t edge_count;	// number of entries in edges
+	u_int16_t edge_size;	// size of the array pointed to by edges
+	edge_t* edges;
+	struct timeval expires;
+	struct all_nodes *prev, *next;	// aging queue, ordered by expires
 	UT_hash_handle hh;
 } all_nodes_t;
 extern all_nodes_t *all_nodes_head;
 
+//////////////// TOPOLOGY STORE (des-lsr_topology.c)
+all_nodes_t* topo_get_node(const u_int8_t *addr);
+all_nodes_t* topo_node_by_id(node_id_t id);
+node_id_t topo_node_id_max();
+all_nodes_t* topo_intern_node(const u_int8_t *addr);
+void topo_release_node(all_nodes_t *node);
+
+void topo_refresh_tc(all_nodes_t *node);
+edge_t* topo_find_edge(all_nodes_t *node, node_id_t target);
+edge_t* topo_add_edge(all_nodes_t *node, all_nodes_t *target, u_int8_t weight);
+void topo_del_edge(all_nodes_t *node, int index);
+
+node_neighbors_t* topo_get_neighbor(const u_int8_t *addr);
+node_neighbors_t* topo_refresh_neighbor(const u_int8_t *addr);
+u_int8_t topo_neighbor_entry_age(node_neighbors_t *neighbor, const struct timeval *now);
+
+int topo_expire(const struct timeval *now);
+
 //////////////// EXTENSIONS
 typedef struct  hello_ext {
 } __attribute__((__packed__)) hello_ext_t;
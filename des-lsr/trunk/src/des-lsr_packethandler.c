@@ -3,13 +3,16 @@
 
 int sys_to_mesh(dessert_msg_t *msg, size_t len, dessert_msg_proc_t *proc, dessert_sysif_t *sysif, dessert_frameid_t id) {
         struct ether_header* l25h = dessert_msg_getl25ether(msg);                       // ptr to l2.5 header
-        all_nodes_t* node;
-        HASH_FIND(hh, all_nodes_head, l25h->ether_dhost, ETH_ALEN, node);       // finding destination of msg in hashmap
+        pthread_rwlock_rdlock(&pp_rwlock);
+        all_nodes_t* node = topo_get_node(l25h->ether_dhost);                   // finding destination of msg in hashmap
 
         // if destination and next hop for destination is known
         if (node && memcmp(node->next_hop, ether_broadcast, ETH_ALEN) != 0) {
                 memcpy(msg->l2h.ether_dhost, node->next_hop, ETH_ALEN);
+                pthread_rwlock_unlock(&pp_rwlock);
                 dessert_meshsend_fast(msg, NULL);
+        } else {
+                pthread_rwlock_unlock(&pp_rwlock);
         }
 
     return DESSERT_MSG_DROP;
@@ -3,25 +3,49 @@
 #include <pthread.h>
 #include <string.h>
 
-node_neighbors_t* dir_neighbors_head  = NULL;
-all_nodes_t* all_nodes_head           = NULL;
-
 uint16_t hello_interval      = HELLO_INTERVAL;
 uint16_t tc_interval         = TC_INTERVAL;
 uint16_t nh_refresh_interval = NH_REFRESH_INTERVAL;
 uint16_t rt_refresh_interval = RT_REFRESH_INTERVAL;
 uint16_t nh_entry_age        = NH_ENTRY_AGE;
 uint16_t rt_entry_age        = RT_ENTRY_AGE;
+uint16_t rt_holddown         = RT_HOLDDOWN;
+
+uint32_t tc_received         = 0;
+uint32_t tc_topology_changed = 0;
+uint32_t rt_recomputations   = 0;
+uint32_t tc_edges_refused    = 0;
 
 dessert_periodic_t* periodic_send_hello;
 dessert_periodic_t* periodic_send_tc;
-dessert_periodic_t* periodic_refresh_nh;
-dessert_periodic_t* periodic_refresh_rt;
+dessert_periodic_t* periodic_age_topology;
 
 uint16_t tc_seq_nr = 0;
 
 pthread_rwlock_t pp_rwlock = PTHREAD_RWLOCK_INITIALIZER;
 
+// set while a one-shot RT calculation is scheduled; protected by pp_rwlock
+static uint8_t rt_recompute_pending = 0;
+
+static dessert_per_result_t recompute_rt(void *data, struct timeval *scheduled, struct timeval *interval);
+
+/**
+ * Schedule a RT calculation rt_holddown ms from now unless one is already
+ * pending. All topology changes within the hold-down are handled by a
+ * single Dijkstra run. Must be called with pp_rwlock write locked.
+ */
+static void topology_changed() {
+	if (rt_recompute_pending) {
+		return;
+	}
+	rt_recompute_pending = 1;
+
+	struct timeval recompute_t;
+	gettimeofday(&recompute_t, NULL);
+	dessert_timevaladd(&recompute_t, rt_holddown / 1000, (rt_holddown % 1000) * 1000);
+	dessert_periodic_add(recompute_rt, NULL, &recompute_t, NULL);
+}
+
 void init_logic() {
 	// registering periodic for HELLO packets
 	struct timeval hello_interval_t;
@@ -35,17 +59,24 @@ void init_logic() {
 	tc_interval_t.tv_usec = (tc_interval % 1000) * 1000;
 	periodic_send_tc = dessert_periodic_add(send_tc, NULL, NULL, &tc_interval_t);
 
-	// registering periodic for refreshing neighboring list
-	struct timeval refresh_neighbor_t;
-	refresh_neighbor_t.tv_sec = nh_refresh_interval / 1000;
-	refresh_neighbor_t.tv_usec = (nh_refresh_interval % 1000) * 1000;
-	periodic_refresh_nh = dessert_periodic_add(refresh_list, NULL, NULL, &refresh_neighbor_t);
-
-	// registering periodic for refreshing routing table
-	struct timeval refresh_rt_t;
-	refresh_rt_t.tv_sec = rt_refresh_interval / 1000;
-	refresh_rt_t.tv_usec = (rt_refresh_interval % 1000) * 1000;
-	periodic_refresh_rt = dessert_periodic_add(refresh_rt, NULL, NULL, &refresh_rt_t);
+	// registering periodic for aging neighbors and TC info
+	schedule_aging();
+}
+
+/**
+ * (Re)register the aging periodic. Neighbors and nodes expire after
+ * nh_entry_age resp. rt_entry_age times their refresh interval, so it is
+ * checked at the shorter of both intervals.
+ */
+void schedule_aging() {
+	if (periodic_age_topology) {
+		dessert_periodic_del(periodic_age_topology);
+	}
+	uint16_t age_interval = min(nh_refresh_interval, rt_refresh_interval);
+	struct timeval age_interval_t;
+	age_interval_t.tv_sec = age_interval / 1000;
+	age_interval_t.tv_usec = (age_interval % 1000) * 1000;
+	periodic_age_topology = dessert_periodic_add(age_topology, NULL, NULL, &age_interval_t);
 }
 
 // --- PERIODIC PIPELINE --- //
@@ -70,17 +101,11 @@ int process_hello(dessert_msg_t* msg, size_t len, dessert_msg_proc_t *proc, cons
 	if(dessert_msg_getext(msg, &ext, LSR_EXT_HELLO, 0)) {
 		pthread_rwlock_wrlock(&pp_rwlock);
 		struct ether_header* l25h = dessert_msg_getl25ether(msg);
-		node_neighbors_t *neighbor = malloc(sizeof(node_neighbors_t));
-		HASH_FIND(hh, dir_neighbors_head, l25h->ether_shost, ETH_ALEN, neighbor);
-		if (neighbor) {
-			neighbor->entry_age = NH_ENTRY_AGE;
-		} else {
-			neighbor = malloc(sizeof(node_neighbors_t));
-			memcpy(neighbor->addr, l25h->ether_shost, ETH_ALEN);
-			neighbor->entry_age = NH_ENTRY_AGE;
-			neighbor->weight = 1;
-			HASH_ADD_KEYPTR(hh, dir_neighbors_head, neighbor->addr, ETH_ALEN, neighbor);
+		node_neighbors_t *neighbor = topo_get_neighbor(l25h->ether_shost);
+		if (!neighbor) {
+			topology_changed();
 		}
+		topo_refresh_neighbor(l25h->ether_shost);
 		pthread_rwlock_unlock(&pp_rwlock);
 		return DESSERT_MSG_DROP;
 	}
@@ -91,6 +116,7 @@ int process_hello(dessert_msg_t* msg, size_t len, dessert_msg_proc_t *proc, cons
 dessert_per_result_t send_tc(void *data, struct timeval *scheduled, struct timeval *interval) {
 	pthread_rwlock_wrlock(&pp_rwlock);
 	if (HASH_COUNT(dir_neighbors_head) == 0) {
+		pthread_rwlock_unlock(&pp_rwlock);
 		return 0;
 	}
 
@@ -99,35 +125,29 @@ dessert_per_result_t send_tc(void *data, struct timeval *scheduled, struct timev
 	tc->ttl = TTL_MAX;
 	tc->u8 = ++tc_seq_nr;
 
-	// delete old entries from NH list
+	// add TC extensions, each holding at most TC_MAX_ENTRIES_PER_EXT neighbors
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	dessert_ext_t *ext;
 	node_neighbors_t *dir_neigh = dir_neighbors_head;
+	size_t entries_left = HASH_COUNT(dir_neighbors_head);
 	while (dir_neigh) {
-		if (dir_neigh->entry_age-- == 0) {
-			node_neighbors_t* el_to_delete = dir_neigh;
-			HASH_DEL(dir_neighbors_head, el_to_delete);
-			free(el_to_delete);
+		size_t entry_count = min(entries_left, TC_MAX_ENTRIES_PER_EXT);
+		size_t ext_size = 1 + TC_ENTRY_SIZE * entry_count;
+		if (dessert_msg_addext(tc, &ext, LSR_EXT_TC, ext_size) != DESSERT_OK) {
+			dessert_warn("TC full, %zu of %u neighbors not advertised", entries_left, HASH_COUNT(dir_neighbors_head));
+			break;
 		}
-		dir_neigh = dir_neigh->hh.next;
-	}
+		uint8_t* tc_ext = ext->data;
+		*tc_ext++ = ext_size;
 
-	// add TC extension
-	dessert_ext_t *ext;
-	uint8_t ext_size = 1 + ((sizeof(node_neighbors_t)- sizeof(dir_neighbors_head->hh)) * HASH_COUNT(dir_neighbors_head));
-	dessert_msg_addext(tc, &ext, LSR_EXT_TC, ext_size);
-	void* tc_ext = ext->data;
-	memcpy(tc_ext, &(ext_size), 1);
-	tc_ext++;
-
-	// copy NH list into extension
-	dir_neigh = dir_neighbors_head;
-	while (dir_neigh) {
-		memcpy(tc_ext, dir_neigh->addr, ETH_ALEN);
-		tc_ext += ETH_ALEN;
-		memcpy(tc_ext, &(dir_neigh->entry_age), 1);
-		tc_ext++;
-		memcpy(tc_ext, &(dir_neigh->weight), 1);
-		tc_ext++;
-		dir_neigh = dir_neigh->hh.next;
+		// copy NH list into extension
+		for (; dir_neigh && entry_count > 0; dir_neigh = dir_neigh->hh.next, entry_count--, entries_left--) {
+			memcpy(tc_ext, dir_neigh->addr, ETH_ALEN);
+			tc_ext += ETH_ALEN;
+			*tc_ext++ = topo_neighbor_entry_age(dir_neigh, &now);
+			*tc_ext++ = dir_neigh->weight;
+		}
 	}
 
 	// add l2.5 header
@@ -143,123 +163,121 @@ dessert_per_result_t send_tc(void *data, struct timeval *scheduled, struct timev
 }
 
 int process_tc(dessert_msg_t* msg, size_t len, dessert_msg_proc_t *proc, const dessert_meshif_t *iface, dessert_frameid_t id) {
-	pthread_rwlock_wrlock(&pp_rwlock);
 	dessert_ext_t *ext;
 
-	if(dessert_msg_getext(msg, &ext, LSR_EXT_TC, 0)){
-		all_nodes_t *node = malloc(sizeof(all_nodes_t));
-		node_neighbors_t *neighbor = malloc(sizeof(node_neighbors_t));
-		struct ether_header* l25h = dessert_msg_getl25ether(msg);
-		void* tc_ext = (void*) ext->data;
-		uint8_t ext_size;
-		uint8_t addr[ETH_ALEN];
-		uint8_t entry_age;
-		uint8_t weight;
-
-		// if node is not in RT, add the node
-		HASH_FIND(hh, all_nodes_head, l25h->ether_shost, ETH_ALEN, node);
-		if (!node) {
-			node = malloc(sizeof(all_nodes_t));
-			memcpy(node->addr, l25h->ether_shost, ETH_ALEN);
-			node->entry_age = RT_ENTRY_AGE;
-			node->seq_nr = msg->u8;
-			HASH_ADD_KEYPTR(hh, all_nodes_head, node->addr, ETH_ALEN, node);
-		}
+	if(!dessert_msg_getext(msg, &ext, LSR_EXT_TC, 0)) {
+		return DESSERT_MSG_KEEP;
+	}
+
+	struct ether_header* l25h = dessert_msg_getl25ether(msg);
+
+	pthread_rwlock_wrlock(&pp_rwlock);
+	tc_received++;
+
+	all_nodes_t *node = topo_intern_node(l25h->ether_shost);
+	if (!node) {
+		pthread_rwlock_unlock(&pp_rwlock);
+		return DESSERT_MSG_DROP;
+	}
+	if (!node->has_tc) {
+		// no TC info held: accept any sequence number
+		node->seq_nr = msg->u8 - 1;
+	}
 
-		// if node is in RT, extract information from TC and add NH
-		memcpy(&ext_size, tc_ext, 1);
+	// ignore TCs older than the last one processed for this node (serial number arithmetic)
+	if ((int8_t) (msg->u8 - node->seq_nr) < 0) {
+		topo_release_node(node);
+		pthread_rwlock_unlock(&pp_rwlock);
+		dessert_meshsend_fast_randomized(msg);	// resend TC packet
+		return DESSERT_MSG_DROP;
+	}
+	node->seq_nr = msg->u8;
+	topo_refresh_tc(node);
+
+	// diff the advertised links of all TC extensions against the stored adjacency of the node
+	uint8_t changed = 0;
+	int i, ext_index = 0;
+	while (dessert_msg_getext(msg, &ext, LSR_EXT_TC, ext_index++)) {
+		uint8_t* tc_ext = ext->data;
+		uint8_t ext_size = tc_ext[0];
+		if (ext_size > dessert_ext_getdatalen(ext)) {
+			ext_size = dessert_ext_getdatalen(ext);
+		}
+		int entry_count = (ext_size - 1) / TC_ENTRY_SIZE;
 		tc_ext++;
-		while (ext_size-1 > 0) {
-			memcpy(addr, tc_ext, ETH_ALEN);
-			ext_size -= ETH_ALEN;
-			tc_ext += ETH_ALEN;
-			memcpy(&entry_age, tc_ext, 1);
-			ext_size--;
-			tc_ext++;
-			memcpy(&weight, tc_ext, 1);
-			ext_size--;
-			tc_ext++;
-			HASH_FIND(hh, all_nodes_head, l25h->ether_shost, ETH_ALEN, node);
-			if (node){
-				if (node->seq_nr <= msg->u8) {
-					node->entry_age = RT_ENTRY_AGE;
-					node->seq_nr = msg->u8;
-
-					// add NH to RT
-					HASH_FIND(hh, node->neighbors, addr, ETH_ALEN, neighbor);
-					if (neighbor) {
-						neighbor->entry_age = entry_age;
-						neighbor->weight = weight;
-					} else {
-						neighbor = malloc(sizeof(node_neighbors_t));
-						memcpy(neighbor->addr, addr, ETH_ALEN);
-						neighbor->entry_age = entry_age;
-						neighbor->weight = weight;
-						HASH_ADD_KEYPTR(hh, node->neighbors, neighbor->addr, ETH_ALEN, neighbor);
-					}
+
+		for (i = 0; i < entry_count; i++, tc_ext += TC_ENTRY_SIZE) {
+			uint8_t* addr = tc_ext;
+			uint8_t weight = tc_ext[ETH_ALEN + 1];
+			all_nodes_t *target = topo_intern_node(addr);
+			if (!target) {
+				continue;
+			}
+
+			edge_t *edge = topo_find_edge(node, target->id);
+			if (!edge) {
+				edge = topo_add_edge(node, target, weight);
+				if (!edge) {
+					tc_edges_refused++;
+					dessert_warn("adjacency of " MAC " full at %u edges, ignoring link to " MAC,
+							EXPLODE_ARRAY6(node->addr), node->edge_count, EXPLODE_ARRAY6(addr));
+				} else {
+					changed = 1;
 				}
+			} else if (edge->weight != weight) {
+				edge->weight = weight;
+				changed = 1;
 			}
+			if (edge) {
+				edge->tc_mark = node->seq_nr;
+			}
+			topo_release_node(target);	// the edge holds its own reference
 		}
+	}
 
-		dessert_meshsend_fast_randomized(msg);	// resend TC packet
-		pthread_rwlock_unlock(&pp_rwlock);
-		return DESSERT_MSG_DROP;
+	// links not listed in this TC are gone
+	for (i = node->edge_count - 1; i >= 0; i--) {
+		if (node->edges[i].tc_mark != node->seq_nr) {
+			topo_del_edge(node, i);
+			changed = 1;
+		}
 	}
 
+	if (changed) {
+		tc_topology_changed++;
+		topology_changed();
+	}
+	topo_release_node(node);	// now referenced by its TC info
 	pthread_rwlock_unlock(&pp_rwlock);
-	return DESSERT_MSG_KEEP;
+
+	dessert_meshsend_fast_randomized(msg);	// resend TC packet
+	return DESSERT_MSG_DROP;
 }
 
-dessert_per_result_t refresh_list(void *data, struct timeval *scheduled, struct timeval *interval) {
+dessert_per_result_t age_topology(void *data, struct timeval *scheduled, struct timeval *interval) {
+	struct timeval now;
+	gettimeofday(&now, NULL);
+
 	pthread_rwlock_wrlock(&pp_rwlock);
-	node_neighbors_t *neighbor = dir_neighbors_head;
-	while (neighbor) {
-		if (neighbor->entry_age-- == 0) {
-			node_neighbors_t* el_to_delete = neighbor;
-			HASH_DEL(dir_neighbors_head, el_to_delete);
-			free(el_to_delete);
-		} else {
-			neighbor->weight = 1;
-		}
-		neighbor = neighbor->hh.next;
+	if (topo_expire(&now)) {
+		topology_changed();
 	}
 	pthread_rwlock_unlock(&pp_rwlock);
 	return 0;
 }
 
-dessert_per_result_t refresh_rt(void *data, struct timeval *scheduled, struct timeval *interval) {
+/**
+ * One-shot periodic scheduled by topology_changed(): recalculates all
+ * routes.
+ */
+static dessert_per_result_t recompute_rt(void *data, struct timeval *scheduled, struct timeval *interval) {
 	pthread_rwlock_wrlock(&pp_rwlock);
-	all_nodes_t *node = all_nodes_head;
-
-	while (node) {
-		if (node->entry_age-- == 0) {
-			all_nodes_t* el_to_delete = node;
-			HASH_DEL(all_nodes_head, el_to_delete);
-			free(el_to_delete);
-		}
-
-		dessert_info("RT ENTRY " MAC " | Seqnr = %d | EntryAge = %d",
-			node->addr[0], node->addr[1], node->addr[2], node->addr[3],
-			node->addr[4], node->addr[5], node->seq_nr, node->entry_age);
-		node = node->hh.next;
-	}
+	rt_recompute_pending = 0;
 
 	/* DIJKSTRA */
-	if (all_nodes_head) {
-		// add self into RT
-		node = malloc(sizeof(all_nodes_t));
-		memcpy(node->addr, dessert_l25_defsrc, ETH_ALEN);
-		node->entry_age = RT_ENTRY_AGE;
-		node->neighbors = dir_neighbors_head;
-		HASH_ADD_KEYPTR(hh, all_nodes_head, node->addr, ETH_ALEN, node);
-
-		// calculate shortest paths from self to all other in RT
-		shortest_path(dessert_l25_defsrc);
-
-		// delete self from RT
-		HASH_DEL(all_nodes_head, node);
-		free(node);
-	}
+	// calculate shortest paths from self to all other in RT
+	shortest_path(dessert_l25_defsrc);
+	rt_recomputations++;
 
 	pthread_rwlock_unlock(&pp_rwlock);
 	return 0;
@@ -277,12 +295,15 @@ int drop_errors(dessert_msg_t* msg, size_t len,	dessert_msg_proc_t *proc, const
 int forward_packet(dessert_msg_t* msg, size_t len, dessert_msg_proc_t *proc, const dessert_meshif_t *iface, dessert_frameid_t id) {
 	// if current node is the destination of the message but message is not for the current node
 	if (memcmp(dessert_l25_defsrc, msg->l2h.ether_dhost, ETH_ALEN) == 0 && !(proc->lflags & DESSERT_RX_FLAG_L25_DST)) {
-		all_nodes_t* node;
-		HASH_FIND(hh, all_nodes_head, msg->l2h.ether_dhost, ETH_ALEN, node);
+		pthread_rwlock_rdlock(&pp_rwlock);
+		all_nodes_t* node = topo_get_node(msg->l2h.ether_dhost);
 
 		if (node && memcmp(node->next_hop, ether_broadcast, ETH_ALEN) != 0) {
 			memcpy(msg->l2h.ether_dhost, node->next_hop, ETH_ALEN);
+			pthread_rwlock_unlock(&pp_rwlock);
 			dessert_meshsend_fast(msg, NULL);
+		} else {
+			pthread_rwlock_unlock(&pp_rwlock);
 		}
 
 		return DESSERT_MSG_DROP;
@@ -0,0 +1,235 @@
+#include "des-lsr.h"
+#include "des-lsr_items.h"
+#include <utlist.h>
+#include <string.h>
+
+/*
+ * Topology store
+ *
+ * Every node that is known, either as originator of a TC, as target of an
+ * advertised link or as direct neighbor, is interned exactly once: it gets
+ * an entry in all_nodes_head and a small integer id indexing node_table.
+ * Links are kept in a realloc-grown edge array per node and refer to their
+ * target by id. A node is reference counted by the edges and neighbor
+ * entries pointing to it plus one reference while its own TC info is held;
+ * it is freed together with its edge array when the last reference is gone.
+ *
+ * TC info and direct neighbors age out of two FIFO queues ordered by expiry
+ * time. A refreshed entry is moved to the tail, so topo_expire() only has
+ * to look at the heads. All functions must be called with pp_rwlock write
+ * locked.
+ */
+
+node_neighbors_t* dir_neighbors_head = NULL;
+all_nodes_t* all_nodes_head          = NULL;
+
+static all_nodes_t** node_table      = NULL;	// indexed by node id
+static node_id_t node_table_size     = 0;	// ids handed out so far
+static size_t node_table_cap         = 0;
+static node_id_t* free_ids           = NULL;	// stack of unused ids below node_table_size
+static node_id_t free_id_count       = 0;
+
+static all_nodes_t* tc_aging_head    = NULL;
+static node_neighbors_t* nh_aging_head = NULL;
+
+static void lifetime(struct timeval *expires, u_int16_t entry_age, u_int16_t refresh_interval) {
+	u_int32_t lifetime_ms = entry_age * refresh_interval;
+	gettimeofday(expires, NULL);
+	dessert_timevaladd(expires, lifetime_ms / 1000, (lifetime_ms % 1000) * 1000);
+}
+
+// --- NODES --- //
+all_nodes_t* topo_get_node(const u_int8_t *addr) {
+	all_nodes_t *node;
+	HASH_FIND(hh, all_nodes_head, addr, ETH_ALEN, node);
+	return node;
+}
+
+all_nodes_t* topo_node_by_id(node_id_t id) {
+	return (id < node_table_size) ? node_table[id] : NULL;
+}
+
+node_id_t topo_node_id_max() {
+	return node_table_size;
+}
+
+static node_id_t alloc_id() {
+	if (free_id_count) {
+		return free_ids[--free_id_count];
+	}
+	if (node_table_size == NODE_ID_NONE) {
+		return NODE_ID_NONE;
+	}
+	if (node_table_size == node_table_cap) {
+		node_table_cap = node_table_cap ? 2 * node_table_cap : 16;
+		node_table = realloc(node_table, node_table_cap * sizeof(all_nodes_t*));
+		free_ids = realloc(free_ids, node_table_cap * sizeof(node_id_t));
+	}
+	return node_table_size++;
+}
+
+/** Looks up the node or creates it; the caller owns one new reference. */
+all_nodes_t* topo_intern_node(const u_int8_t *addr) {
+	all_nodes_t *node = topo_get_node(addr);
+	if (node) {
+		node->refcnt++;
+		return node;
+	}
+
+	node_id_t id = alloc_id();
+	if (id == NODE_ID_NONE) {
+		dessert_warn("node table full, ignoring " MAC, EXPLODE_ARRAY6(addr));
+		return NULL;
+	}
+	node = malloc(sizeof(all_nodes_t));
+	memset(node, 0, sizeof(all_nodes_t));
+	memcpy(node->addr, addr, ETH_ALEN);
+	memcpy(node->next_hop, ether_broadcast, ETH_ALEN);
+	node->id = id;
+	node->prev_hop = NODE_ID_NONE;
+	node->distance = INFINITY;
+	node->refcnt = 1;
+	node_table[id] = node;
+	HASH_ADD_KEYPTR(hh, all_nodes_head, node->addr, ETH_ALEN, node);
+	return node;
+}
+
+static void clear_edges(all_nodes_t *node) {
+	while (node->edge_count) {
+		topo_del_edge(node, node->edge_count - 1);
+	}
+	free(node->edges);
+	node->edges = NULL;
+	node->edge_size = 0;
+}
+
+/** Drops one reference; the node is freed when none is left. */
+void topo_release_node(all_nodes_t *node) {
+	if (--node->refcnt) {
+		return;
+	}
+	clear_edges(node);
+	HASH_DEL(all_nodes_head, node);
+	node_table[node->id] = NULL;
+	free_ids[free_id_count++] = node->id;
+	free(node);
+}
+
+/** Marks the TC info of the node as fresh and (re)queues it for aging. */
+void topo_refresh_tc(all_nodes_t *node) {
+	if (node->has_tc) {
+		DL_DELETE(tc_aging_head, node);
+	} else {
+		node->has_tc = 1;
+		node->refcnt++;
+	}
+	lifetime(&node->expires, rt_entry_age, rt_refresh_interval);
+	DL_APPEND(tc_aging_head, node);
+}
+
+// --- EDGES --- //
+edge_t* topo_find_edge(all_nodes_t *node, node_id_t target) {
+	int i;
+	for (i = 0; i < node->edge_count; i++) {
+		if (node->edges[i].target == target) {
+			return &node->edges[i];
+		}
+	}
+	return NULL;
+}
+
+/** Adds a link; the edge holds a reference on its target. NULL if the adjacency cannot grow. */
+edge_t* topo_add_edge(all_nodes_t *node, all_nodes_t *target, u_int8_t weight) {
+	if (node->edge_count == UINT16_MAX) {
+		return NULL;
+	}
+	if (node->edge_count >= node->edge_size) {
+		u_int16_t size = node->edge_size ? min(2 * node->edge_size, UINT16_MAX) : 4;
+		edge_t *edges = realloc(node->edges, size * sizeof(edge_t));
+		if (!edges) {
+			return NULL;
+		}
+		node->edges = edges;
+		node->edge_size = size;
+	}
+	edge_t *edge = &node->edges[node->edge_count++];
+	edge->target = target->id;
+	edge->weight = weight;
+	edge->tc_mark = node->seq_nr;
+	target->refcnt++;
+	return edge;
+}
+
+/** Removes the link at index by moving the last edge into the gap. */
+void topo_del_edge(all_nodes_t *node, int index) {
+	all_nodes_t *target = node_table[node->edges[index].target];
+	node->edges[index] = node->edges[--node->edge_count];
+	topo_release_node(target);
+}
+
+// --- DIRECT NEIGHBORS --- //
+node_neighbors_t* topo_get_neighbor(const u_int8_t *addr) {
+	node_neighbors_t *neighbor;
+	HASH_FIND(hh, dir_neighbors_head, addr, ETH_ALEN, neighbor);
+	return neighbor;
+}
+
+/** Looks up or creates the neighbor and (re)queues it for aging. */
+node_neighbors_t* topo_refresh_neighbor(const u_int8_t *addr) {
+	node_neighbors_t *neighbor = topo_get_neighbor(addr);
+	if (neighbor) {
+		DL_DELETE(nh_aging_head, neighbor);
+	} else {
+		all_nodes_t *node = topo_intern_node(addr);
+		if (!node) {
+			return NULL;
+		}
+		neighbor = malloc(sizeof(node_neighbors_t));
+		memcpy(neighbor->addr, addr, ETH_ALEN);
+		neighbor->weight = 1;
+		neighbor->id = node->id;
+		HASH_ADD_KEYPTR(hh, dir_neighbors_head, neighbor->addr, ETH_ALEN, neighbor);
+	}
+	lifetime(&neighbor->expires, nh_entry_age, nh_refresh_interval);
+	DL_APPEND(nh_aging_head, neighbor);
+	return neighbor;
+}
+
+/** Remaining lifetime of the neighbor in units of nh_refresh_interval, as sent in TCs. */
+u_int8_t topo_neighbor_entry_age(node_neighbors_t *neighbor, const struct timeval *now) {
+	int64_t remaining_ms = (neighbor->expires.tv_sec - now->tv_sec) * 1000
+		+ (neighbor->expires.tv_usec - now->tv_usec) / 1000;
+	if (remaining_ms <= 0) {
+		return 0;
+	}
+	return min(remaining_ms / nh_refresh_interval, UINT8_MAX);
+}
+
+static void del_neighbor(node_neighbors_t *neighbor) {
+	DL_DELETE(nh_aging_head, neighbor);
+	HASH_DEL(dir_neighbors_head, neighbor);
+	topo_release_node(node_table[neighbor->id]);
+	free(neighbor);
+}
+
+// --- AGING --- //
+/** Removes expired neighbors and TC info; returns the number of removed entries. */
+int topo_expire(const struct timeval *now) {
+	int removed = 0;
+
+	while (nh_aging_head && dessert_timevalcmp(&nh_aging_head->expires, now) <= 0) {
+		del_neighbor(nh_aging_head);
+		removed++;
+	}
+
+	while (tc_aging_head && dessert_timevalcmp(&tc_aging_head->expires, now) <= 0) {
+		all_nodes_t *node = tc_aging_head;
+		DL_DELETE(tc_aging_head, node);
+		node->has_tc = 0;
+		clear_edges(node);
+		topo_release_node(node);
+		removed++;
+	}
+
+	return removed;
+}
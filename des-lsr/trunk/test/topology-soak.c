@@ -0,0 +1,219 @@
+#include "../src/des-lsr.h"
+#include "../src/des-lsr_items.h"
+#include <malloc.h>
+#include <string.h>
+
+/*
+ * Soak test of the topology store. A population of nodes joins and leaves
+ * the network while the daemon's own HELLO, TC and aging handlers run on a
+ * simulated clock (the test is linked with -Wl,--wrap=gettimeofday): every
+ * simulated second the neighbors among the live nodes send HELLOs, a
+ * quarter of the live nodes send a TC listing their current links, links
+ * are rewired every few minutes and the topology is aged, a TC is built by
+ * send_tc and the routes are recalculated.
+ *
+ * After every simulated hour the number of interned nodes, neighbors and
+ * node ids and the heap in use are checked against the first hour. Then a
+ * node gets more links than a u_int8_t counts, all of which have to be
+ * stored. At the end the clock jumps past all lifetimes and the store has
+ * to be empty.
+ * Meant to be run under valgrind or an ASan build (make topology-soak
+ * CFLAGS+=-fsanitize=address), which report what the counts cannot.
+ *
+ * usage: topology-soak [hours] [nodes] [links per node]
+ */
+
+#define NEIGHBOR_SLOTS 48	// nodes 0..NEIGHBOR_SLOTS-1 are in range of this node
+#define CHURN_PERCENT 2		// share of the nodes joining or leaving per second
+#define REWIRE_SECS 300		// period after which a node picks new links
+#define HEAP_SLACK (64 * 1024)
+
+static struct timeval sim_now;
+
+int __wrap_gettimeofday(struct timeval *tv, void *tz) {
+	*tv = sim_now;
+	return 0;
+}
+
+typedef struct sim_node {
+	u_int8_t addr[ETH_ALEN];
+	u_int8_t alive;
+	u_int8_t seq_nr;
+} sim_node_t;
+
+static sim_node_t *sim_nodes;
+static int node_count;
+static int link_count;
+
+static void sim_addr(u_int8_t *addr, int n) {
+	addr[0] = 0x02;
+	addr[1] = 0x00;
+	addr[2] = 0x00;
+	addr[3] = (n >> 16) & 0xff;
+	addr[4] = (n >> 8) & 0xff;
+	addr[5] = n & 0xff;
+}
+
+static dessert_msg_t* sim_msg(int n, u_int8_t ext_type, size_t ext_len, dessert_ext_t **ext) {
+	dessert_msg_t *msg;
+	dessert_ext_t *eth;
+	dessert_msg_new(&msg);
+	if (ext_type) {
+		dessert_msg_addext(msg, ext, ext_type, ext_len);
+	}
+	dessert_msg_addext(msg, &eth, DESSERT_EXT_ETH, ETHER_HDR_LEN);
+	struct ether_header* l25h = (struct ether_header*) eth->data;
+	memcpy(l25h->ether_shost, sim_nodes[n].addr, ETH_ALEN);
+	memcpy(l25h->ether_dhost, ether_broadcast, ETH_ALEN);
+	return msg;
+}
+
+static void sim_hello(int n) {
+	dessert_msg_proc_t proc;
+	dessert_ext_t *ext;
+	dessert_msg_t *msg = sim_msg(n, LSR_EXT_HELLO, sizeof(hello_ext_t), &ext);
+	memset(&proc, 0, sizeof(proc));
+	process_hello(msg, 0, &proc, NULL, 0);
+	dessert_msg_destroy(msg);
+}
+
+// the links of a node are a function of the node and the current rewiring period
+static void sim_tc(int n) {
+	dessert_msg_proc_t proc;
+	dessert_ext_t *ext;
+	int entries = min(link_count, TC_MAX_ENTRIES_PER_EXT);
+	unsigned int seed = n * 7919 + (sim_now.tv_sec + n) / REWIRE_SECS;
+	dessert_msg_t *msg = sim_msg(n, LSR_EXT_TC, 1 + entries * TC_ENTRY_SIZE, &ext);
+	u_int8_t *tc_ext = ext->data;
+	int i;
+
+	msg->u8 = ++sim_nodes[n].seq_nr;
+	*tc_ext++ = 1 + entries * TC_ENTRY_SIZE;
+	for (i = 0; i < entries; i++) {
+		sim_addr(tc_ext, rand_r(&seed) % node_count);
+		tc_ext += ETH_ALEN;
+		*tc_ext++ = nh_entry_age;
+		*tc_ext++ = 1 + rand_r(&seed) % 4;
+	}
+	memset(&proc, 0, sizeof(proc));
+	process_tc(msg, 0, &proc, NULL, 0);
+	dessert_msg_destroy(msg);
+}
+
+// adds links from a new node to as many new nodes, returns how many the store kept
+static int store_wide(int links) {
+	u_int8_t addr[ETH_ALEN];
+	int i, stored;
+
+	sim_addr(addr, node_count);
+	all_nodes_t *node = topo_intern_node(addr);
+	for (i = 0; i < links; i++) {
+		sim_addr(addr, node_count + 1 + i);
+		all_nodes_t *target = topo_intern_node(addr);
+		if (target) {
+			topo_add_edge(node, target, 1);
+			topo_release_node(target);	// the edge holds its own reference
+		}
+	}
+	// the last target is kept by its edge only
+	all_nodes_t *last = topo_get_node(addr);
+	stored = (last && topo_find_edge(node, last->id)) ? node->edge_count : -1;
+	topo_release_node(node);	// and the edges with it
+	return stored;
+}
+
+static void sim_second() {
+	int n;
+
+	for (n = 0; n < node_count; n++) {
+		if (rand() % 100 < CHURN_PERCENT) {
+			sim_nodes[n].alive = !sim_nodes[n].alive;
+		}
+		if (!sim_nodes[n].alive) {
+			continue;
+		}
+		if (n < NEIGHBOR_SLOTS && rand() % hello_interval < 1000) {
+			sim_hello(n);
+		}
+		if ((sim_now.tv_sec + n) % (tc_interval / 1000) == 0) {
+			sim_tc(n);
+		}
+	}
+
+	age_topology(NULL, NULL, NULL);
+	if (sim_now.tv_sec % (tc_interval / 1000) == 0) {
+		send_tc(NULL, NULL, NULL);
+	}
+	pthread_rwlock_wrlock(&pp_rwlock);
+	shortest_path(dessert_l25_defsrc);
+	pthread_rwlock_unlock(&pp_rwlock);
+	sim_now.tv_sec++;
+}
+
+static size_t heap_in_use() {
+	struct mallinfo2 mi = mallinfo2();
+	return mi.uordblks;
+}
+
+int main(int argc, char** argv) {
+	int hours = (argc > 1) ? atoi(argv[1]) : 6;
+	int errors = 0;
+	size_t first_nodes = 0, first_heap = 0;
+	node_id_t first_ids = 0;
+	int h, s, n;
+
+	node_count = (argc > 2) ? atoi(argv[2]) : 400;
+	link_count = (argc > 3) ? atoi(argv[3]) : 8;
+	sim_nodes = calloc(node_count, sizeof(sim_node_t));
+	srand(1);
+	for (n = 0; n < node_count; n++) {
+		sim_addr(sim_nodes[n].addr, n);
+		sim_nodes[n].alive = rand() % 2;
+	}
+	sim_now.tv_sec = 1000000;
+	memset(dessert_l25_defsrc, 0xaa, ETH_ALEN);
+
+	for (h = 1; h <= hours; h++) {
+		for (s = 0; s < 3600; s++) {
+			sim_second();
+		}
+
+		size_t nodes = HASH_COUNT(all_nodes_head);
+		size_t neighbors = HASH_COUNT(dir_neighbors_head);
+		size_t heap = heap_in_use();
+		node_id_t ids = topo_node_id_max();
+		printf("hour %d: nodes %zu neighbors %zu ids %u heap %zu bytes  TCs %u changed %u\n",
+			h, nodes, neighbors, ids, heap, tc_received, tc_topology_changed);
+
+		// ids and memory are reused, so the store stops growing after the first hour
+		if (h == 1) {
+			first_nodes = nodes;
+			first_ids = ids;
+			first_heap = heap;
+		} else if (ids > node_count + 1 || nodes > node_count + 1
+			|| heap > first_heap + first_heap / 4 + HEAP_SLACK) {
+			printf("hour %d: store grew from %zu nodes, %u ids, %zu bytes\n", h, first_nodes, first_ids, first_heap);
+			errors++;
+		}
+	}
+
+	// a node with more links than a u_int8_t counts
+	int stored = store_wide(300);
+	if (stored != 300 || tc_edges_refused) {
+		printf("wide adjacency: %d of 300 links stored, %u refused\n", stored, tc_edges_refused);
+		errors++;
+	}
+
+	// everything expires once no HELLO or TC is received any more
+	u_int32_t nh_lifetime = nh_entry_age * nh_refresh_interval, rt_lifetime = rt_entry_age * rt_refresh_interval;
+	sim_now.tv_sec += ((nh_lifetime > rt_lifetime) ? nh_lifetime : rt_lifetime) / 1000 + 1;
+	age_topology(NULL, NULL, NULL);
+	if (all_nodes_head || dir_neighbors_head) {
+		printf("left after expiry: nodes %u neighbors %u\n", HASH_COUNT(all_nodes_head), HASH_COUNT(dir_neighbors_head));
+		errors++;
+	}
+
+	printf("%d simulated hours, %d nodes: errors %d\n", hours, node_count, errors);
+	free(sim_nodes);
+	return errors ? 1 : 0;
+}
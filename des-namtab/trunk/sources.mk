@@ -19,6 +19,7 @@ src/database \
 src/database/routing_table \
 src/database/rl_seq_t \
 src/database/neighbor_table \
+src/database/failover \
 src/database/inv_routing_table \
 src/database/broadcast_log \
 src/database/backup_routing_table \
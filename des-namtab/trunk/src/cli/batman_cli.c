@@ -28,6 +28,7 @@ For further information and questions please use the web site
 #include "../database/batman_database.h"
 #include "../pipeline/batman_pipeline.h"
 #include "../config.h"
+#include "../routing_log.h"
 #include <string.h>
 #include <time.h>
 #include <stdio.h>
@@ -121,16 +122,53 @@ int batman_cli_print_rt(struct cli_def* cli, char* command, char* argv[], int ar
     return CLI_OK;
 }
 
+int batman_cli_print_failover(struct cli_def* cli, char* command, char* argv[], int argc) {
+    char* fo_report;
+    batman_db_rlock();
+    batman_db_fo_report(&fo_report);
+    batman_db_unlock();
+    cli_print(cli, "\n%s\n", fo_report);
+    free(fo_report);
+    return CLI_OK;
+}
+
 // -------------------- common cli functions ----------------------------------------------
 
 int cli_setrouting_log(struct cli_def* cli, char* command, char* argv[], int argc) {
-    routing_log_file = malloc(strlen(argv[0]));
-    strcpy(routing_log_file, argv[0]);
-    FILE* f = fopen(routing_log_file, "a+");
-    time_t lt;
-    lt = time(NULL);
-    fprintf(f, "\n--- %s\n", ctime(&lt));
-    fclose(f);
-    dessert_info("logging routing data at file %s", routing_log_file);
+    if(argc != 1) {
+        cli_print(cli, "usage of %s command [path to log file]\n", command);
+        return CLI_ERROR_ARG;
+    }
+
+    if(rlog_open(argv[0], (uint64_t) routing_log_max_size * 1024) == false) {
+        dessert_err("could not open routing log file %s", argv[0]);
+        return CLI_ERROR;
+    }
+
+    char* old_file = routing_log_file;
+    routing_log_file = strdup(argv[0]);
+    free(old_file);
+    dessert_info("logging routing data at file %s (binary, convert with rlog_decode)", routing_log_file);
+    return CLI_OK;
+}
+
+int cli_setrouting_log_size(struct cli_def* cli, char* command, char* argv[], int argc) {
+    uint32_t new_size;
+
+    if(argc != 1 || sscanf(argv[0], "%u", &new_size) != 1) {
+        cli_print(cli, "usage of %s command [max size in KiB, 0 = no rotation]\n", command);
+        return CLI_ERROR_ARG;
+    }
+
+    routing_log_max_size = new_size;
+    rlog_set_max_size((uint64_t) routing_log_max_size * 1024);
+    dessert_info("routing log is rotated at %u KiB", routing_log_max_size);
+    return CLI_OK;
+}
+
+int cli_showrouting_log(struct cli_def* cli, char* command, char* argv[], int argc) {
+    cli_print(cli, "routing log: %s, rotation at %u KiB, %llu records written, %llu dropped\n",
+              (routing_log_file != NULL) ? routing_log_file : "off", routing_log_max_size,
+              (unsigned long long) rlog_written(), (unsigned long long) rlog_dropped());
     return CLI_OK;
 }
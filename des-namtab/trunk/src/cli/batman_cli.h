@@ -40,6 +40,8 @@ int batman_cli_print_irt(struct cli_def* cli, char* command, char* argv[], int a
 
 int batman_cli_print_rt(struct cli_def* cli, char* command, char* argv[], int argc);
 
+int batman_cli_print_failover(struct cli_def* cli, char* command, char* argv[], int argc);
+
 int cli_cfgsysif(struct cli_def* cli, char* command, char* argv[], int argc);
 
 int cli_addmeshif(struct cli_def* cli, char* command, char* argv[], int argc);
@@ -47,3 +49,7 @@ int cli_addmeshif(struct cli_def* cli, char* command, char* argv[], int argc);
 int cli_setport(struct cli_def* cli, char* command, char* argv[], int argc);
 
 int cli_setrouting_log(struct cli_def* cli, char* command, char* argv[], int argc);
+
+int cli_setrouting_log_size(struct cli_def* cli, char* command, char* argv[], int argc);
+
+int cli_showrouting_log(struct cli_def* cli, char* command, char* argv[], int argc);
@@ -27,7 +27,7 @@ For further information and questions please use the web site
 #include <stdbool.h>
 #include <dessert.h>
 
-#define VERSION 				5
+#define VERSION 				6
 #define TTL_MIN 				2
 #define TTL_MAX 				255
 #define SEQNO_MAX 				65535
@@ -51,14 +51,20 @@ For further information and questions please use the web site
 #define RL_EXT_TYPE				DESSERT_EXT_USER + 3
 #define OGM_EXT_LEN				sizeof(struct batman_msg_ogm)
 #define OGM_RESET_COUNT			3
+#define IRT_FULL_INTERVAL		16			// OGMs between inverted routing table snapshots
+#define IRT_DELTA_MAX_SHARE		50			// take new snapshot if delta needs more % of OGM space
+#define FAILOVER_MISSED_OGMS	3			// OGM intervals without OGM from a neighbor until its link is lost
+#define FAILOVER_CHECK_INTERVAL	250			// interval of link checks in ms
 
 #define USE_PRECURSOR_LIST		true		// 1 = user precursor list
 #define OGM_PREC_LIST_SIZE		12 			// size of precursor list in OGM. Size MUST be between 1 and 255
+#define ROUTING_LOG_MAX_SIZE	0			// rotate routing log at this size in KiB, 0 = never
 
 extern int 						be_verbose;
 extern int 						ogm_precursor_mode;
 extern int 						cli_port;
 extern char*					routing_log_file;
+extern uint32_t					routing_log_max_size;
 
 
 #endif
@@ -28,6 +28,7 @@ For further information and questions please use the web site
 #include "batman_brt.h"
 #include "batman_brt_nht.h"
 #include "../timeslot.h"
+#include "../failover/batman_failover.h"
 
 #define REPORT_RT_STR_LEN 114
 
@@ -293,9 +294,11 @@ int batman_db_brt_getbestroute_arl(uint8_t ether_dest_addr[ETH_ALEN],
         return false;
     }
 
-    // first check if best route not contained in precursors list
+    // first check if best route not contained in precursors list and its link is not lost
     if(batman_db_brt_check_precursors_list(precursors_iface_list, precursors_iface_count,
-                                           rt_entry->best_output_iface->nht->best_next_hop->ether_nexthop_addr) == false) {
+                                           rt_entry->best_output_iface->nht->best_next_hop->ether_nexthop_addr) == false &&
+       batman_db_fo_linkdown(rt_entry->best_output_iface->nht->best_next_hop->ether_nexthop_addr,
+                             rt_entry->best_output_iface->ether_iface) == false) {
         *ether_iface_out = rt_entry->best_output_iface->ether_iface;
         memcpy(ether_nexthop_addr_out, rt_entry->best_output_iface->nht->best_next_hop->ether_nexthop_addr, ETH_ALEN);
         batman_db_brt_add_myinterfaces_to_precursors(precursors_iface_list, precursors_iface_count);
@@ -338,7 +341,8 @@ int batman_db_brt_getbestroute_arl(uint8_t ether_dest_addr[ETH_ALEN],
         re = re->next;
 
         if(found == false && batman_db_brt_check_precursors_list(precursors_iface_list, precursors_iface_count,
-                current_entry->next_hop) == false) {
+                current_entry->next_hop) == false &&
+           batman_db_fo_linkdown(current_entry->next_hop, current_entry->out_iface) == false) {
             // set next hop and output_iface towards destination
             *ether_iface_out = current_entry->out_iface;
             memcpy(ether_nexthop_addr_out, current_entry->next_hop, ETH_ALEN);
@@ -363,6 +367,52 @@ int batman_db_brt_getbestroute_arl(uint8_t ether_dest_addr[ETH_ALEN],
     return found;
 }
 
+int batman_db_brt_getbackup(uint8_t ether_dest_addr[ETH_ALEN],
+                            const uint8_t exclude_nexthop[ETH_ALEN], const dessert_meshif_t* exclude_iface,
+                            const dessert_meshif_t** ether_iface_out, uint8_t ether_nexthop_addr_out[ETH_ALEN]) {
+    batman_brt_entry_t* rt_entry;
+    batman_rt_bnht_entry_t* best = NULL;
+    const dessert_meshif_t* best_iface = NULL;
+
+    HASH_FIND(hh, brt.entrys, ether_dest_addr, ETH_ALEN, rt_entry);
+
+    if(rt_entry == NULL) {
+        return false;
+    }
+
+    batman_brt_if_entry_t* if_entry;
+
+    for(if_entry = rt_entry->if_entrys; if_entry != NULL; if_entry = if_entry->hh.next) {
+        batman_rt_bnht_entry_t* nht_entry;
+
+        for(nht_entry = if_entry->nht->entrys; nht_entry != NULL; nht_entry = nht_entry->hh.next) {
+            if(if_entry->ether_iface == exclude_iface &&
+               memcmp(nht_entry->ether_nexthop_addr, exclude_nexthop, ETH_ALEN) == 0) {
+                continue;
+            }
+
+            if(best != NULL && nht_entry->sw->size <= best->sw->size) {
+                continue;
+            }
+
+            if(batman_db_fo_linkdown(nht_entry->ether_nexthop_addr, if_entry->ether_iface) == true) {
+                continue;
+            }
+
+            best = nht_entry;
+            best_iface = if_entry->ether_iface;
+        }
+    }
+
+    if(best == NULL) {
+        return false;
+    }
+
+    *ether_iface_out = best_iface;
+    memcpy(ether_nexthop_addr_out, best->ether_nexthop_addr, ETH_ALEN);
+    return true;
+}
+
 int batman_db_brt_getroutesn(uint8_t ether_dest_addr[ETH_ALEN]) {
     batman_brt_entry_t* rt_entry;
     // find appropriate routing table entry
@@ -21,8 +21,8 @@ For further information and questions please use the web site
        http://www.des-testbed.net
 *******************************************************************************/
 
-#ifndef BATMAN_RT
-#define BATMAN_RT
+#ifndef BATMAN_BRT
+#define BATMAN_BRT
 
 #include <linux/if_ether.h>
 #include <dessert.h>
@@ -49,6 +49,13 @@ int batman_db_brt_getbestroute_arl(uint8_t ether_dest_addr[ETH_ALEN],
                                    uint8_t precursors_iface_list[OGM_PREC_LIST_SIZE* ETH_ALEN],
                                    uint8_t* presursosr_iface_count);
 
+/**
+ * Get the best route towards destination that does not use exclude_nexthop over exclude_iface.
+ * Next hops over lost links are skipped.
+ */
+int batman_db_brt_getbackup(uint8_t ether_dest_addr[ETH_ALEN],
+                            const uint8_t exclude_nexthop[ETH_ALEN], const dessert_meshif_t* exclude_iface,
+                            const dessert_meshif_t** ether_iface_out, uint8_t ether_nexthop_addr_out[ETH_ALEN]);
 
 /** Get last know seq_num of destination */
 int batman_db_brt_getroutesn(uint8_t ether_dest_addr[ETH_ALEN]);
@@ -46,6 +46,7 @@ int batman_db_init() {
     batman_db_rt_init();
     batman_db_brct_init();
     batman_db_nt_init();
+    batman_db_fo_init();
     rl_table_init();
     return true;
 }
@@ -59,6 +60,10 @@ int batman_db_cleanup() {
         return false;
     }
 
+    if(batman_db_fo_cleanup() == false) {
+        return false;
+    }
+
     return true;
 }
 
@@ -29,6 +29,7 @@ For further information and questions please use the web site
 #include "broadcast_log/broadcast_log.h"
 #include "neighbor_table/batman_nt.h"
 #include "backup_routing_table/batman_brt.h"
+#include "failover/batman_failover.h"
 
 
 /** Make read lock over database to avoid corrupt read/write */
@@ -0,0 +1,230 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+#include <stdio.h>
+#include <time.h>
+#include <uthash.h>
+#include "batman_failover.h"
+#include "../routing_table/batman_rt.h"
+#include "../../config.h"
+
+#define REPORT_FO_STR_LEN 68
+
+typedef struct batman_fo_link {
+    uint8_t					ether_neighbor[ETH_ALEN];	// key
+    uint8_t					ether_iface[ETH_ALEN];		// key
+    const dessert_meshif_t*	local_iface;
+    struct timeval			last_heard;
+    /** OGM intervals missed since last_heard */
+    uint32_t				missed;
+    int						down;
+    UT_hash_handle			hh;
+} batman_fo_link_t;
+
+typedef struct batman_fo_stats {
+    uint32_t	links_lost;
+    uint32_t	links_restored;
+    /** lost links that had routes to fail over */
+    uint32_t	failovers;
+    uint32_t	routes_switched;
+    /** routes deleted because no backup was known */
+    uint32_t	routes_lost;
+    /** duration of the route switch in usec */
+    uint32_t	last_usec;
+    uint32_t	max_usec;
+    uint64_t	total_usec;
+} batman_fo_stats_t;
+
+static batman_fo_link_t* links = NULL;
+static batman_fo_stats_t fo_stats;
+static uint32_t ogm_int_ms = ORIG_INTERVAL * 1000;
+
+static batman_fo_link_t* _find_link(const uint8_t ether_neighbor_addr[ETH_ALEN], const dessert_meshif_t* local_iface) {
+    batman_fo_link_t* link;
+    uint8_t addr_sum[2*ETH_ALEN];
+    memcpy(addr_sum, ether_neighbor_addr, ETH_ALEN);
+    memcpy(addr_sum + ETH_ALEN, local_iface->hwaddr, ETH_ALEN);
+    HASH_FIND(hh, links, addr_sum, 2 * ETH_ALEN, link);
+    return link;
+}
+
+static uint32_t _elapsed_usec(const struct timespec* start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1000000 + (end.tv_nsec - start->tv_nsec) / 1000;
+}
+
+static void _failover(batman_fo_link_t* link) {
+    struct timespec start;
+    uint32_t switched = 0;
+    uint32_t lost = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    batman_db_rt_failover(link->ether_neighbor, link->local_iface, &switched, &lost);
+    uint32_t usec = _elapsed_usec(&start);
+
+    fo_stats.links_lost++;
+
+    if(switched + lost > 0) {
+        fo_stats.failovers++;
+        fo_stats.routes_switched += switched;
+        fo_stats.routes_lost += lost;
+        fo_stats.last_usec = usec;
+        fo_stats.total_usec += usec;
+
+        if(usec > fo_stats.max_usec) {
+            fo_stats.max_usec = usec;
+        }
+    }
+
+    dessert_info("%s <-/-> " MAC " - link lost after %u missed OGMs, %u routes switched, %u lost in %u usec",
+                 link->local_iface->if_name, EXPLODE_ARRAY6(link->ether_neighbor),
+                 link->missed, switched, lost, usec);
+}
+
+int batman_db_fo_init() {
+    links = NULL;
+    memset(&fo_stats, 0, sizeof(fo_stats));
+    return true;
+}
+
+int batman_db_fo_set_ogmint(time_t ogm_int) {
+    ogm_int_ms = ogm_int * 1000;
+    return true;
+}
+
+int batman_db_fo_heard(uint8_t ether_neighbor_addr[ETH_ALEN], const dessert_meshif_t* local_iface,
+                       const struct timeval* now) {
+    batman_fo_link_t* link = _find_link(ether_neighbor_addr, local_iface);
+
+    if(link == NULL) {
+        link = malloc(sizeof(batman_fo_link_t));
+
+        if(link == NULL) {
+            return false;
+        }
+
+        memcpy(link->ether_neighbor, ether_neighbor_addr, ETH_ALEN);
+        memcpy(link->ether_iface, local_iface->hwaddr, ETH_ALEN);
+        link->local_iface = local_iface;
+        link->down = false;
+        HASH_ADD_KEYPTR(hh, links, link->ether_neighbor, 2 * ETH_ALEN, link);
+    }
+    else if(link->down == true) {
+        link->down = false;
+        fo_stats.links_restored++;
+        dessert_info("%s <---> " MAC " - link restored", local_iface->if_name, EXPLODE_ARRAY6(ether_neighbor_addr));
+    }
+
+    link->last_heard = *now;
+    link->missed = 0;
+    return true;
+}
+
+int batman_db_fo_linkdown(const uint8_t ether_neighbor_addr[ETH_ALEN], const dessert_meshif_t* local_iface) {
+    batman_fo_link_t* link = _find_link(ether_neighbor_addr, local_iface);
+    return link != NULL && link->down == true;
+}
+
+int batman_db_fo_check(const struct timeval* now) {
+    batman_fo_link_t* link;
+    int lost = 0;
+
+    for(link = links; link != NULL; link = link->hh.next) {
+        if(link->down == true) {
+            continue;
+        }
+
+        int64_t elapsed_ms = (int64_t)(now->tv_sec - link->last_heard.tv_sec) * 1000
+                             + (now->tv_usec - link->last_heard.tv_usec) / 1000;
+        link->missed = (elapsed_ms > 0) ? elapsed_ms / ogm_int_ms : 0;
+
+        if(link->missed >= FAILOVER_MISSED_OGMS) {
+            link->down = true;
+            _failover(link);
+            lost++;
+        }
+    }
+
+    return lost;
+}
+
+int batman_db_fo_cleanup() {
+    batman_fo_link_t* link;
+    batman_fo_link_t* tmp;
+    time_t now = time(0);
+
+    HASH_ITER(hh, links, link, tmp) {
+        if(link->last_heard.tv_sec + NEIGHBOR_TIMEOUT < now) {
+            HASH_DEL(links, link);
+            free(link);
+        }
+    }
+
+    return true;
+}
+
+// ------------------- reporting -----------------------------------------------
+
+int batman_db_fo_report(char** str_out) {
+    batman_fo_link_t* link;
+    char* output;
+    char entry_str[REPORT_FO_STR_LEN + 1];
+
+    output = malloc(sizeof(char) * REPORT_FO_STR_LEN * (14 + HASH_COUNT(links)) + 1);
+
+    if(output == NULL) {
+        return false;
+    }
+
+    // initialize first byte to \0 to mark output as empty
+    *output = '\0';
+    snprintf(entry_str, sizeof(entry_str), "links lost:       %10u\n", fo_stats.links_lost);
+    strcat(output, entry_str);
+    snprintf(entry_str, sizeof(entry_str), "links restored:   %10u\n", fo_stats.links_restored);
+    strcat(output, entry_str);
+    snprintf(entry_str, sizeof(entry_str), "failovers:        %10u\n", fo_stats.failovers);
+    strcat(output, entry_str);
+    snprintf(entry_str, sizeof(entry_str), "routes switched:  %10u\n", fo_stats.routes_switched);
+    strcat(output, entry_str);
+    snprintf(entry_str, sizeof(entry_str), "routes lost:      %10u\n", fo_stats.routes_lost);
+    strcat(output, entry_str);
+    snprintf(entry_str, sizeof(entry_str), "switch time usec: %10u last, %u max, %u avg\n\n",
+             fo_stats.last_usec, fo_stats.max_usec,
+             fo_stats.failovers ? (uint32_t)(fo_stats.total_usec / fo_stats.failovers) : 0);
+    strcat(output, entry_str);
+    strcat(output, "+-------------------+--------------+---------------+-------+\n");
+    strcat(output, "|     neighbor      | local iface  | missed OGMs   | state |\n");
+    strcat(output, "+-------------------+--------------+---------------+-------+\n");
+
+    for(link = links; link != NULL; link = link->hh.next) {
+        snprintf(entry_str, sizeof(entry_str), "| " MAC " | %12s | %13u | %5s |\n",
+                 EXPLODE_ARRAY6(link->ether_neighbor), link->local_iface->if_name,
+                 link->missed, (link->down == true) ? "down" : "up");
+        strcat(output, entry_str);
+    }
+
+    strcat(output, "+-------------------+--------------+---------------+-------+\n");
+    *str_out = output;
+    return true;
+}
@@ -0,0 +1,73 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+#ifndef BATMAN_FAILOVER
+#define BATMAN_FAILOVER
+
+#include <dessert.h>
+
+#ifdef ANDROID
+#include <linux/if_ether.h>
+#endif
+
+/**
+ * Link monitor and backup route failover.
+ *
+ * Every OGM frame heard from a neighbor over a local interface refreshes the
+ * link to it. A link that missed FAILOVER_MISSED_OGMS OGM intervals is
+ * declared lost and all routes of the routing table using it are switched
+ * to their backup routes in one write locked step, so the forwarding path
+ * sees either the old or the new next hops but never a mix.
+ *
+ * All functions must be called with the database write locked, except
+ * batman_db_fo_linkdown and batman_db_fo_report that need a read lock only.
+ */
+
+/** initialize link table and failover counters */
+int batman_db_fo_init();
+
+/** set the OGM interval the missed OGM counters are based on */
+int batman_db_fo_set_ogmint(time_t ogm_int);
+
+/** Take a record that an OGM from neighbor was heard over local_iface at time now */
+int batman_db_fo_heard(uint8_t ether_neighbor_addr[ETH_ALEN], const dessert_meshif_t* local_iface,
+                       const struct timeval* now);
+
+/** returns: true if the link to neighbor over local_iface was declared lost */
+int batman_db_fo_linkdown(const uint8_t ether_neighbor_addr[ETH_ALEN], const dessert_meshif_t* local_iface);
+
+/**
+ * Declare links lost that missed too many OGMs and fail over the routes using them.
+ * returns: number of links declared lost
+ */
+int batman_db_fo_check(const struct timeval* now);
+
+/** forget links not heard of for NEIGHBOR_TIMEOUT */
+int batman_db_fo_cleanup();
+
+// ------------------- reporting -----------------------------------------------
+
+/** get link table and failover counters as string */
+int batman_db_fo_report(char** str_out);
+
+#endif
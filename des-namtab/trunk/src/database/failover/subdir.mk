@@ -0,0 +1,24 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+C_SRCS += \
+../src/database/failover/batman_failover.c 
+
+OBJS += \
+./src/database/failover/batman_failover.o 
+
+C_DEPS += \
+./src/database/failover/batman_failover.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+src/database/failover/%.o: ../src/database/failover/%.c
+	@echo 'Building file: $<'
+	@echo 'Invoking: GCC C Compiler'
+	gcc -O0 -g3 -Wall -c -fmessage-length=0 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.d)" -o"$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
@@ -40,6 +40,140 @@ struct batman_rt {
     timeslot_t*			ts;
 } irt;
 
+/*
+ * Advertisement cache
+ *
+ * The advertised form of every entry is kept in one array sorted by source
+ * address and updated with every change of the entry, so OGMs are built
+ * from ready-made entries instead of walking the table. Removed entries
+ * stay in the array as BATMAN_IRT_REMOVED tombstones until the next
+ * snapshot, so the delta can report them. adv_changes lists the addresses
+ * of all entries changed since the snapshot, every address at most once,
+ * so it never needs more space than the array itself.
+ */
+static struct batman_ogm_invrt* adv_entries = NULL;
+/** per entry of adv_entries: changed since the last snapshot */
+static uint8_t* adv_changed = NULL;
+static uint8_t (*adv_changes)[ETH_ALEN] = NULL;
+static int adv_count = 0;
+static int adv_size = 0;
+static int adv_removed = 0;
+static int adv_change_count = 0;
+
+/** returns: index of addr in adv_entries or -(insert position) - 1 if not contained */
+static int _adv_find(const uint8_t addr[ETH_ALEN]) {
+    int lo = 0;
+    int hi = adv_count - 1;
+
+    while(lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = memcmp(adv_entries[mid].source_addr, addr, ETH_ALEN);
+
+        if(cmp == 0) {
+            return mid;
+        }
+
+        if(cmp < 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+
+    return -lo - 1;
+}
+
+static int _adv_grow() {
+    int new_size = adv_size ? 2 * adv_size : 64;
+    struct batman_ogm_invrt* new_entries = realloc(adv_entries, new_size * sizeof(struct batman_ogm_invrt));
+
+    if(new_entries == NULL) {
+        return false;
+    }
+
+    adv_entries = new_entries;
+    uint8_t* new_changed = realloc(adv_changed, new_size);
+
+    if(new_changed == NULL) {
+        return false;
+    }
+
+    adv_changed = new_changed;
+    uint8_t (*new_changes)[ETH_ALEN] = realloc(adv_changes, new_size * ETH_ALEN);
+
+    if(new_changes == NULL) {
+        return false;
+    }
+
+    adv_changes = new_changes;
+    adv_size = new_size;
+    return true;
+}
+
+static void _adv_set(const struct batman_ogm_invrt* entry) {
+    int i = _adv_find(entry->source_addr);
+
+    if(i >= 0) {
+        if(memcmp(&adv_entries[i], entry, sizeof(struct batman_ogm_invrt)) == 0) {
+            return;
+        }
+
+        if(adv_entries[i].output_iface_num == BATMAN_IRT_REMOVED) {
+            adv_removed--;
+        }
+    }
+    else {
+        if(entry->output_iface_num == BATMAN_IRT_REMOVED) {
+            // never advertised
+            return;
+        }
+
+        if(adv_count == adv_size && _adv_grow() == false) {
+            dessert_crit("could not allocate memory, " MAC " not advertised", EXPLODE_ARRAY6(entry->source_addr));
+            return;
+        }
+
+        i = -i - 1;
+        memmove(&adv_entries[i + 1], &adv_entries[i], (adv_count - i) * sizeof(struct batman_ogm_invrt));
+        memmove(&adv_changed[i + 1], &adv_changed[i], adv_count - i);
+        adv_changed[i] = false;
+        adv_count++;
+    }
+
+    if(entry->output_iface_num == BATMAN_IRT_REMOVED) {
+        adv_removed++;
+    }
+
+    memcpy(&adv_entries[i], entry, sizeof(struct batman_ogm_invrt));
+
+    if(adv_changed[i] == false) {
+        adv_changed[i] = true;
+        memcpy(adv_changes[adv_change_count++], entry->source_addr, ETH_ALEN);
+    }
+}
+
+static void _adv_remove(const uint8_t addr[ETH_ALEN]) {
+    struct batman_ogm_invrt entry;
+    memcpy(entry.source_addr, addr, ETH_ALEN);
+    entry.output_iface_num = BATMAN_IRT_REMOVED;
+    memset(entry.next_hop, 0, ETH_ALEN);
+    _adv_set(&entry);
+}
+
+static void _adv_update(const batman_irt_entry_t* rt_entry) {
+    if(rt_entry->best_output_iface == NULL || rt_entry->best_output_iface->nht->best_next_hop == NULL) {
+        _adv_remove(rt_entry->ether_source_addr);
+        return;
+    }
+
+    struct batman_ogm_invrt entry;
+    memcpy(entry.source_addr, rt_entry->ether_source_addr, ETH_ALEN);
+    memcpy(entry.next_hop, rt_entry->best_output_iface->nht->best_next_hop->ether_nexthop_addr, ETH_ALEN);
+    entry.output_iface_num = rt_entry->best_output_iface->iface_num;
+    _adv_set(&entry);
+}
+
 /** create output interface entry. */
 int batman_db_rt_if_entry_create(batman_irt_if_entry_t** rt_if_entry_out,
                                  uint8_t iface_num) {
@@ -188,6 +322,7 @@ int batman_db_irt_addroute(uint8_t ether_dest_addr[ETH_ALEN], uint8_t iface_num,
     // add/replace current routing entry in timeslot
     rt_entry->curr_seq_num = seq_num;
     rt_entry->last_aw_time = timestamp;
+    _adv_update(rt_entry);
     timeslot_addobject(irt.ts, timestamp, rt_entry);
     return true;
 }
@@ -209,6 +344,51 @@ int batman_db_irt_getroutesn(uint8_t ether_dest_addr[ETH_ALEN]) {
     return rt_entry->curr_seq_num;
 }
 
+int batman_db_irt_adv_count() {
+    return adv_count - adv_removed;
+}
+
+int batman_db_irt_adv_snapshot(struct batman_ogm_invrt* snapshot, int max_count) {
+    // tombstones are not part of the new snapshot
+    if(adv_removed > 0) {
+        int i;
+        int count = 0;
+
+        for(i = 0; i < adv_count; i++) {
+            if(adv_entries[i].output_iface_num != BATMAN_IRT_REMOVED) {
+                memcpy(&adv_entries[count++], &adv_entries[i], sizeof(struct batman_ogm_invrt));
+            }
+        }
+
+        adv_count = count;
+        adv_removed = 0;
+    }
+
+    memset(adv_changed, false, adv_count);
+    adv_change_count = 0;
+
+    if(max_count > adv_count) {
+        max_count = adv_count;
+    }
+
+    memcpy(snapshot, adv_entries, max_count * sizeof(struct batman_ogm_invrt));
+    return max_count;
+}
+
+int batman_db_irt_adv_delta(struct batman_ogm_invrt* delta, int max_count) {
+    int i;
+
+    if(adv_change_count > max_count) {
+        return -1;
+    }
+
+    for(i = 0; i < adv_change_count; i++) {
+        memcpy(&delta[i], &adv_entries[_adv_find(adv_changes[i])], sizeof(struct batman_ogm_invrt));
+    }
+
+    return adv_change_count;
+}
+
 int batman_db_irt_cleanup() {
     return timeslot_purgeobjects(irt.ts, time(0));
 }
@@ -224,6 +404,7 @@ void pudge_old_destination(time_t lasw_aw_time, void* entry) {
     dessert_debug("--- " MAC " - inv route timeout",
                   rt_entry->ether_source_addr[0], rt_entry->ether_source_addr[1], rt_entry->ether_source_addr[2],
                   rt_entry->ether_source_addr[3], rt_entry->ether_source_addr[4], rt_entry->ether_source_addr[5]);
+    _adv_remove(rt_entry->ether_source_addr);
     HASH_DEL(irt.entrys, rt_entry);
     batman_db_rt_entry_destroy(rt_entry);
 }
@@ -239,6 +420,7 @@ int batman_db_irt_deleteroute(uint8_t ether_dest_addr[ETH_ALEN]) {
     }
 
     if(timeslot_deleteobject(irt.ts, rt_entry) == true) {
+        _adv_remove(rt_entry->ether_source_addr);
         HASH_DEL(irt.entrys, rt_entry);
         batman_db_rt_entry_destroy(rt_entry);
         return true;
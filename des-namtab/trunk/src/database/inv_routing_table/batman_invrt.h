@@ -29,6 +29,18 @@ For further information and questions please use the web site
 #include "batman_irt_nht.h"
 #include <uthash.h>
 
+#define BATMAN_IRT_REMOVED	255		// output_iface_num of entries removed since the snapshot
+
+/**
+ * Advertised form of an inverted routing table entry, as carried
+ * in the inverted routing table extension of OGMs
+ */
+struct batman_ogm_invrt {
+    uint8_t source_addr[ETH_ALEN];
+    uint8_t output_iface_num;
+    uint8_t next_hop[ETH_ALEN];
+} __attribute__((__packed__));
+
 /** Output interface entry.
  * To one entry of routing table belongs one or more if_entrys.
  */
@@ -74,6 +86,23 @@ batman_irt_entry_t* batman_db_irt_getinvrt();
 /** Get last know seq_num of destination */
 int batman_db_irt_getroutesn(uint8_t ether_dest_addr[ETH_ALEN]);
 
+/** Get number of entries with a best next hop, an upper bound for batman_db_irt_adv_snapshot */
+int batman_db_irt_adv_count();
+
+/**
+ * Copy the advertised form of all entries, sorted by source address, into snapshot
+ * and start a new change set.
+ * returns: number of entries copied, at most max_count
+ */
+int batman_db_irt_adv_snapshot(struct batman_ogm_invrt* snapshot, int max_count);
+
+/**
+ * Copy the advertised form of all entries changed since the last snapshot into delta.
+ * Removed entries have output_iface_num BATMAN_IRT_REMOVED.
+ * returns: number of entries copied or -1 if more than max_count
+ */
+int batman_db_irt_adv_delta(struct batman_ogm_invrt* delta, int max_count);
+
 /** Pudge old rows from routing table */
 int batman_db_irt_cleanup();
 
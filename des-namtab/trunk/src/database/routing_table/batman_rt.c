@@ -29,21 +29,117 @@ For further information and questions please use the web site
 #include <utlist.h>
 #include "../inv_routing_table/batman_invrt.h"
 #include "../backup_routing_table/batman_brt.h"
+#include "../failover/batman_failover.h"
+
+struct batman_rt_nh;
 
 typedef struct batman_rt {
     uint8_t				ether_dest_addr[ETH_ALEN]; // key
     const dessert_meshif_t* output_iface;
     uint8_t				ether_next_hop[ETH_ALEN];
+    /** precomputed backup route not using ether_next_hop, backup_iface is NULL if none is known */
+    const dessert_meshif_t* backup_iface;
+    uint8_t				backup_next_hop[ETH_ALEN];
+    /** next hop index entry this route is listed in */
+    struct batman_rt_nh*	nh;
+    struct batman_rt*		nh_prev;
+    struct batman_rt*		nh_next;
     UT_hash_handle			hh;
 } batman_rt_t;
 
+/**
+ * Next hop index: all routes over one next hop and output interface,
+ * so that a lost link touches only the routes using it.
+ */
+typedef struct batman_rt_nh {
+    uint8_t				ether_next_hop[ETH_ALEN];	// key
+    uint8_t				ether_iface[ETH_ALEN];		// key
+    batman_rt_t*			routes;
+    UT_hash_handle			hh;
+} batman_rt_nh_t;
+
 batman_rt_t* rt_entrys = NULL;
+batman_rt_nh_t* rt_nh_entrys = NULL;
 timeslot_t* rt_ts;
 
+static void _nh_unlink(batman_rt_t* entry) {
+    batman_rt_nh_t* nh = entry->nh;
+
+    if(nh == NULL) {
+        return;
+    }
+
+    if(entry->nh_prev != NULL) {
+        entry->nh_prev->nh_next = entry->nh_next;
+    }
+    else {
+        nh->routes = entry->nh_next;
+    }
+
+    if(entry->nh_next != NULL) {
+        entry->nh_next->nh_prev = entry->nh_prev;
+    }
+
+    entry->nh = NULL;
+
+    if(nh->routes == NULL) {
+        HASH_DEL(rt_nh_entrys, nh);
+        free(nh);
+    }
+}
+
+static int _nh_link(batman_rt_t* entry) {
+    batman_rt_nh_t* nh;
+    uint8_t addr_sum[2*ETH_ALEN];
+    memcpy(addr_sum, entry->ether_next_hop, ETH_ALEN);
+    memcpy(addr_sum + ETH_ALEN, entry->output_iface->hwaddr, ETH_ALEN);
+    HASH_FIND(hh, rt_nh_entrys, addr_sum, 2 * ETH_ALEN, nh);
+
+    if(nh == NULL) {
+        nh = malloc(sizeof(batman_rt_nh_t));
+
+        if(nh == NULL) {
+            return false;
+        }
+
+        memcpy(nh->ether_next_hop, entry->ether_next_hop, ETH_ALEN);
+        memcpy(nh->ether_iface, entry->output_iface->hwaddr, ETH_ALEN);
+        nh->routes = NULL;
+        HASH_ADD_KEYPTR(hh, rt_nh_entrys, nh->ether_next_hop, 2 * ETH_ALEN, nh);
+    }
+
+    entry->nh = nh;
+    entry->nh_prev = NULL;
+    entry->nh_next = nh->routes;
+
+    if(nh->routes != NULL) {
+        nh->routes->nh_prev = entry;
+    }
+
+    nh->routes = entry;
+    return true;
+}
+
+static void _destroy_entry(batman_rt_t* entry) {
+    _nh_unlink(entry);
+    HASH_DEL(rt_entrys, entry);
+    free(entry);
+}
+
+static void _delete_entry(batman_rt_t* entry) {
+    timeslot_deleteobject(rt_ts, entry);
+    _destroy_entry(entry);
+}
+
+static void _compute_backup(batman_rt_t* entry) {
+    if(batman_db_brt_getbackup(entry->ether_dest_addr, entry->ether_next_hop, entry->output_iface,
+                               &entry->backup_iface, entry->backup_next_hop) == false) {
+        entry->backup_iface = NULL;
+    }
+}
+
 void batman_db_rt_purgeentry(time_t timestamp, void* entry) {
-    batman_rt_t* rt_entry = entry;
-    HASH_DEL(rt_entrys, rt_entry);
-    free(rt_entry);
+    _destroy_entry(entry);
 }
 
 int batman_db_rt_init() {
@@ -52,6 +148,12 @@ int batman_db_rt_init() {
 
 int batman_db_rt_captureroute(uint8_t dest_addr[ETH_ALEN], const dessert_meshif_t* output_iface, uint8_t next_hop[ETH_ALEN]) {
     batman_rt_t* entry;
+
+    // advertisements may still name a lost link until the originator noticed it
+    if(batman_db_fo_linkdown(next_hop, output_iface) == true) {
+        return false;
+    }
+
     HASH_FIND(hh, rt_entrys, dest_addr, ETH_ALEN, entry);
 
     if(entry == NULL) {
@@ -62,11 +164,24 @@ int batman_db_rt_captureroute(uint8_t dest_addr[ETH_ALEN], const dessert_meshif_
         }
 
         memcpy(entry->ether_dest_addr, dest_addr, ETH_ALEN);
+        entry->nh = NULL;
         HASH_ADD_KEYPTR(hh, rt_entrys, entry->ether_dest_addr, ETH_ALEN, entry);
     }
 
-    entry->output_iface = output_iface;
-    memcpy(entry->ether_next_hop, next_hop, ETH_ALEN);
+    if(entry->nh == NULL || entry->output_iface != output_iface ||
+       memcmp(entry->ether_next_hop, next_hop, ETH_ALEN) != 0) {
+        _nh_unlink(entry);
+        entry->output_iface = output_iface;
+        memcpy(entry->ether_next_hop, next_hop, ETH_ALEN);
+
+        if(_nh_link(entry) == false) {
+            _delete_entry(entry);
+            return false;
+        }
+    }
+
+    // backup qualities change with every OGM, so refresh the backup on every capture
+    _compute_backup(entry);
     timeslot_addobject(rt_ts, time(0), entry);
     return true;
 }
@@ -104,6 +219,53 @@ int batman_db_rt_getroute_arl(uint8_t dest_addr[ETH_ALEN],
                                           precursors_iface_list, precursors_iface_count);
 }
 
+int batman_db_rt_failover(const uint8_t next_hop[ETH_ALEN], const dessert_meshif_t* output_iface,
+                          uint32_t* switched_out, uint32_t* lost_out) {
+    batman_rt_nh_t* nh;
+    uint8_t addr_sum[2*ETH_ALEN];
+    memcpy(addr_sum, next_hop, ETH_ALEN);
+    memcpy(addr_sum + ETH_ALEN, output_iface->hwaddr, ETH_ALEN);
+    HASH_FIND(hh, rt_nh_entrys, addr_sum, 2 * ETH_ALEN, nh);
+
+    if(nh == NULL) {
+        return true;
+    }
+
+    // detach the whole route list, the routes are relinked to their new next hops one by one
+    batman_rt_t* entry = nh->routes;
+    HASH_DEL(rt_nh_entrys, nh);
+    free(nh);
+
+    while(entry != NULL) {
+        batman_rt_t* next = entry->nh_next;
+        entry->nh = NULL;
+
+        // the precomputed backup may use another link that was lost in the meantime
+        if(entry->backup_iface == NULL ||
+           batman_db_fo_linkdown(entry->backup_next_hop, entry->backup_iface) == true) {
+            _compute_backup(entry);
+        }
+
+        if(entry->backup_iface != NULL) {
+            entry->output_iface = entry->backup_iface;
+            memcpy(entry->ether_next_hop, entry->backup_next_hop, ETH_ALEN);
+        }
+
+        if(entry->backup_iface == NULL || _nh_link(entry) == false) {
+            _delete_entry(entry);
+            (*lost_out)++;
+        }
+        else {
+            _compute_backup(entry);
+            (*switched_out)++;
+        }
+
+        entry = next;
+    }
+
+    return true;
+}
+
 int batman_db_rt_cleanup() {
     timeslot_purgeobjects(rt_ts, time(0));
     return true;
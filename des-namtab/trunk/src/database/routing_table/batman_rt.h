@@ -42,6 +42,13 @@ int batman_db_rt_getroute_arl(uint8_t dest_addr[ETH_ALEN],
                               uint8_t precursors_iface_list[OGM_PREC_LIST_SIZE* ETH_ALEN],
                               uint8_t* precursors_iface_count);
 
+/**
+ * Switch all routes over next_hop and output_iface to their backup routes,
+ * routes without backup are deleted.
+ */
+int batman_db_rt_failover(const uint8_t next_hop[ETH_ALEN], const dessert_meshif_t* output_iface,
+                          uint32_t* switched_out, uint32_t* lost_out);
+
 int batman_db_rt_cleanup();
 
 int batman_db_rt_change_pt(time_t pudge_timeout);
@@ -23,6 +23,8 @@ For further information and questions please use the web site
 
 #include "helper.h"
 #include "config.h"
+#include <time.h>
+#include <pthread.h>
 
 int hf_seq_comp_i_j(uint16_t i, uint16_t j) {
     if(i == j) {
@@ -37,3 +39,32 @@ int hf_seq_comp_i_j(uint16_t i, uint16_t j) {
 
     return -1;
 }
+
+static __thread uint32_t rand_state = 0;
+
+uint32_t hf_rand() {
+    // xorshift32, seeded per thread on first use
+    if(rand_state == 0) {
+        rand_state = (uint32_t) time(0) ^ (uint32_t)(uintptr_t) pthread_self() ^ (uint32_t)(uintptr_t) &rand_state;
+
+        if(rand_state == 0) {
+            rand_state = 1;
+        }
+    }
+
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+void hf_shuffle(void** arr, int count) {
+    int i;
+
+    for(i = count - 1; i > 0; i--) {
+        int j = hf_rand() % (i + 1);
+        void* tmp = arr[i];
+        arr[i] = arr[j];
+        arr[j] = tmp;
+    }
+}
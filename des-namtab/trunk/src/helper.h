@@ -30,4 +30,10 @@ For further information and questions please use the web site
 
 int hf_seq_comp_i_j(uint16_t i, uint16_t j);
 
+/** fast pseudo random number, every thread has its own generator state */
+uint32_t hf_rand();
+
+/** shuffle array of pointers in place (Fisher-Yates) */
+void hf_shuffle(void** arr, int count);
+
 #endif
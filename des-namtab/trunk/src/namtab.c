@@ -25,6 +25,7 @@ For further information and questions please use the web site
 #include "pipeline/batman_pipeline.h"
 #include "database/batman_database.h"
 #include "config.h"
+#include "routing_log.h"
 #include <string.h>
 
 #ifndef ANDROID
@@ -34,6 +35,7 @@ For further information and questions please use the web site
 int be_verbose = false;
 int ogm_precursor_mode = USE_PRECURSOR_LIST;
 char* routing_log_file = NULL;
+uint32_t routing_log_max_size = ROUTING_LOG_MAX_SIZE;
 
 int main(int argc, char** argv) {
     FILE* cfg = NULL;
@@ -69,11 +71,14 @@ int main(int argc, char** argv) {
     cli_register_command(dessert_cli, cli_cfg_set, "verbose", batman_cli_beverbose, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "be more verbose");
     cli_register_command(dessert_cli, cli_cfg_set, "ogmprecmode", batman_cli_ogmprecursormode, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "enable OGM precursor mode [0=off,1=on]");
     cli_register_command(dessert_cli, cli_cfg_set, "routinglog", cli_setrouting_log, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "set path to routing log file");
+    cli_register_command(dessert_cli, cli_cfg_set, "routinglogsize", cli_setrouting_log_size, PRIVILEGE_PRIVILEGED, MODE_CONFIG, "set size in KiB at which the routing log is rotated [0=never]");
     struct cli_command* cli_command_print =
         cli_register_command(dessert_cli, NULL, "print", NULL, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "print table");
     cli_register_command(dessert_cli, cli_command_print, "brt", batman_cli_print_brt, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "print backup routing table (classic B.A.T.M.A.N.)");
     cli_register_command(dessert_cli, cli_command_print, "irt", batman_cli_print_irt, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "print inverted routing table");
     cli_register_command(dessert_cli, cli_command_print, "rt", batman_cli_print_rt, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "print routing table");
+    cli_register_command(dessert_cli, cli_command_print, "failover", batman_cli_print_failover, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "print link states and failover counters");
+    cli_register_command(dessert_cli, cli_command_print, "routinglog", cli_showrouting_log, PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "print routing log state");
 
     dessert_meshrxcb_add(dessert_msg_check_cb, 10);
     dessert_meshrxcb_add(dessert_msg_ifaceflags_cb, 20);
@@ -93,10 +98,16 @@ int main(int argc, char** argv) {
     db_cleanup_interval.tv_usec = 0;
     dessert_periodic_add(batman_periodic_cleanup_database, NULL, NULL, &db_cleanup_interval);
 
+    struct timeval link_check_interval;
+    link_check_interval.tv_sec = FAILOVER_CHECK_INTERVAL / 1000;
+    link_check_interval.tv_usec = (FAILOVER_CHECK_INTERVAL % 1000) * 1000;
+    dessert_periodic_add(batman_periodic_check_links, NULL, NULL, &link_check_interval);
+
     cli_file(dessert_cli, cfg, PRIVILEGE_PRIVILEGED, MODE_CONFIG);
 
     dessert_cli_run();
     dessert_run();
 
+    rlog_close();
     return EXIT_SUCCESS;
 }
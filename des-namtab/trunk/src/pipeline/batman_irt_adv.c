@@ -0,0 +1,461 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <uthash.h>
+#include "../database/batman_database.h"
+#include "batman_pipeline.h"
+
+/*
+ * Versioned inverted routing table advertisement
+ *
+ * The advertisement cache of the inverted routing table, already sorted by
+ * source address, is copied into a snapshot. The snapshot is streamed in chunks over as many OGMs as needed;
+ * every chunk covers the address range from the last entry of the chunk
+ * before (exclusive) to its own last entry, so a receiver knows whether an
+ * entry for it exists from the one chunk covering its address.
+ *
+ * Every OGM also carries a delta: all entries changed or removed since the
+ * snapshot was taken, as tracked by the cache. A new snapshot is taken IRT_FULL_INTERVAL OGMs after
+ * the last one was completely streamed, or earlier when the delta grows
+ * beyond IRT_DELTA_MAX_SHARE of the space in an OGM or beyond the size of
+ * the snapshot. Streaming continues at
+ * the address where the previous snapshot stopped, so large tables are
+ * covered evenly even if snapshots are replaced before they were sent
+ * completely.
+ *
+ * Receivers are only interested in the entry advertised for themselves.
+ * They remember it from the covering chunk of the snapshot and apply the
+ * deltas of that snapshot version to it. Deltas of another version are
+ * ignored until the covering chunk of the new snapshot was received.
+ */
+
+#define IRT_DELTA_ENTRIES_PER_EXT ((DESSERT_MAXEXTDATALEN - sizeof(struct batman_ogm_invrt_hdr)) \
+                                   / sizeof(struct batman_ogm_invrt))
+#define IRT_CHUNK_ENTRIES_PER_EXT ((DESSERT_MAXEXTDATALEN - sizeof(struct batman_ogm_invrt_hdr) - ETH_ALEN) \
+                                   / sizeof(struct batman_ogm_invrt))
+
+// ------------------------------------- sender ---------------------------------------------
+// only used by the periodic send_ogm callback, so no lock is needed
+
+/** last snapshot, sorted by source_addr */
+static struct batman_ogm_invrt* snapshot = NULL;
+static uint16_t snapshot_count = 0;
+static uint16_t snapshot_size = 0;
+static uint16_t snapshot_version = 0;
+static int snapshot_valid = false;
+static int version_initialized = false;
+/** index of first snapshot entry of next chunk */
+static uint16_t stream_index = 0;
+/** entries of snapshot streamed so far */
+static uint16_t streamed_count = 0;
+static int stream_complete = false;
+/** last address streamed, new snapshots continue after it */
+static uint8_t stream_addr[ETH_ALEN];
+static uint8_t ogms_since_complete = 0;
+
+/** copy advertisement cache of inverted routing table into snapshot array. batman_db_wlock must be held */
+static void _new_snapshot() {
+    unsigned int count = batman_db_irt_adv_count();
+
+    if(count > UINT16_MAX) {
+        count = UINT16_MAX;
+    }
+
+    if(count > snapshot_size) {
+        struct batman_ogm_invrt* new_snapshot = realloc(snapshot, count * sizeof(struct batman_ogm_invrt));
+
+        if(new_snapshot == NULL) {
+            dessert_crit("could not allocate memory, inverted routing table not advertised");
+            snapshot_valid = false;
+            return;
+        }
+
+        snapshot = new_snapshot;
+        snapshot_size = count;
+    }
+
+    snapshot_count = batman_db_irt_adv_snapshot(snapshot, count);
+
+    if(version_initialized == false) {
+        // receivers must not mistake snapshots of a restarted daemon for known ones
+        snapshot_version = rand();
+        version_initialized = true;
+    }
+
+    snapshot_version++;
+    snapshot_valid = true;
+    streamed_count = 0;
+    stream_complete = false;
+    ogms_since_complete = 0;
+
+    // continue behind the last streamed address
+    for(stream_index = 0; stream_index < snapshot_count; stream_index++) {
+        if(memcmp(snapshot[stream_index].source_addr, stream_addr, ETH_ALEN) > 0) {
+            break;
+        }
+    }
+
+    if(stream_index == snapshot_count) {
+        stream_index = 0;
+    }
+}
+
+/** returns: data behind header of new extension, NULL if it does not fit into msg */
+static void* _add_ext(dessert_msg_t* msg, uint8_t flags, size_t len) {
+    dessert_ext_t* ext;
+
+    if(dessert_msg_addext(msg, &ext, OGM_INVRT_EXT_TYPE, sizeof(struct batman_ogm_invrt_hdr) + len) != DESSERT_OK) {
+        return NULL;
+    }
+
+    struct batman_ogm_invrt_hdr* hdr = (struct batman_ogm_invrt_hdr*) ext->data;
+    hdr->version = snapshot_version;
+    hdr->flags = flags;
+    return ext->data + sizeof(struct batman_ogm_invrt_hdr);
+}
+
+/** add next chunks of snapshot to OGM */
+static void _add_snapshot_chunks(dessert_msg_t* msg, int ext_count) {
+    while(stream_complete == false && ext_count-- > 0) {
+        uint16_t entry_count = snapshot_count - stream_index;
+        uint8_t flags = BATMAN_IRT_FULL;
+
+        if(entry_count > IRT_CHUNK_ENTRIES_PER_EXT) {
+            entry_count = IRT_CHUNK_ENTRIES_PER_EXT;
+        }
+
+        if(stream_index == 0) {
+            flags |= BATMAN_IRT_FIRST;
+        }
+
+        if(stream_index + entry_count == snapshot_count) {
+            flags |= BATMAN_IRT_LAST;
+        }
+
+        uint8_t* lower = _add_ext(msg, flags, ETH_ALEN + entry_count * sizeof(struct batman_ogm_invrt));
+
+        if(lower == NULL) {
+            // OGM is full, the chunk is sent with the next one
+            break;
+        }
+
+        if(stream_index > 0) {
+            memcpy(lower, snapshot[stream_index - 1].source_addr, ETH_ALEN);
+        }
+        else {
+            memset(lower, 0, ETH_ALEN);
+        }
+
+        memcpy(lower + ETH_ALEN, &snapshot[stream_index], entry_count * sizeof(struct batman_ogm_invrt));
+        stream_index += entry_count;
+        streamed_count += entry_count;
+
+        if(flags & BATMAN_IRT_LAST) {
+            memset(stream_addr, 0, ETH_ALEN);
+            stream_index = 0;
+        }
+        else {
+            memcpy(stream_addr, snapshot[stream_index - 1].source_addr, ETH_ALEN);
+        }
+
+        // an empty table is completely sent with one empty chunk
+        stream_complete = (streamed_count >= snapshot_count);
+    }
+}
+
+/** remove the delta extensions added so far */
+static void _remove_delta(dessert_msg_t* msg) {
+    dessert_ext_t* ext;
+
+    while(dessert_msg_getext(msg, &ext, OGM_INVRT_EXT_TYPE, 0) > 0) {
+        dessert_msg_delext(msg, ext);
+    }
+}
+
+void batman_irt_adv_add(dessert_msg_t* msg) {
+    // room left behind the extensions and payload already in msg
+    int max_ext_count = (dessert_maxlen - ntohs(msg->hlen) - ntohs(msg->plen)) / (DESSERT_MAXEXTDATALEN + DESSERT_EXTLEN);
+
+    if(max_ext_count < 1) {
+        return;
+    }
+
+    int max_delta_count = max_ext_count * IRT_DELTA_ENTRIES_PER_EXT * IRT_DELTA_MAX_SHARE / 100;
+
+    if(max_delta_count > snapshot_count) {
+        // a new snapshot of a small table is cheaper than the delta
+        max_delta_count = snapshot_count;
+    }
+
+    struct batman_ogm_invrt delta[max_delta_count + 1];
+    int delta_count = -1;
+
+    // taking a snapshot starts a new change set of the table
+    batman_db_wlock();
+
+    if(snapshot_valid == true) {
+        delta_count = batman_db_irt_adv_delta(delta, max_delta_count);
+    }
+
+    if(stream_complete == true && ++ogms_since_complete >= IRT_FULL_INTERVAL) {
+        if(delta_count == 0) {
+            // nothing changed: stream the same snapshot again, receivers stay in sync
+            streamed_count = 0;
+            stream_complete = false;
+            ogms_since_complete = 0;
+        }
+        else {
+            delta_count = -1;
+        }
+    }
+
+    if(delta_count < 0) {
+        // first OGM, snapshot due or too many changes
+        _new_snapshot();
+        delta_count = 0;
+    }
+
+    batman_db_unlock();
+
+    if(snapshot_valid == false) {
+        return;
+    }
+
+    // the delta, even if empty, tells receivers that their snapshot entry is still valid
+    int index = 0;
+
+    do {
+        uint16_t entry_count = delta_count - index;
+
+        if(entry_count > IRT_DELTA_ENTRIES_PER_EXT) {
+            entry_count = IRT_DELTA_ENTRIES_PER_EXT;
+        }
+
+        void* entries = _add_ext(msg, 0, entry_count * sizeof(struct batman_ogm_invrt));
+
+        if(entries == NULL) {
+            // a cut delta would tell receivers that their entry did not change
+            dessert_warn("inverted routing table delta does not fit into OGM, new snapshot with next OGM");
+            _remove_delta(msg);
+            snapshot_valid = false;
+            return;
+        }
+
+        memcpy(entries, &delta[index], entry_count * sizeof(struct batman_ogm_invrt));
+        index += entry_count;
+        max_ext_count--;
+    }
+    while(index < delta_count);
+
+    _add_snapshot_chunks(msg, max_ext_count);
+}
+
+// ------------------------------------- receiver -------------------------------------------
+
+/** advertisement state of one originator */
+typedef struct irt_adv_state {
+    uint8_t  originator[ETH_ALEN];      // key
+    /** snapshot version the entry belongs to */
+    uint16_t version;
+    int      valid;
+    /** entry for me in the snapshot */
+    int      has_entry;
+    struct batman_ogm_invrt entry;
+    time_t   last_aw_time;
+    UT_hash_handle hh;
+} irt_adv_state_t;
+
+static irt_adv_state_t* adv_states = NULL;
+static pthread_mutex_t adv_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct batman_ogm_invrt* _find_myself(struct batman_ogm_invrt* entries, int count) {
+    int i;
+
+    for(i = 0; i < count; i++) {
+        if(memcmp(entries[i].source_addr, dessert_l25_defsrc, ETH_ALEN) == 0) {
+            return &entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void _capture(uint8_t originator[ETH_ALEN], const struct batman_ogm_invrt* entry) {
+    const dessert_meshif_t* iflist = dessert_meshiflist_get();
+
+    for(; iflist != NULL; iflist = iflist->next) {
+        if(iflist->if_index == entry->output_iface_num) {
+            uint8_t next_hop[ETH_ALEN];
+            memcpy(next_hop, entry->next_hop, ETH_ALEN);
+            batman_db_wlock();
+            batman_db_rt_captureroute(originator, iflist, next_hop);
+            batman_db_unlock();
+            return;
+        }
+    }
+}
+
+/** returns: true if the chunk covers my address */
+static int _chunk_covers_me(uint8_t flags, const uint8_t lower[ETH_ALEN],
+                            struct batman_ogm_invrt* entries, int count) {
+    if(!(flags & BATMAN_IRT_FIRST) && memcmp(dessert_l25_defsrc, lower, ETH_ALEN) <= 0) {
+        return false;
+    }
+
+    if(!(flags & BATMAN_IRT_LAST)
+       && (count == 0 || memcmp(dessert_l25_defsrc, entries[count - 1].source_addr, ETH_ALEN) > 0)) {
+        return false;
+    }
+
+    return true;
+}
+
+void batman_irt_adv_process(dessert_msg_t* msg, uint8_t originator[ETH_ALEN]) {
+    dessert_ext_t* ext;
+    irt_adv_state_t* state;
+    struct batman_ogm_invrt captured;
+    struct batman_ogm_invrt delta_entry;
+    int capture = false;
+    int delta_seen = false;
+    int delta_has_myself = false;
+    int ext_num = 0;
+
+    if(dessert_msg_getext(msg, &ext, OGM_INVRT_EXT_TYPE, 0) == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&adv_lock);
+    HASH_FIND(hh, adv_states, originator, ETH_ALEN, state);
+
+    if(state == NULL) {
+        state = malloc(sizeof(irt_adv_state_t));
+
+        if(state == NULL) {
+            pthread_mutex_unlock(&adv_lock);
+            return;
+        }
+
+        memset(state, 0, sizeof(irt_adv_state_t));
+        memcpy(state->originator, originator, ETH_ALEN);
+        HASH_ADD_KEYPTR(hh, adv_states, state->originator, ETH_ALEN, state);
+    }
+
+    state->last_aw_time = time(0);
+
+    // first the snapshot chunks, as the delta of the same OGM applies to them
+    while(dessert_msg_getext(msg, &ext, OGM_INVRT_EXT_TYPE, ext_num++) > 0) {
+        int len = ext->len - DESSERT_EXTLEN - (int) sizeof(struct batman_ogm_invrt_hdr);
+
+        if(len < 0) {
+            dessert_debug("inverted routing table extension of " MAC " too short for its header", EXPLODE_ARRAY6(originator));
+            continue;
+        }
+
+        struct batman_ogm_invrt_hdr* hdr = (struct batman_ogm_invrt_hdr*) ext->data;
+        uint8_t* data = ext->data + sizeof(struct batman_ogm_invrt_hdr);
+
+        if((hdr->flags & BATMAN_IRT_FULL) && len >= ETH_ALEN) {
+            struct batman_ogm_invrt* entries = (struct batman_ogm_invrt*)(data + ETH_ALEN);
+            int count = (len - ETH_ALEN) / sizeof(struct batman_ogm_invrt);
+
+            if(_chunk_covers_me(hdr->flags, data, entries, count) == false) {
+                continue;
+            }
+
+            struct batman_ogm_invrt* mine = _find_myself(entries, count);
+            state->version = hdr->version;
+            state->valid = true;
+            state->has_entry = (mine != NULL);
+
+            if(mine != NULL) {
+                memcpy(&state->entry, mine, sizeof(struct batman_ogm_invrt));
+            }
+        }
+    }
+
+    ext_num = 0;
+
+    while(dessert_msg_getext(msg, &ext, OGM_INVRT_EXT_TYPE, ext_num++) > 0) {
+        int len = ext->len - DESSERT_EXTLEN - (int) sizeof(struct batman_ogm_invrt_hdr);
+
+        if(len < 0) {
+            // already reported above
+            continue;
+        }
+
+        struct batman_ogm_invrt_hdr* hdr = (struct batman_ogm_invrt_hdr*) ext->data;
+        uint8_t* data = ext->data + sizeof(struct batman_ogm_invrt_hdr);
+
+        // delta against snapshot hdr->version
+        if((hdr->flags & BATMAN_IRT_FULL)
+           || state->valid == false || hdr->version != state->version) {
+            continue;
+        }
+
+        delta_seen = true;
+        struct batman_ogm_invrt* mine = _find_myself((struct batman_ogm_invrt*) data, len / sizeof(struct batman_ogm_invrt));
+
+        if(mine != NULL) {
+            delta_has_myself = true;
+            memcpy(&delta_entry, mine, sizeof(struct batman_ogm_invrt));
+        }
+    }
+
+    if(delta_seen == true) {
+        if(delta_has_myself == true) {
+            if(delta_entry.output_iface_num != BATMAN_IRT_REMOVED) {
+                memcpy(&captured, &delta_entry, sizeof(struct batman_ogm_invrt));
+                capture = true;
+            }
+        }
+        else if(state->has_entry == true) {
+            // my entry did not change since the snapshot
+            memcpy(&captured, &state->entry, sizeof(struct batman_ogm_invrt));
+            capture = true;
+        }
+    }
+
+    pthread_mutex_unlock(&adv_lock);
+
+    if(capture == true) {
+        _capture(originator, &captured);
+    }
+}
+
+void batman_irt_adv_cleanup(time_t timeout) {
+    irt_adv_state_t* state, *tmp;
+    time_t now = time(0);
+
+    pthread_mutex_lock(&adv_lock);
+    HASH_ITER(hh, adv_states, state, tmp) {
+        if(now - state->last_aw_time > timeout) {
+            HASH_DEL(adv_states, state);
+            free(state);
+        }
+    }
+    pthread_mutex_unlock(&adv_lock);
+}
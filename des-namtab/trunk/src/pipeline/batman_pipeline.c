@@ -27,6 +27,7 @@ For further information and questions please use the web site
 #include "../helper.h"
 #include "../database/batman_database.h"
 #include "../database/rl_seq_t/rl_seq.h"
+#include "../routing_log.h"
 #include <pthread.h>
 #include <netinet/in.h>
 
@@ -73,36 +74,8 @@ void _add_myself_to_precursors(struct batman_msg_ogm* ogm_ext) {
     }
 }
 
-pthread_rwlock_t rlflock = PTHREAD_RWLOCK_INITIALIZER;
 pthread_rwlock_t rlseqlock = PTHREAD_RWLOCK_INITIALIZER;
 
-void _rlfile_log(const uint8_t src_addr[ETH_ALEN], const uint8_t dest_addr[ETH_ALEN],
-                 const uint32_t seq_num, const uint8_t hop_count, const uint8_t in_iface[ETH_ALEN],
-                 const uint8_t out_iface[ETH_ALEN], const uint8_t next_hop_addr[ETH_ALEN]) {
-    pthread_rwlock_wrlock(&rlflock);
-    FILE* f = fopen(routing_log_file, "a+");
-
-    if(f == NULL) {
-        dessert_debug("file = 0");
-    }
-
-    if(out_iface == NULL) {
-        fprintf(f,  MAC "\t" MAC "\t%u\t%u\t" MAC "\t%s\t%s\n",
-                EXPLODE_ARRAY6(src_addr), EXPLODE_ARRAY6(dest_addr), seq_num, hop_count, EXPLODE_ARRAY6(in_iface), "NULL", "NULL");
-    }
-    else if(in_iface == NULL) {
-        fprintf(f,  MAC "\t" MAC "\t%u\t%u\t%s\t" MAC "\t" MAC "\n",
-                EXPLODE_ARRAY6(src_addr), EXPLODE_ARRAY6(dest_addr), seq_num, hop_count, "NULL", EXPLODE_ARRAY6(out_iface), EXPLODE_ARRAY6(next_hop_addr));
-    }
-    else {
-        fprintf(f,  MAC "\t" MAC "\t%u\t%u\t" MAC "\t" MAC "\t" MAC "\n",
-                EXPLODE_ARRAY6(src_addr), EXPLODE_ARRAY6(dest_addr), seq_num, hop_count, EXPLODE_ARRAY6(in_iface), EXPLODE_ARRAY6(out_iface), EXPLODE_ARRAY6(next_hop_addr));
-    }
-
-    fclose(f);
-    pthread_rwlock_unlock(&rlflock);
-}
-
 int batman_drop_errors(dessert_msg_t* msg, size_t len,
                        dessert_msg_proc_t* proc, const dessert_meshif_t* iface, dessert_frameid_t id) {
     // drop packets sent by myself.
@@ -157,8 +130,12 @@ int batman_handle_ogm(dessert_msg_t* msg, size_t len,
             ogm->flags = ogm->flags & ~BATMAN_OGM_DFLAG;
         }
 
+        struct timeval now;
+        gettimeofday(&now, NULL);
         batman_db_wlock();
         int bd = batman_db_nt_check2Dneigh(msg->l2h.ether_shost, iface);
+        // every OGM frame of the neighbor proves the link to it
+        batman_db_fo_heard(msg->l2h.ether_shost, iface, &now);
         batman_db_unlock();
 
         batman_db_wlock();
@@ -176,39 +153,8 @@ int batman_handle_ogm(dessert_msg_t* msg, size_t len,
 
         batman_db_unlock();
 
-        // search for rt entry addressed to me and capture if found
-        dessert_ext_t* invrt_ext;
-        int irt_ext_num = 0;
-
-        while(dessert_msg_getext(msg, &invrt_ext, OGM_INVRT_EXT_TYPE, irt_ext_num++) > 0) {
-            void* pointer = invrt_ext->data;
-            int entry_count = (invrt_ext->len - DESSERT_EXTLEN) / sizeof(struct batman_ogm_invrt);
-
-            while(entry_count-- > 0) {
-                struct batman_ogm_invrt* invrt_data = pointer;
-                pointer += sizeof(struct batman_ogm_invrt);
-
-                if(memcmp(invrt_data->source_addr, dessert_l25_defsrc, ETH_ALEN) == 0) {
-                    const dessert_meshif_t* iflist = dessert_meshiflist_get();
-                    const dessert_meshif_t* myiface = NULL;
-
-                    while(iflist != NULL) {
-                        if(iflist->if_index == invrt_data->output_iface_num) {
-                            myiface = iflist;
-                            break;
-                        }
-
-                        iflist = iflist->next;
-                    }
-
-                    if(myiface != NULL) {
-                        batman_db_wlock();
-                        batman_db_rt_captureroute(l25h->ether_shost, myiface, invrt_data->next_hop);
-                        batman_db_unlock();
-                    }
-                }
-            }
-        }
+        // capture route towards originator if it advertises an entry for me
+        batman_irt_adv_process(msg, l25h->ether_shost);
 
         // capture all OGM not processed by me.
         // We assume that the OGM with known sequence number but
@@ -319,7 +265,7 @@ int batman_fwd2dest(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc, co
 
         if(result == true) {
             if(routing_log_file != NULL) {
-                _rlfile_log(l25h->ether_shost, l25h->ether_dhost, rl_seq_num, rl_hop_count, iface->hwaddr, output_iface->hwaddr, ether_best_next_hop);
+                rlog_packet(l25h->ether_shost, l25h->ether_dhost, rl_seq_num, rl_hop_count, iface->hwaddr, output_iface->hwaddr, ether_best_next_hop);
             }
 
             memcpy(msg->l2h.ether_dhost, ether_best_next_hop, ETH_ALEN);
@@ -373,7 +319,7 @@ int batman_sys2rp(dessert_msg_t* msg, size_t len, dessert_msg_proc_t* proc,
             rl_data->seq_num = seq_num;
 
             if(routing_log_file != NULL) {
-                _rlfile_log(dessert_l25_defsrc, l25h->ether_dhost, seq_num, 0, NULL, output_iface->hwaddr, ether_best_next_hop);
+                rlog_packet(dessert_l25_defsrc, l25h->ether_dhost, seq_num, 0, NULL, output_iface->hwaddr, ether_best_next_hop);
             }
 
             memcpy(msg->l2h.ether_dhost, ether_best_next_hop, ETH_ALEN);
@@ -410,7 +356,7 @@ int rp2sys(dessert_msg_t* msg, size_t len,
         }
 
         if(routing_log_file != NULL && !(proc->lflags & DESSERT_RX_FLAG_L25_BROADCAST) && !(proc->lflags & DESSERT_RX_FLAG_L25_MULTICAST)) {
-            _rlfile_log(l25h->ether_shost, l25h->ether_dhost, rl_seq_num, rl_hop_count, iface->hwaddr, NULL, NULL);
+            rlog_packet(l25h->ether_shost, l25h->ether_dhost, rl_seq_num, rl_hop_count, iface->hwaddr, NULL, NULL);
         }
 
         dessert_syssend_msg(msg);
@@ -23,6 +23,7 @@ For further information and questions please use the web site
 
 #include <dessert.h>
 #include "../config.h"
+#include "../database/inv_routing_table/batman_invrt.h"
 
 #ifdef ANDROID
 #include <linux/if_ether.h>
@@ -63,11 +64,21 @@ struct batman_msg_ogm {
     uint8_t precursors_count;
 }  __attribute__((__packed__));
 
-/** Inverted routing table */
-struct batman_ogm_invrt {
-    uint8_t source_addr[ETH_ALEN];
-    uint8_t output_iface_num;
-    uint8_t next_hop[ETH_ALEN];
+#define BATMAN_IRT_FULL		0x01	// entries are a chunk of a snapshot, not a delta
+#define BATMAN_IRT_FIRST	0x02	// chunk starts at the lowest address
+#define BATMAN_IRT_LAST		0x04	// chunk ends at the highest address
+
+/**
+ * Inverted routing table extension header.
+ * A delta is followed by batman_ogm_invrt entries. A snapshot chunk is
+ * followed by the (exclusive) lower bound of the addresses it covers and
+ * batman_ogm_invrt entries sorted by source_addr.
+ */
+struct batman_ogm_invrt_hdr {
+    /** snapshot version. Deltas refer to this snapshot */
+    uint16_t version;
+    /** BATMAN_IRT_* flags, 0 for a delta */
+    uint8_t flags;
 } __attribute__((__packed__));
 
 struct batman_msg_brc {
@@ -114,6 +125,17 @@ int batman_fwd2dest(dessert_msg_t* msg, size_t len,
 int batman_handle_ogm(dessert_msg_t* msg, size_t len,
                       dessert_msg_proc_t* proc, const dessert_meshif_t* iface, dessert_frameid_t id);
 
+// ------------------------------ inverted routing table advertisement -----------------------
+
+/** add snapshot chunks or delta of inverted routing table to own OGM */
+void batman_irt_adv_add(dessert_msg_t* msg);
+
+/** capture route towards originator if its OGM advertises an entry for me */
+void batman_irt_adv_process(dessert_msg_t* msg, uint8_t originator[ETH_ALEN]);
+
+/** forget advertisement state of originators not heard for timeout seconds */
+void batman_irt_adv_cleanup(time_t timeout);
+
 // ------------------------------ periodic ----------------------------------------------------
 
 /** periodic send OGM message */
@@ -125,6 +147,9 @@ int batman_periodic_log_rt(void* data, struct timeval* scheduled, struct timeval
 /** clean up database from old entrys */
 int batman_periodic_cleanup_database(void* data, struct timeval* scheduled, struct timeval* interval);
 
+/** declare links lost that missed too many OGMs and fail over their routes */
+int batman_periodic_check_links(void* data, struct timeval* scheduled, struct timeval* interval);
+
 /**
  *  Register send_ogm callback to periodic pipelien and set/change
  * 	ist interval betwen to OGMs to omg_int
@@ -0,0 +1,340 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/time.h>
+#include "routing_log.h"
+
+#define RLOG_RING_MASK (RLOG_RING_SIZE - 1)
+
+typedef struct rlog_ring {
+    rlog_record_t     records[RLOG_RING_SIZE];
+    /** next record to write, only changed by the owning thread */
+    uint32_t          head;
+    /** next record to read, only changed by the writer thread */
+    uint32_t          tail;
+    struct rlog_ring* next;
+} rlog_ring_t;
+
+static rlog_ring_t* rings = NULL;           // all rings ever created, only prepended
+static __thread rlog_ring_t* my_ring = NULL;
+
+static pthread_mutex_t rlog_lock = PTHREAD_MUTEX_INITIALIZER;   // open/close/rotate only
+static pthread_t writer;
+static int writer_running = false;
+static int writer_stop = false;
+static FILE* log_file = NULL;
+static char* log_path = NULL;
+static char* io_buffer = NULL;
+static uint64_t file_size = 0;
+static uint64_t max_file_size = 0;
+static uint64_t dropped = 0;
+static uint64_t written = 0;
+
+static uint64_t _now_us() {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (uint64_t) now.tv_sec * 1000000 + now.tv_usec;
+}
+
+static rlog_ring_t* _get_ring() {
+    if(my_ring == NULL) {
+        rlog_ring_t* ring = malloc(sizeof(rlog_ring_t));
+
+        if(ring == NULL) {
+            return NULL;
+        }
+
+        ring->head = 0;
+        ring->tail = 0;
+        ring->next = __atomic_load_n(&rings, __ATOMIC_RELAXED);
+
+        while(!__atomic_compare_exchange_n(&rings, &ring->next, ring, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+        my_ring = ring;
+    }
+
+    return my_ring;
+}
+
+static int _enqueue(const rlog_record_t* rec) {
+    rlog_ring_t* ring = _get_ring();
+
+    if(ring == NULL) {
+        __atomic_add_fetch(&dropped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    uint32_t head = ring->head;
+
+    if(head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= RLOG_RING_SIZE) {
+        __atomic_add_fetch(&dropped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    memcpy(&ring->records[head & RLOG_RING_MASK], rec, sizeof(rlog_record_t));
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// ---------------------------- file handling (rlog_lock held) ------------------------------
+
+static int _open_file() {
+    struct rlog_file_header header;
+
+    log_file = fopen(log_path, "a");
+
+    if(log_file == NULL) {
+        return false;
+    }
+
+    setvbuf(log_file, io_buffer, _IOFBF, RLOG_IO_BUFFER_SIZE);
+    fseek(log_file, 0, SEEK_END);
+    file_size = ftell(log_file);
+
+    if(file_size == 0) {
+        memcpy(header.magic, RLOG_MAGIC, sizeof(header.magic));
+        header.version = RLOG_FORMAT_VERSION;
+        header.record_size = sizeof(rlog_record_t);
+        fwrite(&header, sizeof(header), 1, log_file);
+        file_size = sizeof(header);
+    }
+
+    return true;
+}
+
+static void _rotate() {
+    size_t len = strlen(log_path) + 3;
+    char old_path[len];
+
+    fclose(log_file);
+    snprintf(old_path, len, "%s.1", log_path);
+    rename(log_path, old_path);
+
+    if(_open_file() == false) {
+        // keep draining the rings, but records are lost until the next rlog_open
+        log_file = NULL;
+    }
+}
+
+/** write all records queued in ring, they are lost without log file. returns: number of records taken */
+static uint32_t _drain(rlog_ring_t* ring) {
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t count = head - tail;
+
+    while(tail != head) {
+        // write up to the end of the ring in one call
+        uint32_t start = tail & RLOG_RING_MASK;
+        uint32_t chunk = head - tail;
+
+        if(start + chunk > RLOG_RING_SIZE) {
+            chunk = RLOG_RING_SIZE - start;
+        }
+
+        if(log_file != NULL) {
+            fwrite(&ring->records[start], sizeof(rlog_record_t), chunk, log_file);
+            file_size += chunk * sizeof(rlog_record_t);
+        }
+
+        tail += chunk;
+    }
+
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    return count;
+}
+
+static void* _writer(void* arg) {
+    struct timespec idle = { 0, RLOG_IDLE_SLEEP_MS * 1000000 };
+
+    while(true) {
+        uint32_t count = 0;
+        rlog_ring_t* ring;
+
+        pthread_mutex_lock(&rlog_lock);
+
+        for(ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+            count += _drain(ring);
+        }
+
+        if(log_file != NULL) {
+            written += count;
+        }
+        else {
+            // a failed rotate closed the log
+            __atomic_add_fetch(&dropped, count, __ATOMIC_RELAXED);
+        }
+
+        if(log_file != NULL && max_file_size > 0 && file_size >= max_file_size) {
+            _rotate();
+        }
+
+        int stop = writer_stop;
+
+        if(count == 0 && log_file != NULL) {
+            fflush(log_file);
+        }
+
+        pthread_mutex_unlock(&rlog_lock);
+
+        if(stop && count == 0) {
+            break;
+        }
+
+        if(count == 0) {
+            nanosleep(&idle, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+// ------------------------------------ interface -------------------------------------------
+
+int rlog_open(const char* path, uint64_t max_size) {
+    rlog_record_t rec;
+
+    pthread_mutex_lock(&rlog_lock);
+
+    if(log_file != NULL) {
+        fclose(log_file);
+        log_file = NULL;
+    }
+
+    free(log_path);
+    log_path = strdup(path);
+
+    if(io_buffer == NULL) {
+        io_buffer = malloc(RLOG_IO_BUFFER_SIZE);
+    }
+
+    max_file_size = max_size;
+
+    if(log_path == NULL || io_buffer == NULL || _open_file() == false) {
+        pthread_mutex_unlock(&rlog_lock);
+        return false;
+    }
+
+    if(writer_running == false) {
+        writer_stop = false;
+
+        if(pthread_create(&writer, NULL, _writer, NULL) != 0) {
+            fclose(log_file);
+            log_file = NULL;
+            pthread_mutex_unlock(&rlog_lock);
+            return false;
+        }
+
+        writer_running = true;
+    }
+
+    pthread_mutex_unlock(&rlog_lock);
+
+    memset(&rec, 0, sizeof(rec));
+    rec.type = RLOG_REC_START;
+    rec.timestamp = _now_us();
+    _enqueue(&rec);
+    return true;
+}
+
+void rlog_close(void) {
+    pthread_mutex_lock(&rlog_lock);
+
+    if(writer_running == false) {
+        pthread_mutex_unlock(&rlog_lock);
+        return;
+    }
+
+    writer_stop = true;
+    pthread_mutex_unlock(&rlog_lock);
+
+    pthread_join(writer, NULL);
+
+    pthread_mutex_lock(&rlog_lock);
+    writer_running = false;
+
+    if(log_file != NULL) {
+        fclose(log_file);
+        log_file = NULL;
+    }
+
+    pthread_mutex_unlock(&rlog_lock);
+}
+
+void rlog_set_max_size(uint64_t max_size) {
+    pthread_mutex_lock(&rlog_lock);
+    max_file_size = max_size;
+    pthread_mutex_unlock(&rlog_lock);
+}
+
+int rlog_packet(const uint8_t src[ETH_ALEN], const uint8_t dest[ETH_ALEN],
+                 uint32_t seq_num, uint8_t hop_count, const uint8_t in_iface[ETH_ALEN],
+                 const uint8_t out_iface[ETH_ALEN], const uint8_t next_hop[ETH_ALEN]) {
+    rlog_record_t rec;
+
+    rec.timestamp = _now_us();
+    rec.seq_num = seq_num;
+    rec.type = RLOG_REC_PACKET;
+    rec.flags = 0;
+    rec.hop_count = hop_count;
+    rec.reserved = 0;
+    memcpy(rec.src, src, ETH_ALEN);
+    memcpy(rec.dest, dest, ETH_ALEN);
+
+    if(in_iface != NULL) {
+        rec.flags |= RLOG_HAS_IN_IFACE;
+        memcpy(rec.in_iface, in_iface, ETH_ALEN);
+    }
+    else {
+        memset(rec.in_iface, 0, ETH_ALEN);
+    }
+
+    if(out_iface != NULL) {
+        rec.flags |= RLOG_HAS_OUT_IFACE;
+        memcpy(rec.out_iface, out_iface, ETH_ALEN);
+        memcpy(rec.next_hop, next_hop, ETH_ALEN);
+    }
+    else {
+        memset(rec.out_iface, 0, ETH_ALEN);
+        memset(rec.next_hop, 0, ETH_ALEN);
+    }
+
+    memset(rec.pad, 0, sizeof(rec.pad));
+    return _enqueue(&rec);
+}
+
+uint64_t rlog_dropped(void) {
+    return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
+
+uint64_t rlog_written(void) {
+    uint64_t count;
+    pthread_mutex_lock(&rlog_lock);
+    count = written;
+    pthread_mutex_unlock(&rlog_lock);
+    return count;
+}
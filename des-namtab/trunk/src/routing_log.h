@@ -0,0 +1,109 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+#ifndef ROUTING_LOG
+#define ROUTING_LOG
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <linux/if_ether.h>
+
+/*
+ * Binary routing log
+ *
+ * Every thread logging packets gets its own ring buffer of fixed-size
+ * records. A thread only writes to its own ring and a background writer
+ * thread drains all rings into the log file with buffered I/O, so logging
+ * a packet takes no lock and does no I/O. If a ring is full the record is
+ * dropped and counted, as are records drained while no file is open after
+ * a failed rotation. When rlog_max_size is set, the file is renamed to
+ * <path>.1 after it grew beyond that size and a new file is started.
+ *
+ * The file starts with a struct rlog_file_header followed by records in
+ * host byte order. tools/rlog_decode converts it to the text format of the
+ * former routing log.
+ */
+
+#define RLOG_MAGIC              "RLOG"
+#define RLOG_FORMAT_VERSION     1
+#define RLOG_RING_SIZE          4096        // records per thread, MUST be a power of 2
+#define RLOG_IO_BUFFER_SIZE     (64 * 1024)
+#define RLOG_IDLE_SLEEP_MS      2           // writer sleep when all rings are empty
+
+#define RLOG_REC_START          1           // log (re)opened, only timestamp is valid
+#define RLOG_REC_PACKET         2
+
+#define RLOG_HAS_IN_IFACE       0x01
+#define RLOG_HAS_OUT_IFACE      0x02
+
+struct rlog_file_header {
+    char     magic[4];
+    uint16_t version;
+    uint16_t record_size;
+} __attribute__((__packed__));
+
+typedef struct rlog_record {
+    /** CLOCK_REALTIME in microseconds */
+    uint64_t timestamp;
+    uint32_t seq_num;
+    uint8_t  type;
+    uint8_t  flags;
+    uint8_t  hop_count;
+    uint8_t  reserved;
+    uint8_t  src[ETH_ALEN];
+    uint8_t  dest[ETH_ALEN];
+    uint8_t  in_iface[ETH_ALEN];
+    uint8_t  out_iface[ETH_ALEN];
+    uint8_t  next_hop[ETH_ALEN];
+    uint8_t  pad[2];
+} __attribute__((__packed__)) rlog_record_t;
+
+/**
+ * Open (or switch to) log file at path and start the writer thread.
+ * max_size is the rotation size in bytes, 0 disables rotation.
+ * returns: true on success, false if the file can not be opened
+ */
+int rlog_open(const char* path, uint64_t max_size);
+
+/** Write all queued records, stop the writer thread and close the file. */
+void rlog_close(void);
+
+/** Change rotation size in bytes, 0 disables rotation. */
+void rlog_set_max_size(uint64_t max_size);
+
+/**
+ * Queue one routed packet. in_iface or out_iface (together with next_hop)
+ * may be NULL. Never blocks.
+ * returns: true if queued, false if dropped as the ring of this thread is full
+ */
+int rlog_packet(const uint8_t src[ETH_ALEN], const uint8_t dest[ETH_ALEN],
+                 uint32_t seq_num, uint8_t hop_count, const uint8_t in_iface[ETH_ALEN],
+                 const uint8_t out_iface[ETH_ALEN], const uint8_t next_hop[ETH_ALEN]);
+
+/** returns: number of records dropped since start as rings were full or no file was open */
+uint64_t rlog_dropped(void);
+
+/** returns: number of records written since start */
+uint64_t rlog_written(void);
+
+#endif
@@ -5,15 +5,18 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
 ../src/helper.c \
-../src/namtab.c 
+../src/namtab.c \
+../src/routing_log.c 
 
 OBJS += \
 ./src/helper.o \
-./src/namtab.o 
+./src/namtab.o \
+./src/routing_log.o 
 
 C_DEPS += \
 ./src/helper.d \
-./src/namtab.d 
+./src/namtab.d \
+./src/routing_log.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -0,0 +1,284 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+
+/*
+ * Measure the failover time after a simulated link break.
+ *
+ * Routes to the given number of destinations are captured over the given
+ * number of neighbors, each destination with backup routes over the two
+ * neighbors after its primary one. All neighbors send an OGM every OGM
+ * interval at their own phase and the link check runs every
+ * FAILOVER_CHECK_INTERVAL ms, both on a virtual clock. At a random time
+ * one neighbor falls silent. Prints the time from the break until its
+ * routes were switched to their backups, the time of the switch itself
+ * with the write lock held, and the routes switched per break.
+ *
+ * A forwarding thread looks up the routes over the broken link under the
+ * read lock during every break. Each lookup pass has to see either all of
+ * them over the broken link or none of them. Afterwards every one of them
+ * has to use its backup next hop. Otherwise the run fails. The link is
+ * restored and the routes are captured again before the next break.
+ *
+ * usage: failover_bench [destinations] [neighbors] [breaks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "../src/database/batman_database.h"
+
+int be_verbose = false;
+int ogm_precursor_mode = USE_PRECURSOR_LIST;
+char* routing_log_file = NULL;
+uint32_t routing_log_max_size = ROUTING_LOG_MAX_SIZE;
+
+#define OGM_INT_MS (ORIG_INTERVAL * 1000)
+
+static dessert_meshif_t iface = {.if_name = "mesh0", .hwaddr = {0x02, 0xff, 0x00, 0x00, 0x00, 0x00}};
+static struct timeval start_time;
+
+/** routes over the broken link, looked up by the forwarding thread */
+static int* affected;
+static int affected_count;
+static uint8_t broken[ETH_ALEN];
+static volatile int forwarding;
+static long passes;
+static long mixed_passes;
+
+static void dest_addr(uint8_t addr[ETH_ALEN], int i) {
+    uint8_t a[ETH_ALEN] = {0x02, 0x00, 0x00, (i >> 16) & 0xff, (i >> 8) & 0xff, i & 0xff};
+    memcpy(addr, a, ETH_ALEN);
+}
+
+static void neighbor_addr(uint8_t addr[ETH_ALEN], int n) {
+    uint8_t a[ETH_ALEN] = {0x02, 0x01, 0x00, 0x00, (n >> 8) & 0xff, n & 0xff};
+    memcpy(addr, a, ETH_ALEN);
+}
+
+/** time on the virtual clock, ms after start */
+static struct timeval virtual_time(long ms) {
+    struct timeval tv = start_time;
+    tv.tv_sec += ms / 1000;
+    tv.tv_usec += (ms % 1000) * 1000;
+
+    if(tv.tv_usec >= 1000000) {
+        tv.tv_sec++;
+        tv.tv_usec -= 1000000;
+    }
+
+    return tv;
+}
+
+static double now_usec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void heard(int n, long ms) {
+    uint8_t neighbor[ETH_ALEN];
+    struct timeval tv = virtual_time(ms);
+    neighbor_addr(neighbor, n);
+    batman_db_wlock();
+    batman_db_fo_heard(neighbor, &iface, &tv);
+    batman_db_unlock();
+}
+
+static void* forward(void* arg) {
+    while(forwarding) {
+        int via_broken = 0;
+        int i;
+
+        batman_db_rlock();
+
+        for(i = 0; i < affected_count; i++) {
+            uint8_t dest[ETH_ALEN];
+            uint8_t next_hop[ETH_ALEN];
+            const dessert_meshif_t* out_iface;
+            dest_addr(dest, affected[i]);
+
+            if(batman_db_rt_getroute(dest, &out_iface, next_hop) == true &&
+               memcmp(next_hop, broken, ETH_ALEN) == 0) {
+                via_broken++;
+            }
+        }
+
+        batman_db_unlock();
+
+        if(via_broken != 0 && via_broken != affected_count) {
+            mixed_passes++;
+        }
+
+        passes++;
+    }
+
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    int destinations = (argc > 1) ? atoi(argv[1]) : 1000;
+    int neighbors = (argc > 2) ? atoi(argv[2]) : 10;
+    int breaks = (argc > 3) ? atoi(argv[3]) : 20;
+    long* next_ogm = malloc(neighbors * sizeof(long));
+    double detect_sum = 0, detect_max = 0;
+    double switch_sum = 0, switch_max = 0;
+    long switched = 0;
+    long t = 0;
+    int errors = 0;
+    int b, d, n, s;
+
+    srand(1);
+    gettimeofday(&start_time, NULL);
+    affected = malloc(destinations * sizeof(int));
+    batman_db_init();
+    batman_db_fo_set_ogmint(ORIG_INTERVAL);
+
+    batman_db_wlock();
+
+    for(n = 0; n < neighbors; n++) {
+        struct timeval tv = virtual_time(0);
+        uint8_t neighbor[ETH_ALEN];
+        neighbor_addr(neighbor, n);
+        batman_db_fo_heard(neighbor, &iface, &tv);
+        next_ogm[n] = rand() % OGM_INT_MS;
+    }
+
+    // the first backup is heard as well as the primary next hop, the second one half as often
+    for(d = 0; d < destinations; d++) {
+        uint8_t dest[ETH_ALEN];
+        uint8_t next_hop[ETH_ALEN];
+        dest_addr(dest, d);
+
+        for(s = 1; s <= WINDOW_SIZE; s++) {
+            for(n = 0; n < 3; n++) {
+                if(n < 2 || s % 2 == 0) {
+                    neighbor_addr(next_hop, (d + n) % neighbors);
+                    batman_db_brt_addroute(dest, &iface, time(0), next_hop, s);
+                }
+            }
+        }
+
+        neighbor_addr(next_hop, d % neighbors);
+        batman_db_rt_captureroute(dest, &iface, next_hop);
+    }
+
+    batman_db_unlock();
+
+    for(b = 0; b < breaks; b++) {
+        pthread_t forwarder;
+        int x = rand() % neighbors;
+        long break_time = t + rand() % OGM_INT_MS;
+        double switch_usec = 0;
+        int lost = 0;
+
+        neighbor_addr(broken, x);
+        affected_count = 0;
+
+        for(d = x; d < destinations; d += neighbors) {
+            affected[affected_count++] = d;
+        }
+
+        forwarding = true;
+        pthread_create(&forwarder, NULL, forward, NULL);
+
+        while(lost == 0 && t - break_time < 10 * OGM_INT_MS) {
+            t += FAILOVER_CHECK_INTERVAL;
+
+            for(n = 0; n < neighbors; n++) {
+                for(; next_ogm[n] <= t; next_ogm[n] += OGM_INT_MS) {
+                    if(n != x || next_ogm[n] <= break_time) {
+                        heard(n, next_ogm[n]);
+                    }
+                }
+            }
+
+            // as the periodic link check does
+            struct timeval now = virtual_time(t);
+            batman_db_wlock();
+            double start = now_usec();
+            lost = batman_db_fo_check(&now);
+            switch_usec = now_usec() - start;
+            batman_db_unlock();
+        }
+
+        forwarding = false;
+        pthread_join(forwarder, NULL);
+
+        if(lost != 1) {
+            printf("break %d: %d links lost\n", b, lost);
+            errors++;
+        }
+
+        double detect_ms = t - break_time;
+        detect_sum += detect_ms;
+        detect_max = (detect_ms > detect_max) ? detect_ms : detect_max;
+        switch_sum += switch_usec;
+        switch_max = (switch_usec > switch_max) ? switch_usec : switch_max;
+        switched += affected_count;
+
+        // every route over the broken link has to use its first backup now
+        batman_db_wlock();
+
+        for(d = 0; d < affected_count; d++) {
+            uint8_t dest[ETH_ALEN];
+            uint8_t next_hop[ETH_ALEN];
+            uint8_t backup[ETH_ALEN];
+            const dessert_meshif_t* out_iface;
+            dest_addr(dest, affected[d]);
+            neighbor_addr(backup, (x + 1) % neighbors);
+
+            if(batman_db_rt_getroute(dest, &out_iface, next_hop) == false ||
+               memcmp(next_hop, backup, ETH_ALEN) != 0) {
+                errors++;
+            }
+        }
+
+        batman_db_unlock();
+
+        // restore the link and the routes over it
+        heard(x, t);
+        batman_db_wlock();
+
+        for(d = 0; d < affected_count; d++) {
+            uint8_t dest[ETH_ALEN];
+            dest_addr(dest, affected[d]);
+            batman_db_rt_captureroute(dest, &iface, broken);
+        }
+
+        batman_db_unlock();
+        t += OGM_INT_MS;
+    }
+
+    printf("%d destinations, %d neighbors, %d breaks: failover after %.0f ms avg, %.0f ms max (%d missed OGMs of %d ms), "
+           "switch %.1f usec avg, %.1f usec max for %ld routes, %ld of %ld lookup passes mixed, errors %d\n",
+           destinations, neighbors, breaks, detect_sum / breaks, detect_max, FAILOVER_MISSED_OGMS, OGM_INT_MS,
+           switch_sum / breaks, switch_max, switched / breaks, mixed_passes, passes, errors + (mixed_passes > 0));
+
+    free(affected);
+    free(next_ogm);
+    return (errors || mixed_passes) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
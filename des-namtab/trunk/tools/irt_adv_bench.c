@@ -0,0 +1,193 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+
+/*
+ * Measure the bytes of the inverted routing table advertisement.
+ *
+ * Fills the inverted routing table with the given number of entries and
+ * builds OGMs as the periodic send_ogm callback does. Before every OGM the
+ * given number of random entries changes: half of them get a new next hop,
+ * a quarter is removed and a quarter added again. Counts the bytes of the
+ * advertisement extensions in every OGM, split into snapshot chunks and
+ * deltas, and compares them with the former advertisement, which streamed
+ * a copy of the whole table in as many full extensions as fit into each
+ * OGM and took a new copy after the last entry. Fails if an OGM exceeds
+ * dessert_maxlen.
+ *
+ * usage: irt_adv_bench [entries] [changes per OGM] [OGMs]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../src/database/batman_database.h"
+#include "../src/pipeline/batman_pipeline.h"
+
+int be_verbose = false;
+int ogm_precursor_mode = USE_PRECURSOR_LIST;
+char* routing_log_file = NULL;
+uint32_t routing_log_max_size = ROUTING_LOG_MAX_SIZE;
+
+static uint16_t seq_num = 1;
+
+static void source_addr(uint8_t addr[ETH_ALEN], int i) {
+    uint8_t a[ETH_ALEN] = {0x02, 0x00, 0x00, (i >> 16) & 0xff, (i >> 8) & 0xff, i & 0xff};
+    memcpy(addr, a, ETH_ALEN);
+}
+
+static void set_entry(int i) {
+    uint8_t source[ETH_ALEN];
+    uint8_t next_hop[ETH_ALEN] = {0x02, 0x01, 0x00, 0x00, 0x00, rand() & 0xff};
+
+    // a fresh entry takes the new next hop as best one at once
+    source_addr(source, i);
+    batman_db_wlock();
+    batman_db_irt_deleteroute(source);
+    batman_db_irt_addroute(source, 1 + rand() % 3, time(0), next_hop, seq_num);
+    batman_db_unlock();
+}
+
+static void remove_entry(int i) {
+    uint8_t source[ETH_ALEN];
+    source_addr(source, i);
+    batman_db_wlock();
+    batman_db_irt_deleteroute(source);
+    batman_db_unlock();
+}
+
+/** new OGM with l25 header and OGM extension, as batman_periodic_send_ogm builds it */
+static dessert_msg_t* new_ogm() {
+    dessert_msg_t* msg;
+    dessert_ext_t* ext;
+
+    dessert_msg_new(&msg);
+    dessert_msg_addext(msg, &ext, DESSERT_EXT_ETH, ETHER_HDR_LEN);
+    dessert_msg_addext(msg, &ext, OGM_EXT_TYPE, OGM_EXT_LEN);
+    memset(ext->data, 0, OGM_EXT_LEN);
+    return msg;
+}
+
+/** bytes the former advertisement put into the next OGM, index is the position in its copy of the table */
+static int former_bytes(int table_count, int* index) {
+    int max_ext_count = (dessert_maxlen - sizeof(dessert_msg_t) - sizeof(struct ether_header)
+                         - sizeof(struct batman_msg_ogm)) / DESSERT_MAXEXTDATALEN;
+    int entries_per_ext = DESSERT_MAXEXTDATALEN / sizeof(struct batman_ogm_invrt);
+    int bytes = 0;
+    int ext_count;
+
+    if(*index >= table_count) {
+        // copy of the table completely sent -> new copy
+        *index = 0;
+    }
+
+    for(ext_count = 0; ext_count < max_ext_count && *index < table_count; ext_count++) {
+        int count = (table_count - *index > entries_per_ext) ? entries_per_ext : table_count - *index;
+        bytes += DESSERT_EXTLEN + count * sizeof(struct batman_ogm_invrt);
+        *index += count;
+    }
+
+    return bytes;
+}
+
+int main(int argc, char** argv) {
+    int entries = (argc > 1) ? atoi(argv[1]) : 1000;
+    int changes = (argc > 2) ? atoi(argv[2]) : 1;
+    int ogms = (argc > 3) ? atoi(argv[3]) : 1000;
+    char* present = calloc(entries, 1);
+    long snapshot_bytes = 0;
+    long delta_bytes = 0;
+    long old_bytes = 0;
+    int table_count = entries;
+    int old_index = 0;
+    int snapshots = 0;
+    int last_version = -1;
+    int errors = 0;
+    int i, o;
+
+    srand(1);
+    batman_db_init();
+
+    for(i = 0; i < entries; i++) {
+        set_entry(i);
+        present[i] = true;
+    }
+
+    for(o = 0; o < ogms; o++) {
+        dessert_ext_t* ext;
+        int ext_num = 0;
+
+        seq_num++;
+
+        for(i = 0; i < changes; i++) {
+            int k = rand() % entries;
+            int action = rand() % 4;
+
+            if(action == 0 && present[k]) {
+                remove_entry(k);
+                present[k] = false;
+                table_count--;
+            }
+            else if(action == 1 || present[k]) {
+                set_entry(k);
+                table_count += !present[k];
+                present[k] = true;
+            }
+        }
+
+        old_bytes += former_bytes(table_count, &old_index);
+
+        dessert_msg_t* msg = new_ogm();
+        batman_irt_adv_add(msg);
+
+        while(dessert_msg_getext(msg, &ext, OGM_INVRT_EXT_TYPE, ext_num++) > 0) {
+            struct batman_ogm_invrt_hdr* hdr = (struct batman_ogm_invrt_hdr*) ext->data;
+
+            if(hdr->flags & BATMAN_IRT_FULL) {
+                snapshot_bytes += ext->len;
+            }
+            else {
+                delta_bytes += ext->len;
+            }
+
+            if(hdr->version != last_version) {
+                last_version = hdr->version;
+                snapshots++;
+            }
+        }
+
+        if(ntohs(msg->hlen) + ntohs(msg->plen) > dessert_maxlen) {
+            errors++;
+        }
+
+        dessert_msg_destroy(msg);
+    }
+
+    printf("%d entries, %d changes per OGM: former %ld B/OGM, now %ld B/OGM (%.1f%%): snapshot %ld, delta %ld B/OGM, %d snapshots, errors %d\n",
+           entries, changes, old_bytes / ogms, (snapshot_bytes + delta_bytes) / ogms,
+           100.0 * (snapshot_bytes + delta_bytes) / old_bytes, snapshot_bytes / ogms, delta_bytes / ogms, snapshots, errors);
+
+    free(present);
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,357 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+
+/*
+ * Check the receiver of the inverted routing table advertisement.
+ *
+ * Feeds OGMs with hand-made advertisement extensions of several
+ * originators to batman_irt_adv_process and checks the route captured
+ * towards each originator:
+ *
+ *  - a snapshot in one chunk and an empty delta capture the entry for me
+ *  - a delta of the same version changes it, one of another version is
+ *    ignored
+ *  - without the chunk covering my address nothing is captured, even if
+ *    the other chunks and a delta naming me were received; the covering
+ *    chunk captures the entry in it
+ *  - a covering chunk without an entry for me captures nothing until a
+ *    delta adds one
+ *  - extensions too short for their header or the lower bound of a chunk
+ *    are skipped
+ *
+ * Then a snapshot and deltas built by batman_irt_adv_add from the inverted
+ * routing table of this process are decoded. The entry for me has to be
+ * captured once the snapshot was streamed, and the captured route has to
+ * follow every change of it: with the delta of the next OGM, or within
+ * the OGMs it takes to stream a new snapshot.
+ *
+ * usage: irt_adv_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../src/database/batman_database.h"
+#include "../src/pipeline/batman_pipeline.h"
+
+int be_verbose = false;
+int ogm_precursor_mode = USE_PRECURSOR_LIST;
+char* routing_log_file = NULL;
+uint32_t routing_log_max_size = ROUTING_LOG_MAX_SIZE;
+
+#define IFACE_NUM 1
+#define TABLE_ENTRIES 200
+
+static dessert_meshif_t iface = {.if_name = "mesh0", .if_index = IFACE_NUM,
+                                 .hwaddr = {0x02, 0xff, 0x00, 0x00, 0x00, 0x00}};
+static const uint8_t me[ETH_ALEN] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x50};
+static int errors = 0;
+
+#define CHECK(cond, what) \
+    if(!(cond)) { \
+        printf("FAILED: %s\n", what); \
+        errors++; \
+    }
+
+/** replaces the one of libdessert, captured routes need a mesh interface with IFACE_NUM */
+dessert_meshif_t* dessert_meshiflist_get() {
+    return &iface;
+}
+
+static void addr(uint8_t a[ETH_ALEN], uint8_t prefix, int i) {
+    uint8_t b[ETH_ALEN] = {0x02, prefix, 0x00, 0x00, (i >> 8) & 0xff, i & 0xff};
+    memcpy(a, b, ETH_ALEN);
+}
+
+static void entry(struct batman_ogm_invrt* e, int source, int next_hop) {
+    addr(e->source_addr, 0x00, source);
+    addr(e->next_hop, 0x01, next_hop);
+    e->output_iface_num = IFACE_NUM;
+}
+
+static void entry_removed(struct batman_ogm_invrt* e, int source) {
+    entry(e, source, 0);
+    e->output_iface_num = BATMAN_IRT_REMOVED;
+}
+
+static dessert_msg_t* new_ogm() {
+    dessert_msg_t* msg;
+    dessert_ext_t* ext;
+
+    dessert_msg_new(&msg);
+    dessert_msg_addext(msg, &ext, DESSERT_EXT_ETH, ETHER_HDR_LEN);
+    dessert_msg_addext(msg, &ext, OGM_EXT_TYPE, OGM_EXT_LEN);
+    memset(ext->data, 0, OGM_EXT_LEN);
+    return msg;
+}
+
+static void add_chunk(dessert_msg_t* msg, uint16_t version, uint8_t flags, int lower,
+                      struct batman_ogm_invrt* entries, int count) {
+    dessert_ext_t* ext;
+    size_t len = sizeof(struct batman_ogm_invrt_hdr) + ETH_ALEN + count * sizeof(struct batman_ogm_invrt);
+
+    dessert_msg_addext(msg, &ext, OGM_INVRT_EXT_TYPE, len);
+    struct batman_ogm_invrt_hdr* hdr = (struct batman_ogm_invrt_hdr*) ext->data;
+    hdr->version = version;
+    hdr->flags = BATMAN_IRT_FULL | flags;
+    addr(ext->data + sizeof(struct batman_ogm_invrt_hdr), 0x00, lower);
+    memcpy(ext->data + sizeof(struct batman_ogm_invrt_hdr) + ETH_ALEN, entries, count * sizeof(struct batman_ogm_invrt));
+}
+
+static void add_delta(dessert_msg_t* msg, uint16_t version, struct batman_ogm_invrt* entries, int count) {
+    dessert_ext_t* ext;
+
+    dessert_msg_addext(msg, &ext, OGM_INVRT_EXT_TYPE, sizeof(struct batman_ogm_invrt_hdr) + count * sizeof(struct batman_ogm_invrt));
+    struct batman_ogm_invrt_hdr* hdr = (struct batman_ogm_invrt_hdr*) ext->data;
+    hdr->version = version;
+    hdr->flags = 0;
+
+    if(count > 0) {
+        memcpy(ext->data + sizeof(struct batman_ogm_invrt_hdr), entries, count * sizeof(struct batman_ogm_invrt));
+    }
+}
+
+static void process(dessert_msg_t* msg, uint8_t originator[ETH_ALEN]) {
+    batman_irt_adv_process(msg, originator);
+    dessert_msg_destroy(msg);
+}
+
+/** returns: next hop number of the route to originator, -1 if none was captured */
+static int route(uint8_t originator[ETH_ALEN]) {
+    const dessert_meshif_t* out_iface;
+    uint8_t next_hop[ETH_ALEN];
+    int found;
+
+    batman_db_rlock();
+    found = batman_db_rt_getroute(originator, &out_iface, next_hop);
+    batman_db_unlock();
+
+    if(found == false || out_iface != &iface) {
+        return -1;
+    }
+
+    return (next_hop[4] << 8) | next_hop[5];
+}
+
+static void test_snapshot_and_delta() {
+    uint8_t originator[ETH_ALEN];
+    struct batman_ogm_invrt entries[3];
+    dessert_msg_t* msg;
+
+    addr(originator, 0x10, 1);
+    entry(&entries[0], 0x20, 1);
+    entry(&entries[1], 0x50, 1);
+    entry(&entries[2], 0x70, 2);
+
+    msg = new_ogm();
+    add_chunk(msg, 7, BATMAN_IRT_FIRST | BATMAN_IRT_LAST, 0, entries, 3);
+    add_delta(msg, 7, NULL, 0);
+    process(msg, originator);
+    CHECK(route(originator) == 1, "snapshot in one chunk captures my entry");
+
+    entry(&entries[0], 0x50, 3);
+    msg = new_ogm();
+    add_delta(msg, 7, entries, 1);
+    process(msg, originator);
+    CHECK(route(originator) == 3, "delta of snapshot version changes my entry");
+
+    entry(&entries[0], 0x50, 4);
+    msg = new_ogm();
+    add_delta(msg, 8, entries, 1);
+    process(msg, originator);
+    CHECK(route(originator) == 3, "delta of unknown version is ignored");
+}
+
+static void test_missing_chunk() {
+    uint8_t originator[ETH_ALEN];
+    struct batman_ogm_invrt low[2], mid[2], high[2], delta[1];
+    dessert_msg_t* msg;
+
+    addr(originator, 0x10, 2);
+    entry(&low[0], 0x10, 1);
+    entry(&low[1], 0x30, 1);
+    entry(&mid[0], 0x40, 1);
+    entry(&mid[1], 0x50, 5);
+    entry(&high[0], 0x60, 1);
+    entry(&high[1], 0x70, 1);
+    entry(&delta[0], 0x50, 6);
+
+    // chunks not covering me, my entry only in the delta
+    msg = new_ogm();
+    add_chunk(msg, 3, BATMAN_IRT_FIRST, 0, low, 2);
+    add_delta(msg, 3, NULL, 0);
+    process(msg, originator);
+    CHECK(route(originator) == -1, "chunk below my address captures nothing");
+
+    msg = new_ogm();
+    add_chunk(msg, 3, BATMAN_IRT_LAST, 0x50, high, 2);
+    add_delta(msg, 3, delta, 1);
+    process(msg, originator);
+    CHECK(route(originator) == -1, "chunk with my address as lower bound captures nothing");
+
+    // covering chunk, the delta of the same OGM applies to it
+    msg = new_ogm();
+    add_chunk(msg, 3, 0, 0x30, mid, 2);
+    add_delta(msg, 3, NULL, 0);
+    process(msg, originator);
+    CHECK(route(originator) == 5, "covering chunk captures my entry");
+
+    msg = new_ogm();
+    add_chunk(msg, 3, 0, 0x30, mid, 2);
+    add_delta(msg, 3, delta, 1);
+    process(msg, originator);
+    CHECK(route(originator) == 6, "delta applies to covering chunk of same OGM");
+}
+
+static void test_not_in_snapshot() {
+    uint8_t originator[ETH_ALEN];
+    struct batman_ogm_invrt entries[2], delta[1];
+    dessert_msg_t* msg;
+
+    addr(originator, 0x10, 3);
+    entry(&entries[0], 0x40, 1);
+    entry(&entries[1], 0x60, 1);
+
+    msg = new_ogm();
+    add_chunk(msg, 11, BATMAN_IRT_FIRST | BATMAN_IRT_LAST, 0, entries, 2);
+    add_delta(msg, 11, NULL, 0);
+    process(msg, originator);
+    CHECK(route(originator) == -1, "snapshot without my entry captures nothing");
+
+    entry_removed(&delta[0], 0x50);
+    msg = new_ogm();
+    add_delta(msg, 11, delta, 1);
+    process(msg, originator);
+    CHECK(route(originator) == -1, "removed entry captures nothing");
+
+    entry(&delta[0], 0x50, 7);
+    msg = new_ogm();
+    add_delta(msg, 11, delta, 1);
+    process(msg, originator);
+    CHECK(route(originator) == 7, "delta adding my entry captures it");
+}
+
+static void test_short_ext() {
+    uint8_t originator[ETH_ALEN];
+    struct batman_ogm_invrt entries[1];
+    dessert_msg_t* msg;
+    dessert_ext_t* ext;
+    size_t len;
+
+    addr(originator, 0x10, 4);
+    entry(&entries[0], 0x50, 8);
+
+    msg = new_ogm();
+
+    // header cut off, with and without the flags of a chunk
+    for(len = 0; len < sizeof(struct batman_ogm_invrt_hdr); len++) {
+        dessert_msg_addext(msg, &ext, OGM_INVRT_EXT_TYPE, len);
+        memset(ext->data, BATMAN_IRT_FULL | BATMAN_IRT_FIRST | BATMAN_IRT_LAST, len);
+    }
+
+    // chunk without complete lower bound
+    dessert_msg_addext(msg, &ext, OGM_INVRT_EXT_TYPE, sizeof(struct batman_ogm_invrt_hdr) + ETH_ALEN - 1);
+    memset(ext->data, 0, sizeof(struct batman_ogm_invrt_hdr) + ETH_ALEN - 1);
+    ((struct batman_ogm_invrt_hdr*) ext->data)->flags = BATMAN_IRT_FULL | BATMAN_IRT_FIRST | BATMAN_IRT_LAST;
+
+    add_delta(msg, 0, entries, 1);
+    process(msg, originator);
+    CHECK(route(originator) == -1, "short extensions are no snapshot");
+
+    msg = new_ogm();
+    dessert_msg_addext(msg, &ext, OGM_INVRT_EXT_TYPE, 1);
+    ext->data[0] = 0;
+    add_chunk(msg, 0, BATMAN_IRT_FIRST | BATMAN_IRT_LAST, 0, entries, 1);
+    add_delta(msg, 0, NULL, 0);
+    process(msg, originator);
+    CHECK(route(originator) == 8, "short extension does not hide the snapshot behind it");
+}
+
+static void set_entry(int source, int next_hop, uint16_t seq_num) {
+    uint8_t source_addr[ETH_ALEN];
+    uint8_t next_hop_addr[ETH_ALEN];
+
+    addr(source_addr, 0x00, source);
+    addr(next_hop_addr, 0x01, next_hop);
+    batman_db_wlock();
+    batman_db_irt_deleteroute(source_addr);
+    batman_db_irt_addroute(source_addr, IFACE_NUM, time(0), next_hop_addr, seq_num);
+    batman_db_unlock();
+}
+
+static void test_sender() {
+    uint8_t originator[ETH_ALEN];
+    uint16_t seq_num = 1;
+    int complete = -1;
+    int o, i;
+
+    addr(originator, 0x10, 5);
+
+    // my address in the middle of the table, streamed over several OGMs
+    for(i = 0; i < TABLE_ENTRIES; i++) {
+        set_entry(i, (i == 0x50) ? 9 : 1, seq_num);
+    }
+
+    for(o = 0; o < IRT_FULL_INTERVAL * 4; o++) {
+        dessert_msg_t* msg = new_ogm();
+        batman_irt_adv_add(msg);
+        process(msg, originator);
+
+        if(complete < 0 && route(originator) == 9) {
+            complete = o;
+        }
+    }
+
+    CHECK(complete >= 0, "streamed snapshot captures my entry");
+
+    for(i = 10; i < 20; i++) {
+        set_entry(0x50, i, ++seq_num);
+        // some other changes in the same delta
+        set_entry(0x50 + i, 2, seq_num);
+
+        for(o = 0; o <= complete && route(originator) != i; o++) {
+            dessert_msg_t* msg = new_ogm();
+            batman_irt_adv_add(msg);
+            process(msg, originator);
+        }
+
+        CHECK(route(originator) == i, "captured route follows my entry");
+    }
+}
+
+int main(int argc, char** argv) {
+    memcpy(dessert_l25_defsrc, me, ETH_ALEN);
+    srand(1);
+    batman_db_init();
+
+    test_snapshot_and_delta();
+    test_missing_chunk();
+    test_not_in_snapshot();
+    test_short_ext();
+    test_sender();
+
+    printf("irt_adv_test: %d errors\n", errors);
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+/*
+ * Measure the cost of building OGMs.
+ *
+ * Fills the inverted routing table with the given number of entries and
+ * calls the periodic send_ogm callback, changing the given number of
+ * random entries before every OGM. No mesh interface is registered, so the
+ * OGMs are built completely but not sent. Prints the time per OGM.
+ *
+ * usage: ogm_bench [entries] [changes per OGM] [OGMs]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+#include "../src/database/batman_database.h"
+#include "../src/pipeline/batman_pipeline.h"
+
+int be_verbose = false;
+int ogm_precursor_mode = USE_PRECURSOR_LIST;
+char* routing_log_file = NULL;
+uint32_t routing_log_max_size = ROUTING_LOG_MAX_SIZE;
+
+static uint16_t seq_num = 1;
+
+static void set_entry(int i) {
+    uint8_t source[ETH_ALEN] = {0x02, 0x00, 0x00, (i >> 16) & 0xff, (i >> 8) & 0xff, i & 0xff};
+    uint8_t next_hop[ETH_ALEN] = {0x02, 0x01, 0x00, 0x00, 0x00, rand() & 0xff};
+
+    // a fresh entry takes the new next hop as best one at once
+    batman_db_wlock();
+    batman_db_irt_deleteroute(source);
+    batman_db_irt_addroute(source, 1 + rand() % 3, time(0), next_hop, seq_num);
+    batman_db_unlock();
+}
+
+static double now_usec() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+int main(int argc, char** argv) {
+    int entries = (argc > 1) ? atoi(argv[1]) : 1000;
+    int changes = (argc > 2) ? atoi(argv[2]) : 10;
+    int ogms = (argc > 3) ? atoi(argv[3]) : 1000;
+    int i;
+    int o;
+
+    srand(1);
+    batman_db_init();
+
+    for(i = 0; i < entries; i++) {
+        set_entry(i);
+    }
+
+    double build_usec = 0;
+
+    for(o = 0; o < ogms; o++) {
+        seq_num++;
+
+        for(i = 0; i < changes; i++) {
+            set_entry(rand() % entries);
+        }
+
+        double start = now_usec();
+        batman_periodic_send_ogm(NULL, NULL, NULL);
+        build_usec += now_usec() - start;
+    }
+
+    printf("%d entries, %d changes per OGM: %.2f usec per OGM\n", entries, changes, build_usec / ogms);
+    return EXIT_SUCCESS;
+}
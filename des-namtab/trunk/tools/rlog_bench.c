@@ -0,0 +1,177 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+/*
+ * Measure the cost of the routing log on the forwarding path.
+ *
+ * Several threads each "forward" packets as fast as possible; per packet
+ * they do a small amount of dummy work and log the packet either not at
+ * all, the former way (fopen/fprintf/fclose under a write lock) or with
+ * the binary ring buffer log. Prints packets/s for every mode.
+ *
+ * The binary log drops records when the writer thread falls behind, so it
+ * runs twice: as in the daemon, with the records written and dropped by
+ * the run, and with back-pressure, where a thread retries a dropped record
+ * until it is queued. Only the second rate is one at which every packet
+ * gets logged.
+ *
+ * usage: rlog_bench [threads] [packets per thread] [logfile]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/time.h>
+#include "../src/routing_log.h"
+
+#define MAC "%02x:%02x:%02x:%02x:%02x:%02x"
+#define EXPLODE_ARRAY6(a) (a)[0],(a)[1],(a)[2],(a)[3],(a)[4],(a)[5]
+
+enum { MODE_OFF, MODE_TEXT, MODE_BINARY, MODE_BINARY_WAIT };
+
+static const char* log_path = "/tmp/rlog_bench.log";
+static long packets = 100000;
+static pthread_rwlock_t rlflock = PTHREAD_RWLOCK_INITIALIZER;
+static volatile uint32_t sink;
+
+static void text_log(const uint8_t src[ETH_ALEN], const uint8_t dest[ETH_ALEN], uint32_t seq_num, uint8_t hop_count,
+                     const uint8_t in_iface[ETH_ALEN], const uint8_t out_iface[ETH_ALEN], const uint8_t next_hop[ETH_ALEN]) {
+    pthread_rwlock_wrlock(&rlflock);
+    FILE* f = fopen(log_path, "a+");
+    fprintf(f, MAC "\t" MAC "\t%u\t%u\t" MAC "\t" MAC "\t" MAC "\n",
+            EXPLODE_ARRAY6(src), EXPLODE_ARRAY6(dest), seq_num, hop_count,
+            EXPLODE_ARRAY6(in_iface), EXPLODE_ARRAY6(out_iface), EXPLODE_ARRAY6(next_hop));
+    fclose(f);
+    pthread_rwlock_unlock(&rlflock);
+}
+
+static void* forward(void* arg) {
+    int mode = *(int*) arg;
+    uint8_t src[ETH_ALEN] = { 0x02, 0, 0, 0, 0, 1 };
+    uint8_t dest[ETH_ALEN] = { 0x02, 0, 0, 0, 0, 2 };
+    uint8_t in[ETH_ALEN] = { 0x02, 0, 0, 0, 1, 1 };
+    uint8_t out[ETH_ALEN] = { 0x02, 0, 0, 0, 1, 2 };
+    uint8_t next[ETH_ALEN] = { 0x02, 0, 0, 0, 2, 1 };
+    uint32_t hash = 2166136261u;
+    long i;
+    int j;
+
+    for(i = 0; i < packets; i++) {
+        // stands in for route lookup and header rewriting
+        for(j = 0; j < 64; j++) {
+            hash = (hash ^ (i + j)) * 16777619u;
+        }
+
+        dest[5] = hash;
+
+        if(mode == MODE_TEXT) {
+            text_log(src, dest, i, 1, in, out, next);
+        }
+        else if(mode == MODE_BINARY) {
+            rlog_packet(src, dest, i, 1, in, out, next);
+        }
+        else if(mode == MODE_BINARY_WAIT) {
+            while(rlog_packet(src, dest, i, 1, in, out, next) == false) {
+                sched_yield();
+            }
+        }
+    }
+
+    sink = hash;
+    return NULL;
+}
+
+static double run(int mode, int threads) {
+    pthread_t tid[threads];
+    struct timeval start, end;
+    uint64_t written = rlog_written();
+    uint64_t dropped = rlog_dropped();
+    int binary = (mode == MODE_BINARY || mode == MODE_BINARY_WAIT);
+    int i;
+
+    remove(log_path);
+
+    if(binary && rlog_open(log_path, 0) == false) {
+        fprintf(stderr, "could not open %s\n", log_path);
+        exit(1);
+    }
+
+    gettimeofday(&start, NULL);
+
+    for(i = 0; i < threads; i++) {
+        pthread_create(&tid[i], NULL, forward, &mode);
+    }
+
+    for(i = 0; i < threads; i++) {
+        pthread_join(tid[i], NULL);
+    }
+
+    gettimeofday(&end, NULL);
+
+    double secs = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+
+    if(binary) {
+        rlog_close();
+        // minus the start record of rlog_open
+        written = rlog_written() - written - 1;
+        dropped = rlog_dropped() - dropped;
+        // with back-pressure the dropped records were queued again
+        printf("%-15s %12.0f packets/s, %12.0f logged/s (%llu written, %llu %s, %.1f%%)\n",
+               (mode == MODE_BINARY) ? "binary log:" : "back-pressure:", threads * packets / secs, written / secs,
+               (unsigned long long) written, (unsigned long long) dropped, (mode == MODE_BINARY) ? "dropped" : "retries",
+               100.0 * dropped / (threads * packets));
+    }
+
+    return threads * packets / secs;
+}
+
+int main(int argc, char** argv) {
+    int threads = 4;
+
+    if(argc > 1) {
+        threads = atoi(argv[1]);
+    }
+
+    if(argc > 2) {
+        packets = atol(argv[2]);
+    }
+
+    if(argc > 3) {
+        log_path = argv[3];
+    }
+
+    if(threads < 1 || packets < 1) {
+        fprintf(stderr, "usage: %s [threads] [packets per thread] [logfile]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%d threads, %ld packets each\n", threads, packets);
+    printf("logging off:    %12.0f packets/s\n", run(MODE_OFF, threads));
+    printf("text log:       %12.0f packets/s\n", run(MODE_TEXT, threads));
+    run(MODE_BINARY, threads);
+    run(MODE_BINARY_WAIT, threads);
+    remove(log_path);
+    return 0;
+}
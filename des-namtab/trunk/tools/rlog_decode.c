@@ -0,0 +1,122 @@
+/******************************************************************************
+Copyright 2009, Freie Universitaet Berlin (FUB). All rights reserved.
+
+These sources were developed at the Freie Universitaet Berlin,
+Computer Systems and Telematics / Distributed, embedded Systems (DES) group
+(http://cst.mi.fu-berlin.de, http://www.des-testbed.net)
+-------------------------------------------------------------------------------
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see http://www.gnu.org/licenses/ .
+--------------------------------------------------------------------------------
+For further information and questions please use the web site
+       http://www.des-testbed.net
+*******************************************************************************/
+
+/*
+ * Convert a binary routing log to the text format written by former
+ * versions of the daemon:
+ *
+ *   src  dest  seq_num  hop_count  in_iface  out_iface  next_hop
+ *
+ * usage: rlog_decode [-t] <logfile>
+ *   -t  prefix every line with the time the packet was logged
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../src/routing_log.h"
+
+#define MAC "%02x:%02x:%02x:%02x:%02x:%02x"
+#define EXPLODE_ARRAY6(a) (a)[0],(a)[1],(a)[2],(a)[3],(a)[4],(a)[5]
+
+static void print_record(const rlog_record_t* rec, int with_time) {
+    time_t sec = rec->timestamp / 1000000;
+
+    if(rec->type == RLOG_REC_START) {
+        printf("\n--- %s\n", ctime(&sec));
+        return;
+    }
+
+    if(rec->type != RLOG_REC_PACKET) {
+        return;
+    }
+
+    if(with_time) {
+        printf("%lu.%06lu\t", (unsigned long) sec, (unsigned long)(rec->timestamp % 1000000));
+    }
+
+    printf(MAC "\t" MAC "\t%u\t%u\t", EXPLODE_ARRAY6(rec->src), EXPLODE_ARRAY6(rec->dest), rec->seq_num, rec->hop_count);
+
+    if(rec->flags & RLOG_HAS_IN_IFACE) {
+        printf(MAC "\t", EXPLODE_ARRAY6(rec->in_iface));
+    }
+    else {
+        printf("NULL\t");
+    }
+
+    if(rec->flags & RLOG_HAS_OUT_IFACE) {
+        printf(MAC "\t" MAC "\n", EXPLODE_ARRAY6(rec->out_iface), EXPLODE_ARRAY6(rec->next_hop));
+    }
+    else {
+        printf("NULL\tNULL\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    struct rlog_file_header header;
+    rlog_record_t rec;
+    int with_time = 0;
+    const char* path = NULL;
+    int i;
+
+    for(i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-t") == 0) {
+            with_time = 1;
+        }
+        else {
+            path = argv[i];
+        }
+    }
+
+    if(path == NULL) {
+        fprintf(stderr, "usage: %s [-t] <logfile>\n", argv[0]);
+        return 1;
+    }
+
+    FILE* f = fopen(path, "r");
+
+    if(f == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    if(fread(&header, sizeof(header), 1, f) != 1
+       || memcmp(header.magic, RLOG_MAGIC, sizeof(header.magic)) != 0) {
+        fprintf(stderr, "%s: not a binary routing log\n", path);
+        fclose(f);
+        return 1;
+    }
+
+    if(header.version != RLOG_FORMAT_VERSION || header.record_size != sizeof(rlog_record_t)) {
+        fprintf(stderr, "%s: unsupported format version %u (record size %u)\n", path, header.version, header.record_size);
+        fclose(f);
+        return 1;
+    }
+
+    while(fread(&rec, sizeof(rec), 1, f) == 1) {
+        print_record(&rec, with_time);
+    }
+
+    fclose(f);
+    return 0;
+}